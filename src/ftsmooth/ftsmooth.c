@@ -6,186 +6,293 @@ LD/24.04.14
 
   ftsmooth (24.04.14)
     perform Fourier Transform smoothing on x,y data
-  
+  ftsmooth_batch (19.10.26)
+    perform Fourier Transform smoothing on several y columns sharing
+    the same x values
+
 Changes:
 
+LD/19.10.26 - Sine transforms of equidistant data via FFT (O(N log N)),
+              direct summation is kept for non-equidistant x.
+            - Buffers are sized exactly (no STRSZ blocks).
+            - Batch mode (ftsmooth_batch) for multi-column files.
+
 *********************************************************************/
 
+#include <string.h>
 #include "ftsmooth.h"
 
 char line_buffer[STRSZ];
 
-/****************************************************************
-*					Fourier Transformation						*
-*****************************************************************/
-/* This subroutine performs the Fourier smoothing of the data */
-int ftsmooth(FILE *out_stream, double *x, double *fx, int n_x, 
-	  double cutoff, double tailoff, int stdout_flag)
+/* max. deviation from an equidistant grid (in units of x_step) for FFT */
+#define EQUIDIST_TOLERANCE 1.e-4
+
+/* parameters of the transformation shared by all columns */
+typedef struct ftsmooth_par
 {
+  int n_x;          /* number of data points */
+  int n_k;          /* number of k values in the transform */
+  int n_tail;       /* number of interpolated points on each side */
+  int n_fft;        /* length of FFT (6 * (n_x - 1)) */
+  int equidist;     /* 1 if x values are equidistant (use FFT) */
+  double x_0;       /* length of the interpolated tails */
+  double x_max;     /* period of the sine transform / 2 */
+  double x_step;    /* average x step */
+  double k_step;
+  double cutoff;    /* cutoff (scaled to k) */
+  double tailoff;   /* tailoff (scaled to k) */
+  double norm1;
+} ftsmooth_par_t;
 
+/*====================================================================*/
+/* set up the column independent transformation parameters */
+static int ftsmooth_setup(ftsmooth_par_t *par, double *x, int n_x,
+        double cutoff, double tailoff)
+{
   int i_x;
-  int i_k, n_k;
-  int N;
+  double faux, x_now, k_max;
 
-  double *k, *fk_s, *fk_c; 
+  memset(par, 0, sizeof(ftsmooth_par_t));
+  par->n_x = n_x;
 
-  double norm1;
-  double x_0;
-  double a1, a3;
-  double b1, b2;
+  if (n_x < 2)
+  {
+    fprintf(stderr," *** error:  not enough data points: %d\n", n_x);
+    exit(1);
+  }
 
-  double k_step, k_max;
-  double x_step, x_max, x_now;
-  double faux;
-  
 /* parameters for x */
 
-  faux   = x[n_x-1] - x[0];
-  x_0    = 0.25 * faux;
-  x_max  = 2 * (faux + 2. * x_0);
-  x_step = faux/(n_x - 1);
-  i_k = 0;
+  faux        = x[n_x-1] - x[0];
+  par->x_0    = 0.25 * faux;
+  par->x_max  = 2 * (faux + 2. * par->x_0);
+  par->x_step = faux/(n_x - 1);
 
-  if (x_step <= 0.) 
+  if (par->x_step <= 0.)
   {
-    fprintf(stderr," *** error:  x step < or = 0.: %.3e\n", x_step);
+    fprintf(stderr," *** error:  x step < or = 0.: %.3e\n", par->x_step);
     exit(1);
   }
 
-/* 
-   parameters for cubic/linear interpolation:
-    a1,a3: between -x_0 and x_0 (cubic);
-    b1,b2: between  x_f and x_f + 2*x_0 (linear);
-*/
+  for (x_now = par->x_step, i_x = 0; x_now < par->x_0;
+       x_now += par->x_step, i_x ++) { ; }
+  par->n_tail = i_x;
 
-  faux = x[1] - x[0] + x_0;
-  a3 = (fx[1]/faux  - fx[0]/x_0) / (faux*faux - x_0*x_0);
-  a1 = fx[0]/x_0 - a3*x_0*x_0;
- 
-  b1 = fx[n_x-1];
-  b2 = - fx[n_x-1]/x_0;
+/*
+   With x_max = 6 * (n_x-1) * x_step, sin(k_i * (x_0 + j*x_step)) is
+   Im(exp(i*k_i*x_0) * exp(2*pi*i*i*j/N)) with N = 6 * (n_x-1), i.e.
+   forward and back transform are discrete Fourier transforms of
+   length N if all x are equidistant.
+*/
 
-  if (!stdout_flag) printf("#> a1: %.3e, b1: %.3e, b2: %.3e\n", a1, b1, b2);
+  par->equidist = 1;
+  for (i_x = 1; (i_x < n_x) && par->equidist; i_x ++)
+  {
+    faux = x[i_x] - x[0] - i_x * par->x_step;
+    if (fabs(faux) > EQUIDIST_TOLERANCE * par->x_step) par->equidist = 0;
+  }
+  par->n_fft = 6 * (n_x - 1);
 
 /* parameters for k */
 
   faux = cutoff * (1. + 3. / sqrt(tailoff) );    /* (empirical) */
-  n_k  = (int) rint(n_x * 1.5 * faux) + 1;
+  par->n_k  = (int) rint(n_x * 1.5 * faux) + 1;
 
-  fprintf(out_stream,"# cutoff: %.3f, tailoff: %.3f => k range: %.3f\n",
-			   cutoff, tailoff, faux);
-  if (!stdout_flag)
-    printf("#> cutoff: %.3f, tailoff: %.3f => k range: %.3f\n",
-            cutoff, tailoff, faux);
+  par->k_step = PI/par->x_max;
+  k_max  = 1.5 * n_x * PI / par->x_max;
+
+  par->tailoff = tailoff / k_max;
+  par->cutoff  = cutoff * k_max;
+  par->norm1 = 0.5 / atan(par->tailoff*par->cutoff);
+
+  return 0;
+}
+
+/*====================================================================*/
+/* weight of the low pass filter for the i_k-th k value */
+static double ftsmooth_weight(const ftsmooth_par_t *par, int i_k)
+{
+  double faux;
+
+  faux = par->tailoff * (par->cutoff - i_k * par->k_step);
+  return 0.5 + par->norm1 * atan(faux);
+}
+
+/*====================================================================*/
+/*
+   parameters for cubic/linear interpolation:
+    a1,a3: between -x_0 and x_0 (cubic);
+    b1,b2: between  x_f and x_f + 2*x_0 (linear);
+*/
+static void ftsmooth_tails(const ftsmooth_par_t *par, double *x, double *fx,
+        double *a1, double *a3, double *b1, double *b2)
+{
+  double faux;
+  int n_x = par->n_x;
 
-  k_step = PI/x_max;
-  k_max  = 1.5 * n_x * PI / x_max;
+  faux = x[1] - x[0] + par->x_0;
+  *a3 = (fx[1]/faux  - fx[0]/par->x_0) / (faux*faux - par->x_0*par->x_0);
+  *a1 = fx[0]/par->x_0 - (*a3)*par->x_0*par->x_0;
 
-  tailoff /= k_max;
-  cutoff  *= k_max;
-  norm1 = 0.5 / atan(tailoff*cutoff);
+  *b1 = fx[n_x-1];
+  *b2 = - fx[n_x-1]/par->x_0;
+}
 
-/* initialize k and fk_s/c */
+/*====================================================================*/
+/* direct sine transform and back transform (any x) */
+static void ftsmooth_direct(const ftsmooth_par_t *par, double *x, double *fx,
+        double *fk_s)
+{
+  int i_x, i_k;
+  int n_x = par->n_x;
+  double a1, a3, b1, b2;
+  double k, x_now, faux;
 
-  N = (n_k-(n_k%STRSZ))*2; /* use blocks of 128^i */
-  if(N<=0) N=STRSZ;
-  k =  (double *) malloc (N * sizeof(double) );
-  fk_s = (double *) malloc (N * sizeof(double) );
-  fk_c = (double *) malloc (N * sizeof(double) );
+  ftsmooth_tails(par, x, fx, &a1, &a3, &b1, &b2);
 
 /* Fourier Transformation */
   #ifdef _USE_OPENMP
-  #pragma omp parallel for
+  #pragma omp parallel for private(i_x, k, x_now, faux)
   #endif
-  for( i_k = 0; i_k < n_k; i_k ++)
+  for( i_k = 0; i_k < par->n_k; i_k ++)
   {
-
-    k[i_k]  = i_k * k_step;
+    k = i_k * par->k_step;
     fk_s[i_k] = 0.;
-    fk_c[i_k] = 0.;
-  
 
-/* 
+/*
  (a) over linear part: 0 < x < x_0 and x[n_x-1] < x < x[n_x-1] + x_0
 */
 
-    for (x_now = x_step, i_x = 0; x_now < x_0; x_now += x_step, i_x ++)
+    for (x_now = par->x_step, i_x = 0; x_now < par->x_0;
+         x_now += par->x_step, i_x ++)
     {
-      faux  = k[i_k] * x_now;
+      faux  = k * x_now;
       fk_s[i_k] += (a3*x_now*x_now + a1)*x_now * sin(faux);
-	  
-	  #ifdef DEBUG
-      if (i_k == 0) fprintf(stdout,"%e %e\n", 
-                      x_now, (a3*x_now*x_now + a1)*x_now );
-	  #endif
 
-      faux  = k[i_k] * (x[n_x-1] - x[0] + x_0 + x_now);
+      faux  = k * (x[n_x-1] - x[0] + par->x_0 + x_now);
       fk_s[i_k] += (b1 + b2 * x_now) * sin(faux);
-
-	  #ifdef DEBUG
-      if (i_k == 1) fprintf(stdout,"%e %e\n", 
-              (x[n_x-1] - x[0] + x_0 + x_now), (b1 + b2 * x_now) );
-	  #endif
     } /* for x_now */
 
-    if ((i_k == 0) && (!stdout_flag)) 
-      printf("#> %d (2 x %d) interpolated function values are used \n", 
-        2*i_x, i_x);
-
-/* 
+/*
  (b) over actual function: x[0] < x < x[n_x-1]
 */
     for (i_x = 0; i_x < n_x; i_x ++)
     {
-      x_now = x[i_x] - x[0] + x_0;
-      faux  = k[i_k] * x_now;
-      fk_s[i_k] += fx[i_x] * sin(faux);
-
-	 #ifdef DEBUG
-     if (i_k == 0) fprintf(stdout,"%e %e\n", x_now, fx[i_x] );
-	 #endif
-	 
+      x_now = x[i_x] - x[0] + par->x_0;
+      fk_s[i_k] += fx[i_x] * sin(k * x_now);
     } /* for i_x */
 
-    faux = tailoff * (cutoff - k[i_k]);
-    faux =  0.5 + norm1 * atan(faux);
-    fk_s[i_k] *= k_step * SQRT_PI * faux;
+    fk_s[i_k] *= par->k_step * SQRT_PI * ftsmooth_weight(par, i_k);
+  }  /* for i_k */
 
- }  /* for i_k */
+/*
+  back transformation: Use the input values of x.
+*/
 
-  if(!stdout_flag)
-    printf("#> last point in FT (%d): k = %.3f weight = %.3f\n", 
-         i_k-1, k[i_k-1],faux);
+  faux = SQRT_PI * par->x_max / (n_x * 3.);
 
-/* 
-  back transformation (for data points 2 to n_x - 3):
-  Use the input values of x.
+  #ifdef _USE_OPENMP
+  #pragma omp parallel for private(i_k, x_now)
+  #endif
+  for( i_x = 0; i_x < n_x; i_x ++)
+  {
+    x_now = x[i_x] - x[0] + par->x_0;
+    for (i_k = 0, fx[i_x] = 0.; i_k < par->n_k; i_k ++)
+      fx[i_x] += fk_s[i_k]*sin(x_now * i_k * par->k_step);
+
+    fx[i_x] *= faux;
+  }  /* for i_x */
+}
+
+/*====================================================================*/
+/*
+  sine transform and back transform of equidistant data via FFT.
+  re, im must have n_fft elements, fk_s n_k elements.
 */
+static void ftsmooth_fast(const ftsmooth_par_t *par, ftsmooth_fft_t *plan,
+        double *x, double *fx, double *re, double *im, double *fk_s)
+{
+  int i_x, i_k, i_r, i_n;
+  int n_x = par->n_x;
+  int N = par->n_fft;
+  double a1, a3, b1, b2;
+  double x_now, phi, faux;
+  double a_im, b_re, b_im;
 
-  x_step = SQRT_PI * x_max / (n_x * 3.);
- 
-  for( i_x = 0; i_x < n_x; i_x ++)
+  ftsmooth_tails(par, x, fx, &a1, &a3, &b1, &b2);
+
+/*
+  Pack both (real) grids into one complex sequence:
+    re: cubic tail at x = m * x_step (m = 1 .. n_tail)
+    im: data at x = x_0 + j * x_step (j = 0 .. n_x-1)
+        and linear tail (j = n_x-1+m, m = 1 .. n_tail)
+*/
+
+  memset(re, 0, N * sizeof(double));
+  memset(im, 0, N * sizeof(double));
+
+  for (i_x = 1; i_x <= par->n_tail; i_x ++)
   {
-    x_now = x[i_x] - x[0] + x_0;
-    for (i_k = 0, fx[i_x] = 0.; i_k < n_k; i_k ++)
-    {
-      faux  = x_now * k[i_k];
-      fx[i_x] += fk_s[i_k]*sin(faux);
-    } /* for i_x */
+    x_now = i_x * par->x_step;
+    re[i_x] = (a3*x_now*x_now + a1)*x_now;
+    im[n_x-1+i_x] = b1 + b2 * x_now;
+  }
+  for (i_x = 0; i_x < n_x; i_x ++) im[i_x] = fx[i_x];
 
-    fx[i_x] *= x_step;
+  ftsmooth_fft_exec(plan, re, im);
 
-  }  /* for i_k */
+/*
+  unpack: A = transform of re, B = transform of im;
+  F(k_i) = Im(A_i) + Im(exp(i k_i x_0) * B_i) (indices modulo N)
+*/
+
+  for (i_k = 0; i_k < par->n_k; i_k ++)
+  {
+    i_r = i_k % N;
+    i_n = (N - i_r) % N;
+
+    a_im = 0.5 * (im[i_r] - im[i_n]);
+    b_re = 0.5 * (im[i_r] + im[i_n]);
+    b_im = -0.5 * (re[i_r] - re[i_n]);
+
+    phi = i_k * par->k_step * par->x_0;
+    faux = a_im + sin(phi) * b_re + cos(phi) * b_im;
+
+    fk_s[i_k] = faux * par->k_step * SQRT_PI * ftsmooth_weight(par, i_k);
+  }
 
 /*
-  5 point smooth (if required):
+  back transformation: fold the k values onto the FFT grid,
+  f(x_0 + j*x_step) = Im( sum_r C_r exp(2*pi*i*r*j/N) )
 */
 
-  fprintf(out_stream,"# 5 point smooth\n");
-  if(!stdout_flag) printf("#> 5 point smooth\n");
+  memset(re, 0, N * sizeof(double));
+  memset(im, 0, N * sizeof(double));
+
+  for (i_k = 0; i_k < par->n_k; i_k ++)
+  {
+    i_r = i_k % N;
+    phi = i_k * par->k_step * par->x_0;
+    re[i_r] += fk_s[i_k] * cos(phi);
+    im[i_r] += fk_s[i_k] * sin(phi);
+  }
+
+  ftsmooth_fft_exec(plan, re, im);
+
+  faux = SQRT_PI * par->x_max / (n_x * 3.);
+  for (i_x = 0; i_x < n_x; i_x ++) fx[i_x] = faux * im[i_x];
+}
+
+/*====================================================================*/
+/* 5 point smooth */
+static void ftsmooth_5point(double *fx, int n_x)
+{
+  int i_x;
+  double faux;
+
+  if (n_x < 3) return;
 
   /* 1st data point no smooth */
-  fprintf(out_stream,"%e %e\n", x[0], fx[0] );
 
   /* 2nd data point 3 point smooth */
   faux = 0.25 * (fx[0] + fx[2]) + 0.5 * fx[1];
@@ -194,8 +301,8 @@ int ftsmooth(FILE *out_stream, double *x, double *fx, int n_x,
   /* data points 2 to n_x - 3 */
   for( i_x = 2; i_x < n_x - 2; i_x ++)
   {
-    faux = 0.0625*(fx[i_x-2] + fx[i_x+2]) + 
-           0.25  *(fx[i_x-1] + fx[i_x+1]) + 
+    faux = 0.0625*(fx[i_x-2] + fx[i_x+2]) +
+           0.25  *(fx[i_x-1] + fx[i_x+1]) +
            0.375 * fx[i_x];
     fx[i_x] = faux;
   }  /* for i_x */
@@ -205,11 +312,147 @@ int ftsmooth(FILE *out_stream, double *x, double *fx, int n_x,
   fx[n_x-2] = faux;
 
   /* last data point =  no smooth */
+}
+
+/*====================================================================*/
+/* allocate the work space; returns 0 on success */
+static int ftsmooth_alloc(const ftsmooth_par_t *par, ftsmooth_fft_t **plan,
+        double **re, double **im, double **fk_s)
+{
+  *plan = NULL;
+  *re = *im = NULL;
+
+  *fk_s = (double *) malloc (par->n_k * sizeof(double) );
+  if (par->equidist)
+  {
+    *plan = ftsmooth_fft_init(par->n_fft);
+    *re = (double *) malloc (par->n_fft * sizeof(double) );
+    *im = (double *) malloc (par->n_fft * sizeof(double) );
+    if (*plan == NULL || *re == NULL || *im == NULL) return -1;
+  }
+  return (*fk_s == NULL) ? -1 : 0;
+}
+
+static void ftsmooth_info_out(FILE *out_stream, const ftsmooth_par_t *par,
+        double cutoff, double tailoff, int stdout_flag)
+{
+  double faux = cutoff * (1. + 3. / sqrt(tailoff) );
+
+  fprintf(out_stream,"# cutoff: %.3f, tailoff: %.3f => k range: %.3f\n",
+			   cutoff, tailoff, faux);
+  if (!stdout_flag)
+  {
+    printf("#> cutoff: %.3f, tailoff: %.3f => k range: %.3f\n",
+            cutoff, tailoff, faux);
+    printf("#> %d (2 x %d) interpolated function values are used \n",
+        2*par->n_tail, par->n_tail);
+    printf("#> last point in FT (%d): k = %.3f weight = %.3f\n",
+         par->n_k-1, (par->n_k-1)*par->k_step,
+         ftsmooth_weight(par, par->n_k-1));
+    if (par->equidist)
+      printf("#> FFT of length %d\n", par->n_fft);
+    else
+      printf("#> x not equidistant: direct transform\n");
+  }
+}
+
+/****************************************************************
+*					Fourier Transformation						*
+*****************************************************************/
+/* This subroutine performs the Fourier smoothing of the data */
+int ftsmooth(FILE *out_stream, double *x, double *fx, int n_x,
+	  double cutoff, double tailoff, int stdout_flag)
+{
+  int ret;
+  double a1, a3, b1, b2;
+  double *re, *im, *fk_s;
+  ftsmooth_fft_t *plan;
+  ftsmooth_par_t par;
+
+  ftsmooth_setup(&par, x, n_x, cutoff, tailoff);
+
+  if (!stdout_flag)
+  {
+    ftsmooth_tails(&par, x, fx, &a1, &a3, &b1, &b2);
+    printf("#> a1: %.3e, b1: %.3e, b2: %.3e\n", a1, b1, b2);
+  }
+
+  ftsmooth_info_out(out_stream, &par, cutoff, tailoff, stdout_flag);
+
+  ret = ftsmooth_alloc(&par, &plan, &re, &im, &fk_s);
+  if (ret == 0)
+  {
+    if (par.equidist)
+      ftsmooth_fast(&par, plan, x, fx, re, im, fk_s);
+    else
+      ftsmooth_direct(&par, x, fx, fk_s);
+
+/*
+  5 point smooth (if required):
+*/
+
+    fprintf(out_stream,"# 5 point smooth\n");
+    if(!stdout_flag) printf("#> 5 point smooth\n");
+
+    /* 1st data point no smooth */
+    fprintf(out_stream,"%e %e\n", x[0], fx[0] );
+
+    ftsmooth_5point(fx, n_x);
+  }
+  else
+    fprintf(stderr," *** error (ftsmooth): allocation error\n");
 
   /* clean up */
-  free(k); 
+  ftsmooth_fft_free(plan);
+  free(re);
+  free(im);
   free(fk_s);
-  free(fk_c);
-  
-  return 0;
+
+  return ret;
+}
+
+/****************************************************************
+*				Fourier Transformation (batch)					*
+*****************************************************************/
+/*
+  Fourier smoothing of n_col columns fx[i_col][0..n_x-1] sharing the
+  same x values. Transformation parameters and FFT are set up only once.
+  Unlike ftsmooth no data points are written to out_stream.
+*/
+int ftsmooth_batch(FILE *out_stream, double *x, double **fx, int n_x,
+	  int n_col, double cutoff, double tailoff, int stdout_flag)
+{
+  int i_col, ret;
+  double *re, *im, *fk_s;
+  ftsmooth_fft_t *plan;
+  ftsmooth_par_t par;
+
+  ftsmooth_setup(&par, x, n_x, cutoff, tailoff);
+  ftsmooth_info_out(out_stream, &par, cutoff, tailoff, stdout_flag);
+
+  ret = ftsmooth_alloc(&par, &plan, &re, &im, &fk_s);
+  if (ret == 0)
+  {
+    for (i_col = 0; i_col < n_col; i_col ++)
+    {
+      if (par.equidist)
+        ftsmooth_fast(&par, plan, x, fx[i_col], re, im, fk_s);
+      else
+        ftsmooth_direct(&par, x, fx[i_col], fk_s);
+
+      ftsmooth_5point(fx[i_col], n_x);
+    }
+
+    fprintf(out_stream,"# 5 point smooth (%d columns)\n", n_col);
+    if(!stdout_flag) printf("#> 5 point smooth (%d columns)\n", n_col);
+  }
+  else
+    fprintf(stderr," *** error (ftsmooth_batch): allocation error\n");
+
+  ftsmooth_fft_free(plan);
+  free(re);
+  free(im);
+  free(fk_s);
+
+  return ret;
 }
@@ -0,0 +1,203 @@
+/*********************************************************************
+LD/19.10.26
+                        FTSMOOTH_FFT
+
+  file contains functions:
+
+  ftsmooth_fft_init (19.10.26)
+    prepare a discrete Fourier transform of arbitrary length
+  ftsmooth_fft_free (19.10.26)
+    free a transform prepared by ftsmooth_fft_init
+  ftsmooth_fft_exec (19.10.26)
+    X_k = sum_n x_n exp(+2 pi i n k / N)
+
+  The transform is computed by an iterative radix-2 FFT if N is a
+  power of 2, otherwise by Bluestein's algorithm (chirp z-transform)
+  on top of a radix-2 FFT of length >= 2N - 1. Both are O(N log N).
+
+Changes:
+
+*********************************************************************/
+
+#include <string.h>
+#include "ftsmooth.h"
+
+/* radix-2 in-place FFT of length m (power of 2), sign = +1/-1 */
+static void fft_radix2(double *re, double *im, int m,
+        const double *tw_re, const double *tw_im, int sign)
+{
+  int i, j, k, len, half, step;
+  double t_re, t_im, w_re, w_im;
+
+  /* bit reversal */
+  for (i = 1, j = 0; i < m; i++)
+  {
+    int bit = m >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j)
+    {
+      t_re = re[i]; re[i] = re[j]; re[j] = t_re;
+      t_im = im[i]; im[i] = im[j]; im[j] = t_im;
+    }
+  }
+
+  /* butterflies */
+  for (len = 2; len <= m; len <<= 1)
+  {
+    half = len >> 1;
+    step = m / len;
+    for (i = 0; i < m; i += len)
+    {
+      for (k = 0; k < half; k++)
+      {
+        w_re = tw_re[k*step];
+        w_im = sign * tw_im[k*step];
+        t_re = re[i+k+half]*w_re - im[i+k+half]*w_im;
+        t_im = re[i+k+half]*w_im + im[i+k+half]*w_re;
+        re[i+k+half] = re[i+k] - t_re;
+        im[i+k+half] = im[i+k] - t_im;
+        re[i+k] += t_re;
+        im[i+k] += t_im;
+      }
+    }
+  }
+}
+
+/*====================================================================*/
+ftsmooth_fft_t *ftsmooth_fft_init(int n)
+{
+  int i, m;
+  long long n2;
+  double phi;
+  ftsmooth_fft_t *plan;
+
+  if (n < 1) return NULL;
+
+  plan = (ftsmooth_fft_t *) calloc(1, sizeof(ftsmooth_fft_t));
+  if (plan == NULL) return NULL;
+
+  plan->n = n;
+  plan->bluestein = (n & (n - 1)) != 0;
+
+  for (m = 1; m < (plan->bluestein ? 2*n - 1 : n); m <<= 1) { ; }
+  plan->m = m;
+
+  plan->tw_re = (double *) malloc ((m/2 + 1) * sizeof(double));
+  plan->tw_im = (double *) malloc ((m/2 + 1) * sizeof(double));
+  plan->wk_re = (double *) malloc (m * sizeof(double));
+  plan->wk_im = (double *) malloc (m * sizeof(double));
+  if (plan->tw_re == NULL || plan->tw_im == NULL ||
+      plan->wk_re == NULL || plan->wk_im == NULL)
+  {
+    ftsmooth_fft_free(plan);
+    return NULL;
+  }
+
+  /* twiddle factors exp(-2 pi i k / m) */
+  for (i = 0; i <= m/2; i++)
+  {
+    phi = -2. * PI * i / m;
+    plan->tw_re[i] = cos(phi);
+    plan->tw_im[i] = sin(phi);
+  }
+
+  if (!plan->bluestein) return plan;
+
+  plan->ch_re = (double *) malloc (n * sizeof(double));
+  plan->ch_im = (double *) malloc (n * sizeof(double));
+  plan->bf_re = (double *) calloc (m, sizeof(double));
+  plan->bf_im = (double *) calloc (m, sizeof(double));
+  if (plan->ch_re == NULL || plan->ch_im == NULL ||
+      plan->bf_re == NULL || plan->bf_im == NULL)
+  {
+    ftsmooth_fft_free(plan);
+    return NULL;
+  }
+
+  /* chirp exp(+i pi k^2 / n); k^2 is reduced mod 2n to keep precision */
+  for (i = 0; i < n; i++)
+  {
+    n2 = ((long long)i * i) % (2LL * n);
+    phi = PI * (double)n2 / n;
+    plan->ch_re[i] = cos(phi);
+    plan->ch_im[i] = sin(phi);
+  }
+
+  /* filter b_k = conj(chirp_k), wrapped for negative k, transformed */
+  plan->bf_re[0] = plan->ch_re[0];
+  plan->bf_im[0] = -plan->ch_im[0];
+  for (i = 1; i < n; i++)
+  {
+    plan->bf_re[i] = plan->bf_re[m-i] = plan->ch_re[i];
+    plan->bf_im[i] = plan->bf_im[m-i] = -plan->ch_im[i];
+  }
+  fft_radix2(plan->bf_re, plan->bf_im, m, plan->tw_re, plan->tw_im, 1);
+
+  return plan;
+}
+
+/*====================================================================*/
+void ftsmooth_fft_free(ftsmooth_fft_t *plan)
+{
+  if (plan == NULL) return;
+  free(plan->tw_re);
+  free(plan->tw_im);
+  free(plan->ch_re);
+  free(plan->ch_im);
+  free(plan->bf_re);
+  free(plan->bf_im);
+  free(plan->wk_re);
+  free(plan->wk_im);
+  free(plan);
+}
+
+/*====================================================================*/
+/* in-place transform X_k = sum_n x_n exp(+2 pi i n k / N) of re/im[N] */
+void ftsmooth_fft_exec(ftsmooth_fft_t *plan, double *re, double *im)
+{
+  int i, n, m;
+  double t_re, t_im, scale;
+  double *wr, *wi;
+
+  n = plan->n;
+  m = plan->m;
+
+  if (!plan->bluestein)
+  {
+    /* twiddles are stored for sign -1, hence sign = -1 gives exp(+...) */
+    fft_radix2(re, im, n, plan->tw_re, plan->tw_im, -1);
+    return;
+  }
+
+  wr = plan->wk_re;
+  wi = plan->wk_im;
+
+  /* a_k = x_k * chirp_k (zero padded to m) */
+  for (i = 0; i < n; i++)
+  {
+    wr[i] = re[i]*plan->ch_re[i] - im[i]*plan->ch_im[i];
+    wi[i] = re[i]*plan->ch_im[i] + im[i]*plan->ch_re[i];
+  }
+  memset(wr + n, 0, (m - n) * sizeof(double));
+  memset(wi + n, 0, (m - n) * sizeof(double));
+
+  /* cyclic convolution with the filter */
+  fft_radix2(wr, wi, m, plan->tw_re, plan->tw_im, 1);
+  for (i = 0; i < m; i++)
+  {
+    t_re = wr[i]*plan->bf_re[i] - wi[i]*plan->bf_im[i];
+    t_im = wr[i]*plan->bf_im[i] + wi[i]*plan->bf_re[i];
+    wr[i] = t_re;
+    wi[i] = t_im;
+  }
+  fft_radix2(wr, wi, m, plan->tw_re, plan->tw_im, -1);
+
+  /* X_k = chirp_k * (a * b)_k / m */
+  scale = 1. / m;
+  for (i = 0; i < n; i++)
+  {
+    re[i] = scale * (wr[i]*plan->ch_re[i] - wi[i]*plan->ch_im[i]);
+    im[i] = scale * (wr[i]*plan->ch_im[i] + wi[i]*plan->ch_re[i]);
+  }
+}
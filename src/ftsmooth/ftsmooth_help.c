@@ -28,6 +28,9 @@ void ftsmooth_usage(FILE *output)
    fprintf(output,"\t--output <output>\n");
    fprintf(output,"\n");
    fprintf(output,"optional arguments:\n");
+   fprintf(output,"\n\t-b\t\tbatch mode: input has several y columns per line\n");
+   fprintf(output,"\t--batch\t\t(x y1 y2 ... yn), all of which are smoothed.\n");
+   fprintf(output,"\t\t\t'-d' and '-r' are ignored in batch mode.\n");
    fprintf(output,"\n\t-c <cut>\tenter a cut off value for fourier transform\n");
    fprintf(output,"\t--cutoff <cut>\tthis should be between 0 and 1 (default=0.5).\n");
    fprintf(output,"\n\t-d\t\tdelete entries with negative y-values.\n\t--delete\n"); 
@@ -15,6 +15,7 @@ GH/01.06.95 - Start transformation from f(x=0) = 0 and interpolate values
 GH/07.06.95 - x_0 = n_x/4 * x_step
 
 LD/18.06.13 - allow trimming of datasets with '--range <arg1> <arg2>'
+LD/19.10.26 - batch mode '-b' for multi-column files (x y1 y2 ... yn)
 
 ****************************************************************************/
 
@@ -27,12 +28,15 @@ char mode;
 
 int range_flag, offset_flag, del_flag;
 int stdin_flag, stdout_flag;
+int batch_flag;
 
 int i_arg;
 int i_x, n_x;
 int i_r;
+int i_col, n_col;
 
 double *x, *fx; 
+double **fy;
 
 double cutoff, tailoff;
 double offset;
@@ -53,6 +57,8 @@ FILE *out_stream;
  
  stdin_flag = stdout_flag = 1;
  range_flag = offset_flag = del_flag = 0;
+ batch_flag = 0;
+ i_r = 0;
 
  /* initialise arrays to STRSZ dimensional doubles */
  ubound = (double *) malloc (STRSZ * sizeof(double) );
@@ -62,10 +68,10 @@ FILE *out_stream;
  Check command line and decode arguments
 */
 
- parse_args(argc, argv, in_stream, out_stream, 
+ parse_args(argc, argv, &in_stream, &out_stream, 
 	  &stdin_flag, &stdout_flag,&cutoff, &tailoff, &mode,
 	  &offset_flag, &offset, &range_flag, &i_r,
-	  lbound, ubound, &del_flag);
+	  lbound, ubound, &del_flag, &batch_flag);
  
  #ifdef DEBUG
  char *dbg_str = (char*)malloc(sizeof(char)*STRSZ);
@@ -84,15 +90,56 @@ FILE *out_stream;
  if (!stdout_flag) /* print if out_stream not equal to stdout */
    printf("#> Sin Fourier Smooth: version %3.1f\n",VERSION);
 
+/*
+ BATCH MODE: smooth all columns of a multi-column file
+*/
+
+ if(batch_flag)
+ {
+   n_x = read_columns(in_stream, out_stream, &x, &fy, &n_col);
+   fclose(in_stream);
+
+   if(!stdout_flag)
+     printf("#> End of input (%d lines with %d columns read)\n", n_x, n_col);
+
+   if(offset_flag) /* apply y-offset */
+     for(i_col = 0; i_col < n_col; i_col ++)
+       offset_data(x, fy[i_col], n_x, offset, offset_flag);
+
+   if(del_flag || range_flag)
+     fprintf(stderr, "*** warning (ftsmooth): "
+             "'-d' and '-r' are ignored in batch mode\n");
+
+   if(mode == 's')
+     ftsmooth_batch(out_stream, x, fy, n_x, n_col, cutoff, tailoff,
+                    stdout_flag);
+   else
+     if(!stdout_flag) printf("#> no smooth\n");
+
+   print_columns(out_stream, x, fy, n_x, n_col);
+   fclose(out_stream);
+
+   if(!stdout_flag)
+     printf("#> End of output (%d lines written)\n", n_x);
+
+   for(i_col = 0; i_col < n_col; i_col ++) free(fy[i_col]);
+   free(fy);
+   free(x);
+   free(ubound);
+   free(lbound);
+
+   return 0;
+ }
+
 /*
  initialize x and fx
 */
 
- x =  (double *) malloc (1 * sizeof(double) );
- fx = (double *) malloc (1 * sizeof(double) );
+ x =  (double *) malloc (STRSZ * sizeof(double) );
+ fx = (double *) malloc (STRSZ * sizeof(double) );
 
 /* READ INPUT DATA */
- n_x = read_data(in_stream, out_stream, x, fx);
+ n_x = read_data(in_stream, out_stream, &x, &fx);
  fclose(in_stream); 
 
  if(!stdout_flag)
@@ -12,6 +12,8 @@ LD/24.04.14
   
 Changes:
 
+LD/19.10.26 - return streams by reference; add '-b/--batch' option
+
 *********************************************************************/
 
 #include "ftsmooth.h"
@@ -24,11 +26,11 @@ Changes:
 *****************************************************************/
 /* subroutine to deal with commandline arguments */
 int parse_args(int argc, char *argv[], 
-	  FILE *in_stream, FILE *out_stream, 
+	  FILE **in_stream, FILE **out_stream, 
 	  int *stdin_flag, int *stdout_flag,
 	  double *cutoff, double *tailoff, char *mode,
 	  int *offset_flag, double *offset, int *range_flag, int *i_r,
-	  double *lbound, double *ubound, int *del_flag)
+	  double *lbound, double *ubound, int *del_flag, int *batch_flag)
 {
  int i_arg;
  
@@ -49,7 +51,7 @@ int parse_args(int argc, char *argv[],
    {
 /* Open input file */
     i_arg++;
-    if ((in_stream = fopen(argv[i_arg],"r")) == NULL)
+    if ((*in_stream = fopen(argv[i_arg],"r")) == NULL)
     {
      fprintf(stderr,"error: failed to open '%s'",argv[i_arg]);
      exit(1);
@@ -61,8 +63,7 @@ int parse_args(int argc, char *argv[],
       (!strcmp(argv[i_arg], "--output"))) 
    {
     i_arg++;
-    fclose(out_stream); /* !will always close stdout! */
-    if ((out_stream = fopen(argv[i_arg],"w")) == NULL)
+    if ((*out_stream = fopen(argv[i_arg],"w")) == NULL)
     {
      fprintf(stderr,"error: failed to open '%s'",argv[i_arg]);
      exit(1);
@@ -149,6 +150,12 @@ int parse_args(int argc, char *argv[],
 	   decode_ranges(lbound, ubound, &*i_r, argv[i_arg]);  
      }
    }
+/* Define batch mode */
+   if((!strncmp(argv[i_arg], "-b", 2)) ||
+	  (!strcmp(argv[i_arg], "--batch")))
+   {
+     *batch_flag = 1;
+   }
 /* Define delete */
    if((!strncmp(argv[i_arg], "-d", 2)) ||
 	  (!strcmp(argv[i_arg], "--delete")))
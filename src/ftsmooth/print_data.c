@@ -6,6 +6,8 @@ LD/24.04.14
 
   print_data (24.04.14)
     print (x,y) data
+  print_columns (19.10.26)
+    print (x,y1,...,yn) data
   
 Changes:
 
@@ -29,3 +31,19 @@ int print_data(FILE *out_stream, double *x, double *fx, int n_x)
   return 0;
 }
 
+/* subroutine to output x & n_col columns of f(x) values */
+int print_columns(FILE *out_stream, double *x, double **fx, int n_x,
+        int n_col)
+{
+  int i_x, i_col;
+
+  for(i_x = 0; i_x < n_x; i_x ++)
+  {
+    fprintf(out_stream,"%e", x[i_x]);
+    for(i_col = 0; i_col < n_col; i_col ++)
+      fprintf(out_stream," %e", fx[i_col][i_x]);
+    fprintf(out_stream,"\n");
+  }
+
+  return 0;
+}
@@ -6,11 +6,17 @@ LD/24.04.14
 
   read_data (24.04.14)
      read input x,y data
+  read_columns (19.10.26)
+     read input x,y1,y2,...,yn data
   
 Changes:
 
+LD/19.10.26 - read_data: pass arrays by reference so that realloc
+              is seen by the caller.
+
 *********************************************************************/
 
+#include <string.h>
 #include "ftsmooth.h"
 
 
@@ -19,7 +25,7 @@ Changes:
 *****************************************************************/
 /* subroutine to read input data stream */
 int read_data(FILE *in_stream, 
-	  FILE *out_stream, double *x, double *fx)
+	  FILE *out_stream, double **x, double **fx)
 {
   int i_x;
   int N;     /* array max size */
@@ -33,18 +39,108 @@ int read_data(FILE *in_stream,
     if (line_buffer[0] == '#') fprintf(out_stream,"%s", line_buffer);
     else 
     {
-      sscanf(line_buffer,"%le %le", x+i_x, fx+i_x);
+      sscanf(line_buffer,"%le %le", *x+i_x, *fx+i_x);
 
       i_x ++;
 	  if(i_x >= N) 
 	  {
         /* efficiently realloc N*2 amount of memory */
 	    N*=2;
-        x =  (double *) realloc(x, (N)*sizeof(double) );
-        fx = (double *) realloc(fx, (N)*sizeof(double) );
+        *x =  (double *) realloc(*x, (N)*sizeof(double) );
+        *fx = (double *) realloc(*fx, (N)*sizeof(double) );
 	  }
     }
   }  /* for */
   
   return i_x;
-}
\ No newline at end of file
+}
+
+/****************************************************************
+*						READ COLUMNS							*
+*****************************************************************/
+/* 
+ subroutine to read multi-column input (x followed by n_col y values
+ per line, e.g. one column per beam). The number of columns is taken
+ from the first data line; missing values are set to 0.
+ *x and (*fx)[0..n_col-1] are allocated here. Returns number of lines.
+*/
+int read_columns(FILE *in_stream, FILE *out_stream, double **x,
+        double ***fx, int *n_col)
+{
+  int i_x, i_col;
+  int N;     /* array max size */
+  int pos, len;
+  char *line;
+  double faux;
+
+  size_t line_sz = STRSZ;
+  line = (char *) malloc (line_sz * sizeof(char) );
+
+  N = STRSZ;
+  *n_col = 0;
+  *x = (double *) malloc (N * sizeof(double) );
+  *fx = NULL;
+
+  for (i_x = 0; line != NULL; )
+  {
+    /* read a line of arbitrary length */
+    len = 0;
+    line[0] = '\0';
+    while (fgets(line + len, (int)(line_sz - len), in_stream) != NULL)
+    {
+      len += (int)strlen(line + len);
+      if (len > 0 && line[len-1] == '\n') break;
+      line_sz *= 2;
+      line = (char *) realloc(line, line_sz * sizeof(char) );
+      if (line == NULL) break;
+    }
+    if (line == NULL || len == 0) break;
+
+    /* Lines beginning with '#' are interpreted as comments */
+    if (line[0] == '#')
+    {
+      fprintf(out_stream,"%s", line);
+      continue;
+    }
+
+    if (sscanf(line, "%le%n", *x+i_x, &pos) < 1) continue;
+
+    if (*fx == NULL) /* count columns of first data line */
+    {
+      for (len = pos, i_col = 0;
+           sscanf(line + len, "%le%n", &faux, &pos) == 1; len += pos)
+        i_col ++;
+      if (i_col < 1)
+      {
+        fprintf(stderr,"***error (ftsmooth): no y values in input\n");
+        exit(1);
+      }
+      *n_col = i_col;
+      *fx = (double **) malloc (*n_col * sizeof(double *) );
+      for (i_col = 0; i_col < *n_col; i_col ++)
+        (*fx)[i_col] = (double *) malloc (N * sizeof(double) );
+      sscanf(line, "%le%n", &faux, &pos);
+    }
+
+    for (i_col = 0, len = pos; i_col < *n_col; i_col ++, len += pos)
+    {
+      if (sscanf(line + len, "%le%n", (*fx)[i_col]+i_x, &pos) != 1)
+      {
+        for (; i_col < *n_col; i_col ++) (*fx)[i_col][i_x] = 0.;
+        break;
+      }
+    }
+
+    i_x ++;
+    if(i_x >= N)
+    {
+      N*=2;
+      *x = (double *) realloc(*x, N*sizeof(double) );
+      for (i_col = 0; i_col < *n_col; i_col ++)
+        (*fx)[i_col] = (double *) realloc((*fx)[i_col], N*sizeof(double) );
+    }
+  }  /* for */
+
+  free(line);
+  return i_x;
+}
@@ -0,0 +1,83 @@
+/*********************************************************************
+LD/19.10.26
+
+include file for the binary (columnar) IV curve format shared by the
+LEED programs (writer) and the R factor program CRFAC (reader).
+
+ - layout constants
+ - magic number
+
+Changes:
+LD/19.10.26 - Creation
+
+DESIGN:
+
+ All numbers are stored little-endian, independent of the host. The
+ file consists of a fixed size header, the beam list, the energy axis
+ and the intensities (one contiguous column per beam):
+
+  offset                 size             contents
+  ------                 ----             --------
+  0                      8                magic "CLEEDIVB"
+  8                      4  (uint32)      format version
+  12                     4  (uint32)      offset of the energy column
+  16                     4  (uint32)      number of beams (n_beam)
+  20                     4  (uint32)      number of energies (n_eng)
+  24                     8  (float64)     initial energy [eV]
+  32                     8  (float64)     final energy   [eV]
+  40                     8  (float64)     energy step    [eV]
+  48                     16               reserved (zero)
+  64                     24 * n_beam      beam records:
+                                           float64 1st index,
+                                           float64 2nd index,
+                                           int32   beam set,
+                                           int32   reserved (zero)
+  data_offs              8 * n_eng        energies [eV] (float64)
+  data_offs + 8 * n_eng  8*n_eng*n_beam   intensities (float64),
+                                          beam i at
+                                          data_offs + 8*n_eng*(i+1)
+
+ Every block starts at a multiple of 8 bytes, so the file can be
+ memory mapped and the columns accessed in place.
+*********************************************************************/
+
+#ifdef __cplusplus /* If this is a C++ compiler, use C linkage */
+extern "C" {
+#endif
+
+#ifndef CLEED_IVBIN_H
+#define CLEED_IVBIN_H
+
+#include <stddef.h>
+
+#define IVBIN_MAGIC        "CLEEDIVB"  /* first 8 bytes of every file */
+#define IVBIN_MAGIC_LEN    8
+#define IVBIN_VERSION      1
+
+#define IVBIN_HEAD_SIZE    64          /* size of the fixed header */
+#define IVBIN_BEAM_SIZE    24          /* size of one beam record */
+
+/* offsets within the fixed header */
+#define IVBIN_OFFS_VERSION 8
+#define IVBIN_OFFS_DATA    12
+#define IVBIN_OFFS_N_BEAM  16
+#define IVBIN_OFFS_N_ENG   20
+#define IVBIN_OFFS_E_INI   24
+#define IVBIN_OFFS_E_FIN   32
+#define IVBIN_OFFS_E_STP   40
+
+/* offset of the energy column for n_beam beams (size_t arithmetic;
+   readers must check n_beam against the file size first) */
+#define IVBIN_DATA_OFFSET(n_beam) \
+  ((size_t)IVBIN_HEAD_SIZE + (size_t)IVBIN_BEAM_SIZE * (size_t)(n_beam))
+
+/* total file size for n_beam beams and n_eng energies */
+#define IVBIN_FILE_SIZE(n_beam, n_eng) \
+  (IVBIN_DATA_OFFSET(n_beam) + \
+   (size_t)8 * (size_t)(n_eng) * ((size_t)(n_beam) + 1))
+
+#endif /* CLEED_IVBIN_H */
+
+#ifdef __cplusplus /* If this is a C++ compiler, use C linkage */
+}
+#endif
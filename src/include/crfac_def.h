@@ -11,6 +11,10 @@ GH/25.09.92
 GH/03.03.93
 GH/10.08.95 - Create (copy from rfdefines.h and rftypes.h)
 GH/10.08.95 - modify structure crargs (output)
+LD/19.10.26 - add structure crivbin (binary theoretical input)
+LD/19.10.26 - add structures crspline, crsplcur (SoA cubic splines)
+LD/19.10.26 - crivcur: keep index list of theor. input (the_index);
+              crargs: serve mode (serve, sockfile)
 
 *********************************************************************/
 
@@ -32,6 +36,25 @@ struct crelist
  real deriv2;      /* second derivative used in cubic spline */
 };
 
+struct crspline
+{
+ int     n_curve;            /* number of curves */
+ int     n_tot;              /* total number of points (all curves) */
+ int    *offs;               /* first point of curve i (n_curve + 1) */
+ real   *energy;             /* energies of all curves (n_tot) */
+ real   *intens;             /* intensities of all curves (n_tot) */
+ real   *deriv2;             /* second derivatives for cubic spline */
+};
+
+struct crsplcur
+{
+ const real *energy;         /* energies of one curve in crspline */
+ const real *intens;         /* intensities of one curve */
+ const real *deriv2;         /* second derivatives of one curve */
+ int     leng;               /* number of points */
+ int     lo;                 /* current interval [lo, lo+1] */
+};
+
 struct rfspot 
 {
  real index1;      /* 1st index */
@@ -49,8 +72,10 @@ struct crivcur
                                 curves e.g. integral/superstructure */
  struct rfspot  spot_id;     /* set of spot indices (label) */
  real   eng_0;              /* energy of beam appearance (1.1) */
+ int    eng_0_the;          /* eng_0 is the first theo. energy (no "e0=") */
 
 /* theroretical data */
+ char   *the_index;          /* index list for theo. input ("ti=") */
  struct crelist *the_list;   /* theo. IV curve */
  int     the_leng;           /* number of data pairs in IV list */
  int     the_equidist;       /* indicates equidistant energies */
@@ -72,12 +97,32 @@ struct crivcur
  real    exp_last_eng;       /* last energy in expt. list */
  real    exp_max_int;        /* max. intensity value in list */
 
+/* cubic spline (SoA, shared by all curves; see cr_spline_setup) */
+ struct crspline *spline;    /* spline data or NULL */
+ int     exp_spl;            /* curve number of expt. list in spline */
+ int     the_spl;            /* curve number of theo. list in spline */
+
 /* R factor */
  real    overlap;            /* Energy overlap */
  real    weight;             /* relative weight in average */
  real    rfac;               /* R-factor */
 };
 
+struct crivbin
+{
+ char   *map;                /* start of file (mapped or read) */
+ long    map_len;            /* length of file in bytes */
+ int     mapped;             /* 1: map is memory mapped, 0: malloc'd */
+ int     n_beam;             /* number of beams in file */
+ int     n_eng;              /* number of energies in file */
+ double  e_ini;              /* initial energy [eV] (header) */
+ double  e_fin;              /* final energy [eV] (header) */
+ double  e_stp;              /* energy step [eV] (header) */
+ const char   *beams;        /* beam records (see cleed_ivbin.h) */
+ const double *energy;       /* energy column (n_eng) */
+ const double *intens;       /* intensity columns (n_beam * n_eng) */
+};
+
 struct crargs 
 {
  char  *ctrfile;             /* input control file */
@@ -91,6 +136,9 @@ struct crargs
  real  s_step;               /* shift of energy axes */
  real  vi;                   /* imaginary part of optical potential */
  int   all_groups;           /* flag: print R-factors of all group ID's */
+ int   serve;                /* flag: resident R factor service */
+ char  *sockfile;            /* socket for service (NULL: stdin/stdout) */
+ char  *yfile;               /* file for Y function residuals (NULL: none) */
 };
 
 /*********************************************************************
@@ -24,10 +24,22 @@ int   rf_nclines( char *);                 /* count data lines */
 /* high level input/output */
 struct crargs cr_rdargs (int, char * *);                       /* read argument list */
 struct crivcur *cr_input( char *, char *);                     /* read control file */
+int cr_input_the( struct crivcur *, char *);                   /* re-read theory */
+int cr_input_thebuf( struct crivcur *, char *, struct crivbin *);
+                                                               /* from buffer */
 struct crelist *cr_rdcleed( struct crivcur *, char *, char *); /* input of theor. data */
 struct crelist *cr_rdexpt( struct crivcur *, char *);          /* input of expt. data */
 void cr_intindl( char *, struct rfspot *, int);                /* line interpreter */
 
+/* binary theoretical input (crfrdbin.c) */
+int cr_ivbin_check( const char *);                             /* test magic number */
+struct crivbin *cr_ivbin_open( const char *);                  /* map binary file */
+struct crivbin *cr_ivbin_from_buffer( char *, long);           /* binary buffer */
+void cr_ivbin_close( struct crivbin *);                        /* unmap binary file */
+struct crelist *cr_rdcleed_bin( struct crivcur *, struct crivbin *, char *);
+                                                               /* input of theor. data */
+int cr_ivbin_write_text( struct crivbin *, FILE *);            /* convert to text */
+
 /* data output */
 /*
 int cr_output(struct crargs * ,  struct rfrfac * , int , int);
@@ -50,21 +62,41 @@ int cr_lorentz( struct crivcur * , real, char *);
 void cr_spline(struct crelist *, int ); /* prepare cubic spline */
 real cr_splint(real, struct crelist *, int ); /* prepare cubic spline */
 
+/* cubic splines for many curves (crfsplbat.c) */
+void cr_spline_solve(const real *, const real *, real *, int ,
+                     real *, real *);     /* 2nd derivatives (arrays) */
+struct crspline *cr_spline_alloc(int , const int *);
+void cr_spline_free(struct crspline *);
+int cr_spline_set(struct crspline *, int , const struct crelist *);
+int cr_spline_prep(struct crspline *);    /* prepare all curves */
+struct crspline *cr_spline_setup(struct crivcur *);
+                                           /* prepare all IV curves */
+void cr_splcur_init(struct crsplcur *, const struct crspline *, int );
+real cr_splcur_eval(struct crsplcur *, real ); /* monotone evaluation */
+
 /*
  r_factors
 */
 int cr_mklide(real *, real *, real *, real , real,
-              struct crelist *, int , struct crelist *, int );
+              const struct crspline *, int , int );
 int cr_mklist(real *, real *, real *, real , 
-              struct crelist *, int , struct crelist *, int );
+              const struct crspline *, int , int );
                                                 /* prepare comparison */
 real cr_r1( real *, real *, real *);            /* R1 factor */
 real cr_r2( real *, real *, real *);            /* R2 factor */
 real cr_rb( real *, real *, real *);            /* Rb1 factor */
 real cr_rp( real *, real *, real *, real );     /* Pendry's R factor */
+int cr_rp_resid( real *, real *, real *, real, real *, real *);
+                                                /* Y function differences */
+int cr_yres( struct crivcur *, struct crargs *, real, const char *);
+                                                /* write Rp residuals */
 
 real cr_rmin( struct crivcur *, struct crargs *, real *, real *, real *);
 
+/* resident R factor service (crfserve.c) */
+int cr_serve_eval( struct crivcur *, struct crargs *, real *, real *, real *);
+int cr_serve( struct crivcur *, struct crargs *);
+
 
 #endif /* CRFAC_FUNC_H */
 
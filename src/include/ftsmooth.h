@@ -15,6 +15,7 @@ GH/01.06.95 - Start transformation from f(x=0) = 0 and interpolate values
 GH/07.06.95 - x_0 = n_x/4 * x_step
 
 LD/18.06.13 - allow trimming of datasets with '--range <arg1> <arg2>'
+LD/19.10.26 - FFT based transform, batch mode for multi-column files
 
 ****************************************************************************/
 
@@ -76,15 +77,40 @@ extern "C" {
 #define OFFSET_Y_TO_VALUE 3   /* offset flag: make f(x) += offset */
 #define OFFSET_Y_TO_ZERO  4   /* offset flag: make ymin = 0 */
 #define INVALID_ARGUMENT_ERROR -1
+
+/* discrete Fourier transform of arbitrary length (ftsmooth_fft.c) */
+typedef struct ftsmooth_fft
+{
+  int n;                  /* transform length */
+  int m;                  /* length of radix-2 transform (power of 2) */
+  int bluestein;          /* 1 if n is not a power of 2 */
+  double *tw_re, *tw_im;  /* twiddle factors of radix-2 transform */
+  double *ch_re, *ch_im;  /* chirp exp(i pi k^2 / n) (Bluestein) */
+  double *bf_re, *bf_im;  /* transformed chirp filter (Bluestein) */
+  double *wk_re, *wk_im;  /* work space (m) */
+} ftsmooth_fft_t;
+
 /* function prototypes */
 int ftsmooth(FILE *out_stream, double *x, double *fx, int n_x, 
         double cutoff, double tailoff, int stdout_flag);
+
+int ftsmooth_batch(FILE *out_stream, double *x, double **fx, int n_x,
+        int n_col, double cutoff, double tailoff, int stdout_flag);
+
+ftsmooth_fft_t *ftsmooth_fft_init(int n);
+
+void ftsmooth_fft_free(ftsmooth_fft_t *plan);
+
+void ftsmooth_fft_exec(ftsmooth_fft_t *plan, double *re, double *im);
         
 void ftsmooth_usage(FILE *output);
 
 void ftsmooth_info();
 
-int read_data(FILE *in_stream, FILE *out_stream, double *x, double *fx);
+int read_data(FILE *in_stream, FILE *out_stream, double **x, double **fx);
+
+int read_columns(FILE *in_stream, FILE *out_stream, double **x,
+        double ***fx, int *n_col);
 
 int offset_data(double *x, double *fx, int n_x, double offset, 
         int offset_flag);
@@ -96,6 +122,9 @@ int rm_neg_data(double *x, double *fx, int n_x);
 
 int print_data(FILE *out_stream, double *x, double *fx, int n_x);
 
+int print_columns(FILE *out_stream, double *x, double **fx, int n_x,
+        int n_col);
+
 int decode_ranges(double *lbound, double *ubound, int *i_r, char *argv);
 
 void debug(char *debug_str, char *tag, int argc, char *argv[], 
@@ -106,11 +135,11 @@ void debug(char *debug_str, char *tag, int argc, char *argv[],
 	  double *lbound, double *ubound, int *del_flag);
       
 int parse_args(int argc, char *argv[], 
-	  FILE *in_stream, FILE *out_stream, 
+	  FILE **in_stream, FILE **out_stream, 
 	  int *stdin_flag, int *stdout_flag,
 	  double *cutoff, double *tailoff, char *mode,
 	  int *offset_flag, double *offset, int *range_flag, int *i_r,
-	  double *lbound, double *ubound, int *del_flag);
+	  double *lbound, double *ubound, int *del_flag, int *batch_flag);
       
 /* globals */
 extern char line_buffer[STRSZ];
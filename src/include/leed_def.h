@@ -339,6 +339,29 @@ typedef struct eng_str  /*!< contains all parameters that change during the
 /* Backwards-compatible alias used by several headers/sources. */
 typedef leed_eng_t leed_energy_t;
 
+/*********************************************************************
+  struct ivbin_str collects the intensities of all output beams for the
+  binary (columnar) results file (see "cleed_ivbin.h").
+*********************************************************************/
+/*! \struct leed_ivbin_t
+ *  \brief buffer for the binary IV output written at the end of the
+ *  energy loop. */
+typedef struct ivbin_str
+{
+ FILE *outfile;     /*!< binary output stream (opened with "wb") */
+ int  n_beams;      /*!< number of output beams */
+ int  n_eng;        /*!< number of energies allocated */
+ int  i_eng;        /*!< number of energies stored so far */
+ real e_ini;        /*!< initial energy [eV] */
+ real e_fin;        /*!< final energy [eV] */
+ real e_stp;        /*!< energy step [eV] */
+ real *ind_1;       /*!< 1st beam indices (n_beams) */
+ real *ind_2;       /*!< 2nd beam indices (n_beams) */
+ int  *set;         /*!< beam sets (n_beams) */
+ real *energy;      /*!< energies [eV] (n_eng) */
+ real *intens;      /*!< intensities, beam-major (n_beams * n_eng) */
+} leed_ivbin_t;
+
 #endif /* LEED_DEF_H */
 
 #ifdef __cplusplus /* If this is a C++ compiler, use C linkage */
@@ -106,6 +106,12 @@ int leed_output_beam_list(leed_beam_t **, leed_beam_t *, leed_energy_t *, FILE *
 int leed_output_int(mat , leed_beam_t *, leed_beam_t *, leed_var_t *, FILE * );
 int leed_output_iint_sym(mat , leed_beam_t *, leed_beam_t *, leed_var_t *, FILE * );
 
+    /* binary (columnar) IV output (loutbin.c) */
+leed_ivbin_t *leed_output_bin_init(FILE *, leed_beam_t *, leed_energy_t *);
+int leed_output_bin_int(mat , leed_beam_t *, leed_beam_t *, leed_var_t *,
+                        int , leed_ivbin_t *);
+int leed_output_bin_close(leed_ivbin_t *);
+
     /* check cpu time */
 double leed_cpu_time(FILE *, const char *);
 
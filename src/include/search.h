@@ -37,9 +37,8 @@ extern "C" {
 #include "search_func.h"
 #include "search_ver.h"
 
-extern struct sratom_str *sr_atoms;
-extern struct search_str *sr_search;
-extern char *sr_project;
+/* default search context (search_globals.c): the original globals */
+extern struct sr_context sr_default_context;
 
 /*********************************************************************
  End of include file 
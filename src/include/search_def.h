@@ -89,6 +89,114 @@ struct search_str
  real rf_range;        /* shift range for R factor */
 };
 
+/*
+  geometry screening (srckgeo.c): positions of the atoms for one
+  parameter set (structure of arrays), their images in the 3x3
+  surrounding unit cells and a cell list of the images. The arrays are
+  allocated by the first sr_geo_eval() and reused for all parameter sets.
+*/
+#define SR_RGEO_MAX 1.          /* no LEED calculation for rgeo above */
+
+struct sr_geoscreen
+{
+ int n_atoms;               /* number of atoms (0: not yet set up) */
+ int n_cell_max;            /* size of cell_head */
+ real r_max;                /* largest r_min of all atoms */
+ real *r_min;               /* min. radii (n_atoms) */
+ real *x, *y, *z;           /* positions (n_atoms) */
+ real *gx, *gy, *gz;        /* images (9 n_atoms, atom = index % n_atoms) */
+ int *cell_head;            /* first image in cell (-1: none) */
+ int *cell_next;            /* next image in the same cell */
+};
+
+/*
+  evaluation slot (see sr_evslot.c): scratch directory and file names
+  of one LEED/R factor evaluation
+*/
+#define SR_PATHSZ 1024
+
+struct sr_evslot
+{
+ int id;                    /* number of slot */
+ char dir[SR_PATHSZ];       /* scratch directory (empty: not open) */
+ char par_file[SR_PATHSZ];  /* overlayer parameters (input of LEED) */
+ char bsr_file[SR_PATHSZ];  /* bulk parameters with search angles */
+ char res_file[SR_PATHSZ];  /* IV curves (output of LEED) */
+ char out_file[SR_PATHSZ];  /* stdout of LEED program */
+ char dum_file[SR_PATHSZ];  /* stdout of R factor program */
+ char bul_file[SR_PATHSZ];  /* <project>.bul (shared, read only) */
+ char yres_file[SR_PATHSZ]; /* residuals of Rp (crfac -y, see srlm.c) */
+
+ int y_res;                 /* R factor program writes yres_file */
+ int fix_shift;             /* ... for the single shift shift_fix only */
+ real shift_fix;
+
+ real rfac;                 /* results of the last R factor evaluation: */
+ real rr;                   /* R factor, RR factor (error bars), */
+ real shift;                /* and energy shift */
+
+ struct sr_geoscreen geo;   /* workspace of sr_geo_eval */
+};
+
+/*
+  search context: everything a search needs besides its parameters.
+  Independent searches (threads of one process) use separate contexts;
+  the original globals sr_atoms, sr_search, sr_project and sa_idum are
+  the members of the default context sr_default_context (see search.h).
+*/
+struct sr_context
+{
+ struct sratom_str *atoms;  /* atoms and their dependence on parameters */
+ struct search_str *search; /* search parameters */
+ char *project;             /* project name (prefix of all file names) */
+
+ real rfac_min;             /* lowest R factor so far (sr_evalrf) */
+ real rfac_max;             /* highest R factor so far */
+ int n_eval;                /* number of evaluations */
+ int n_calc;                /* number of LEED calculations */
+ int rf_serv;               /* R factor service: 0 - not yet tried,
+                               1 - in use, -1 - not available */
+ struct sr_evslot slot0;    /* slot of sr_evalrf_ctx (opened on demand) */
+
+ long idum;                 /* seed for random number generator (sr_sa) */
+ int surrogate;             /* pre-screen trial points (sr_sg_eval) */
+};
+
+/*
+  one evaluation in the record file of the search log (sr_log.c)
+*/
+struct sr_logrec
+{
+ int i_eval;                /* number of evaluation */
+ int i_calc;                /* number of LEED calculation (0: none) */
+ int slot;                  /* evaluation slot */
+ double time;               /* end of evaluation (seconds since epoch) */
+ int n_par;                 /* number of parameters */
+ const real *par;           /* parameters (1..n_par) */
+ real rfac;                 /* R factor (rfac_max if not calculated), */
+ real shift;                /* energy shift, */
+ real rgeo;                 /* and geometry penalty */
+ double t_leed;             /* wall time of LEED program (s) */
+ double t_rfac;             /* wall time of R factor evaluation (s) */
+};
+
+/*
+  surrogate pre-screening (srsg.c): trial points of the simplex and
+  annealing searches whose predicted R factor is clearly above the best
+  one so far are not evaluated by LEED.
+*/
+struct sr_sgscreen
+{
+ struct sr_context *ctx;    /* context of the LEED evaluations */
+ struct sr_surrogate *model; /* Gaussian process (sr_surrogate.c) */
+ const char *log_file;      /* skipped points are logged here */
+ int n_min;                 /* minimum number of points for screening */
+ real y_best;               /* lowest evaluated R factor */
+ int n_eval;                /* number of LEED evaluations */
+ int n_skip;                /* number of points screened out */
+ int n_hit;                 /* number of repeated points (not evaluated) */
+};
+
 /*********************************************************************
  special definitions
 *********************************************************************/
@@ -114,6 +222,12 @@ struct search_str
 #define SR_POWELL         2
 #define SR_SIM_ANNEALING  3
 #define SR_GENETIC        4
+#define SR_ERROR_BARS     5     /* error bars at the minimum (sr_er) */
+#define SR_PARALLEL_TEMPERING 6 /* replica exchange annealing (sr_pt) */
+#define SR_LEVENBERG_MARQUARDT 7 /* fit of Y function residuals (sr_lm) */
+
+#define SR_PT_MAX_REPLICA 64    /* maximum number of replicas (sr_ptemper) */
+#define SR_MS_MAX_START  256    /* maximum number of starts (sr_ms) */
 
 /*!
     \def SR_SX
@@ -127,6 +241,15 @@ struct search_str
     
     \def SR_GA
     Entry into genetic algorithm search.
+
+    \def SR_PT
+    Entry into parallel tempering search.
+
+    \def SR_MS
+    Entry into multi-start search.
+
+    \def SR_LM
+    Entry into Levenberg-Marquardt fit of the Y function residuals.
 */  
 #if defined(USE_GSL) || defined(_USE_GSL)
     /* set search functions to GNU Scientific Library */
@@ -134,6 +257,10 @@ struct search_str
     #define SR_SA    sr_sa_gsl     
     #define SR_PO    sr_po_gsl
     #define SR_GA    sr_ga_gsl
+    #define SR_ER    sr_er
+    #define SR_PT    sr_pt
+    #define SR_MS    sr_ms
+    #define SR_LM    sr_lm
     #define SR_RDINP sr_rdinp
     #define I_PAR_0  0          /* start index for parameters */
 # else
@@ -142,6 +269,10 @@ struct search_str
     #define SR_SA    sr_sa
     #define SR_PO    sr_po
     #define SR_GA    sr_ga    
+    #define SR_ER    sr_er
+    #define SR_PT    sr_pt
+    #define SR_MS    sr_ms
+    #define SR_LM    sr_lm
     #define SR_RDINP sr_rdinp
     #define I_PAR_0  1          /* start index for parameters */
 #endif
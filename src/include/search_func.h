@@ -48,6 +48,27 @@ extern "C" {
  */
 int sr_amoeba(real **p, real *y, int ndim, real ftol, real (*funk)(real *), int *nfunk);
 
+/** Objective function with a user pointer (e.g. a search context). */
+typedef real (*sr_eval_func)(real *, void *);
+
+/**
+ * @brief Nelder–Mead downhill simplex minimiser, objective function with
+ * user pointer.
+ *
+ * @param p Simplex vertices (`[1..ndim+1][1..ndim]`), updated in-place.
+ * @param y Function values at `p` (`1..ndim+1`), updated in-place.
+ * @param ndim Dimensionality of the parameter vector.
+ * @param ftol Termination tolerance (absolute difference between best/worst).
+ * @param funk Objective function.
+ * @param data Second argument of @p funk.
+ * @param project Prefix of the vertex file written after each step
+ *        (`<project>.ver`, see sr_simplex_write_vertex()); NULL: none.
+ * @param nfunk Output evaluation counter.
+ * @return 0 on success, non-zero on failure.
+ */
+int sr_amoeba_data(real **p, real *y, int ndim, real ftol, sr_eval_func funk,
+                   void *data, const char *project, int *nfunk);
+
 typedef real (*sr_amebsa_func)(real *);
 
 /**
@@ -55,11 +76,17 @@ typedef real (*sr_amebsa_func)(real *);
  *
  * Grouping these inputs avoids "too many parameters" warnings and keeps
  * the public API stable while allowing internal evolution.
+ *
+ * Members added later must be zero for the original behaviour, i.e.
+ * initialise with `sr_amebsa_cfg cfg = {0};`.
  */
 typedef struct sr_amebsa_cfg {
   real ftol;
   sr_amebsa_func funk;
   real temptr;
+  sr_eval_func funk_data;  /**< used instead of funk if not NULL */
+  void *data;              /**< second argument of funk_data */
+  long *idum;              /**< seed, updated on return (NULL: default context) */
 } sr_amebsa_cfg;
 
 /**
@@ -76,6 +103,18 @@ static inline sr_amebsa_func sr_amebsa_cfg_get_funk(const sr_amebsa_cfg *cfg)
   return cfg ? cfg->funk : NULL;
 }
 
+/**
+ * @brief Accessor for the objective function with user pointer in
+ * @ref sr_amebsa_cfg.
+ *
+ * @param cfg Configuration pointer.
+ * @return Objective function pointer (may be NULL).
+ */
+static inline sr_eval_func sr_amebsa_cfg_get_funk_data(const sr_amebsa_cfg *cfg)
+{
+  return cfg ? cfg->funk_data : NULL;
+}
+
 /**
  * @brief Simulated annealing wrapper around the simplex method.
  *
@@ -91,6 +130,45 @@ static inline sr_amebsa_func sr_amebsa_cfg_get_funk(const sr_amebsa_cfg *cfg)
 int sr_amebsa(real **p, real *y, int ndim, real *pb, real *yb,
               const sr_amebsa_cfg *cfg, int *iter);
 
+/**
+ * @brief Configuration for @ref sr_ptemper.
+ */
+typedef struct sr_ptemper_cfg {
+  int n_replica;           /**< number of replicas (temperatures) */
+  int n_jobs;              /**< replicas annealed at the same time */
+  real t_min;              /**< temperature of the coldest replica */
+  real t_max;              /**< temperature of the hottest replica */
+  real ftol;               /**< tolerance passed to sr_amebsa() */
+  int iter;                /**< evaluations per replica and sweep */
+  int max_sweep;           /**< maximum number of sweeps */
+  int patience;            /**< sweeps without improvement (0: no limit) */
+  long idum;               /**< seed */
+  sr_eval_func funk;       /**< objective function */
+  void **data;             /**< data[k]: argument of funk for replica k */
+  /** called after each sweep with the coldest simplex (may be NULL) */
+  void (*checkpoint)(const real **p, const real *y, int ndim, void *arg);
+  void *checkpoint_arg;
+} sr_ptemper_cfg;
+
+/**
+ * @brief Parallel tempering: replicas of @ref sr_amebsa at fixed
+ * temperatures, run concurrently and exchanged between neighbouring
+ * temperatures (see sr_ptemper.c).
+ *
+ * @param p Simplices `p[0..n_replica-1]`, each `[1..ndim+1][1..ndim]`;
+ *          permuted on exchanges, p[0] is the coldest on return.
+ * @param y Function values `y[0..n_replica-1]`, each `1..ndim+1`.
+ * @param ndim Dimensionality of the parameter vector.
+ * @param pb Output best point (`1..ndim`).
+ * @param yb Output best function value.
+ * @param cfg Configuration.
+ * @param nfunc Output number of evaluations (may be NULL).
+ * @param nswap Output number of accepted exchanges (may be NULL).
+ * @return 0 on success, non-zero on failure.
+ */
+int sr_ptemper(real ***p, real **y, int ndim, real *pb, real *yb,
+               const sr_ptemper_cfg *cfg, int *nfunc, int *nswap);
+
 /**
  * @brief Powell direction-set minimiser.
  *
@@ -105,22 +183,138 @@ int sr_amebsa(real **p, real *y, int ndim, real *pb, real *yb,
  */
 int sr_powell(real *p, real **xi, int n, real ftol, int *iter, real *fret,
               real (*func)(real *));
+
+/**
+ * @brief Powell direction-set minimiser, objective function with user
+ * pointer (see @ref sr_powell).
+ */
+int sr_powell_data(real *p, real **xi, int n, real ftol, int *iter,
+                   real *fret, sr_eval_func func, void *data);
+
+/**
+ * @brief Residual function for @ref sr_levmar.
+ *
+ * Writes the residuals of point `par[1..ndim]` to `res[1..n]` and
+ * returns n (-1 if the residuals cannot be evaluated or n > n_max).
+ * `aux` is an auxiliary variable minimised by the function itself
+ * (e.g. the energy shift of the R factor): it is returned in `*aux`
+ * if `fix_aux` is 0 and taken from `*aux` otherwise.
+ */
+typedef int (*sr_resid_func)(real *par, real *res, int n_max, real *aux,
+                             int fix_aux, void *data);
+
+/**
+ * @brief Configuration for @ref sr_levmar.
+ */
+typedef struct sr_levmar_cfg {
+  int n_max;               /**< maximum number of residuals */
+  int n_jobs;              /**< Jacobian columns evaluated at the same time */
+  real h;                  /**< finite difference step */
+  int central;             /**< central (2 ndim) instead of forward differences */
+  real lambda;             /**< initial damping (0: default) */
+  real ftol;               /**< stop if the relative decrease is below ftol */
+  int max_iter;            /**< maximum number of Jacobians */
+  sr_resid_func func;      /**< residual function */
+  void **data;             /**< data[k]: argument of func for thread k */
+} sr_levmar_cfg;
+
+/**
+ * @brief Levenberg-Marquardt fit of a residual vector with a finite
+ * difference Jacobian evaluated in parallel (see sr_levmar.c).
+ */
+int sr_levmar(real *p, int ndim, real *chi2, const sr_levmar_cfg *cfg,
+              int *n_iter, int *n_eval);
 ///@}
 
 /* Drivers */
-void sr_sa(int ndim, real dpos, const char *bak_file, const char *log_file);
-void sr_sx(int ndim, real dpos, const char *bak_file, const char *log_file);
-void sr_po(int ndim, const char *bak_file, const char *log_file);
-void sr_er(int ndim, real dpos, const char *bak_file, const char *log_file);
+void sr_sa(struct sr_context *ctx, int ndim, real dpos, const char *bak_file,
+           const char *log_file);
+void sr_sx(struct sr_context *ctx, int ndim, real dpos, const char *bak_file,
+           const char *log_file);
+void sr_po(struct sr_context *ctx, int ndim, const char *bak_file,
+           const char *log_file);
+void sr_er(struct sr_context *ctx, int ndim, real dpos, int n_jobs,
+           const char *bak_file, const char *log_file);
+void sr_pt(struct sr_context *ctx, int ndim, real dpos, int n_jobs,
+           const char *bak_file, const char *log_file);
+void sr_ms(struct sr_context *ctx, int search_type, int n_start,
+           const char *start_file, int ndim, real dpos, int n_jobs,
+           const char *log_file);
+void sr_lm(struct sr_context *ctx, int ndim, real dpos, int n_jobs,
+           const char *log_file);
+
+/* search context */
+int  sr_context_init(struct sr_context *, const char *);
+void sr_context_free(struct sr_context *);
+
+/* geometry screening (srckgeo.c) */
+real sr_ckgeo(const struct sr_context *, real *);
+int  sr_geo_init(struct sr_geoscreen *, const struct sr_context *);
+real sr_geo_eval(struct sr_geoscreen *, const struct sr_context *,
+                 const real *);
+int  sr_geo_batch(struct sr_geoscreen *, const struct sr_context *, real **,
+                  int, real *);
+void sr_geo_free(struct sr_geoscreen *);
 
 /* file input|output */
-real sr_ckgeo(real *);
 int  sr_ckrot(struct sratom_str *, struct search_str *);
 real sr_evalrf(real *);
-int  sr_mkinp(real *, int, char *);
-int  sr_rdinp(const char *);
+real sr_evalrf_ctx(real *, void *);
+real sr_evalrf_slot(struct sr_context *, real *, struct sr_evslot *);
+int  sr_mkinp(const struct sr_context *, real *, int, const struct sr_evslot *);
+int  sr_rdinp(struct sr_context *, const char *);
 int  sr_rdver(const char *, real *, real **, int);
 
+/* search log: ring buffer and writer thread (sr_log.c) */
+int  sr_log_open(const char *);
+FILE *sr_log_begin(const char *);
+void sr_log_end(FILE *);
+void sr_log_record(const struct sr_logrec *);
+void sr_log_time(char *, size_t);
+double sr_log_clock(void);
+void sr_log_flush(void);
+void sr_log_close(void);
+
+/* evaluation slots (scratch directories) */
+int  sr_evslot_open(struct sr_evslot *, const char *, int);
+int  sr_evslot_promote(const struct sr_evslot *, const char *, real);
+void sr_evslot_close(struct sr_evslot *);
+
+/* cache of evaluations shared by concurrent searches */
+struct sr_evcache;
+struct sr_evcache *sr_evcache_new(int, real);
+int  sr_evcache_get(struct sr_evcache *, const real *, real *);
+void sr_evcache_put(struct sr_evcache *, const real *, real);
+void sr_evcache_stats(struct sr_evcache *, long *, long *);
+void sr_evcache_free(struct sr_evcache *);
+
+/* Gaussian process model of the R factor (surrogate) */
+struct sr_surrogate;
+struct sr_surrogate *sr_surrogate_new(int, real);
+int  sr_surrogate_add(struct sr_surrogate *, const real *, real);
+int  sr_surrogate_count(struct sr_surrogate *);
+int  sr_surrogate_lookup(struct sr_surrogate *, const real *, real, real *);
+int  sr_surrogate_predict(struct sr_surrogate *, const real *, real *, real *);
+real sr_surrogate_ei(struct sr_surrogate *, const real *, real);
+real sr_surrogate_propose(struct sr_surrogate *, const real *, real, int,
+                          real, long, real *);
+void sr_surrogate_free(struct sr_surrogate *);
+
+/* surrogate pre-screening of trial points (srsg.c) */
+int  sr_sg_init(struct sr_sgscreen *, struct sr_context *, int, real,
+                const char *);
+real sr_sg_eval(real *, void *);
+void sr_sg_add(struct sr_sgscreen *, real *, real);
+real sr_sg_propose(struct sr_sgscreen *, real **, real *, int, real, long,
+                   real *);
+void sr_sg_report(const struct sr_sgscreen *, const char *);
+void sr_sg_free(struct sr_sgscreen *);
+
+/* resident R factor service (crfac --serve) */
+int  sr_rfserv_open(const char *, const char *, real , real , real );
+int  sr_rfserv_eval(const char *, real *, real *, real *);
+void sr_rfserv_close(void);
+
 /* debye temperature */
 real leed_inp_debye_temp(real , real , real );
 
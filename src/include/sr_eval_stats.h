@@ -0,0 +1,175 @@
+/*********************************************************************
+ *                     SR_EVAL_STATS.H
+ *
+ *  GPL-3.0-or-later
+ *
+ *  Streaming statistics over the evaluation history of SEARCH.
+ *********************************************************************/
+
+#ifndef SR_EVAL_STATS_H
+#define SR_EVAL_STATS_H
+
+#include "real.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file sr_eval_stats.h
+ * @brief One-pass statistics over the evaluations of one or more searches
+ * (log file lines or `csearch --trace` records), used by `evstat`.
+ *
+ * The memory used does not depend on the number of evaluations: the
+ * accumulators are O(n_par^2) means and co-moments, a fixed R factor
+ * histogram, a bounded list of best-so-far steps and one time stamp per
+ * evaluation slot.
+ *
+ * Parameter vectors are 1-based (`1..n_par`). Index 0 of the co-moment
+ * matrix is the R factor, indices `1..n_par` are the parameters.
+ */
+
+#define SR_EVSTAT_DBIN      0.001  /**< width of the R factor histogram bins */
+#define SR_EVSTAT_NBIN      2000   /**< bins in [0, NBIN*DBIN); plus overflow */
+#define SR_EVSTAT_MAX_STEP  1024   /**< best-so-far steps kept per search */
+#define SR_EVSTAT_MAX_SLOT  256    /**< evaluation slots with wall times */
+#define SR_EVSTAT_N_CONV    3      /**< convergence thresholds (see below) */
+
+/** @brief Thresholds above the final best value (convergence table). */
+#define SR_EVSTAT_CONV_DR   { 0.05, 0.01, 0.001 }
+
+/**
+ * @brief One evaluation as read from a log or trace line.
+ *
+ * Values that the line format does not contain are negative
+ * (`i_calc`, `slot`, `time`, `t_leed`, `t_rfac`).
+ */
+typedef struct sr_evstat_eval {
+  int i_eval;            /**< number of evaluation */
+  int i_calc;            /**< number of LEED calculation, 0: none */
+  int slot;              /**< evaluation slot */
+  int rejected;          /**< geometry rejected (rf is rfac_max) */
+  int n_par;             /**< number of parameters */
+  real *par;             /**< parameters (`1..n_par`), set by the caller */
+  double rfac;           /**< R factor */
+  double shift;          /**< energy shift */
+  double rgeo;           /**< geometry penalty */
+  double rtot;           /**< minimised value rfac + rgeo */
+  double time;           /**< end of evaluation (seconds) */
+  double t_leed;         /**< wall time of the LEED program (s) */
+  double t_rfac;         /**< wall time of the R factor evaluation (s) */
+} sr_evstat_eval;
+
+/** @brief Convergence of one search (sr_evstat_end()). */
+typedef struct sr_evstat_conv {
+  long n_eval;                      /**< evaluations of the search */
+  double r_first;                   /**< first value of rtot */
+  double r_best;                    /**< best value of rtot */
+  int i_best;                       /**< evaluation of r_best */
+  int i_conv[SR_EVSTAT_N_CONV];     /**< first evaluation within the
+                                         thresholds SR_EVSTAT_CONV_DR */
+  int n_step;                       /**< improvements of best-so-far */
+  double elapsed;                   /**< last minus first time stamp, <0:
+                                         no time stamps */
+} sr_evstat_conv;
+
+/** @brief Accumulators (sr_evstat_init() / sr_evstat_free()). */
+typedef struct sr_evstat {
+  int n_par;
+  double r_cut;          /**< only rfac <= r_cut enter the moments */
+
+  long n_eval;           /**< all evaluations */
+  long n_calc;           /**< evaluations with LEED calculation */
+  long n_rejected;       /**< rejected geometries */
+  long n_skip;           /**< lines with a different number of parameters */
+
+  /* means and co-moments of (rfac, par[1..n_par]) */
+  long n_mom;
+  double *mean;          /**< 0..n_par */
+  double *com;           /**< (n_par+1)^2, row major */
+  double *work;          /**< 2 (n_par+1) */
+
+  /* R factor distribution (LEED evaluations) */
+  double r_min, r_max;
+  long hist[SR_EVSTAT_NBIN + 1];
+
+  /* timing: Delta t per slot and times of LEED/R factor program */
+  long n_wall;
+  double t_wall, t_wall_leed, t_wall_rfac;
+  long n_time;
+  double t_leed, t_rfac;
+  double t_slot[SR_EVSTAT_MAX_SLOT];
+
+  /* current search: best-so-far steps */
+  long s_eval;
+  double s_first, s_t0, s_t1;
+  int n_step, n_step_tot;
+  int step_i[SR_EVSTAT_MAX_STEP];
+  double step_r[SR_EVSTAT_MAX_STEP];
+} sr_evstat;
+
+/**
+ * @brief Read one line of a log file (`#  n par: ... rf: ...`) or of a
+ * trace file (`{"eval":n,...}`).
+ *
+ * @param line Input line.
+ * @param ev Output; `ev->par` must point to a 1-based vector of
+ *        @p max_par elements.
+ * @param max_par Maximum number of parameters.
+ * @return 1 if @p line is an evaluation, 0 if it is not, -1 if it is
+ *         malformed or has more than @p max_par parameters.
+ */
+int sr_evstat_parse(const char *line, sr_evstat_eval *ev, int max_par);
+
+/**
+ * @brief Set up the accumulators for @p n_par parameters.
+ *
+ * @param r_cut Only LEED evaluations with rfac <= r_cut enter the
+ *        parameter statistics (use a large value for all).
+ * @return 0 on success, -1 on allocation failure.
+ */
+int sr_evstat_init(sr_evstat *st, int n_par, double r_cut);
+
+/** @brief Start a new search (file): reset best-so-far and time stamps. */
+void sr_evstat_begin(sr_evstat *st);
+
+/**
+ * @brief Add one evaluation.
+ *
+ * @return 0 if used, -1 if the number of parameters differs.
+ */
+int sr_evstat_add(sr_evstat *st, const sr_evstat_eval *ev);
+
+/** @brief Convergence of the search started by sr_evstat_begin(). */
+void sr_evstat_end(const sr_evstat *st, sr_evstat_conv *conv);
+
+/**
+ * @brief Quantile @p q (0..1) of the R factors (bin resolution).
+ *
+ * @return quantile, -1 if there are no LEED evaluations.
+ */
+double sr_evstat_quantile(const sr_evstat *st, double q);
+
+/** @brief Mean of variable @p i (0: R factor, 1..n_par: parameters). */
+double sr_evstat_mean(const sr_evstat *st, int i);
+
+/** @brief Standard deviation of variable @p i. */
+double sr_evstat_dev(const sr_evstat *st, int i);
+
+/** @brief Correlation coefficient of variables @p i and @p j (0 if undefined). */
+double sr_evstat_corr(const sr_evstat *st, int i, int j);
+
+/**
+ * @brief Sensitivity dR/dp of the R factor to parameter @p i_par
+ * (slope of the linear regression of R on par[i_par]).
+ */
+double sr_evstat_slope(const sr_evstat *st, int i_par);
+
+/** @brief Free the accumulators of sr_evstat_init(). */
+void sr_evstat_free(sr_evstat *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SR_EVAL_STATS_H */
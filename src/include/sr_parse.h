@@ -37,6 +37,19 @@ extern "C" {
  */
 int sr_parse_two_reals(const char *line, real *out_a, real *out_b);
 
+/**
+ * @brief Parse @p n whitespace-delimited @ref real values from a line.
+ *
+ * Same rules as @ref sr_parse_two_reals; further tokens after the n-th
+ * value are ignored. On failure the contents of @p out are undefined.
+ *
+ * @param line Input line buffer (NUL-terminated).
+ * @param out Output values (`out[0..n-1]`).
+ * @param n Number of values.
+ * @return 0 on success, non-zero on failure.
+ */
+int sr_parse_reals(const char *line, real *out, int n);
+
 /**
  * @brief Scan a file until a line containing two @ref real values is found.
  *
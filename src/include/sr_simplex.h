@@ -98,9 +98,27 @@ void sr_simplex_buffers_free(sr_simplex_buffers *b);
  * @param b Allocated simplex buffers.
  * @param dpos Initial displacement for axis-aligned vertices.
  * @param func Objective function to evaluate at each vertex.
+ * @param data Second argument of @p func.
  * @return 0 on success, non-zero on invalid inputs.
  */
-int sr_simplex_build_initial(sr_simplex_buffers *b, real dpos, real (*func)(real *));
+int sr_simplex_build_initial(sr_simplex_buffers *b, real dpos,
+                             sr_eval_func func, void *data);
+
+/**
+ * @brief Build an axis-aligned initial simplex around a given point.
+ *
+ * As sr_simplex_build_initial(), but vertex 1 is @p centre (`1..ndim`;
+ * NULL: origin) and the other vertices are displaced from it.
+ *
+ * @param b Allocated simplex buffers.
+ * @param centre First vertex (may be NULL).
+ * @param dpos Initial displacement for axis-aligned vertices.
+ * @param func Objective function to evaluate at each vertex.
+ * @param data Second argument of @p func.
+ * @return 0 on success, non-zero on invalid inputs.
+ */
+int sr_simplex_build_at(sr_simplex_buffers *b, const real *centre, real dpos,
+                        sr_eval_func func, void *data);
 
 /**
  * @brief Populate simplex buffers by reading a vertex file via sr_rdver().
@@ -111,6 +129,19 @@ int sr_simplex_build_initial(sr_simplex_buffers *b, real dpos, real (*func)(real
  */
 int sr_simplex_read_vertex(sr_simplex_buffers *b, const char *bak_file);
 
+/**
+ * @brief Write a simplex to `<project>.ver` (checkpoint for resuming
+ * with `csearch -v`); the previous file is kept as `<project>.vbk`.
+ *
+ * @param project Project name (file prefix).
+ * @param p Simplex vertices (`[1..ndim+1][1..ndim]`).
+ * @param y Function values (`1..ndim+1`).
+ * @param ndim Dimensionality of the parameter vector.
+ * @return 0 on success (or if @p project is NULL or empty), -1 on failure.
+ */
+int sr_simplex_write_vertex(const char *project, const real **p,
+                            const real *y, int ndim);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
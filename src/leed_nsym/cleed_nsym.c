@@ -13,6 +13,8 @@ LD/27.03.14 - added OMP parallel for loop for energy and inverted
               (use '-D_USE_OPENMP' & '-fopenmp' flags when compiling)
 LD/02.04.14 - added '--help', '-h' & '-V' options for usage and info,
               respectively (added functions usage() & info() )
+LD/19.10.26 - added '-B' / '--binary' option for binary (columnar)
+              results file (see cleed_ivbin.h).
 
 *********************************************************************/
 
@@ -65,6 +67,7 @@ leed_beam_t *beams_now;
 leed_beam_t *beams_set;
 leed_var_t *v_par;
 leed_energy_t *eng;
+leed_ivbin_t *ivbin;
 
 mat Tpp,   Tmm,   Rpm,   Rmp;
 mat Tpp_s, Tmm_s, Rpm_s, Rmp_s;
@@ -72,6 +75,7 @@ mat R_bulk, R_tot;
 mat Amp;
 
 int ctr_flag;
+int bin_flag;
 int i_c, i_arg;
 int n_beams_now, n_beams_set;
 int i_set, n_set, offset;
@@ -103,6 +107,7 @@ FILE *res_stream;
   beams_out   = NULL;
   v_par = NULL;
   eng   = NULL;
+  ivbin = NULL;
 
 
 /*********************************************************************
@@ -110,6 +115,7 @@ FILE *res_stream;
 *********************************************************************/
 
   ctr_flag = CTR_NORMAL;
+  bin_flag = 0;
 
   strncpy(bul_file,"---", STRSZ);
 
@@ -125,6 +131,7 @@ FILE *res_stream;
     -i <par_file> - (mandatory input file) overlayer parameters of all 
                     parameters (if bul_file does not exist).
     -o <res_file> - (output file) IV output.
+    -B            - write IV output in binary (columnar) format.
 *********************************************************************/
 
   for (i_arg = 1; i_arg < argc; i_arg++)
@@ -193,6 +200,13 @@ FILE *res_stream;
         ctr_flag = CTR_EARLY_RETURN;
       } /* -e */
 
+/* Binary output */
+      if(strcmp(argv[i_arg], "-B") == 0 ||
+         strcmp(argv[i_arg], "--binary") == 0)
+      {
+        bin_flag = 1;
+      } /* -B */
+
 
     }  /* else */
   }  /* for i_arg */
@@ -237,6 +251,16 @@ FILE *res_stream;
     } 
   }
 
+  if( bin_flag && ((res_stream = freopen(res_file, "wb", res_stream)) == NULL) )
+  {
+#ifdef ERROR
+    fprintf(STDERR,
+    "*** error (CLEED_NSYM): could not open binary output file \"%s\"\n",
+    res_file);
+#endif
+    exit(1);
+  }
+
 /*********************************************************************
   Read input parameters
 *********************************************************************/
@@ -254,8 +278,17 @@ FILE *res_stream;
     exit(0);
   }
 
-  leed_out_head(res_stream);
-  leed_output_beam_list(&beams_out, beams_all, eng, res_stream);
+  if( bin_flag )
+  {
+    leed_output_beam_list(&beams_out, beams_all, eng, NULL);
+    if( (ivbin = leed_output_bin_init(res_stream, beams_out, eng)) == NULL)
+      exit(1);
+  }
+  else
+  {
+    leed_out_head(res_stream);
+    leed_output_beam_list(&beams_out, beams_all, eng, res_stream);
+  }
 
 /*********************************************************************
  Prepare some often used parameters.
@@ -588,7 +621,10 @@ FILE *res_stream;
 ********************************************/
 
     Amp = leed_ld_potstep0(Amp, R_tot, beams_now, v_par->eng_v, vec);
-    leed_output_int(Amp, beams_now, beams_out, v_par, res_stream);
+    if( bin_flag )
+      leed_output_bin_int(Amp, beams_now, beams_out, v_par, 0, ivbin);
+    else
+      leed_output_int(Amp, beams_now, beams_out, v_par, res_stream);
 
 /********************************************
     Write cpu time to output 
@@ -605,6 +641,7 @@ FILE *res_stream;
   fprintf(STDCTR, "(LEED): end of energy loop: close files\n");
 #endif
 
+  if( bin_flag ) leed_output_bin_close(ivbin);
   fclose(res_stream);
 
 #ifdef CONTROL
@@ -0,0 +1,334 @@
+/*********************************************************************
+  LD/19.10.26
+  file contains functions:
+
+  leed_ivbin_t *leed_output_bin_init(FILE *outfile,
+                 leed_beam_t *beams_out, leed_energy_t *eng)
+  int leed_output_bin_int(mat Amp, leed_beam_t *beams_now,
+                 leed_beam_t *beams_all, leed_var_t *par, int sym,
+                 leed_ivbin_t *ivbin)
+  int leed_output_bin_close(leed_ivbin_t *ivbin)
+
+ Binary (columnar) intensity output. The layout of the output file is
+ described in "cleed_ivbin.h".
+
+ Changes:
+
+ LD/19.10.26 - Creation (binary counterpart of loutint.c/loutintsym.c)
+
+*********************************************************************/
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "leed.h"
+#include "cleed_ivbin.h"
+
+#ifndef INT_TOLERANCE            /* should be defined in "leed_def.h" */
+#define INT_TOLERANCE 1.e-10               /* min intensity != 0. */
+#endif
+
+/*======================================================================*/
+
+static void ivbin_put_u32(unsigned char *buf, unsigned long val)
+{
+ int i;
+ for(i = 0; i < 4; i++) buf[i] = (unsigned char)((val >> (8*i)) & 0xFF);
+}
+
+static void ivbin_put_f64(unsigned char *buf, double val)
+{
+ int i;
+ unsigned char bytes[8];
+ unsigned long long bits;
+
+ memcpy(&bits, &val, 8);
+ for(i = 0; i < 8; i++) bytes[i] = (unsigned char)((bits >> (8*i)) & 0xFF);
+ memcpy(buf, bytes, 8);
+}
+
+static int ivbin_write_column(real *col, int n, FILE *outfile)
+{
+ int i;
+ unsigned char buf[8];
+
+ for(i = 0; i < n; i++)
+ {
+   ivbin_put_f64(buf, (double)col[i]);
+   if(fwrite(buf, 1, 8, outfile) != 8) return(-1);
+ }
+ return(n);
+}
+
+/*======================================================================*/
+
+leed_ivbin_t *leed_output_bin_init(FILE *outfile,
+               leed_beam_t *beams_out, leed_energy_t *eng)
+
+/************************************************************************
+
+ Prepare the binary output of beam intensities.
+
+ INPUT:
+
+  FILE * outfile - binary output stream (should be opened with "wb").
+  leed_beam_t *beams_out - list of output beams as created by
+            leed_output_beam_list (terminated by F_END_OF_LIST in k_par).
+  leed_energy_t *eng - control parameters of the energy loop (Hartree).
+
+ RETURN VALUES:
+
+  pointer to the output buffer,
+  NULL if failed.
+
+ DESIGN:
+
+  The number of energies is counted with the same loop as in
+  leed_output_beam_list. Space for all intensities is allocated here;
+  the file itself is only written by leed_output_bin_close.
+
+*************************************************************************/
+{
+int i_beam, n_beams, n_eng;
+real faux;
+leed_ivbin_t *ivbin;
+
+ for(n_beams = 0;
+     ! IS_EQUAL_REAL((beams_out + n_beams)->k_par, F_END_OF_LIST);
+     n_beams ++) { ; }
+
+ for(faux = eng->ini, n_eng = 0; faux <= eng->fin; faux += eng->stp, n_eng++)
+ { ; }
+
+ /* the energy loop may run downwards (eng->stp < 0) */
+ if(n_eng < 1) n_eng = 1;
+
+ ivbin = (leed_ivbin_t *)calloc(1, sizeof(leed_ivbin_t));
+ if(ivbin == NULL)
+ {
+#ifdef ERROR
+   fprintf(STDERR," *** error (leed_output_bin_init): allocation error.\n");
+#endif
+   return(NULL);
+ }
+
+ ivbin->outfile = outfile;
+ ivbin->n_beams = n_beams;
+ ivbin->n_eng = n_eng;
+ ivbin->i_eng = 0;
+ ivbin->e_ini = eng->ini*HART;
+ ivbin->e_fin = eng->fin*HART;
+ ivbin->e_stp = eng->stp*HART;
+
+ ivbin->ind_1  = (real *)calloc(n_beams + 1, sizeof(real));
+ ivbin->ind_2  = (real *)calloc(n_beams + 1, sizeof(real));
+ ivbin->set    = (int *)calloc(n_beams + 1, sizeof(int));
+ ivbin->energy = (real *)calloc(n_eng, sizeof(real));
+ ivbin->intens = (real *)calloc((n_beams + 1) * n_eng, sizeof(real));
+
+ if( (ivbin->ind_1 == NULL) || (ivbin->ind_2 == NULL) ||
+     (ivbin->set == NULL) || (ivbin->energy == NULL) ||
+     (ivbin->intens == NULL) )
+ {
+#ifdef ERROR
+   fprintf(STDERR," *** error (leed_output_bin_init): allocation error.\n");
+#endif
+   leed_output_bin_close(ivbin);
+   return(NULL);
+ }
+
+ for(i_beam = 0; i_beam < n_beams; i_beam ++)
+ {
+   ivbin->ind_1[i_beam] = (beams_out + i_beam)->ind_1;
+   ivbin->ind_2[i_beam] = (beams_out + i_beam)->ind_2;
+   ivbin->set[i_beam]   = (beams_out + i_beam)->set;
+ }
+
+ return(ivbin);
+}  /* end of function leed_output_bin_init */
+
+/*======================================================================*/
+
+int leed_output_bin_int(mat Amp, leed_beam_t *beams_now,
+            leed_beam_t *beams_all, leed_var_t *par, int sym,
+            leed_ivbin_t *ivbin)
+
+/************************************************************************
+
+ Store the beam intensities of the current energy in the binary output
+ buffer.
+
+ INPUT:
+
+  mat Amp - (input) vector containing the beam amplitudes of all beams
+           included at the current energy.
+  leed_beam_t *beams_now  -  all beams included at the current energy.
+  leed_beam_t *beams_all  -  all beams included at the highest energy.
+  leed_var_t *par - current energy parameters.
+  int sym - if non-zero, intensities are divided by the number of
+           symmetry-equivalent beams (as in leed_output_iint_sym).
+  leed_ivbin_t *ivbin - output buffer (from leed_output_bin_init).
+
+ RETURN VALUES:
+
+  number of beams included at the current energy.
+  -1 if failed.
+
+*************************************************************************/
+{
+int i_beams_now, i_beams_all, i_eng;
+real *new_eng, *new_int;
+
+mat Int;
+real k_r, val;
+
+ Int = NULL;
+
+/*********************************************************
+   Grow buffer if the energy loop produces more energies
+   than counted in leed_output_bin_init.
+*********************************************************/
+
+ if(ivbin->i_eng >= ivbin->n_eng)
+ {
+   new_eng = (real *)realloc(ivbin->energy, 2*ivbin->n_eng * sizeof(real));
+   new_int = (real *)calloc((ivbin->n_beams + 1) * 2*ivbin->n_eng,
+                            sizeof(real));
+   if( (new_eng == NULL) || (new_int == NULL) )
+   {
+#ifdef ERROR
+     fprintf(STDERR," *** error (leed_output_bin_int): allocation error.\n");
+#endif
+     return(-1);
+   }
+   for(i_beams_all = 0; i_beams_all < ivbin->n_beams; i_beams_all ++)
+     memcpy(new_int + i_beams_all * 2*ivbin->n_eng,
+            ivbin->intens + i_beams_all * ivbin->n_eng,
+            ivbin->n_eng * sizeof(real));
+   free(ivbin->intens);
+   ivbin->energy = new_eng;
+   ivbin->intens = new_int;
+   ivbin->n_eng *= 2;
+ }
+
+ i_eng = ivbin->i_eng;
+
+/*********************************************************
+   Calculate intensities as the square of the moduli of the
+   amplitudes (same rules as for text output).
+*********************************************************/
+
+ Int = matsqmod(Int, Amp);
+ k_r = R_sqrt(2*par->eng_v);
+
+ ivbin->energy[i_eng] = par->eng_v*HART;
+
+ for(i_beams_all = 0; i_beams_all < ivbin->n_beams; i_beams_all ++)
+ {
+   val = 0.;
+   for(i_beams_now = 0; i_beams_now < Int->rows; i_beams_now ++)
+   {
+     if( IS_EQUAL_REAL((beams_all+i_beams_all)->ind_1, (beams_now+i_beams_now)->ind_1) &&
+         IS_EQUAL_REAL((beams_all+i_beams_all)->ind_2, (beams_now+i_beams_now)->ind_2)  )
+     {
+       if( ((beams_now + i_beams_now)->k_par <= k_r) &&
+           (Int->rel[i_beams_now + 1] > INT_TOLERANCE) )
+       {
+         val = Int->rel[i_beams_now + 1];
+         if(sym) val /= (beams_now + i_beams_now)->n_eqb_s;
+       }
+       break;
+     }  /* if index = index */
+   }  /* for i_beams_now */
+
+   ivbin->intens[i_beams_all * ivbin->n_eng + i_eng] = val;
+ } /* for i_beams_all */
+
+ ivbin->i_eng ++;
+
+ matfree(Int);
+ return(i_beams_now);
+}  /* end of function leed_output_bin_int */
+
+/*======================================================================*/
+
+int leed_output_bin_close(leed_ivbin_t *ivbin)
+
+/************************************************************************
+
+ Write the binary output file and free the output buffer.
+ The stream ivbin->outfile is flushed but not closed.
+
+ RETURN VALUES:
+
+  number of energies written.
+  -1 if failed.
+
+*************************************************************************/
+{
+int i_beam, n_eng, ret;
+unsigned char head[IVBIN_HEAD_SIZE];
+unsigned char rec[IVBIN_BEAM_SIZE];
+
+ if(ivbin == NULL) return(-1);
+
+ ret = -1;
+ n_eng = ivbin->i_eng;
+
+ if( (ivbin->outfile != NULL) && (ivbin->intens != NULL) )
+ {
+   ret = n_eng;
+
+   memset(head, 0, IVBIN_HEAD_SIZE);
+   memcpy(head, IVBIN_MAGIC, IVBIN_MAGIC_LEN);
+   ivbin_put_u32(head + IVBIN_OFFS_VERSION, IVBIN_VERSION);
+   ivbin_put_u32(head + IVBIN_OFFS_DATA, IVBIN_DATA_OFFSET(ivbin->n_beams));
+   ivbin_put_u32(head + IVBIN_OFFS_N_BEAM, ivbin->n_beams);
+   ivbin_put_u32(head + IVBIN_OFFS_N_ENG, n_eng);
+   ivbin_put_f64(head + IVBIN_OFFS_E_INI, ivbin->e_ini);
+   ivbin_put_f64(head + IVBIN_OFFS_E_FIN, ivbin->e_fin);
+   ivbin_put_f64(head + IVBIN_OFFS_E_STP, ivbin->e_stp);
+
+   if(fwrite(head, 1, IVBIN_HEAD_SIZE, ivbin->outfile) != IVBIN_HEAD_SIZE)
+     ret = -1;
+
+   for(i_beam = 0; (ret != -1) && (i_beam < ivbin->n_beams); i_beam ++)
+   {
+     memset(rec, 0, IVBIN_BEAM_SIZE);
+     ivbin_put_f64(rec, ivbin->ind_1[i_beam]);
+     ivbin_put_f64(rec + 8, ivbin->ind_2[i_beam]);
+     ivbin_put_u32(rec + 16, (unsigned long)ivbin->set[i_beam]);
+     if(fwrite(rec, 1, IVBIN_BEAM_SIZE, ivbin->outfile) != IVBIN_BEAM_SIZE)
+       ret = -1;
+   }
+
+   if( (ret != -1) && (ivbin_write_column(ivbin->energy, n_eng, ivbin->outfile) < 0) )
+     ret = -1;
+
+   for(i_beam = 0; (ret != -1) && (i_beam < ivbin->n_beams); i_beam ++)
+   {
+     if(ivbin_write_column(ivbin->intens + i_beam * ivbin->n_eng,
+                           n_eng, ivbin->outfile) < 0)
+       ret = -1;
+   }
+
+   fflush(ivbin->outfile);
+
+#ifdef ERROR
+   if(ret == -1)
+     fprintf(STDERR," *** error (leed_output_bin_close): write error.\n");
+#endif
+ }
+
+ free(ivbin->ind_1);
+ free(ivbin->ind_2);
+ free(ivbin->set);
+ free(ivbin->energy);
+ free(ivbin->intens);
+ free(ivbin);
+
+ return(ret);
+}  /* end of function leed_output_bin_close */
+/************************************************************************/
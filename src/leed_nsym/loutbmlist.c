@@ -14,6 +14,7 @@
  GH/20.07.95 - Creation
  GH/11.08.95 - write only non-evanescent beams to output. Return value
                is a list of nonevanescent beams at eng->fin.
+ LD/19.10.26 - outfile can be NULL (binary output, no text header).
 
 *********************************************************************/
 
@@ -60,7 +61,7 @@ int leed_output_beam_list(leed_beam_t ** p_beams_out,
             eng->stp = energy step.
         
   FILE * outfile - (input) pointer to the output file were the intensities 
-            are written to.
+            are written to. If NULL, only beams_out is created.
 
  DESIGN:
 
@@ -178,6 +179,13 @@ leed_beam_t *beams_out;
   - 
 ************************************************************************/
 
+/* no text output (e.g. binary results file) */
+ if(outfile == NULL)
+ {
+   *p_beams_out = beams_out;
+   return(n_beams);
+ }
+
 /* energies */
  for(faux = eng->ini, n_eng = 0; 
      faux <= eng->fin; 
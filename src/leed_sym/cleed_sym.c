@@ -19,6 +19,8 @@ Changes:
 version 1.1
  GH/27.09.00 - version 1.1
  LD/21.04.14 - added --help and --version arguments
+ LD/19.10.26 - added -B/--binary argument for binary (columnar) results
+               file (see cleed_ivbin.h).
 *********************************************************************/
 
 #include <stdio.h>
@@ -57,6 +59,7 @@ leed_beam_t *beams_now;
 leed_beam_t *beams_set;
 leed_var_t *v_par;
 leed_energy_t *eng;
+leed_ivbin_t *ivbin;
 
 mat Tpp,   Tmm,   Rpm,   Rmp;
 mat Tpp_s, Tmm_s, Rpm_s, Rmp_s;
@@ -64,6 +67,7 @@ mat R_bulk, R_tot;
 mat Amp;
 
 int ctr_flag;  /****i wegen control****/
+int bin_flag;
 int i_c, i_arg;
 int n_beams_now, n_beams_set;
 int i_set, n_set, offset;
@@ -97,6 +101,7 @@ FILE *res_stream;
  beams_out = NULL;
  v_par = NULL;
  eng = NULL;
+ ivbin = NULL;
  
  n_set = 0;
 
@@ -117,6 +122,7 @@ FILE *res_stream;
   strncpy(pro_name,"leed.pro", STRSZ);
 
   ctr_flag = FLAG_NONE;
+  bin_flag = 0;
 
 /*********************************************************************
   Decode arguments:
@@ -130,6 +136,7 @@ FILE *res_stream;
                     matrices from.
     -w <pro_name> - (output file) top write parameters and scattering
                     matrices to.
+    -B            - write IV output in binary (columnar) format.
 *********************************************************************/
 
  for (i_arg = 1; i_arg < argc; i_arg++)
@@ -209,6 +216,12 @@ FILE *res_stream;
     }
    }
 
+/* Binary output */
+   if(strcmp(argv[i_arg], "-B") == 0 || strcmp(argv[i_arg], "--binary") == 0)
+   {
+    bin_flag = 1;
+   }
+
 /* Read project name for writing matrices */
    if(strncmp(argv[i_arg], "-w", 2) == 0)
    {
@@ -268,6 +281,16 @@ FILE *res_stream;
    } 
  }
 
+ if( bin_flag && ((res_stream = freopen(res_file, "wb", res_stream)) == NULL) )
+ {
+#ifdef ERROR
+   fprintf(STDERR,
+   "*** error (%s): could not open binary output file \"%s\"\n",
+   LEED_NAME, res_file);
+#endif
+   exit(1);
+ }
+
 /*********************************************************************
   Read input parameters
 *********************************************************************/
@@ -321,8 +344,17 @@ FILE *res_stream;
  }  /* switch */
    
 /**** leed_inp_show_beam_op(bulk, over, phs_shifts);***/
- leed_out_head_2 (LEED_VERSION, LEED_NAME, res_stream);
- leed_output_beam_list (&beams_out, beams_all, eng, res_stream);
+ if( bin_flag )
+ {
+   leed_output_beam_list (&beams_out, beams_all, eng, NULL);
+   if( (ivbin = leed_output_bin_init(res_stream, beams_out, eng)) == NULL)
+     exit(1);
+ }
+ else
+ {
+   leed_out_head_2 (LEED_VERSION, LEED_NAME, res_stream);
+   leed_output_beam_list (&beams_out, beams_all, eng, res_stream);
+ }
 
 /*********************************************************************
  Prepare some often used parameters.
@@ -600,7 +632,10 @@ FILE *res_stream;
 
 /**** No scattering at pot. step ****/
     Amp = leed_ld_potstep0(Amp, R_tot, beams_now, v_par->eng_v, vec);
-    leed_output_iint_sym(Amp, beams_now, beams_out, v_par, res_stream);
+    if( bin_flag )
+      leed_output_bin_int(Amp, beams_now, beams_out, v_par, 1, ivbin);
+    else
+      leed_output_iint_sym(Amp, beams_now, beams_out, v_par, res_stream);
 
 /**Write cpu time to output**/
    sprintf(linebuffer,"  %.1f   %d  ",energy * HART,n_beams_now);
@@ -618,6 +653,7 @@ FILE *res_stream;
  if( (ctr_flag == FLAG_WRITE) || (ctr_flag == FLAG_READ) ) 
    fclose(pro_stream);
 
+ if( bin_flag ) leed_output_bin_close(ivbin);
  fclose(res_stream);
 
 #ifdef CONTROL
@@ -38,3 +38,35 @@ CS/21.9.93	allow nstep
      return(int_avg);
 }
 /************************************************************************/
+
+void b_smooth_series(float *cur, float *smo, int n, int width)
+
+/*************************************************************************
+LD/19.10.26
+  Smooth the beam currents cur[0..n-1] of a whole energy series (in
+  the order of the energy loop): centred, linearly weighted average
+      smo[i] = sum_j (width+1-|j|) * cur[i+j] / sum_j (width+1-|j|)
+  over |j| <= width (fewer values at both ends of the series). Unlike
+  b_smooth, a linear drift of the current is not delayed.
+*************************************************************************/
+
+{
+     int i, j;
+     float sum, w_sum, w;
+
+/************************************************************************/
+
+     for ( i=0; i<n; i++ )
+     {
+        sum = w_sum = 0.;
+        for ( j=-width; j<=width; j++ )
+        {
+           if ( i+j < 0 || i+j >= n ) continue;
+           w = (float)(width + 1 - (j < 0 ? -j : j));
+           sum += w * cur[i+j];
+           w_sum += w;
+        }
+        smo[i] = sum / w_sum;
+     }
+}
+/************************************************************************/
@@ -16,6 +16,7 @@ short calcbase(int naux, struct spot aux[], struct vector a[],
    SU/ 91
    GH/ 11.08.92
    CS/11.8.93
+   LD/19.10.26 size of dposh, dposv, dind1, dind2 (index 2 was out of bounds)
 
   Purpose:
    determination of origin and two basic vectors from at least 3 spots.
@@ -39,7 +40,7 @@ short calcbase(int naux, struct spot aux[], struct vector a[],
      register int i, j, k, ntrip;
      float det, x11, x12, x21, x22;          /* Matrix to invert */
      float cor_fac;
-     float dposh[2], dposv[2], dind1[2], dind2[2];
+     float dposh[3], dposv[3], dind1[3], dind2[3];  /* [1],[2] are used */
      static struct vector V_ZERO = { 0., 0., 0.};
 
 /***********************************************************************/
@@ -18,6 +18,7 @@ int calcoi(
 
 /***************************************************************************
   CS/9.8.93    
+  LD/19.10.26  spots in parallel (OpenMP)
 
  Purpose:
   calcoi.c recalculates the center of each spot using the
@@ -44,8 +45,12 @@ int calcoi(
 
 /**************************************************************************/
 
-/* loop over all apots in list spot */
+/* loop over all apots in list spot (independent of each other) */
 
+#ifdef _USE_OPENMP
+#pragma omp parallel for private(v, h, val, pos, hsum, vsum, valsum, v0, h0, \
+                                 lowh, high, lowv, higv) schedule(dynamic)
+#endif
    for( i=0; i<nspot; i++)
    {
       if( spot[i].control & SPOT_GOOD_S2N ) continue;
@@ -30,6 +30,7 @@ int calcspotpos(
    SU/ 29.04.91                                                         
    GH/ 20.08.92                                                         
    CS/ 3.8.93
+   LD/19.10.26  reset spot->range
 
   Purpose:
    calcspotpos calculates the positions of all reciprocal lattice points   
@@ -50,6 +51,7 @@ int calcspotpos(
      spot->lind1/2   lattex indices
      spot->x0,y0     calculated spot position
      spot->xx,yy     spot position that will be modified by fimax,calcoi
+     spot->range     0 (search within common range)
      spot->cos_th    cosine of k towards e-beam
    radius        calculated screen radius in pixels
 
@@ -125,6 +127,7 @@ int calcspotpos(
 
 	      spot[k].xx = spot[k].x0 = a[0].xx + rposx;
 	      spot[k].yy = spot[k].y0 = a[0].yy + rposy;
+	      spot[k].range = 0.;
 
 /* when spot-position is out of the visible LEED-screen area -> continue */
 
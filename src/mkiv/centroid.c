@@ -0,0 +1,231 @@
+/****************************************************************************
+LD/19.10.26
+
+File Name: centroid.c
+
+ Purpose:
+  Sub-pixel spot positions (mkiv -g). Alternatives to the centre of
+  gravity of calcoi, which includes the background within the disc and
+  is therefore biased towards the position found by fimax4:
+
+  CENT_COG    : centre of gravity (calcoi)
+  CENT_MOMENT : centre of gravity of the intensity above the background;
+                the background is the mean of the border of the disc and
+                the disc is re-centred on the result (CENT_ITER times)
+  CENT_GAUSS  : least squares fit of a 2D Gaussian to the intensity above
+                the background, starting from CENT_MOMENT:
+                  ln(I - bg) = c0 + c1*x + c2*y + c3*(x*x + y*y)
+                weighted by (I - bg)^2, using the pixels above CENT_CUT
+                times the maximum. Centre = -(c1,c2) / (2*c3).
+
+  All spots of a frame are fitted in parallel; the sums over each row of
+  the disc are contiguous runs of pixels (vectorisable).
+
+History:
+LD/19.10.26 - Creation.
+
+****************************************************************************/
+
+#include <stdio.h>
+#include <math.h>
+#include "mkiv.h"
+
+#define CENT_ITER   2           /* passes of the moment method            */
+#define CENT_CUT    0.05        /* pixels used by the Gaussian fit        */
+
+/***************************************************************************/
+
+static float disc_background(const unsigned short *im, int cols, int rows,
+                             int h0, int v0, int r)
+
+/* mean intensity of the pixels (r-1)^2 < d^2 <= r^2 around (h0,v0) */
+{
+    int v, h, lowh, high, lowv, higv, hw;
+    int r_in = (r-1)*(r-1), r_out = r*r, dv2;
+    long sum = 0, n = 0;
+
+    lowv = MAX(v0-r, 0);
+    higv = MIN(v0+r, rows-1);
+    for (v = lowv; v <= higv; v++)
+    {
+        dv2 = (v-v0)*(v-v0);
+        hw = (int)sqrt((double)(r_out - dv2));
+        lowh = MAX(h0-hw, 0);
+        high = MIN(h0+hw, cols-1);
+        for (h = lowh; h <= high; h++)
+        {
+            if ((h-h0)*(h-h0) + dv2 <= r_in) continue;
+            sum += im[v*cols + h];
+            n ++;
+        }
+    }
+    return (n > 0) ? (float)sum / n : 0.;
+}
+
+/***************************************************************************/
+
+static int solve4(double m[4][4], double b[4])
+
+/* solve m * x = b (Gaussian elimination, partial pivoting); x -> b */
+{
+    int i, j, k, p;
+    double f, t;
+
+    for (k = 0; k < 4; k++)
+    {
+        p = k;
+        for (i = k+1; i < 4; i++)
+            if (fabs(m[i][k]) > fabs(m[p][k])) p = i;
+        if (fabs(m[p][k]) < 1.e-12) return 0;
+        if (p != k)
+        {
+            for (j = 0; j < 4; j++) { t = m[k][j]; m[k][j] = m[p][j]; m[p][j] = t; }
+            t = b[k]; b[k] = b[p]; b[p] = t;
+        }
+        for (i = k+1; i < 4; i++)
+        {
+            f = m[i][k] / m[k][k];
+            for (j = k; j < 4; j++) m[i][j] -= f * m[k][j];
+            b[i] -= f * b[k];
+        }
+    }
+    for (k = 3; k >= 0; k--)
+    {
+        for (j = k+1; j < 4; j++) b[k] -= m[k][j] * b[j];
+        b[k] /= m[k][k];
+    }
+    return 1;
+}
+
+/***************************************************************************/
+
+int centroid(int nspot, Spot spot[], float range, ImageMatrix *image,
+             int method)
+
+/****************************************************************************
+ Recalculate the positions spot.xx/yy of all spots without SPOT_GOOD_S2N
+ within a disc (radius = range) around the position found by fimax4.
+ method: CENT_COG, CENT_MOMENT or CENT_GAUSS (see above).
+****************************************************************************/
+{
+    unsigned short *im = (unsigned short *)image->imagedata;
+    int cols = image->rows,
+        rows = image->cols;
+    int r = MAX((int)range, 2);
+    int i;
+
+/***************************************************************************/
+
+    if (method == CENT_COG) return calcoi(nspot, spot, range, image);
+
+#ifdef _USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (i = 0; i < nspot; i++)
+    {
+        int v, h, iter, lowh, high, lowv, higv, hw, h0, v0, dv;
+        float bg, xc, yc, w, w_max;
+        double sw, swx, swy, m[4][4], c[4], x, y, rr, lw, w2;
+        const unsigned short *im_row;
+
+        if (spot[i].control & SPOT_GOOD_S2N) continue;
+
+        h0 = (int)spot[i].xx;
+        v0 = (int)spot[i].yy;
+        if (h0 < 0 || h0 >= cols || v0 < 0 || v0 >= rows) continue;
+
+        bg = disc_background(im, cols, rows, h0, v0, r);
+
+        /* centre of gravity above background, disc re-centred */
+        xc = h0;
+        yc = v0;
+        w_max = 0.;
+        for (iter = 0; iter < CENT_ITER; iter++)
+        {
+            h0 = (int)(xc + 0.5);
+            v0 = (int)(yc + 0.5);
+            sw = swx = swy = 0.;
+            w_max = 0.;
+            lowv = MAX(v0-r, 0);
+            higv = MIN(v0+r, rows-1);
+            for (v = lowv; v <= higv; v++)
+            {
+                dv = v - v0;
+                hw = (int)sqrt((double)(r*r - dv*dv));
+                lowh = MAX(h0-hw, 0);
+                high = MIN(h0+hw, cols-1);
+                im_row = im + v*cols;
+#ifdef _USE_OPENMP
+#pragma omp simd private(w) reduction(+:sw, swx, swy) reduction(max:w_max)
+#endif
+                for (h = lowh; h <= high; h++)
+                {
+                    w = MAX(im_row[h] - bg, 0.f);
+                    sw += w;
+                    swx += w * (h - h0);
+                    swy += w * dv;
+                    w_max = MAX(w_max, w);
+                }
+            }
+            if (sw <= 0.) break;
+            xc = h0 + swx / sw;
+            yc = v0 + swy / sw;
+        }
+
+        if (method == CENT_GAUSS && w_max > 0.)
+        {
+            h0 = (int)(xc + 0.5);
+            v0 = (int)(yc + 0.5);
+            for (v = 0; v < 4; v++)
+            {
+                c[v] = 0.;
+                for (h = 0; h < 4; h++) m[v][h] = 0.;
+            }
+            lowv = MAX(v0-r, 0);
+            higv = MIN(v0+r, rows-1);
+            for (v = lowv; v <= higv; v++)
+            {
+                dv = v - v0;
+                hw = (int)sqrt((double)(r*r - dv*dv));
+                lowh = MAX(h0-hw, 0);
+                high = MIN(h0+hw, cols-1);
+                im_row = im + v*cols;
+                y = dv;
+                for (h = lowh; h <= high; h++)
+                {
+                    w = im_row[h] - bg;
+                    if (w <= CENT_CUT * w_max) continue;
+                    x = h - h0;
+                    rr = x*x + y*y;
+                    w2 = (double)w * w;
+                    lw = w2 * log(w);
+                    m[0][0] += w2;      m[0][1] += w2*x;    m[0][2] += w2*y;
+                    m[0][3] += w2*rr;   m[1][1] += w2*x*x;  m[1][2] += w2*x*y;
+                    m[1][3] += w2*x*rr; m[2][2] += w2*y*y;  m[2][3] += w2*y*rr;
+                    m[3][3] += w2*rr*rr;
+                    c[0] += lw;  c[1] += lw*x;  c[2] += lw*y;  c[3] += lw*rr;
+                }
+            }
+            m[1][0] = m[0][1]; m[2][0] = m[0][2]; m[3][0] = m[0][3];
+            m[2][1] = m[1][2]; m[3][1] = m[1][3]; m[3][2] = m[2][3];
+
+            /* use the fit only for a peak close to the moment result */
+            if (solve4(m, c) && c[3] < 0.)
+            {
+                x = h0 - c[1] / (2.*c[3]);
+                y = v0 - c[2] / (2.*c[3]);
+                if ((x-xc)*(x-xc) + (y-yc)*(y-yc) < 1.)
+                {
+                    xc = x;
+                    yc = y;
+                }
+            }
+        }
+
+        spot[i].xx = xc;
+        spot[i].yy = yc;
+    }
+
+    return 0;
+}
+/***************************************************************************/
@@ -8,6 +8,7 @@ GH/27.07.03
 CHANGES:
   CS /9.8.93
   GH/27.07.03 - circle colour = max_value
+  LD/19.10.26 - size of background ellipse: verh * MAX(h,v) (parentheses)
 ****************************************************************************/
 
 #include "mkiv.h"
@@ -60,7 +61,7 @@ float verh;                 ratio bg/integr. ellipses
     y_fac = PYTH2(sin(angle)/h,cos(angle)/v);
     xy_fac = sin(angle) * cos(angle) * ( 2./(h*h) - 2./(v*v) );
 
-    a_back = RND( verh * MAX(h,v) );
+    a_back = RND( verh * (MAX(h,v)) );
     for (j = -a_back; j <= a_back; j++) {
         for (i = -a_back; i <= a_back; i++) {
             ell = i*i*x_fac + j*j*y_fac + i*j*xy_fac;
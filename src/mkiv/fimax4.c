@@ -1,4 +1,3 @@
-
 /**************************************************************************
      
               File Name: fimax4.c
@@ -6,8 +5,20 @@
  **************************************************************************/
 
 /***************************************************************************/
+#include <stdlib.h>
 #include "mkiv.h"
 /***************************************************************************/
+
+/* half size of kernel */
+#define KL_H_SIZE 3
+
+/* box sum over rows r0..r1, cols c0..c1 of the integral image ii
+   (row length n_ii); unsigned arithmetic: exact modulo 2^32 */
+#define BOX(ii, n_ii, r0, c0, r1, c1)                                       \
+    ( (ii)[((r1)+1)*(n_ii) + (c1)+1] - (ii)[(r0)*(n_ii) + (c1)+1]             \
+    - (ii)[((r1)+1)*(n_ii) + (c0)]   + (ii)[(r0)*(n_ii) + (c0)] )
+
+/***************************************************************************/
  
 int fimax4(int nspot, Spot spot[], int step, float range, ImageMatrix *image)
 
@@ -16,10 +27,15 @@ int fimax4(int nspot, Spot spot[], int step, float range, ImageMatrix *image)
   GH/31.08.92  kernel method 
   CS/5.8.93    all positive kernel
   CS/20.8.93   
+  LD/19.10.26  spots in parallel (OpenMP)
+  LD/19.10.26  kernel sums from box sums of an integral image
+  LD/19.10.26  search radius of each spot (spot->range)
 
  Purpose:
   fimax4 scans for each spot through a disc (radius = range) searching for
   the maximum intensity.  A kernel is used, which is described below.
+  If spot->range is set (> 0) and smaller than range, it is used as
+  radius of the disc for this spot (see track.c).
   If spot->control -bit SPOT_GOOD_S2N is set, no max. search is performed.
 
  Output: 
@@ -31,50 +47,95 @@ int step;                       step size for maximum search
 float range;                    radius of search area in pixels  
 ImageMatrix *image;             pointer to the image structure
 
+ Kernel for the weighted integration [sum(kernel)=112]:
+
+          0, 1, 1, 1, 1, 1, 0
+          1, 1, 2, 2, 2, 1, 1
+          1, 2, 4, 8, 4, 2, 1
+          1, 2, 8,16, 8, 2, 1
+          1, 2, 4, 8, 4, 2, 1
+          1, 1, 2, 2, 2, 1, 1
+          0, 1, 1, 1, 1, 1, 0
+
+  The kernel is a sum of nested boxes:
+
+    kernel = B7 + B5 + 6*B3 + 8*C - (c7 + c5 + 4*c3)
+
+  Bn: n*n box of ones, cn: the four corners of Bn, C: the centre pixel.
+  For each spot the integral image of the search area is computed once;
+  each box sum then needs four values of the integral image instead of
+  49 multiplications. The kernel sums of a row of candidates are
+  computed first (vectorisable), the maximum is then searched in the
+  original order, i.e. the results are identical to the direct sum.
+
 ****************************************************************************/
 {
-    register int i, h, v,       /* auxiliaries */
-                 sum, adr0;   
-    int lowh, lowv, high, higv; /* horiz.and vert.boundaries of search area */
-    long max_sum;               /* integration sum, total maximum of all sum*/
-    float h0, v0;               /* calculated spot positions */
-
-    /* the kernel that serves for a weighted integration [sum(kernel)=112] */
-    int KL_H_SIZE = 3;          /*  half size of kernel */
-    int nkernel = 7*7;
-    int ad[7*7];
-    static long kernel[7*7] ={  0, 1, 1, 1, 1, 1, 0 ,
-                                1, 1, 2, 2, 2, 1, 1 ,
-                                1, 2, 4, 8, 4, 2, 1 ,
-                                1, 2, 8,16, 8, 2, 1 ,
-                                1, 2, 4, 8, 4, 2, 1 ,
-                                1, 1, 2, 2, 2, 1, 1 ,
-                                0, 1, 1, 1, 1, 1, 0 };      
-
-    register int k = 0, cols = image->rows;
+    int cols = image->rows;
     int rows = image->cols;
     unsigned short *im = (unsigned short *)image->imagedata;
+    int n_box;                  /* max. size of padded search area */
 
 /***************************************************************************/
-     
-    for (v = -KL_H_SIZE; v<= KL_H_SIZE; v++)
-        for (h = -KL_H_SIZE; h<= KL_H_SIZE; h++)
-            ad[k++] = v*cols + h;
 
+    n_box = 2*((int)range + 1) + 2*KL_H_SIZE + 2;
+
+#ifdef _USE_OPENMP
+#pragma omp parallel
+#endif
+    {
+    int i, h, v, k, n_h,        /* auxiliaries */
+        r, c, n_ii;   
+    int lowh, lowv, high, higv; /* horiz.and vert.boundaries of search area */
+    long max_sum;               /* integration sum, total maximum of all sum*/
+    float h0, v0;               /* calculated spot positions */
+    float r_spot;               /* search radius of spot */
+    unsigned int *ii;           /* integral image of search area */
+    unsigned int *row_sum;      /* kernel sums of a row of candidates */
+    unsigned int acc;
+    unsigned short *im_row;
+
+    ii = (unsigned int *)malloc( (n_box+1) * (n_box+1) * sizeof(unsigned int) );
+    row_sum = (unsigned int *)malloc( (n_box+1) * sizeof(unsigned int) );
+    if (ii == NULL || row_sum == NULL)
+        ERR_EXIT(fimax4 : memory allocation failed);
+
+    /* spots are independent */
+#ifdef _USE_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
     for (i=0; i<nspot; i++) {
         if( spot[i].control & SPOT_GOOD_S2N )
             continue;
 
         h0 = spot[i].xx;
         v0 = spot[i].yy;
+        r_spot = (spot[i].range > 0. && spot[i].range < range) ?
+                 spot[i].range : range;
 
         /* find boundaries */
 
-        lowh = MAX( (int)(h0-range) , KL_H_SIZE );
-        high = MIN( (int)(h0+range) , cols-KL_H_SIZE-1 );
-
-        lowv = MAX( (int)(v0-range) , KL_H_SIZE );
-        higv = MIN( (int)(v0+range) , rows-KL_H_SIZE-1 );
+        lowh = MAX( (int)(h0-r_spot) , KL_H_SIZE );
+        high = MIN( (int)(h0+r_spot) , cols-KL_H_SIZE-1 );
+
+        lowv = MAX( (int)(v0-r_spot) , KL_H_SIZE );
+        higv = MIN( (int)(v0+r_spot) , rows-KL_H_SIZE-1 );
+
+        if (lowh > high || lowv > higv) continue;
+
+        /* integral image of the search area including the kernel margin:
+           ii[r*n_ii + c] = sum of im over rows < r, cols < c (relative to
+           (lowv-KL_H_SIZE, lowh-KL_H_SIZE)) */
+        n_ii = high - lowh + 2*KL_H_SIZE + 2;
+        for (c = 0; c < n_ii; c++) ii[c] = 0;
+        for (r = 1; r <= higv - lowv + 2*KL_H_SIZE + 1; r++) {
+            im_row = im + (lowv - KL_H_SIZE + r - 1)*cols + lowh - KL_H_SIZE;
+            ii[r*n_ii] = 0;
+            acc = 0;
+            for (c = 1; c < n_ii; c++) {
+                acc += im_row[c-1];
+                ii[r*n_ii + c] = ii[(r-1)*n_ii + c] + acc;
+            }
+        }
 
         /* loop over searching area */
         /* v and h point to the center of the kernel = 
@@ -82,24 +143,53 @@ ImageMatrix *image;             pointer to the image structure
 
         max_sum = 0L;
         for (v = lowv; v <= higv; v+=step) {
-            for (h = lowh; h <= high; h+=step) {
-                if ( PYTH(v-v0,h-h0) > range ) 
-                    continue; /* spot out of range */
-                adr0 = v*cols +h;
-                sum = 0L;
-                for (k=0; k<nkernel; k++) 
-                    sum += kernel[k] *im[ adr0+ad[k] ];
+
+            /* kernel sums of all candidates in row v;
+               r, c: position of the kernel centre in the padded area */
+            r = v - lowv + KL_H_SIZE;
+            n_h = (high - lowh) / step + 1;
+#ifdef _USE_OPENMP
+#pragma omp simd private(c)
+#endif
+            for (k = 0; k < n_h; k++) {
+                c = k*step + KL_H_SIZE;
+                row_sum[k] =
+                      BOX(ii, n_ii, r-3, c-3, r+3, c+3)
+                    + BOX(ii, n_ii, r-2, c-2, r+2, c+2)
+                    + 6 * BOX(ii, n_ii, r-1, c-1, r+1, c+1)
+                    + 8 * BOX(ii, n_ii, r, c, r, c)
+                    - ( BOX(ii, n_ii, r-3, c-3, r-3, c-3) 
+                      + BOX(ii, n_ii, r-3, c+3, r-3, c+3)
+                      + BOX(ii, n_ii, r+3, c-3, r+3, c-3) 
+                      + BOX(ii, n_ii, r+3, c+3, r+3, c+3) )
+                    - ( BOX(ii, n_ii, r-2, c-2, r-2, c-2) 
+                      + BOX(ii, n_ii, r-2, c+2, r-2, c+2)
+                      + BOX(ii, n_ii, r+2, c-2, r+2, c-2) 
+                      + BOX(ii, n_ii, r+2, c+2, r+2, c+2) )
+                    - 4 * ( BOX(ii, n_ii, r-1, c-1, r-1, c-1) 
+                          + BOX(ii, n_ii, r-1, c+1, r-1, c+1)
+                          + BOX(ii, n_ii, r+1, c-1, r+1, c-1) 
+                          + BOX(ii, n_ii, r+1, c+1, r+1, c+1) );
+            }
+
+            for (k = 0, h = lowh; k < n_h; k++, h+=step) {
 
                 /* store coordinates when intensity is max */
 
-                if (sum>max_sum) {
+                if ((long)row_sum[k] > max_sum) {
+                    if ( PYTH(v-v0,h-h0) > r_spot ) 
+                        continue; /* spot out of range */
                     spot[i].yy = (float)v;
                     spot[i].xx = (float)h; 
-                    max_sum = sum;
+                    max_sum = (long)row_sum[k];
                 }
             }       /* for(h = ...) */
         }       /* for(v = ...) */
     }       /* for(i < nspot) */
+
+    free(ii);
+    free(row_sum);
+    }       /* parallel */
     
     return 0;
 }
@@ -8,6 +8,52 @@
 #include <stdlib.h>
 /***************************************************************************/
 
+static void sum_run(const unsigned short *im,   /* first pixel of run     */
+                    const unsigned short *mask, /* mask (NULL: no mask)   */
+                    int n,                      /* number of pixels       */
+                    long long sums[3])
+
+/****************************************************************************
+  Number of (unmasked) pixels, sum of intensities and sum of squared
+  intensities of a contiguous run of pixels: sums = (n, I, I^2).
+  The loops have no branches so that they can be vectorised.
+****************************************************************************/
+{
+    int i;
+    unsigned int val, wgt, cnt = 0;
+    unsigned long long sum = 0, sq = 0;
+
+    if (mask == NULL) {
+        cnt = n;
+#ifdef _USE_OPENMP
+#pragma omp simd private(val) reduction(+:sum, sq)
+#endif
+        for (i = 0; i < n; i++) {
+            val = im[i];
+            sum += val;
+            sq  += val * val;
+        }
+    }
+    else {
+#ifdef _USE_OPENMP
+#pragma omp simd private(val, wgt) reduction(+:cnt, sum, sq)
+#endif
+        for (i = 0; i < n; i++) {
+            wgt = (mask[i] != 0);
+            val = im[i] * wgt;
+            cnt += wgt;
+            sum += val;
+            sq  += val * val;
+        }
+    }
+
+    sums[0] = cnt;
+    sums[1] = (long long)sum;
+    sums[2] = (long long)sq;
+}
+
+/***************************************************************************/
+
 int get_int(int nspot,              /* number of spots */
             Spot spot[],            /* list of measurable reflexes */
             ImageMatrix *image,     /* matrix of image data */
@@ -25,6 +71,10 @@ int get_int(int nspot,              /* number of spots */
 /****************************************************************************
   GH /25.08.92
   CS /9.8.93
+  LD /19.10.26 spot-major integration over precomputed offset masks
+  LD /19.10.26 background area up to verh * max(h,v); it was clipped
+               to max(h,v) in y (or x) if verh * h <= v (MAX without
+               parentheses), which changes the background and intensities
 
  Purpose:
   getint serves to :
@@ -39,10 +89,12 @@ int get_int(int nspot,              /* number of spots */
 
 ****************************************************************************/
 {
-    register int i, j, k, val, pos;
-    int a_back;
+    register int i, j, k;
+    int a_back, n_width, row, i_lo, i_hi, base, n_pixel;
     int e_counter=0, *e_count;        /* no.of pixels within spot area      */
     int b_counter=0, *b_count;        /* no.of pixels within background area*/
+    int *e_lo, *e_hi, *b_lo, *b_hi;   /* spot/backgr. area in each row      */
+    long long e_sums[3], b_sums[3], e_tot[3], b_tot[3];
     float x_fac, y_fac, xy_fac, ellipse, b_norm;
     float sgma, sgmb;
     register int cols = image->rows,        /* define image size */
@@ -50,33 +102,38 @@ int get_int(int nspot,              /* number of spots */
     float h = scale->xx,
           v = scale->yy;
     unsigned short *im = (unsigned short *)image->imagedata;
-    unsigned short *mask = (unsigned short *)imask->imagedata;
+    unsigned short *mask = 
+        (imask != NULL) ? (unsigned short *)imask->imagedata : NULL;
 
 /***************************************************************************/
 
-    /* Allocate memory for e_count, b_count */
-    e_count = (int *)calloc( nspot, sizeof(int) );
-    b_count = (int *)calloc( nspot, sizeof(int) );
-    if ( e_count == NULL || b_count == NULL ) 
-        ERR_EXIT(getint : Memory allocation failed)
-
     /* Initialize */
     angle *= PI/180.;
     x_fac = PYTH2(cos(angle)/h,sin(angle)/v);
     y_fac = PYTH2(sin(angle)/h,cos(angle)/v);
     xy_fac = sin(angle) * cos(angle) * ( 2./(h*h) - 2./(v*v) );
 
-    for (k = 0; k < nspot; k++) { 
-        if ( spot[k].control & SPOT_GOOD_S2N ) continue;
-        spot[k].intensity = 0.;
-        spot[k].s2n = 0.;
-        spot[k].s2u = 0.;
-    }
+    a_back = RND( verh * (MAX(h,v)) );
+    n_width = 2*a_back + 1;
+    n_pixel = cols*rows;
+
+    /* Allocate memory */
+    e_count = (int *)calloc( nspot + 1, sizeof(int) );
+    b_count = (int *)calloc( nspot + 1, sizeof(int) );
+    e_lo = (int *)malloc( 4 * n_width * sizeof(int) );
+    if ( e_count == NULL || b_count == NULL || e_lo == NULL ) 
+        ERR_EXIT(getint : Memory allocation failed)
+    e_hi = e_lo + n_width;
+    b_lo = e_hi + n_width;
+    b_hi = b_lo + n_width;
 
 /****************************************************************************
 
-  Search for the points which lie inside the (rotated) ellipses around the 
-  spot maxima and sum up the intensities for each spot ( list spot ).
+  Find the points which lie inside the (rotated) ellipses around the 
+  spot maxima. The areas only depend on scale, angle and verh and are
+  therefore computed once for all spots: in each row j the spot area is
+  the interval e_lo..e_hi and the background area is the interval
+  b_lo..b_hi without e_lo..e_hi (both ellipses are convex).
 
   A point (x,y) being inside an ellipsis with half axes h and v is defined by 
   the following equation:
@@ -86,49 +143,85 @@ int get_int(int nspot,              /* number of spots */
                   y(new) = -x*sin(angle) + y*cos(angle) 
   The ellipsis equation (1) then transforms as:
                 x*x* x_fac + y*y* y_fac + x*y * xy_fac <= 1.  (3)
-  
-  spot.s2u is temporarily used as background.  
-  spot.s2n is temporarily used as SQUARE(background)
 
 ****************************************************************************/
 
-    /* loop over relative coordinates */
-    a_back = RND( verh * MAX(h,v) );
     for (j = -a_back; j <= a_back; j++) {
+        row = j + a_back;
+        e_lo[row] = b_lo[row] = a_back + 1;
+        e_hi[row] = b_hi[row] = -a_back - 1;
         for (i = -a_back; i <= a_back; i++) {
             /* equation (3) - see above */
             ellipse = (i*i* x_fac) + (j*j* y_fac) + (i*j* xy_fac);
             if (ellipse > SQUARE(verh)) continue;    /* outside */
-            if (ellipse <= 1.) e_counter++;
-            else               b_counter++;
-            
-            /* loop over spots */
-            for (k = 0; k < nspot; k++) {
-            
-                if( spot[k].control & SPOT_GOOD_S2N )
-                    continue; /*already done*/
-                    
-                pos =((int)spot[k].yy+j)*cols +(int)spot[k].xx+i;
-                
-                if ( pos < 0 || pos >= cols*rows )
-                    continue; /* out of frame */
-                    
-                if ( imask && !mask[pos] ) 
-                    continue; /* outside masked area */
-                val = im[ pos ];
-
-                if (ellipse>1.) {
-                    b_count[k]++;
-                    spot[k].s2u += val;
-                    spot[k].s2n += SQUARE(val); 
-                }
-                else {
-                    e_count[k]++;
-                    spot[k].intensity += val; 
-                }
+            if (ellipse <= 1.) {
+                e_counter++;
+                if (i < e_lo[row]) e_lo[row] = i;
+                if (i > e_hi[row]) e_hi[row] = i;
             }
-        }  
-     }   
+            else 
+                b_counter++;
+            if (i < b_lo[row]) b_lo[row] = i;
+            if (i > b_hi[row]) b_hi[row] = i;
+        }
+    }
+
+/****************************************************************************
+
+  Sum up the intensities for each spot: the spots are independent and
+  each spot is integrated row by row over contiguous runs of pixels.
+
+  spot.s2u is temporarily used as background.  
+  spot.s2n is temporarily used as SQUARE(background)
+
+****************************************************************************/
+
+#ifdef _USE_OPENMP
+#pragma omp parallel for private(i, j, row, i_lo, i_hi, base, \
+                                 e_sums, b_sums, e_tot, b_tot) schedule(dynamic)
+#endif
+    for (k = 0; k < nspot; k++) {
+
+        if( spot[k].control & SPOT_GOOD_S2N )
+            continue; /*already done*/
+
+        for (i = 0; i < 3; i++) e_tot[i] = b_tot[i] = 0;
+        for (j = -a_back; j <= a_back; j++) {
+            row = j + a_back;
+            base = ((int)spot[k].yy+j)*cols + (int)spot[k].xx;
+
+            /* whole area (pixels outside the frame are skipped) */
+            i_lo = MAX( b_lo[row], -base );
+            i_hi = MIN( b_hi[row], n_pixel - 1 - base );
+            if (i_lo > i_hi) continue;
+            sum_run(im + base + i_lo, 
+                    (mask != NULL) ? mask + base + i_lo : NULL,
+                    i_hi - i_lo + 1, b_sums);
+
+            /* spot area */
+            i_lo = MAX( e_lo[row], -base );
+            i_hi = MIN( e_hi[row], n_pixel - 1 - base );
+            if (i_lo <= i_hi) 
+                sum_run(im + base + i_lo, 
+                        (mask != NULL) ? mask + base + i_lo : NULL,
+                        i_hi - i_lo + 1, e_sums);
+            else
+                e_sums[0] = e_sums[1] = e_sums[2] = 0;
+
+            for (i = 0; i < 3; i++) {
+                e_tot[i] += e_sums[i];
+                b_tot[i] += b_sums[i] - e_sums[i];
+            }
+        }
+
+        e_count[k] = (int)e_tot[0];
+        b_count[k] = (int)b_tot[0];
+        spot[k].intensity = (float)e_tot[1];
+        spot[k].s2u = (float)b_tot[1];
+        spot[k].s2n = (float)b_tot[2];
+    }
+
+    free( e_lo );
 
     /* Normalize background.  Subtract background.  calculate s/n ratio */
 
@@ -0,0 +1,492 @@
+/****************************************************************************
+LD/19.10.26
+
+File Name: imgstack.c
+
+ Purpose:
+  Image stack: all LEED images of an energy loop in a single file of
+  16 bit pixels, which is mapped into memory. Frames are passed to mkiv
+  without reading, decoding or copying; the I/O is left to the page cache.
+
+  imgstack_convert : write the TIFF series fname(nstart..nstop) to a stack
+  imgstack_open    : map a stack file into memory
+  imgstack_frame   : point an ImageMatrix to frame numb of the stack
+  imgstack_close   : unmap the stack
+
+ File format (all values little endian):
+
+   offset  size
+      0      8   magic "MKIVSTK" + '\0'
+      8      4   version (1)
+     12      4   width  (pixels per row, ImageMatrix.rows)
+     16      4   height (number of rows, ImageMatrix.cols)
+     20      4   number of frames n_frame
+     24      4   bits per pixel (16)
+     28      4   offset of the first frame (multiple of STK_ALIGN)
+     32     32   reserved (0)
+     64  16*n_frame  frame table:
+                 int32 number (as in the file names of the TIFF series),
+                 float32 energy (eV), float32 beam current (0: unknown),
+                 uint32 reserved
+   then  width*height*2 bytes per frame in the order of the frame table.
+
+  The frames are mapped privately: mkiv draws the integration areas into
+  the image; the modified pages are private copies and the stack file is
+  never changed. Before a frame is passed again, these copies are
+  discarded.
+
+History:
+LD/19.10.26 - Creation.
+LD/19.10.26 - imgstack_open: check the header sizes before any allocation.
+
+****************************************************************************/
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mkiv.h"
+
+#if !defined(_WIN32)
+#define IMGSTACK_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#define STK_MAGIC       "MKIVSTK"
+#define STK_VERSION     1
+#define STK_HEAD_SIZE   64
+#define STK_ENTRY_SIZE  16
+#define STK_ALIGN       4096
+
+struct imgstack
+{
+    char fname[STRSZ];          /* name of stack file                     */
+    int width, height;          /* frame size                             */
+    int n_frame;                /* number of frames                       */
+    int depth;                  /* number of frames read ahead            */
+    int *numb;                  /* frame numbers                          */
+    float *energy;              /* energies                               */
+    float *current;             /* beam currents                          */
+    char *passed;               /* 1: frame has been passed to mkiv       */
+    int last;                   /* index of last frame passed             */
+    size_t n_frame_size;        /* bytes per frame                        */
+    size_t data_offset;         /* offset of first frame in file          */
+#ifdef IMGSTACK_MMAP
+    unsigned char *map;         /* mapped file                            */
+    size_t map_size;
+#else
+    FILE *fp;                   /* stack file                             */
+    unsigned short *buf;        /* frame buffer                           */
+#endif
+};
+
+/***************************************************************************/
+
+static void put_u32(unsigned char *p, unsigned long v)
+{
+    p[0] = (unsigned char)(v & 0xFF);
+    p[1] = (unsigned char)((v >> 8) & 0xFF);
+    p[2] = (unsigned char)((v >> 16) & 0xFF);
+    p[3] = (unsigned char)((v >> 24) & 0xFF);
+}
+
+static unsigned long get_u32(const unsigned char *p)
+{
+    return (unsigned long)p[0] | ((unsigned long)p[1] << 8) |
+           ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static void put_f32(unsigned char *p, float f)
+{
+    uint32 v;
+
+    memcpy(&v, &f, 4);
+    put_u32(p, v);
+}
+
+static float get_f32(const unsigned char *p)
+{
+    uint32 v = (uint32)get_u32(p);
+    float f;
+
+    memcpy(&f, &v, 4);
+    return f;
+}
+
+static int host_is_little_endian(void)
+{
+    unsigned short one = 1;
+
+    return *(unsigned char *)&one == 1;
+}
+
+/***************************************************************************/
+
+static float read_current(char *cur_path, float energy)
+
+/****************************************************************************
+ Beam current for energy from a file with lines "energy current"
+ (format of beam.raw). Return value: current, 0. if not found.
+****************************************************************************/
+{
+    FILE *fp;
+    char line[STRSZ];
+    float en, cur, result = 0.;
+
+    if (cur_path == NULL || cur_path[0] == '\0') return 0.;
+    if ((fp = fopen(cur_path, "r")) == NULL)
+    {
+        fprintf(stderr, "*** error (imgstack_convert): cannot open '%s'\n",
+                cur_path);
+        exit(1);
+    }
+    while (fgets(line, STRSZ, fp) != NULL)
+    {
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%f %f", &en, &cur) == 2 &&
+            fabs(en - energy) < 0.01)
+        {
+            result = cur;
+            break;
+        }
+    }
+    fclose(fp);
+    return result;
+}
+
+/***************************************************************************/
+
+int imgstack_convert(char *stack_path, char *fname, int nstart, int nstop,
+                     float e_step, char *cur_path)
+
+/****************************************************************************
+ Convert the TIFF images
+     for (numb = nstart; <numb within nstart..nstop>; numb += e_step)
+ (same sequence as in mkiv, file names from filename(fname, numb)) into
+ the image stack stack_path. The energy of each frame is numb (as in
+ mkiv); the beam currents are taken from cur_path (may be NULL).
+ Return value: number of frames written.
+****************************************************************************/
+{
+    FILE *fp;
+    tifvalues tif;
+    ImageMatrix mat;
+    char name[STRSZ];
+    unsigned char head[STK_HEAD_SIZE], entry[STK_ENTRY_SIZE];
+    int numb, n_frame, i_frame, width = 0, height = 0;
+    long data_offset;
+
+    if (!host_is_little_endian())
+        ERR_EXIT(imgstack_convert : big endian hosts are not supported);
+
+    n_frame = 0;
+    for (numb = nstart;
+        ((numb<=nstop)&&(e_step>0)) || ((numb>=nstop)&&(e_step<0));
+        numb+=e_step)
+        n_frame ++;
+
+    if (n_frame == 0) ERR_EXIT(imgstack_convert : no images in energy loop);
+
+    if ((fp = fopen(stack_path, "wb")) == NULL)
+    {
+        fprintf(stderr, "*** error (imgstack_convert): cannot open '%s'\n",
+                stack_path);
+        exit(1);
+    }
+
+    data_offset = STK_HEAD_SIZE + STK_ENTRY_SIZE * n_frame;
+    data_offset = (data_offset + STK_ALIGN - 1) / STK_ALIGN * STK_ALIGN;
+
+    /* frame table */
+    memset(entry, 0, STK_ENTRY_SIZE);
+    fseek(fp, STK_HEAD_SIZE, SEEK_SET);
+    for (numb = nstart;
+        ((numb<=nstop)&&(e_step>0)) || ((numb>=nstop)&&(e_step<0));
+        numb+=e_step)
+    {
+        put_u32(entry, (uint32)numb);
+        put_f32(entry + 4, (float)numb);
+        put_f32(entry + 8, read_current(cur_path, (float)numb));
+        fwrite(entry, 1, STK_ENTRY_SIZE, fp);
+    }
+
+    /* frames; readtif stores 32 bit TIFF fields in unsigned long */
+    memset(&tif, 0, sizeof(tif));
+    mat.imagedata = NULL;
+    strncpy(name, fname, STRSZ-1);
+    name[STRSZ-1] = '\0';
+    fseek(fp, data_offset, SEEK_SET);
+    i_frame = 0;
+    for (numb = nstart;
+        ((numb<=nstop)&&(e_step>0)) || ((numb>=nstop)&&(e_step<0));
+        numb+=e_step)
+    {
+        readtif(&tif, filename(name, numb));
+        conv_tif2mat(&tif, &mat);
+        if (i_frame == 0)
+        {
+            width = mat.rows;
+            height = mat.cols;
+        }
+        else if ((int)mat.rows != width || (int)mat.cols != height)
+        {
+            fprintf(stderr, "*** error (imgstack_convert): '%s' has size "
+                    "%dx%d (expected %dx%d)\n", name, (int)mat.rows,
+                    (int)mat.cols, width, height);
+            exit(1);
+        }
+        if (fwrite(mat.imagedata, sizeof(unsigned short),
+                   (size_t)width * height, fp) != (size_t)width * height)
+            ERR_EXIT(imgstack_convert : write failed);
+        i_frame ++;
+    }
+    free(tif.buf);
+    free(mat.imagedata);
+
+    /* header */
+    memset(head, 0, STK_HEAD_SIZE);
+    memcpy(head, STK_MAGIC, strlen(STK_MAGIC) + 1);
+    put_u32(head + 8, STK_VERSION);
+    put_u32(head + 12, (uint32)width);
+    put_u32(head + 16, (uint32)height);
+    put_u32(head + 20, (uint32)n_frame);
+    put_u32(head + 24, 16);
+    put_u32(head + 28, (uint32)data_offset);
+    fseek(fp, 0L, SEEK_SET);
+    fwrite(head, 1, STK_HEAD_SIZE, fp);
+
+    if (fclose(fp) != 0) ERR_EXIT(imgstack_convert : write failed);
+
+    return n_frame;
+}
+
+/***************************************************************************/
+
+struct imgstack *imgstack_open(char *stack_path, int depth)
+
+/****************************************************************************
+ Map the image stack stack_path into memory; depth frames after the
+ current one are read ahead by the kernel.
+ Return value: pointer to the stack structure (exit on error).
+****************************************************************************/
+{
+    struct imgstack *st;
+    unsigned char head[STK_HEAD_SIZE], *table;
+    unsigned long width, height, n_frame;
+    size_t n_table, n_frame_size, data_offset, file_size;
+    FILE *fp;
+    int i;
+
+    if (!host_is_little_endian())
+        ERR_EXIT(imgstack_open : big endian hosts are not supported);
+
+    st = (struct imgstack *)calloc(1, sizeof(struct imgstack));
+    if (st == NULL) ERR_EXIT(imgstack_open : memory allocation failed);
+    strncpy(st->fname, stack_path, STRSZ-1);
+
+    if ((fp = fopen(stack_path, "rb")) == NULL)
+    {
+        fprintf(stderr, "*** error (imgstack_open): cannot open '%s'\n",
+                stack_path);
+        exit(1);
+    }
+
+    if (fread(head, 1, STK_HEAD_SIZE, fp) != STK_HEAD_SIZE ||
+        memcmp(head, STK_MAGIC, strlen(STK_MAGIC) + 1) != 0 ||
+        get_u32(head + 8) != STK_VERSION || get_u32(head + 24) != 16)
+    {
+        fprintf(stderr, "*** error (imgstack_open): '%s' is not an image "
+                "stack (version %d)\n", stack_path, STK_VERSION);
+        exit(1);
+    }
+
+    /* header values: sizes in size_t, checked before any allocation */
+    width = get_u32(head + 12);
+    height = get_u32(head + 16);
+    n_frame = get_u32(head + 20);
+    fseek(fp, 0L, SEEK_END);
+    file_size = (size_t)ftell(fp);
+    if (width == 0 || width > INT_MAX || height == 0 || height > INT_MAX ||
+        n_frame == 0 || n_frame > INT_MAX ||
+        (size_t)height > SIZE_MAX / sizeof(unsigned short) / width ||
+        (size_t)n_frame > (SIZE_MAX - STK_HEAD_SIZE) / STK_ENTRY_SIZE)
+    {
+        fprintf(stderr, "*** error (imgstack_open): '%s' has an invalid "
+                "header (%lu x %lu pixels, %lu frames)\n", stack_path,
+                width, height, n_frame);
+        exit(1);
+    }
+    n_frame_size = (size_t)width * height * sizeof(unsigned short);
+    n_table = (size_t)n_frame * STK_ENTRY_SIZE;
+    data_offset = get_u32(head + 28);
+    if (data_offset < STK_HEAD_SIZE + n_table || data_offset > file_size ||
+        (size_t)n_frame > (file_size - data_offset) / n_frame_size)
+    {
+        fprintf(stderr, "*** error (imgstack_open): '%s' is truncated\n",
+                stack_path);
+        exit(1);
+    }
+
+    st->width = (int)width;
+    st->height = (int)height;
+    st->n_frame = (int)n_frame;
+    st->data_offset = data_offset;
+    st->n_frame_size = n_frame_size;
+    st->depth = MAX(depth, 0);
+    st->last = -1;
+
+    /* frame table */
+    table = (unsigned char *)malloc(n_table + 1);
+    st->numb = (int *)malloc((n_frame + 1) * sizeof(int));
+    st->energy = (float *)malloc((n_frame + 1) * sizeof(float));
+    st->current = (float *)malloc((n_frame + 1) * sizeof(float));
+    st->passed = (char *)calloc(n_frame + 1, sizeof(char));
+    if (table == NULL || st->numb == NULL || st->energy == NULL ||
+        st->current == NULL || st->passed == NULL)
+        ERR_EXIT(imgstack_open : memory allocation failed);
+
+    fseek(fp, STK_HEAD_SIZE, SEEK_SET);
+    if (fread(table, 1, n_table, fp) != n_table)
+    {
+        fprintf(stderr, "*** error (imgstack_open): '%s' is truncated\n",
+                stack_path);
+        exit(1);
+    }
+
+    for (i = 0; i < st->n_frame; i++)
+    {
+        st->numb[i] = (int)(int32)get_u32(table + i*STK_ENTRY_SIZE);
+        st->energy[i] = get_f32(table + i*STK_ENTRY_SIZE + 4);
+        st->current[i] = get_f32(table + i*STK_ENTRY_SIZE + 8);
+    }
+    free(table);
+
+#ifdef IMGSTACK_MMAP
+    fclose(fp);
+
+    st->map_size = st->data_offset + st->n_frame * st->n_frame_size;
+    i = open(stack_path, O_RDONLY);
+    if (i != -1)
+    {
+        st->map = (unsigned char *)mmap(NULL, st->map_size,
+                                        PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                                        i, 0);
+        close(i);
+    }
+    if (i == -1 || st->map == MAP_FAILED)
+    {
+        fprintf(stderr, "*** error (imgstack_open): cannot map '%s'\n",
+                stack_path);
+        exit(1);
+    }
+
+    /* frames are mostly read in order */
+    madvise(st->map, st->map_size, MADV_SEQUENTIAL);
+#else
+    st->fp = fp;
+    st->buf = (unsigned short *)malloc(st->n_frame_size);
+    if (st->buf == NULL) ERR_EXIT(imgstack_open : memory allocation failed);
+#endif
+
+    fprintf(stdout, "(imgstack_open): %s: %d frames of %dx%d pixels\n",
+            stack_path, st->n_frame, st->width, st->height);
+
+    return st;
+}
+
+/***************************************************************************/
+
+#ifdef IMGSTACK_MMAP
+static void frame_advise(struct imgstack *st, int i_frame, int advice)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start, stop;
+
+    if (i_frame < 0 || i_frame >= st->n_frame) return;
+
+    /* madvise works on whole pages; the neighbouring frames are either
+       not in use or unchanged */
+    start = st->data_offset + i_frame * st->n_frame_size;
+    stop = MIN(start + st->n_frame_size + page - 1, st->map_size);
+    start -= start % page;
+    madvise(st->map + start, stop - start, advice);
+}
+#endif
+
+/***************************************************************************/
+
+int imgstack_frame(struct imgstack *st, int numb, ImageMatrix *mat_image,
+                   float *energy, float *current)
+
+/****************************************************************************
+ Set mat_image to frame numb of the stack: mat_image->imagedata points
+ into the stack and must not be freed. The image may be modified; the
+ changes are discarded when the same frame is requested again.
+ energy and current (may be NULL) are set from the frame table.
+ Return value: 0 if the frame was found, -1 otherwise.
+****************************************************************************/
+{
+    int i_frame, i;
+
+    for (i_frame = 0;
+         i_frame < st->n_frame && st->numb[i_frame] != numb; i_frame++)
+        ;
+    if (i_frame == st->n_frame) return -1;
+
+#ifdef IMGSTACK_MMAP
+    /* release the previous frame (private copies of drawn pages) and
+       restore the original data of a frame that is passed again */
+    if (st->last != i_frame) frame_advise(st, st->last, MADV_DONTNEED);
+    if (st->passed[i_frame]) frame_advise(st, i_frame, MADV_DONTNEED);
+
+    for (i = 1; i <= st->depth; i++)
+        frame_advise(st, i_frame + i, MADV_WILLNEED);
+
+    mat_image->imagedata =
+        (uint32 *)(st->map + st->data_offset + i_frame * st->n_frame_size);
+#else
+    (void)i;
+    fseek(st->fp, (long)(st->data_offset + i_frame * st->n_frame_size),
+          SEEK_SET);
+    if (fread(st->buf, 1, st->n_frame_size, st->fp) != st->n_frame_size)
+    {
+        fprintf(stderr, "*** error (imgstack_frame): cannot read frame %d "
+                "from '%s'\n", numb, st->fname);
+        exit(1);
+    }
+    mat_image->imagedata = (uint32 *)st->buf;
+#endif
+
+    mat_image->rows = st->width;
+    mat_image->cols = st->height;
+    st->passed[i_frame] = 1;
+    st->last = i_frame;
+
+    if (energy != NULL) *energy = st->energy[i_frame];
+    if (current != NULL) *current = st->current[i_frame];
+
+    return 0;
+}
+
+/***************************************************************************/
+
+void imgstack_close(struct imgstack *st)
+{
+    if (st == NULL) return;
+
+#ifdef IMGSTACK_MMAP
+    munmap(st->map, st->map_size);
+#else
+    fclose(st->fp);
+    free(st->buf);
+#endif
+    free(st->numb);
+    free(st->energy);
+    free(st->current);
+    free(st->passed);
+    free(st);
+}
+/***************************************************************************/
@@ -0,0 +1,261 @@
+/****************************************************************************
+LD/19.10.26
+
+File Name: ivwrite.c
+
+ Purpose:
+  Write the results of the energy loop (mkiv.ivdat, beam.raw, beam.smo)
+  in a separate thread. The intensities and beam currents of an accepted
+  frame are copied into a ring of result buffers; the writing thread
+  formats them in the order of the energy loop, i.e. the main loop never
+  waits for stdio (unless the ring is full).
+
+  ivwrite_open  : open the output files, write the ivdat header
+  ivwrite_frame : queue the results of one frame
+  ivwrite_close : write the remaining frames and close the files
+
+  Only the three output files are flushed (every UPDATE frames), not all
+  streams of the process. If threads are not available, the frames are
+  written directly.
+
+History:
+LD/19.10.26 - Creation.
+
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mkiv.h"
+
+#if !defined(_WIN32)
+#define IVWRITE_THREAD
+#include <pthread.h>
+#endif
+
+#define IVWRITE_SLOTS   16      /* number of frames in the ring           */
+
+struct ivwrite
+{
+    FILE *iv_stream;            /* mkiv.ivdat                             */
+    FILE *cur_stream;           /* beam.raw                               */
+    FILE *smcur_stream;         /* beam.smo                               */
+    int ndesi;                  /* number of intensities per frame        */
+    int n_slot;                 /* size of ring                           */
+    float *slot;                /* energy, currents, intensities of frame */
+    int *slot_flush;            /* 1: flush files after frame             */
+    long n_put;                 /* frames queued by the energy loop       */
+    long n_done;                /* frames written                         */
+    int threaded;               /* 1: writing thread is running           */
+    int stop;                   /* request to stop the writing thread     */
+#ifdef IVWRITE_THREAD
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+};
+
+/***************************************************************************/
+
+static FILE *open_file(char *path)
+{
+    FILE *fp;
+    char msg[STRSZ + 64];
+
+    if ((fp = fopen(path, "w")) == NULL)
+    {
+        sprintf(msg, "(ivwrite_open): '%s' open failed!", path);
+        ERR_EXIT(msg);
+    }
+    return fp;
+}
+
+/***************************************************************************/
+
+static void write_frame(struct ivwrite *iw, const float *val, int flush)
+
+/* val = energy, raw current, smoothed current, ndesi intensities */
+{
+    int i;
+
+    fprintf(iw->cur_stream, "%f\t%f\n", val[0], val[1]);
+    fprintf(iw->smcur_stream, "%f\t%f\n", val[0], val[2]);
+    fprintf(iw->iv_stream, "%6.1f", val[0]);
+    for (i = 0; i < iw->ndesi; i++)
+        fprintf(iw->iv_stream, " %10.5f", val[3 + i]);
+    fprintf(iw->iv_stream, "\n");
+
+    if (flush)
+    {
+        fflush(iw->iv_stream);
+        fflush(iw->cur_stream);
+        fflush(iw->smcur_stream);
+    }
+}
+
+/***************************************************************************/
+
+#ifdef IVWRITE_THREAD
+static void *ivwrite_thread(void *arg)
+{
+    struct ivwrite *iw = (struct ivwrite *)arg;
+    int i_slot;
+
+    pthread_mutex_lock(&iw->lock);
+    for (;;)
+    {
+        while (!iw->stop && iw->n_done == iw->n_put)
+            pthread_cond_wait(&iw->cond, &iw->lock);
+        if (iw->n_done == iw->n_put) break;     /* stop and ring empty */
+
+        /* slot i_slot is not changed until n_done is incremented */
+        i_slot = (int)(iw->n_done % iw->n_slot);
+        pthread_mutex_unlock(&iw->lock);
+
+        write_frame(iw, iw->slot + (size_t)i_slot * (iw->ndesi + 3),
+                    iw->slot_flush[i_slot]);
+
+        pthread_mutex_lock(&iw->lock);
+        iw->n_done ++;
+        pthread_cond_broadcast(&iw->cond);
+    }
+    pthread_mutex_unlock(&iw->lock);
+
+    return NULL;
+}
+#endif
+
+/***************************************************************************/
+
+struct ivwrite *ivwrite_open(char *iv_path, char *cur_path, char *smcur_path,
+                             int ndesi, struct lindex desi[])
+
+/****************************************************************************
+ Open the output files and write the header of the ivdat file (indices
+ of the ndesi desired spots).
+ Return value: pointer to the writer (never NULL).
+****************************************************************************/
+{
+    struct ivwrite *iw;
+    int i;
+
+    iw = (struct ivwrite *)calloc(1, sizeof(struct ivwrite));
+    if (iw == NULL) ERR_EXIT((ivwrite_open): memory allocation failed);
+
+    iw->iv_stream = open_file(iv_path);
+    iw->cur_stream = open_file(cur_path);
+    iw->smcur_stream = open_file(smcur_path);
+
+    /* list header */
+    fprintf(iw->iv_stream," h     ");
+    for ( i=0; i<ndesi; i++)
+        fprintf(iw->iv_stream, "%10.2f", desi[i].lind1);
+    fprintf(iw->iv_stream, "\n k     ");
+    for ( i=0; i<ndesi; i++)
+        fprintf(iw->iv_stream, "%10.2f", desi[i].lind2);
+    fprintf(iw->iv_stream, "\n nenergy\n");
+
+    iw->ndesi = ndesi;
+    iw->n_slot = IVWRITE_SLOTS;
+    iw->slot = (float *)malloc((size_t)iw->n_slot * (ndesi + 3) * sizeof(float));
+    iw->slot_flush = (int *)calloc(iw->n_slot, sizeof(int));
+    if (iw->slot == NULL || iw->slot_flush == NULL)
+        ERR_EXIT((ivwrite_open): memory allocation failed);
+
+#ifdef IVWRITE_THREAD
+    pthread_mutex_init(&iw->lock, NULL);
+    pthread_cond_init(&iw->cond, NULL);
+    if (pthread_create(&iw->thread, NULL, ivwrite_thread, iw) == 0)
+        iw->threaded = 1;
+    else
+    {
+        fprintf(stderr, "* warning (ivwrite_open): cannot start thread,"
+                " output is written directly\n");
+        pthread_mutex_destroy(&iw->lock);
+        pthread_cond_destroy(&iw->cond);
+    }
+#endif
+
+    return iw;
+}
+
+/***************************************************************************/
+
+void ivwrite_frame(struct ivwrite *iw, float energy, float cur, float smcur,
+                   float inty[], int flush)
+
+/****************************************************************************
+ Queue the results of an accepted frame: energy, raw and smoothed beam
+ current and the intensities of the desired spots (INT_OUT if not
+ measured). If flush is set, the files are flushed after this frame.
+****************************************************************************/
+{
+    float *val;
+    int i_slot;
+
+#ifdef IVWRITE_THREAD
+    if (iw->threaded)
+    {
+        pthread_mutex_lock(&iw->lock);
+        while (iw->n_put - iw->n_done >= iw->n_slot)
+            pthread_cond_wait(&iw->cond, &iw->lock);
+        pthread_mutex_unlock(&iw->lock);
+    }
+#endif
+
+    /* the slot is free: only this thread changes n_put */
+    i_slot = (int)(iw->n_put % iw->n_slot);
+    val = iw->slot + (size_t)i_slot * (iw->ndesi + 3);
+    val[0] = energy;
+    val[1] = cur;
+    val[2] = smcur;
+    memcpy(val + 3, inty, iw->ndesi * sizeof(float));
+    iw->slot_flush[i_slot] = flush;
+
+#ifdef IVWRITE_THREAD
+    if (iw->threaded)
+    {
+        pthread_mutex_lock(&iw->lock);
+        iw->n_put ++;
+        pthread_cond_broadcast(&iw->cond);
+        pthread_mutex_unlock(&iw->lock);
+        return;
+    }
+#endif
+
+    write_frame(iw, val, flush);
+    iw->n_put ++;
+    iw->n_done ++;
+}
+
+/***************************************************************************/
+
+void ivwrite_close(struct ivwrite *iw)
+
+/****************************************************************************
+ Write all queued frames and close the output files.
+****************************************************************************/
+{
+    if (iw == NULL) return;
+
+#ifdef IVWRITE_THREAD
+    if (iw->threaded)
+    {
+        pthread_mutex_lock(&iw->lock);
+        iw->stop = 1;
+        pthread_cond_broadcast(&iw->cond);
+        pthread_mutex_unlock(&iw->lock);
+        pthread_join(iw->thread, NULL);
+        pthread_mutex_destroy(&iw->lock);
+        pthread_cond_destroy(&iw->cond);
+    }
+#endif
+
+    fclose(iw->iv_stream);
+    fclose(iw->cur_stream);
+    fclose(iw->smcur_stream);
+    free(iw->slot);
+    free(iw->slot_flush);
+    free(iw);
+}
+/***************************************************************************/
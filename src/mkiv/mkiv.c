@@ -35,6 +35,7 @@ CS/23.8.93
 VJ/28.01.03
 GH/11.03.03
 LD/28.02.14
+LD/19.10.26
 
  Purpose:
   subtest evaluates LEED-images
@@ -45,6 +46,14 @@ LD/28.02.14
   -B --beam         : followed by the prefix for .raw and .smo files [default='beam']
   -c --change-input : allow changes of mkiv.inp and mkiv.var
   -h --help         : print the IV_READ_ME help file
+  -k --prefetch     : number of LEED images read ahead [default=2]
+  -S --stack        : read the LEED images from an image stack file
+  -t --track        : track spot positions, search radius for each spot
+  -g --centroid     : spot positions: cog, moment or gauss [default=cog]
+  --png             : also write annotated images as PNG, downsampled by n
+  --two-pass        : normalise to the (smoothed) beam current after the loop
+  --make-stack      : convert the LEED images into an image stack and exit
+  --stack-current   : beam currents (energy, current) for --make-stack
   -m --mask         : path to mask file [default='mkiv.byte']
   -M --make-mask    : produce mask and save to file [default='mask.byte']
   -o --output       : output file path [default='mkiv.ivdat']
@@ -100,6 +109,25 @@ char *argv[];
     int n_show;                    /* process images                       */
     int n_show_2;                  /* show image after each n_show_2 images*/
     int repetitions;		       /* number of repetitions of frame       */
+    int n_prefetch;                /* number of images read ahead          */
+    struct prefetch *prefetch;     /* images of the energy loop            */
+    struct imgstack *stack;        /* image stack (NULL: TIFF images)      */
+    char stackname[STRSZ],         /* image stack to be read               */
+         stack_out[STRSZ],         /* image stack to be written            */
+         stack_cur[STRSZ];         /* beam currents for image stack        */
+    float stack_energy = 0., stack_current = 0.;
+    int ref_in_stack;              /* reference image is read from stack   */
+    struct track *track;           /* spot tracking (NULL: not used)       */
+    struct ivwrite *ivwrite;       /* writer of the output files           */
+    struct overlay *overlay;       /* drawing of the annotated images      */
+    int png_step;                  /* downsampling of PNG (0: no PNG)      */
+    int two_pass;                  /* normalise after the energy loop      */
+    float *series;                 /* two_pass: energy, current, raw int.  */
+    float *ser_cur, *ser_smo;      /* two_pass: raw and smoothed currents  */
+    int n_series, max_series;
+    int use_track, n_tracked;
+    int cent_method;               /* method for spot positions (centroid) */
+    char cent_name[STRSZ];
 
     char *linebuffer;
 
@@ -161,7 +189,7 @@ char *argv[];
     float bas_rat;
 
 /* auxiliaries */
-    int i, k, nnref; 
+    int i, j, k, nnref; 
     int flag, save_intermediates, make_mask;
 
 /* inputs from command line: */
@@ -178,14 +206,23 @@ char *argv[];
     char *fname_beam_raw = (char*)malloc(sizeof(char)*FILENAME_MAX);
     char *fname_beam_smo = (char*)malloc(sizeof(char)*FILENAME_MAX);
     char *dummy = (char*)malloc(sizeof(char)*FILENAME_MAX); 
+    dummy[0] = '\0';
     
 /* open statements */
-    FILE *cur_stream, *smcur_stream, *iv_stream;
 
 /***************************************************************************/
 
     fname[0] = '\0';
     maskname[0] = '\0';
+    stackname[0] = stack_out[0] = stack_cur[0] = '\0';
+    stack = NULL;
+    track = NULL;
+    use_track = 0;
+    cent_method = CENT_COG;
+    png_step = 0;
+    two_pass = 0;
+    series = NULL;
+    n_series = max_series = 0;
 
 /***************************************************************************
    MAIN BEFORE ENERGY - LOOP
@@ -208,6 +245,7 @@ char *argv[];
 /* preset variables */
     verb = flag = save_intermediates = repetitions = make_mask = 0;
     n_show = n_show_2 = 1;
+    n_prefetch = 2;
 
 /* Allocate memory for mat/tif_image and mat/tif_mask */
 
@@ -266,6 +304,38 @@ char *argv[];
                             
                 }
             }
+            else if (ARG_IS("-k") || ARG_IS("--prefetch")) {
+                INT_ARG(n_prefetch);
+            }
+            else if (ARG_IS("-S") || ARG_IS("--stack")) {
+                STRCPY_ARG(stackname);
+            }
+            else if (ARG_IS("-t") || ARG_IS("--track")) {
+                use_track = 1;
+            }
+            else if (ARG_IS("-g") || ARG_IS("--centroid")) {
+                STRCPY_ARG(cent_name);
+                if (!strcmp(cent_name, "cog")) cent_method = CENT_COG;
+                else if (!strcmp(cent_name, "moment")) cent_method = CENT_MOMENT;
+                else if (!strcmp(cent_name, "gauss")) cent_method = CENT_GAUSS;
+                else {
+                    fprintf(stderr, "***error (mkiv_main): "
+                            "unknown centroid method '%s'\n", cent_name);
+                    exit(-1);
+                }
+            }
+            else if (ARG_IS("--two-pass")) {
+                two_pass = 1;
+            }
+            else if (ARG_IS("--png")) {
+                INT_ARG(png_step);
+            }
+            else if (ARG_IS("--make-stack")) {
+                STRCPY_ARG(stack_out);
+            }
+            else if (ARG_IS("--stack-current")) {
+                STRCPY_ARG(stack_cur);
+            }
             else if (ARG_IS("-s") || ARG_IS("--save-images")) {
                 /* save processed images ('ima.byte' */
                 save_intermediates = 1;
@@ -344,6 +414,14 @@ char *argv[];
         &ratio
         );
 
+/* Only convert the LEED images of the energy loop into an image stack */
+    if (stack_out[0] != '\0')
+    {
+        i = imgstack_convert(stack_out, fname, nstart, nstop, e_step, stack_cur);
+        fprintf(stdout, "%d images written to image stack '%s'\n", i, stack_out);
+        exit(0);
+    }
+
 /* Read mask, if existing, else use router,rinner for masking */
     if(maskname[0] == '\0' && file_exists(maskname))
     {
@@ -356,13 +434,24 @@ char *argv[];
     }
 
 
-/* Read image */
-    readtif(tif_image, fname);
+/* Read image: from the image stack, if it contains the reference image
+   (the number is the extension of the name), else from the TIFF file */
+    if (stackname[0] != '\0') stack = imgstack_open(stackname, n_prefetch);
+
+    if (stack != NULL && strrchr(fname, '.') != NULL &&
+        imgstack_frame(stack, atoi(strrchr(fname, '.') + 1), mat_image, 
+                       NULL, NULL) == 0)
+        ref_in_stack = 1;
+    else
+    {
+        ref_in_stack = 0;
+        readtif(tif_image, fname);
 
 /* Convert TIFF image (tifvalues) into a matrix (ImageMatrix) so that 
    MKIV is able to process them 
 */
-    conv_tif2mat(tif_image, mat_image);
+        conv_tif2mat(tif_image, mat_image);
+    }
     
     if (save_intermediates) 
     {
@@ -461,33 +550,17 @@ char *argv[];
      ENERGY - LOOP 
 *************************************************************************/
 
-/* Open files "mkiv.ivdat", "beam_raw" and "beam_smo" */
-
-    char *msg = (char *)malloc(512);
-    
-
+/* Open files "mkiv.ivdat", "beam_raw" and "beam_smo" (written by a
+   separate thread) and make list header */
     fprintf(stderr,"Open output files\n");
+    ivwrite = ivwrite_open(fname_mkiv_dat, fname_beam_raw, fname_beam_smo,
+                           ndesi, desi);
 
-    iv_stream = fopen(fname_mkiv_dat, "w");
-    sprintf(msg, "(mkiv_main): '%s' open failed!", fname_mkiv_dat);
-    if (iv_stream == NULL) ERR_EXIT(msg);
-    
-    cur_stream = fopen(fname_beam_raw, "w");
-    sprintf(msg, "(mkiv_main): '%s' open failed!", fname_beam_raw);
-    if (cur_stream == NULL) ERR_EXIT(msg);
-    
-    smcur_stream = fopen(fname_beam_smo, "w");
-    sprintf(msg, "(mkiv_main): '%s' open failed!", fname_beam_smo);
-    if (smcur_stream == NULL) ERR_EXIT(msg);
- 
-/* Make list header */
-    fprintf(iv_stream," h     ");
-    for ( i=0; i<ndesi; i++) 
-        fprintf(iv_stream, "%10.2f", desi[i].lind1);
-    fprintf(iv_stream, "\n k     ");
-    for ( i=0; i<ndesi; i++) 
-        fprintf(iv_stream, "%10.2f", desi[i].lind2);
-    fprintf(iv_stream, "\n nenergy\n");
+/* The annotated images are drawn into copies of the frames by a separate 
+   thread (mark_reflex writes to ima.byte unless another name is given) */
+    if (dummy[0] == '\0') strcpy(dummy, "ima.byte");
+    overlay = overlay_open(fname_mkiv_ima, dummy, png_step,
+                           mat_mask, &center, router, rinner);
 
 /* Loop for data files */
     fprintf(stderr,"nstart = %d, nstop = %d \n", nstart, nstop);
@@ -496,9 +569,27 @@ char *argv[];
     /* i_e_step = (int)e_step; */
     
     numb_2 = nstart;
-#ifdef _USE_OPENMP
-    /* #pragma omp parallel for */
-#endif
+
+    /* the next n_prefetch images are read by a separate thread while the
+       current image is analysed; the frames depend on each other through
+       the recalibrated basis a[] and are therefore analysed in order */
+    /* predicted positions and search radii of the spots */
+    if (use_track) track = track_init(range_min);
+
+    if (stack == NULL)
+        prefetch = prefetch_open(fname, nstart, nstop, e_step, n_prefetch);
+    else
+    {
+        /* the frames are mapped from the image stack, which is read ahead 
+           by the operating system */
+        prefetch = NULL;
+        if (!ref_in_stack) 
+        {
+            free(mat_image->imagedata);
+            mat_image->imagedata = NULL;
+        }
+    }
+
     for ( numb = nstart; 
         ((numb<=nstop)&&(e_step>0)) || ((numb>=nstop)&&(e_step<0)); 
         numb+=e_step)  /* note the dodgy cast from float to int */ 
@@ -506,26 +597,45 @@ char *argv[];
 
         /* Read image and convert tifvalues to ImageMatrix */
 
-        fname2 = filename(fname, numb);
-        fprintf(stderr, "read data from file \"%s\" and convert \n", 
-                fname2);
+        if (stack != NULL)
+        {
+            fprintf(stderr, "read image %d from image stack \"%s\" \n", 
+                    numb, stackname);
+            if (imgstack_frame(stack, numb, mat_image, 
+                               &stack_energy, &stack_current) != 0)
+            {
+                fprintf(stderr, "*** error (mkiv_main): image %d is not in "
+                        "image stack '%s'\n", numb, stackname);
+                exit(1);
+            }
+        }
+        else
+        {
+            fname2 = filename(fname, numb);
+            fprintf(stderr, "read data from file \"%s\" and convert \n", 
+                    fname2);
 
-        readtif(tif_image, fname2);
-        conv_tif2mat(tif_image, mat_image);
+            prefetch_frame(prefetch, numb, mat_image);
+        }
 
         /* Read energy from file header */
-        energy = (float)numb;
+        energy = (stack != NULL) ? stack_energy : (float)numb;
 
         /* Compute contraction of new basic vectors, range and scale */
         calca(&kappa, &en_old, energy, a, 
               &range, range_min, rel_range, &scale, scale_min, rel_scale);
+        if (track != NULL) track_origin(track, a, energy);
 
         /* use current from file and smooth it when desired */
-        int_norm[numb]= 100.;
+        int_norm[numb]= (stack != NULL && stack_current > 0.) ? 
+                        stack_current : 100.;
         use_cur = int_norm[numb];
         if (mod_cur<0) use_cur = b_smooth(int_norm, numb, nstart, e_step, 10);
         if (mod_cur>0) use_cur = (float)mod_cur;
 
+        /* two-pass mode: raw intensities, normalised after the loop */
+        if (two_pass) use_cur = 1.;
+
         printf("\n\n");
         QQ printf("#####################################################\n");
         QQ printf("\t\t FILE NAME: %s\n", fname);
@@ -551,6 +661,14 @@ char *argv[];
         /* Set the spot.control bits according to the lists desi,ref */
         setcontrol(nspot, spot, ndesi, desi, nref, ref);
 
+        /* Move spots to tracked positions, reduce search radius */
+        if (track != NULL)
+        {
+            n_tracked = track_predict(track, nspot, spot, range);
+            QQ printf("%d of %d spots tracked (search radius < %.1f)\n", 
+                      n_tracked, nspot, range);
+        }
+
         /* Find spot maxima */
         printf("%d spots measurable. \n", nspot);
         QQ 
@@ -571,8 +689,9 @@ char *argv[];
         /* Find the exact positions 
            (i.e. center of gravity method) of all wanted spots*/
         VPRINT("calculate center of intensity \n");
-        calcoi(nspot, spot,       /* number and list of measurable spots */
-               range, mat_image); /* range for cog search, LEED image */
+        centroid(nspot, spot,     /* number and list of measurable spots */
+                 range, mat_image,/* range for cog search, LEED image */
+                 cent_method);    /* cog, moments or Gaussian fit */
 
         /* Compute total intensity of the reflexes */
         if(bg <=1) ERR_EXIT(no more implemented background!);
@@ -602,22 +721,16 @@ char *argv[];
 
         /* Second run for spots with bad s/n : use range/sec_range, step=1 */
         fimax4(nspot, spot, 1,range/sec_range, mat_image);
-        calcoi(nspot, spot, range, mat_image);
+        centroid(nspot, spot, range, mat_image, cent_method);
         get_int(nspot, spot, mat_image, mat_mask, &scale, angle,
                 use_cur, bg-1, s2n_bad, verb, verh,acci,accb);
 
-        /* Draw integration area boundaries into image */
+        /* Draw integration area boundaries into a copy of the image */
         if(numb % n_show == 0)
         {  
-            drawbound(mat_image, mat_mask, &center, router, rinner, -1, fname_mkiv_ima);
-
             fprintf(stderr, "draw ellipses around found positions\n");
-            fprintf(stderr, "drawell:\n");
-            drawell(nspot, spot, mat_image, &scale, angle, verh);
-            fprintf(stderr, "mark_reflex:\n");
-            mark_reflex(nspot, spot, mat_image, /* list of spots, image */
-                        THICK, range, WHITE,    /* width,radius,color of circles */
-                        0, dummy);              /* don't draw indices */
+            overlay_frame(overlay, mat_image, nspot, spot, 
+                          &scale, angle, verh, range);
             numb_2++;
             /* if(numb_2 % n_show_2 == 0) XV;  // antiquated xv command */
         } 	  
@@ -631,6 +744,9 @@ char *argv[];
             else inty[i] = spot[k].intensity;
         }
 
+        /* Store positions of spots with good s/n for tracking */
+        if (track != NULL) track_measure(track, nspot, spot, s2n_good);
+
         /* Calculate basis with true spot positions */
         fprintf(stderr,"Calculate basis:\n");
         nnref = 0;
@@ -713,16 +829,29 @@ char *argv[];
         else 
         {
             repetitions=0;
+            if (track != NULL) track_accept(track, a);
             VPRINT("updating output ivdat and beam.cur files... \n");
-            fprintf(cur_stream, "%f\t%f\n", energy, int_norm[numb]);
-            fprintf(smcur_stream, "%f\t%f\n", energy, use_cur);
-            fprintf(iv_stream, "%6.1f", energy);
-            for (i=0; i<ndesi; i++ ) 
-                fprintf(iv_stream, " %10.5f", inty[i]);
-            fprintf(iv_stream, "\n");
-            QQ fflush(NULL);       /* flush all buffered output files */
-            else if ((nstop-numb)%update == 0) 
-                fflush(NULL);
+            if (two_pass)
+            {
+                /* store energy, current and raw intensities of frame */
+                if (n_series == max_series)
+                {
+                    max_series = 2*max_series + 64;
+                    series = (float *)realloc(series, 
+                                 max_series * (ndesi + 2) * sizeof(float));
+                    if (series == NULL) 
+                        ERR_EXIT(mkiv_main : memory allocation failed);
+                }
+                series[n_series*(ndesi+2)] = energy;
+                series[n_series*(ndesi+2) + 1] = int_norm[numb];
+                memcpy(series + n_series*(ndesi+2) + 2, inty, 
+                       ndesi * sizeof(float));
+                n_series ++;
+            }
+            else
+                /* flush the output files in QUICK mode every update frames */
+                ivwrite_frame(ivwrite, energy, int_norm[numb], use_cur, inty,
+                              !(verb & QUICK) || (nstop-numb)%update == 0);
         }
 
 
@@ -732,12 +861,46 @@ char *argv[];
    END OF ENERGY - LOOP 
 *************************************************************************/
 
+    prefetch_close(prefetch);
+    imgstack_close(stack);
+    track_free(track);
+
     /* release memory that was allocated for spot structure array */
     free(spot);
 
-    /* close output files */
-    fclose(iv_stream);
-    fclose(cur_stream);
+    /* two-pass mode: smooth the beam currents of the whole series 
+       (centred average) and write the normalised intensities */
+    if (two_pass)
+    {
+        ser_cur = (float *)malloc((n_series + 1) * sizeof(float));
+        ser_smo = (float *)malloc((n_series + 1) * sizeof(float));
+        if (ser_cur == NULL || ser_smo == NULL) 
+            ERR_EXIT(mkiv_main : memory allocation failed);
+
+        for (j=0; j<n_series; j++)
+            ser_cur[j] = ser_smo[j] = series[j*(ndesi+2) + 1];
+        if (mod_cur<0) b_smooth_series(ser_cur, ser_smo, n_series, 5);
+        if (mod_cur>0) 
+            for (j=0; j<n_series; j++) ser_smo[j] = (float)mod_cur;
+
+        for (j=0; j<n_series; j++)
+        {
+            for (i=0; i<ndesi; i++)
+            {
+                inty[i] = series[j*(ndesi+2) + 2 + i];
+                if (fabs(inty[i] - INT_OUT) > TOLERANCE) inty[i] /= ser_smo[j];
+            }
+            ivwrite_frame(ivwrite, series[j*(ndesi+2)], ser_cur[j], 
+                          ser_smo[j], inty, 0);
+        }
+        free(ser_cur);
+        free(ser_smo);
+        free(series);
+    }
+
+    /* write remaining frames and close output files */
+    ivwrite_close(ivwrite);
+    overlay_close(overlay);
 
     /* copy fname_mkiv_dat to fname.ivdat */
     char *fname_ivdat = (char *)malloc(strlen(fname) + 7 * sizeof(char));
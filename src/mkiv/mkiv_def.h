@@ -96,6 +96,11 @@ else {                                                                      \
 #define    DEV_BIG          1
 #define    DEV_SMALL        0
 
+/* spot position methods (centroid.c) */
+#define    CENT_COG         0
+#define    CENT_MOMENT      1
+#define    CENT_GAUSS       2
+
 
 /* structures */
 typedef struct spot
@@ -112,6 +117,7 @@ typedef struct spot
     float  s2n;                     /* signal to noise ratio of reflex   */ 
     float  s2u;		                /* signal to underground ratio       */
     long   control;                 /* control byte */
+    float  range;                   /* search radius (0: common range)   */
 /* spot->control bits */
 #define    SPOT_EXCL        1
 #define    SPOT_DESI        2
@@ -6,6 +6,8 @@
 
 float b_smooth(float *int_norm, int numb, int nstart, int nstep, int width);
 
+void b_smooth_series(float *cur, float *smo, int n, int width);
+
 int calca(float *kappa, float *en_old, float energy,
       Vector a[], float *range, float range_min, float rel_range, 
       Vector *scale, float scale_min, Vector rel_scale);
@@ -21,6 +23,9 @@ int calcspotpos(Vector a[], int ndom, Domain superl[],
                 float router, float rinner, float *radius, 
                 float energy, float ratio, float k_10);   
   
+int centroid(int nspot, Spot spot[], float range, ImageMatrix *image,
+             int method);
+
 int conv_tif2mat(tifvalues *tifval, ImageMatrix *mat_image);
 
 int conv_mat2tif(ImageMatrix *mat_image, tifvalues *tif_image);
@@ -47,6 +52,28 @@ int get_int(int nspot, Spot spot[], ImageMatrix *image, ImageMatrix *imask, Vect
             float angle, float use_cur, int bg, float mins2n, int verb,
             float verh, float acci, float accb);
                
+struct imgstack;
+
+int imgstack_convert(char *stack_path, char *fname, int nstart, int nstop,
+                     float e_step, char *cur_path);
+
+struct imgstack *imgstack_open(char *stack_path, int depth);
+
+int imgstack_frame(struct imgstack *st, int numb, ImageMatrix *mat_image,
+                   float *energy, float *current);
+
+void imgstack_close(struct imgstack *st);
+
+struct ivwrite;
+
+struct ivwrite *ivwrite_open(char *iv_path, char *cur_path, char *smcur_path,
+                             int ndesi, struct lindex desi[]);
+
+void ivwrite_frame(struct ivwrite *iw, float energy, float cur, float smcur,
+                   float inty[], int flush);
+
+void ivwrite_close(struct ivwrite *iw);
+
 int ito3a(int n, char *s);
 
 int mark_reflex(int nspot, Spot spot[], ImageMatrix *image, float thick, float radius, 
@@ -57,8 +84,43 @@ int mkmask(ImageMatrix *image, Coord *center,
 
 int out_tif(ImageMatrix *image, char *filename);
 
+struct overlay;
+
+struct overlay *overlay_open(char *ima_path, char *ref_path, int png_step,
+                             ImageMatrix *imask, Coord *center,
+                             float router, float rinner);
+
+int overlay_frame(struct overlay *ov, ImageMatrix *image, int nspot,
+                  Spot spot[], Vector *scale, float angle, float verh,
+                  float range);
+
+void overlay_close(struct overlay *ov);
+
 int plot_indices(ImageMatrix *image, int nspot, struct spot * spot);
 
+struct prefetch;
+
+struct prefetch *prefetch_open(char *fname, int nstart, int nstop,
+                               float e_step, int depth);
+
+int prefetch_frame(struct prefetch *pf, int numb, ImageMatrix *mat_image);
+
+void prefetch_close(struct prefetch *pf);
+
+struct track;
+
+struct track *track_init(float r_min);
+
+void track_origin(struct track *tr, Vector a[], float energy);
+
+int track_predict(struct track *tr, int nspot, Spot spot[], float range);
+
+void track_measure(struct track *tr, int nspot, Spot spot[], float s2n_min);
+
+void track_accept(struct track *tr, Vector a[]);
+
+void track_free(struct track *tr);
+
 void quicksort(struct spot *low_ptr, struct spot *up_ptr);
 
 int readinp(int verb, char *inp_path, char *param_path, char *ref_name, 
@@ -25,6 +25,14 @@ void mkiv_usage(FILE *output)
     fprintf(output, "  -b --current <float> : followed by the beam current value\n");
     fprintf(output, "  -B --beam <prefix>   : followed by the prefix for .raw and .smo files [default='beam']\n");
     fprintf(output, "  -h --help            : print help\n");
+    fprintf(output, "  -k --prefetch <int>  : number of LEED images read ahead while processing [default=2]\n");
+    fprintf(output, "  -S --stack <file>    : read the LEED images from an image stack (see --make-stack)\n");
+    fprintf(output, "  -t --track           : track spot positions across energies and search each spot in a reduced area\n");
+    fprintf(output, "  --two-pass           : normalise the intensities to the (smoothed) beam current after the energy loop\n");
+    fprintf(output, "  --png <int>          : also write the annotated images as 8 bit PNG, downsampled by <int> [default=0: no PNG]\n");
+    fprintf(output, "  -g --centroid <method> : spot positions: cog (centre of gravity), moment (above background) or gauss (2D Gaussian fit) [default=cog]\n");
+    fprintf(output, "  --make-stack <file>  : write the LEED images of the energy loop to an image stack and exit\n");
+    fprintf(output, "  --stack-current <file> : beam currents (lines 'energy current') stored by --make-stack\n");
     fprintf(output, "  -q --quiet --quick   : faster, no graphical output, only few printf's\n");
     fprintf(output, "  -v --verbose         : give more detailed information during computations\n");
     fprintf(output, "  -V --version         : give version and additional information about this program\n");
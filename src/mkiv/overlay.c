@@ -0,0 +1,368 @@
+/****************************************************************************
+LD/19.10.26
+
+File Name: overlay.c
+
+ Purpose:
+  Annotated images of the energy loop (every n_show'th frame): the
+  boundaries of the LEED screen (drawbound), the integration areas
+  (drawell) and the spot circles (mark_reflex) are drawn into a copy of
+  the frame by a separate thread and written to ima.byte and the image
+  file of mkiv. Optionally, the annotated frame is also written as an
+  8 bit PNG, downsampled by an integer factor.
+
+  overlay_open  : start the drawing thread
+  overlay_frame : queue a copy of the frame and the spot list
+  overlay_close : draw the last queued frame, stop the thread
+
+  The frame used by the analysis is never changed (a repeated frame is
+  analysed again from the same data). The energy loop does not wait for
+  the drawing: if a frame is still pending when the next one is queued,
+  it is replaced by the newer frame. If threads are not available, the
+  frames are drawn directly.
+
+History:
+LD/19.10.26 - Creation.
+
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mkiv.h"
+
+#if !defined(_WIN32)
+#define OVERLAY_THREAD
+#include <pthread.h>
+#endif
+
+#ifdef _USE_PNG
+#include <png.h>
+#endif
+
+#define OV_FREE     0           /* states of the frame buffers            */
+#define OV_PENDING  1
+#define OV_DRAWING  2
+#define OV_NBUF     3           /* drawing, pending and filled            */
+
+struct overlay_buf
+{
+    ImageMatrix image;          /* copy of the frame                      */
+    Spot *spot;                 /* copy of the spot list                  */
+    int nspot, max_spot;
+    Vector scale;               /* half axes of integration area          */
+    float angle, verh, range;
+    int state;
+};
+
+struct overlay
+{
+    char ima_path[FILENAME_MAX];/* image with screen boundaries           */
+    char ref_path[FILENAME_MAX];/* image with all annotations             */
+    char png_path[FILENAME_MAX];/* downsampled PNG                        */
+    int png_step;               /* downsampling factor (0: no PNG)        */
+    ImageMatrix *imask;         /* mask (NULL: router, rinner)            */
+    Coord center;
+    float router, rinner;
+    struct overlay_buf buf[OV_NBUF];
+    int n_drop;                 /* frames replaced before being drawn     */
+    int threaded;
+    int stop;
+#ifdef OVERLAY_THREAD
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+};
+
+/***************************************************************************/
+
+#ifdef _USE_PNG
+static int write_png(ImageMatrix *image, int step, char *path)
+
+/* write image downsampled by step (mean of step*step pixels) as 8 bit
+   grey PNG, scaled to the maximum of the downsampled image */
+{
+    int cols = image->rows, rows = image->cols;
+    int n_col = cols / step, n_row = rows / step;
+    unsigned short *im = (unsigned short *)image->imagedata;
+    unsigned char *row;
+    unsigned int *sum;
+    unsigned int max_val = 1;
+    int i, j, k;
+    FILE *fp;
+    png_structp png;
+    png_infop info;
+
+    if (n_col < 1 || n_row < 1) return -1;
+    sum = (unsigned int *)malloc((size_t)n_col * n_row * sizeof(unsigned int));
+    row = (unsigned char *)malloc(n_col);
+    if (sum == NULL || row == NULL)
+    {
+        free(sum);
+        free(row);
+        return -1;
+    }
+
+    memset(sum, 0, (size_t)n_col * n_row * sizeof(unsigned int));
+    for (i = 0; i < n_row * step; i++)
+        for (j = 0; j < n_col * step; j++)
+            sum[(i/step)*n_col + j/step] += im[i*cols + j];
+    for (k = 0; k < n_col * n_row; k++)
+        max_val = MAX(max_val, sum[k]);
+
+    if ((fp = fopen(path, "wb")) == NULL)
+    {
+        free(sum);
+        free(row);
+        return -1;
+    }
+    png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    info = (png != NULL) ? png_create_info_struct(png) : NULL;
+    if (info == NULL || setjmp(png_jmpbuf(png)))
+    {
+        png_destroy_write_struct(&png, &info);
+        fclose(fp);
+        free(sum);
+        free(row);
+        return -1;
+    }
+    png_init_io(png, fp);
+    png_set_IHDR(png, info, n_col, n_row, 8, PNG_COLOR_TYPE_GRAY,
+                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                 PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
+    for (i = 0; i < n_row; i++)
+    {
+        for (j = 0; j < n_col; j++)
+            row[j] = (unsigned char)(255. * sum[i*n_col + j] / max_val);
+        png_write_row(png, row);
+    }
+    png_write_end(png, NULL);
+    png_destroy_write_struct(&png, &info);
+    fclose(fp);
+    free(sum);
+    free(row);
+    return 0;
+}
+#endif
+
+/***************************************************************************/
+
+static void draw_frame(struct overlay *ov, struct overlay_buf *b)
+{
+    drawbound(&b->image, ov->imask, &ov->center, ov->router, ov->rinner,
+              -1, ov->ima_path);
+    drawell(b->nspot, b->spot, &b->image, &b->scale, b->angle, b->verh);
+    mark_reflex(b->nspot, b->spot, &b->image,  /* list of spots, image */
+                THICK, b->range, WHITE,        /* width,radius,color   */
+                0, ov->ref_path);              /* no indices           */
+#ifdef _USE_PNG
+    if (ov->png_step > 0 && write_png(&b->image, ov->png_step, ov->png_path))
+        fprintf(stderr, "* warning (overlay): failed to write '%s'\n",
+                ov->png_path);
+#endif
+}
+
+/***************************************************************************/
+
+#ifdef OVERLAY_THREAD
+static void *overlay_thread(void *arg)
+{
+    struct overlay *ov = (struct overlay *)arg;
+    int i_buf;
+
+    pthread_mutex_lock(&ov->lock);
+    for (;;)
+    {
+        for (i_buf = 0; i_buf < OV_NBUF; i_buf++)
+            if (ov->buf[i_buf].state == OV_PENDING) break;
+        if (i_buf == OV_NBUF)
+        {
+            if (ov->stop) break;
+            pthread_cond_wait(&ov->cond, &ov->lock);
+            continue;
+        }
+        ov->buf[i_buf].state = OV_DRAWING;
+        pthread_mutex_unlock(&ov->lock);
+
+        draw_frame(ov, ov->buf + i_buf);
+
+        pthread_mutex_lock(&ov->lock);
+        ov->buf[i_buf].state = OV_FREE;
+    }
+    pthread_mutex_unlock(&ov->lock);
+
+    return NULL;
+}
+#endif
+
+/***************************************************************************/
+
+struct overlay *overlay_open(char *ima_path, char *ref_path, int png_step,
+                             ImageMatrix *imask, Coord *center,
+                             float router, float rinner)
+
+/****************************************************************************
+ Start drawing the annotated images: ima_path is written by drawbound,
+ ref_path by mark_reflex (see mkiv.c). If png_step > 0, the annotated
+ image is also written to ima_path with extension .png, downsampled by
+ png_step. imask must be valid until overlay_close.
+ Return value: pointer to the overlay structure (never NULL).
+****************************************************************************/
+{
+    struct overlay *ov;
+    char *ext;
+
+    ov = (struct overlay *)calloc(1, sizeof(struct overlay));
+    if (ov == NULL) ERR_EXIT((overlay_open): memory allocation failed);
+
+    strncpy(ov->ima_path, ima_path, FILENAME_MAX-1);
+    strncpy(ov->ref_path, ref_path, FILENAME_MAX-1);
+    strncpy(ov->png_path, ima_path, FILENAME_MAX-5);
+    if ((ext = strrchr(ov->png_path, '.')) != NULL &&
+        strchr(ext, '/') == NULL && strchr(ext, '\\') == NULL)
+        *ext = '\0';
+    strcat(ov->png_path, ".png");
+
+    ov->png_step = MAX(png_step, 0);
+#ifndef _USE_PNG
+    if (ov->png_step > 0)
+    {
+        fprintf(stderr, "* warning (overlay_open): compiled without libpng,"
+                " no PNG output\n");
+        ov->png_step = 0;
+    }
+#endif
+
+    ov->imask = imask;
+    ov->center = *center;
+    ov->router = router;
+    ov->rinner = rinner;
+
+#ifdef OVERLAY_THREAD
+    pthread_mutex_init(&ov->lock, NULL);
+    pthread_cond_init(&ov->cond, NULL);
+    if (pthread_create(&ov->thread, NULL, overlay_thread, ov) == 0)
+        ov->threaded = 1;
+    else
+    {
+        fprintf(stderr, "* warning (overlay_open): cannot start thread,"
+                " images are drawn directly\n");
+        pthread_mutex_destroy(&ov->lock);
+        pthread_cond_destroy(&ov->cond);
+    }
+#endif
+
+    return ov;
+}
+
+/***************************************************************************/
+
+int overlay_frame(struct overlay *ov, ImageMatrix *image, int nspot,
+                  Spot spot[], Vector *scale, float angle, float verh,
+                  float range)
+
+/****************************************************************************
+ Queue a copy of image and spot list to be drawn (replaces a frame that
+ is still pending).
+ Return value: number of frames replaced so far.
+****************************************************************************/
+{
+    struct overlay_buf *b;
+    size_t n_size = (size_t)image->rows * image->cols * sizeof(unsigned short);
+    int i_buf;
+
+#ifdef OVERLAY_THREAD
+    if (ov->threaded) pthread_mutex_lock(&ov->lock);
+#endif
+    /* at most one buffer is drawn and one is pending */
+    for (i_buf = 0; i_buf < OV_NBUF; i_buf++)
+        if (ov->buf[i_buf].state == OV_FREE) break;
+#ifdef OVERLAY_THREAD
+    if (ov->threaded) pthread_mutex_unlock(&ov->lock);
+#endif
+    b = ov->buf + i_buf;
+
+    /* copy the frame (free buffers are only used by this thread) */
+    if (b->image.imagedata == NULL ||
+        b->image.rows * b->image.cols != image->rows * image->cols)
+    {
+        free(b->image.imagedata);
+        b->image.imagedata = (uint32 *)malloc(n_size);
+    }
+    if (nspot > b->max_spot)
+    {
+        free(b->spot);
+        b->max_spot = nspot;
+        b->spot = (Spot *)malloc(nspot * sizeof(Spot));
+    }
+    if (b->image.imagedata == NULL || (nspot > 0 && b->spot == NULL))
+        ERR_EXIT((overlay_frame): memory allocation failed);
+
+    b->image.rows = image->rows;
+    b->image.cols = image->cols;
+    memcpy(b->image.imagedata, image->imagedata, n_size);
+    memcpy(b->spot, spot, nspot * sizeof(Spot));
+    b->nspot = nspot;
+    b->scale = *scale;
+    b->angle = angle;
+    b->verh = verh;
+    b->range = range;
+
+#ifdef OVERLAY_THREAD
+    if (ov->threaded)
+    {
+        pthread_mutex_lock(&ov->lock);
+        for (i_buf = 0; i_buf < OV_NBUF; i_buf++)
+        {
+            if (ov->buf[i_buf].state == OV_PENDING)
+            {
+                ov->buf[i_buf].state = OV_FREE;
+                ov->n_drop ++;
+            }
+        }
+        b->state = OV_PENDING;
+        pthread_cond_broadcast(&ov->cond);
+        pthread_mutex_unlock(&ov->lock);
+        return ov->n_drop;
+    }
+#endif
+
+    draw_frame(ov, b);
+    return ov->n_drop;
+}
+
+/***************************************************************************/
+
+void overlay_close(struct overlay *ov)
+
+/****************************************************************************
+ Draw the frame that is still pending and stop the drawing thread.
+****************************************************************************/
+{
+    int i_buf;
+
+    if (ov == NULL) return;
+
+#ifdef OVERLAY_THREAD
+    if (ov->threaded)
+    {
+        pthread_mutex_lock(&ov->lock);
+        ov->stop = 1;
+        pthread_cond_broadcast(&ov->cond);
+        pthread_mutex_unlock(&ov->lock);
+        pthread_join(ov->thread, NULL);
+        pthread_mutex_destroy(&ov->lock);
+        pthread_cond_destroy(&ov->cond);
+    }
+#endif
+
+    for (i_buf = 0; i_buf < OV_NBUF; i_buf++)
+    {
+        free(ov->buf[i_buf].image.imagedata);
+        free(ov->buf[i_buf].spot);
+    }
+    free(ov);
+}
+/***************************************************************************/
@@ -0,0 +1,284 @@
+/****************************************************************************
+LD/19.10.26
+
+File Name: prefetch.c
+
+ Purpose:
+  Read and decode the LEED images of the energy loop ahead of time.
+  A separate thread reads the next <depth> TIFF frames (readtif and
+  conv_tif2mat) while the current frame is analysed by mkiv; the decoded
+  frames are kept in a ring of <depth>+1 image matrices.
+
+  prefetch_open  : start reading the frame sequence nstart, nstart+e_step,..
+  prefetch_frame : copy frame numb to mat_image (waits if necessary)
+  prefetch_close : stop the reading thread and free the ring
+
+  Frames that are requested out of sequence (or if threads are not
+  available, or depth = 0) are read directly, as in the original loop.
+  A frame that has been requested can be requested again (mkiv repeats
+  a frame if the basis recalibration failed).
+
+History:
+LD/19.10.26 - Creation.
+
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mkiv.h"
+
+#if !defined(_WIN32)
+#define PREFETCH_THREAD
+#include <pthread.h>
+#endif
+
+struct prefetch
+{
+    char fname[STRSZ];          /* name of first image (ext. = number)    */
+    int n_frame;                /* number of frames in energy loop        */
+    int *frame;                 /* frame numbers in order of the loop     */
+    int depth;                  /* number of frames read ahead            */
+    int n_slot;                 /* size of ring = depth + 1               */
+    ImageMatrix *slot;          /* decoded frames                         */
+    int *slot_frame;            /* index (in frame) of frame in slot      */
+    int *slot_ok;               /* 1: slot holds frame, 0: frame missing  */
+    int base;                   /* oldest frame index still needed        */
+    int next;                   /* next frame index to be read            */
+    int done;                   /* reading thread has finished            */
+    int stop;                   /* request to stop the reading thread     */
+    tifvalues tif;              /* TIFF buffer of reading thread          */
+    tifvalues tif_direct;       /* TIFF buffer for frames read directly   */
+#ifdef PREFETCH_THREAD
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+};
+
+/***************************************************************************/
+
+static void read_frame(tifvalues *tif, char *fname, int numb,
+                       ImageMatrix *mat_image)
+{
+    readtif(tif, filename(fname, numb));
+    conv_tif2mat(tif, mat_image);
+}
+
+/***************************************************************************/
+
+static void copy_frame(ImageMatrix *src, ImageMatrix *dest)
+{
+    size_t n_size = (size_t)src->rows * src->cols * sizeof(unsigned short);
+
+    if (dest->imagedata == NULL || dest->rows * dest->cols != src->rows * src->cols)
+    {
+        free(dest->imagedata);
+        dest->imagedata = (uint32 *)malloc(n_size);
+        if (dest->imagedata == NULL)
+            ERR_EXIT((prefetch_frame): memory allocation failed);
+    }
+    dest->rows = src->rows;
+    dest->cols = src->cols;
+    memcpy(dest->imagedata, src->imagedata, n_size);
+}
+
+/***************************************************************************/
+
+#ifdef PREFETCH_THREAD
+static void *prefetch_thread(void *arg)
+{
+    struct prefetch *pf = (struct prefetch *)arg;
+    char fname[STRSZ];
+    int i_frame, i_slot, ok;
+
+    strcpy(fname, pf->fname);
+
+    pthread_mutex_lock(&pf->lock);
+    while (!pf->stop && pf->next < pf->n_frame)
+    {
+        /* ring is full: wait for the main loop */
+        while (!pf->stop && pf->next > pf->base + pf->depth)
+            pthread_cond_wait(&pf->cond, &pf->lock);
+        if (pf->stop) break;
+
+        i_frame = pf->next;
+        i_slot = i_frame % pf->n_slot;
+        pthread_mutex_unlock(&pf->lock);
+
+        /* a missing file is reported (and terminates mkiv) when the frame
+           is read directly by prefetch_frame */
+        ok = file_exists(filename(fname, pf->frame[i_frame]));
+        if (ok)
+            read_frame(&pf->tif, fname, pf->frame[i_frame], pf->slot + i_slot);
+
+        pthread_mutex_lock(&pf->lock);
+        pf->slot_frame[i_slot] = i_frame;
+        pf->slot_ok[i_slot] = ok;
+        pf->next ++;
+        pthread_cond_broadcast(&pf->cond);
+        if (!ok) break;
+    }
+    pf->done = 1;
+    pthread_cond_broadcast(&pf->cond);
+    pthread_mutex_unlock(&pf->lock);
+
+    return NULL;
+}
+#endif
+
+/***************************************************************************/
+
+struct prefetch *prefetch_open(char *fname, int nstart, int nstop,
+                               float e_step, int depth)
+
+/****************************************************************************
+ Start reading the frames of the energy loop
+     for (numb = nstart; <numb within nstart..nstop>; numb += e_step)
+ (same sequence as in mkiv) with up to depth frames read ahead.
+ Return value: pointer to the prefetch structure (never NULL; if no
+ thread could be started, prefetch_frame reads the frames directly).
+****************************************************************************/
+{
+    struct prefetch *pf;
+    int numb, i_slot;
+
+    pf = (struct prefetch *)calloc(1, sizeof(struct prefetch));
+    if (pf == NULL) ERR_EXIT((prefetch_open): memory allocation failed);
+
+    strncpy(pf->fname, fname, STRSZ-1);
+
+    for (numb = nstart;
+        ((numb<=nstop)&&(e_step>0)) || ((numb>=nstop)&&(e_step<0));
+        numb+=e_step)
+        pf->n_frame ++;
+
+    pf->frame = (int *)malloc((pf->n_frame + 1) * sizeof(int));
+    if (pf->frame == NULL) ERR_EXIT((prefetch_open): memory allocation failed);
+
+    pf->n_frame = 0;
+    for (numb = nstart;
+        ((numb<=nstop)&&(e_step>0)) || ((numb>=nstop)&&(e_step<0));
+        numb+=e_step)
+        pf->frame[pf->n_frame ++] = numb;
+
+    pf->depth = MAX(depth, 0);
+    pf->n_slot = pf->depth + 1;
+    pf->slot = (ImageMatrix *)calloc(pf->n_slot, sizeof(ImageMatrix));
+    pf->slot_frame = (int *)malloc(pf->n_slot * sizeof(int));
+    pf->slot_ok = (int *)calloc(pf->n_slot, sizeof(int));
+    if (pf->slot == NULL || pf->slot_frame == NULL || pf->slot_ok == NULL)
+        ERR_EXIT((prefetch_open): memory allocation failed);
+    for (i_slot = 0; i_slot < pf->n_slot; i_slot++)
+        pf->slot_frame[i_slot] = -1;
+
+    pf->done = 1;
+    if (pf->n_frame == 0) pf->depth = 0;
+
+#ifdef PREFETCH_THREAD
+    if (pf->depth > 0)
+    {
+        pthread_mutex_init(&pf->lock, NULL);
+        pthread_cond_init(&pf->cond, NULL);
+        pf->done = 0;
+        if (pthread_create(&pf->thread, NULL, prefetch_thread, pf) != 0)
+        {
+            fprintf(stderr, "* warning (prefetch_open): cannot start thread,"
+                    " frames are read directly\n");
+            pthread_mutex_destroy(&pf->lock);
+            pthread_cond_destroy(&pf->cond);
+            pf->done = 1;
+            pf->depth = 0;
+        }
+    }
+#else
+    pf->depth = 0;
+#endif
+
+    return pf;
+}
+
+/***************************************************************************/
+
+int prefetch_frame(struct prefetch *pf, int numb, ImageMatrix *mat_image)
+
+/****************************************************************************
+ Copy frame numb into mat_image (mat_image->imagedata is reallocated if
+ necessary). Frames before numb are released, i.e. the reading thread
+ may continue with the next frames.
+ Return value: 1 if the frame was prefetched, 0 if it was read directly.
+****************************************************************************/
+{
+#ifdef PREFETCH_THREAD
+    int i_frame, i_slot;
+
+    if (pf->depth > 0)
+    {
+        pthread_mutex_lock(&pf->lock);
+
+        for (i_frame = pf->base;
+             i_frame < pf->n_frame && pf->frame[i_frame] != numb; i_frame++)
+            ;
+
+        if (i_frame < pf->n_frame)
+        {
+            /* release older frames */
+            if (i_frame > pf->base)
+            {
+                pf->base = i_frame;
+                pthread_cond_broadcast(&pf->cond);
+            }
+
+            i_slot = i_frame % pf->n_slot;
+            while (pf->slot_frame[i_slot] != i_frame &&
+                   !(pf->done && pf->next <= i_frame))
+                pthread_cond_wait(&pf->cond, &pf->lock);
+
+            if (pf->slot_frame[i_slot] == i_frame && pf->slot_ok[i_slot])
+            {
+                /* slot i_slot is not changed while base <= i_frame */
+                pthread_mutex_unlock(&pf->lock);
+                copy_frame(pf->slot + i_slot, mat_image);
+                return 1;
+            }
+        }
+        pthread_mutex_unlock(&pf->lock);
+    }
+#endif
+
+    read_frame(&pf->tif_direct, pf->fname, numb, mat_image);
+    return 0;
+}
+
+/***************************************************************************/
+
+void prefetch_close(struct prefetch *pf)
+{
+    int i_slot;
+
+    if (pf == NULL) return;
+
+#ifdef PREFETCH_THREAD
+    if (pf->depth > 0)
+    {
+        pthread_mutex_lock(&pf->lock);
+        pf->stop = 1;
+        pthread_cond_broadcast(&pf->cond);
+        pthread_mutex_unlock(&pf->lock);
+        pthread_join(pf->thread, NULL);
+        pthread_mutex_destroy(&pf->lock);
+        pthread_cond_destroy(&pf->cond);
+    }
+#endif
+
+    for (i_slot = 0; i_slot < pf->n_slot; i_slot++)
+        free(pf->slot[i_slot].imagedata);
+    free(pf->slot);
+    free(pf->slot_frame);
+    free(pf->slot_ok);
+    free(pf->frame);
+    free(pf->tif.buf);
+    free(pf->tif_direct.buf);
+    free(pf);
+}
+/***************************************************************************/
@@ -0,0 +1,285 @@
+/****************************************************************************
+LD/19.10.26
+
+File Name: track.c
+
+ Purpose:
+  Tracking of spot positions across the energy loop (mkiv -t).
+  For each spot (h,k) the position relative to the calculated lattice
+  position is stored together with its velocity with respect to
+  u = 1/sqrt(E) and the mean error of the last predictions. Only spots
+  with a good signal-to-noise ratio update their track.
+
+  track_init    : create an empty track table
+  track_origin  : predict the origin a[0] for the next energy
+  track_predict : predicted position and search radius of each spot
+  track_measure : store the positions found in the current frame
+  track_accept  : update the tracks when the frame has been accepted
+  track_free    : release the track table
+
+  The search radius (spot.range) of a spot that has been found in the
+  last frames is TRACK_ERR_FAC times the mean prediction error, but not
+  smaller than r_min; spots without such a history are searched within
+  the common range. The origin is extrapolated linearly in u, which
+  reduces the deviations between the predicted and recalibrated basis
+  (i.e. the number of repeated frames).
+
+History:
+LD/19.10.26 - Creation.
+
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mkiv.h"
+
+#define TRACK_ERR_FAC   3.      /* search radius / mean prediction error  */
+#define TRACK_AVG       0.5     /* weight of new values in running means  */
+
+struct track_spot
+{
+    float lind1, lind2;         /* indices of spot                        */
+    float rx, ry;               /* position relative to lattice position  */
+    float vx, vy;               /* d(rx,ry)/du                            */
+    float u;                    /* u = 1/sqrt(E) of last update           */
+    float err;                  /* mean prediction error (pixels)         */
+    int n;                      /* number of updates                      */
+    int miss;                   /* 1: not found in last accepted frame    */
+    float lat_x, lat_y;         /* lattice position in current frame     */
+    float mx, my;               /* position found in current frame        */
+    int found;                  /* 1: mx, my are valid                    */
+};
+
+struct track
+{
+    int n_track, max_track;
+    struct track_spot *ts;
+    float r_min;                /* minimum search radius                  */
+    float u;                    /* u of current frame                     */
+    float sx, sy;               /* origin shift applied in current frame  */
+    float ox, oy, vox, voy, u_o;/* origin, velocity, u of last frame      */
+    int n_o;                    /* number of accepted frames              */
+    int n_pass;                 /* frame passes with the same u           */
+};
+
+/***************************************************************************/
+
+static struct track_spot *track_find(struct track *tr, float lind1,
+                                     float lind2, int create)
+{
+    int i;
+
+    for (i = 0; i < tr->n_track; i++)
+        if (PYTH(tr->ts[i].lind1 - lind1, tr->ts[i].lind2 - lind2) < TOLERANCE)
+            return tr->ts + i;
+
+    if (!create) return NULL;
+
+    if (tr->n_track == tr->max_track)
+    {
+        tr->max_track = 2*tr->max_track + 64;
+        tr->ts = (struct track_spot *)realloc(tr->ts,
+                        tr->max_track * sizeof(struct track_spot));
+        if (tr->ts == NULL) ERR_EXIT(track_find : memory allocation failed);
+    }
+    tr->ts[tr->n_track].lind1 = lind1;
+    tr->ts[tr->n_track].lind2 = lind2;
+    tr->ts[tr->n_track].n = 0;
+    tr->ts[tr->n_track].miss = 1;
+    tr->ts[tr->n_track].found = 0;
+    tr->ts[tr->n_track].err = 0.;
+    tr->ts[tr->n_track].vx = tr->ts[tr->n_track].vy = 0.;
+
+    return tr->ts + tr->n_track++;
+}
+
+/***************************************************************************/
+
+struct track *track_init(float r_min)
+
+/****************************************************************************
+ Create an empty track table; r_min is the smallest search radius
+ (pixels) used for tracked spots.
+****************************************************************************/
+{
+    struct track *tr;
+
+    tr = (struct track *)calloc(1, sizeof(struct track));
+    if (tr == NULL) ERR_EXIT(track_init : memory allocation failed);
+    tr->r_min = r_min;
+    tr->u = -1.;
+
+    return tr;
+}
+
+/***************************************************************************/
+
+void track_origin(struct track *tr, Vector a[], float energy)
+
+/****************************************************************************
+ Set the current energy and shift the origin a[0] to the position
+ extrapolated from the last accepted frames. If the frame is repeated
+ (same energy), a[0] is the recalibrated origin and is not changed.
+****************************************************************************/
+{
+    float u = 1./sqrt(energy);
+
+    tr->sx = tr->sy = 0.;
+    if (fabs(u - tr->u) < 1.e-6)
+    {
+        tr->n_pass ++;
+        return;
+    }
+    tr->u = u;
+    tr->n_pass = 0;
+
+    if (tr->n_o >= 2)
+    {
+        tr->sx = tr->vox * (u - tr->u_o);
+        tr->sy = tr->voy * (u - tr->u_o);
+        a[0].xx += tr->sx;
+        a[0].yy += tr->sy;
+    }
+}
+
+/***************************************************************************/
+
+int track_predict(struct track *tr, int nspot, Spot spot[], float range)
+
+/****************************************************************************
+ Move the calculated positions (x0,y0 and xx,yy) of the spots to the
+ predicted positions and set the search radius spot.range.
+ Must be called after calcspotpos and track_origin.
+ Return value: number of spots with a reduced search radius.
+****************************************************************************/
+{
+    struct track_spot *ts;
+    float du, px, py;
+    int i, n_small = 0;
+
+    for (i = 0; i < nspot; i++)
+    {
+        spot[i].range = 0.;
+
+        /* lattice position without the origin shift of this frame: the
+           tracks contain the motion of the origin */
+        ts = track_find(tr, spot[i].lind1, spot[i].lind2, 1);
+        ts->lat_x = spot[i].x0 - tr->sx;
+        ts->lat_y = spot[i].y0 - tr->sy;
+        ts->found = 0;
+
+        if (ts->n == 0) continue;
+
+        du = tr->u - ts->u;
+        px = ts->lat_x + ts->rx + ts->vx * du;
+        py = ts->lat_y + ts->ry + ts->vy * du;
+        spot[i].xx = spot[i].x0 = px;
+        spot[i].yy = spot[i].y0 = py;
+
+        if (ts->n >= 2 && !ts->miss)
+        {
+            spot[i].range = MAX(tr->r_min, TRACK_ERR_FAC * ts->err);
+            if (spot[i].range < range) n_small ++;
+            else spot[i].range = 0.;
+        }
+    }
+
+    return n_small;
+}
+
+/***************************************************************************/
+
+void track_measure(struct track *tr, int nspot, Spot spot[], float s2n_min)
+
+/****************************************************************************
+ Store the positions of the spots with s2n >= s2n_min found in the
+ current frame. Must be called before spots are removed from the list.
+****************************************************************************/
+{
+    struct track_spot *ts;
+    int i;
+
+    for (i = 0; i < nspot; i++)
+    {
+        if ( (spot[i].control & SPOT_OUT) || spot[i].s2n < s2n_min) continue;
+        ts = track_find(tr, spot[i].lind1, spot[i].lind2, 0);
+        if (ts == NULL) continue;
+        ts->mx = spot[i].xx - ts->lat_x;
+        ts->my = spot[i].yy - ts->lat_y;
+        ts->found = 1;
+    }
+}
+
+/***************************************************************************/
+
+void track_accept(struct track *tr, Vector a[])
+
+/****************************************************************************
+ The current frame has been accepted: update the tracks of the spots
+ found and the origin.
+****************************************************************************/
+{
+    struct track_spot *ts;
+    float du, e, vx, vy;
+    int i;
+
+    for (i = 0; i < tr->n_track; i++)
+    {
+        ts = tr->ts + i;
+        if (!ts->found)
+        {
+            ts->miss = 1;
+            continue;
+        }
+
+        du = tr->u - ts->u;
+        if (ts->n >= 1)
+        {
+            e = PYTH(ts->mx - ts->rx - ts->vx * du,
+                     ts->my - ts->ry - ts->vy * du);
+            ts->err = (ts->n >= 2) ?
+                (1. - TRACK_AVG) * ts->err + TRACK_AVG * e : e;
+
+            if (fabs(du) > 1.e-6)
+            {
+                vx = (ts->mx - ts->rx) / du;
+                vy = (ts->my - ts->ry) / du;
+                ts->vx = (ts->n >= 2) ?
+                    (1. - TRACK_AVG) * ts->vx + TRACK_AVG * vx : vx;
+                ts->vy = (ts->n >= 2) ?
+                    (1. - TRACK_AVG) * ts->vy + TRACK_AVG * vy : vy;
+            }
+        }
+        ts->rx = ts->mx;
+        ts->ry = ts->my;
+        ts->u = tr->u;
+        ts->n ++;
+        ts->miss = 0;
+        ts->found = 0;
+    }
+
+    /* origin */
+    if (tr->n_o >= 1 && fabs(tr->u - tr->u_o) > 1.e-6)
+    {
+        vx = (a[0].xx - tr->ox) / (tr->u - tr->u_o);
+        vy = (a[0].yy - tr->oy) / (tr->u - tr->u_o);
+        tr->vox = (tr->n_o >= 2) ?
+            (1. - TRACK_AVG) * tr->vox + TRACK_AVG * vx : vx;
+        tr->voy = (tr->n_o >= 2) ?
+            (1. - TRACK_AVG) * tr->voy + TRACK_AVG * vy : vy;
+    }
+    tr->ox = a[0].xx;
+    tr->oy = a[0].yy;
+    tr->u_o = tr->u;
+    tr->n_o ++;
+}
+
+/***************************************************************************/
+
+void track_free(struct track *tr)
+{
+    if (tr == NULL) return;
+    free(tr->ts);
+    free(tr);
+}
+/***************************************************************************/
@@ -47,6 +47,17 @@ struct crargs  args;              /* program parameters from argument list */
 **********************************************************************/
  args = cr_rdargs(argc, argv);
 
+/**********************************************************************
+  Resident service: read control file and expt. data only,
+  theoretical input is read per request (see crfserve.c).
+**********************************************************************/
+
+ if (args.serve)
+ {
+   iv_cur = cr_input(args.ctrfile, NULL);
+   return (cr_serve(iv_cur, &args) == 0) ? 0 : 1;
+ }
+
 /**********************************************************************
   Read data from files 
 **********************************************************************/
@@ -70,20 +81,34 @@ struct crargs  args;              /* program parameters from argument list */
    fprintf(STDCTR,"before spline\n");
 #endif
 
-/* prepare cubic spline */
-   cr_spline((iv_cur+i_list)->exp_list, (iv_cur+i_list)->exp_leng);
-   (iv_cur+i_list)->exp_spline = 1;
-   cr_spline((iv_cur+i_list)->the_list, (iv_cur+i_list)->the_leng);
-   (iv_cur+i_list)->the_spline = 1;
  }  /* for i_list */
+
+/* prepare cubic splines of all curves in one go */
+ if(cr_spline_setup(iv_cur) == NULL)
+ {
+   fprintf(STDERR, "*** error (crfac): spline preparation failed\n");
+   exit(1);
+ }
  
 #ifdef CONTROL
  fprintf(STDCTR,"before cr_rmin\n");
 #endif
  
  r_min = cr_rmin(iv_cur, &args, &r_min, &s_min, &e_range);
+ if(r_min < 0.)
+ {
+   fprintf(STDERR, "*** error (crfac): R factor evaluation failed\n");
+   exit(1);
+ }
  rr = R_sqrt(args.vi * 8. / e_range);
 
+/* residuals of Rp for least squares fits (csearch -s lm) */
+ if(args.yfile != NULL && cr_yres(iv_cur, &args, s_min, args.yfile) < 0)
+ {
+   fprintf(STDERR, "*** error (crfac): cannot write residuals\n");
+   exit(1);
+ }
+
 #ifdef CONTROL
  if(args.r_type == RP_FACTOR)       fprintf(STDCTR,"Rp = ");
  else if (args.r_type == R1_FACTOR) fprintf(STDCTR,"R1 = ");
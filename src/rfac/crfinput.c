@@ -4,6 +4,9 @@ GH/15.08.95
  file contains function:
 
   struct crivcur *cr_input( char *ctr_file, char *the_file)
+  int cr_input_the( struct crivcur *cur_list, char *the_file)
+  int cr_input_thebuf( struct crivcur *cur_list, char *the_buffer,
+                       struct crivbin *the_bin)
 
  Read all inputs from theoretical and experimental data files
 
@@ -15,10 +18,19 @@ Changes:
  GH/11.08.95 - Creation (copy from rfinput.c)
  GH/15.08.95 - Include the_file in parameter list.
  WB/05.10.98 - cur_list[i_cur -1].group_id = I_END_OF_LIST;
+ LD/19.10.26 - detect binary theoretical input (magic number) and read
+               it through cr_ivbin_open/cr_rdcleed_bin.
+ LD/19.10.26 - keep index lists in cur_list[].the_index and read the
+               theoretical data in cr_input_the(buf), so that new theory
+               files can be read for the same expt. data (crfac --serve).
+               the_file = NULL: read control file and expt. data only.
+ LD/19.10.26 - eng_0 without "e0=" is taken from each new theoretical
+               input, not only from the first one (eng_0_the).
  
 *********************************************************************/
 
 #include <math.h>
+#include <string.h>
 #include <strings.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -68,6 +80,9 @@ ef=/usr/leed/RU001/Ru001cl.iv2:ti=(-1.,2.)         :id=12:wt=1.
 ef=/usr/leed/RU001/Ru001cl.iv3:ti=(-2.,2.)+(2.,-2.):id=11:wt=1.
 --- End of File ---
 
+If the_file is NULL, only the control file and the experimental data
+are read; the theoretical data can be read later by cr_input_the.
+
 return value: pointer to a list of IV curves (struct crivcur *cur_list).
               This list is terminated by the value I_END_OF_LIST in 
 	      cur_list[i+1].group_id.
@@ -81,23 +96,11 @@ long offs;
 
 struct crivcur *cur_list;   /* list of IV curves */
 char *ctr_buffer;           /* buffer for control file */
-char *the_buffer;           /* buffer for theoretical input file */
 char line_buffer[STRSZ],    /* buffer for a single command line */
      exp_file[STRSZ],       /* name of experimental input file */ 
      index_list[STRSZ];     /* command line for averaging theoretical
 			       indices */
 
-/*********************************************************************
- Copy theoretical input file to the_buffer
- first free previously allocated memory.
-*********************************************************************/
-
-#ifdef CONTROL
- fprintf(STDCTR,"(cr_input): read theoretical data from \"%s\"\n", the_file);
-#endif
- the_buffer = file2buffer(the_file);
- 
-
 /*********************************************************************
  Copy control file to ctr_buffer
  count lines without comments (i.e. number of IV curves to compare)
@@ -113,7 +116,8 @@ char line_buffer[STRSZ],    /* buffer for a single command line */
 #ifdef CONTROL_X
  fprintf(STDCTR,"(cr_input): n_cur = %d\n", n_cur);
 #endif
- cur_list = (struct crivcur *) calloc(n_cur, sizeof(struct crivcur));
+ /* one extra element: the lists are reset for i_cur = n_cur at the end */
+ cur_list = (struct crivcur *) calloc(n_cur + 1, sizeof(struct crivcur));
 
 /*********************************************************************
  Scan through control file.
@@ -130,6 +134,7 @@ char line_buffer[STRSZ],    /* buffer for a single command line */
    /* initialise variables */
    exp_file[0] = '\0';
    cur_list[i_cur].eng_0 = 0.;
+   cur_list[i_cur].eng_0_the = 0;
    cur_list[i_cur].group_id = DEFAULT_GROUP_ID;
    cur_list[i_cur].weight = 1.;
 
@@ -163,30 +168,21 @@ char line_buffer[STRSZ],    /* buffer for a single command line */
 	      && (line_buffer[i] != ' '); j++, i++)
          { index_list[j] = line_buffer[i]; }
          index_list[j] = '\0';
-  
-         if (the_buffer == NULL)
+
+  /* 
+     Theoretical IV curves are read by cr_input_the (below).
+  */
+         free(cur_list[i_cur].the_index);
+         cur_list[i_cur].the_index =
+             (char *)malloc(strlen(index_list) + 1);
+         if (cur_list[i_cur].the_index == NULL)
          {
            #ifdef ERROR
-           fprintf(STDERR,
-                  "(cr_input): *** No theoretical input file present \"%s\"\n",
-	          index_list);
+           fprintf(STDERR, "*** error (cr_input): allocation error\n");
            #endif
            exit(1);
          }
-         else
-         {
-           cur_list[i_cur].the_list = 
-                cr_rdcleed(
-                        cur_list+i_cur, /* IV curve structure */
-                        the_buffer,      /* theoretical input */
-                        index_list);     /* control list for beam average */
-    /* 
-       If the energy of appearance is not specified, use first energy
-       in the theoretical file.
-    */
-           if ( IS_EQUAL_REAL(cur_list[i_cur].eng_0, 0.)) 
-           {  cur_list[i_cur].eng_0 = cur_list[i_cur].the_first_eng; }
-         }
+         strcpy(cur_list[i_cur].the_index, index_list);
        }/* if "ti=" */
 
 /* id: group ID */
@@ -248,10 +244,126 @@ char line_buffer[STRSZ],    /* buffer for a single command line */
  cur_list[i_cur -1].group_id = I_END_OF_LIST;
 
 /*
- free previously allocated memory.
+ Read theoretical IV curves, free previously allocated memory.
  return.
 */
- free(the_buffer);
  free(ctr_buffer);
+
+ if (the_file != NULL)
+ {
+   if (cr_input_the(cur_list, the_file) != 0) exit(1);
+ }
+
  return(cur_list);
-}   /* end of function */
+}   /* end of function cr_input */
+
+/*======================================================================*/
+
+int cr_input_the( struct crivcur *cur_list, char *the_file)
+
+/*********************************************************************
+ Read theoretical IV curves from the_file for all curves in cur_list
+ (as set up by cr_input). Previous theoretical curves are replaced.
+ Binary input files (magic number, see cleed_ivbin.h) are mapped.
+
+ return value: 0 if successful, -1 if failed.
+*********************************************************************/
+{
+int ret;
+char *the_buffer;           /* buffer for theoretical input file */
+struct crivbin *the_bin;    /* binary theoretical input file */
+
+#ifdef CONTROL
+ fprintf(STDCTR,"(cr_input_the): read theoretical data from \"%s\"\n",
+         the_file);
+#endif
+
+ the_buffer = NULL;
+ the_bin = NULL;
+ if (cr_ivbin_check(the_file))
+ {
+   if ((the_bin = cr_ivbin_open(the_file)) == NULL) return(-1);
+ }
+ else
+ {
+   the_buffer = file2buffer(the_file);
+ }
+
+ ret = cr_input_thebuf(cur_list, the_buffer, the_bin);
+
+ free(the_buffer);
+ cr_ivbin_close(the_bin);
+ return(ret);
+}   /* end of function cr_input_the */
+
+/*======================================================================*/
+
+int cr_input_thebuf( struct crivcur *cur_list, char *the_buffer,
+                     struct crivbin *the_bin)
+
+/*********************************************************************
+ Read theoretical IV curves for all curves in cur_list from a text
+ buffer (the_buffer, CLEED format) or from a binary IV file (the_bin,
+ used if not NULL). The beams are selected through the index lists
+ stored in cur_list[].the_index by cr_input. Previous theoretical
+ curves are freed and the smoothing/spline flags are reset.
+
+ If the energy of appearance was not specified in the control file,
+ the first energy in the theoretical file is used (again for every
+ new theoretical input, whose energy range may differ).
+
+ return value: 0 if successful, -1 if failed.
+*********************************************************************/
+{
+int i_cur;
+
+ if (the_bin == NULL && the_buffer == NULL)
+ {
+   #ifdef ERROR
+   fprintf(STDERR,
+          "*** error (cr_input_thebuf): No theoretical input present\n");
+   #endif
+   return(-1);
+ }
+
+ for (i_cur = 0; cur_list[i_cur].group_id != I_END_OF_LIST; i_cur ++)
+ {
+   if (cur_list[i_cur].the_index == NULL) continue;
+
+   free(cur_list[i_cur].the_list);
+   cur_list[i_cur].the_smooth = 0;
+   cur_list[i_cur].the_spline = 0;
+
+   if (the_bin != NULL)
+     cur_list[i_cur].the_list = 
+          cr_rdcleed_bin(
+                  cur_list+i_cur,            /* IV curve structure */
+                  the_bin,                   /* binary theoretical input */
+                  cur_list[i_cur].the_index);/* control list for average */
+   else
+     cur_list[i_cur].the_list = 
+          cr_rdcleed(
+                  cur_list+i_cur,            /* IV curve structure */
+                  the_buffer,                /* theoretical input */
+                  cur_list[i_cur].the_index);/* control list for average */
+
+   if (cur_list[i_cur].the_list == NULL) return(-1);
+   if (cur_list[i_cur].the_leng < 2)
+   {
+     #ifdef ERROR
+     fprintf(STDERR, "*** error (cr_input_thebuf): "
+             "less than two energies for \"%s\"\n", cur_list[i_cur].the_index);
+     #endif
+     return(-1);
+   }
+
+   if ( cur_list[i_cur].eng_0_the ||
+        IS_EQUAL_REAL(cur_list[i_cur].eng_0, 0.)) 
+   {
+     cur_list[i_cur].eng_0 = cur_list[i_cur].the_first_eng;
+     cur_list[i_cur].eng_0_the = 1;
+   }
+ }
+
+ return(0);
+}   /* end of function cr_input_thebuf */
@@ -4,14 +4,15 @@ file contains function:
 
   int cr_mklide(real *eng, real *e_int, real *t_int, 
                 read de, real shift,
-                struct crelist *exp_list, int exp_leng,
-                struct crelist *the_list, int the_leng)
+                const struct crspline *spl, int i_exp, int i_the)
 
  Prepare R factor calculations
 
  Changes:
 
  GH/29.08.95 - Creation.
+ LD/19.10.26 - Evaluate curves of struct crspline through monotone
+               cursors (no bisection per energy point).
 
 ********************************************************************/
 #include <math.h>
@@ -27,8 +28,7 @@ file contains function:
 
 int cr_mklide(real *eng, real *e_int, real *t_int, 
               real de, real shift,
-              struct crelist *exp_list, int exp_leng,
-              struct crelist *the_list, int the_leng)
+              const struct crspline *spl, int i_exp, int i_the)
 
 /********************************************************************
  First stage of cubic spline
@@ -47,19 +47,18 @@ INPUT:
  real de - (input) step for energy axis.
  real shift - (input) offset between experimental and theoretical 
               energy axes (Et = Ee - shift).
- struct crelist *exp_list - (input) list of energy/intensity/deriv2
-          values to be interpolated by cubic spline.
- int exp_leng - (input) number of elements in exp_list.
-
- struct crelist *the_list - (input) list of energy/intensity/deriv2
-          values to be interpolated by cubic spline.
- int the_leng - (input) number of elements in exp_list.
+ const struct crspline *spl - (input) energy/intensity/deriv2 values
+          of all curves to be interpolated by cubic spline.
+ int i_exp - (input) number of the expt. curve in spl.
+ int i_the - (input) number of the theor. curve in spl.
 
 DESIGN:
 
+ The energies are increasing, therefore both curves are evaluated
+ through cursors (cr_splcur_eval) which only move forward.
+
 NOTE:
- The lists exp_list and the_list must be prepared for a cubic spline;
- i.e. the structure elements deriv2 must exist.
+ The second derivatives in spl must be prepared (cr_spline_prep).
  
  Enough memory for eng, e_int, and t_int must be allocated.
 
@@ -69,31 +68,42 @@ RETURN VALUE:
 ********************************************************************/
 {
 int i_elo, n_eng;
+int exp_leng, the_leng;
 real energy;
 real e_max = 0., t_max = 0.;
+const real *exp_eng, *the_eng;
+struct crsplcur exp_cur, the_cur;
 
 #ifdef WRITE
 FILE *str_e_int, *str_t_int;
 #endif
 
+ cr_splcur_init(&exp_cur, spl, i_exp);
+ cr_splcur_init(&the_cur, spl, i_the);
+ exp_eng = exp_cur.energy;
+ the_eng = the_cur.energy;
+ exp_leng = exp_cur.leng;
+ the_leng = the_cur.leng;
+ if( (exp_leng < 1) || (the_leng < 1) ) return(0);
+
 /* Find first expt. energy (i_elo) within the theor. energy range */
  for( i_elo = 0; 
       (i_elo < exp_leng) &&
-      ( (exp_list+i_elo)->energy < (the_list->energy - shift) );
+      ( exp_eng[i_elo] < (the_eng[0] - shift) );
       i_elo ++)
  { ; }
 /* Return zero if no overlap */
  if(i_elo == exp_leng) return(0); 
 
 /* Write lists eng, e_int/2 */
- for(energy = (exp_list+i_elo)->energy, n_eng = 0;
-     (energy <= (exp_list+exp_leng-1)->energy) && 
-     (energy < ((the_list+the_leng-1)->energy - shift) );
+ for(energy = exp_eng[i_elo], n_eng = 0;
+     (energy <= exp_eng[exp_leng-1]) && 
+     (energy < (the_eng[the_leng-1] - shift) );
      energy += de, n_eng ++)
  {
    eng[n_eng]  = energy;
-   e_int[n_eng] = cr_splint(eng[n_eng],         exp_list, exp_leng);
-   t_int[n_eng] = cr_splint(eng[n_eng] - shift, the_list, the_leng);
+   e_int[n_eng] = cr_splcur_eval(&exp_cur, eng[n_eng]);
+   t_int[n_eng] = cr_splcur_eval(&the_cur, eng[n_eng] - shift);
    e_max = MAX(e_int[n_eng], e_max);
    t_max = MAX(t_int[n_eng], t_max);
  }
@@ -103,7 +113,7 @@ FILE *str_e_int, *str_t_int;
  t_int[n_eng] = F_END_OF_LIST;
 
 #ifdef CONTROL
- fprintf(STDCTR,"(cr_mklist): (exp) n_eng: %d\n", n_eng);
+ fprintf(STDCTR,"(cr_mklide): (exp) n_eng: %d\n", n_eng);
 #endif
  
 #ifdef WRITE
@@ -118,5 +128,5 @@ FILE *str_e_int, *str_t_int;
 #endif
 
  return(n_eng);
-}  /* end of function cr_mklist */
+}  /* end of function cr_mklide */
 /********************************************************************/
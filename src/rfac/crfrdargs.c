@@ -9,6 +9,9 @@ Changes:
   GH/27.10.92 - Creation
   GH/30.08.95 - Adaptation to CRFAC
   LD/07.03.14 - Added POSIX style arguments
+  LD/19.10.26 - --serve [<socket>]: resident R factor service;
+                check for theoretical input file.
+  LD/19.10.26 - -y <file>: residuals of Rp for least squares fits.
 *********************************************************************/
 #include <math.h>
 #include <stdio.h>
@@ -81,6 +84,11 @@ struct crargs cr_rdargs (int argc, char **argv)
   -w <filename>: specify file name for iv curves output.
              program parameter: iv_file.
 
+  --yres
+  -y <filename>: write the residuals of Rp (Y function differences)
+             for the best shift to a file (only with -r rp).
+             program parameter: yfile.
+
 
   output: argument list.
 	  function exits if any error occured.
@@ -109,6 +117,10 @@ structure containing all program parameters:
 *********************************************************************/
 
   args.ctrfile = NULL;
+  args.thefile = NULL;
+
+  args.serve = 0;                  /* default: single R factor evaluation */
+  args.sockfile = NULL;            /* service reads from stdin */
 
   args.s_ini = -10.;
   args.s_fin =  10.;
@@ -124,10 +136,11 @@ structure containing all program parameters:
 
   args.outfile = NULL;             /* will be treated as "stdout" */
 
+  args.yfile = NULL;               /* default: no residuals */
+
 /*********************************************************************
  decode arguments 
 *********************************************************************/
-  printf("got here\n");
   if( argc == 1)
   {
     rf_help(stderr);
@@ -306,6 +319,17 @@ structure containing all program parameters:
         }
       } /* case s */
 
+      else if (ARG_IS("--serve"))
+      {
+        /*
+          --serve [<socket>]: keep expt. data in memory and evaluate
+                  theoretical input files given on stdin or through
+                  the Unix domain socket <socket> (see crfserve.c).
+        */
+        args.serve = 1;
+        if ((i+1 < argc) && (argv[i+1][0] != '-')) args.sockfile = argv[++i];
+      } /* case serve */
+
       else if (ARG_IS("-t") || ARG_IS("--theory"))
       {
         /*
@@ -363,6 +387,21 @@ structure containing all program parameters:
         }
       } /* case w */
 
+      else if (ARG_IS("-y") || ARG_IS("--yres"))
+      {
+        /*
+         -y <filename>: write residuals of Rp for the best shift
+        */
+        if (++i < argc) args.yfile = argv[i];
+        else
+        {
+          fprintf(stderr, 
+            " *** error in argument list: missing argument for \"%s\"\n",
+            argv[i-1]);
+          exit(1);
+        }
+      } /* case y */
+
       else if (ARG_IS("-V") || ARG_IS("--version"))
       {
         rf_info();
@@ -393,6 +432,21 @@ structure containing all program parameters:
     exit(1);
   }
 
+  if (args.thefile == NULL && !args.serve)
+  {
+    fprintf(stderr, 
+            " *** error in argument list: No theoretical input file specified\n");
+    fprintf(stderr, "     use option -t to specify\n");
+    exit(1);
+  }
+
+  if (args.yfile != NULL && args.r_type != RP_FACTOR)
+  {
+    fprintf(stderr, 
+            " *** error in argument list: option -y requires -r rp\n");
+    exit(1);
+  }
+
   return (args);
 }
 /********************************************************************/
@@ -0,0 +1,573 @@
+/********************************************************************
+LD/19.10.26
+
+  file contains functions:
+
+  int cr_ivbin_check( const char *filename)
+  struct crivbin *cr_ivbin_open( const char *filename)
+  struct crivbin *cr_ivbin_from_buffer( char *buffer, long buf_len)
+  void cr_ivbin_close( struct crivbin *ivbin)
+  struct crelist *cr_rdcleed_bin( struct crivcur *iv_cur,
+                                  struct crivbin *ivbin,
+                                  char *index_list )
+  int cr_ivbin_write_text( struct crivbin *ivbin, FILE *outfile)
+
+ Read theoretical IV curves from a binary (columnar) results file
+ written by the LEED programs with option -B. The file layout is
+ described in "cleed_ivbin.h".
+
+ Changes:
+
+ LD/19.10.26 - Creation (binary counterpart of crfrdcleed.c)
+ LD/19.10.26 - cr_ivbin_from_buffer: binary IV data received in memory
+               (crfac --serve).
+ LD/19.10.26 - ivbin_setup: the beam and energy counts of the header are
+               checked against the file size before the data offset and
+               the file size are computed (in size_t).
+
+********************************************************************/
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "crfac.h"       /* rf specific definitions */
+#include "cleed_ivbin.h"
+
+/*
+#define CONTROL
+*/
+
+#define WARNING
+#define ERROR
+
+/*======================================================================*/
+
+static unsigned long ivbin_get_u32(const char *buf)
+{
+  const unsigned char *b = (const unsigned char *)buf;
+  return( (unsigned long)b[0]         | ((unsigned long)b[1] << 8) |
+         ((unsigned long)b[2] << 16) | ((unsigned long)b[3] << 24) );
+}
+
+static double ivbin_get_f64(const char *buf)
+{
+  int i;
+  unsigned long long bits;
+  double val;
+  const unsigned char *b = (const unsigned char *)buf;
+
+  bits = 0;
+  for(i = 7; i >= 0; i--) bits = (bits << 8) | b[i];
+  memcpy(&val, &bits, 8);
+  return(val);
+}
+
+static int ivbin_host_is_le(void)
+{
+  const unsigned short one = 1;
+  return( *(const unsigned char *)&one == 1 );
+}
+
+/*======================================================================*/
+
+static struct crivbin *ivbin_setup(struct crivbin *ivbin,
+                                   const char *filename)
+
+/*********************************************************************
+ Check the header of the file in ivbin->map and set up the pointers
+ to beam records, energies and intensities. ivbin is closed if the
+ check fails.
+*********************************************************************/
+{
+  long i_val, n_val;
+  unsigned long n_beam, n_eng;
+  size_t map_len, data_offs;
+  double *swapped;
+
+/********************************************************************
+ Check header
+********************************************************************/
+
+  if( (ivbin->map_len < IVBIN_HEAD_SIZE) ||
+      (memcmp(ivbin->map, IVBIN_MAGIC, IVBIN_MAGIC_LEN) != 0) )
+  {
+    #ifdef ERROR
+    fprintf(STDERR, "*** error (cr_ivbin_open): \"%s\" is not a binary "
+            "IV file\n", filename);
+    #endif
+    cr_ivbin_close(ivbin);
+    return(NULL);
+  }
+
+  if( ivbin_get_u32(ivbin->map + IVBIN_OFFS_VERSION) != IVBIN_VERSION )
+  {
+    #ifdef ERROR
+    fprintf(STDERR, "*** error (cr_ivbin_open): unsupported version %lu "
+            "in \"%s\"\n", ivbin_get_u32(ivbin->map + IVBIN_OFFS_VERSION),
+            filename);
+    #endif
+    cr_ivbin_close(ivbin);
+    return(NULL);
+  }
+
+/*
+  The counts are checked against the file size one at a time, so that
+  the products below cannot overflow for a corrupt (or crafted) header:
+  n_beam beam records must fit behind the header, n_eng energies and
+  n_beam * n_eng intensities behind the beam records.
+*/
+  map_len = (size_t)ivbin->map_len;
+  n_beam = ivbin_get_u32(ivbin->map + IVBIN_OFFS_N_BEAM);
+  n_eng  = ivbin_get_u32(ivbin->map + IVBIN_OFFS_N_ENG);
+  data_offs = 0;
+
+  if( (n_beam <= (unsigned long)INT_MAX - 1) &&
+      (n_beam <= (map_len - IVBIN_HEAD_SIZE) / IVBIN_BEAM_SIZE) )
+    data_offs = IVBIN_DATA_OFFSET(n_beam);
+
+  if( (data_offs == 0) ||
+      (ivbin_get_u32(ivbin->map + IVBIN_OFFS_DATA) != data_offs) ||
+      (n_eng > (unsigned long)INT_MAX) ||
+      (n_eng > (map_len - data_offs) / 8 / (n_beam + 1)) )
+  {
+    #ifdef ERROR
+    fprintf(STDERR, "*** error (cr_ivbin_open): inconsistent header or "
+            "truncated file \"%s\"\n", filename);
+    #endif
+    cr_ivbin_close(ivbin);
+    return(NULL);
+  }
+
+  ivbin->n_beam = (int)n_beam;
+  ivbin->n_eng  = (int)n_eng;
+  ivbin->e_ini  = ivbin_get_f64(ivbin->map + IVBIN_OFFS_E_INI);
+  ivbin->e_fin  = ivbin_get_f64(ivbin->map + IVBIN_OFFS_E_FIN);
+  ivbin->e_stp  = ivbin_get_f64(ivbin->map + IVBIN_OFFS_E_STP);
+  ivbin->beams = ivbin->map + IVBIN_HEAD_SIZE;
+
+  if( ivbin_host_is_le() )
+  {
+    ivbin->energy = (const double *)
+                    (ivbin->map + IVBIN_DATA_OFFSET(ivbin->n_beam));
+  }
+  else
+  {
+    n_val = (long)ivbin->n_eng * (ivbin->n_beam + 1);
+    swapped = (double *)malloc((n_val + 1) * sizeof(double));
+    if( swapped == NULL )
+    {
+      #ifdef ERROR
+      fprintf(STDERR, "*** error (cr_ivbin_open): allocation error\n");
+      #endif
+      cr_ivbin_close(ivbin);
+      return(NULL);
+    }
+    for(i_val = 0; i_val < n_val; i_val ++)
+      swapped[i_val] = ivbin_get_f64(ivbin->map +
+                         IVBIN_DATA_OFFSET(ivbin->n_beam) + 8*i_val);
+    ivbin->energy = swapped;
+  }
+  ivbin->intens = ivbin->energy + ivbin->n_eng;
+
+  #ifdef CONTROL
+  fprintf(STDCTR, "(cr_ivbin_open): \"%s\": %d beams, %d energies (%s)\n",
+          filename, ivbin->n_beam, ivbin->n_eng,
+          ivbin->mapped ? "mapped" : "read");
+  #endif
+
+  return(ivbin);
+}  /* end of function ivbin_setup */
+
+/*======================================================================*/
+
+int cr_ivbin_check( const char *filename)
+
+/*********************************************************************
+ Check whether a file starts with the magic number of the binary IV
+ format.
+
+ return value: 1 if the file is a binary IV file, 0 otherwise (this
+               includes files that cannot be opened).
+*********************************************************************/
+{
+  char magic[IVBIN_MAGIC_LEN];
+  FILE *in_stream;
+  int ret;
+
+  if( (in_stream = fopen(filename, "rb")) == NULL) return(0);
+
+  ret = ( (fread(magic, 1, IVBIN_MAGIC_LEN, in_stream) == IVBIN_MAGIC_LEN) &&
+          (memcmp(magic, IVBIN_MAGIC, IVBIN_MAGIC_LEN) == 0) );
+
+  fclose(in_stream);
+  return(ret);
+}  /* end of function cr_ivbin_check */
+
+/*======================================================================*/
+
+struct crivbin *cr_ivbin_open( const char *filename)
+
+/*********************************************************************
+ Map a binary IV file into memory and check its header.
+
+ The file is memory mapped read-only if possible, otherwise it is
+ read into a buffer. On little-endian hosts the energy and intensity
+ columns are used in place; on big-endian hosts they are converted
+ into a separate buffer.
+
+ return value: pointer to structure crivbin.
+               NULL, if failed.
+*********************************************************************/
+{
+  long file_len;
+  struct crivbin *ivbin;
+  FILE *in_stream;
+
+  ivbin = (struct crivbin *)calloc(1, sizeof(struct crivbin));
+  if( ivbin == NULL )
+  {
+    #ifdef ERROR
+    fprintf(STDERR, "*** error (cr_ivbin_open): allocation error\n");
+    #endif
+    return(NULL);
+  }
+
+/********************************************************************
+ Map file (or read it to a buffer)
+********************************************************************/
+
+  #if !defined(_WIN32)
+  {
+    int fd;
+    struct stat st;
+
+    if( ((fd = open(filename, O_RDONLY)) != -1) && (fstat(fd, &st) == 0) &&
+        (st.st_size >= IVBIN_HEAD_SIZE) )
+    {
+      ivbin->map = (char *)mmap(NULL, (size_t)st.st_size, PROT_READ,
+                                MAP_PRIVATE, fd, 0);
+      if( ivbin->map == (char *)MAP_FAILED ) ivbin->map = NULL;
+      else
+      {
+        ivbin->map_len = (long)st.st_size;
+        ivbin->mapped = 1;
+        #ifdef MADV_SEQUENTIAL
+        madvise(ivbin->map, (size_t)st.st_size, MADV_SEQUENTIAL);
+        #endif
+      }
+    }
+    if( fd != -1 ) close(fd);
+  }
+  #endif
+
+  if( ivbin->map == NULL )
+  {
+    if( (in_stream = fopen(filename, "rb")) == NULL )
+    {
+      #ifdef ERROR
+      fprintf(STDERR, "*** error (cr_ivbin_open): could not open \"%s\"\n",
+              filename);
+      #endif
+      free(ivbin);
+      return(NULL);
+    }
+
+    fseek(in_stream, 0L, SEEK_END);
+    file_len = ftell(in_stream);
+    fseek(in_stream, 0L, SEEK_SET);
+
+    ivbin->map = (char *)malloc((size_t)file_len + 1);
+    if( (ivbin->map == NULL) ||
+        ((long)fread(ivbin->map, 1, (size_t)file_len, in_stream) != file_len) )
+    {
+      #ifdef ERROR
+      fprintf(STDERR, "*** error (cr_ivbin_open): could not read \"%s\"\n",
+              filename);
+      #endif
+      fclose(in_stream);
+      free(ivbin->map);
+      free(ivbin);
+      return(NULL);
+    }
+    fclose(in_stream);
+    ivbin->map_len = file_len;
+    ivbin->mapped = 0;
+  }
+
+  return(ivbin_setup(ivbin, filename));
+}  /* end of function cr_ivbin_open */
+
+/*======================================================================*/
+
+struct crivbin *cr_ivbin_from_buffer( char *buffer, long buf_len)
+
+/*********************************************************************
+ Use a binary IV file that has been read into memory (e.g. received
+ through a pipe). buffer must be allocated by malloc; it is owned by
+ the returned structure and freed by cr_ivbin_close (also if the
+ header check fails).
+
+ return value: pointer to structure crivbin.
+               NULL, if failed.
+*********************************************************************/
+{
+  struct crivbin *ivbin;
+
+  ivbin = (struct crivbin *)calloc(1, sizeof(struct crivbin));
+  if( ivbin == NULL )
+  {
+    #ifdef ERROR
+    fprintf(STDERR, "*** error (cr_ivbin_from_buffer): allocation error\n");
+    #endif
+    free(buffer);
+    return(NULL);
+  }
+
+  ivbin->map = buffer;
+  ivbin->map_len = buf_len;
+  ivbin->mapped = 0;
+
+  return(ivbin_setup(ivbin, "(buffer)"));
+}  /* end of function cr_ivbin_from_buffer */
+
+/*======================================================================*/
+
+void cr_ivbin_close( struct crivbin *ivbin)
+
+/*********************************************************************
+ Unmap (or free) a binary IV file opened by cr_ivbin_open.
+*********************************************************************/
+{
+  if( ivbin == NULL ) return;
+
+  if( (ivbin->energy != NULL) && (ivbin->map != NULL) &&
+      ((const char *)ivbin->energy !=
+         ivbin->map + IVBIN_DATA_OFFSET(ivbin->n_beam)) )
+    free((void *)ivbin->energy);
+
+  #if !defined(_WIN32)
+  if( ivbin->mapped ) munmap(ivbin->map, (size_t)ivbin->map_len);
+  else
+  #endif
+    free(ivbin->map);
+
+  free(ivbin);
+}  /* end of function cr_ivbin_close */
+
+/*======================================================================*/
+
+struct crelist *cr_rdcleed_bin( struct crivcur *iv_cur,
+                                struct crivbin *ivbin,
+                                char *index_list )
+
+/*********************************************************************
+ Read theoretical IV curves for the beams listed in index_list from a
+ binary IV file. Apart from the input this function is equivalent to
+ cr_rdcleed.
+
+ parameters: - iv_cur: pointer to structure crivcur. All available
+             information about the theoretical IV curve will be
+             stored in this structure. sort and equidist flags will be
+             set.
+             - ivbin: binary IV file opened by cr_ivbin_open.
+             - index_list: command line for interpreter rfintindl.
+
+ return value: pointer to the IV curve (struct crelist). The
+               list is terminated by a pair of negative values.
+               NULL, if failed;
+*********************************************************************/
+{
+  int i_eng, i_list, i_beam;
+  int n_beam, n_eng;
+
+  real max_int,                    /* list of max. intensity */
+       int_sum;                    /* sum of all intensities */
+
+  const double *col;
+
+  struct crelist *list;
+  struct rfspot *beam;
+
+  n_beam = ivbin->n_beam;
+  n_eng  = ivbin->n_eng;
+
+/********************************************************************
+ Read beam indices and call cr_intindl
+********************************************************************/
+
+  beam = (struct rfspot *) calloc( n_beam+1, sizeof(struct rfspot));
+  list = (struct crelist *) malloc( (n_eng+1)*sizeof(struct crelist));
+
+  if( (beam == NULL) || (list == NULL) )
+  {
+    #ifdef ERROR
+    fprintf(STDERR, "*** error (cr_rdcleed_bin): allocation error\n");
+    #endif
+    exit(1);
+  }
+
+  for(i_beam = 0; i_beam < n_beam; i_beam ++)
+  {
+    beam[i_beam].index1 =
+      (real)ivbin_get_f64(ivbin->beams + i_beam*IVBIN_BEAM_SIZE);
+    beam[i_beam].index2 =
+      (real)ivbin_get_f64(ivbin->beams + i_beam*IVBIN_BEAM_SIZE + 8);
+  }
+
+  cr_intindl(index_list, beam, n_beam);
+
+/********************************************************************
+ Sum up the weighted intensity columns (f_val1 = scaling factor).
+ Only beams contributing to the average are touched.
+********************************************************************/
+
+  for(i_eng = 0; i_eng < n_eng; i_eng ++)
+  {
+    list[i_eng].energy = (real)ivbin->energy[i_eng];
+    list[i_eng].intens = 0.;
+  }
+
+  for(i_beam = 0; i_beam < n_beam; i_beam ++)
+  {
+    if( IS_EQUAL_REAL(beam[i_beam].f_val1, 0.) ) continue;
+
+    col = ivbin->intens + (long)i_beam * n_eng;
+    for(i_eng = 0; i_eng < n_eng; i_eng ++)
+      list[i_eng].intens += beam[i_beam].f_val1 * (real)col[i_eng];
+  }
+
+/********************************************************************
+ Skip leading zeros, check maximum, order and equidistance
+ (same rules as in cr_rdcleed).
+********************************************************************/
+
+  iv_cur->the_sort = 1;              /* reset sort flag */
+  iv_cur->the_equidist = 1;          /* reset equidistance flag */
+
+  max_int = 0.;
+  int_sum = 0.;
+
+  for(i_eng = 0, i_list = 0; i_eng < n_eng; i_eng ++)
+  {
+    list[i_list] = list[i_eng];
+
+    if ( list[i_list].intens > max_int )
+      max_int = list[i_list].intens;
+
+    int_sum += list[i_list].intens;
+
+    if( int_sum > ZERO_TOLERANCE)
+    {
+      if( (i_list > 0) && (list[i_list].energy < list[i_list-1].energy) )
+        iv_cur->the_sort = 0;
+
+      if( (i_list > 1) &&
+          (R_fabs((2*list[i_list-1].energy -
+             list[i_list].energy - list[i_list-2].energy)) >  ENG_TOLERANCE ))
+      {
+        iv_cur->the_equidist = 0;
+
+        #ifdef WARNING
+        fprintf(STDWAR, "* warning (cr_rdcleed_bin): "
+                "theor. input is not equidistant (Eng:%.1f)\n",
+                list[i_list-1].energy);
+        #endif
+      }
+      i_list ++;
+    }
+    else
+    {
+      int_sum = 0.;
+    }
+  }  /* for i_eng */
+
+  iv_cur->the_leng = i_list;
+  iv_cur->the_first_eng = list[0].energy;
+  iv_cur->the_last_eng = (i_list > 0) ? list[i_list-1].energy : list[0].energy;
+  iv_cur->the_max_int = max_int;
+
+/*
+ Find beam with maximum contribution to average.
+ This beam will be used as spot ID.
+*/
+  iv_cur->spot_id.f_val1 = R_fabs(beam[0].f_val1);
+  iv_cur->spot_id.i_val1 = 0;
+
+  for (i_beam=1; i_beam < n_beam; i_beam ++)
+  {
+    if (R_fabs(beam[i_beam].f_val1) > iv_cur->spot_id.f_val1 )
+    {
+      iv_cur->spot_id.f_val1 = R_fabs(beam[i_beam].f_val1);
+      iv_cur->spot_id.i_val1 = i_beam;
+    }
+  }
+
+  iv_cur->spot_id.index1 = beam[iv_cur->spot_id.i_val1].index1;
+  iv_cur->spot_id.index2 = beam[iv_cur->spot_id.i_val1].index2;
+  free(beam);
+
+  #ifdef CONTROL
+  fprintf(STDCTR,"(cr_rdcleed_bin): spot_id: (%5.2f,%5.2f), %d energies\n",
+          iv_cur->spot_id.index1, iv_cur->spot_id.index2, i_list);
+  #endif
+
+/*
+ set last energy and intensities to termination value
+*/
+  list[i_list].energy = F_END_OF_LIST;
+  list[i_list].intens = F_END_OF_LIST;
+
+  return(list);
+}  /* end of function cr_rdcleed_bin */
+
+/*======================================================================*/
+
+int cr_ivbin_write_text( struct crivbin *ivbin, FILE *outfile)
+
+/*********************************************************************
+ Write the contents of a binary IV file in the text format of the
+ LEED programs ("#en", "#bn", "#bi" header lines followed by one line
+ per energy).
+
+ return value: number of energies written.
+*********************************************************************/
+{
+  int i_eng, i_beam;
+  const char *rec;
+
+  fprintf(outfile, "# converted from binary IV file (version %d)\n",
+          IVBIN_VERSION);
+  fprintf(outfile, "#en %d %f %f %f\n",
+          ivbin->n_eng, ivbin->e_ini, ivbin->e_fin, ivbin->e_stp);
+  fprintf(outfile, "#bn %d\n", ivbin->n_beam);
+
+  for(i_beam = 0; i_beam < ivbin->n_beam; i_beam ++)
+  {
+    rec = ivbin->beams + i_beam*IVBIN_BEAM_SIZE;
+    fprintf(outfile, "#bi %d %f %f %d\n",
+            i_beam, ivbin_get_f64(rec), ivbin_get_f64(rec + 8),
+            (int)ivbin_get_u32(rec + 16));
+  }
+
+  for(i_eng = 0; i_eng < ivbin->n_eng; i_eng ++)
+  {
+    fprintf(outfile, "%.2f ", ivbin->energy[i_eng]);
+    for(i_beam = 0; i_beam < ivbin->n_beam; i_beam ++)
+      fprintf(outfile, "%.6e ", ivbin->intens[(long)i_beam*ivbin->n_eng + i_eng]);
+    fprintf(outfile, "\n");
+  }
+
+  return(ivbin->n_eng);
+}  /* end of function cr_ivbin_write_text */
+/********************************************************************/
@@ -13,6 +13,8 @@ GH/11.08.95
 
  GH/11.08.95 - Creation (copy from rfrdvhbeams.c)
  GH/12.10.00 - bug fixed in comparing neng with number of lines.
+ LD/19.10.26 - return NULL instead of exit for inconsistent input
+               (no beams, wrong numbers of beams/energies).
 
 ********************************************************************/
 #include <math.h>
@@ -202,6 +204,16 @@ return value: pointer to the IV curve (struct crelist). The
  - Allocate memory for list
 ********************************************************************/
 
+  if(n_beam <= 0 || beam == NULL)
+  {
+    #ifdef ERROR
+    fprintf(STDERR, "*** error (cr_rdcleed): no beams in input\n");
+    #endif
+    free(beam);
+    free(line_buffer);
+    return(NULL);
+  }
+
   if(i_read != n_beam)
   {
     #ifdef ERROR
@@ -209,7 +221,9 @@ return value: pointer to the IV curve (struct crelist). The
       "*** error (cr_rdcleed): numbers of beams do not match "
       "(read: %d/n_beam: %d)\n", i_read, n_beam);
     #endif
-    exit(1);
+    free(beam);
+    free(line_buffer);
+    return(NULL);
   }
 
   /* Changed 12.10.00: if( (lines = rf_nclines(buffer+offs) ) != n_eng) */
@@ -220,7 +234,9 @@ return value: pointer to the IV curve (struct crelist). The
             "numbers of energies do not match (lines: %d/n_eng: %d)\n",
             lines, n_eng);
     #endif
-    exit(1);
+    free(beam);
+    free(line_buffer);
+    return(NULL);
   }
 
   cr_intindl(index_list, beam, n_beam);
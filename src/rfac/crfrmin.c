@@ -10,6 +10,11 @@ file contains function:
 Changes:
 GH/30.08.95 - Creation
 GH/12.09.95 - Output of IV curves for the best overlap
+LD/19.10.26 - Interpolate via struct crspline (prepared if necessary)
+LD/19.10.26 - Evaluate the pairs (shift, IV curve) in parallel with
+              thread-private lists; summation in fixed order.
+LD/19.10.26 - Return -1. if an allocation fails instead of using NULL
+              pointers (in particular the thread-private lists).
   
 ********************************************************************/
 #include <stdio.h>
@@ -50,18 +55,23 @@ DESIGN:
 
 RETURN VALUE: 
   min. Rp, if successful.
+  -1., if an allocation failed.
 
 ********************************************************************/
 {
 
 int i_list, n_list;
 int i_leng, n_leng;
+int i_shift, n_shift, i_pair;
+int *pair_leng;
+int alloc_err;
 
 real faux;
 real shift;
 real e_range, norm, rfac;
 
 real *eng, *e_int, *t_int;
+real *shift_list, *pair_range, *pair_norm, *pair_rfac;
 
 char linebuffer[STRSZ];
 char r_name[STRSZ];
@@ -97,53 +107,180 @@ FILE *out_stream;
  eng   = (real *)malloc( n_leng * sizeof(real)*13);
  e_int = (real *)malloc( n_leng * sizeof(real)*13);
  t_int = (real *)malloc( n_leng * sizeof(real)*13);
+ if( (eng == NULL) || (e_int == NULL) || (t_int == NULL) )
+ {
+#ifdef ERROR
+   fprintf(STDERR, "*** error (cr_rmin): allocation error\n");
+#endif
+   free(eng);
+   free(e_int);
+   free(t_int);
+   return(-1.);
+ }
+
+/********************************************************************
+  Prepare cubic splines for all curves (if not done by the caller)
+********************************************************************/
+
+ if(n_list > 0 && iv_cur->spline == NULL)
+ {
+   if(cr_spline_setup(iv_cur) == NULL)
+   {
+#ifdef ERROR
+     fprintf(STDERR, "*** error (cr_rmin): spline preparation failed\n");
+#endif
+     exit(1);
+   }
+ }
 
 /********************************************************************
   Scan through shift and find min. R factor
+
+  The pairs (shift, IV curve) are independent and are evaluated in
+  parallel; each thread uses its own lists eng_p/e_int_p/t_int_p.
+  A thread whose lists could not be allocated skips its pairs and sets
+  alloc_err; the function then returns -1.
+  The contributions are stored per pair and summed afterwards in the
+  original order (shift, then i_list), i.e. the result does not depend
+  on the number of threads.
 ********************************************************************/
 
- *p_r_min = 100.;
+ if( (args->r_type != RP_FACTOR) && (args->r_type != R1_FACTOR) &&
+     (args->r_type != R2_FACTOR) && (args->r_type != RB_FACTOR) )
+ {
+#ifdef ERROR
+   fprintf(STDERR,
+   "*** error (cr_rmin): invalid R factor selection %d\n", args->r_type);
+#endif
+   exit(1);
+ }
 
+ n_shift = 0;
  for(shift = args->s_ini; shift <= args->s_fin; shift += args->s_step)
+   n_shift ++;
+
+ shift_list = (real *)malloc( (n_shift + 1) * sizeof(real));
+ pair_leng  = (int *) malloc( (n_shift * n_list + 1) * sizeof(int));
+ pair_range = (real *)malloc( (n_shift * n_list + 1) * sizeof(real));
+ pair_norm  = (real *)malloc( (n_shift * n_list + 1) * sizeof(real));
+ pair_rfac  = (real *)malloc( (n_shift * n_list + 1) * sizeof(real));
+ if( (shift_list == NULL) || (pair_leng == NULL) || (pair_range == NULL) ||
+     (pair_norm == NULL) || (pair_rfac == NULL) )
  {
-   rfac = 0.;
-   norm = 0.;
-   e_range = 0.;
-   for(i_list = 0; i_list < n_list; i_list ++)
+#ifdef ERROR
+   fprintf(STDERR, "*** error (cr_rmin): allocation error\n");
+#endif
+   free(shift_list);
+   free(pair_leng);
+   free(pair_range);
+   free(pair_norm);
+   free(pair_rfac);
+   free(eng);
+   free(e_int);
+   free(t_int);
+   return(-1.);
+ }
+
+ i_shift = 0;
+ for(shift = args->s_ini; shift <= args->s_fin; shift += args->s_step)
+   shift_list[i_shift ++] = shift;
+
+ alloc_err = 0;
+
+#ifdef _USE_OPENMP
+#pragma omp parallel private(i_pair, i_shift, i_list, faux)
+#endif
+ {
+   int n_pt, p_err;
+   real *eng_p, *e_int_p, *t_int_p;
+
+   eng_p   = (real *)malloc( n_leng * sizeof(real)*13);
+   e_int_p = (real *)malloc( n_leng * sizeof(real)*13);
+   t_int_p = (real *)malloc( n_leng * sizeof(real)*13);
+   p_err = (eng_p == NULL) || (e_int_p == NULL) || (t_int_p == NULL);
+   if(p_err)
    {
+#ifdef _USE_OPENMP
+#pragma omp atomic
+#endif
+     alloc_err += 1;
+   }
+
+#ifdef _USE_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+   for(i_pair = 0; i_pair < n_shift * n_list; i_pair ++)
+   {
+     if(p_err) continue;
+     i_shift = i_pair / n_list;
+     i_list  = i_pair % n_list;
 
 #ifdef SHIFT_DE
-     n_leng = cr_mklide(eng, e_int, t_int, args->s_step, shift,
-              (iv_cur+i_list)->exp_list, (iv_cur+i_list)->exp_leng,
-              (iv_cur+i_list)->the_list, (iv_cur+i_list)->the_leng);
+     n_pt = cr_mklide(eng_p, e_int_p, t_int_p, args->s_step,
+              shift_list[i_shift], (iv_cur+i_list)->spline,
+              (iv_cur+i_list)->exp_spl, (iv_cur+i_list)->the_spl);
 #else
-     n_leng = cr_mklist(eng, e_int, t_int, shift,
-              (iv_cur+i_list)->exp_list, (iv_cur+i_list)->exp_leng,
-              (iv_cur+i_list)->the_list, (iv_cur+i_list)->the_leng);
+     n_pt = cr_mklist(eng_p, e_int_p, t_int_p, shift_list[i_shift],
+              (iv_cur+i_list)->spline,
+              (iv_cur+i_list)->exp_spl, (iv_cur+i_list)->the_spl);
 #endif
 
-     if(n_leng > 1) 
+     pair_leng[i_pair] = n_pt;
+     if(n_pt > 1) 
      {
-       e_range += faux = (eng[n_leng-1] - eng[0]);
-       norm += faux *= (iv_cur+i_list)->weight;
+       pair_range[i_pair] = faux = (eng_p[n_pt-1] - eng_p[0]);
+       pair_norm[i_pair] = faux *= (iv_cur+i_list)->weight;
 
        if(args->r_type == RP_FACTOR)
-         faux *= cr_rp(eng, e_int, t_int, args->vi);
+         faux *= cr_rp(eng_p, e_int_p, t_int_p, args->vi);
        else if (args->r_type == R1_FACTOR)
-         faux *= cr_r1(eng, e_int, t_int);
+         faux *= cr_r1(eng_p, e_int_p, t_int_p);
        else if (args->r_type == R2_FACTOR)
-         faux *= cr_r2(eng, e_int, t_int);
-       else if (args->r_type == RB_FACTOR)
-         faux *= cr_rb(eng, e_int, t_int);
-       else 
-       {
+         faux *= cr_r2(eng_p, e_int_p, t_int_p);
+       else
+         faux *= cr_rb(eng_p, e_int_p, t_int_p);
+       pair_rfac[i_pair] = faux;
+     }
+   }  /* for i_pair */
+
+   free(eng_p);
+   free(e_int_p);
+   free(t_int_p);
+ }  /* parallel */
+
+ if(alloc_err)
+ {
 #ifdef ERROR
-         fprintf(STDERR,
-         "*** error (cr_rmin): invalid R factor selection %d\n", args->r_type);
+   fprintf(STDERR, "*** error (cr_rmin): allocation error (%d thread(s))\n",
+           alloc_err);
 #endif
-         exit(1);
-       }
-       rfac += faux;
+   free(shift_list);
+   free(pair_leng);
+   free(pair_range);
+   free(pair_norm);
+   free(pair_rfac);
+   free(eng);
+   free(e_int);
+   free(t_int);
+   return(-1.);
+ }
+
+ *p_r_min = 100.;
+
+ for(i_shift = 0; i_shift < n_shift; i_shift ++)
+ {
+   shift = shift_list[i_shift];
+   rfac = 0.;
+   norm = 0.;
+   e_range = 0.;
+   for(i_list = 0; i_list < n_list; i_list ++)
+   {
+     i_pair = i_shift * n_list + i_list;
+     if(pair_leng[i_pair] > 1) 
+     {
+       e_range += pair_range[i_pair];
+       norm += pair_norm[i_pair];
+       rfac += pair_rfac[i_pair];
      }
 #ifdef WARNING
      else
@@ -177,7 +314,13 @@ FILE *out_stream;
        *p_e_range = e_range;
      }
    }  /* else (overlap) */
- }  /* for shift ... */
+ }  /* for i_shift ... */
+
+ free(shift_list);
+ free(pair_leng);
+ free(pair_range);
+ free(pair_norm);
+ free(pair_rfac);
 
 #ifdef CONTROL
  fprintf(STDCTR,"(cr_rmin): r_min = %.6f (shift = %4.1f)\n", 
@@ -195,12 +338,12 @@ FILE *out_stream;
 
 #ifdef SHIFT_DE
      n_leng = cr_mklide(eng, e_int, t_int, args->s_step, *p_s_min,
-              (iv_cur+i_list)->exp_list, (iv_cur+i_list)->exp_leng,
-              (iv_cur+i_list)->the_list, (iv_cur+i_list)->the_leng);
+              (iv_cur+i_list)->spline,
+              (iv_cur+i_list)->exp_spl, (iv_cur+i_list)->the_spl);
 #else
      n_leng = cr_mklist(eng, e_int, t_int, *p_s_min,
-              (iv_cur+i_list)->exp_list, (iv_cur+i_list)->exp_leng,
-              (iv_cur+i_list)->the_list, (iv_cur+i_list)->the_leng);
+              (iv_cur+i_list)->spline,
+              (iv_cur+i_list)->exp_spl, (iv_cur+i_list)->the_spl);
 #endif
 
      
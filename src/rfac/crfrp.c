@@ -1,14 +1,17 @@
 /********************************************************************
 GH/29.08.95
-file contains function:
+file contains functions:
 
    real cr_rp( real *eng, real *e_int, real *t_int, real vi)
+   int cr_rp_resid( real *eng, real *e_int, real *t_int, real vi,
+                    real *res, real *p_norm)
 
-Calculate Pendry's R-factor
+Calculate Pendry's R-factor (and the differences of the Y functions)
 
 Changes:
 GH/06.10.92 - Creation
 GH/29.08.95 - adjust to crfac format.
+LD/19.10.26 - cr_rp_resid: Y function differences for least squares fits.
   
 ********************************************************************/
 /*
@@ -89,3 +92,58 @@ real Y_exp, Y_the, L, e_step;
  rf_sum /= (exp_y_sum + the_y_sum);
  return (rf_sum);
 }
+
+/********************************************************************/
+
+int cr_rp_resid( real *eng, real *e_int, real *t_int, real vi,
+                 real *res, real *p_norm)
+
+/********************************************************************
+ compute the differences of theoretical and experimental Y functions
+ (terms of Pendry's R-factor):
+
+INPUT:
+
+  real *eng, *e_int, *t_int, vi - (input) as for cr_rp.
+
+  real *res - (output) res[i-1] = (Yt - Ye) * sqrt(de) for the energies
+             i = 1 ... n, i.e. the sum of res^2 is the numerator of Rp.
+
+  real *p_norm - (output) normalizing factor S(Ye^2 + Yt^2).
+
+DESIGN:
+
+  Rp = S(res^2) / *p_norm; the same Y functions as in cr_rp.
+
+RETURN VALUE: 
+  number of values n written to res.
+
+********************************************************************/
+{
+int i_eng;
+real exp_y_sum, the_y_sum;
+real Y_exp, Y_the, L, e_step;
+
+ exp_y_sum = 0.;
+ the_y_sum = 0.;
+ for(i_eng = 1; 
+     ! IS_EQUAL_REAL(eng[i_eng], F_END_OF_LIST); i_eng ++)
+ {
+  e_step = eng[i_eng] - eng[i_eng-1];
+
+  L = ( t_int[i_eng] - t_int[i_eng-1] ) / 
+      ( e_step * 0.5 * (t_int[i_eng] + t_int[i_eng-1]) );
+  Y_the = L/ ( 1. + L*L*vi*vi);
+  the_y_sum += SQUARE(Y_the)*e_step;
+
+  L = (e_int[i_eng] - e_int[i_eng-1]) / 
+      ( e_step * 0.5 * (e_int[i_eng] + e_int[i_eng-1]) );
+  Y_exp = L/ ( 1. + L*L*vi*vi);
+  exp_y_sum += SQUARE(Y_exp)*e_step;
+
+  res[i_eng-1] = (Y_the - Y_exp) * R_sqrt(e_step);
+ }
+
+ *p_norm = exp_y_sum + the_y_sum;
+ return (i_eng - 1);
+}
@@ -0,0 +1,512 @@
+/********************************************************************
+LD/19.10.26
+file contains functions:
+
+  int cr_serve_eval( struct crivcur *iv_cur, struct crargs *args,
+                     real *p_r_min, real *p_s_min, real *p_e_range)
+  int cr_serve( struct crivcur *iv_cur, struct crargs *args)
+
+ Resident R factor service (crfac --serve): the control file and the
+ experimental IV curves are read and smoothed only once; theoretical
+ IV curves are then read for each request and compared with the same
+ experimental data. This avoids re-reading and re-smoothing the
+ experiment for every evaluation of a structural search.
+
+ Requests are read line by line from stdin or from the connections
+ to a local (Unix domain) socket; each connection is served by its
+ own thread, the evaluations (which share iv_cur) one at a time:
+
+  <file name>          theoretical input file (text or binary)
+  DATA <n_bytes>       followed by n_bytes of theoretical input
+                       (text or binary IV file, see cleed_ivbin.h)
+  QUIT                 end of session
+  SHUTDOWN             end of session and stop the service
+
+ Each request is answered by a single line:
+
+  <r_min> <rr> <shift> <range>   (same format as the crfac output)
+  ERR <message>                  if the request failed
+
+ Changes:
+
+ LD/19.10.26 - Creation.
+ LD/19.10.26 - Socket connections are served concurrently (one thread
+               per connection); SHUTDOWN ends all sessions.
+
+********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include "crfac.h"
+#include "cleed_ivbin.h"
+
+/*
+#define CONTROL
+*/
+#define ERROR
+
+#if !defined(_WIN32)
+#define SERVE_MAX_CONN 64           /* max. number of open connections */
+
+/* the theoretical curves of iv_cur are replaced for every request:
+   one evaluation at a time */
+static pthread_mutex_t serve_lock = PTHREAD_MUTEX_INITIALIZER;
+#define SERVE_LOCK()   pthread_mutex_lock(&serve_lock)
+#define SERVE_UNLOCK() pthread_mutex_unlock(&serve_lock)
+
+struct serve_conn
+{
+  struct crivcur *iv_cur;
+  struct crargs *args;
+  pthread_mutex_t lock;             /* protects the fields below */
+  pthread_cond_t cond;              /* a session has ended */
+  int conn[SERVE_MAX_CONN];         /* open connections (-1: unused) */
+  int n_conn;                       /* number of sessions */
+  int stop;                         /* SHUTDOWN received */
+  int wake;                         /* write end: wakes the accept loop */
+};
+
+struct serve_arg
+{
+  struct serve_conn *sc;
+  int i_conn;
+};
+#else
+#define SERVE_LOCK()
+#define SERVE_UNLOCK()
+#endif
+
+/*======================================================================*/
+
+int cr_serve_eval( struct crivcur *iv_cur, struct crargs *args,
+                   real *p_r_min, real *p_s_min, real *p_e_range)
+
+/********************************************************************
+ Smooth the (new) theoretical IV curves in iv_cur, prepare new cubic
+ splines and find the min. R factor (see cr_rmin). The experimental
+ curves must have been smoothed before.
+ RETURN VALUE: 0 if successful, -1 if failed.
+********************************************************************/
+{
+int i_list;
+char t[2] = "t";
+
+ for(i_list = 0; iv_cur[i_list].group_id != I_END_OF_LIST; i_list ++)
+   cr_lorentz(iv_cur+i_list, args->vi / 2., t);
+
+ if (iv_cur->spline != NULL)
+ {
+   cr_spline_free(iv_cur->spline);
+   for(i_list = 0; iv_cur[i_list].group_id != I_END_OF_LIST; i_list ++)
+     iv_cur[i_list].spline = NULL;
+ }
+ if (cr_spline_setup(iv_cur) == NULL) return(-1);
+
+ if (cr_rmin(iv_cur, args, p_r_min, p_s_min, p_e_range) < 0.) return(-1);
+ return(0);
+}  /* end of function cr_serve_eval */
+
+/*======================================================================*/
+
+static int serve_score(struct crivcur *iv_cur, struct crargs *args,
+                       char *the_file, char *the_buffer,
+                       struct crivbin *the_bin, FILE *out)
+
+/********************************************************************
+ Read theoretical IV curves (from the_file or, if NULL, from
+ the_buffer/the_bin) and reply with the min. R factor.
+ RETURN VALUE: 0 if an R factor was written, -1 otherwise.
+********************************************************************/
+{
+int ret;
+real r_min, s_min, e_range, rr;
+FILE *test_stream;
+
+ if (the_file != NULL)
+ {
+   /* file2buffer does not return on missing files */
+   if ((test_stream = fopen(the_file, "r")) == NULL)
+   {
+     fprintf(out, "ERR cannot open \"%s\"\n", the_file);
+     fflush(out);
+     return(-1);
+   }
+   fclose(test_stream);
+   ret = cr_input_the(iv_cur, the_file);
+ }
+ else
+   ret = cr_input_thebuf(iv_cur, the_buffer, the_bin);
+
+ if (ret != 0)
+ {
+   fprintf(out, "ERR invalid theoretical input\n");
+   fflush(out);
+   return(-1);
+ }
+
+ if (cr_serve_eval(iv_cur, args, &r_min, &s_min, &e_range) != 0)
+ {
+   fprintf(out, "ERR R factor evaluation failed\n");
+   fflush(out);
+   return(-1);
+ }
+
+ rr = R_sqrt(args->vi * 8. / e_range);
+
+ fprintf(out, "%.6f %.6f %.2f %.2f\n", r_min, rr, s_min, e_range);
+ fflush(out);
+ return(0);
+}  /* end of function serve_score */
+
+/*======================================================================*/
+
+static int serve_session(struct crivcur *iv_cur, struct crargs *args,
+                         FILE *in, FILE *out)
+
+/********************************************************************
+ Answer requests read from in until end of file, QUIT or SHUTDOWN.
+ RETURN VALUE: 1 after SHUTDOWN, 0 otherwise.
+********************************************************************/
+{
+long n_bytes;
+size_t len;
+char line_buffer[STRSZ];
+char *name, *data;
+struct crivbin *the_bin;
+
+ while (fgets(line_buffer, STRSZ, in) != NULL)
+ {
+   len = strlen(line_buffer);
+   while (len > 0 && (line_buffer[len-1] == '\n' ||
+                      line_buffer[len-1] == '\r' ||
+                      line_buffer[len-1] == ' ')) line_buffer[--len] = '\0';
+   for (name = line_buffer; *name == ' ' || *name == '\t'; name ++) { ; }
+
+   if (*name == '\0' || *name == '#') continue;
+
+#ifdef CONTROL
+   fprintf(STDERR, "(cr_serve): request \"%s\"\n", name);
+#endif
+
+   if (!strcmp(name, "QUIT")) return(0);
+   if (!strcmp(name, "SHUTDOWN")) return(1);
+
+   if (!strncmp(name, "DATA ", 5))
+   {
+     n_bytes = atol(name + 5);
+     if (n_bytes <= 0)
+     {
+       fprintf(out, "ERR invalid DATA length\n");
+       fflush(out);
+       continue;
+     }
+
+     data = (char *)malloc((size_t)n_bytes + 2);
+     if (data == NULL)
+     {
+#ifdef ERROR
+       fprintf(STDERR, "*** error (cr_serve): allocation error\n");
+#endif
+       return(0);
+     }
+     if ((long)fread(data, 1, (size_t)n_bytes, in) != n_bytes)
+     {
+       free(data);                  /* connection broken */
+       return(0);
+     }
+     data[n_bytes] = data[n_bytes + 1] = '\0';
+
+     if (n_bytes >= IVBIN_MAGIC_LEN &&
+         !memcmp(data, IVBIN_MAGIC, IVBIN_MAGIC_LEN))
+     {
+       /* data is owned by the_bin from now on */
+       if ((the_bin = cr_ivbin_from_buffer(data, n_bytes)) == NULL)
+       {
+         fprintf(out, "ERR invalid binary IV data\n");
+         fflush(out);
+         continue;
+       }
+       SERVE_LOCK();
+       serve_score(iv_cur, args, NULL, NULL, the_bin, out);
+       SERVE_UNLOCK();
+       cr_ivbin_close(the_bin);
+     }
+     else
+     {
+       SERVE_LOCK();
+       serve_score(iv_cur, args, NULL, data, NULL, out);
+       SERVE_UNLOCK();
+       free(data);
+     }
+   }
+   else
+   {
+     SERVE_LOCK();
+     serve_score(iv_cur, args, name, NULL, NULL, out);
+     SERVE_UNLOCK();
+   }
+ }
+
+ return(0);
+}  /* end of function serve_session */
+
+/*======================================================================*/
+
+#if !defined(_WIN32)
+static void *serve_thread(void *arg)
+
+/********************************************************************
+ Session of a socket connection (thread). After SHUTDOWN the accept
+ loop of cr_serve is woken up.
+********************************************************************/
+{
+struct serve_conn *sc = ((struct serve_arg *)arg)->sc;
+int i_conn = ((struct serve_arg *)arg)->i_conn;
+int conn, stop, fd;
+FILE *in, *out;
+
+ free(arg);
+ conn = sc->conn[i_conn];
+
+ stop = 0;
+ in = fdopen(conn, "r");
+ out = ((fd = dup(conn)) == -1) ? NULL : fdopen(fd, "w");
+ if (out == NULL && fd != -1) close(fd);
+ if (in != NULL && out != NULL)
+   stop = serve_session(sc->iv_cur, sc->args, in, out);
+
+ /* the connection is closed after it has been removed from sc->conn,
+    i.e. cr_serve does not shut down a reused descriptor */
+ pthread_mutex_lock(&sc->lock);
+ sc->conn[i_conn] = -1;
+ sc->n_conn --;
+ if (stop && !sc->stop)
+ {
+   sc->stop = 1;
+   if (write(sc->wake, "", 1) != 1) { ; }
+ }
+ pthread_cond_broadcast(&sc->cond);
+ pthread_mutex_unlock(&sc->lock);
+
+ if (out != NULL) fclose(out);
+ if (in != NULL) fclose(in); else close(conn);
+ return(NULL);
+}  /* end of function serve_thread */
+#endif
+
+/*======================================================================*/
+
+int cr_serve( struct crivcur *iv_cur, struct crargs *args)
+
+/********************************************************************
+ Resident R factor service.
+
+INPUT:
+
+  struct crivcur *iv_cur - (input) IV curves as read by cr_input
+          without theoretical input (i.e. experimental data only).
+
+  struct crargs *args - (input) argument list; args->sockfile selects
+          a Unix domain socket, otherwise requests are read from stdin
+          and replies written to stdout. In the latter case all other
+          output to stdout is redirected to stderr to keep the reply
+          stream clean.
+
+DESIGN:
+
+  The experimental curves are smoothed once. For every request the
+  theoretical curves are replaced (cr_input_the), smoothed, splined
+  and compared by cr_rmin.
+
+RETURN VALUE:
+  0 if successful, -1 if the service could not be started.
+
+********************************************************************/
+{
+int i_list;
+char e[2] = "e";
+FILE *out;
+
+ for(i_list = 0; iv_cur[i_list].group_id != I_END_OF_LIST; i_list ++)
+   cr_lorentz(iv_cur+i_list, args->vi / 2., e);
+
+/********************************************************************
+  Requests from stdin
+********************************************************************/
+
+ if (args->sockfile == NULL)
+ {
+#if !defined(_WIN32)
+   int fd;
+
+   fflush(stdout);
+   if ((fd = dup(fileno(stdout))) == -1 ||
+       dup2(fileno(stderr), fileno(stdout)) == -1 ||
+       (out = fdopen(fd, "w")) == NULL)
+   {
+#ifdef ERROR
+     fprintf(STDERR, "*** error (cr_serve): cannot redirect stdout\n");
+#endif
+     return(-1);
+   }
+#else
+   out = stdout;
+#endif
+
+   serve_session(iv_cur, args, stdin, out);
+   fclose(out);
+   return(0);
+ }
+
+/********************************************************************
+  Requests from a Unix domain socket (a thread per connection)
+********************************************************************/
+
+#if !defined(_WIN32)
+ {
+   int sock, conn, i_conn, wake[2];
+   struct sockaddr_un addr;
+   struct pollfd fds[2];
+   struct serve_conn sc;
+   struct serve_arg *sa;
+   pthread_attr_t attr;
+   pthread_t thread;
+
+   if (strlen(args->sockfile) >= sizeof(addr.sun_path))
+   {
+#ifdef ERROR
+     fprintf(STDERR, "*** error (cr_serve): socket name \"%s\" too long\n",
+             args->sockfile);
+#endif
+     return(-1);
+   }
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strcpy(addr.sun_path, args->sockfile);
+
+   unlink(args->sockfile);
+   if ((sock = socket(AF_UNIX, SOCK_STREAM, 0)) == -1 ||
+       bind(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+       listen(sock, 4) == -1 || pipe(wake) == -1)
+   {
+#ifdef ERROR
+     fprintf(STDERR, "*** error (cr_serve): cannot listen on \"%s\"\n",
+             args->sockfile);
+#endif
+     if (sock != -1) close(sock);
+     return(-1);
+   }
+
+   /* a client closing its connection must not stop the service */
+   signal(SIGPIPE, SIG_IGN);
+
+   sc.iv_cur = iv_cur;
+   sc.args = args;
+   pthread_mutex_init(&sc.lock, NULL);
+   pthread_cond_init(&sc.cond, NULL);
+   for (i_conn = 0; i_conn < SERVE_MAX_CONN; i_conn ++) sc.conn[i_conn] = -1;
+   sc.n_conn = 0;
+   sc.stop = 0;
+   sc.wake = wake[1];
+
+   pthread_attr_init(&attr);
+   pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+#ifdef CONTROL
+   fprintf(STDERR, "(cr_serve): listening on \"%s\"\n", args->sockfile);
+#endif
+
+   fds[0].fd = sock;
+   fds[0].events = POLLIN;
+   fds[1].fd = wake[0];
+   fds[1].events = POLLIN;
+   for (;;)
+   {
+     if (poll(fds, 2, -1) == -1)
+     {
+       if (errno == EINTR) continue;
+       break;
+     }
+     if (fds[1].revents != 0) break;         /* SHUTDOWN */
+     if (!(fds[0].revents & POLLIN)) continue;
+
+     if ((conn = accept(sock, NULL, NULL)) == -1)
+     {
+       if (errno == EINTR || errno == ECONNABORTED) continue;
+       break;
+     }
+
+     /* wait for a free entry in sc.conn */
+     pthread_mutex_lock(&sc.lock);
+     while (sc.n_conn == SERVE_MAX_CONN && !sc.stop)
+       pthread_cond_wait(&sc.cond, &sc.lock);
+     if (sc.stop)
+     {
+       pthread_mutex_unlock(&sc.lock);
+       close(conn);
+       break;
+     }
+     for (i_conn = 0; sc.conn[i_conn] != -1; i_conn ++) { ; }
+     sc.conn[i_conn] = conn;
+     sc.n_conn ++;
+     pthread_mutex_unlock(&sc.lock);
+
+     sa = (struct serve_arg *)malloc(sizeof(struct serve_arg));
+     if (sa != NULL)
+     {
+       sa->sc = &sc;
+       sa->i_conn = i_conn;
+     }
+     if (sa == NULL || pthread_create(&thread, &attr, serve_thread, sa) != 0)
+     {
+#ifdef ERROR
+       fprintf(STDERR, "*** error (cr_serve): cannot start session\n");
+#endif
+       free(sa);
+       pthread_mutex_lock(&sc.lock);
+       sc.conn[i_conn] = -1;
+       sc.n_conn --;
+       pthread_mutex_unlock(&sc.lock);
+       close(conn);
+     }
+   }
+
+   /* end the remaining sessions: their next read returns end of file */
+   pthread_mutex_lock(&sc.lock);
+   for (i_conn = 0; i_conn < SERVE_MAX_CONN; i_conn ++)
+     if (sc.conn[i_conn] != -1) shutdown(sc.conn[i_conn], SHUT_RDWR);
+   while (sc.n_conn > 0)
+     pthread_cond_wait(&sc.cond, &sc.lock);
+   pthread_mutex_unlock(&sc.lock);
+
+   pthread_attr_destroy(&attr);
+   pthread_cond_destroy(&sc.cond);
+   pthread_mutex_destroy(&sc.lock);
+   close(wake[0]);
+   close(wake[1]);
+   close(sock);
+   unlink(args->sockfile);
+   return(0);
+ }
+#else
+#ifdef ERROR
+ fprintf(STDERR, "*** error (cr_serve): sockets are not supported, "
+         "use --serve without argument (stdin)\n");
+#endif
+ return(-1);
+#endif
+}  /* end of function cr_serve */
+/********************************************************************/
@@ -10,6 +10,7 @@
 Changes:
 GH/02.10.92 - Creation
 GH/30.08.95 - Adaption to CRFAC
+LD/19.10.26 - Skip empty lists (expt. data without theory in crfac --serve)
 ********************************************************************/
 /*
 #define CONTROL
@@ -84,9 +85,12 @@ real f_aux;
    fprintf(STDCTR,"(cr_tsort): theor. IV curve is not equidistant\n");
 #endif
 
- iv_cur->the_first_eng = iv_cur->the_list[0].energy;
- iv_cur->the_last_eng = iv_cur->the_list[iv_cur->the_leng - 1].energy;
- iv_cur->the_sort = 1;
+ if (iv_cur->the_leng > 0)
+ {
+   iv_cur->the_first_eng = iv_cur->the_list[0].energy;
+   iv_cur->the_last_eng = iv_cur->the_list[iv_cur->the_leng - 1].energy;
+   iv_cur->the_sort = 1;
+ }
 
 /*********************************************************************
  Now: sort experimental data according to energy values
@@ -136,9 +140,12 @@ real f_aux;
    fprintf(STDCTR,"(cr_tsort): experimental. IV curve is not equidistant\n");
 #endif
 
- iv_cur->exp_first_eng = iv_cur->exp_list[0].energy;
- iv_cur->exp_last_eng = iv_cur->exp_list[iv_cur->exp_leng - 1].energy;
- iv_cur->exp_sort = 1;
+ if (iv_cur->exp_leng > 0)
+ {
+   iv_cur->exp_first_eng = iv_cur->exp_list[0].energy;
+   iv_cur->exp_last_eng = iv_cur->exp_list[iv_cur->exp_leng - 1].energy;
+   iv_cur->exp_sort = 1;
+ }
 
  return (1);
 }
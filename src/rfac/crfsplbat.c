@@ -0,0 +1,377 @@
+/********************************************************************
+LD/19.10.26
+file contains functions:
+
+  void cr_spline_solve(const real *x, const real *y, real *d2, int leng,
+                       real *c_prime, real *d_prime)
+  struct crspline *cr_spline_alloc(int n_curve, const int *leng)
+  void cr_spline_free(struct crspline *spl)
+  int cr_spline_set(struct crspline *spl, int i_curve,
+                    const struct crelist *list)
+  int cr_spline_prep(struct crspline *spl)
+  struct crspline *cr_spline_setup(struct crivcur *iv_cur)
+  void cr_splcur_init(struct crsplcur *cur, const struct crspline *spl,
+                      int i_curve)
+  real cr_splcur_eval(struct crsplcur *cur, real eng)
+
+ Cubic spline interpolation for many IV curves at once. Energies,
+ intensities and second derivatives of all curves are stored in
+ contiguous arrays (struct crspline); the curves are evaluated through
+ cursors (struct crsplcur) that move monotonically along the energy
+ axis, so that sorted query points need no bisection.
+
+ Changes:
+
+ LD/19.10.26 - Creation.
+
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "crfac.h"
+
+/*
+#define CONTROL
+*/
+#define ERROR
+
+/*======================================================================*/
+
+void cr_spline_solve(const real *x, const real *y, real *d2, int leng,
+                     real *c_prime, real *d_prime)
+
+/********************************************************************
+ Natural cubic spline: second derivatives d2[0..leng-1] for the points
+ (x[i], y[i]). c_prime and d_prime are work space of at least leng-2
+ elements each.
+********************************************************************/
+{
+int i, k, n_unknown;
+real h_im1, h_i, a, b, c, d, denom;
+
+ if (leng <= 1)
+ {
+   if (leng == 1) d2[0] = 0.0;
+   return;
+ }
+
+ /* Natural spline boundary conditions. */
+ d2[0] = 0.0;
+ d2[leng - 1] = 0.0;
+
+ if (leng <= 2) return;
+
+ n_unknown = leng - 2;
+
+ /* Build and solve the tridiagonal system for M[1..leng-2]. */
+ for (k = 0; k < n_unknown; k++)
+ {
+   i = k + 1; /* original point index */
+   h_im1 = x[i] - x[i - 1];
+   h_i = x[i + 1] - x[i];
+   if (IS_EQUAL_REAL(h_im1, 0.0) || IS_EQUAL_REAL(h_i, 0.0))
+   {
+     /* Degenerate spacing; fall back to zero curvature locally. */
+     d2[i] = 0.0;
+     c_prime[k] = d_prime[k] = 0.0;
+     continue;
+   }
+
+   a = (i == 1) ? 0.0 : h_im1;
+   b = 2.0 * (h_im1 + h_i);
+   c = (i == leng - 2) ? 0.0 : h_i;
+   d = 6.0 * ((y[i + 1] - y[i]) / h_i - (y[i] - y[i - 1]) / h_im1);
+
+   if (k == 0)
+   {
+     c_prime[k] = c / b;
+     d_prime[k] = d / b;
+   }
+   else
+   {
+     denom = b - a * c_prime[k - 1];
+     c_prime[k] = (IS_EQUAL_REAL(denom, 0.0)) ? 0.0 : (c / denom);
+     d_prime[k] = (IS_EQUAL_REAL(denom, 0.0)) ? 0.0 :
+                  ((d - a * d_prime[k - 1]) / denom);
+   }
+ }
+
+ /* Back substitution. */
+ d2[leng - 2] = d_prime[n_unknown - 1];
+ for (k = n_unknown - 2; k >= 0; k--)
+ {
+   i = k + 1;
+   d2[i] = d_prime[k] - c_prime[k] * d2[i + 1];
+ }
+}  /* end of function cr_spline_solve */
+
+/*======================================================================*/
+
+struct crspline *cr_spline_alloc(int n_curve, const int *leng)
+
+/********************************************************************
+ Allocate spline storage for n_curve curves of leng[i] points each.
+ RETURN VALUE: pointer to the new structure or NULL if failed.
+********************************************************************/
+{
+int i_curve;
+struct crspline *spl;
+
+ spl = (struct crspline *)calloc(1, sizeof(struct crspline));
+ if (spl == NULL) return(NULL);
+
+ spl->n_curve = n_curve;
+ spl->offs = (int *)malloc((n_curve + 1) * sizeof(int));
+ if (spl->offs == NULL)
+ {
+   free(spl);
+   return(NULL);
+ }
+
+ spl->offs[0] = 0;
+ for (i_curve = 0; i_curve < n_curve; i_curve ++)
+   spl->offs[i_curve + 1] = spl->offs[i_curve] +
+                            ((leng[i_curve] > 0) ? leng[i_curve] : 0);
+ spl->n_tot = spl->offs[n_curve];
+
+ spl->energy = (real *)calloc(spl->n_tot + 1, sizeof(real));
+ spl->intens = (real *)calloc(spl->n_tot + 1, sizeof(real));
+ spl->deriv2 = (real *)calloc(spl->n_tot + 1, sizeof(real));
+ if (spl->energy == NULL || spl->intens == NULL || spl->deriv2 == NULL)
+ {
+   cr_spline_free(spl);
+   return(NULL);
+ }
+
+ return(spl);
+}  /* end of function cr_spline_alloc */
+
+/*======================================================================*/
+
+void cr_spline_free(struct crspline *spl)
+{
+ if (spl == NULL) return;
+ free(spl->offs);
+ free(spl->energy);
+ free(spl->intens);
+ free(spl->deriv2);
+ free(spl);
+}  /* end of function cr_spline_free */
+
+/*======================================================================*/
+
+int cr_spline_set(struct crspline *spl, int i_curve,
+                  const struct crelist *list)
+
+/********************************************************************
+ Copy energies and intensities of list into curve i_curve.
+ RETURN VALUE: number of points copied, -1 if i_curve is invalid.
+********************************************************************/
+{
+int i, off, leng;
+
+ if (i_curve < 0 || i_curve >= spl->n_curve) return(-1);
+
+ off  = spl->offs[i_curve];
+ leng = spl->offs[i_curve + 1] - off;
+ for (i = 0; i < leng; i ++)
+ {
+   spl->energy[off + i] = list[i].energy;
+   spl->intens[off + i] = list[i].intens;
+ }
+ return(leng);
+}  /* end of function cr_spline_set */
+
+/*======================================================================*/
+
+int cr_spline_prep(struct crspline *spl)
+
+/********************************************************************
+ Prepare the second derivatives of all curves. The tridiagonal
+ systems of all curves are solved in one pass using a single work
+ space (curves are independent and distributed over threads).
+ RETURN VALUE: 0 if successful, -1 if failed.
+********************************************************************/
+{
+int i_curve, off;
+real *work;
+
+ work = (real *)malloc(2 * (spl->n_tot + 1) * sizeof(real));
+ if (work == NULL)
+ {
+#ifdef ERROR
+   fprintf(STDERR, "*** error (cr_spline_prep): allocation error\n");
+#endif
+   return(-1);
+ }
+
+#ifdef _USE_OPENMP
+#pragma omp parallel for private(off) schedule(dynamic)
+#endif
+ for (i_curve = 0; i_curve < spl->n_curve; i_curve ++)
+ {
+   off = spl->offs[i_curve];
+   cr_spline_solve(spl->energy + off, spl->intens + off, spl->deriv2 + off,
+                   spl->offs[i_curve + 1] - off,
+                   work + off, work + spl->n_tot + 1 + off);
+ }
+
+ free(work);
+ return(0);
+}  /* end of function cr_spline_prep */
+
+/*======================================================================*/
+
+struct crspline *cr_spline_setup(struct crivcur *iv_cur)
+
+/********************************************************************
+ Prepare cubic splines for all expt. and theor. IV curves in iv_cur
+ (terminated by group_id == I_END_OF_LIST).
+
+ Curve 2*i holds the expt. and curve 2*i+1 the theor. list of
+ iv_cur[i]. The spline structure is stored in iv_cur[i].spline along
+ with the curve numbers exp_spl/the_spl; the second derivatives are
+ also copied back into the lists (deriv2).
+
+ RETURN VALUE: pointer to the spline structure or NULL if failed.
+********************************************************************/
+{
+int i_list, n_list, i;
+int *leng;
+struct crspline *spl;
+
+ for (n_list = 0; iv_cur[n_list].group_id != I_END_OF_LIST; n_list ++) { ; }
+
+ leng = (int *)malloc((2 * n_list + 1) * sizeof(int));
+ if (leng == NULL) return(NULL);
+
+ for (i_list = 0; i_list < n_list; i_list ++)
+ {
+   leng[2*i_list]     = iv_cur[i_list].exp_leng;
+   leng[2*i_list + 1] = iv_cur[i_list].the_leng;
+ }
+
+ spl = cr_spline_alloc(2 * n_list, leng);
+ free(leng);
+ if (spl == NULL)
+ {
+#ifdef ERROR
+   fprintf(STDERR, "*** error (cr_spline_setup): allocation error\n");
+#endif
+   return(NULL);
+ }
+
+ for (i_list = 0; i_list < n_list; i_list ++)
+ {
+   cr_spline_set(spl, 2*i_list,     iv_cur[i_list].exp_list);
+   cr_spline_set(spl, 2*i_list + 1, iv_cur[i_list].the_list);
+ }
+
+ if (cr_spline_prep(spl) != 0)
+ {
+   cr_spline_free(spl);
+   return(NULL);
+ }
+
+ for (i_list = 0; i_list < n_list; i_list ++)
+ {
+   iv_cur[i_list].spline  = spl;
+   iv_cur[i_list].exp_spl = 2*i_list;
+   iv_cur[i_list].the_spl = 2*i_list + 1;
+
+   for (i = 0; i < iv_cur[i_list].exp_leng; i ++)
+     iv_cur[i_list].exp_list[i].deriv2 = spl->deriv2[spl->offs[2*i_list] + i];
+   for (i = 0; i < iv_cur[i_list].the_leng; i ++)
+     iv_cur[i_list].the_list[i].deriv2 =
+       spl->deriv2[spl->offs[2*i_list + 1] + i];
+
+   iv_cur[i_list].exp_spline = 1;
+   iv_cur[i_list].the_spline = 1;
+ }
+
+#ifdef CONTROL
+ fprintf(STDCTR, "(cr_spline_setup): %d curves, %d points\n",
+         spl->n_curve, spl->n_tot);
+#endif
+
+ return(spl);
+}  /* end of function cr_spline_setup */
+
+/*======================================================================*/
+
+void cr_splcur_init(struct crsplcur *cur, const struct crspline *spl,
+                    int i_curve)
+
+/********************************************************************
+ Set up a cursor for evaluating curve i_curve of spl.
+********************************************************************/
+{
+int off;
+
+ off = spl->offs[i_curve];
+ cur->energy = spl->energy + off;
+ cur->intens = spl->intens + off;
+ cur->deriv2 = spl->deriv2 + off;
+ cur->leng   = spl->offs[i_curve + 1] - off;
+ cur->lo     = 0;
+}  /* end of function cr_splcur_init */
+
+/*======================================================================*/
+
+real cr_splcur_eval(struct crsplcur *cur, real eng)
+
+/********************************************************************
+ Evaluate the cubic spline at eng (same results as cr_splint).
+
+ The interval found for the previous call is the starting point for
+ the search, i.e. for increasing eng the cursor only moves forward
+ (amortised O(1) per point). Bisection is only used if eng is smaller
+ than the previous value.
+********************************************************************/
+{
+int lo, hi, mid;
+real h, a, b, y;
+const real *e = cur->energy;
+
+ if (cur->leng <= 0) return 0.0;
+ if (cur->leng == 1) return cur->intens[0];
+
+ /* Clamp to data bounds (avoids extrapolation surprises). */
+ if (eng <= e[0]) return cur->intens[0];
+ if (eng >= e[cur->leng - 1]) return cur->intens[cur->leng - 1];
+
+ /* lo = last point with e[lo] <= eng (e[leng-1] > eng stops the loop) */
+ lo = cur->lo;
+ if (e[lo] > eng)
+ {
+   lo = 0;
+   hi = cur->leng - 1;
+   while (hi - lo > 1)
+   {
+     mid = lo + (hi - lo) / 2;
+     if (e[mid] > eng) hi = mid;
+     else lo = mid;
+   }
+ }
+ else
+ {
+   while (e[lo + 1] <= eng) lo ++;
+ }
+ cur->lo = lo;
+ hi = lo + 1;
+
+ h = e[hi] - e[lo];
+ if (IS_EQUAL_REAL(h, 0.0)) return cur->intens[lo];
+
+ a = (e[hi] - eng) / h;
+ b = (eng - e[lo]) / h;
+
+ y = a * cur->intens[lo] + b * cur->intens[hi];
+ y += ((a * a * a - a) * cur->deriv2[lo] +
+       (b * b * b - b) * cur->deriv2[hi]) *
+      (h * h) / 6.0;
+
+ return y;
+}  /* end of function cr_splcur_eval */
+/********************************************************************/
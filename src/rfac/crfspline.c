@@ -3,6 +3,9 @@
  *
  *  Prepare natural cubic spline second derivatives for a list of
  *  (energy, intensity) points.
+ *
+ *  LD/19.10.26 - solve via cr_spline_solve (crfsplbat.c), which is
+ *                shared with the batched spline preparation.
  ********************************************************************/
 
 // cppcheck-suppress missingIncludeSystem
@@ -18,55 +21,22 @@ void cr_spline(struct crelist *list, int leng)
     return;
   }
 
-  /* Natural spline boundary conditions. */
-  list[0].deriv2 = 0.0;
-  list[leng - 1].deriv2 = 0.0;
+  /* gather into contiguous arrays: x, y, d2 and work space (2x) */
+  real *buf = (real *)malloc((size_t)leng * 5 * sizeof(real));
+  if (buf == NULL) return;
 
-  if (leng <= 2) return;
+  real *x = buf;
+  real *y = buf + leng;
+  real *d2 = buf + 2 * leng;
 
-  int n_unknown = leng - 2;
-  real *c_prime = (real *)calloc((size_t)n_unknown, sizeof(real));
-  real *d_prime = (real *)calloc((size_t)n_unknown, sizeof(real));
-  if (c_prime == NULL || d_prime == NULL) {
-    free(c_prime);
-    free(d_prime);
-    return;
+  for (int i = 0; i < leng; i++) {
+    x[i] = list[i].energy;
+    y[i] = list[i].intens;
   }
 
-  /* Build and solve the tridiagonal system for M[1..leng-2]. */
-  for (int k = 0; k < n_unknown; k++) {
-    int i = k + 1; /* original point index */
-    real h_im1 = list[i].energy - list[i - 1].energy;
-    real h_i = list[i + 1].energy - list[i].energy;
-    if (IS_EQUAL_REAL(h_im1, 0.0) || IS_EQUAL_REAL(h_i, 0.0)) {
-      /* Degenerate spacing; fall back to zero curvature locally. */
-      list[i].deriv2 = 0.0;
-      continue;
-    }
-
-    real a = (i == 1) ? 0.0 : h_im1;
-    real b = 2.0 * (h_im1 + h_i);
-    real c = (i == leng - 2) ? 0.0 : h_i;
-    real d = 6.0 * ((list[i + 1].intens - list[i].intens) / h_i -
-                    (list[i].intens - list[i - 1].intens) / h_im1);
+  cr_spline_solve(x, y, d2, leng, buf + 3 * leng, buf + 4 * leng);
 
-    if (k == 0) {
-      c_prime[k] = c / b;
-      d_prime[k] = d / b;
-    } else {
-      real denom = b - a * c_prime[k - 1];
-      c_prime[k] = (IS_EQUAL_REAL(denom, 0.0)) ? 0.0 : (c / denom);
-      d_prime[k] = (IS_EQUAL_REAL(denom, 0.0)) ? 0.0 : ((d - a * d_prime[k - 1]) / denom);
-    }
-  }
-
-  /* Back substitution. */
-  list[leng - 2].deriv2 = d_prime[n_unknown - 1];
-  for (int k = n_unknown - 2; k >= 0; k--) {
-    int i = k + 1;
-    list[i].deriv2 = d_prime[k] - c_prime[k] * list[i + 1].deriv2;
-  }
+  for (int i = 0; i < leng; i++) list[i].deriv2 = d2[i];
 
-  free(c_prime);
-  free(d_prime);
+  free(buf);
 }
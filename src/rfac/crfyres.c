@@ -0,0 +1,188 @@
+/********************************************************************
+LD/19.10.26
+file contains function:
+
+   int cr_yres( struct crivcur *iv_cur, struct crargs *args,
+                real shift, const char *file)
+
+ Write the residuals of Pendry's R factor for one shift
+
+Changes:
+LD/19.10.26 - Creation
+
+********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "crfac.h"          /* specific definitions etc. */
+
+/*
+#define CONTROL
+*/
+#define ERROR
+
+int cr_yres( struct crivcur *iv_cur, struct crargs *args,
+             real shift, const char *file)
+
+/********************************************************************
+ Write the residuals of Pendry's R factor for a given shift to a file.
+
+INPUT:
+
+  struct crivcur *iv_cur - (input) IV curves (splines prepared as for
+          cr_rmin).
+
+  struct crargs *args - (input) argument list (vi, s_step, r_type).
+
+  real shift - (input) energy shift (usually the best shift of cr_rmin).
+
+  const char *file - (input) name of output file.
+
+DESIGN:
+
+  The residual of curve c at energy i is
+
+    r = (Yt - Ye) * sqrt(de) * sqrt(range_c * weight_c / (N_c * N)),
+
+  N_c = S(Ye^2 + Yt^2) of curve c, N = S(range_c * weight_c). The sum
+  of r^2 is the total Rp of cr_rmin for this shift. The curves are
+  evaluated in the same order and on the same energy grid as in
+  cr_rmin, i.e. the number and order of residuals only depend on
+  the shift.
+
+  File format: comment lines start with '#', the first other line
+  contains "<number of residuals> <shift> <Rp>", followed by one
+  residual per line.
+
+RETURN VALUE:
+  number of residuals, -1 if failed.
+
+********************************************************************/
+{
+int i_list, n_list;
+int n_leng, n_pt, n_res, i_res, n_tot;
+
+real faux, norm, c_norm, rfac;
+
+real *eng, *e_int, *t_int, *res;
+FILE *out_stream;
+
+ if(args->r_type != RP_FACTOR)
+ {
+#ifdef ERROR
+   fprintf(STDERR,
+   "*** error (cr_yres): residuals are only defined for Rp\n");
+#endif
+   return(-1);
+ }
+
+/********************************************************************
+  Allocate storage (same size as in cr_rmin)
+********************************************************************/
+
+ n_leng = 0;
+ for(n_list = 0; iv_cur[n_list].group_id != I_END_OF_LIST; n_list ++)
+ {
+   faux = ((iv_cur+n_list)->exp_list + (iv_cur+n_list)->exp_leng -1)->energy  -
+          ((iv_cur+n_list)->exp_list)->energy;
+   n_leng = MAX(n_leng, (int)(faux/args->s_step) );
+   faux = ((iv_cur+n_list)->the_list + (iv_cur+n_list)->the_leng -1)->energy  -
+          ((iv_cur+n_list)->the_list)->energy;
+   n_leng = MAX(n_leng, (int)(faux/args->s_step) );
+ }
+
+ eng   = (real *)malloc( n_leng * sizeof(real)*13);
+ e_int = (real *)malloc( n_leng * sizeof(real)*13);
+ t_int = (real *)malloc( n_leng * sizeof(real)*13);
+ res   = (real *)malloc( n_leng * sizeof(real)*13);
+ if( (eng == NULL) || (e_int == NULL) || (t_int == NULL) || (res == NULL) )
+ {
+#ifdef ERROR
+   fprintf(STDERR, "*** error (cr_yres): allocation error\n");
+#endif
+   free(eng); free(e_int); free(t_int); free(res);
+   return(-1);
+ }
+
+/********************************************************************
+  First pass: number of residuals and normalisation of the total Rp
+********************************************************************/
+
+ norm = 0.;
+ n_tot = 0;
+ for(i_list = 0; i_list < n_list; i_list ++)
+ {
+   n_pt = cr_mklide(eng, e_int, t_int, args->s_step, shift,
+            (iv_cur+i_list)->spline,
+            (iv_cur+i_list)->exp_spl, (iv_cur+i_list)->the_spl);
+   if(n_pt > 1)
+   {
+     norm += (eng[n_pt-1] - eng[0]) * (iv_cur+i_list)->weight;
+     n_tot += n_pt - 1;
+   }
+ }
+
+ if( IS_EQUAL_REAL(norm, 0.) ||
+     (out_stream = fopen(file, "w")) == NULL )
+ {
+#ifdef ERROR
+   fprintf(STDERR,
+   "*** error (cr_yres): no overlap or cannot open \"%s\"\n", file);
+#endif
+   free(eng); free(e_int); free(t_int); free(res);
+   return(-1);
+ }
+
+/********************************************************************
+  Second pass: compute Rp for the header, then write residuals
+********************************************************************/
+
+ rfac = 0.;
+ for(i_list = 0; i_list < n_list; i_list ++)
+ {
+   n_pt = cr_mklide(eng, e_int, t_int, args->s_step, shift,
+            (iv_cur+i_list)->spline,
+            (iv_cur+i_list)->exp_spl, (iv_cur+i_list)->the_spl);
+   if(n_pt > 1)
+   {
+     n_res = cr_rp_resid(eng, e_int, t_int, args->vi, res, &c_norm);
+     faux = (eng[n_pt-1] - eng[0]) * (iv_cur+i_list)->weight / norm;
+     for(i_res = 0; i_res < n_res; i_res ++)
+       rfac += faux * SQUARE(res[i_res]) / c_norm;
+   }
+ }
+
+ fprintf(out_stream, "# Y function residuals (Pendry), sum of squares = Rp\n");
+ fprintf(out_stream, "# n_res shift Rp\n");
+ fprintf(out_stream, "%d %.4f %.8f\n", n_tot, shift, rfac);
+
+ for(i_list = 0; i_list < n_list; i_list ++)
+ {
+   n_pt = cr_mklide(eng, e_int, t_int, args->s_step, shift,
+            (iv_cur+i_list)->spline,
+            (iv_cur+i_list)->exp_spl, (iv_cur+i_list)->the_spl);
+   if(n_pt > 1)
+   {
+     n_res = cr_rp_resid(eng, e_int, t_int, args->vi, res, &c_norm);
+     faux = R_sqrt( (eng[n_pt-1] - eng[0]) * (iv_cur+i_list)->weight /
+                    (norm * c_norm) );
+     for(i_res = 0; i_res < n_res; i_res ++)
+       fprintf(out_stream, "%.10e\n", res[i_res] * faux);
+   }
+ }
+
+ fclose(out_stream);
+
+#ifdef CONTROL
+ fprintf(STDCTR,"(cr_yres): %d residuals, Rp = %.6f (shift = %4.1f)\n",
+         n_tot, rfac, shift);
+#endif
+
+ free(eng);
+ free(e_int);
+ free(t_int);
+ free(res);
+
+ return (n_tot);
+}  /* end of function cr_yres */
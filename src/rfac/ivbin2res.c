@@ -0,0 +1,62 @@
+/*********************************************************************
+LD/19.10.26
+  IVBIN2RES
+
+  Program converts a binary (columnar) IV file written by the LEED
+  programs (option -B) into the text format of the results file.
+
+Changes:
+  LD/19.10.26 - Creation
+*********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crfac.h"
+
+/*********************************************************************/
+
+int main(int argc, char *argv[])
+
+/**********************************************************************
+  usage: ivbin2res <binary_file> [<res_file>]
+
+  If no output file is given (or "-"), the text is written to stdout.
+**********************************************************************/
+{
+  int n_eng;
+  FILE *out_stream;
+  struct crivbin *ivbin;
+
+  if( (argc < 2) || (argc > 3) ||
+      (strcmp(argv[1], "-h") == 0) || (strcmp(argv[1], "--help") == 0) )
+  {
+    fprintf(STDERR, "usage: %s <binary_file> [<res_file>]\n", argv[0]);
+    exit(1);
+  }
+
+  if( !cr_ivbin_check(argv[1]) )
+  {
+    fprintf(STDERR, "*** error (ivbin2res): \"%s\" is not a binary IV file\n",
+            argv[1]);
+    exit(1);
+  }
+
+  if( (ivbin = cr_ivbin_open(argv[1])) == NULL ) exit(1);
+
+  if( (argc == 2) || (strcmp(argv[2], "-") == 0) ) out_stream = STDOUT;
+  else if( (out_stream = fopen(argv[2], "w")) == NULL )
+  {
+    fprintf(STDERR, "*** error (ivbin2res): could not open output file "
+            "\"%s\"\n", argv[2]);
+    cr_ivbin_close(ivbin);
+    exit(1);
+  }
+
+  n_eng = cr_ivbin_write_text(ivbin, out_stream);
+
+  if( out_stream != STDOUT ) fclose(out_stream);
+  cr_ivbin_close(ivbin);
+
+  return( (n_eng < 0) ? 1 : 0 );
+}      /* end of main */
@@ -8,6 +8,7 @@ File contains:
 Changes:
   GH/15.02.94 - Creation
   LD/07.03.14 - Added hard-coded help if no RF_HELP_FILE in env
+  LD/19.10.26 - Added --serve
 ********************************************************************/
 #include <stdlib.h>
 #include <stdio.h>
@@ -58,6 +59,7 @@ void rf_help(FILE *output)
         /* use hard-coded help */
         fprintf(output, "SYNTAX:");
         fprintf(output, "\n  crfac -c <control_file> -t <theory_file> [OPTIONS...]    ");
+        fprintf(output, "\n  crfac -c <control_file> --serve [<socket>] [OPTIONS...]    ");
         fprintf(output, "\n");
         fprintf(output, "\n  ");
         fprintf(output, "\nOPTIONS:");
@@ -96,9 +98,19 @@ void rf_help(FILE *output)
         fprintf(output, "\n	  1-3 arguments: <first shift>{,<last shift>,<step>}");
         fprintf(output, "\n      default: -10, 10, 0.5;");
         fprintf(output, "\n");
+        fprintf(output, "\n  --serve [<socket>]");
+        fprintf(output, "\n      keep the experimental data in memory and compare them with");
+        fprintf(output, "\n      theoretical input files named on stdin (one per line) or sent");
+        fprintf(output, "\n      through the Unix domain socket <socket>. One line is returned");
+        fprintf(output, "\n      per request: \"<R> <RR> <shift> <range>\" or \"ERR <message>\".");
+        fprintf(output, "\n      \"DATA <n>\" followed by n bytes sends the theoretical input");
+        fprintf(output, "\n      directly, \"QUIT\" ends a session, \"SHUTDOWN\" the service.");
+        fprintf(output, "\n");
         fprintf(output, "\n  --theory");
         fprintf(output, "\n  -t <filename>");
         fprintf(output, "\n      specify theoretical input file (outside control file) e.g. *.res");
+        fprintf(output, "\n      binary files written by the LEED programs with option -B");
+        fprintf(output, "\n      are detected automatically (see also ivbin2res).");
         fprintf(output, "\n");
         fprintf(output, "\n  --potential");
         fprintf(output, "\n  -v <potential>");
@@ -110,6 +122,11 @@ void rf_help(FILE *output)
         fprintf(output, "\n  --write");
         fprintf(output, "\n  -w <filename> ");
         fprintf(output, "\n      specify file name for iv curves output.");
+        fprintf(output, "\n");
+        fprintf(output, "\n  --yres");
+        fprintf(output, "\n  -y <filename> ");
+        fprintf(output, "\n      write the residuals of Rp (differences of the Y functions)");
+        fprintf(output, "\n      for the best shift to a file (only with -r rp).");
     }
 }
 
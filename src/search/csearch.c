@@ -9,6 +9,15 @@ version 0.1
  GH/29.12.95 - include option d (initial displacement).
                print version number to log file
  LD/03.04.14 - added double quotes around pathnames to enable spaces
+ LD/19.10.26 - search type 'er' (error bars) and option -j (number of
+               concurrent evaluations)
+ LD/19.10.26 - search type 'pt' (parallel tempering)
+ LD/19.10.26 - input and evaluations use the default search context.
+ LD/19.10.26 - options --multistart and --starts (multi-start search).
+ LD/19.10.26 - search type 'lm' (Levenberg-Marquardt fit of Y functions)
+ LD/19.10.26 - option --surrogate (pre-screening of trial points).
+ LD/19.10.26 - the log file is written by a background thread (sr_log.c);
+               option --trace (one JSON line per evaluation).
 ***********************************************************************/
 
 /* Driver for routine AMOEBA */
@@ -29,15 +38,21 @@ int main(int argc, char *argv[])
   int i_atoms;
   int ndim;
   int search_type;
+  int n_jobs;
+  int n_start;
 
   real delta;
 
   char inp_file[STRSZ];
   char bak_file[STRSZ];
   char log_file[STRSZ];
+  char start_file[STRSZ];
+  char trace_file[STRSZ];
 
   FILE *log_stream;
 
+  struct sr_context *ctx = &sr_default_context;
+
 /*********************************************************************
   Preset program parameters and
   Decode arguments:
@@ -49,20 +64,38 @@ int main(int argc, char *argv[])
     -v <bak_file> - (optional input file) vertex.
 
     -s <search_type> - (optional) default is "simplex"
+
+    -j <n_jobs> - (optional) number of LEED evaluations that may run at
+                  the same time (error bars, parallel tempering,
+                  multi-start search and Levenberg-Marquardt fit),
+                  default is 1.
+
+    --multistart <n_start> - (optional) run the search from n_start
+                  starting points at the same time.
+    --starts <start_file> - (optional) starting points of the multi-start
+                  search (one parameter set per line).
+    --surrogate - (optional) do not evaluate trial points whose R factor
+                  predicted by a surrogate model is clearly above the
+                  best one (simplex and simulated annealing).
+    --trace <trace_file> - (optional) write parameters, R factor, shift,
+                  timings and slot of each evaluation to trace_file
+                  (one JSON object per line).
 *********************************************************************/
 
-  sr_project = (char *) malloc(STRSZ * sizeof(char) );
-  if (sr_project == NULL) {
-    fprintf(STDERR, "*** error (SEARCH): allocation error (sr_project)\n");
+  if (sr_context_init(ctx, "search") != 0) {
+    fprintf(STDERR, "*** error (SEARCH): allocation error (project name)\n");
     exit(1);
   }
-  (void)snprintf(sr_project, STRSZ, "%s", "search");
 
   delta = DPOS;
   (void)snprintf(inp_file, sizeof(inp_file), "%s", "---");
   (void)snprintf(bak_file, sizeof(bak_file), "%s", "---");
+  (void)snprintf(start_file, sizeof(start_file), "%s", "---");
+  (void)snprintf(trace_file, sizeof(trace_file), "%s", "---");
 
   search_type = SR_SIMPLEX;
+  n_jobs = 1;
+  n_start = 0;
 
   if (!argc) {search_usage(STDERR);exit(1);}
   
@@ -94,6 +127,74 @@ int main(int argc, char *argv[])
         }
       }
 
+      /* Read number of concurrent evaluations */
+      if(strncmp(argv[i_arg], "-j", 2) == 0)
+      {
+        i_arg++;
+        if (i_arg < argc && atoi(argv[i_arg]) > 0)
+          n_jobs = atoi(argv[i_arg]);
+        else 
+        {
+          #ifdef ERROR
+          fprintf(STDERR,"*** error (SEARCH): number of jobs (option -j) not given\n");
+          #endif
+          exit(1);
+        }
+      }
+
+      /* Read number of starting points (multi-start search) */
+      if(strcmp(argv[i_arg], "--multistart") == 0)
+      {
+        i_arg++;
+        if (i_arg < argc && atoi(argv[i_arg]) > 0)
+          n_start = atoi(argv[i_arg]);
+        else
+        {
+          #ifdef ERROR
+          fprintf(STDERR,"*** error (SEARCH): number of starting points "
+                  "(option --multistart) not given\n");
+          #endif
+          exit(1);
+        }
+      }
+
+      /* Read file of starting points (multi-start search) */
+      if(strcmp(argv[i_arg], "--starts") == 0)
+      {
+        i_arg++;
+        if (i_arg < argc)
+            (void)snprintf(start_file, sizeof(start_file), "%s", argv[i_arg]);
+        else
+        {
+          #ifdef ERROR
+          fprintf(STDERR,"*** error (SEARCH): no file of starting points "
+                  "specified\n");
+          #endif
+          exit(1);
+        }
+      }
+
+      /* Surrogate pre-screening of trial points */
+      if(strcmp(argv[i_arg], "--surrogate") == 0)
+      {
+        ctx->surrogate = 1;
+      }
+
+      /* Read trace file (one record per evaluation) */
+      if(strcmp(argv[i_arg], "--trace") == 0)
+      {
+        i_arg++;
+        if (i_arg < argc)
+            (void)snprintf(trace_file, sizeof(trace_file), "%s", argv[i_arg]);
+        else
+        {
+          #ifdef ERROR
+          fprintf(STDERR,"*** error (SEARCH): no trace file specified\n");
+          #endif
+          exit(1);
+        }
+      }
+
       /* Read parameter input file */
       if(strncmp(argv[i_arg], "-i", 2) == 0)
       {
@@ -144,6 +245,12 @@ int main(int argc, char *argv[])
           search_type = SR_SIM_ANNEALING;
         else if(strncmp(argv[i_arg], "ga", 2) == 0)
           search_type = SR_GENETIC;
+        else if(strncmp(argv[i_arg], "er", 2) == 0)
+          search_type = SR_ERROR_BARS;
+        else if(strncmp(argv[i_arg], "pt", 2) == 0)
+          search_type = SR_PARALLEL_TEMPERING;
+        else if(strncmp(argv[i_arg], "lm", 2) == 0)
+          search_type = SR_LEVENBERG_MARQUARDT;
         else
         {
           #ifdef ERROR
@@ -195,20 +302,20 @@ int main(int argc, char *argv[])
   Build name of log file.
 ***********************************************************************/
 
-  fprintf(STDCTR,"(SEARCH): sr_project  = %s\n", sr_project);
+  fprintf(STDCTR,"(SEARCH): sr_project  = %s\n", ctx->project);
 
-  sr_rdinp(inp_file);
+  sr_rdinp(ctx, inp_file);
 
-  fprintf(STDCTR,"(SEARCH): sr_project  = %s\n", sr_project);
+  fprintf(STDCTR,"(SEARCH): sr_project  = %s\n", ctx->project);
 
   /* build log file */
-  (void)snprintf(log_file, sizeof(log_file), "%s.log", sr_project);
+  (void)snprintf(log_file, sizeof(log_file), "%s.log", ctx->project);
 
   /* dimension of the search */
-  ndim = sr_search->n_par;
+  ndim = ctx->search->n_par;
 
   #ifdef CONTROL
-  fprintf(STDCTR,"(SEARCH): project name  = %s\n", sr_project);
+  fprintf(STDCTR,"(SEARCH): project name  = %s\n", ctx->project);
   fprintf(STDCTR,"(SEARCH): log file name = %s\n", log_file);
   fprintf(STDCTR,"(SEARCH): dimension = %d\n", ndim);
   #endif
@@ -221,49 +328,103 @@ int main(int argc, char *argv[])
 
   fprintf(log_stream,"CSEARCH - version %s\n\n", SR_VERSION);
   fprintf(log_stream,"=> Atoms in search:\n\n");
-  for(i_atoms = 0; (sr_atoms + i_atoms)->type != I_END_OF_LIST; i_atoms ++)
+  for(i_atoms = 0; (ctx->atoms + i_atoms)->type != I_END_OF_LIST;
+      i_atoms ++)
   {
     fprintf(log_stream,"%d \"%s\": (%6.3f, %6.3f, %6.3f) ref: %d nref: %d",
             i_atoms, 
-            (sr_atoms + i_atoms)->name,
-            (sr_atoms + i_atoms)->x, 
-            (sr_atoms + i_atoms)->y, 
-            (sr_atoms + i_atoms)->z,
-            (sr_atoms + i_atoms)->ref, 
-            (sr_atoms + i_atoms)->nref);
-    fprintf(log_stream," r_min: %.3f\n", (sr_atoms + i_atoms)->r_min);
-
-    if(!sr_search->z_only)
+            (ctx->atoms + i_atoms)->name,
+            (ctx->atoms + i_atoms)->x, 
+            (ctx->atoms + i_atoms)->y, 
+            (ctx->atoms + i_atoms)->z,
+            (ctx->atoms + i_atoms)->ref, 
+            (ctx->atoms + i_atoms)->nref);
+    fprintf(log_stream," r_min: %.3f\n", (ctx->atoms + i_atoms)->r_min);
+
+    if(!ctx->search->z_only)
     {
       fprintf(log_stream,"x_par:\t");
-      for(i_par = 1; i_par <= sr_search->n_par; i_par ++)
+      for(i_par = 1; i_par <= ctx->search->n_par; i_par ++)
       { 
         fprintf(log_stream,"%.3f ", 
-                (sr_atoms+i_atoms)->x_par[i_par]); 
+                (ctx->atoms+i_atoms)->x_par[i_par]); 
       }
       fprintf(log_stream,"\ny_par:\t");
-      for(i_par = 1; i_par <= sr_search->n_par; i_par ++)
+      for(i_par = 1; i_par <= ctx->search->n_par; i_par ++)
       { 
         fprintf(log_stream,"%.3f ", 
-               (sr_atoms+i_atoms)->y_par[i_par]); 
+               (ctx->atoms+i_atoms)->y_par[i_par]); 
       }
       fprintf(log_stream,"\n");
     }
     fprintf(log_stream,"z_par:\t");
-    for(i_par = 1; i_par <= sr_search->n_par; i_par ++)
+    for(i_par = 1; i_par <= ctx->search->n_par; i_par ++)
     { 
       fprintf(log_stream,"%.3f ", 
-              (sr_atoms+i_atoms)->z_par[i_par]); 
+              (ctx->atoms+i_atoms)->z_par[i_par]); 
     }
     fprintf(log_stream,"\n\n");
   }
 
   fclose(log_stream);
 
+/***********************************************************************
+  From here on, the log file is written by a background thread (flushed
+  at exit).
+***********************************************************************/
+
+  if (sr_log_open((strncmp(trace_file, "---", 3) != 0) ? trace_file : NULL)
+      != 0)
+  {
+    #ifdef ERROR
+    fprintf(STDERR, "*** error (SEARCH): cannot write trace file \"%s\"\n",
+            trace_file);
+    #endif
+    exit(1);
+  }
+
+/***********************************************************************
+  Multi-start search: the selected algorithm from several starting
+  points (simplex, Powell's method and simulated annealing only).
+***********************************************************************/
+
+  if (n_start > 0 || strncmp(start_file, "---", 3) != 0)
+  {
+    if (search_type != SR_SIMPLEX && search_type != SR_POWELL &&
+        search_type != SR_SIM_ANNEALING)
+    {
+      #ifdef ERROR
+      fprintf(STDERR, "*** error (SEARCH): multi-start search is only "
+              "possible with search types 'sx', 'po' and 'sa'\n");
+      #endif
+      exit(1);
+    }
+    #ifdef WARNING
+    if (strncmp(bak_file, "---", 3) != 0)
+      fprintf(STDWAR, "* warning (SEARCH): vertex file \"%s\" is ignored "
+              "by the multi-start search\n", bak_file);
+    if (ctx->surrogate)
+      fprintf(STDWAR, "* warning (SEARCH): option --surrogate is ignored "
+              "by the multi-start search\n");
+    #endif
+
+    SR_MS(ctx, search_type, n_start,
+          (strncmp(start_file, "---", 3) != 0) ? start_file : NULL,
+          ndim, delta, n_jobs, log_file);
+    return 0;
+  }
+
 /***********************************************************************
   Perform the search according to the selected algorithm.
 ***********************************************************************/
 
+  #ifdef WARNING
+  if (ctx->surrogate && search_type != SR_SIMPLEX &&
+      search_type != SR_SIM_ANNEALING)
+    fprintf(STDWAR, "* warning (SEARCH): option --surrogate is only used "
+            "by search types 'sx' and 'sa'\n");
+  #endif
+
   switch(search_type)
   {
 /*
@@ -271,7 +432,7 @@ int main(int argc, char *argv[])
 */
     case(SR_SIMPLEX):
     {
-      SR_SX(ndim, delta, bak_file, log_file);
+      SR_SX(ctx, ndim, delta, bak_file, log_file);
       break;
     } /* case SR_SIMPLEX */
 
@@ -280,7 +441,7 @@ int main(int argc, char *argv[])
 */
     case(SR_POWELL):
     {
-      SR_PO(ndim, bak_file, log_file);
+      SR_PO(ctx, ndim, bak_file, log_file);
       break;
     } /* case SR_POWELL */
 
@@ -289,7 +450,7 @@ int main(int argc, char *argv[])
 */
     case(SR_SIM_ANNEALING):
     {
-      SR_SA(ndim, delta, bak_file, log_file);
+      SR_SA(ctx, ndim, delta, bak_file, log_file);
       break;
     } /* case SR_SIM_ANNEALING */
 
@@ -301,6 +462,38 @@ int main(int argc, char *argv[])
       SR_NOT_IMPLEMENTED_ERROR("genetic algorithm");
       break;
     } /* case SR_GENETIC */
+
+/*
+  ERROR BARS
+*/
+    case(SR_ERROR_BARS):
+    {
+      SR_ER(ctx, ndim, delta, n_jobs, bak_file, log_file);
+      break;
+    } /* case SR_ERROR_BARS */
+
+/*
+  PARALLEL TEMPERING
+*/
+    case(SR_PARALLEL_TEMPERING):
+    {
+      SR_PT(ctx, ndim, delta, n_jobs, bak_file, log_file);
+      break;
+    } /* case SR_PARALLEL_TEMPERING */
+
+/*
+  LEVENBERG-MARQUARDT (Y FUNCTION RESIDUALS)
+*/
+    case(SR_LEVENBERG_MARQUARDT):
+    {
+      #ifdef WARNING
+      if (strncmp(bak_file, "---", 3) != 0)
+        fprintf(STDWAR, "* warning (SEARCH): vertex file \"%s\" is ignored "
+                "by the Levenberg-Marquardt fit\n", bak_file);
+      #endif
+      SR_LM(ctx, ndim, delta, n_jobs, log_file);
+      break;
+    } /* case SR_LEVENBERG_MARQUARDT */
     
     default:
     {
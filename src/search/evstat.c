@@ -0,0 +1,309 @@
+/***********************************************************************
+LD/19.10.26
+ Statistics of the evaluation history of one or more searches
+ (log files or trace files of csearch --trace).
+ Modified:
+ LD/19.10.26 - Creation
+***********************************************************************/
+
+/**
+ * @file evstat.c
+ * @brief Print statistics over all evaluations of one or more searches.
+ *
+ * Where `verstat` summarises the final simplex, this utility reads the
+ * complete history - the `*.log` file of csearch or the JSON lines of
+ * `csearch --trace` - and prints per search the convergence of the best
+ * R factor and over all searches the R factor distribution, the
+ * sensitivity of R to each parameter, the correlation of the parameters
+ * and the time per evaluation spent in LEED, R factor and the rest
+ * (I/O and the search itself; trace files only).
+ *
+ * The files are read line by line and the statistics are accumulated in
+ * one pass (sr_eval_stats.c), so the memory used does not grow with the
+ * length of the history.
+ */
+
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+#include "search.h"
+#include "sr_alloc.h"
+#include "sr_eval_stats.h"
+
+#define EVSTAT_LINE     65536     /* maximum length of an input line */
+#define EVSTAT_MAX_PAR  4096      /* maximum number of parameters */
+#define EVSTAT_N_HIST   20        /* lines of the R factor histogram */
+#define EVSTAT_BAR      50        /* length of the longest bar */
+
+/**********************************************************************/
+
+static void evstat_usage(void)
+{
+  fprintf(STDERR, "\tusage: \tevstat [-r <r_cut>] <file> [<file> ...]\n");
+  fprintf(STDERR, "\t<file>:  csearch log file (*.log) or trace file "
+          "(csearch --trace)\n");
+  fprintf(STDERR, "\t-r:      parameter statistics only for R <= r_cut\n");
+}
+
+// cppcheck-suppress constParameter
+static int evstat_parse_args(int argc, char *const argv[], double *r_cut,
+                             int *i_first)
+{
+  *r_cut = HUGE_VAL;
+  *i_first = argc;
+  for (int i_arg = 1; i_arg < argc; i_arg++)
+  {
+    if (*argv[i_arg] != '-')
+    {
+      *i_first = i_arg;
+      return 0;
+    }
+    if (strcmp(argv[i_arg], "-r") == 0 && i_arg + 1 < argc)
+    {
+      char *end;
+      *r_cut = strtod(argv[++i_arg], &end);
+      if (*end == '\0') continue;
+    }
+    fprintf(STDERR, "*** error (evstat):\tsyntax error:\n");
+    evstat_usage();
+    return 1;
+  }
+  fprintf(STDERR, "*** error (evstat): no log or trace file specified\n");
+  evstat_usage();
+  return 1;
+}
+
+static void evstat_print_conv(const char *file, const sr_evstat_conv *conv)
+{
+  static const double dr[SR_EVSTAT_N_CONV] = SR_EVSTAT_CONV_DR;
+
+  fprintf(STDOUT, "=> %s: %ld evaluations\n", file, conv->n_eval);
+  if (conv->n_eval == 0) return;
+  fprintf(STDOUT, "   first: %.4f best: %.4f (#%d, %d improvements)\n",
+          conv->r_first, conv->r_best, conv->i_best, conv->n_step);
+  fprintf(STDOUT, "   best reached within");
+  for (int k = 0; k < SR_EVSTAT_N_CONV; k++)
+    fprintf(STDOUT, " %.3f: #%d%s", dr[k], conv->i_conv[k],
+            (k < SR_EVSTAT_N_CONV - 1) ? "," : "\n");
+  if (conv->elapsed >= 0.)
+    fprintf(STDOUT, "   elapsed: %.0f s (%.1f s per evaluation)\n",
+            conv->elapsed, conv->elapsed / (double)conv->n_eval);
+}
+
+/*
+  read one file; the accumulators are set up with the number of
+  parameters of the first evaluation.
+*/
+static int evstat_read_file(const char *file, sr_evstat *st, int *init,
+                            double r_cut, char *line, sr_evstat_eval *ev,
+                            long *n_bad)
+{
+  sr_evstat_conv conv;
+  int long_line = 0;
+  FILE *inp_stream = fopen(file, "r");
+
+  if (inp_stream == NULL)
+  {
+    fprintf(STDERR, " *** error (evstat): could not open file \"%s\"\n",
+            file);
+    return 1;
+  }
+  if (*init) sr_evstat_begin(st);
+
+  while (fgets(line, EVSTAT_LINE, inp_stream) != NULL)
+  {
+    int end_of_line = (strchr(line, '\n') != NULL);
+    int skip = long_line;
+
+    long_line = !end_of_line && !feof(inp_stream);
+    if (skip) continue;
+    if (long_line)
+    {
+      (*n_bad) ++;
+      continue;
+    }
+
+    switch (sr_evstat_parse(line, ev, EVSTAT_MAX_PAR))
+    {
+      case 0: continue;
+      case 1: break;
+      default: (*n_bad) ++; continue;
+    }
+
+    if (!*init)
+    {
+      if (sr_evstat_init(st, ev->n_par, r_cut) != 0)
+      {
+        fclose(inp_stream);
+        fprintf(STDERR, "*** error (evstat): allocation failure\n");
+        return 1;
+      }
+      *init = 1;
+    }
+    (void)sr_evstat_add(st, ev);
+  }
+  fclose(inp_stream);
+
+  if (*init)
+  {
+    sr_evstat_end(st, &conv);
+    evstat_print_conv(file, &conv);
+  }
+  else
+    fprintf(STDOUT, "=> %s: no evaluations\n", file);
+  return 0;
+}
+
+static void evstat_print_hist(const sr_evstat *st)
+{
+  int k_lo = (int)(st->r_min / SR_EVSTAT_DBIN);
+  int k_hi = (int)(st->r_max / SR_EVSTAT_DBIN);
+  int width;
+  long n_max = 1;
+
+  if (k_lo < 0) k_lo = 0;
+  if (k_hi >= SR_EVSTAT_NBIN) k_hi = SR_EVSTAT_NBIN - 1;
+  width = (k_hi - k_lo) / EVSTAT_N_HIST + 1;
+
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (int k = k_lo; k <= k_hi; k += width)
+    {
+      long n = 0;
+      for (int l = k; l < k + width && l < SR_EVSTAT_NBIN; l++)
+        n += st->hist[l];
+      if (pass == 0)
+      {
+        if (n > n_max) n_max = n;
+        continue;
+      }
+      fprintf(STDOUT, "%7.3f - %.3f: %7ld", k * SR_EVSTAT_DBIN,
+              (k + width) * SR_EVSTAT_DBIN, n);
+      if (n > 0) fputc(' ', STDOUT);
+      for (long i = 0; i < (n * EVSTAT_BAR + n_max - 1) / n_max; i++)
+        fputc('#', STDOUT);
+      fputc('\n', STDOUT);
+    }
+  }
+  if (st->hist[SR_EVSTAT_NBIN] > 0)
+    fprintf(STDOUT, "  outside 0 - %.3f: %ld\n",
+            SR_EVSTAT_NBIN * SR_EVSTAT_DBIN, st->hist[SR_EVSTAT_NBIN]);
+}
+
+static void evstat_print_rfac(const sr_evstat *st)
+{
+  fprintf(STDOUT, "\n=> R factor distribution (%ld LEED calculations):\n",
+          st->n_calc);
+  if (st->n_calc == 0) return;
+  fprintf(STDOUT, "min: %.4f 10%%: %.4f 50%%: %.4f 90%%: %.4f max: %.4f\n",
+          st->r_min, sr_evstat_quantile(st, 0.1),
+          sr_evstat_quantile(st, 0.5), sr_evstat_quantile(st, 0.9),
+          st->r_max);
+  evstat_print_hist(st);
+}
+
+static void evstat_print_par(const sr_evstat *st)
+{
+  if (st->r_cut < HUGE_VAL)
+    fprintf(STDOUT, "\n=> Parameter sensitivity (%ld evaluations with "
+            "R <= %.4f):\n", st->n_mom, st->r_cut);
+  else
+    fprintf(STDOUT, "\n=> Parameter sensitivity (%ld evaluations):\n",
+            st->n_mom);
+  if (st->n_mom < 2) return;
+
+  fprintf(STDOUT, " par:     avg     dev    dR/dpar  corr(par,R)\n");
+  for (int i = 1; i <= st->n_par; i++)
+    fprintf(STDOUT, "%4d: %7.4f %7.4f %10.4f %8.3f\n", i,
+            sr_evstat_mean(st, i), sr_evstat_dev(st, i),
+            sr_evstat_slope(st, i), sr_evstat_corr(st, i, 0));
+
+  fprintf(STDOUT, "\n=> Parameter correlation:\n     ");
+  for (int j = 1; j <= st->n_par; j++) fprintf(STDOUT, " %6d", j);
+  fputc('\n', STDOUT);
+  for (int i = 1; i <= st->n_par; i++)
+  {
+    fprintf(STDOUT, "%4d:", i);
+    for (int j = 1; j <= st->n_par; j++)
+      fprintf(STDOUT, " %6.3f", sr_evstat_corr(st, i, j));
+    fputc('\n', STDOUT);
+  }
+}
+
+static void evstat_print_time(const sr_evstat *st)
+{
+  double t_other;
+
+  if (st->n_time == 0) return;
+  fprintf(STDOUT, "\n=> Time per evaluation (%ld evaluations with "
+          "timing):\n", st->n_time);
+  fprintf(STDOUT, "LEED: %.3f s R factor: %.3f s\n",
+          st->t_leed / (double)st->n_time, st->t_rfac / (double)st->n_time);
+  if (st->n_wall == 0) return;
+  if (st->t_wall <= 0.)
+  {
+    fprintf(STDOUT, "wall: below the resolution of the time stamps (1 s)\n");
+    return;
+  }
+
+  /* same evaluations: time between two evaluations of a slot */
+  t_other = st->t_wall - st->t_wall_leed - st->t_wall_rfac;
+  if (t_other < 0.) t_other = 0.;
+  fprintf(STDOUT, "wall: %.3f s = LEED %.1f%% + R factor %.1f%% + "
+          "I/O and search %.1f%% (%ld evaluations)\n",
+          st->t_wall / (double)st->n_wall, 100. * st->t_wall_leed / st->t_wall,
+          100. * st->t_wall_rfac / st->t_wall, 100. * t_other / st->t_wall,
+          st->n_wall);
+}
+
+int main(int argc, char *argv[])
+{
+  double r_cut;
+  int i_first;
+  if (evstat_parse_args(argc, argv, &r_cut, &i_first) != 0) return 1;
+
+  char *line = (char *)malloc(EVSTAT_LINE);
+  real *par = sr_alloc_vector((size_t)EVSTAT_MAX_PAR);
+  if (line == NULL || par == NULL)
+  {
+    free(line);
+    sr_free_vector(par);
+    fprintf(STDERR, "*** error (evstat): allocation failure\n");
+    return 1;
+  }
+
+  sr_evstat st;
+  sr_evstat_eval ev;
+  int init = 0, rc = 0;
+  long n_bad = 0;
+  ev.par = par;
+
+  for (int i_arg = i_first; i_arg < argc && rc == 0; i_arg++)
+    rc = evstat_read_file(argv[i_arg], &st, &init, r_cut, line, &ev, &n_bad);
+
+  if (rc == 0 && init)
+  {
+    fprintf(STDOUT, "\n=> %d file(s), %ld evaluations (%ld LEED "
+            "calculations, %ld rejected geometries), %d parameters\n",
+            argc - i_first, st.n_eval, st.n_calc, st.n_rejected, st.n_par);
+    if (st.n_skip > 0 || n_bad > 0)
+      fprintf(STDOUT, "   %ld lines with a different number of parameters, "
+              "%ld unreadable lines ignored\n", st.n_skip, n_bad);
+    evstat_print_rfac(&st);
+    evstat_print_par(&st);
+    evstat_print_time(&st);
+  }
+
+  if (init) sr_evstat_free(&st);
+  free(line);
+  sr_free_vector(par);
+
+  return rc;
+}  /* end of main */
+
+/**********************************************************************/
@@ -3,11 +3,75 @@ Global state for search library.
 
 Modern toolchains default to -fno-common, so globals must be defined
 exactly once (and declared as extern in headers).
+
+The former globals sr_atoms, sr_search, sr_project and sa_idum are the
+members atoms, search, project and idum of the default search context
+sr_default_context; further contexts are set up by sr_context_init.
 ***********************************************************************/
 
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
 #include "search.h"
 
-struct sratom_str *sr_atoms = NULL;
-struct search_str *sr_search = NULL;
-char *sr_project = NULL;
+struct sr_context sr_default_context = {
+  .atoms = NULL,
+  .search = NULL,
+  .project = NULL,
+  .rfac_min = 100.,
+  .rfac_max = 0.,
+  .idum = -1
+};
+
+/*!
+ * Initialise an empty search context for project \p project (default
+ * "search" if NULL); atoms and search parameters are read by sr_rdinp.
+ *
+ * \return 0 on success, -1 on allocation failure.
+ */
+int sr_context_init(struct sr_context *ctx, const char *project)
+{
+  memset(ctx, 0, sizeof(*ctx));
+
+  ctx->project = (char *)malloc(STRSZ * sizeof(char));
+  if (ctx->project == NULL) return -1;
+  (void)snprintf(ctx->project, STRSZ, "%s",
+                 (project != NULL) ? project : "search");
+
+  ctx->rfac_min = 100.;
+  ctx->rfac_max = 0.;
+  ctx->idum = -1;
+  return 0;
+}
+
+/*!
+ * Remove the scratch directory of the default slot and free everything
+ * allocated by sr_context_init and sr_rdinp.
+ */
+void sr_context_free(struct sr_context *ctx)
+{
+  if (ctx == NULL) return;
+
+  sr_evslot_close(&ctx->slot0);
+
+  if (ctx->atoms != NULL)
+  {
+    /* the terminating entry may have parameter lists, too (sr_rdinp) */
+    for (int i = 0; ; i++)
+    {
+      free(ctx->atoms[i].x_par);
+      free(ctx->atoms[i].y_par);
+      free(ctx->atoms[i].z_par);
+      if (ctx->atoms[i].type == I_END_OF_LIST) break;
+    }
+    free(ctx->atoms);
+  }
+  free(ctx->search);
+  free(ctx->project);
 
+  ctx->atoms = NULL;
+  ctx->search = NULL;
+  ctx->project = NULL;
+}
@@ -17,7 +17,12 @@
  *
  * This is a lightweight annealing variant intended for SEARCH workflows.
  * It uses a deterministic RNG (@ref sr_rng) seeded from the global SEARCH
- * `sa_idum` value so behaviour can be regression-tested across platforms.
+ * seed (`sr_default_context.idum`) so behaviour can be regression-tested across platforms.
+ *
+ * For concurrent annealing runs (parallel tempering, see sr_ptemper.c)
+ * each run passes its own seed (`cfg->idum`) and an objective function
+ * with user pointer (`cfg->funk_data`, `cfg->data`), so that no global
+ * state is shared.
  */
 
 // cppcheck-suppress missingIncludeSystem
@@ -29,8 +34,7 @@
 #include "sr_rng.h"
 #include "sr_simplex.h"
 
-/* The SEARCH driver keeps a global seed. */
-extern long sa_idum;
+/* Without cfg->idum the seed of the default search context is used. */
 
 static int sr_accept_move(sr_rng *rng, real current, real proposed, real temp)
 {
@@ -53,6 +57,9 @@ typedef struct sr_amebsa_ctx {
   real ftol;
   real temptr;
   sr_amebsa_func funk;
+  sr_eval_func funk_data;
+  void *data;
+  long *idum;
   real **p;
   real *y;
   real *pb;
@@ -120,7 +127,8 @@ static int sr_amebsa_step(sr_amebsa_ctx *ctx)
                     (real)(ctx->temptr * (real)0.05) * (real)jitter;
   }
 
-  real fr = (*ctx->funk)(ctx->trial);
+  real fr = (ctx->funk_data != NULL) ? (*ctx->funk_data)(ctx->trial, ctx->data)
+                                      : (*ctx->funk)(ctx->trial);
   ctx->used++;
 
   if (!sr_accept_move(&ctx->rng, ctx->y[ihi], fr, ctx->temptr)) return 0;
@@ -145,6 +153,9 @@ static int sr_amebsa_init_ctx(sr_amebsa_ctx *ctx, real **p, real *y, int ndim, r
   ctx->ftol = cfg->ftol;
   ctx->temptr = cfg->temptr;
   ctx->funk = sr_amebsa_cfg_get_funk(cfg);
+  ctx->funk_data = sr_amebsa_cfg_get_funk_data(cfg);
+  ctx->data = cfg->data;
+  ctx->idum = (cfg->idum != NULL) ? cfg->idum : &sr_default_context.idum;
   ctx->p = p;
   ctx->y = y;
   ctx->pb = pb;
@@ -154,14 +165,14 @@ static int sr_amebsa_init_ctx(sr_amebsa_ctx *ctx, real **p, real *y, int ndim, r
   ctx->trial = NULL;
   ctx->used = 0;
 
-  if (ctx->funk == NULL) return -1;
+  if (ctx->funk == NULL && ctx->funk_data == NULL) return -1;
 
   ctx->budget = *iter;
   if (ctx->budget < 0) ctx->budget = 0;
 
   if (sr_amebsa_alloc(ctx) != 0) return -1;
 
-  ctx->seed = sr_amebsa_seed_from_idum(sa_idum);
+  ctx->seed = sr_amebsa_seed_from_idum(*ctx->idum);
   sr_rng_seed(&ctx->rng, ctx->seed);
   sr_amebsa_init_best(ctx);
   return 0;
@@ -178,7 +189,7 @@ static void sr_amebsa_run(sr_amebsa_ctx *ctx)
 static void sr_amebsa_finalize(sr_amebsa_ctx *ctx)
 {
   *ctx->iter_io = ctx->used;
-  sa_idum = (long)(ctx->seed + (uint64_t)ctx->used + 1);
+  *ctx->idum = (long)(ctx->seed + (uint64_t)ctx->used + 1);
   sr_amebsa_init_best(ctx);
 }
 
@@ -18,8 +18,10 @@
  * calling conventions (1-based arrays) while keeping the code testable and
  * portable.
  *
- * When `sr_project` is set, the minimiser writes `${sr_project}.ver` and
- * `${sr_project}.vbk` vertex files as a best-effort checkpoint for long runs.
+ * The minimiser writes `<project>.ver` and `<project>.vbk` vertex files as
+ * a best-effort checkpoint for long runs (see sr_simplex_write_vertex());
+ * sr_amoeba() uses the project of the default search context
+ * (`sr_default_context.project`), sr_amoeba_data() the one passed by the caller.
  */
 
 // cppcheck-suppress missingIncludeSystem
@@ -28,12 +30,7 @@
 #include <stdio.h>
 // cppcheck-suppress missingIncludeSystem
 #include <stdlib.h>
-// cppcheck-suppress missingIncludeSystem
-#include <string.h>
-// cppcheck-suppress missingIncludeSystem
-#include <time.h>
 
-#include "copy_file.h"
 #include "search.h"
 #include "sr_simplex.h"
 
@@ -41,45 +38,6 @@
 #define MAX_ITER_AMOEBA 2000
 #endif
 
-static int sr_write_vertex_file(const real **p, const real *y, int ndim)
-{
-  if (sr_project == NULL || sr_project[0] == '\0') return 0;
-
-  char ver_file[STRSZ];
-  char vbk_file[STRSZ];
-
-  /* Best-effort backup of the previous vertex file. */
-  (void)snprintf(ver_file, sizeof(ver_file), "%s.ver", sr_project);
-  (void)snprintf(vbk_file, sizeof(vbk_file), "%s.vbk", sr_project);
-
-  (void)copy_file(ver_file, vbk_file);
-
-  FILE *fp = fopen(ver_file, "w");
-  if (fp == NULL) return -1;
-
-  int mpts = ndim + 1;
-  fprintf(fp, "%d %d %s\n", ndim, mpts, sr_project);
-  for (int i = 1; i <= mpts; i++) {
-    fprintf(fp, "%e ", (double)y[i]);
-    for (int j = 1; j <= ndim; j++) {
-      fprintf(fp, "%e ", (double)p[i][j]);
-    }
-    fputc('\n', fp);
-  }
-
-  time_t now = time(NULL);
-  const struct tm *tm_info = localtime(&now);
-  if (tm_info != NULL) {
-    char timebuf[64];
-    if (strftime(timebuf, sizeof(timebuf), "%c", tm_info) > 0) {
-      fprintf(fp, "%s\n", timebuf);
-    }
-  }
-
-  fclose(fp);
-  return 0;
-}
-
 /**
  * @brief Internal state for a single sr_amoeba() invocation.
  *
@@ -95,7 +53,9 @@ typedef struct sr_amoeba_ctx {
   real rho;
   real sigma;
   real ftol;
-  real (*funk)(real *);
+  sr_eval_func funk;
+  void *data;
+  const char *project;
   int *nfunk;
   real **p;
   real *y;
@@ -106,7 +66,7 @@ typedef struct sr_amoeba_ctx {
 
 static real sr_amoeba_eval(sr_amoeba_ctx *ctx, real *x)
 {
-  real v = ctx->funk(x);
+  real v = (*ctx->funk)(x, ctx->data);
   (*ctx->nfunk)++;
   return v;
 }
@@ -198,7 +158,8 @@ static int sr_amoeba_step(sr_amoeba_ctx *ctx)
     sr_amoeba_contract_or_shrink(ctx, ilo, ihi, fr);
   }
 
-  (void)sr_write_vertex_file((const real **)ctx->p, ctx->y, ctx->ndim);
+  (void)sr_simplex_write_vertex(ctx->project, (const real **)ctx->p, ctx->y,
+                                ctx->ndim);
   return 0;
 }
 
@@ -214,7 +175,7 @@ static int sr_amoeba_alloc_buffers(sr_amoeba_ctx *ctx, int ndim)
 }
 
 static int sr_amoeba_init(sr_amoeba_ctx *ctx, real **p, real *y, int ndim,
-                          real ftol, real (*funk)(real *), int *nfunk)
+                          real ftol, sr_eval_func funk, int *nfunk)
 {
   if (ctx == NULL || p == NULL || y == NULL || ndim <= 0 || funk == NULL || nfunk == NULL) return -1;
 
@@ -261,10 +222,13 @@ static int sr_amoeba_run(sr_amoeba_ctx *ctx)
   return rc;
 }
 
-int sr_amoeba(real **p, real *y, int ndim, real ftol, real (*funk)(real *), int *nfunk)
+int sr_amoeba_data(real **p, real *y, int ndim, real ftol, sr_eval_func funk,
+                   void *data, const char *project, int *nfunk)
 {
   sr_amoeba_ctx ctx;
   int rc = sr_amoeba_init(&ctx, p, y, ndim, ftol, funk, nfunk);
+  ctx.data = data;
+  ctx.project = project;
   if (rc != 0) {
     sr_amoeba_free(&ctx);
     return -1;
@@ -276,3 +240,22 @@ int sr_amoeba(real **p, real *y, int ndim, real ftol, real (*funk)(real *), int
   if (rc == 1) return 0;
   return rc;
 }
+
+/* objective function without user pointer (legacy interface) */
+typedef struct sr_amoeba_legacy {
+  real (*funk)(real *);
+} sr_amoeba_legacy;
+
+static real sr_amoeba_call_legacy(real *x, void *data)
+{
+  return (*((sr_amoeba_legacy *)data)->funk)(x);
+}
+
+int sr_amoeba(real **p, real *y, int ndim, real ftol, real (*funk)(real *), int *nfunk)
+{
+  sr_amoeba_legacy legacy;
+  legacy.funk = funk;
+  if (funk == NULL) return -1;
+  return sr_amoeba_data(p, y, ndim, ftol, sr_amoeba_call_legacy, &legacy,
+                        sr_default_context.project, nfunk);
+}
@@ -0,0 +1,402 @@
+/*********************************************************************
+ *                     SR_EVAL_STATS.C
+ *
+ *  GPL-3.0-or-later
+ *********************************************************************/
+
+/**
+ * @file sr_eval_stats.c
+ * @brief Streaming statistics over the evaluation history of SEARCH
+ * (see sr_eval_stats.h).
+ *
+ * Means and co-moments are updated with Welford's algorithm, i.e. in
+ * one pass and without cancellation for long histories. The R factors
+ * are binned into a fixed histogram, from which the quantiles are taken.
+ * Convergence is described by the steps of the best-so-far value; if a
+ * search has more than SR_EVSTAT_MAX_STEP steps every second one is
+ * dropped, which delays the reported evaluations by at most the gap
+ * between two remaining steps.
+ */
+
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "sr_eval_stats.h"
+
+/**********************************************************************/
+
+/* days since 1970-01-01 of a date of the Gregorian calendar */
+static long sr_evstat_days(int year, int month, int day)
+{
+  long y = year - (month <= 2);
+  long era = (y >= 0 ? y : y - 399) / 400;
+  long yoe = y - era * 400;
+  long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+/* time stamp of the log file (asctime format), seconds; -1 if invalid */
+static double sr_evstat_asctime(const char *str)
+{
+  static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+  char wday[4], mon[4];
+  int day, hour, min, sec, year;
+  const char *pos;
+
+  if (sscanf(str, "%3s %3s %d %d:%d:%d %d", wday, mon, &day, &hour, &min,
+             &sec, &year) != 7) return -1.;
+  pos = strstr(months, mon);
+  if (pos == NULL || strlen(mon) != 3) return -1.;
+
+  return 86400. * (double)sr_evstat_days(year, (int)(pos - months) / 3 + 1,
+                                         day)
+         + 3600. * hour + 60. * min + sec;
+}
+
+static void sr_evstat_clear(sr_evstat_eval *ev)
+{
+  ev->i_eval = 0;
+  ev->i_calc = ev->slot = -1;
+  ev->rejected = 0;
+  ev->n_par = 0;
+  ev->rfac = ev->shift = ev->rgeo = ev->rtot = 0.;
+  ev->time = ev->t_leed = ev->t_rfac = -1.;
+}
+
+/* number after "key": in a trace line */
+static int sr_evstat_json_num(const char *line, const char *key, double *val)
+{
+  char *end;
+  const char *pos = strstr(line, key);
+
+  if (pos == NULL) return -1;
+  pos += strlen(key);
+  *val = strtod(pos, &end);
+  return (end == pos) ? -1 : 0;
+}
+
+static int sr_evstat_parse_json(const char *line, sr_evstat_eval *ev,
+                                int max_par)
+{
+  double val;
+  char *end;
+  const char *pos;
+
+  if (sr_evstat_json_num(line, "\"eval\":", &val) != 0) return 0;
+  ev->i_eval = (int)val;
+  if (sr_evstat_json_num(line, "\"calc\":", &val) == 0) ev->i_calc = (int)val;
+  if (sr_evstat_json_num(line, "\"slot\":", &val) == 0) ev->slot = (int)val;
+  (void)sr_evstat_json_num(line, "\"time\":", &ev->time);
+  (void)sr_evstat_json_num(line, "\"shift\":", &ev->shift);
+  (void)sr_evstat_json_num(line, "\"t_leed\":", &ev->t_leed);
+  (void)sr_evstat_json_num(line, "\"t_rfac\":", &ev->t_rfac);
+  if (sr_evstat_json_num(line, "\"rf\":", &ev->rfac) != 0 ||
+      sr_evstat_json_num(line, "\"rg\":", &ev->rgeo) != 0 ||
+      sr_evstat_json_num(line, "\"rt\":", &ev->rtot) != 0) return -1;
+  ev->rejected = (ev->i_calc == 0);
+
+  pos = strstr(line, "\"par\":[");
+  if (pos == NULL) return -1;
+  pos += 7;
+  while (*pos != ']')
+  {
+    val = strtod(pos, &end);
+    if (end == pos || ev->n_par >= max_par) return -1;
+    ev->par[++ev->n_par] = (real)val;
+    pos = end;
+    if (*pos == ',') pos++;
+  }
+  return 1;
+}
+
+static int sr_evstat_parse_log(const char *line, sr_evstat_eval *ev,
+                               int max_par)
+{
+  double val;
+  char *end;
+  const char *pos = line + 1;
+
+  ev->i_eval = (int)strtol(pos, &end, 10);
+  if (end == pos) return 0;
+  pos = end;
+  while (*pos == ' ') pos++;
+  if (strncmp(pos, "par:", 4) != 0) return 0;
+  pos += 4;
+
+  /* parameters, angles of an angle search as "theta:x phi:y" */
+  for (;;)
+  {
+    while (*pos == ' ') pos++;
+    if (strncmp(pos, "theta:", 6) == 0) pos += 6;
+    else if (strncmp(pos, "phi:", 4) == 0) pos += 4;
+    val = strtod(pos, &end);
+    if (end == pos) break;
+    if (ev->n_par >= max_par) return -1;
+    ev->par[++ev->n_par] = (real)val;
+    pos = end;
+  }
+
+  if (sscanf(pos, "**rfmax: %lf** rg:%lf rt:%lf", &ev->rfac, &ev->rgeo,
+             &ev->rtot) == 3)
+  {
+    ev->rejected = 1;
+    ev->i_calc = 0;
+  }
+  else if (sscanf(pos, "rf:%lf sh: %lf rg:%lf rt:%lf", &ev->rfac,
+                  &ev->shift, &ev->rgeo, &ev->rtot) != 4) return -1;
+
+  pos = strstr(pos, "dt:");
+  if (pos != NULL) ev->time = sr_evstat_asctime(pos + 3);
+  return 1;
+}
+
+/**
+ * @brief Read one evaluation from a log or trace line.
+ */
+int sr_evstat_parse(const char *line, sr_evstat_eval *ev, int max_par)
+{
+  sr_evstat_clear(ev);
+  if (line[0] == '{') return sr_evstat_parse_json(line, ev, max_par);
+  if (line[0] == '#') return sr_evstat_parse_log(line, ev, max_par);
+  return 0;
+}
+
+/**********************************************************************/
+
+/**
+ * @brief Set up the accumulators for @p n_par parameters.
+ */
+int sr_evstat_init(sr_evstat *st, int n_par, double r_cut)
+{
+  size_t n_var = (size_t)n_par + 1;
+
+  memset(st, 0, sizeof(*st));
+  st->n_par = n_par;
+  st->r_cut = r_cut;
+  st->r_min = HUGE_VAL;
+  st->r_max = -HUGE_VAL;
+  st->mean = (double *)calloc(n_var, sizeof(double));
+  st->com = (double *)calloc(n_var * n_var, sizeof(double));
+  st->work = (double *)calloc(2 * n_var, sizeof(double));
+  if (st->mean == NULL || st->com == NULL || st->work == NULL)
+  {
+    sr_evstat_free(st);
+    return -1;
+  }
+  sr_evstat_begin(st);
+  return 0;
+}
+
+/**
+ * @brief Start a new search.
+ */
+void sr_evstat_begin(sr_evstat *st)
+{
+  st->s_eval = 0;
+  st->s_first = 0.;
+  st->s_t0 = st->s_t1 = -1.;
+  st->n_step = st->n_step_tot = 0;
+  for (int k = 0; k < SR_EVSTAT_MAX_SLOT; k++) st->t_slot[k] = -1.;
+}
+
+static void sr_evstat_moments(sr_evstat *st, const sr_evstat_eval *ev)
+{
+  int n_var = st->n_par + 1;
+  double *x = st->work, *dx = st->work + n_var;
+
+  x[0] = ev->rfac;
+  for (int i = 1; i < n_var; i++) x[i] = (double)ev->par[i];
+
+  st->n_mom ++;
+  for (int i = 0; i < n_var; i++)
+  {
+    dx[i] = x[i] - st->mean[i];
+    st->mean[i] += dx[i] / (double)st->n_mom;
+  }
+  for (int i = 0; i < n_var; i++)
+    for (int j = 0; j < n_var; j++)
+      st->com[i * n_var + j] += dx[i] * (x[j] - st->mean[j]);
+}
+
+static void sr_evstat_step(sr_evstat *st, int i_eval, double r)
+{
+  if (st->n_step > 0 && r >= st->step_r[st->n_step - 1]) return;
+
+  if (st->n_step == SR_EVSTAT_MAX_STEP)
+  {
+    int n = 0;
+    for (int k = 0; k < st->n_step; k += 2, n++)
+    {
+      st->step_i[n] = st->step_i[k];
+      st->step_r[n] = st->step_r[k];
+    }
+    st->n_step = n;
+  }
+  st->step_i[st->n_step] = i_eval;
+  st->step_r[st->n_step] = r;
+  st->n_step ++;
+  st->n_step_tot ++;
+}
+
+static void sr_evstat_times(sr_evstat *st, const sr_evstat_eval *ev)
+{
+  if (ev->time >= 0.)
+  {
+    if (st->s_t0 < 0. || ev->time < st->s_t0) st->s_t0 = ev->time;
+    if (ev->time > st->s_t1) st->s_t1 = ev->time;
+  }
+  if (ev->t_leed < 0. || ev->t_rfac < 0.) return;
+
+  st->n_time ++;
+  st->t_leed += ev->t_leed;
+  st->t_rfac += ev->t_rfac;
+
+  /* wall time: time between two evaluations of the same slot */
+  if (ev->slot < 0 || ev->slot >= SR_EVSTAT_MAX_SLOT || ev->time < 0.)
+    return;
+  if (st->t_slot[ev->slot] >= 0. && ev->time >= st->t_slot[ev->slot])
+  {
+    st->n_wall ++;
+    st->t_wall += ev->time - st->t_slot[ev->slot];
+    st->t_wall_leed += ev->t_leed;
+    st->t_wall_rfac += ev->t_rfac;
+  }
+  st->t_slot[ev->slot] = ev->time;
+}
+
+/**
+ * @brief Add one evaluation.
+ */
+int sr_evstat_add(sr_evstat *st, const sr_evstat_eval *ev)
+{
+  if (ev->n_par != st->n_par)
+  {
+    st->n_skip ++;
+    return -1;
+  }
+
+  st->n_eval ++;
+  if (st->s_eval == 0) st->s_first = ev->rtot;
+  st->s_eval ++;
+  sr_evstat_step(st, ev->i_eval, ev->rtot);
+  sr_evstat_times(st, ev);
+
+  if (ev->rejected)
+  {
+    st->n_rejected ++;
+    return 0;
+  }
+
+  st->n_calc ++;
+  if (ev->rfac < st->r_min) st->r_min = ev->rfac;
+  if (ev->rfac > st->r_max) st->r_max = ev->rfac;
+  if (ev->rfac >= 0. && ev->rfac < SR_EVSTAT_NBIN * SR_EVSTAT_DBIN)
+    st->hist[(int)(ev->rfac / SR_EVSTAT_DBIN)] ++;
+  else
+    st->hist[SR_EVSTAT_NBIN] ++;
+
+  if (ev->rfac <= st->r_cut) sr_evstat_moments(st, ev);
+  return 0;
+}
+
+/**
+ * @brief Convergence of the current search.
+ */
+void sr_evstat_end(const sr_evstat *st, sr_evstat_conv *conv)
+{
+  static const double dr[SR_EVSTAT_N_CONV] = SR_EVSTAT_CONV_DR;
+
+  memset(conv, 0, sizeof(*conv));
+  conv->n_eval = st->s_eval;
+  conv->n_step = st->n_step_tot;
+  conv->elapsed = (st->s_t0 >= 0.) ? st->s_t1 - st->s_t0 : -1.;
+  if (st->n_step == 0) return;
+
+  conv->r_first = st->s_first;
+  conv->r_best = st->step_r[st->n_step - 1];
+  conv->i_best = st->step_i[st->n_step - 1];
+  for (int k = 0; k < SR_EVSTAT_N_CONV; k++)
+  {
+    int i_step = 0;
+    while (st->step_r[i_step] > conv->r_best + dr[k]) i_step ++;
+    conv->i_conv[k] = st->step_i[i_step];
+  }
+}
+
+/**********************************************************************/
+
+/**
+ * @brief Quantile of the R factors.
+ */
+double sr_evstat_quantile(const sr_evstat *st, double q)
+{
+  long n_want, n = 0;
+
+  if (st->n_calc == 0) return -1.;
+  n_want = (long)ceil(q * (double)st->n_calc);
+  if (n_want < 1) return st->r_min;
+  if (n_want >= st->n_calc) return st->r_max;
+
+  for (int k = 0; k < SR_EVSTAT_NBIN; k++)
+  {
+    n += st->hist[k];
+    if (n >= n_want)
+    {
+      double r = (k + 0.5) * SR_EVSTAT_DBIN;
+      return (r < st->r_min) ? st->r_min : (r > st->r_max) ? st->r_max : r;
+    }
+  }
+  return st->r_max;
+}
+
+double sr_evstat_mean(const sr_evstat *st, int i)
+{
+  return (st->n_mom > 0) ? st->mean[i] : 0.;
+}
+
+double sr_evstat_dev(const sr_evstat *st, int i)
+{
+  int n_var = st->n_par + 1;
+
+  if (st->n_mom < 2) return 0.;
+  return sqrt(st->com[i * n_var + i] / (double)(st->n_mom - 1));
+}
+
+double sr_evstat_corr(const sr_evstat *st, int i, int j)
+{
+  int n_var = st->n_par + 1;
+  double vi = st->com[i * n_var + i];
+  double vj = st->com[j * n_var + j];
+
+  if (st->n_mom < 2 || vi <= 0. || vj <= 0.) return 0.;
+  return st->com[i * n_var + j] / sqrt(vi * vj);
+}
+
+double sr_evstat_slope(const sr_evstat *st, int i_par)
+{
+  int n_var = st->n_par + 1;
+  double v = st->com[i_par * n_var + i_par];
+
+  if (st->n_mom < 2 || v <= 0.) return 0.;
+  return st->com[i_par * n_var] / v;
+}
+
+/**
+ * @brief Free the accumulators.
+ */
+void sr_evstat_free(sr_evstat *st)
+{
+  free(st->mean);
+  free(st->com);
+  free(st->work);
+  st->mean = st->com = st->work = NULL;
+}
+
+/**********************************************************************/
@@ -0,0 +1,257 @@
+/*********************************************************************
+ *                        SR_EVCACHE.C
+ *
+ *  GPL-3.0-or-later
+ *********************************************************************/
+
+/**
+ * @file sr_evcache.c
+ * @brief Cache of R factor evaluations shared by concurrent searches.
+ *
+ * A LEED evaluation takes seconds to minutes, so a parameter vector
+ * that has been evaluated before (by the same or another replica of a
+ * parallel search, or after an exchange of states) is looked up
+ * instead. Parameters are compared on a grid of resolution `res`,
+ * i.e. vectors that differ by less than res/2 in every component
+ * share one entry.
+ *
+ * The table uses open addressing and grows when it is half full. All
+ * functions may be called by several threads at the same time.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#include "search.h"
+
+struct sr_evcache
+{
+  int ndim;
+  real res;                   /* resolution of parameters */
+  size_t n_slot;              /* size of table (power of 2) */
+  size_t n_used;              /* number of entries */
+  long long *key;             /* n_slot x ndim grid coordinates */
+  real *val;                  /* n_slot values */
+  unsigned char *used;        /* n_slot flags */
+  long n_hit, n_miss;
+#if !defined(_WIN32)
+  pthread_mutex_t lock;
+#endif
+};
+
+static void sr_evcache_quantise(const struct sr_evcache *c, const real *par,
+                                long long *q)
+{
+  for (int j = 0; j < c->ndim; j++)
+  {
+    q[j] = llround((double)par[j + 1] / (double)c->res);
+  }
+}
+
+static size_t sr_evcache_hash(const long long *q, int ndim)
+{
+  uint64_t h = 1469598103934665603ULL;            /* FNV-1a */
+
+  for (int j = 0; j < ndim; j++)
+  {
+    uint64_t v = (uint64_t)q[j];
+    for (int k = 0; k < 8; k++)
+    {
+      h ^= (v >> (8 * k)) & 0xff;
+      h *= 1099511628211ULL;
+    }
+  }
+  return (size_t)h;
+}
+
+/* index of the entry for q, or of the free slot where it belongs */
+static size_t sr_evcache_find(const struct sr_evcache *c, const long long *q)
+{
+  size_t i = sr_evcache_hash(q, c->ndim) & (c->n_slot - 1);
+
+  while (c->used[i] &&
+         memcmp(c->key + i * c->ndim, q, c->ndim * sizeof(long long)) != 0)
+  {
+    i = (i + 1) & (c->n_slot - 1);
+  }
+  return i;
+}
+
+static int sr_evcache_alloc(struct sr_evcache *c, size_t n_slot)
+{
+  c->n_slot = n_slot;
+  c->n_used = 0;
+  c->key = (long long *)malloc(n_slot * c->ndim * sizeof(long long));
+  c->val = (real *)malloc(n_slot * sizeof(real));
+  c->used = (unsigned char *)calloc(n_slot, 1);
+  return (c->key != NULL && c->val != NULL && c->used != NULL) ? 0 : -1;
+}
+
+static int sr_evcache_grow(struct sr_evcache *c)
+{
+  struct sr_evcache old = *c;
+
+  if (sr_evcache_alloc(c, 2 * old.n_slot) != 0)
+  {
+    free(c->key);
+    free(c->val);
+    free(c->used);
+    c->key = old.key;
+    c->val = old.val;
+    c->used = old.used;
+    c->n_slot = old.n_slot;
+    c->n_used = old.n_used;
+    return -1;
+  }
+
+  for (size_t i = 0; i < old.n_slot; i++)
+  {
+    if (!old.used[i]) continue;
+    size_t k = sr_evcache_find(c, old.key + i * c->ndim);
+    memcpy(c->key + k * c->ndim, old.key + i * c->ndim,
+           c->ndim * sizeof(long long));
+    c->val[k] = old.val[i];
+    c->used[k] = 1;
+    c->n_used ++;
+  }
+
+  free(old.key);
+  free(old.val);
+  free(old.used);
+  return 0;
+}
+
+/**
+ * @brief Create an empty cache.
+ *
+ * @param ndim Number of parameters (vectors are `1..ndim`).
+ * @param res Resolution: parameters are compared on a grid of this size.
+ * @return Pointer to the cache, NULL on allocation failure.
+ */
+struct sr_evcache *sr_evcache_new(int ndim, real res)
+{
+  struct sr_evcache *c;
+
+  if (ndim <= 0 || !(res > 0.)) return NULL;
+  if ((c = (struct sr_evcache *)calloc(1, sizeof(struct sr_evcache))) == NULL)
+    return NULL;
+
+  c->ndim = ndim;
+  c->res = res;
+  if (sr_evcache_alloc(c, 256) != 0)
+  {
+    sr_evcache_free(c);
+    return NULL;
+  }
+#if !defined(_WIN32)
+  pthread_mutex_init(&c->lock, NULL);
+#endif
+  return c;
+}
+
+/**
+ * @brief Look up the value of a parameter vector.
+ *
+ * @param c Cache (may be NULL: nothing is found).
+ * @param par Parameters (`1..ndim`).
+ * @param val Output value, if found.
+ * @return 1 if found, 0 otherwise.
+ */
+int sr_evcache_get(struct sr_evcache *c, const real *par, real *val)
+{
+  long long q[c != NULL ? c->ndim : 1];
+  size_t i;
+  int found;
+
+  if (c == NULL) return 0;
+  sr_evcache_quantise(c, par, q);
+
+#if !defined(_WIN32)
+  pthread_mutex_lock(&c->lock);
+#endif
+  i = sr_evcache_find(c, q);
+  found = c->used[i];
+  if (found)
+  {
+    *val = c->val[i];
+    c->n_hit ++;
+  }
+  else
+    c->n_miss ++;
+#if !defined(_WIN32)
+  pthread_mutex_unlock(&c->lock);
+#endif
+
+  return found;
+}
+
+/**
+ * @brief Store the value of a parameter vector (replaces an existing
+ * entry on the same grid point).
+ *
+ * @param c Cache (may be NULL: nothing is stored).
+ * @param par Parameters (`1..ndim`).
+ * @param val Value.
+ */
+void sr_evcache_put(struct sr_evcache *c, const real *par, real val)
+{
+  long long q[c != NULL ? c->ndim : 1];
+  size_t i;
+
+  if (c == NULL) return;
+  sr_evcache_quantise(c, par, q);
+
+#if !defined(_WIN32)
+  pthread_mutex_lock(&c->lock);
+#endif
+  if (2 * (c->n_used + 1) > c->n_slot) (void)sr_evcache_grow(c);
+  i = sr_evcache_find(c, q);
+  if (!c->used[i])
+  {
+    /* the table is never full: it grows at half size, or stays at
+       most half full plus the entries added after a failed growth */
+    if (c->n_used + 1 < c->n_slot)
+    {
+      memcpy(c->key + i * c->ndim, q, c->ndim * sizeof(long long));
+      c->used[i] = 1;
+      c->n_used ++;
+      c->val[i] = val;
+    }
+  }
+  else
+    c->val[i] = val;
+#if !defined(_WIN32)
+  pthread_mutex_unlock(&c->lock);
+#endif
+}
+
+/**
+ * @brief Number of successful and failed look-ups so far.
+ */
+void sr_evcache_stats(struct sr_evcache *c, long *n_hit, long *n_miss)
+{
+  *n_hit = (c != NULL) ? c->n_hit : 0;
+  *n_miss = (c != NULL) ? c->n_miss : 0;
+}
+
+/**
+ * @brief Free the cache.
+ */
+void sr_evcache_free(struct sr_evcache *c)
+{
+  if (c == NULL) return;
+#if !defined(_WIN32)
+  if (c->key != NULL && c->val != NULL && c->used != NULL)
+    pthread_mutex_destroy(&c->lock);
+#endif
+  free(c->key);
+  free(c->val);
+  free(c->used);
+  free(c);
+}
@@ -0,0 +1,284 @@
+/*********************************************************************
+ *                        SR_EVSLOT.C
+ *
+ *  GPL-3.0-or-later
+ *********************************************************************/
+
+/**
+ * @file sr_evslot.c
+ * @brief Evaluation slots: private scratch directories for the input
+ * and output files of one LEED/R factor evaluation.
+ *
+ * sr_evalrf() used to write `<project>.par`, `.bsr`, `.res`, `.out`
+ * and `.dum` in the working directory, so that no two evaluations
+ * (threads or csearch processes in the same directory) could run at
+ * the same time. Each slot owns a directory created by mkdtemp() in
+ *
+ * - `$CSEARCH_SCRATCH` if set,
+ * - `/dev/shm` if writable (tmpfs: the files never touch the disk),
+ * - `$TMPDIR` or `/tmp` otherwise,
+ *
+ * and the file names within the slot are `<stem>.par` etc., where
+ * `<stem>` is the last component of the project name. The bulk file
+ * `<project>.bul` is only read and stays in the project directory.
+ *
+ * The "best so far" files `<project>.rmin`, `.pmin` and `.bmin` are
+ * promoted by sr_evslot_promote(): each is copied to a temporary file
+ * in the project directory and renamed, i.e. readers never see a
+ * partly written file. `<project>.rfmin` records the R factor and
+ * the process of the current minimum; the record is protected by a
+ * lock (fcntl between processes, mutex between threads), so that
+ * concurrent searches only replace the files by a better result.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#else
+#include <direct.h>
+#include <process.h>
+#define getpid _getpid
+#endif
+
+#include "search.h"
+#include "copy_file.h"
+
+#if !defined(_WIN32)
+static pthread_mutex_t sr_evslot_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* directory in which the scratch directories are created */
+static const char *sr_evslot_base(void)
+{
+  const char *base = getenv("CSEARCH_SCRATCH");
+
+  if (base != NULL && *base != '\0') return base;
+#if !defined(_WIN32)
+  if (access("/dev/shm", W_OK | X_OK) == 0) return "/dev/shm";
+  base = getenv("TMPDIR");
+  if (base != NULL && *base != '\0') return base;
+  return "/tmp";
+#else
+  base = getenv("TEMP");
+  if (base != NULL && *base != '\0') return base;
+  return ".";
+#endif
+}
+
+static int sr_evslot_path(char *path, const char *dir, const char *stem,
+                          const char *ext)
+{
+  int len = snprintf(path, SR_PATHSZ, "%s/%s.%s", dir, stem, ext);
+
+  return (len < 0 || len >= SR_PATHSZ) ? -1 : 0;
+}
+
+/**
+ * @brief Create the scratch directory of a slot and set up its file
+ * names.
+ *
+ * @param slot Slot to be initialised.
+ * @param project Project name (path prefix of the input files).
+ * @param id Number of the slot (part of the directory name).
+ * @return 0 on success, -1 if the directory cannot be created.
+ */
+int sr_evslot_open(struct sr_evslot *slot, const char *project, int id)
+{
+  const char *stem;
+  int len;
+
+  memset(slot, 0, sizeof(struct sr_evslot));
+  slot->id = id;
+
+  if (project == NULL || *project == '\0') return -1;
+  stem = strrchr(project, '/');
+  stem = (stem != NULL) ? stem + 1 : project;
+  if (*stem == '\0') return -1;
+
+#if !defined(_WIN32)
+  len = snprintf(slot->dir, SR_PATHSZ, "%s/csearch-%d-%d-XXXXXX",
+                 sr_evslot_base(), (int)getpid(), id);
+  if (len < 0 || len >= SR_PATHSZ || mkdtemp(slot->dir) == NULL)
+  {
+    slot->dir[0] = '\0';
+    return -1;
+  }
+#else
+  len = snprintf(slot->dir, SR_PATHSZ, "%s/csearch-%d-%d",
+                 sr_evslot_base(), (int)getpid(), id);
+  if (len < 0 || len >= SR_PATHSZ || _mkdir(slot->dir) != 0)
+  {
+    slot->dir[0] = '\0';
+    return -1;
+  }
+#endif
+
+  len = snprintf(slot->bul_file, SR_PATHSZ, "%s.bul", project);
+  if (len < 0 || len >= SR_PATHSZ ||
+      sr_evslot_path(slot->par_file, slot->dir, stem, "par") ||
+      sr_evslot_path(slot->bsr_file, slot->dir, stem, "bsr") ||
+      sr_evslot_path(slot->res_file, slot->dir, stem, "res") ||
+      sr_evslot_path(slot->out_file, slot->dir, stem, "out") ||
+      sr_evslot_path(slot->dum_file, slot->dir, stem, "dum") ||
+      sr_evslot_path(slot->yres_file, slot->dir, stem, "yres"))
+  {
+    sr_evslot_close(slot);
+    return -1;
+  }
+
+  return 0;
+}
+
+/* copy old_file to a temporary file and rename it to new_file */
+static int sr_evslot_replace(const char *old_file, const char *new_file)
+{
+  char tmp_file[SR_PATHSZ + 32];
+
+  (void)snprintf(tmp_file, sizeof(tmp_file), "%s.%d.tmp",
+                 new_file, (int)getpid());
+  if (copy_file((char *)old_file, tmp_file) != 0)
+  {
+    remove(tmp_file);
+    return -1;
+  }
+#if defined(_WIN32)
+  remove(new_file);                 /* rename does not replace on Windows */
+#endif
+  if (rename(tmp_file, new_file) != 0)
+  {
+    remove(tmp_file);
+    return -1;
+  }
+  return 0;
+}
+
+#if !defined(_WIN32)
+/* current minimum recorded in fd: 1 if valid (recording process alive) */
+static int sr_evslot_read_min(int fd, real *rfac)
+{
+  char buffer[64];
+  ssize_t n;
+  long pid;
+
+  if (lseek(fd, 0, SEEK_SET) != 0 ||
+      (n = read(fd, buffer, sizeof(buffer) - 1)) <= 0)
+    return 0;
+  buffer[n] = '\0';
+
+#ifdef REAL_IS_DOUBLE
+  if (sscanf(buffer, "%lf %ld", rfac, &pid) != 2) return 0;
+#else
+  if (sscanf(buffer, "%f %ld", rfac, &pid) != 2) return 0;
+#endif
+
+  /* records of terminated searches are ignored */
+  return (kill((pid_t)pid, 0) == 0 || errno == EPERM);
+}
+#endif
+
+/**
+ * @brief Promote the files of a slot to `<project>.rmin` (results),
+ * `.pmin` (parameters) and `.bmin` (bulk file), if rfac is lower than
+ * the minimum of all running searches in this project directory.
+ *
+ * @param slot Slot of the evaluation.
+ * @param project Project name.
+ * @param rfac R factor of the evaluation.
+ * @return 1 if the files have been replaced, 0 if a better result
+ *         exists, -1 on error.
+ */
+int sr_evslot_promote(const struct sr_evslot *slot, const char *project,
+                      real rfac)
+{
+  char rmin_file[SR_PATHSZ], pmin_file[SR_PATHSZ], bmin_file[SR_PATHSZ];
+  char rf_file[SR_PATHSZ];
+  int ret = 1;
+#if !defined(_WIN32)
+  char buffer[64];
+  struct flock fl;
+  real rfac_min;
+  int fd, len;
+#endif
+
+  if (snprintf(rmin_file, SR_PATHSZ, "%s.rmin", project) >= SR_PATHSZ ||
+      snprintf(pmin_file, SR_PATHSZ, "%s.pmin", project) >= SR_PATHSZ ||
+      snprintf(bmin_file, SR_PATHSZ, "%s.bmin", project) >= SR_PATHSZ ||
+      snprintf(rf_file, SR_PATHSZ, "%s.rfmin", project) >= SR_PATHSZ)
+    return -1;
+
+#if !defined(_WIN32)
+  pthread_mutex_lock(&sr_evslot_lock);
+
+  if ((fd = open(rf_file, O_RDWR | O_CREAT, 0644)) == -1)
+  {
+    pthread_mutex_unlock(&sr_evslot_lock);
+    return -1;
+  }
+  memset(&fl, 0, sizeof(fl));
+  fl.l_type = F_WRLCK;
+  fl.l_whence = SEEK_SET;
+  while (fcntl(fd, F_SETLKW, &fl) == -1 && errno == EINTR);
+
+  if (sr_evslot_read_min(fd, &rfac_min) && !(rfac < rfac_min)) ret = 0;
+#else
+  (void)rf_file;
+#endif
+
+  if (ret == 1 &&
+      (sr_evslot_replace(slot->res_file, rmin_file) ||
+       sr_evslot_replace(slot->par_file, pmin_file) ||
+       sr_evslot_replace(slot->bsr_file, bmin_file)))
+    ret = -1;
+
+#if !defined(_WIN32)
+  if (ret == 1)
+  {
+    len = snprintf(buffer, sizeof(buffer), "%.6f %ld\n",
+                   (double)rfac, (long)getpid());
+    if (ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) != 0 ||
+        write(fd, buffer, len) != len)
+      ret = -1;
+  }
+
+  fl.l_type = F_UNLCK;
+  fcntl(fd, F_SETLK, &fl);
+  close(fd);
+  pthread_mutex_unlock(&sr_evslot_lock);
+#endif
+
+  return ret;
+}
+
+/**
+ * @brief Remove the files and the scratch directory of a slot.
+ *
+ * @param slot Slot opened by sr_evslot_open() (may be closed already).
+ */
+void sr_evslot_close(struct sr_evslot *slot)
+{
+  if (slot == NULL) return;
+  sr_geo_free(&slot->geo);
+  if (slot->dir[0] == '\0') return;
+
+  if (slot->par_file[0] != '\0') remove(slot->par_file);
+  if (slot->bsr_file[0] != '\0') remove(slot->bsr_file);
+  if (slot->res_file[0] != '\0') remove(slot->res_file);
+  if (slot->out_file[0] != '\0') remove(slot->out_file);
+  if (slot->dum_file[0] != '\0') remove(slot->dum_file);
+  if (slot->yres_file[0] != '\0') remove(slot->yres_file);
+#if !defined(_WIN32)
+  rmdir(slot->dir);
+#else
+  _rmdir(slot->dir);
+#endif
+  slot->dir[0] = '\0';
+}
@@ -0,0 +1,421 @@
+/*********************************************************************
+ *                        SR_LEVMAR.C
+ *
+ *  GPL-3.0-or-later
+ *
+ *  Levenberg-Marquardt least squares fit with a finite difference
+ *  Jacobian whose columns are evaluated in parallel.
+ *
+ *  Legacy SEARCH conventions:
+ *  - parameter vectors are stored in p[1..ndim]
+ *  - residual vectors are stored in r[1..n_res]
+ *********************************************************************/
+
+/**
+ * @file sr_levmar.c
+ * @brief Levenberg-Marquardt minimisation of a sum of squares (SEARCH).
+ *
+ * The simplex and Powell searches only see the R factor, i.e. a single
+ * number per LEED calculation. Pendry's R factor is a sum of squares
+ * of residuals (differences of the Y functions at each energy, see
+ * cr_yres()); fitting the residual vector uses much more of the
+ * information of each calculation:
+ *
+ * - the Jacobian J (n_res x ndim) is estimated by forward differences
+ *   (ndim evaluations) or central differences (2 ndim evaluations).
+ *   The columns are independent and are evaluated by up to `n_jobs`
+ *   threads at the same time, i.e. each Jacobian costs about one LEED
+ *   calculation of wall time if n_jobs >= ndim;
+ * - the step solves (J^T J + lambda diag(J^T J)) dp = - J^T r
+ *   (Cholesky decomposition); a step is accepted if the sum of squares
+ *   decreases, otherwise lambda is increased tenfold and the step is
+ *   tried again without a new Jacobian.
+ *
+ * The residual function may minimise an auxiliary variable itself
+ * (the energy shift of the R factor): full evaluations return it,
+ * the Jacobian is evaluated with the value of the current point, so
+ * that all columns have the same number of residuals.
+ *
+ * The search stops after `max_iter` Jacobians, if the relative decrease
+ * of the sum of squares is below `ftol`, if the step is much smaller
+ * than the finite difference step, or if no step is accepted for lambda
+ * up to SR_LM_LAMBDA_MAX.
+ */
+
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+
+#include "search.h"
+#include "sr_alloc.h"
+
+#if !defined(_WIN32)
+#define SR_LEVMAR_THREAD
+#include <pthread.h>
+#endif
+
+#define SR_LM_MAX_JOBS    64      /* maximum number of threads */
+#define SR_LM_LAMBDA_INI  1.e-3   /* default initial damping */
+#define SR_LM_LAMBDA_MIN  1.e-7
+#define SR_LM_LAMBDA_MAX  1.e+7   /* give up if no step is accepted */
+#define SR_LM_XTOL        1.e-3   /* smallest step in units of cfg->h */
+
+typedef struct sr_levmar_ctx {
+  const sr_levmar_cfg *cfg;
+  int ndim;
+  int n_res;                 /* number of residuals at the current point */
+  int n_col;                 /* ndim (forward) or 2 ndim (central) */
+  const real *p;             /* current point */
+  real aux;                  /* auxiliary variable of the current point */
+  real **col;                /* col[1..n_col][1..n_res]: displaced residuals */
+  int *col_ok;               /* col_ok[1..n_col] */
+  real **pt;                 /* pt[1..n_jobs]: displaced points */
+  int i_next;                /* next column */
+#ifdef SR_LEVMAR_THREAD
+  pthread_mutex_t lock;
+#endif
+} sr_levmar_ctx;
+
+typedef struct sr_levmar_job {
+  sr_levmar_ctx *ctx;
+  int i_job;
+} sr_levmar_job;
+
+/* sum of squares */
+static real sr_levmar_chi2(const real *r, int n_res)
+{
+  real chi2 = 0.;
+  for (int i = 1; i <= n_res; i++) chi2 += r[i] * r[i];
+  return chi2;
+}
+
+/* residuals for column i_col (parameter j displaced by +h or -h) */
+static void sr_levmar_column(sr_levmar_ctx *ctx, int i_job, int i_col)
+{
+  const sr_levmar_cfg *cfg = ctx->cfg;
+  real *pt = ctx->pt[i_job + 1];
+  int j = (i_col - 1) % ctx->ndim + 1;
+  real aux = ctx->aux;
+  void *data = (cfg->data != NULL) ? cfg->data[i_job] : NULL;
+  int n;
+
+  for (int k = 1; k <= ctx->ndim; k++) pt[k] = ctx->p[k];
+  pt[j] += (i_col <= ctx->ndim) ? cfg->h : - cfg->h;
+
+  n = (*cfg->func)(pt, ctx->col[i_col], cfg->n_max, &aux, 1, data);
+  ctx->col_ok[i_col] = (n == ctx->n_res);
+}
+
+static void *sr_levmar_worker(void *arg)
+{
+  sr_levmar_job *job = (sr_levmar_job *)arg;
+  sr_levmar_ctx *ctx = job->ctx;
+
+  for (;;)
+  {
+    int i_col;
+#ifdef SR_LEVMAR_THREAD
+    pthread_mutex_lock(&ctx->lock);
+#endif
+    i_col = ++ ctx->i_next;
+#ifdef SR_LEVMAR_THREAD
+    pthread_mutex_unlock(&ctx->lock);
+#endif
+    if (i_col > ctx->n_col) break;
+    sr_levmar_column(ctx, job->i_job, i_col);
+  }
+
+  return NULL;
+}
+
+/* all columns of the Jacobian, using up to n_jobs threads */
+static void sr_levmar_jacobian(sr_levmar_ctx *ctx, int n_jobs)
+{
+  sr_levmar_job job[SR_LM_MAX_JOBS];
+#ifdef SR_LEVMAR_THREAD
+  pthread_t thread[SR_LM_MAX_JOBS];
+  int started[SR_LM_MAX_JOBS];
+#endif
+
+  ctx->i_next = 0;
+  for (int i_job = 0; i_job < n_jobs; i_job++)
+  {
+    job[i_job].ctx = ctx;
+    job[i_job].i_job = i_job;
+  }
+
+#ifdef SR_LEVMAR_THREAD
+  /* this thread is one of the workers */
+  for (int i_job = 1; i_job < n_jobs; i_job++)
+  {
+    started[i_job] = (pthread_create(thread + i_job, NULL,
+                                     sr_levmar_worker, job + i_job) == 0);
+#ifdef WARNING
+    if (!started[i_job])
+      fprintf(STDWAR, "* warning (sr_levmar): cannot start thread %d\n",
+              i_job);
+#endif
+  }
+#endif
+
+  sr_levmar_worker(job);
+
+#ifdef SR_LEVMAR_THREAD
+  for (int i_job = 1; i_job < n_jobs; i_job++)
+  {
+    if (started[i_job]) pthread_join(thread[i_job], NULL);
+  }
+#endif
+}
+
+/*
+  normal equations a = J^T J, g = J^T r from the displaced residuals;
+  failed columns give zero rows/columns. Returns the number of
+  usable columns.
+*/
+static int sr_levmar_normal(const sr_levmar_ctx *ctx, const real *r,
+                            real **jac, real **a, real *g)
+{
+  int ndim = ctx->ndim, n_ok = 0;
+  real h = ctx->cfg->h;
+
+  for (int j = 1; j <= ndim; j++)
+  {
+    int ok = ctx->col_ok[j];
+    if (ctx->n_col > ndim) ok = ok && ctx->col_ok[j + ndim];
+    n_ok += ok;
+
+    for (int i = 1; i <= ctx->n_res; i++)
+    {
+      if (!ok) jac[j][i] = 0.;
+      else if (ctx->n_col > ndim)
+        jac[j][i] = (ctx->col[j][i] - ctx->col[j + ndim][i]) / (2. * h);
+      else
+        jac[j][i] = (ctx->col[j][i] - r[i]) / h;
+    }
+  }
+
+  for (int j = 1; j <= ndim; j++)
+  {
+    g[j] = 0.;
+    for (int i = 1; i <= ctx->n_res; i++) g[j] += jac[j][i] * r[i];
+    for (int k = 1; k <= j; k++)
+    {
+      real sum = 0.;
+      for (int i = 1; i <= ctx->n_res; i++) sum += jac[j][i] * jac[k][i];
+      a[j][k] = a[k][j] = sum;
+    }
+  }
+
+  return n_ok;
+}
+
+/*
+  solve (a + lambda diag(a)) dp = -g by Cholesky decomposition
+  (l: work matrix). Parameters without influence (a_jj = 0) are damped
+  with lambda alone, i.e. they do not move. Returns 0 on success.
+*/
+static int sr_levmar_solve(real **a, const real *g, real lambda, int ndim,
+                           real **l, real *dp)
+{
+  for (int j = 1; j <= ndim; j++)
+  {
+    for (int k = 1; k <= j; k++)
+    {
+      real sum = a[j][k];
+      if (k == j) sum += lambda * ((a[j][j] > 0.) ? a[j][j] : 1.);
+      for (int m = 1; m < k; m++) sum -= l[j][m] * l[k][m];
+
+      if (k == j)
+      {
+        if (!(sum > 0.)) return -1;
+        l[j][j] = R_sqrt(sum);
+      }
+      else l[j][k] = sum / l[k][k];
+    }
+  }
+
+  /* forward and back substitution */
+  for (int j = 1; j <= ndim; j++)
+  {
+    real sum = - g[j];
+    for (int m = 1; m < j; m++) sum -= l[j][m] * dp[m];
+    dp[j] = sum / l[j][j];
+  }
+  for (int j = ndim; j >= 1; j--)
+  {
+    real sum = dp[j];
+    for (int m = j + 1; m <= ndim; m++) sum -= l[m][j] * dp[m];
+    dp[j] = sum / l[j][j];
+  }
+
+  return 0;
+}
+
+static int sr_levmar_validate(const real *p, int ndim, const real *chi2,
+                              const sr_levmar_cfg *cfg)
+{
+  if (p == NULL || chi2 == NULL || cfg == NULL || cfg->func == NULL ||
+      ndim <= 0 || cfg->n_max <= 0 || !(cfg->h > 0.)) return -1;
+  return 0;
+}
+
+/**
+ * @brief Levenberg-Marquardt minimisation of the sum of squares of the
+ * residuals of `cfg->func`.
+ *
+ * @param p In/out parameter vector (`1..ndim`): start point on input,
+ *          best point on return.
+ * @param ndim Dimensionality of the parameter vector.
+ * @param chi2 Output sum of squares at @p p.
+ * @param cfg Finite difference step, tolerances and residual function.
+ * @param n_iter Output number of Jacobians (may be NULL).
+ * @param n_eval Output number of residual evaluations (may be NULL).
+ * @return 0 on success, -1 on invalid input, allocation failure or if
+ *         the residuals of the start point cannot be evaluated.
+ */
+int sr_levmar(real *p, int ndim, real *chi2, const sr_levmar_cfg *cfg,
+              int *n_iter, int *n_eval)
+{
+  sr_levmar_ctx ctx;
+  int n_jobs, n_col, iter = 0, evals = 0, ret = 0;
+  real lambda, aux = 0., aux_t = 0.;
+  real *r, *rt, *g, *dp, *ptrial;
+  real **a, **l, **jac;
+
+  if (sr_levmar_validate(p, ndim, chi2, cfg) != 0) return -1;
+
+  n_col = cfg->central ? 2 * ndim : ndim;
+  n_jobs = (cfg->n_jobs < 1) ? 1 : cfg->n_jobs;
+  if (n_jobs > n_col) n_jobs = n_col;
+  if (n_jobs > SR_LM_MAX_JOBS) n_jobs = SR_LM_MAX_JOBS;
+#ifndef SR_LEVMAR_THREAD
+  n_jobs = 1;
+#endif
+
+  r = sr_alloc_vector((size_t)cfg->n_max);
+  rt = sr_alloc_vector((size_t)cfg->n_max);
+  g = sr_alloc_vector((size_t)ndim);
+  dp = sr_alloc_vector((size_t)ndim);
+  ptrial = sr_alloc_vector((size_t)ndim);
+  a = sr_alloc_matrix((size_t)ndim, (size_t)ndim);
+  l = sr_alloc_matrix((size_t)ndim, (size_t)ndim);
+  jac = sr_alloc_matrix((size_t)ndim, (size_t)cfg->n_max);
+  ctx.col = sr_alloc_matrix((size_t)n_col, (size_t)cfg->n_max);
+  ctx.pt = sr_alloc_matrix((size_t)n_jobs, (size_t)ndim);
+  ctx.col_ok = (int *)calloc((size_t)n_col + 1, sizeof(int));
+
+  if (r == NULL || rt == NULL || g == NULL || dp == NULL || ptrial == NULL ||
+      a == NULL || l == NULL || jac == NULL || ctx.col == NULL ||
+      ctx.pt == NULL || ctx.col_ok == NULL) ret = -1;
+
+  ctx.cfg = cfg;
+  ctx.ndim = ndim;
+  ctx.n_col = n_col;
+  ctx.p = p;
+#ifdef SR_LEVMAR_THREAD
+  pthread_mutex_init(&ctx.lock, NULL);
+#endif
+
+  /* start point: residuals and auxiliary variable */
+  if (ret == 0)
+  {
+    ctx.n_res = (*cfg->func)(p, r, cfg->n_max, &aux, 0,
+                             (cfg->data != NULL) ? cfg->data[0] : NULL);
+    evals ++;
+    if (ctx.n_res < 1 || ctx.n_res > cfg->n_max) ret = -1;
+    else *chi2 = sr_levmar_chi2(r, ctx.n_res);
+  }
+
+  lambda = (cfg->lambda > 0.) ? cfg->lambda : SR_LM_LAMBDA_INI;
+
+  while (ret == 0 && iter < cfg->max_iter)
+  {
+    real chi2_t = 0.;
+    int accepted = 0;
+
+    /* Jacobian at p (auxiliary variable fixed) */
+    ctx.aux = aux;
+    sr_levmar_jacobian(&ctx, n_jobs);
+    evals += n_col;
+    iter ++;
+    if (sr_levmar_normal(&ctx, r, jac, a, g) == 0) break;
+
+    /* increase damping until the sum of squares decreases */
+    while (!accepted && lambda <= SR_LM_LAMBDA_MAX)
+    {
+      int n_t;
+
+      if (sr_levmar_solve(a, g, lambda, ndim, l, dp) != 0)
+      {
+        lambda *= 10.;
+        continue;
+      }
+
+      /* converged: the step is far below the finite difference step */
+      {
+        real dp_max = 0.;
+        for (int j = 1; j <= ndim; j++)
+          if (R_fabs(dp[j]) > dp_max) dp_max = R_fabs(dp[j]);
+        if (dp_max < SR_LM_XTOL * cfg->h) break;
+      }
+
+      for (int j = 1; j <= ndim; j++) ptrial[j] = p[j] + dp[j];
+      n_t = (*cfg->func)(ptrial, rt, cfg->n_max, &aux_t, 0,
+                         (cfg->data != NULL) ? cfg->data[0] : NULL);
+      evals ++;
+
+      if (n_t >= 1 && n_t <= cfg->n_max &&
+          (chi2_t = sr_levmar_chi2(rt, n_t)) < *chi2) accepted = 1;
+      else lambda *= 10.;
+
+#ifdef CONTROL
+      fprintf(STDCTR, "(sr_levmar): iter %d lambda = %.1e chi2 = %.6f %s\n",
+              iter, (double)lambda, (double)chi2_t,
+              accepted ? "accepted" : "rejected");
+#endif
+
+      if (accepted)
+      {
+        real *swap = r;
+        r = rt;
+        rt = swap;
+        for (int j = 1; j <= ndim; j++) p[j] = ptrial[j];
+        ctx.n_res = n_t;
+        aux = aux_t;
+      }
+    }
+
+    if (!accepted) break;
+
+    lambda = (lambda / 10. > SR_LM_LAMBDA_MIN) ? lambda / 10. :
+             SR_LM_LAMBDA_MIN;
+    {
+      real decrease = *chi2 - chi2_t;
+      *chi2 = chi2_t;
+      if (decrease <= cfg->ftol * chi2_t) break;
+    }
+  }
+
+#ifdef SR_LEVMAR_THREAD
+  pthread_mutex_destroy(&ctx.lock);
+#endif
+  sr_free_vector(r);
+  sr_free_vector(rt);
+  sr_free_vector(g);
+  sr_free_vector(dp);
+  sr_free_vector(ptrial);
+  sr_free_matrix(a);
+  sr_free_matrix(l);
+  sr_free_matrix(jac);
+  sr_free_matrix(ctx.col);
+  sr_free_matrix(ctx.pt);
+  free(ctx.col_ok);
+
+  if (n_iter != NULL) *n_iter = iter;
+  if (n_eval != NULL) *n_eval = evals;
+  return ret;
+}
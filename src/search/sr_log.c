@@ -0,0 +1,487 @@
+/*********************************************************************
+ *                        SR_LOG.C
+ *
+ *  GPL-3.0-or-later
+ *********************************************************************/
+
+/**
+ * @file sr_log.c
+ * @brief Search log (<project>.log) written by a background thread.
+ *
+ * The drivers and sr_evalrf write blocks of lines to the log file:
+ *
+ *   FILE *log_stream = sr_log_begin(log_file);
+ *   fprintf(log_stream, ...);
+ *   sr_log_end(log_stream);
+ *
+ * Once sr_log_open() has started the writer thread, sr_log_begin()
+ * returns a memory stream; sr_log_end() copies the block into a ring
+ * buffer of SR_LOG_BUFSZ bytes, from which the writer thread appends it
+ * to the file (kept open until sr_log_close()). Blocks of concurrent
+ * evaluations are therefore never interleaved, and the searches do not
+ * wait for the file system; the files are synced every SR_LOG_SYNC
+ * seconds and when the log is closed (at exit). Without writer thread,
+ * sr_log_begin() opens the file for appending as before.
+ *
+ * sr_log_record() writes one JSON line per evaluation (parameters,
+ * R factor, shift, timings, slot) to an optional record file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !defined(_WIN32)
+#define SR_LOG_THREAD
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "search.h"
+
+#define SR_LOG_BUFSZ     (256 * 1024)  /* size of ring buffer (bytes) */
+#define SR_LOG_MAX_FILE  64            /* files of the writer thread */
+#define SR_LOG_MAX_OPEN  64            /* blocks formatted at the same time */
+#define SR_LOG_SYNC      5             /* seconds between fsync */
+
+typedef struct sr_log_hdr
+{
+  int i_file;                 /* index of file */
+  size_t len;                 /* number of bytes following */
+} sr_log_hdr;
+
+typedef struct sr_log_block
+{
+  FILE *stream;               /* memory stream (NULL: free) */
+  char *buf;
+  size_t size;
+  int i_file;
+} sr_log_block;
+
+static char *sr_log_rec_file = NULL;   /* record file (JSON lines) */
+
+#ifdef SR_LOG_THREAD
+
+static struct
+{
+  pthread_mutex_t lock;
+  pthread_cond_t more;        /* data queued or stop */
+  pthread_cond_t room;        /* data taken by the writer */
+  pthread_cond_t done;        /* data written */
+  pthread_t writer;
+  int running;
+  int stop;
+  char *ring;
+  size_t n_in, n_out, n_done; /* bytes queued, taken, written */
+  int n_file;
+  char *name[SR_LOG_MAX_FILE];
+  FILE *fp[SR_LOG_MAX_FILE];  /* used by the writer thread only */
+  sr_log_block block[SR_LOG_MAX_OPEN];
+} sr_log = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+  .more = PTHREAD_COND_INITIALIZER,
+  .room = PTHREAD_COND_INITIALIZER,
+  .done = PTHREAD_COND_INITIALIZER
+};
+
+/* index of file name in the table (added if new), -1 if full; lock held */
+static int sr_log_file_index(const char *file)
+{
+  for (int i = 0; i < sr_log.n_file; i++)
+    if (strcmp(sr_log.name[i], file) == 0) return i;
+
+  if (sr_log.n_file >= SR_LOG_MAX_FILE) return -1;
+  sr_log.name[sr_log.n_file] = strdup(file);
+  if (sr_log.name[sr_log.n_file] == NULL) return -1;
+  return sr_log.n_file ++;
+}
+
+static void sr_log_ring_in(const void *src, size_t n)
+{
+  size_t pos = sr_log.n_in % SR_LOG_BUFSZ;
+  size_t first = (n < SR_LOG_BUFSZ - pos) ? n : SR_LOG_BUFSZ - pos;
+
+  memcpy(sr_log.ring + pos, src, first);
+  memcpy(sr_log.ring, (const char *)src + first, n - first);
+  sr_log.n_in += n;
+}
+
+static void sr_log_ring_out(void *dst, size_t n)
+{
+  size_t pos = sr_log.n_out % SR_LOG_BUFSZ;
+  size_t first = (n < SR_LOG_BUFSZ - pos) ? n : SR_LOG_BUFSZ - pos;
+
+  memcpy(dst, sr_log.ring + pos, first);
+  memcpy((char *)dst + first, sr_log.ring, n - first);
+  sr_log.n_out += n;
+}
+
+/*
+  queue len bytes for file i_file; lock held. Blocks larger than half
+  the ring buffer are split (and may then be interleaved with others).
+*/
+static void sr_log_queue(int i_file, const char *buf, size_t len)
+{
+  sr_log_hdr hdr;
+
+  hdr.i_file = i_file;
+  while (len > 0)
+  {
+    hdr.len = (len < SR_LOG_BUFSZ / 2) ? len : SR_LOG_BUFSZ / 2;
+    while (SR_LOG_BUFSZ - (sr_log.n_in - sr_log.n_out) < sizeof(hdr) + hdr.len)
+      pthread_cond_wait(&sr_log.room, &sr_log.lock);
+
+    sr_log_ring_in(&hdr, sizeof(hdr));
+    sr_log_ring_in(buf, hdr.len);
+    buf += hdr.len;
+    len -= hdr.len;
+  }
+  pthread_cond_signal(&sr_log.more);
+}
+
+static void sr_log_sync_all(void)
+{
+  for (int i = 0; i < SR_LOG_MAX_FILE; i++)
+    if (sr_log.fp[i] != NULL) fsync(fileno(sr_log.fp[i]));
+}
+
+/* append a batch of queued blocks to the files */
+static void sr_log_write_batch(const char *batch, size_t n)
+{
+  int touched[SR_LOG_MAX_FILE] = {0};
+  sr_log_hdr hdr;
+
+  for (size_t pos = 0; pos < n; pos += sizeof(hdr) + hdr.len)
+  {
+    memcpy(&hdr, batch + pos, sizeof(hdr));
+
+    if (sr_log.fp[hdr.i_file] == NULL)
+    {
+      sr_log.fp[hdr.i_file] = fopen(sr_log.name[hdr.i_file], "a");
+      if (sr_log.fp[hdr.i_file] == NULL)
+      {
+        /* no exit on the writer thread: drop the block and go on */
+        fprintf(STDERR, "* warning (sr_log): cannot open \"%s\", "
+                "block dropped\n", sr_log.name[hdr.i_file]);
+        continue;
+      }
+    }
+    fwrite(batch + pos + sizeof(hdr), 1, hdr.len, sr_log.fp[hdr.i_file]);
+    touched[hdr.i_file] = 1;
+  }
+
+  for (int i = 0; i < SR_LOG_MAX_FILE; i++)
+    if (touched[i]) fflush(sr_log.fp[i]);
+}
+
+static void *sr_log_writer(void *arg)
+{
+  char *batch = (char *)arg;
+  time_t t_sync = time(NULL);
+  int unsynced = 0;
+  struct timespec ts;
+
+  pthread_mutex_lock(&sr_log.lock);
+  for (;;)
+  {
+    if (sr_log.n_in == sr_log.n_out)
+    {
+      if (sr_log.stop) break;
+
+      clock_gettime(CLOCK_REALTIME, &ts);
+      ts.tv_sec += SR_LOG_SYNC;
+      if (pthread_cond_timedwait(&sr_log.more, &sr_log.lock, &ts) == ETIMEDOUT
+          && unsynced)
+      {
+        pthread_mutex_unlock(&sr_log.lock);
+        sr_log_sync_all();
+        pthread_mutex_lock(&sr_log.lock);
+        t_sync = time(NULL);
+        unsynced = 0;
+      }
+      continue;
+    }
+
+    size_t n = sr_log.n_in - sr_log.n_out;
+    sr_log_ring_out(batch, n);
+    pthread_cond_broadcast(&sr_log.room);
+    pthread_mutex_unlock(&sr_log.lock);
+
+    sr_log_write_batch(batch, n);
+    unsynced = 1;
+    if (time(NULL) - t_sync >= SR_LOG_SYNC)
+    {
+      sr_log_sync_all();
+      t_sync = time(NULL);
+      unsynced = 0;
+    }
+
+    pthread_mutex_lock(&sr_log.lock);
+    sr_log.n_done += n;
+    pthread_cond_broadcast(&sr_log.done);
+  }
+  pthread_mutex_unlock(&sr_log.lock);
+
+  sr_log_sync_all();
+  for (int i = 0; i < SR_LOG_MAX_FILE; i++)
+  {
+    if (sr_log.fp[i] != NULL) fclose(sr_log.fp[i]);
+    sr_log.fp[i] = NULL;
+  }
+  return batch;
+}
+
+#endif /* SR_LOG_THREAD */
+
+/**
+ * @brief Start the writer thread of the log files.
+ *
+ * @param rec_file Record file (one JSON line per evaluation, truncated),
+ *        NULL: none.
+ * If the writer thread cannot be started, sr_log_begin() opens the
+ * files directly.
+ *
+ * @return 0 on success, -1 if the record file cannot be created.
+ */
+int sr_log_open(const char *rec_file)
+{
+  free(sr_log_rec_file);
+  sr_log_rec_file = NULL;
+  if (rec_file != NULL)
+  {
+    FILE *fp = fopen(rec_file, "w");
+    if (fp == NULL)
+    {
+      OPEN_ERROR(rec_file);
+      return -1;
+    }
+    fclose(fp);
+    sr_log_rec_file = strdup(rec_file);
+  }
+
+#ifdef SR_LOG_THREAD
+  static int registered = 0;
+  char *batch;
+
+  if (sr_log.running) return 0;
+
+  sr_log.ring = (char *)malloc(SR_LOG_BUFSZ);
+  batch = (char *)malloc(SR_LOG_BUFSZ);
+  if (sr_log.ring == NULL || batch == NULL)
+  {
+    free(sr_log.ring);
+    free(batch);
+    sr_log.ring = NULL;
+    return 0;
+  }
+
+  sr_log.n_in = sr_log.n_out = sr_log.n_done = 0;
+  sr_log.stop = 0;
+  if (pthread_create(&sr_log.writer, NULL, sr_log_writer, batch) != 0)
+  {
+#ifdef WARNING
+    fprintf(STDWAR, "* warning (sr_log_open): cannot create writer thread, "
+            "log files are written directly\n");
+#endif
+    free(sr_log.ring);
+    free(batch);
+    sr_log.ring = NULL;
+    return 0;
+  }
+
+  pthread_mutex_lock(&sr_log.lock);
+  sr_log.running = 1;
+  pthread_mutex_unlock(&sr_log.lock);
+
+  if (!registered) atexit(sr_log_close);
+  registered = 1;
+#endif
+  return 0;
+}
+
+/**
+ * @brief Wait until everything queued so far has been written.
+ */
+void sr_log_flush(void)
+{
+#ifdef SR_LOG_THREAD
+  pthread_mutex_lock(&sr_log.lock);
+  if (sr_log.running)
+  {
+    size_t target = sr_log.n_in;
+    pthread_cond_signal(&sr_log.more);
+    while (sr_log.n_done < target)
+      pthread_cond_wait(&sr_log.done, &sr_log.lock);
+  }
+  pthread_mutex_unlock(&sr_log.lock);
+#endif
+}
+
+/**
+ * @brief Write everything queued, sync and close the files and stop the
+ * writer thread (registered with atexit by sr_log_open()).
+ */
+void sr_log_close(void)
+{
+#ifdef SR_LOG_THREAD
+  char *batch = NULL;
+
+  pthread_mutex_lock(&sr_log.lock);
+  if (!sr_log.running)
+  {
+    pthread_mutex_unlock(&sr_log.lock);
+    return;
+  }
+  sr_log.stop = 1;
+  pthread_cond_signal(&sr_log.more);
+  pthread_mutex_unlock(&sr_log.lock);
+
+  pthread_join(sr_log.writer, (void **)&batch);
+
+  /* the file names are kept for blocks still being formatted */
+  pthread_mutex_lock(&sr_log.lock);
+  sr_log.running = 0;
+  free(sr_log.ring);
+  sr_log.ring = NULL;
+  pthread_mutex_unlock(&sr_log.lock);
+  free(batch);
+#endif
+}
+
+/**
+ * @brief Stream for one block of lines of @p log_file.
+ *
+ * @return Stream to be passed to sr_log_end(), NULL if the file cannot
+ *         be opened.
+ */
+FILE *sr_log_begin(const char *log_file)
+{
+#ifdef SR_LOG_THREAD
+  pthread_mutex_lock(&sr_log.lock);
+  if (sr_log.running)
+  {
+    int i_file = sr_log_file_index(log_file);
+
+    for (int k = 0; i_file >= 0 && k < SR_LOG_MAX_OPEN; k++)
+    {
+      sr_log_block *b = sr_log.block + k;
+      if (b->stream != NULL) continue;
+
+      b->stream = open_memstream(&b->buf, &b->size);
+      if (b->stream == NULL) break;
+      b->i_file = i_file;
+      pthread_mutex_unlock(&sr_log.lock);
+      return b->stream;
+    }
+  }
+  pthread_mutex_unlock(&sr_log.lock);
+
+  /* direct output after everything queued */
+  sr_log_flush();
+#endif
+
+  return fopen(log_file, "a");
+}
+
+/**
+ * @brief Queue (or write) a block started by sr_log_begin().
+ */
+void sr_log_end(FILE *log_stream)
+{
+  if (log_stream == NULL) return;
+
+#ifdef SR_LOG_THREAD
+  sr_log_block *b = NULL;
+
+  pthread_mutex_lock(&sr_log.lock);
+  for (int k = 0; k < SR_LOG_MAX_OPEN && b == NULL; k++)
+    if (sr_log.block[k].stream == log_stream) b = sr_log.block + k;
+  pthread_mutex_unlock(&sr_log.lock);
+
+  if (b != NULL)
+  {
+    fclose(log_stream);
+
+    pthread_mutex_lock(&sr_log.lock);
+    if (b->buf != NULL && b->size > 0)
+    {
+      if (sr_log.running) sr_log_queue(b->i_file, b->buf, b->size);
+      else
+      {
+        /* log closed in the meantime */
+        FILE *fp = fopen(sr_log.name[b->i_file], "a");
+        if (fp != NULL)
+        {
+          fwrite(b->buf, 1, b->size, fp);
+          fclose(fp);
+        }
+      }
+    }
+    free(b->buf);
+    b->buf = NULL;
+    b->size = 0;
+    b->stream = NULL;
+    pthread_mutex_unlock(&sr_log.lock);
+    return;
+  }
+#endif
+
+  fclose(log_stream);
+}
+
+/**
+ * @brief Current local time in the format of asctime() (with newline).
+ */
+void sr_log_time(char *buf, size_t size)
+{
+  time_t t_time = time(NULL);
+
+#ifdef SR_LOG_THREAD
+  struct tm l_time;
+  localtime_r(&t_time, &l_time);
+  strftime(buf, size, "%a %b %e %H:%M:%S %Y\n", &l_time);
+#else
+  (void)snprintf(buf, size, "%s", asctime(localtime(&t_time)));
+#endif
+}
+
+/**
+ * @brief Wall clock time in seconds (for differences).
+ */
+double sr_log_clock(void)
+{
+#ifdef SR_LOG_THREAD
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + 1.e-9 * (double)ts.tv_nsec;
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/**
+ * @brief Append one evaluation to the record file of sr_log_open() as
+ * JSON line (nothing if there is none).
+ */
+void sr_log_record(const struct sr_logrec *rec)
+{
+  FILE *rec_stream;
+
+  if (sr_log_rec_file == NULL) return;
+  rec_stream = sr_log_begin(sr_log_rec_file);
+  if (rec_stream == NULL) return;
+
+  fprintf(rec_stream, "{\"eval\":%d,\"calc\":%d,\"slot\":%d,\"time\":%.0f,"
+          "\"par\":[", rec->i_eval, rec->i_calc, rec->slot, rec->time);
+  for (int i_par = 1; i_par <= rec->n_par; i_par++)
+    fprintf(rec_stream, "%s%.6g", (i_par > 1) ? "," : "",
+            (double)rec->par[i_par]);
+  fprintf(rec_stream, "],\"rf\":%.6f,\"shift\":%.2f,\"rg\":%.6f,\"rt\":%.6f,"
+          "\"t_leed\":%.3f,\"t_rfac\":%.3f}\n", (double)rec->rfac,
+          (double)rec->shift, (double)rec->rgeo,
+          (double)(rec->rfac + rec->rgeo), rec->t_leed, rec->t_rfac);
+
+  sr_log_end(rec_stream);
+}
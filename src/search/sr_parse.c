@@ -82,6 +82,24 @@ int sr_parse_two_reals(const char *line, real *out_a, real *out_b)
   return 0;
 }
 
+/**
+ * @brief Parse n numeric values from a line into @ref real outputs.
+ *
+ * See @ref sr_parse_reals for full semantics.
+ */
+int sr_parse_reals(const char *line, real *out, int n)
+{
+  if (line == NULL || out == NULL || n <= 0) return -1;
+
+  const char *p = line;
+  for (int i = 0; i < n; i++) {
+    double v = 0.0;
+    if (sr_parse_next_double(&p, &v) != 0) return -1;
+    out[i] = (real)v;
+  }
+  return 0;
+}
+
 /**
  * @brief Read the first line containing two @ref real values from a file.
  *
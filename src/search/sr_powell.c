@@ -47,7 +47,8 @@ typedef struct sr_line_ctx {
   real *p0;         /* base point (1..n) */
   real *dir;        /* direction (1..n) */
   real *tmp;        /* scratch (1..n) */
-  real (*func)(real *);   /* objective */
+  sr_eval_func func;      /* objective */
+  void *data;             /* second argument of func */
 } sr_line_ctx;
 
 static real sr_line_eval(real alpha, void *vctx)
@@ -56,7 +57,7 @@ static real sr_line_eval(real alpha, void *vctx)
   for (int j = 1; j <= ctx->n; j++) {
     ctx->tmp[j] = ctx->p0[j] + alpha * ctx->dir[j];
   }
-  return (*ctx->func)(ctx->tmp);
+  return (*ctx->func)(ctx->tmp, ctx->data);
 }
 
 static void sr_swap_real(real *a, real *b)
@@ -302,13 +303,15 @@ static real sr_brent_minimise(real ax, real bx, real cx,
   return s.fx;
 }
 
-static int sr_linmin(real *p, real *dir, int n, real *fret, real (*func)(real *))
+static int sr_linmin(real *p, real *dir, int n, real *fret, sr_eval_func func,
+                     void *data)
 {
   sr_line_ctx ctx;
   ctx.n = n;
   ctx.p0 = p;
   ctx.dir = dir;
   ctx.func = func;
+  ctx.data = data;
   ctx.tmp = sr_alloc_vector((size_t)n);
   if (ctx.tmp == NULL) return -1;
 
@@ -356,7 +359,8 @@ static void sr_powell_free_work(real *p_prev, real *p_extrap, real *dir)
   sr_free_vector(p_prev);
 }
 
-static int sr_powell_minimise_all_directions(real *p, real **xi, int n, real *fret, real (*func)(real *),
+static int sr_powell_minimise_all_directions(real *p, real **xi, int n, real *fret,
+                                             sr_eval_func func, void *data,
                                              real *dir, int *out_best_dir)
 {
   real biggest_drop = 0.0;
@@ -365,7 +369,7 @@ static int sr_powell_minimise_all_directions(real *p, real **xi, int n, real *fr
   for (int i = 1; i <= n; i++) {
     for (int j = 1; j <= n; j++) dir[j] = xi[j][i];
     real f_before = *fret;
-    if (sr_linmin(p, dir, n, fret, func) != 0) return -2;
+    if (sr_linmin(p, dir, n, fret, func, data) != 0) return -2;
 
     real drop = (real)fabs((double)(f_before - *fret));
     if (drop > biggest_drop) {
@@ -397,7 +401,8 @@ typedef struct sr_powell_update_ctx {
   real **xi;
   int n;
   real *fret;
-  real (*func)(real *);
+  sr_eval_func func;
+  void *data;
   real *dir;
 } sr_powell_update_ctx;
 
@@ -407,7 +412,7 @@ static void sr_powell_maybe_update_direction(sr_powell_update_ctx *ctx, int best
   if (f_extrap >= f_start) return;
 
   real f_saved = *ctx->fret;
-  if (sr_linmin(ctx->p, ctx->dir, ctx->n, ctx->fret, ctx->func) != 0) return;
+  if (sr_linmin(ctx->p, ctx->dir, ctx->n, ctx->fret, ctx->func, ctx->data) != 0) return;
   if (*ctx->fret >= f_saved) return;
 
   for (int j = 1; j <= ctx->n; j++) ctx->xi[j][best_dir] = ctx->dir[j];
@@ -419,7 +424,8 @@ typedef struct sr_powell_run_ctx {
   int n;
   real ftol;
   real *fret;
-  real (*func)(real *);
+  sr_eval_func func;
+  void *data;
   real *p_prev;
   real *p_extrap;
   real *dir;
@@ -435,14 +441,15 @@ static int sr_powell_iteration(sr_powell_run_ctx *ctx)
   real f_start = *ctx->fret;
   int best_dir = 1;
 
-  if (sr_powell_minimise_all_directions(ctx->p, ctx->xi, ctx->n, ctx->fret, ctx->func, ctx->dir, &best_dir) != 0) {
+  if (sr_powell_minimise_all_directions(ctx->p, ctx->xi, ctx->n, ctx->fret, ctx->func,
+                                        ctx->data, ctx->dir, &best_dir) != 0) {
     return -2;
   }
 
   if (sr_powell_converged(f_start, *ctx->fret, ctx->ftol)) return 1;
 
   sr_powell_extrapolate(ctx->p, ctx->n, ctx->p_prev, ctx->p_extrap, ctx->dir);
-  real f_extrap = (*ctx->func)(ctx->p_extrap);
+  real f_extrap = (*ctx->func)(ctx->p_extrap, ctx->data);
 
   sr_powell_update_ctx update_ctx;
   update_ctx.p = ctx->p;
@@ -450,6 +457,7 @@ static int sr_powell_iteration(sr_powell_run_ctx *ctx)
   update_ctx.n = ctx->n;
   update_ctx.fret = ctx->fret;
   update_ctx.func = ctx->func;
+  update_ctx.data = ctx->data;
   update_ctx.dir = ctx->dir;
   sr_powell_maybe_update_direction(&update_ctx, best_dir, f_start, f_extrap);
 
@@ -466,8 +474,8 @@ static int sr_powell_run(sr_powell_run_ctx *ctx, int *iter)
   return -3;
 }
 
-int sr_powell(real *p, real **xi, int n, real ftol, int *iter,
-              real *fret, real (*func)(real *))
+int sr_powell_data(real *p, real **xi, int n, real ftol, int *iter,
+                   real *fret, sr_eval_func func, void *data)
 {
   if (p == NULL) return -1;
   if (xi == NULL) return -1;
@@ -488,14 +496,35 @@ int sr_powell(real *p, real **xi, int n, real ftol, int *iter,
   ctx.ftol = ftol;
   ctx.fret = fret;
   ctx.func = func;
+  ctx.data = data;
   ctx.p_prev = p_prev;
   ctx.p_extrap = p_extrap;
   ctx.dir = dir;
 
-  *fret = (*func)(p);
+  *fret = (*func)(p, data);
   sr_powell_copy_prev(&ctx);
 
   int rc = sr_powell_run(&ctx, iter);
   sr_powell_free_work(p_prev, p_extrap, dir);
   return rc;
 }
+
+/* objective function without user pointer (legacy interface) */
+typedef struct sr_powell_legacy {
+  real (*func)(real *);
+} sr_powell_legacy;
+
+static real sr_powell_call_legacy(real *x, void *data)
+{
+  return (*((sr_powell_legacy *)data)->func)(x);
+}
+
+int sr_powell(real *p, real **xi, int n, real ftol, int *iter,
+              real *fret, real (*func)(real *))
+{
+  sr_powell_legacy legacy;
+  legacy.func = func;
+  if (func == NULL) return -1;
+  return sr_powell_data(p, xi, n, ftol, iter, fret, sr_powell_call_legacy,
+                        &legacy);
+}
@@ -0,0 +1,313 @@
+/*********************************************************************
+ *                        SR_PTEMPER.C
+ *
+ *  GPL-3.0-or-later
+ *
+ *  Parallel tempering (replica exchange) of annealing simplices.
+ *
+ *  Legacy SEARCH conventions:
+ *  - simplex k is stored in p[k][1..ndim+1][1..ndim], y[k][1..ndim+1]
+ *  - best point is returned in pb[1..ndim] and *yb
+ *********************************************************************/
+
+/**
+ * @file sr_ptemper.c
+ * @brief Parallel tempering of annealing simplices (SEARCH).
+ *
+ * The sequential schedule of sr_sa() cools one simplex from a start
+ * temperature; every evaluation has to wait for the previous one. Here
+ * `n_replica` simplices are kept at fixed temperatures
+ *
+ *   T_k = t_min * (t_max / t_min)^(k / (n_replica - 1)),  k = 0 (coldest)
+ *
+ * and in each sweep all replicas run sr_amebsa() for `iter`
+ * evaluations at the same time (up to `n_jobs` threads). After a sweep,
+ * neighbouring replicas exchange their simplices with the Metropolis
+ * probability min(1, exp((1/T_k - 1/T_{k+1}) (E_k - E_{k+1}))), where E
+ * is the lowest value of a simplex; even and odd pairs are tried in
+ * alternating sweeps. Hot replicas cross barriers, cold replicas refine
+ * the minima handed down to them.
+ *
+ * The search stops after `max_sweep` sweeps, after `patience` sweeps
+ * without improvement of the best value, or when no replica moves any
+ * more (all simplices have contracted below `ftol`).
+ *
+ * The objective function is called with the data pointer of its
+ * replica, which stays with the replica (not with the simplex) when
+ * simplices are exchanged; it must be safe to call for different
+ * replicas concurrently.
+ */
+
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+
+#include "search.h"
+#include "sr_alloc.h"
+#include "sr_rng.h"
+#include "sr_simplex.h"
+
+#if !defined(_WIN32)
+#define SR_PTEMPER_THREAD
+#include <pthread.h>
+#endif
+
+typedef struct sr_ptemper_replica {
+  real temp;
+  long idum;
+  void *data;
+  real *pb;                  /* best point of the last sweep */
+  real yb;
+  int used;                  /* evaluations in the last sweep */
+  int failed;
+} sr_ptemper_replica;
+
+typedef struct sr_ptemper_ctx {
+  real ***p;
+  real **y;
+  int ndim;
+  const sr_ptemper_cfg *cfg;
+  sr_ptemper_replica *rep;
+  int i_next;                /* next replica of the current sweep */
+#ifdef SR_PTEMPER_THREAD
+  pthread_mutex_t lock;
+#endif
+} sr_ptemper_ctx;
+
+static real sr_ptemper_emin(const real *y, int ndim)
+{
+  int ilo = 1, ihi = 1, inhi = 1;
+  sr_simplex_extremes(y, ndim, &ilo, &ihi, &inhi);
+  return y[ilo];
+}
+
+/* anneal replica k at its temperature for one sweep */
+static void sr_ptemper_anneal(sr_ptemper_ctx *ctx, int k)
+{
+  sr_ptemper_replica *r = ctx->rep + k;
+  sr_amebsa_cfg cfg = {0};
+  int budget = ctx->cfg->iter;
+
+  cfg.ftol = ctx->cfg->ftol;
+  cfg.temptr = r->temp;
+  cfg.funk_data = ctx->cfg->funk;
+  cfg.data = r->data;
+  cfg.idum = &r->idum;
+
+  r->failed = (sr_amebsa(ctx->p[k], ctx->y[k], ctx->ndim, r->pb, &r->yb,
+                         &cfg, &budget) != 0);
+  r->used = r->failed ? 0 : budget;
+}
+
+static void *sr_ptemper_worker(void *arg)
+{
+  sr_ptemper_ctx *ctx = (sr_ptemper_ctx *)arg;
+
+  for (;;)
+  {
+    int k;
+#ifdef SR_PTEMPER_THREAD
+    pthread_mutex_lock(&ctx->lock);
+#endif
+    k = ctx->i_next ++;
+#ifdef SR_PTEMPER_THREAD
+    pthread_mutex_unlock(&ctx->lock);
+#endif
+    if (k >= ctx->cfg->n_replica) break;
+    sr_ptemper_anneal(ctx, k);
+  }
+
+  return NULL;
+}
+
+/* one sweep of all replicas, using up to n_jobs threads */
+static void sr_ptemper_sweep(sr_ptemper_ctx *ctx)
+{
+  int n_run = ctx->cfg->n_jobs;
+#ifdef SR_PTEMPER_THREAD
+  pthread_t thread[SR_PT_MAX_REPLICA];
+  int started[SR_PT_MAX_REPLICA];
+#endif
+
+  if (n_run > ctx->cfg->n_replica) n_run = ctx->cfg->n_replica;
+  ctx->i_next = 0;
+
+#ifdef SR_PTEMPER_THREAD
+  /* this thread is one of the workers */
+  for (int i_job = 1; i_job < n_run; i_job++)
+  {
+    started[i_job] = (pthread_create(thread + i_job, NULL,
+                                     sr_ptemper_worker, ctx) == 0);
+#ifdef WARNING
+    if (!started[i_job])
+      fprintf(STDWAR, "* warning (sr_ptemper): cannot start thread %d\n",
+              i_job);
+#endif
+  }
+#else
+  (void)n_run;
+#endif
+
+  sr_ptemper_worker(ctx);
+
+#ifdef SR_PTEMPER_THREAD
+  for (int i_job = 1; i_job < n_run; i_job++)
+  {
+    if (started[i_job]) pthread_join(thread[i_job], NULL);
+  }
+#endif
+}
+
+/* try to exchange the simplices of neighbouring replicas */
+static int sr_ptemper_exchange(sr_ptemper_ctx *ctx, sr_rng *rng, int parity)
+{
+  int n_swap = 0;
+
+  for (int k = parity; k + 1 < ctx->cfg->n_replica; k += 2)
+  {
+    real e_lo = sr_ptemper_emin(ctx->y[k], ctx->ndim);
+    real e_hi = sr_ptemper_emin(ctx->y[k + 1], ctx->ndim);
+    double delta = (1. / (double)ctx->rep[k].temp -
+                    1. / (double)ctx->rep[k + 1].temp) *
+                   (double)(e_lo - e_hi);
+
+    if (delta >= 0. || sr_rng_uniform01(rng) < exp(delta))
+    {
+      real **p_tmp = ctx->p[k];
+      real *y_tmp = ctx->y[k];
+      ctx->p[k] = ctx->p[k + 1];
+      ctx->y[k] = ctx->y[k + 1];
+      ctx->p[k + 1] = p_tmp;
+      ctx->y[k + 1] = y_tmp;
+      n_swap ++;
+    }
+  }
+
+  return n_swap;
+}
+
+static int sr_ptemper_validate(real ***p, real **y, int ndim, real *pb,
+                               real *yb, const sr_ptemper_cfg *cfg)
+{
+  if (p == NULL || y == NULL || pb == NULL || yb == NULL || cfg == NULL ||
+      cfg->funk == NULL || ndim <= 0) return -1;
+  if (cfg->n_replica < 1 || cfg->n_replica > SR_PT_MAX_REPLICA) return -1;
+  if (!(cfg->t_min > 0.) || cfg->t_max < cfg->t_min) return -1;
+  for (int k = 0; k < cfg->n_replica; k++)
+  {
+    if (p[k] == NULL || y[k] == NULL) return -1;
+  }
+  return 0;
+}
+
+/* best point of all simplices */
+static void sr_ptemper_best(const sr_ptemper_ctx *ctx, real *pb, real *yb)
+{
+  for (int k = 0; k < ctx->cfg->n_replica; k++)
+  {
+    int ilo = 1, ihi = 1, inhi = 1;
+    sr_simplex_extremes(ctx->y[k], ctx->ndim, &ilo, &ihi, &inhi);
+    if (ctx->y[k][ilo] < *yb)
+    {
+      sr_simplex_copy_point(pb, ctx->p[k][ilo], ctx->ndim);
+      *yb = ctx->y[k][ilo];
+    }
+  }
+}
+
+/**
+ * @brief Parallel tempering of `cfg->n_replica` annealing simplices.
+ *
+ * @param p Simplices (`p[0..n_replica-1]`, each `[1..ndim+1][1..ndim]`),
+ *          evaluated in @p y. Simplices are exchanged between replicas,
+ *          i.e. the pointers in p and y are permuted; on return p[0] is
+ *          the simplex of the coldest replica.
+ * @param y Function values (`y[0..n_replica-1]`, each `1..ndim+1`).
+ * @param ndim Dimensionality of the parameter vector.
+ * @param pb Output best point (`1..ndim`).
+ * @param yb Output best function value.
+ * @param cfg Ladder, budget and objective function.
+ * @param nfunc Output number of evaluations (may be NULL).
+ * @param nswap Output number of accepted exchanges (may be NULL).
+ * @return 0 on success, non-zero on invalid input or allocation failure.
+ */
+int sr_ptemper(real ***p, real **y, int ndim, real *pb, real *yb,
+               const sr_ptemper_cfg *cfg, int *nfunc, int *nswap)
+{
+  sr_ptemper_ctx ctx;
+  sr_ptemper_replica rep[SR_PT_MAX_REPLICA];
+  sr_rng rng;
+  int n_func = 0, n_swap = 0, n_idle = 0, ret = 0;
+
+  if (sr_ptemper_validate(p, y, ndim, pb, yb, cfg) != 0) return -1;
+
+  ctx.p = p;
+  ctx.y = y;
+  ctx.ndim = ndim;
+  ctx.cfg = cfg;
+  ctx.rep = rep;
+
+  /* geometric temperature ladder, independent seeds */
+  for (int k = 0; k < cfg->n_replica; k++)
+  {
+    double frac = (cfg->n_replica > 1) ? (double)k / (cfg->n_replica - 1) : 0.;
+    rep[k].temp = (real)((double)cfg->t_min *
+                         pow((double)cfg->t_max / (double)cfg->t_min, frac));
+    rep[k].idum = labs(cfg->idum) + 7919L * k + 1;
+    rep[k].data = (cfg->data != NULL) ? cfg->data[k] : NULL;
+    rep[k].pb = sr_alloc_vector((size_t)ndim);
+    if (rep[k].pb == NULL) ret = -1;
+  }
+  sr_rng_seed(&rng, (uint64_t)labs(cfg->idum) + 1);
+
+  *yb = (real)HUGE_VAL;
+  sr_ptemper_best(&ctx, pb, yb);
+
+#ifdef SR_PTEMPER_THREAD
+  pthread_mutex_init(&ctx.lock, NULL);
+#endif
+
+  for (int sweep = 0; ret == 0 && sweep < cfg->max_sweep; sweep++)
+  {
+    int used = 0;
+    real yb_old = *yb;
+
+    sr_ptemper_sweep(&ctx);
+    for (int k = 0; k < cfg->n_replica; k++)
+    {
+      if (rep[k].failed) ret = -1;
+      used += rep[k].used;
+    }
+    n_func += used;
+    sr_ptemper_best(&ctx, pb, yb);
+
+    n_swap += sr_ptemper_exchange(&ctx, &rng, sweep % 2);
+
+    if (cfg->checkpoint != NULL)
+      (*cfg->checkpoint)((const real **)p[0], y[0], ndim, cfg->checkpoint_arg);
+
+#ifdef CONTROL
+    fprintf(STDCTR, "(sr_ptemper): sweep %d: %d evaluations, best = %.6f\n",
+            sweep + 1, used, (double)*yb);
+#endif
+
+    if (used == 0) break;                 /* all simplices contracted */
+    n_idle = (*yb < yb_old) ? 0 : n_idle + 1;
+    if (cfg->patience > 0 && n_idle >= cfg->patience) break;
+  }
+
+#ifdef SR_PTEMPER_THREAD
+  pthread_mutex_destroy(&ctx.lock);
+#endif
+  for (int k = 0; k < cfg->n_replica; k++)
+  {
+    sr_free_vector(rep[k].pb);
+  }
+
+  if (nfunc != NULL) *nfunc = n_func;
+  if (nswap != NULL) *nswap = n_swap;
+  return ret;
+}
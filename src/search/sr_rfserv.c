@@ -0,0 +1,250 @@
+/*********************************************************************
+ *                        SR_RFSERV.C
+ *
+ *  GPL-3.0-or-later
+ *********************************************************************/
+
+/**
+ * @file sr_rfserv.c
+ * @brief Client for the resident R factor service (`crfac --serve`).
+ *
+ * Instead of starting the R factor program for every evaluation,
+ * sr_evalrf() can send the name of the results file to a running
+ * `crfac --serve` process that keeps the experimental IV curves in
+ * memory. The service is selected by the environment variable
+ * `CSEARCH_RFAC_SERVE`:
+ *
+ * - unset, empty, `0` or `no`: service not used.
+ * - `unix:<socket>` or an absolute path: connect to a service that
+ *   has been started with `crfac -c <ctr_file> --serve <socket>`.
+ * - any other value (e.g. `1`): start `$CSEARCH_RFAC --serve` as a
+ *   child process and talk to it through pipes.
+ *
+ * Each request is one line (the results file name); each reply is
+ * one line `<rfac> <rr> <shift> <range>` or `ERR <message>`.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#endif
+
+#include "search.h"
+
+static FILE *sr_rfserv_req = NULL;    /* requests to service */
+static FILE *sr_rfserv_rep = NULL;    /* replies from service */
+#if !defined(_WIN32)
+static pid_t sr_rfserv_pid = -1;      /* child process (pipe mode) */
+#endif
+
+#if !defined(_WIN32)
+/* The descriptors of the service must not be inherited by the LEED and
+   R factor programs started by other evaluations: a child holding the
+   write end of a pipe would keep the service from seeing end of file. */
+static int sr_rfserv_cloexec(int fd)
+{
+  int flags = fcntl(fd, F_GETFD);
+  if (flags == -1 || fcntl(fd, F_SETFD, flags | FD_CLOEXEC) == -1) return -1;
+  return 0;
+}
+
+static int sr_rfserv_connect(const char *sock_file)
+{
+  int sock, sock_w;
+  struct sockaddr_un addr;
+
+  if (strlen(sock_file) >= sizeof(addr.sun_path)) return -1;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, sock_file);
+
+  if ((sock = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) return -1;
+  if (sr_rfserv_cloexec(sock) != 0 ||
+      connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+      (sock_w = fcntl(sock, F_DUPFD_CLOEXEC, 0)) == -1)
+  {
+    close(sock);
+    return -1;
+  }
+
+  if ((sr_rfserv_rep = fdopen(sock, "r")) == NULL) close(sock);
+  if ((sr_rfserv_req = fdopen(sock_w, "w")) == NULL) close(sock_w);
+  return 0;
+}
+
+static int sr_rfserv_spawn(const char *ctr_file, const char *r_type,
+                           real s_ini, real s_fin, real s_step)
+{
+  int to_child[2], from_child[2];
+  char command[4096];
+
+  if (getenv("CSEARCH_RFAC") == NULL) return -1;
+
+  (void)snprintf(command, sizeof(command),
+      "exec \"%s\" -c \"%s\" -r \"%s\" -s %.2f,%.2f,%.2f --serve",
+      getenv("CSEARCH_RFAC"), ctr_file, r_type, s_ini, s_fin, s_step);
+
+  if (pipe(to_child) == -1) return -1;
+  if (pipe(from_child) == -1)
+  {
+    close(to_child[0]);
+    close(to_child[1]);
+    return -1;
+  }
+  /* the child's ends are passed to the service by dup2, which clears
+     FD_CLOEXEC */
+  if (sr_rfserv_cloexec(to_child[0]) != 0 ||
+      sr_rfserv_cloexec(to_child[1]) != 0 ||
+      sr_rfserv_cloexec(from_child[0]) != 0 ||
+      sr_rfserv_cloexec(from_child[1]) != 0)
+  {
+    close(to_child[0]);   close(to_child[1]);
+    close(from_child[0]); close(from_child[1]);
+    return -1;
+  }
+
+  if ((sr_rfserv_pid = fork()) == -1)
+  {
+    close(to_child[0]);   close(to_child[1]);
+    close(from_child[0]); close(from_child[1]);
+    return -1;
+  }
+
+  if (sr_rfserv_pid == 0)
+  {
+    /* child: stdin/stdout of the service are the pipes */
+    dup2(to_child[0], STDIN_FILENO);
+    dup2(from_child[1], STDOUT_FILENO);
+    close(to_child[0]);   close(to_child[1]);
+    close(from_child[0]); close(from_child[1]);
+    execl("/bin/sh", "sh", "-c", command, (char *)NULL);
+    _exit(127);
+  }
+
+  close(to_child[0]);
+  close(from_child[1]);
+  sr_rfserv_req = fdopen(to_child[1], "w");
+  sr_rfserv_rep = fdopen(from_child[0], "r");
+  return 0;
+}
+#endif /* !_WIN32 */
+
+/**
+ * @brief Connect to (or start) the R factor service.
+ *
+ * @param ctr_file Control file for crfac (pipe mode only).
+ * @param r_type R factor type, e.g. "rp" (pipe mode only).
+ * @param s_ini,s_fin,s_step Range and step of energy shifts.
+ * @return 0 if the service can be used, -1 otherwise (not selected
+ *         by `CSEARCH_RFAC_SERVE` or not available).
+ */
+int sr_rfserv_open(const char *ctr_file, const char *r_type,
+                   real s_ini, real s_fin, real s_step)
+{
+  const char *mode = getenv("CSEARCH_RFAC_SERVE");
+  int ret;
+
+  if (sr_rfserv_req != NULL) return 0;
+
+  if (mode == NULL || *mode == '\0' || !strcmp(mode, "0") ||
+      !strcasecmp(mode, "no"))
+    return -1;
+
+#if !defined(_WIN32)
+  if (!strncmp(mode, "unix:", 5))
+    ret = sr_rfserv_connect(mode + 5);
+  else if (mode[0] == '/')
+    ret = sr_rfserv_connect(mode);
+  else
+    ret = sr_rfserv_spawn(ctr_file, r_type, s_ini, s_fin, s_step);
+
+  if (ret != 0 || sr_rfserv_req == NULL || sr_rfserv_rep == NULL)
+  {
+    sr_rfserv_close();
+    return -1;
+  }
+
+  /* a terminated service must not terminate the search */
+  signal(SIGPIPE, SIG_IGN);
+  atexit(sr_rfserv_close);
+  return 0;
+#else
+  (void)ctr_file; (void)r_type; (void)s_ini; (void)s_fin; (void)s_step;
+  (void)ret;
+  return -1;
+#endif
+}
+
+/**
+ * @brief Evaluate the R factor of a theoretical results file.
+ *
+ * @param res_file Results file of the LEED program (text or binary).
+ * @param rfac Output minimum R factor.
+ * @param rr Output RR factor (used for error bars).
+ * @param shift Output energy shift of the minimum.
+ * @return 0 on success, -1 if the service failed or reported an error.
+ */
+int sr_rfserv_eval(const char *res_file, real *rfac, real *rr, real *shift)
+{
+  char line_buffer[STRSZ];
+  const char *name = res_file;
+#if !defined(_WIN32)
+  char abs_name[PATH_MAX];
+
+  /* the service may run in a different directory */
+  if (realpath(res_file, abs_name) != NULL) name = abs_name;
+#endif
+
+  if (sr_rfserv_req == NULL || sr_rfserv_rep == NULL) return -1;
+
+  if (fprintf(sr_rfserv_req, "%s\n", name) < 0 ||
+      fflush(sr_rfserv_req) != 0 ||
+      fgets(line_buffer, STRSZ, sr_rfserv_rep) == NULL)
+    return -1;
+
+#ifdef REAL_IS_DOUBLE
+  if (sscanf(line_buffer, "%lf %lf %lf", rfac, rr, shift) != 3) return -1;
+#else
+  if (sscanf(line_buffer, "%f %f %f", rfac, rr, shift) != 3) return -1;
+#endif
+
+  return 0;
+}
+
+/**
+ * @brief End the session; a child process started by sr_rfserv_open()
+ * is terminated.
+ */
+void sr_rfserv_close(void)
+{
+  if (sr_rfserv_req != NULL)
+  {
+    fprintf(sr_rfserv_req, "QUIT\n");
+    fclose(sr_rfserv_req);
+    sr_rfserv_req = NULL;
+  }
+  if (sr_rfserv_rep != NULL)
+  {
+    fclose(sr_rfserv_rep);
+    sr_rfserv_rep = NULL;
+  }
+#if !defined(_WIN32)
+  if (sr_rfserv_pid > 0)
+  {
+    waitpid(sr_rfserv_pid, NULL, 0);
+    sr_rfserv_pid = -1;
+  }
+#endif
+}
@@ -11,8 +11,14 @@
 
 #include "sr_simplex.h"
 
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
 // cppcheck-suppress missingIncludeSystem
 #include <string.h>
+// cppcheck-suppress missingIncludeSystem
+#include <time.h>
+
+#include "copy_file.h"
 
 #include "sr_alloc.h"
 
@@ -128,15 +134,23 @@ static void sr_simplex_build_vertex(sr_simplex_buffers *b, int i, real dpos)
   }
 }
 
-int sr_simplex_build_initial(sr_simplex_buffers *b, real dpos, real (*func)(real *))
+int sr_simplex_build_initial(sr_simplex_buffers *b, real dpos,
+                             sr_eval_func func, void *data)
+{
+  return sr_simplex_build_at(b, NULL, dpos, func, data);
+}
+
+int sr_simplex_build_at(sr_simplex_buffers *b, const real *centre, real dpos,
+                        sr_eval_func func, void *data)
 {
   if (b == NULL || b->p == NULL || b->y == NULL || b->x == NULL || b->ndim <= 0 || func == NULL) return -1;
 
-  sr_simplex_zero(b->p[1], b->ndim);
+  if (centre != NULL) sr_simplex_copy_point(b->p[1], centre, b->ndim);
+  else sr_simplex_zero(b->p[1], b->ndim);
 
   for (int i = 1; i <= b->mpar; i++) {
     sr_simplex_build_vertex(b, i, dpos);
-    b->y[i] = (*func)(b->x);
+    b->y[i] = (*func)(b->x, data);
   }
 
   return 0;
@@ -147,3 +161,43 @@ int sr_simplex_read_vertex(sr_simplex_buffers *b, const char *bak_file)
   if (b == NULL || b->p == NULL || b->y == NULL || bak_file == NULL) return -1;
   return (sr_rdver(bak_file, b->y, b->p, b->ndim) == 1) ? 0 : -1;
 }
+
+int sr_simplex_write_vertex(const char *project, const real **p,
+                            const real *y, int ndim)
+{
+  if (project == NULL || project[0] == '\0') return 0;
+
+  char ver_file[STRSZ];
+  char vbk_file[STRSZ];
+
+  /* Best-effort backup of the previous vertex file. */
+  (void)snprintf(ver_file, sizeof(ver_file), "%s.ver", project);
+  (void)snprintf(vbk_file, sizeof(vbk_file), "%s.vbk", project);
+
+  (void)copy_file(ver_file, vbk_file);
+
+  FILE *fp = fopen(ver_file, "w");
+  if (fp == NULL) return -1;
+
+  int mpts = ndim + 1;
+  fprintf(fp, "%d %d %s\n", ndim, mpts, project);
+  for (int i = 1; i <= mpts; i++) {
+    fprintf(fp, "%e ", (double)y[i]);
+    for (int j = 1; j <= ndim; j++) {
+      fprintf(fp, "%e ", (double)p[i][j]);
+    }
+    fputc('\n', fp);
+  }
+
+  time_t now = time(NULL);
+  const struct tm *tm_info = localtime(&now);
+  if (tm_info != NULL) {
+    char timebuf[64];
+    if (strftime(timebuf, sizeof(timebuf), "%c", tm_info) > 0) {
+      fprintf(fp, "%s\n", timebuf);
+    }
+  }
+
+  fclose(fp);
+  return 0;
+}
@@ -0,0 +1,389 @@
+/*********************************************************************
+ *                        SR_SURROGATE.C
+ *
+ *  GPL-3.0-or-later
+ *********************************************************************/
+
+/**
+ * @file sr_surrogate.c
+ * @brief Gaussian process model of the R factor as a function of the
+ * search parameters.
+ *
+ * A LEED evaluation takes seconds to minutes, the prediction of a model
+ * fitted to all evaluations so far takes microseconds. The model is a
+ * Gaussian process with constant mean (the mean of all values) and the
+ * squared exponential covariance
+ *
+ *   k(a, b) = s2 * exp(-|a - b|^2 / (2 l^2)),
+ *
+ * where s2 is the variance of the values and l the length scale given
+ * to sr_surrogate_new(); a small nugget accounts for the noise of the
+ * R factor (finite energy shift grid, rounding of the geometry). The
+ * prediction at x is the mean mu(x) and the standard deviation
+ * sigma(x); the expected improvement over a value y_best is
+ *
+ *   EI = (y_best - mu) Phi(z) + sigma phi(z),  z = (y_best - mu) / sigma.
+ *
+ * The model is refitted (Cholesky decomposition, O(n^3)) after each new
+ * point; at most SR_SG_MAX_POINT points are kept, the worst one is
+ * dropped if the model is full. All functions may be called by several
+ * threads at the same time.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#include "search.h"
+#include "sr_rng.h"
+
+#define SR_SG_MAX_POINT 256     /* maximum number of points of the model */
+#define SR_SG_NUGGET    1.e-4   /* noise variance relative to s2 */
+#define SR_SG_VAR_MIN   1.e-8   /* lower limit of s2 */
+
+struct sr_surrogate
+{
+  int ndim;
+  double scale;               /* length scale l */
+  int n;                      /* number of points */
+  double *x;                  /* SR_SG_MAX_POINT x ndim coordinates */
+  double *y;                  /* values */
+  double mean, s2;            /* mean and variance of y */
+  double *l;                  /* Cholesky factor of K (n x n, lower) */
+  double *alpha;              /* K^-1 (y - mean) */
+  double *work;               /* n (prediction) */
+  double *xq;                 /* ndim (query point) */
+  int fitted;
+#if !defined(_WIN32)
+  pthread_mutex_t lock;
+#endif
+};
+
+#if !defined(_WIN32)
+#define SR_SG_LOCK(s)   pthread_mutex_lock(&(s)->lock)
+#define SR_SG_UNLOCK(s) pthread_mutex_unlock(&(s)->lock)
+#else
+#define SR_SG_LOCK(s)
+#define SR_SG_UNLOCK(s)
+#endif
+
+/**
+ * @brief Create an empty model.
+ *
+ * @param ndim Number of parameters.
+ * @param scale Length scale of the covariance (parameter units).
+ * @return New model, NULL on invalid input or allocation failure.
+ */
+struct sr_surrogate *sr_surrogate_new(int ndim, real scale)
+{
+  struct sr_surrogate *s;
+
+  if (ndim < 1 || !(scale > 0.)) return NULL;
+  s = (struct sr_surrogate *)calloc(1, sizeof(struct sr_surrogate));
+  if (s == NULL) return NULL;
+
+  s->ndim = ndim;
+  s->scale = (double)scale;
+  s->x = (double *)calloc((size_t)SR_SG_MAX_POINT * (size_t)ndim,
+                          sizeof(double));
+  s->y = (double *)calloc(SR_SG_MAX_POINT, sizeof(double));
+  s->l = (double *)calloc((size_t)SR_SG_MAX_POINT * SR_SG_MAX_POINT,
+                          sizeof(double));
+  s->alpha = (double *)calloc(SR_SG_MAX_POINT, sizeof(double));
+  s->work = (double *)calloc(SR_SG_MAX_POINT, sizeof(double));
+  s->xq = (double *)calloc((size_t)ndim, sizeof(double));
+  if (s->x == NULL || s->y == NULL || s->l == NULL || s->alpha == NULL ||
+      s->work == NULL || s->xq == NULL)
+  {
+    sr_surrogate_free(s);
+    return NULL;
+  }
+#if !defined(_WIN32)
+  pthread_mutex_init(&s->lock, NULL);
+#endif
+  return s;
+}
+
+/**
+ * @brief Free a model (NULL is allowed).
+ */
+void sr_surrogate_free(struct sr_surrogate *s)
+{
+  if (s == NULL) return;
+#if !defined(_WIN32)
+  if (s->x != NULL && s->y != NULL && s->l != NULL && s->alpha != NULL &&
+      s->work != NULL && s->xq != NULL) pthread_mutex_destroy(&s->lock);
+#endif
+  free(s->x);
+  free(s->y);
+  free(s->l);
+  free(s->alpha);
+  free(s->work);
+  free(s->xq);
+  free(s);
+}
+
+/* covariance of two points (0-based, ndim) */
+static double sr_sg_kernel(const struct sr_surrogate *s, const double *a,
+                           const double *b)
+{
+  double d2 = 0.;
+  for (int j = 0; j < s->ndim; j++) d2 += (a[j] - b[j]) * (a[j] - b[j]);
+  return s->s2 * exp(- d2 / (2. * s->scale * s->scale));
+}
+
+/* solve L v = b (in place) */
+static void sr_sg_forward(const struct sr_surrogate *s, double *v)
+{
+  for (int i = 0; i < s->n; i++)
+  {
+    double sum = v[i];
+    for (int k = 0; k < i; k++) sum -= s->l[i * SR_SG_MAX_POINT + k] * v[k];
+    v[i] = sum / s->l[i * SR_SG_MAX_POINT + i];
+  }
+}
+
+/* refit mean, variance, Cholesky factor and weights */
+static int sr_sg_fit(struct sr_surrogate *s)
+{
+  int n = s->n;
+  double mean = 0., var = 0.;
+
+  s->fitted = 0;
+  if (n < 2) return -1;
+
+  for (int i = 0; i < n; i++) mean += s->y[i];
+  mean /= n;
+  for (int i = 0; i < n; i++) var += (s->y[i] - mean) * (s->y[i] - mean);
+  var /= n;
+  s->mean = mean;
+  s->s2 = (var > SR_SG_VAR_MIN) ? var : SR_SG_VAR_MIN;
+
+  for (int i = 0; i < n; i++)
+  {
+    for (int k = 0; k <= i; k++)
+    {
+      double sum = sr_sg_kernel(s, s->x + i * s->ndim, s->x + k * s->ndim);
+      if (k == i) sum += SR_SG_NUGGET * s->s2;
+      for (int m = 0; m < k; m++)
+        sum -= s->l[i * SR_SG_MAX_POINT + m] * s->l[k * SR_SG_MAX_POINT + m];
+
+      if (k == i)
+      {
+        if (!(sum > 0.)) return -1;
+        s->l[i * SR_SG_MAX_POINT + i] = sqrt(sum);
+      }
+      else s->l[i * SR_SG_MAX_POINT + k] = sum / s->l[k * SR_SG_MAX_POINT + k];
+    }
+  }
+
+  /* alpha = L^-T L^-1 (y - mean) */
+  for (int i = 0; i < n; i++) s->alpha[i] = s->y[i] - mean;
+  sr_sg_forward(s, s->alpha);
+  for (int i = n - 1; i >= 0; i--)
+  {
+    double sum = s->alpha[i];
+    for (int k = i + 1; k < n; k++) sum -= s->l[k * SR_SG_MAX_POINT + i] * s->alpha[k];
+    s->alpha[i] = sum / s->l[i * SR_SG_MAX_POINT + i];
+  }
+
+  s->fitted = 1;
+  return 0;
+}
+
+/**
+ * @brief Add an evaluated point and refit the model.
+ *
+ * If the model is full, the point with the highest value is replaced
+ * (the new point is not added if its value is even higher).
+ *
+ * @param s Model.
+ * @param par Parameters (`1..ndim`).
+ * @param y Value (R factor) at @p par.
+ * @return 0 on success, -1 if the refit failed.
+ */
+int sr_surrogate_add(struct sr_surrogate *s, const real *par, real y)
+{
+  int i_new, ret;
+
+  SR_SG_LOCK(s);
+  if (s->n < SR_SG_MAX_POINT) i_new = s->n ++;
+  else
+  {
+    i_new = 0;
+    for (int i = 1; i < s->n; i++)
+      if (s->y[i] > s->y[i_new]) i_new = i;
+    if ((double)y >= s->y[i_new])
+    {
+      SR_SG_UNLOCK(s);
+      return 0;
+    }
+  }
+
+  for (int j = 0; j < s->ndim; j++) s->x[i_new * s->ndim + j] = par[j + 1];
+  s->y[i_new] = y;
+  ret = (s->n >= 2) ? sr_sg_fit(s) : 0;
+  SR_SG_UNLOCK(s);
+  return ret;
+}
+
+/**
+ * @brief Number of points of the model.
+ */
+int sr_surrogate_count(struct sr_surrogate *s)
+{
+  int n;
+  SR_SG_LOCK(s);
+  n = s->n;
+  SR_SG_UNLOCK(s);
+  return n;
+}
+
+/**
+ * @brief Look up a point of the model.
+ *
+ * @param s Model.
+ * @param par Parameters (`1..ndim`).
+ * @param tol Largest difference of each parameter.
+ * @param y Output value of the point.
+ * @return 1 if a point within @p tol was found, 0 otherwise.
+ */
+int sr_surrogate_lookup(struct sr_surrogate *s, const real *par, real tol,
+                        real *y)
+{
+  int found = 0;
+
+  SR_SG_LOCK(s);
+  for (int i = 0; i < s->n && !found; i++)
+  {
+    found = 1;
+    for (int j = 0; j < s->ndim; j++)
+      if (fabs(s->x[i * s->ndim + j] - (double)par[j + 1]) > (double)tol)
+        found = 0;
+    if (found) *y = (real)s->y[i];
+  }
+  SR_SG_UNLOCK(s);
+  return found;
+}
+
+/* mean and standard deviation at x (0-based), lock held */
+static void sr_sg_predict_locked(struct sr_surrogate *s, const double *x,
+                                 double *mu, double *sigma)
+{
+  double m = s->mean, var = s->s2;
+
+  for (int i = 0; i < s->n; i++)
+  {
+    s->work[i] = sr_sg_kernel(s, s->x + i * s->ndim, x);
+    m += s->work[i] * s->alpha[i];
+  }
+  sr_sg_forward(s, s->work);
+  for (int i = 0; i < s->n; i++) var -= s->work[i] * s->work[i];
+
+  *mu = m;
+  *sigma = (var > 0.) ? sqrt(var) : 0.;
+}
+
+/**
+ * @brief Predict the value at a point.
+ *
+ * @param s Model.
+ * @param par Parameters (`1..ndim`).
+ * @param mu Output predicted mean.
+ * @param sigma Output predicted standard deviation.
+ * @return 0 on success, -1 if the model has fewer than two points.
+ */
+int sr_surrogate_predict(struct sr_surrogate *s, const real *par, real *mu,
+                         real *sigma)
+{
+  double m, sd;
+
+  SR_SG_LOCK(s);
+  if (!s->fitted)
+  {
+    SR_SG_UNLOCK(s);
+    return -1;
+  }
+  for (int j = 0; j < s->ndim; j++) s->xq[j] = par[j + 1];
+  sr_sg_predict_locked(s, s->xq, &m, &sd);
+  SR_SG_UNLOCK(s);
+
+  *mu = (real)m;
+  *sigma = (real)sd;
+  return 0;
+}
+
+static double sr_sg_ei(double mu, double sigma, double y_best)
+{
+  double z;
+
+  if (!(sigma > 0.)) return (y_best > mu) ? y_best - mu : 0.;
+  z = (y_best - mu) / sigma;
+  return (y_best - mu) * 0.5 * erfc(- z / M_SQRT2) +
+         sigma * exp(-0.5 * z * z) / sqrt(2. * M_PI);
+}
+
+/**
+ * @brief Expected improvement over @p y_best at a point.
+ *
+ * @return EI (>= 0), 0 if the model has fewer than two points.
+ */
+real sr_surrogate_ei(struct sr_surrogate *s, const real *par, real y_best)
+{
+  real mu, sigma;
+
+  if (sr_surrogate_predict(s, par, &mu, &sigma) != 0) return 0.;
+  return (real)sr_sg_ei((double)mu, (double)sigma, (double)y_best);
+}
+
+/**
+ * @brief Propose the point of highest expected improvement among
+ * @p n_cand random points within @p radius of @p centre.
+ *
+ * @param s Model.
+ * @param centre Centre of the box (`1..ndim`).
+ * @param radius Half width of the box in each parameter.
+ * @param n_cand Number of random candidates.
+ * @param y_best Value to be improved.
+ * @param seed Seed of the random candidates.
+ * @param out Output proposed point (`1..ndim`).
+ * @return Expected improvement at @p out, -1 if the model has fewer
+ *         than two points.
+ */
+real sr_surrogate_propose(struct sr_surrogate *s, const real *centre,
+                          real radius, int n_cand, real y_best,
+                          long seed, real *out)
+{
+  double *x = s->xq, mu, sigma, ei, ei_max = -1.;
+  sr_rng rng;
+
+  sr_rng_seed(&rng, (uint64_t)labs(seed) + 1);
+
+  SR_SG_LOCK(s);
+  if (!s->fitted)
+  {
+    SR_SG_UNLOCK(s);
+    return -1.;
+  }
+  for (int i_cand = 0; i_cand < n_cand; i_cand++)
+  {
+    for (int j = 0; j < s->ndim; j++)
+      x[j] = (double)centre[j + 1] +
+             (double)radius * (2. * sr_rng_uniform01(&rng) - 1.);
+    sr_sg_predict_locked(s, x, &mu, &sigma);
+    ei = sr_sg_ei(mu, sigma, (double)y_best);
+    if (ei > ei_max)
+    {
+      ei_max = ei;
+      for (int j = 0; j < s->ndim; j++) out[j + 1] = (real)x[j];
+    }
+  }
+  SR_SG_UNLOCK(s);
+
+  return (real)ei_max;
+}
@@ -1,8 +1,14 @@
 /***********************************************************************
  GH/01.04.03
-  file contains function:
+  file contains functions:
 
-  real sr_ckgeo(void)
+  real sr_ckgeo(const struct sr_context *ctx, real *par)
+  int  sr_geo_init(struct sr_geoscreen *geo, const struct sr_context *ctx)
+  real sr_geo_eval(struct sr_geoscreen *geo, const struct sr_context *ctx,
+                   const real *par)
+  int  sr_geo_batch(struct sr_geoscreen *geo, const struct sr_context *ctx,
+                    real **par, int n_pop, real *rgeo)
+  void sr_geo_free(struct sr_geoscreen *geo)
 
  Check geometry
 
@@ -10,6 +16,11 @@
 
 GH/24.08.95 - Creation (copy from srevalrf.c)
 SRP/01.04.03 - Modified the code for the angle search (n_par_geo)
+LD/19.10.26 - atoms and search parameters are taken from a search context.
+LD/19.10.26 - cell list of the atom images instead of the loop over all
+              pairs and unit cells; the arrays are kept in a workspace
+              (struct sr_geoscreen) and reused. sr_geo_batch for a whole
+              population of parameter sets.
 
 ***********************************************************************/
 #include <stdio.h>
@@ -20,63 +31,270 @@ SRP/01.04.03 - Modified the code for the angle search (n_par_geo)
 
 #include "search.h"
 
-#define GEO_PREF 10.                 /* rgeo is 1 if the actual distance 
+#define GEO_PREF 10.                 /* rgeo is 1 if the actual distance
                                         between two atoms is by 1/GEO_PREF
                                         smaller than the sum of their min.
                                         radii */
+#define GEO_N_IMAGE 9                /* unit cell and the 8 surrounding */
+#define GEO_IMAGE_0 4                /* index of the unit cell itself */
+#define GEO_CELL_FAC 2               /* cells per image (at most) */
 
 /***********************************************************************/
 
-extern struct sratom_str *sr_atoms;
-extern struct search_str *sr_search;
-extern char *sr_project;
+int sr_geo_init(struct sr_geoscreen *geo, const struct sr_context *ctx)
 
-real sr_ckgeo(real *par)
+/***********************************************************************
+
+  Allocate the workspace for the atoms of ctx.
+  Returns 0 on success, -1 on allocation failure.
+
+***********************************************************************/
+{
+int i_atoms, n_atoms;
+size_t n_img;
+
+ for(n_atoms = 0; (ctx->atoms + n_atoms)->type != I_END_OF_LIST; n_atoms ++)
+ { ; }
+
+ sr_geo_free(geo);
+ n_img = (size_t)GEO_N_IMAGE * n_atoms + 1;
+
+ geo->n_cell_max = GEO_CELL_FAC * (int)n_img;
+ geo->r_min = (real *)malloc( (n_atoms + 1) * sizeof(real) );
+ geo->x = (real *)malloc( (n_atoms + 1) * sizeof(real) );
+ geo->y = (real *)malloc( (n_atoms + 1) * sizeof(real) );
+ geo->z = (real *)malloc( (n_atoms + 1) * sizeof(real) );
+ geo->gx = (real *)malloc( n_img * sizeof(real) );
+ geo->gy = (real *)malloc( n_img * sizeof(real) );
+ geo->gz = (real *)malloc( n_img * sizeof(real) );
+ geo->cell_head = (int *)malloc( geo->n_cell_max * sizeof(int) );
+ geo->cell_next = (int *)malloc( n_img * sizeof(int) );
+
+ if( (geo->r_min == NULL) || (geo->x == NULL) || (geo->y == NULL) ||
+     (geo->z == NULL) || (geo->gx == NULL) || (geo->gy == NULL) ||
+     (geo->gz == NULL) || (geo->cell_head == NULL) ||
+     (geo->cell_next == NULL) )
+ {
+   sr_geo_free(geo);
+   return(-1);
+ }
+
+ geo->r_max = 0.;
+ for(i_atoms = 0; i_atoms < n_atoms; i_atoms ++)
+ {
+   geo->r_min[i_atoms] = (ctx->atoms + i_atoms)->r_min;
+   if(geo->r_min[i_atoms] > geo->r_max) geo->r_max = geo->r_min[i_atoms];
+ }
+ geo->n_atoms = n_atoms;
+ return(0);
+}
+
+/***********************************************************************/
+
+void sr_geo_free(struct sr_geoscreen *geo)
 
 /***********************************************************************
 
-  Geometry assesment
+  Free the workspace (may be called for a zeroed workspace).
+
+***********************************************************************/
+{
+ free(geo->r_min);
+ free(geo->x);
+ free(geo->y);
+ free(geo->z);
+ free(geo->gx);
+ free(geo->gy);
+ free(geo->gz);
+ free(geo->cell_head);
+ free(geo->cell_next);
+ geo->r_min = geo->x = geo->y = geo->z = NULL;
+ geo->gx = geo->gy = geo->gz = NULL;
+ geo->cell_head = geo->cell_next = NULL;
+ geo->n_atoms = geo->n_cell_max = 0;
+ geo->r_max = 0.;
+}
+
+/***********************************************************************/
+
+static real sr_geo_pairs(struct sr_geoscreen *geo, const real *b_lat)
+
+/***********************************************************************
+
+  Penalty of all pairs closer than the sum of their min. radii.
+
+  The images of atom j in the 3x3 unit cells around the original cell
+  are sorted into cubic cells with an edge of at least 2 r_max, i.e.
+  the atoms within the min. distance of atom i are in the 27 cells
+  around it. As before, pair i < j is checked for all 9 images of j.
 
 ***********************************************************************/
 {
 int i_atoms, j_atoms, n_atoms;
-int i_par;
+int i_img, n_img;
 int i1, i2;
+int n_x, n_y, n_z;
+int c_x, c_y, c_z, k_x, k_y, k_z;
+int i_cell;
 
 real rgeo;
-
 real faux;
-real *x, *y, *z;
-real d_min, d_min2;
-real d_x, d_y, d_z;
+real d_min, d_x, d_y, d_z, d2;
+real x_min, x_max, y_min, y_max, z_min, z_max;
+real edge;
+
+ n_atoms = geo->n_atoms;
+ n_img = GEO_N_IMAGE * n_atoms;
+
+/*
+  Images of all atoms and their bounding box
+*/
+ for(i_img = 0, i1 = -1; i1 <= 1; i1 ++)
+ for(i2 = -1; i2 <= 1; i2 ++)
+ {
+   d_x = i1 * b_lat[1] + i2 * b_lat[2];
+   d_y = i1 * b_lat[3] + i2 * b_lat[4];
+   for(j_atoms = 0; j_atoms < n_atoms; j_atoms ++, i_img ++)
+   {
+     geo->gx[i_img] = geo->x[j_atoms] + d_x;
+     geo->gy[i_img] = geo->y[j_atoms] + d_y;
+     geo->gz[i_img] = geo->z[j_atoms];
+   }
+ }
+
+ x_min = x_max = geo->gx[0];
+ y_min = y_max = geo->gy[0];
+ z_min = z_max = geo->gz[0];
+ for(i_img = 1; i_img < n_img; i_img ++)
+ {
+   if(geo->gx[i_img] < x_min) x_min = geo->gx[i_img];
+   if(geo->gx[i_img] > x_max) x_max = geo->gx[i_img];
+   if(geo->gy[i_img] < y_min) y_min = geo->gy[i_img];
+   if(geo->gy[i_img] > y_max) y_max = geo->gy[i_img];
+   if(geo->gz[i_img] < z_min) z_min = geo->gz[i_img];
+   if(geo->gz[i_img] > z_max) z_max = geo->gz[i_img];
+ }
+
+/*
+  Cell grid: edge >= 2 r_max, at most n_cell_max cells
+*/
+ if(!isfinite(x_max - x_min + y_max - y_min + z_max - z_min)) return(0.);
+
+ edge = 2. * geo->r_max * (1. + 1.e-4);
+ while( (floor((x_max - x_min) / edge) + 1.) *
+        (floor((y_max - y_min) / edge) + 1.) *
+        (floor((z_max - z_min) / edge) + 1.) > geo->n_cell_max )
+ {
+   edge *= 2.;
+ }
+ n_x = (int)((x_max - x_min) / edge) + 1;
+ n_y = (int)((y_max - y_min) / edge) + 1;
+ n_z = (int)((z_max - z_min) / edge) + 1;
+
+ for(i_cell = 0; i_cell < n_x * n_y * n_z; i_cell ++)
+   geo->cell_head[i_cell] = -1;
+
+ for(i_img = n_img - 1; i_img >= 0; i_img --)
+ {
+   c_x = (int)((geo->gx[i_img] - x_min) / edge);
+   c_y = (int)((geo->gy[i_img] - y_min) / edge);
+   c_z = (int)((geo->gz[i_img] - z_min) / edge);
+   if(c_x >= n_x) c_x = n_x - 1;
+   if(c_y >= n_y) c_y = n_y - 1;
+   if(c_z >= n_z) c_z = n_z - 1;
+   i_cell = (c_z * n_y + c_y) * n_x + c_x;
+   geo->cell_next[i_img] = geo->cell_head[i_cell];
+   geo->cell_head[i_cell] = i_img;
+ }
+
+/*
+  Loop over all atoms in the unit cell and the images in the cells
+  around them
+*/
+ rgeo = 0.;
+ for(i_atoms = 0; i_atoms < n_atoms; i_atoms ++)
+ {
+   i_img = GEO_IMAGE_0 * n_atoms + i_atoms;
+   c_x = (int)((geo->gx[i_img] - x_min) / edge);
+   c_y = (int)((geo->gy[i_img] - y_min) / edge);
+   c_z = (int)((geo->gz[i_img] - z_min) / edge);
+
+   for(k_z = c_z - 1; k_z <= c_z + 1; k_z ++)
+   for(k_y = c_y - 1; k_y <= c_y + 1; k_y ++)
+   for(k_x = c_x - 1; k_x <= c_x + 1; k_x ++)
+   {
+     if( (k_x < 0) || (k_x >= n_x) || (k_y < 0) || (k_y >= n_y) ||
+         (k_z < 0) || (k_z >= n_z) ) continue;
+
+     i_cell = (k_z * n_y + k_y) * n_x + k_x;
+     for(i_img = geo->cell_head[i_cell]; i_img >= 0;
+         i_img = geo->cell_next[i_img])
+     {
+       j_atoms = i_img % n_atoms;
+       if(j_atoms <= i_atoms) continue;
+
+       d_min = geo->r_min[i_atoms] + geo->r_min[j_atoms];
+       d_x = geo->gx[i_img] - geo->x[i_atoms];
+       d_y = geo->gy[i_img] - geo->y[i_atoms];
+       d_z = geo->gz[i_img] - geo->z[i_atoms];
+       d2 = d_x*d_x + d_y*d_y + d_z*d_z;
+
+       if(SQUARE(d_min) - d2 > 0.)
+       {
+         faux = GEO_PREF * (d_min - sqrt(d2) ) / d_min;
+         rgeo += (SQUARE(faux));
+       }
+     }  /* for i_img */
+   }  /* for k_x, k_y, k_z */
+ }  /* for i_atoms */
+
+ return (rgeo);
+}
+
+/***********************************************************************/
+
+real sr_geo_eval(struct sr_geoscreen *geo, const struct sr_context *ctx,
+                 const real *par)
 
 /***********************************************************************
-  Set initial values
-  - n_atoms
-  - arrays x, y, and z
+
+  Geometry assesment of parameter set par (1..n_par) using the
+  workspace geo (set up at the first call).
+
 ***********************************************************************/
+{
+int i_atoms, n_atoms;
+int i_par;
 
- for(n_atoms = 0; (sr_atoms + n_atoms)->type != I_END_OF_LIST; n_atoms ++)
- { ; }
+real rgeo;
+real faux;
+
+ if(geo->x == NULL && sr_geo_init(geo, ctx) != 0)
+ {
+   fprintf(STDERR, " *** error (sr_geo_eval): allocation failure\n");
+   exit(1);
+ }
+ n_atoms = geo->n_atoms;
+ if(n_atoms == 0) return(0.);
 
- x = (real *)malloc( n_atoms * sizeof(real) );
- y = (real *)malloc( n_atoms * sizeof(real) );
- z = (real *)malloc( n_atoms * sizeof(real) );
+/***********************************************************************
+  Positions of the atoms
+***********************************************************************/
 
  for(i_atoms = 0; i_atoms < n_atoms; i_atoms ++)
  {
-   x[i_atoms] = (sr_atoms + i_atoms)->x;
-   y[i_atoms] = (sr_atoms + i_atoms)->y;
-   z[i_atoms] = (sr_atoms + i_atoms)->z;
+   geo->x[i_atoms] = (ctx->atoms + i_atoms)->x;
+   geo->y[i_atoms] = (ctx->atoms + i_atoms)->y;
+   geo->z[i_atoms] = (ctx->atoms + i_atoms)->z;
 
-   for(i_par = 1; i_par <= sr_search->n_par_geo; i_par ++)
+   for(i_par = 1; i_par <= ctx->search->n_par_geo; i_par ++)
    {
-     if(!sr_search->z_only)
+     if(!ctx->search->z_only)
      {
-       x[i_atoms] += par[i_par] * (sr_atoms + i_atoms)->x_par[i_par];
-       y[i_atoms] += par[i_par] * (sr_atoms + i_atoms)->y_par[i_par];
+       geo->x[i_atoms] += par[i_par] * (ctx->atoms + i_atoms)->x_par[i_par];
+       geo->y[i_atoms] += par[i_par] * (ctx->atoms + i_atoms)->y_par[i_par];
      }
-     z[i_atoms] += par[i_par] * (sr_atoms + i_atoms)->z_par[i_par];
+     geo->z[i_atoms] += par[i_par] * (ctx->atoms + i_atoms)->z_par[i_par];
    }
  } /* for i_atoms */
 
@@ -86,61 +304,77 @@ real d_x, d_y, d_z;
 
  rgeo = 0.;
 
- for(i_atoms = 0; i_atoms < n_atoms; i_atoms ++)
- {
-
 /*
-   Check wether this atom is within the vertical limits (z_min/z_max)
+   Check wether the atoms are within the vertical limits (z_min/z_max)
 */
-   if(z[i_atoms] > sr_search->z_max)
+ for(i_atoms = 0; i_atoms < n_atoms; i_atoms ++)
+ {
+   if(geo->z[i_atoms] > ctx->search->z_max)
    {
-     faux = GEO_PREF * (sr_search->z_max - z[i_atoms] ) / sr_search->z_max;
+     faux = GEO_PREF * (ctx->search->z_max - geo->z[i_atoms] ) /
+            ctx->search->z_max;
      rgeo += (SQUARE(faux));
    }
-   if(z[i_atoms] < sr_search->z_min)
+   if(geo->z[i_atoms] < ctx->search->z_min)
    {
-     faux = GEO_PREF * (sr_search->z_min - z[i_atoms] ) / sr_search->z_min;
+     faux = GEO_PREF * (ctx->search->z_min - geo->z[i_atoms] ) /
+            ctx->search->z_min;
      rgeo += (SQUARE(faux));
    }
+ }
 
 /*
-   Loop over all other atoms:
    Check whether the distances between the atoms are within the given
    limits (r_min)
 */
-
-   for(j_atoms = i_atoms + 1; j_atoms < n_atoms; j_atoms ++)
-   {
-     d_min = (sr_atoms + i_atoms)->r_min + (sr_atoms + j_atoms)->r_min;
-     d_min2 = SQUARE(d_min);
-     
-     d_z = z[j_atoms] - z[i_atoms];
-     d_z *= d_z;
-     d_min2 -= d_z;
-     
-/* 
-   Loop over all surrounding unit cells 
-   (add lattice vectors to the atom positions)
-*/
-     for(i1 = -1; i1 <= 1; i1 ++)
-     for(i2 = -1; i2 <= 1; i2 ++)
-     {
-       d_x = x[j_atoms] - x[i_atoms] + 
-             i1 * sr_search->b_lat[1] + i2 * sr_search->b_lat[2];
-       d_x *= d_x;
-       d_y = y[j_atoms] - y[i_atoms] + 
-             i1 * sr_search->b_lat[3] + i2 * sr_search->b_lat[4];
-       d_y *= d_y;
-       
-       if(d_min2 - d_x - d_y > 0.) 
-       {
-         faux = GEO_PREF * (d_min - sqrt(d_x + d_y + d_z) ) / d_min;
-         rgeo += (SQUARE(faux));
-       }
-     }  /* for i1, i2 */
-   }  /* for j_atoms */
- }  /* for i_atoms */
+ if(geo->r_max > 0.) rgeo += sr_geo_pairs(geo, ctx->search->b_lat);
 
  rgeo /= n_atoms;
  return (rgeo);
 }
+
+/***********************************************************************/
+
+int sr_geo_batch(struct sr_geoscreen *geo, const struct sr_context *ctx,
+                 real **par, int n_pop, real *rgeo)
+
+/***********************************************************************
+
+  Geometry assesment of a population: rgeo[k] for the parameter sets
+  par[k] (k = 1 ... n_pop, each 1..n_par), e.g. to discard parameter
+  sets before any LEED calculation is started.
+
+  Returns the number of parameter sets with rgeo > SR_RGEO_MAX (for
+  which sr_evalrf does not calculate IV curves).
+
+***********************************************************************/
+{
+int k, n_bad;
+
+ n_bad = 0;
+ for(k = 1; k <= n_pop; k ++)
+ {
+   rgeo[k] = sr_geo_eval(geo, ctx, par[k]);
+   if(rgeo[k] > SR_RGEO_MAX) n_bad ++;
+ }
+ return(n_bad);
+}
+
+/***********************************************************************/
+
+real sr_ckgeo(const struct sr_context *ctx, real *par)
+
+/***********************************************************************
+
+  Geometry assesment with a temporary workspace
+  (sr_evalrf uses the workspace of its evaluation slot).
+
+***********************************************************************/
+{
+struct sr_geoscreen geo = {0};
+real rgeo;
+
+ rgeo = sr_geo_eval(&geo, ctx, par);
+ sr_geo_free(&geo);
+ return (rgeo);
+}
@@ -2,11 +2,22 @@
 GH/21.09.02
  File contains:
 
-  sr_er(int ndim, real dpos, char *bak_file, char *log_file)
+  sr_er(struct sr_context *ctx, int ndim, real dpos, int n_jobs,
+        char *bak_file, char *log_file)
  Determine error bars for all parameters.
 
  Modified:
 GH/21.09.02 - copy from srsx
+LD/19.10.26 - the parameters are displaced in parallel (up to n_jobs
+              evaluations at the same time, one evaluation slot each):
+              first the initial displacement of all parameters, then the
+              iterative rescaling of each remaining parameter. The first
+              displacement (delta = dpos) is always evaluated again, as in
+              the original do-while loop. RR is taken from the evaluation
+              slot instead of <project>.dum.
+LD/19.10.26 - evaluate in the search context ctx.
+LD/19.10.26 - the log file is written through sr_log_begin/sr_log_end
+              (sr_log.c).
 
 ***********************************************************************/
 
@@ -20,49 +31,85 @@ GH/21.09.02 - copy from srsx
 #include <math.h>
 #include "search.h"
 #include "sr_alloc.h"
-#include "sr_parse.h"
 
-extern char *sr_project;
+#if !defined(_WIN32)
+#define SR_ER_THREAD
+#include <pthread.h>
+#endif
 
 /**********************************************************************/
 
 typedef struct sr_er_ctx {
+  struct sr_context *context; /* search context of the evaluations */
   int ndim;
   real dpos;
   real y0;
   real pref;
   real rtol;
   real rr;
-  real *x;
   real *x0;
+  /* parallel evaluation */
+  int n_jobs;                 /* number of concurrent evaluations */
+  struct sr_evslot *slot;     /* one evaluation slot per job */
+  real **x;                   /* one parameter vector per job */
+  int i_next;                 /* next parameter to be processed */
+  int failed;
+#ifdef SR_ER_THREAD
+  pthread_mutex_t lock;
+#endif
 } sr_er_ctx;
 
 typedef struct sr_er_arrays {
   real *y;
   real *del;
+  real *rdel;
   real *err;
 } sr_er_arrays;
 
-static void sr_er_set_displacement(sr_er_ctx *ctx, int i_par, real delta)
+typedef struct sr_er_job {
+  sr_er_ctx *ctx;
+  sr_er_arrays *a;
+  int phase;                  /* SR_ER_FIRST or SR_ER_REFINE */
+  int i_job;
+} sr_er_job;
+
+#define SR_ER_MAX_JOBS 64     /* maximum number of concurrent evaluations */
+
+#define SR_ER_FIRST   0       /* first displacement of a parameter */
+#define SR_ER_REFINE  1       /* rescale until rdel is in [0.75,1.25] */
+
+static void sr_er_set_displacement(const sr_er_ctx *ctx, real *x, int i_par,
+                                   real delta)
 {
   for (int j = 1; j <= ctx->ndim; j++)
   {
-    ctx->x[j] = ctx->x0[j];
+    x[j] = ctx->x0[j];
   }
-  ctx->x[i_par] = ctx->x0[i_par] + delta;
+  x[i_par] = ctx->x0[i_par] + delta;
 }
 
-static int sr_er_find_delta(sr_er_ctx *ctx, int i_par, real *out_y, real *out_delta)
+static void sr_er_eval(sr_er_ctx *ctx, sr_er_arrays *a, int i_job, int i_par)
 {
-  real delta = ctx->dpos;
-  real rdel = 1.0;
-  real y = ctx->y0;
+  real *x = ctx->x[i_job + 1];
 
-  while ((rdel < 0.75) || (rdel > 1.25))
+  sr_er_set_displacement(ctx, x, i_par, a->del[i_par]);
+
+#ifdef CONTROL
+  fprintf(STDCTR, "(sr_er): Calculate function for parameter (%d)\n", i_par);
+#endif
+
+  a->y[i_par] = sr_evalrf_slot(ctx->context, x, ctx->slot + i_job);
+  // cppcheck-suppress suspiciousFloatingPointCast
+  a->rdel[i_par] = R_fabs(a->y[i_par] - ctx->y0) / ctx->pref;
+}
+
+static int sr_er_find_delta(sr_er_ctx *ctx, sr_er_arrays *a, int i_job, int i_par)
+{
+  while ((a->rdel[i_par] < 0.75) || (a->rdel[i_par] > 1.25))
   {
-    if (rdel < ctx->rtol)
+    if (a->rdel[i_par] < ctx->rtol)
     {
-      if (rdel < 0.0)
+      if (a->rdel[i_par] < 0.0)
       {
 #ifdef ERROR
         fprintf(STDERR, "*** error (sr_er): minimum not found (%d)\n", i_par);
@@ -75,32 +122,105 @@ static int sr_er_find_delta(sr_er_ctx *ctx, int i_par, real *out_y, real *out_de
               "* warning (sr_er): minimum R factor independent of par. %d\n",
               i_par);
 #endif
-      rdel = 1.0;
+      a->rdel[i_par] = 1.0;
     }
     else
     {
       // cppcheck-suppress suspiciousFloatingPointCast
-      delta = delta / R_sqrt(rdel);
-      sr_er_set_displacement(ctx, i_par, delta);
+      a->del[i_par] = a->del[i_par] / R_sqrt(a->rdel[i_par]);
+      sr_er_eval(ctx, a, i_job, i_par);
+    }
+  }
 
-#ifdef CONTROL
-      fprintf(STDCTR, "(sr_er): Calculate function for parameter (%d)\n", i_par);
+  return 0;
+}
+
+/* take parameters from the list until all are done */
+static void *sr_er_worker(void *arg)
+{
+  sr_er_job *job = (sr_er_job *)arg;
+  sr_er_ctx *ctx = job->ctx;
+  int i_par;
+
+  for (;;)
+  {
+#ifdef SR_ER_THREAD
+    pthread_mutex_lock(&ctx->lock);
+#endif
+    i_par = ctx->failed ? ctx->ndim + 1 : ctx->i_next ++;
+#ifdef SR_ER_THREAD
+    pthread_mutex_unlock(&ctx->lock);
 #endif
+    if (i_par > ctx->ndim) break;
 
-      y = sr_evalrf(ctx->x);
-      // cppcheck-suppress suspiciousFloatingPointCast
-      rdel = R_fabs(y - ctx->y0) / ctx->pref;
+    if (job->phase == SR_ER_FIRST)
+    {
+      job->a->del[i_par] = ctx->dpos;
+      sr_er_eval(ctx, job->a, job->i_job, i_par);
+    }
+    else if (sr_er_find_delta(ctx, job->a, job->i_job, i_par) != 0)
+    {
+#ifdef SR_ER_THREAD
+      pthread_mutex_lock(&ctx->lock);
+#endif
+      ctx->failed = 1;
+#ifdef SR_ER_THREAD
+      pthread_mutex_unlock(&ctx->lock);
+#endif
     }
   }
 
-  *out_y = y;
-  *out_delta = delta;
-  return 0;
+  return NULL;
+}
+
+/* process all parameters in phase, using up to n_jobs evaluations at a time */
+static int sr_er_run(sr_er_ctx *ctx, sr_er_arrays *a, int phase)
+{
+  sr_er_job job[SR_ER_MAX_JOBS];
+  int n_run = ctx->n_jobs;
+#ifdef SR_ER_THREAD
+  pthread_t thread[SR_ER_MAX_JOBS];
+  int started[SR_ER_MAX_JOBS];
+#endif
+
+  ctx->i_next = 1;
+  ctx->failed = 0;
+  for (int i_job = 0; i_job < n_run; i_job++)
+  {
+    job[i_job].ctx = ctx;
+    job[i_job].a = a;
+    job[i_job].phase = phase;
+    job[i_job].i_job = i_job;
+  }
+
+#ifdef SR_ER_THREAD
+  /* this thread runs job 0 */
+  for (int i_job = 1; i_job < n_run; i_job++)
+  {
+    started[i_job] =
+      (pthread_create(thread + i_job, NULL, sr_er_worker, job + i_job) == 0);
+#ifdef WARNING
+    if (!started[i_job])
+      fprintf(STDWAR, "* warning (sr_er): cannot start thread %d\n", i_job);
+#endif
+  }
+#endif
+
+  sr_er_worker(job);
+
+#ifdef SR_ER_THREAD
+  for (int i_job = 1; i_job < n_run; i_job++)
+  {
+    if (started[i_job]) pthread_join(thread[i_job], NULL);
+  }
+#endif
+
+  return ctx->failed ? -1 : 0;
 }
 
 static FILE *sr_er_open_log_append(const char *log_file)
 {
-  FILE *log_stream = fopen(log_file, "a");
+  FILE *log_stream = sr_log_begin(log_file);
   if (log_stream == NULL) {
     OPEN_ERROR(log_file);
   }
@@ -109,44 +229,71 @@ static FILE *sr_er_open_log_append(const char *log_file)
 
 static int sr_er_alloc_buffers(sr_er_ctx *ctx, sr_er_arrays *a, int ndim)
 {
-  ctx->x = sr_alloc_vector((size_t)ndim);
+  ctx->x = sr_alloc_matrix((size_t)ctx->n_jobs, (size_t)ndim);
   ctx->x0 = sr_alloc_vector((size_t)ndim);
+  ctx->slot = (struct sr_evslot *)calloc((size_t)ctx->n_jobs,
+                                         sizeof(struct sr_evslot));
   a->y = sr_alloc_vector((size_t)ndim);
   a->del = sr_alloc_vector((size_t)ndim);
+  a->rdel = sr_alloc_vector((size_t)ndim);
   a->err = sr_alloc_vector((size_t)ndim);
-  return (ctx->x != NULL && ctx->x0 != NULL && a->y != NULL && a->del != NULL && a->err != NULL) ? 0 : -1;
+  return (ctx->x != NULL && ctx->x0 != NULL && ctx->slot != NULL &&
+          a->y != NULL && a->del != NULL && a->rdel != NULL && a->err != NULL) ? 0 : -1;
 }
 
 static void sr_er_free_buffers(sr_er_ctx *ctx, sr_er_arrays *a)
 {
-  sr_free_vector(ctx->x);
+  if (ctx->slot != NULL)
+  {
+    for (int i_job = 0; i_job < ctx->n_jobs; i_job++)
+    {
+      sr_evslot_close(ctx->slot + i_job);
+    }
+    free(ctx->slot);
+  }
+  sr_free_matrix(ctx->x);
   sr_free_vector(ctx->x0);
   sr_free_vector(a->y);
   sr_free_vector(a->del);
+  sr_free_vector(a->rdel);
   sr_free_vector(a->err);
 }
 
-static void sr_er_init_minimum(sr_er_ctx *ctx)
+static void sr_er_open_slots(sr_er_ctx *ctx, const char *log_file)
 {
-  for (int i_par = 1; i_par <= ctx->ndim; i_par++) {
-    ctx->x0[i_par] = 0.0;
+  for (int i_job = 0; i_job < ctx->n_jobs; i_job++)
+  {
+    if (sr_evslot_open(ctx->slot + i_job, ctx->context->project,
+                       i_job + 1) != 0)
+    {
+      FILE *log_stream = sr_er_open_log_append(log_file);
+      fprintf(log_stream, "*** cannot create scratch directory for "
+              "evaluation (CSEARCH_SCRATCH) ***\n");
+      sr_log_end(log_stream);
+      exit(1);
+    }
   }
-  ctx->y0 = sr_evalrf(ctx->x0);
 }
 
-static void sr_er_read_rr(sr_er_ctx *ctx, const char *log_file)
+static void sr_er_init_minimum(sr_er_ctx *ctx, const char *log_file)
 {
-  char dum_path[STRSZ];
-  snprintf(dum_path, sizeof(dum_path), "%s.dum", sr_project);
+  for (int i_par = 1; i_par <= ctx->ndim; i_par++) {
+    ctx->x0[i_par] = 0.0;
+  }
+  ctx->slot[0].rr = 0.0;
+  ctx->y0 = sr_evalrf_slot(ctx->context, ctx->x0, ctx->slot);
+
+/***********************************************************************
+  R factor value and RR factor for minimum
+***********************************************************************/
 
-  real rfac = 0.0;
-  ctx->rr = 0.0;
-  if (sr_read_two_reals_from_file(dum_path, &rfac, &ctx->rr) != 0)
+  ctx->rr = ctx->slot[0].rr;
+  if (!(ctx->rr > 0.0))
   {
     FILE *log_stream = sr_er_open_log_append(log_file);
     fprintf(log_stream, "*** error while reading output from %s\n",
             getenv("CSEARCH_RFAC"));
-    fclose(log_stream);
+    sr_log_end(log_stream);
     exit(1);
   }
 
@@ -154,22 +301,17 @@ static void sr_er_read_rr(sr_er_ctx *ctx, const char *log_file)
   ctx->rtol = R_TOLERANCE / ctx->rr;
 
 #ifdef CONTROL
-  fprintf(STDCTR, "(sr_er): rfac = %.4f, rr = %.4f\n", rfac, ctx->rr);
+  fprintf(STDCTR, "(sr_er): rfac = %.4f, rr = %.4f\n", ctx->slot[0].rfac, ctx->rr);
 #endif
 }
 
 static void sr_er_compute_displacements(sr_er_ctx *ctx, sr_er_arrays *a)
 {
-  for (int i_par = 1; i_par <= ctx->ndim; i_par++)
+  /* first displacement of all parameters, then rescale each one */
+  if (sr_er_run(ctx, a, SR_ER_FIRST) != 0 ||
+      sr_er_run(ctx, a, SR_ER_REFINE) != 0)
   {
-    real yi = 0.0;
-    real di = 0.0;
-    if (sr_er_find_delta(ctx, i_par, &yi, &di) != 0)
-    {
-      exit(1);
-    }
-    a->y[i_par] = yi;
-    a->del[i_par] = di;
+    exit(1);
   }
 }
 
@@ -210,15 +352,25 @@ static void sr_er_write_error_bar_line(FILE *log_stream, const sr_er_ctx *ctx, s
   }
 }
 
-void sr_er(int ndim, real dpos, const char *bak_file, const char *log_file)
+void sr_er(struct sr_context *context, int ndim, real dpos, int n_jobs,
+           const char *bak_file, const char *log_file)
 {
   (void)bak_file;
 
   sr_er_ctx ctx;
+  ctx.context = context;
   ctx.ndim = ndim;
   ctx.dpos = dpos;
+  ctx.n_jobs = (n_jobs < 1) ? 1 : (n_jobs > ndim) ? ndim : n_jobs;
+  if (ctx.n_jobs > SR_ER_MAX_JOBS) ctx.n_jobs = SR_ER_MAX_JOBS;
   ctx.x = NULL;
   ctx.x0 = NULL;
+  ctx.slot = NULL;
+#ifdef SR_ER_THREAD
+  pthread_mutex_init(&ctx.lock, NULL);
+#else
+  ctx.n_jobs = 1;
+#endif
 
 /***********************************************************************
   write title to log file
@@ -234,6 +386,7 @@ void sr_er(int ndim, real dpos, const char *bak_file, const char *log_file)
   sr_er_arrays a;
   a.y = NULL;
   a.del = NULL;
+  a.rdel = NULL;
   a.err = NULL;
 
   if (sr_er_alloc_buffers(&ctx, &a, ndim) != 0)
@@ -248,15 +401,14 @@ void sr_er(int ndim, real dpos, const char *bak_file, const char *log_file)
 ***********************************************************************/
 
   fprintf(log_stream, "=> displace parameters from minimum:\n");
-  fclose(log_stream);
-
-  sr_er_init_minimum(&ctx);
-
-/***********************************************************************
-  Read R factor value and RR factor for minimum
-***********************************************************************/
+  if (ctx.n_jobs > 1)
+  {
+    fprintf(log_stream, "   (%d evaluations in parallel)\n", ctx.n_jobs);
+  }
+  sr_log_end(log_stream);
 
-  sr_er_read_rr(&ctx, log_file);
+  sr_er_open_slots(&ctx, log_file);
+  sr_er_init_minimum(&ctx, log_file);
 
 /***********************************************************************
   Calculate R factors for displacements
@@ -280,9 +432,12 @@ void sr_er(int ndim, real dpos, const char *bak_file, const char *log_file)
     sr_er_write_error_bar_line(log_stream, &ctx, &a, i_par, pref);
   }
 
-  fclose(log_stream);
+  sr_log_end(log_stream);
 
   sr_er_free_buffers(&ctx, &a);
+#ifdef SR_ER_THREAD
+  pthread_mutex_destroy(&ctx.lock);
+#endif
 } /* end of function sr_er */
 
 /***********************************************************************/
@@ -3,6 +3,9 @@ GH/31.03.03
   file contains function:
 
   real sr_evalrf(real *par)
+  real sr_evalrf_ctx(real *par, void *ctx)
+  real sr_evalrf_slot(struct sr_context *ctx, real *par,
+                      struct sr_evslot *slot)
 
  Calculate IV curves and evaluate R factor
 
@@ -22,6 +25,32 @@ GH/09.08.04  - use modified bulk file *.bsr and copy to *.bmin if a
                minimum is reached.
 LD/30.04.14  - removed dependence on 'cp' system call, now uses 
                copy_file(char* old_filename, char *new_filename) function.
+LD/19.10.26  - use the resident R factor service (crfac --serve, see
+               sr_rfserv.c) if selected by CSEARCH_RFAC_SERVE; fall back
+               to calling CSEARCH_RFAC if the service fails.
+LD/19.10.26  - input and output files of LEED and R factor program are
+               written to the scratch directory of an evaluation slot
+               (sr_evslot.c); *.rmin, *.pmin, *.bmin are promoted
+               atomically and only if no running search has a lower
+               R factor.
+LD/19.10.26  - sr_evalrf_slot: evaluation in a given slot, may be called
+               by several threads at the same time (the LEED and R factor
+               programs run concurrently; counters, *.rmin and the log
+               file are protected by a mutex). R factor, RR factor and
+               shift are stored in the slot.
+LD/19.10.26  - the state of the evaluations (rfac_min, rfac_max, counters,
+               default slot, R factor service) is kept in a search
+               context (struct sr_context) instead of static variables;
+               sr_evalrf uses the default context. The R factor service
+               is shared by the contexts of one project.
+LD/19.10.26  - slot->y_res: the R factor program also writes the residuals
+               of Rp to slot->yres_file (crfac -y), optionally for the
+               single shift slot->shift_fix; the service is not used then.
+LD/19.10.26  - the log file is written through sr_log_begin/sr_log_end
+               (ring buffer and writer thread, see sr_log.c); one record
+               per evaluation with timings (sr_log_record).
+LD/19.10.26  - the geometry is checked with the workspace of the slot
+               (sr_geo_eval, no allocation per evaluation).
 
 ***********************************************************************/
 #include <stdio.h>
@@ -29,8 +58,18 @@ LD/30.04.14  - removed dependence on 'cp' system call, now uses
 #include <time.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+static pthread_mutex_t sr_evalrf_lock = PTHREAD_MUTEX_INITIALIZER;
+#define SR_EVALRF_LOCK()   pthread_mutex_lock(&sr_evalrf_lock)
+#define SR_EVALRF_UNLOCK() pthread_mutex_unlock(&sr_evalrf_lock)
+#else
+#define SR_EVALRF_LOCK()
+#define SR_EVALRF_UNLOCK()
+#endif
 
-#include "cleed_string.h"
 #include "search.h"
 #include "copy_file.h"
 
@@ -52,20 +91,67 @@ LD/30.04.14  - removed dependence on 'cp' system call, now uses
 #endif
 
 
-#define SYS_ERROR_TO_LOG(x)   log_stream = fopen(log_file, "a"); \
+#define SYS_ERROR_TO_LOG(x)   log_stream = sr_log_begin(log_file); \
      fprintf(log_stream,"*** system call \"%s\" failed ***", x); \
-     fclose(log_stream); exit(1)
+     sr_log_end(log_stream); exit(1)
      
-#define COPY_ERROR_TO_LOG(x,y) log_stream = fopen(log_file, "a"); \
+#define COPY_ERROR_TO_LOG(x,y) log_stream = sr_log_begin(log_file); \
      fprintf(log_stream,"*** copying \"%s\" to \"%s\" failed ***", x, y); \
-     fclose(log_stream); exit(1)
+     sr_log_end(log_stream); exit(1)
 
-extern struct sratom_str *sr_atoms;
-extern struct search_str *sr_search;
-extern char *sr_project;
+static char rf_serv_project[STRSZ];  /* project of the R factor service */
+
+static void sr_evalrf_close(void)
+{
+  sr_evslot_close(&sr_default_context.slot0);
+}
 
 real sr_evalrf(real *par)
 
+/***********************************************************************
+ Evaluate the R factor of parameters par in the default context.
+***********************************************************************/
+{
+ return sr_evalrf_ctx(par, &sr_default_context);
+}
+
+/**********************************************************************/
+
+real sr_evalrf_ctx(real *par, void *data)
+
+/***********************************************************************
+ Evaluate the R factor of parameters par in the default slot of the
+ search context data (opened at the first call, removed by
+ sr_context_free or, for the default context, at exit).
+***********************************************************************/
+{
+struct sr_context *ctx = (struct sr_context *)data;
+char log_file[STRSZ];
+FILE *log_stream;
+
+ SR_EVALRF_LOCK();
+ if (ctx->slot0.dir[0] == '\0')
+ {
+   if (sr_evslot_open(&ctx->slot0, ctx->project, 0) != 0)
+   {
+     sprintf(log_file,"%s.log", ctx->project);
+     log_stream = sr_log_begin(log_file);
+     fprintf(log_stream, "*** cannot create scratch directory for "
+             "evaluation (CSEARCH_SCRATCH) ***\n");
+     sr_log_end(log_stream);
+     exit(1);
+   }
+   if (ctx == &sr_default_context) atexit(sr_evalrf_close);
+ }
+ SR_EVALRF_UNLOCK();
+
+ return sr_evalrf_slot(ctx, par, &ctx->slot0);
+}
+
+/**********************************************************************/
+
+real sr_evalrf_slot(struct sr_context *ctx, real *par, struct sr_evslot *slot)
+
 /***********************************************************************
 
  - check geometry
@@ -73,25 +159,31 @@ real sr_evalrf(real *par)
  - calculate IV curves (program "cleed")
  - calculate R-factor (program "crfac")
 
+ All files are written to the scratch directory of slot (see
+ sr_evslot_open); different slots can be evaluated in parallel, also
+ for different search contexts ctx.
+
+ If slot->y_res is set, the residuals of Rp are written to
+ slot->yres_file (for slot->shift_fix only if slot->fix_shift is set).
+
 ***********************************************************************/
 {
-static real rfac_min = 100.;
-static real rfac_max = 0.;
-static real shift = 0.;
-static int n_eval  = 0;
-static int n_calc  = 0;
-
 	int iaux;
 	int i_par;
+	int i_eval, i_calc;
 	real rgeo = 0.;
 	real rfac = 0.;
+	real rr = 0.;
+	real shift = 0.;
+	real s_ini, s_fin;
+	double t_leed = 0., t_rfac = 0., t_start;
 
-struct tm *l_time;
-time_t t_time;
+struct sr_logrec rec;
 
-char line_buffer[4096];
+char line_buffer[5*SR_PATHSZ + STRSZ];
+char time_buffer[STRSZ];
+char y_opt[SR_PATHSZ + 8];
 char log_file[STRSZ];
-char par_file[STRSZ];
 
 FILE *io_stream, *log_stream;
 
@@ -99,9 +191,11 @@ FILE *io_stream, *log_stream;
   Set initial values
 ***********************************************************************/
  iaux = 0;
- n_eval ++;
- sprintf(log_file,"%s.log", sr_project);
- sprintf(par_file,"%s.par", sr_project);
+ sprintf(log_file,"%s.log", ctx->project);
+
+ SR_EVALRF_LOCK();
+ i_eval = ++ ctx->n_eval;
+ SR_EVALRF_UNLOCK();
 
 /***********************************************************************
   Check whether environment variables CSEARCH_LEED and CSEARCH_RFAC exist
@@ -129,10 +223,10 @@ FILE *io_stream, *log_stream;
 ***********************************************************************/
 
 #ifdef SHORTCUT
- fprintf(STDCTR,"(sr_evalrf %d) SHORTCUT:", n_eval);
+ fprintf(STDCTR,"(sr_evalrf %d) SHORTCUT:", i_eval);
 #endif
 
- rgeo = sr_ckgeo( par );
+ rgeo = sr_geo_eval(&slot->geo, ctx, par);
 
 #ifdef CONTROL
 #ifdef SHORTCUT
@@ -148,79 +242,112 @@ FILE *io_stream, *log_stream;
   Calculate IV curves otherwise.
 ***********************************************************************/
 
-/*
-*/
- if( (rgeo > 1.) && (n_calc > 1) )
+ SR_EVALRF_LOCK();
+ if( (rgeo > SR_RGEO_MAX) && (ctx->n_calc > 1) )
  {
 #ifdef CONTROL
    fprintf(STDCTR," return rfac_max: %.4f rtot = %.4f\n", 
-           rfac_max, rgeo + rfac_max);
+           ctx->rfac_max, rgeo + ctx->rfac_max);
 #endif
-   log_stream = fopen(log_file, "a");
+   log_stream = sr_log_begin(log_file);
 
-   fprintf(log_stream,"#%3d par:", n_eval);
-   for(i_par=1; i_par <= sr_search->n_par; i_par++)
+   fprintf(log_stream,"#%3d par:", i_eval);
+   for(i_par=1; i_par <= ctx->search->n_par; i_par++)
      fprintf(log_stream," %.3f", par[i_par]);
    fprintf(log_stream," **rfmax: %.4f** rg:%.4f rt:%.4f ",
-           rfac_max, rgeo, rfac_max + rgeo);
-
-   t_time = time(NULL);
-   l_time = localtime(&t_time);
-   fprintf(log_stream," dt: %s", asctime(l_time) );
-
-   fclose(log_stream);
-   return(rfac_max + rgeo);
+           ctx->rfac_max, rgeo, ctx->rfac_max + rgeo);
+
+   sr_log_time(time_buffer, sizeof(time_buffer));
+   fprintf(log_stream," dt: %s", time_buffer);
+
+   sr_log_end(log_stream);
+   rfac = ctx->rfac_max;
+   SR_EVALRF_UNLOCK();
+
+   rec.i_eval = i_eval;
+   rec.i_calc = 0;
+   rec.slot = slot->id;
+   rec.time = (double)time(NULL);
+   rec.n_par = ctx->search->n_par;
+   rec.par = par;
+   rec.rfac = rfac;
+   rec.shift = 0.;
+   rec.rgeo = rgeo;
+   rec.t_leed = rec.t_rfac = 0.;
+   sr_log_record(&rec);
+
+   return(rfac + rgeo);
  }
 
 /***********************************************************************
   Calculate IV curves
 ***********************************************************************/
 
- n_calc ++;
- sr_mkinp(par, n_calc, par_file);
+ i_calc = ++ ctx->n_calc;
+ SR_EVALRF_UNLOCK();
+
+ if (sr_mkinp(ctx, par, i_calc, slot) != 1)
+ {
+   log_stream = sr_log_begin(log_file);
+   fprintf(log_stream, "*** cannot write input files to \"%s\" ***\n",
+           slot->dir);
+   sr_log_end(log_stream);
+   exit(1);
+ }
 
 #ifdef SHORTCUT
 
  rfac = 0.;
- for (i_par = 1; i_par <= sr_search->n_par; i_par ++)
+ for (i_par = 1; i_par <= ctx->search->n_par; i_par ++)
    rfac += 1 - cos(PI*(par[i_par] - 2.3)) + 
            R_fabs(par[i_par] - 2.3);
- rfac /= sr_search->n_par;
+ rfac /= ctx->search->n_par;
 
 #ifdef CONTROL
  fprintf(STDCTR," rfac = %.4f rtot = %.4f\n", rfac, rgeo + rfac);
 #endif
 
- rfac_min = MIN(rfac, rfac_min);
- rfac_max = MAX(rfac, rfac_max);
+ SR_EVALRF_LOCK();
+ ctx->rfac_min = MIN(rfac, ctx->rfac_min);
+ ctx->rfac_max = MAX(rfac, ctx->rfac_max);
 
 #else
 
 /* Added quotation for filepath safety. On Windows, wrap the whole command in cmd /S /C ""..."" so redirection is parsed correctly. */
 #ifdef _WIN32
  (void)snprintf(line_buffer, sizeof(line_buffer),
-         "cmd /S /C \"\"%s\" -b \"%s.bsr\" -i \"%s\" -o \"%s.res\" > \"%s.out\"\"",
+         "cmd /S /C \"\"%s\" -b \"%s\" -i \"%s\" -o \"%s\" > \"%s\"\"",
          getenv("CSEARCH_LEED"),      /* LEED program name */
-         sr_project,                  /* project name for modified bulk file */
-         par_file,                    /* parameter file for overlayer */
-         sr_project,                  /* project name for results file */
-         sr_project);                 /* project name for output file */
+         slot->bsr_file,     /* modified bulk file */
+         slot->par_file,     /* parameter file for overlayer */
+         slot->res_file,     /* results file */
+         slot->out_file);    /* output file */
 #else
  (void)snprintf(line_buffer, sizeof(line_buffer),
-         "\"%s\" -b \"%s.bsr\" -i \"%s\" -o \"%s.res\" > \"%s.out\"",
+         "\"%s\" -b \"%s\" -i \"%s\" -o \"%s\" > \"%s\"",
          getenv("CSEARCH_LEED"),      /* LEED program name */
-         sr_project,                  /* project name for modified bulk file */
-         par_file,                    /* parameter file for overlayer */
-         sr_project,                  /* project name for results file */
-         sr_project);                 /* project name for output file */
+         slot->bsr_file,     /* modified bulk file */
+         slot->par_file,     /* parameter file for overlayer */
+         slot->res_file,     /* results file */
+         slot->out_file);    /* output file */
 #endif
        
 #ifdef CONTROL
  fprintf(STDCTR,"(sr_evalrf %d): calculate IV curves:\n %s\n", 
-         n_eval, line_buffer); 
+         i_eval, line_buffer); 
 #endif
 
- if (system (line_buffer)) {SYS_ERROR_TO_LOG(line_buffer);}
+ t_start = sr_log_clock();
+ iaux = system (line_buffer);
+ t_leed = sr_log_clock() - t_start;
+ if (iaux)
+ {
+   /* keep the output of the LEED program for diagnosis */
+   char out_file[STRSZ];
+   sprintf(out_file, "%s.out", ctx->project);
+   copy_file(slot->out_file, out_file);
+   SYS_ERROR_TO_LOG(line_buffer);
+ }
 
 /***********************************************************************
   Calculate R factor
@@ -228,65 +355,118 @@ FILE *io_stream, *log_stream;
 
 /* changed for Sim. Ann.: range is independent of previous shift. */
 
+ /* requests to the service are serialised */
+ t_start = sr_log_clock();
+ SR_EVALRF_LOCK();
+ if (ctx->rf_serv == 0)
+ {
+   /* one service per process: it reads the control file of one project */
+   if (rf_serv_project[0] == '\0')
+   {
+     sprintf(line_buffer, "%s.ctr", ctx->project);
+     ctx->rf_serv = (sr_rfserv_open(line_buffer, RFAC_TYP, - RFAC_SHIFT_RANGE,
+                         + RFAC_SHIFT_RANGE, RFAC_SHIFT_STEP) == 0) ? 1 : -1;
+     (void)snprintf(rf_serv_project, sizeof(rf_serv_project), "%s",
+                    ctx->project);
+   }
+   else
+     ctx->rf_serv = (strcmp(rf_serv_project, ctx->project) == 0) ? 1 : -1;
+ }
+
+ if (ctx->rf_serv == 1 && !slot->y_res)
+ {
+   if (sr_rfserv_eval(slot->res_file, &rfac, &rr, &shift) != 0)
+   {
+     log_stream = sr_log_begin(log_file);
+     fprintf(log_stream, "* R factor service failed, using %s\n",
+             getenv("CSEARCH_RFAC"));
+     sr_log_end(log_stream);
+     sr_rfserv_close();
+     ctx->rf_serv = -1;
+   }
+ }
+ iaux = slot->y_res ? -1 : ctx->rf_serv;
+ SR_EVALRF_UNLOCK();
+
+ if (iaux != 1)
+ {
+   /* residuals of Rp (sr_lm): range of shifts or a single shift */
+   s_ini = - RFAC_SHIFT_RANGE;
+   s_fin = + RFAC_SHIFT_RANGE;
+   y_opt[0] = '\0';
+   if (slot->y_res)
+   {
+     if (slot->fix_shift) s_ini = s_fin = slot->shift_fix;
+     (void)snprintf(y_opt, sizeof(y_opt), " -y \"%s\"", slot->yres_file);
+   }
+
 #ifdef _WIN32
- (void)snprintf(line_buffer, sizeof(line_buffer),
-         "cmd /S /C \"\"%s\" -t \"%s.res\" -c \"%s.ctr\" -r \"%s\" -s %.2f,%.2f,%.2f > \"%s.dum\"\"",
-         getenv("CSEARCH_RFAC"),      /* R factor program name */
-         sr_project,                  /* project name for the. file */
-         sr_project,                  /* project name for control file */
-         RFAC_TYP,                    /* type of R factor */
-         - RFAC_SHIFT_RANGE,          /* initial shift */
-         + RFAC_SHIFT_RANGE,          /* final shift */
-         RFAC_SHIFT_STEP,             /* step of shift */
-         sr_project);                 /* project name for output file */
+   (void)snprintf(line_buffer, sizeof(line_buffer),
+           "cmd /S /C \"\"%s\" -t \"%s\" -c \"%s.ctr\" -r \"%s\" -s %.2f,%.2f,%.2f%s > \"%s\"\"",
+           getenv("CSEARCH_RFAC"),      /* R factor program name */
+           slot->res_file,     /* theoretical IV curves */
+           ctx->project,                  /* project name for control file */
+           RFAC_TYP,                    /* type of R factor */
+           s_ini,                       /* initial shift */
+           s_fin,                       /* final shift */
+           RFAC_SHIFT_STEP,             /* step of shift */
+           y_opt,                       /* residuals (-y <file>) */
+           slot->dum_file);    /* output file */
 #else
- (void)snprintf(line_buffer, sizeof(line_buffer),
-         "\"%s\" -t \"%s.res\" -c \"%s.ctr\" -r \"%s\" -s %.2f,%.2f,%.2f > \"%s.dum\"",
-         getenv("CSEARCH_RFAC"),      /* R factor program name */
-         sr_project,                  /* project name for the. file */
-         sr_project,                  /* project name for control file */
-         RFAC_TYP,                    /* type of R factor */
-         - RFAC_SHIFT_RANGE,          /* initial shift */
-         + RFAC_SHIFT_RANGE,          /* final shift */
-         RFAC_SHIFT_STEP,             /* step of shift */
-         sr_project);                 /* project name for output file */
+   (void)snprintf(line_buffer, sizeof(line_buffer),
+           "\"%s\" -t \"%s\" -c \"%s.ctr\" -r \"%s\" -s %.2f,%.2f,%.2f%s > \"%s\"",
+           getenv("CSEARCH_RFAC"),      /* R factor program name */
+           slot->res_file,     /* theoretical IV curves */
+           ctx->project,                  /* project name for control file */
+           RFAC_TYP,                    /* type of R factor */
+           s_ini,                       /* initial shift */
+           s_fin,                       /* final shift */
+           RFAC_SHIFT_STEP,             /* step of shift */
+           y_opt,                       /* residuals (-y <file>) */
+           slot->dum_file);    /* output file */
 #endif
 
 #ifdef CONTROL
- fprintf(STDCTR,"(sr_evalrf %d): calculate R factor:\n %s\n", 
-         n_eval, line_buffer); 
+   fprintf(STDCTR,"(sr_evalrf %d): calculate R factor:\n %s\n", 
+           i_eval, line_buffer); 
 #endif
 
- if (system (line_buffer)) {SYS_ERROR_TO_LOG(line_buffer);}
+   if (system (line_buffer)) {SYS_ERROR_TO_LOG(line_buffer);}
 
-/* Read R factor value from output file */
+   /* Read R factor value from output file */
+   iaux = 0;
 
- sprintf(line_buffer, "%s.dum", sr_project);
- io_stream = fopen(line_buffer, "r");
+   io_stream = fopen(slot->dum_file, "r");
 
- while( fgets(line_buffer, STRSZ, io_stream) != NULL)
- {
-	 if(
+   while( io_stream != NULL && fgets(line_buffer, STRSZ, io_stream) != NULL)
+   {
+     if(
 #ifdef REAL_IS_DOUBLE
-	     (iaux = sscanf(line_buffer, "%lf %*lf %lf", &rfac, &shift) )
+         (iaux = sscanf(line_buffer, "%lf %lf %lf", &rfac, &rr, &shift) )
 #endif
 #ifdef REAL_IS_FLOAT
-	     (iaux = sscanf(line_buffer, "%f %*f %f",    &rfac, &shift) )
+         (iaux = sscanf(line_buffer, "%f %f %f",    &rfac, &rr, &shift) )
 #endif
-	     == 2) break;
-	 }
-
-/* Stop with error message if reading error */
-	 if( iaux != 2)
-	 {
-	   log_stream = fopen(log_file, "a");
-	   fprintf(log_stream,"*** error while reading output from %s\n", 
-	           getenv("CSEARCH_RFAC"));
-   fclose(log_stream);
-   exit(1);
- }
+         == 3) break;
+   }
+
+   /* Stop with error message if reading error */
+   if( iaux != 3)
+   {
+     log_stream = sr_log_begin(log_file);
+     fprintf(log_stream,"*** error while reading output from %s\n", 
+             getenv("CSEARCH_RFAC"));
+     sr_log_end(log_stream);
+     exit(1);
+   }
+
+   fclose (io_stream);
+ } /* rf_serv != 1 */
+ t_rfac = sr_log_clock() - t_start;
 
- fclose (io_stream);
+ slot->rfac = rfac;
+ slot->rr = rr;
+ slot->shift = shift;
 
 #ifdef CONTROL
  fprintf(STDCTR," rfac = %.4f\n", rfac);
@@ -294,91 +474,68 @@ FILE *io_stream, *log_stream;
 
 /***********************************************************************
   If this is the minimum R factor copy *.res file to *.rmin
+  (*.par to *.pmin, *.bsr to *.bmin)
 ***********************************************************************/
 
- if(rfac < rfac_min)
+ SR_EVALRF_LOCK();
+ if(rfac < ctx->rfac_min)
  {
-   /* removed dependence on cp system call (no VLA for MSVC builds) */
-   const size_t project_len = cleed_strnlen(sr_project, 4096);
-   if (!sr_project || project_len == 0 || project_len >= 4096)
-   {
-     fprintf(STDERR, "*** error (sr_evalrf): invalid project name\n");
-     exit(1);
-   }
+   char rmin_file[STRSZ];
 
-   const size_t path_len = project_len + 6;
-   char *old_path = (char *)malloc(path_len);
-   char *new_path = (char *)malloc(path_len);
-   if (!old_path || !new_path)
-   {
-     free(old_path);
-     free(new_path);
-     fprintf(STDERR, "*** error (sr_evalrf): allocation error\n");
-     exit(1);
-   }
-   
-   /* res file */
-   snprintf(old_path, path_len, "%s.res", sr_project);
-   snprintf(new_path, path_len, "%s.rmin", sr_project);
-   if (copy_file(old_path, new_path)) 
-   {
-     COPY_ERROR_TO_LOG(old_path, new_path);
-   }
-   
-   /* par file */
-   snprintf(old_path, path_len, "%s.par", sr_project);
-   snprintf(new_path, path_len, "%s.pmin", sr_project);
-   if (copy_file(old_path, new_path)) 
-   {
-     COPY_ERROR_TO_LOG(old_path, new_path);
-   }
-   
-   /* bsr file */
-   snprintf(old_path, path_len, "%s.bsr", sr_project);
-   snprintf(new_path, path_len, "%s.bmin", sr_project);
-   if (copy_file(old_path, new_path)) 
+   if (sr_evslot_promote(slot, ctx->project, rfac) < 0)
    {
-     COPY_ERROR_TO_LOG(old_path, new_path);
+     sprintf(rmin_file, "%s.rmin", ctx->project);
+     COPY_ERROR_TO_LOG(slot->res_file, rmin_file);
    }
 
-   rfac_min = rfac;
-
-   free(old_path);
-   free(new_path);
+   ctx->rfac_min = rfac;
  }
 
- rfac_max = MAX(rfac, rfac_max);
+ ctx->rfac_max = MAX(rfac, ctx->rfac_max);
 #endif /* SHORTCUT */
 
 /***********************************************************************
   Write parameters, R factor and time to *.log file
 ***********************************************************************/
 
- log_stream = fopen(log_file, "a");
+ log_stream = sr_log_begin(log_file);
 
- fprintf(log_stream,"#%3d par:", n_eval);
- for(i_par=1; i_par <= sr_search->n_par_geo; i_par++) 
+ fprintf(log_stream,"#%3d par:", i_eval);
+ for(i_par=1; i_par <= ctx->search->n_par_geo; i_par++) 
    fprintf(log_stream," %.3f", par[i_par]);
  
 
 /*Inserted a routine to print the angles in the 
   log-file for the angle search: 
 */
- if(sr_search->sr_angle)
+ if(ctx->search->sr_angle)
   { 
-  fprintf(log_stream," theta:%.2f",(par[sr_search->i_par_theta]*FAC_THETA)); 
-  fprintf(log_stream," phi:%.2f",  (par[sr_search->i_par_phi  ]*FAC_PHI)  ); 
+  fprintf(log_stream," theta:%.2f",(par[ctx->search->i_par_theta]*FAC_THETA)); 
+  fprintf(log_stream," phi:%.2f",  (par[ctx->search->i_par_phi  ]*FAC_PHI)  ); 
   }
 
 
  fprintf(log_stream," rf:%.4f sh: %.1f rg:%.4f rt:%.4f ", 
          rfac, shift, rgeo, rfac + rgeo);
 
- t_time = time(NULL);
- l_time = localtime(&t_time);
- fprintf(log_stream," dt: %s", asctime(l_time) );
-
- fclose(log_stream);
+ sr_log_time(time_buffer, sizeof(time_buffer));
+ fprintf(log_stream," dt: %s", time_buffer);
+
+ sr_log_end(log_stream);
+ SR_EVALRF_UNLOCK();
+
+ rec.i_eval = i_eval;
+ rec.i_calc = i_calc;
+ rec.slot = slot->id;
+ rec.time = (double)time(NULL);
+ rec.n_par = ctx->search->n_par;
+ rec.par = par;
+ rec.rfac = rfac;
+ rec.shift = shift;
+ rec.rgeo = rgeo;
+ rec.t_leed = t_leed;
+ rec.t_rfac = t_rfac;
+ sr_log_record(&rec);
 
 /***********************************************************************
   Return R factor
@@ -9,6 +9,12 @@ LD/24.04.14
      Provides version information then exits
   
 Changes:
+LD/19.10.26 - options -s er and -j
+LD/19.10.26 - option -s pt
+LD/19.10.26 - options --multistart and --starts
+LD/19.10.26 - option -s lm
+LD/19.10.26 - option --surrogate
+LD/19.10.26 - option --trace
 
 *********************************************************************/
 
@@ -26,12 +32,31 @@ void search_usage(FILE *output) {
     fprintf(output, "  -d <delta>            : initial displacement\n");
     fprintf(output, "  -h --help             : print help and exit\n");
 	fprintf(output, "  -i <inp_file>         : surface parameter input file\n");
+    fprintf(output, "  -j <n_jobs>           : number of LEED evaluations running at the\n"
+                    "                          same time (error bars, parallel\n"
+                    "                          tempering, multi-start and\n"
+                    "                          Levenberg-Marquardt, default: 1)\n");
+    fprintf(output, "  --multistart <n>      : run the search ('sx', 'po' or 'sa') from\n"
+                    "                          n starting points at the same time\n");
 	fprintf(output, "  -s <search_type>      : can be \n"
+                    "                          'er' = error bars at the input geometry\n"
                     "                          'ga' = genetic algorithm\n"
+                    "                          'lm' = Levenberg-Marquardt fit of the\n"
+                    "                                 Y function residuals (Rp)\n"
                     "                          'sa' = simulated annealing\n"
                     "                          'si' = simplex method (default)\n"
                     "                          'sx' = simplex - duplicate\n"
-                    "                          'po' = simulated annealing\n");
+                    "                          'po' = simulated annealing\n"
+                    "                          'pt' = parallel tempering (annealing\n"
+                    "                                 simplices exchanged between\n"
+                    "                                 temperatures)\n");
+    fprintf(output, "  --starts <start_file> : starting points of the multi-start search\n"
+                    "                          (one parameter set per line)\n");
+    fprintf(output, "  --surrogate           : do not evaluate trial points whose R factor\n"
+                    "                          predicted by a surrogate model is clearly\n"
+                    "                          above the best one ('sx' and 'sa')\n");
+    fprintf(output, "  --trace <trace_file>  : write one JSON line per evaluation\n"
+                    "                          (parameters, R factor, shift, timings)\n");
     fprintf(output, "  -v <vertex_file>      : file to read vertex information if resuming search\n");                
     fprintf(output, "  -V --version          : print version and information about this program\n");
     fprintf(output, "\n");
@@ -0,0 +1,273 @@
+/***********************************************************************
+LD/19.10.26
+ File contains:
+
+  sr_lm(struct sr_context *ctx, int ndim, real dpos, int n_jobs,
+        char *log_file)
+ Perform a LEVENBERG-MARQUARDT fit of the residuals of Pendry's
+ R factor (differences of the Y functions).
+ Driver for routine sr_levmar
+
+Changes
+LD/19.10.26 - Creation (copy from srpt.c)
+LD/19.10.26 - the log file is written through sr_log_begin/sr_log_end
+              (sr_log.c).
+
+***********************************************************************/
+
+/**
+ * @file srlm.c
+ * @brief SEARCH driver for the Levenberg-Marquardt fit of the Y function
+ * residuals.
+ *
+ * The R factor program writes the residuals of Rp (crfac -y) for the
+ * best shift of the current point; the columns of the Jacobian are
+ * evaluated for this shift only (all vectors have the same length)
+ * and at the same time in up to n_jobs evaluation slots. A geometry
+ * penalty (sr_ckgeo) is appended as one more residual sqrt(rgeo), i.e.
+ * the sum of squares is the value minimised by the other searches.
+ */
+
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <limits.h>
+
+#include "search.h"
+#include "sr_alloc.h"
+#include "sr_parse.h"
+
+#define FD_STEP_LM   0.2        /* finite difference step in units of dpos */
+#define CENTRAL_LM   0          /* forward differences (ndim evaluations) */
+#define MAX_ITER_LM  50         /* maximum number of Jacobians */
+#define MAX_JOBS_LM  64         /* maximum number of evaluation slots */
+#define EXTRA_RES_LM 1000       /* residuals beyond twice the start value */
+
+/**********************************************************************/
+
+typedef struct sr_lm_job {
+  struct sr_context *ctx;
+  struct sr_evslot slot;
+  real *r_start;              /* residuals of the start point (job 0) */
+  int n_start;                /* number of r_start; 0 once used */
+  real s_start;               /* shift of the start point */
+} sr_lm_job;
+
+static FILE *sr_lm_open_log_append(const char *log_file)
+{
+  FILE *log_stream = sr_log_begin(log_file);
+  if (log_stream == NULL) {
+    OPEN_ERROR(log_file);
+  }
+  return log_stream;
+}
+
+/*
+  read the residuals written by crfac -y: header "<n> <shift> <Rp>",
+  then n values (only the header if res is NULL). Returns n, -1 if the
+  file cannot be read or n > n_max.
+*/
+static int sr_lm_read_yres(const char *file, real *res, int n_max,
+                           real *shift)
+{
+  char line[STRSZ];
+  real head[3];
+  int n = -1, i = 0;
+  FILE *fp = fopen(file, "r");
+
+  if (fp == NULL) return -1;
+  while (fgets(line, STRSZ, fp) != NULL)
+  {
+    if (n < 0)
+    {
+      if (sr_parse_reals(line, head, 3) != 0) continue;
+      n = (int)head[0];
+      *shift = head[1];
+      if (n < 1 || n > n_max || res == NULL) break;
+    }
+    else if (i < n && sr_parse_reals(line, res + i + 1, 1) == 0) i++;
+  }
+  fclose(fp);
+
+  if (res == NULL) i = n;
+  return (n >= 1 && n <= n_max && i == n) ? n : -1;
+}
+
+/* residual function of sr_levmar: Y function residuals and sqrt(rgeo) */
+static int sr_lm_resid(real *par, real *res, int n_max, real *aux,
+                       int fix_aux, void *data)
+{
+  sr_lm_job *job = (sr_lm_job *)data;
+  real rtot, rgeo, shift = 0.;
+  int n;
+
+  /* the start point has been evaluated by sr_lm already */
+  if (!fix_aux && job->n_start > 0)
+  {
+    n = job->n_start;
+    if (n > n_max) return -1;
+    for (int i = 1; i <= n; i++) res[i] = job->r_start[i];
+    *aux = job->s_start;
+    job->n_start = 0;
+    return n;
+  }
+
+  job->slot.y_res = 1;
+  job->slot.fix_shift = fix_aux;
+  job->slot.shift_fix = *aux;
+  remove(job->slot.yres_file);
+
+  rtot = sr_evalrf_slot(job->ctx, par, &job->slot);
+
+  /* no residuals: geometry far outside the limits (no LEED calculation) */
+  n = sr_lm_read_yres(job->slot.yres_file, res, n_max - 1, &shift);
+  if (n < 1) return -1;
+
+  rgeo = rtot - job->slot.rfac;
+  res[n + 1] = (rgeo > 0.) ? R_sqrt(rgeo) : 0.;
+  if (!fix_aux) *aux = shift;
+  return n + 1;
+}
+
+static void sr_lm_write_results(const char *log_file, int n_iter, int n_eval,
+                                int ndim, const real *best, real rmin)
+{
+  FILE *log_stream = sr_lm_open_log_append(log_file);
+  fprintf(log_stream, "\n=> No. of Jacobians: %d, function evaluations "
+          "in sr_levmar: %3d\n", n_iter, n_eval);
+  fprintf(log_stream, "=> Optimum parameter set and function value:\n");
+
+  for (int j_par = 1; j_par <= ndim; j_par++ ) {
+    fprintf(log_stream, "%.6f ", (double)best[j_par]);
+  }
+  fprintf(log_stream, "\nrmin = %.6f\n", (double)rmin);
+  sr_log_end(log_stream);
+}
+
+void sr_lm(struct sr_context *ctx, int ndim, real dpos, int n_jobs,
+           const char *log_file)
+{
+  int n_col = CENTRAL_LM ? 2 * ndim : ndim;
+  int n_job = (n_jobs < 1) ? 1 : (n_jobs > n_col) ? n_col : n_jobs;
+  if (n_job > MAX_JOBS_LM) n_job = MAX_JOBS_LM;
+
+  void *data[MAX_JOBS_LM];
+  sr_lm_job *job = (sr_lm_job *)calloc((size_t)n_job, sizeof(sr_lm_job));
+  real *par = sr_alloc_vector((size_t)ndim);
+  real *r_start = NULL;
+  real rtot, rmin = 0.;
+  int n_start;
+
+  if (job == NULL || par == NULL)
+  {
+    fprintf(STDERR, "*** error (sr_lm): allocation failure\n");
+    exit(1);
+  }
+
+  /***********************************************************************
+    LEVENBERG-MARQUARDT (Y FUNCTION RESIDUALS)
+  ***********************************************************************/
+
+  FILE *log_stream = sr_lm_open_log_append(log_file);
+  fprintf(log_stream, "=> LEVENBERG-MARQUARDT FIT OF Y FUNCTION RESIDUALS:"
+          "\n\n");
+  sr_log_end(log_stream);
+
+  for (int k = 0; k < n_job; k++)
+  {
+    if (sr_evslot_open(&job[k].slot, ctx->project, k + 1) != 0)
+    {
+      log_stream = sr_lm_open_log_append(log_file);
+      fprintf(log_stream, "*** cannot create scratch directory for "
+              "evaluation (CSEARCH_SCRATCH) ***\n");
+      sr_log_end(log_stream);
+      exit(1);
+    }
+    job[k].ctx = ctx;
+    data[k] = job + k;
+  }
+
+  /***********************************************************************
+    Start point (input geometry): the number of residuals determines
+    the size of the Jacobian.
+  ***********************************************************************/
+
+  for (int j_par = 1; j_par <= ndim; j_par++) par[j_par] = 0.;
+
+  job[0].slot.y_res = 1;
+  job[0].slot.fix_shift = 0;
+  rtot = sr_evalrf_slot(ctx, par, &job[0].slot);
+  n_start = sr_lm_read_yres(job[0].slot.yres_file, NULL, INT_MAX - 1,
+                            &job[0].s_start);
+
+  if (n_start >= 1) r_start = sr_alloc_vector((size_t)n_start + 1);
+  if (r_start == NULL ||
+      sr_lm_read_yres(job[0].slot.yres_file, r_start, n_start,
+                      &job[0].s_start) != n_start)
+  {
+    log_stream = sr_lm_open_log_append(log_file);
+    fprintf(log_stream, "*** error while reading residuals from %s "
+            "(option -y)\n", getenv("CSEARCH_RFAC"));
+    sr_log_end(log_stream);
+    exit(1);
+  }
+  rtot -= job[0].slot.rfac;
+  r_start[n_start + 1] = (rtot > 0.) ? R_sqrt(rtot) : 0.;
+  job[0].r_start = r_start;
+  job[0].n_start = n_start + 1;
+
+  /***********************************************************************
+    Enter iteration loop
+  ***********************************************************************/
+
+  sr_levmar_cfg cfg = {0};
+  cfg.n_max = 2 * (n_start + 1) + EXTRA_RES_LM;
+  cfg.n_jobs = n_job;
+  cfg.h = FD_STEP_LM * dpos;
+  cfg.central = CENTRAL_LM;
+  cfg.ftol = R_TOLERANCE;
+  cfg.max_iter = MAX_ITER_LM;
+  cfg.func = sr_lm_resid;
+  cfg.data = data;
+
+  log_stream = sr_lm_open_log_append(log_file);
+  fprintf(log_stream, "=> Start fit (%d residuals, %s differences, "
+          "step = %.4f, %d evaluations at the same time, "
+          "rel. tolerance = %.3e)\n", n_start,
+          CENTRAL_LM ? "central" : "forward", cfg.h, n_job, R_TOLERANCE);
+  sr_log_end(log_stream);
+
+  int n_iter = 0, n_eval = 0;
+  if (sr_levmar(par, ndim, &rmin, &cfg, &n_iter, &n_eval) != 0)
+  {
+    fprintf(STDERR, "*** error (sr_lm): Levenberg-Marquardt fit failed\n");
+    exit(1);
+  }
+
+  /***********************************************************************
+    Write final results to log file
+  ***********************************************************************/
+
+#ifdef CONTROL
+  fprintf(STDCTR, "(sr_lm): %d Jacobians, %d function evaluations\n",
+          n_iter, n_eval);
+#endif
+  sr_lm_write_results(log_file, n_iter, n_eval, ndim, par, rmin);
+
+  for (int k = 0; k < n_job; k++)
+  {
+    sr_evslot_close(&job[k].slot);
+  }
+  free(job);
+  sr_free_vector(par);
+  sr_free_vector(r_start);
+
+} /* end of function sr_lm */
+
+/***********************************************************************/
@@ -3,7 +3,8 @@
 
  file contains function:
 
-  int sr_mkinp(real *pos, int i_call, char *filename)
+  int sr_mkinp(const struct sr_context *ctx, real *pos, int i_call,
+               const struct sr_evslot *slot)
 
  Prepare (par)input file for CLEED program
 
@@ -12,6 +13,9 @@
 GH/22.08.95 - Creation (copy from srmkinp.c)
 SRP/31.03.03 - Added a section for the angle search
 GH/09.08.04 - Copy bulk parameters (except angles from *.bul and write to *.bsr
+LD/19.10.26 - write the files of an evaluation slot (sr_evslot.c) instead
+              of names derived from the parameter file; no global buffer.
+LD/19.10.26 - atoms and search parameters are taken from a search context.
 
 ***********************************************************************/
 
@@ -28,24 +32,27 @@ GH/09.08.04 - Copy bulk parameters (except angles from *.bul and write to *.bsr
 #define FAC_PHI   50.
 #endif
 
-extern struct sratom_str *sr_atoms;
-extern struct search_str *sr_search;
-
-char line_buffer[STRSZ];
-
-int sr_mkinp(real *par, int i_call, char *filename)
+int sr_mkinp(const struct sr_context *ctx, real *par, int i_call,
+             const struct sr_evslot *slot)
 
 /***********************************************************************
  - Set up inputfile for IV program
  
 INPUT:
- filename: name of IV input file
+ ctx:  search context (atoms and search parameters).
+ slot: evaluation slot; slot->par_file (overlayer) and slot->bsr_file
+       (bulk, from slot->bul_file) are written.
+
+RETURN VALUE:
+ 1 on success, -1 if a file cannot be opened.
 ***********************************************************************/
 
 {
 int i_atoms, i_par;
 int i_str;
 
+char line_buffer[STRSZ];
+
 real x, y, z;
 real theta, phi; /* Added for the angle search (SRP 31.03.03) */
 
@@ -55,18 +62,24 @@ FILE *iv_bul_out;
 
 
 /* Open IV parameter file */
- iv_par = fopen(filename, "w"); 
+ iv_par = fopen(slot->par_file, "w"); 
 
 /**********************************************************************/
 /* Open IV bulk file for read and write */
- strncpy(line_buffer, filename, STRSZ);
- i_str = strlen(line_buffer) - 3;
+ iv_bul_in = fopen(slot->bul_file, "r"); 
+ iv_bul_out= fopen(slot->bsr_file, "w"); 
 
- sprintf(line_buffer+i_str,"bul");
- iv_bul_in = fopen(line_buffer, "r"); 
-
- sprintf(line_buffer+i_str,"bsr");
- iv_bul_out= fopen(line_buffer, "w"); 
+ if (iv_par == NULL || iv_bul_in == NULL || iv_bul_out == NULL)
+ {
+#ifdef ERROR
+   fprintf(STDERR, " *** error (sr_mkinp): cannot open \"%s\", \"%s\" "
+           "or \"%s\"\n", slot->par_file, slot->bul_file, slot->bsr_file);
+#endif
+   if (iv_par != NULL) fclose(iv_par);
+   if (iv_bul_in != NULL) fclose(iv_bul_in);
+   if (iv_bul_out != NULL) fclose(iv_bul_out);
+   return(-1);
+ }
 /**********************************************************************/
 
 /* 
@@ -78,40 +91,40 @@ FILE *iv_bul_out;
  Write all other lines to iv_input
 */
 
- for( i_atoms = 0; (sr_atoms + i_atoms)->type != I_END_OF_LIST; i_atoms ++)
+ for( i_atoms = 0; (ctx->atoms + i_atoms)->type != I_END_OF_LIST; i_atoms ++)
  {
-   x = (sr_atoms + i_atoms)->x;
-   y = (sr_atoms + i_atoms)->y;
-   z = (sr_atoms + i_atoms)->z;
+   x = (ctx->atoms + i_atoms)->x;
+   y = (ctx->atoms + i_atoms)->y;
+   z = (ctx->atoms + i_atoms)->z;
 
-   for(i_par = 1; i_par <= (sr_search->n_par_geo); i_par ++) 
+   for(i_par = 1; i_par <= (ctx->search->n_par_geo); i_par ++) 
    {
-     if(!sr_search->z_only)
+     if(!ctx->search->z_only)
      {
-       x += par[i_par] * (sr_atoms + i_atoms)->x_par[i_par];
-       y += par[i_par] * (sr_atoms + i_atoms)->y_par[i_par];
+       x += par[i_par] * (ctx->atoms + i_atoms)->x_par[i_par];
+       y += par[i_par] * (ctx->atoms + i_atoms)->y_par[i_par];
      }
-     z += par[i_par] * (sr_atoms + i_atoms)->z_par[i_par];
+     z += par[i_par] * (ctx->atoms + i_atoms)->z_par[i_par];
    }
 
    fprintf(iv_par,"po: %s %f %f %f dr1 %f\n",
-                  (sr_atoms + i_atoms)->name,
+                  (ctx->atoms + i_atoms)->name,
                   x, y, z, 
-                  (sr_atoms + i_atoms)->dr);
+                  (ctx->atoms + i_atoms)->dr);
  } /* for i_atoms */
 
 
 /* angle search */
 
- if(sr_search->sr_angle)
+ if(ctx->search->sr_angle)
  {
-   phi =   sr_search->phi_0   + par[sr_search->i_par_phi]   * FAC_PHI;
-   theta = sr_search->theta_0 + par[sr_search->i_par_theta] * FAC_THETA;
+   phi =   ctx->search->phi_0   + par[ctx->search->i_par_phi]   * FAC_PHI;
+   theta = ctx->search->theta_0 + par[ctx->search->i_par_theta] * FAC_THETA;
  }
  else
  {
-   phi =   sr_search->phi_0;
-   theta = sr_search->theta_0;
+   phi =   ctx->search->phi_0;
+   theta = ctx->search->theta_0;
  }
 
 
@@ -157,11 +170,6 @@ FILE *iv_bul_out;
  fclose(iv_bul_in);
  fclose(iv_bul_out);
 
- strncpy(line_buffer, filename, STRSZ);
- i_str = strlen(line_buffer) -4;
- line_buffer[i_str] = '\0';
-
-
 /**********************************************************************/
 
  fclose(iv_par);
@@ -0,0 +1,633 @@
+/***********************************************************************
+LD/19.10.26
+ File contains:
+
+  sr_ms(struct sr_context *ctx, int search_type, int n_start,
+        char *start_file, int ndim, real dpos, int n_jobs, char *log_file)
+ Perform a MULTI-START search: the simplex method, Powell's method or
+ simulated annealing from several starting points at the same time.
+
+Changes
+LD/19.10.26 - Creation (copy from srpt.c)
+LD/19.10.26 - the log file is written through sr_log_begin/sr_log_end
+              (sr_log.c).
+LD/19.10.26 - random starting points with unacceptable geometry are
+              redrawn (sr_geo_batch).
+
+***********************************************************************/
+
+/**
+ * @file srms.c
+ * @brief SEARCH driver for multi-start searches.
+ *
+ * Each start is a run of the selected optimiser in its own thread and
+ * evaluation slot. The LEED/R factor evaluations of all runs share one
+ * pool of `n_jobs` workers: a run waits for a free worker before each
+ * evaluation, so that never more than `n_jobs` calculations run at the
+ * same time, however many starts there are.
+ *
+ * A run that has made at least MS_KILL_EVAL * (ndim + 1) evaluations and
+ * whose best R factor is higher than the best of all runs by more than
+ * MS_KILL_MARGIN is stopped: its optimiser gets the best value of the
+ * run for all further parameter sets without a calculation and
+ * terminates after a few steps.
+ *
+ * The minimum of run k is kept in `<project>_ms<k>.rmin`, `.pmin` and
+ * `.bmin` (and, for the simplex method, the vertex in `<project>_ms<k>.ver`);
+ * `<project>.pmin` etc. hold the minimum of all runs as usual. The ranked
+ * minima are written to the log file and to `<project>.msum`.
+ */
+
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "search.h"
+#include "sr_alloc.h"
+#include "sr_parse.h"
+#include "sr_rng.h"
+#include "sr_simplex.h"
+
+#if !defined(_WIN32)
+#define SR_MS_THREAD
+#include <pthread.h>
+#endif
+
+#define MS_SPREAD      3.       /* generated starts within +-MS_SPREAD*dpos */
+#define MS_KILL_MARGIN 0.10     /* stop runs worse than the best by more */
+#define MS_KILL_EVAL   3        /* ... after MS_KILL_EVAL*(ndim+1) evaluations */
+#define MS_SCREEN_GEN  20       /* generations of random starts screened */
+
+#define START_TEMP     3.5      /* simulated annealing (as sr_sa) */
+#define EPSILON        0.25
+#define MAX_ITER_SA  200
+
+#ifdef SR_MS_THREAD
+#define SR_MS_LOCK(ms)   pthread_mutex_lock(&(ms)->lock)
+#define SR_MS_UNLOCK(ms) pthread_mutex_unlock(&(ms)->lock)
+#else
+#define SR_MS_LOCK(ms)
+#define SR_MS_UNLOCK(ms)
+#endif
+
+/**********************************************************************/
+
+struct sr_ms_ctx;
+
+typedef struct sr_ms_run {
+  struct sr_ms_ctx *ms;
+  int id;                     /* number of the run (1 ... n_start) */
+  char prefix[STRSZ];         /* <project>_ms<id> */
+  struct sr_evslot slot;
+  real *start;                /* starting point */
+  real *pb;                   /* best point so far */
+  real rmin;                  /* best R factor so far */
+  int n_eval;                 /* number of LEED calculations */
+  int killed;                 /* run stopped (losing) */
+  int failed;
+  long idum;                  /* seed (simulated annealing) */
+} sr_ms_run;
+
+typedef struct sr_ms_ctx {
+  struct sr_context *ctx;
+  int search_type;
+  int ndim;
+  real dpos;
+  int n_jobs;                 /* size of the worker pool */
+  int n_busy;                 /* workers in use */
+  int kill_after;             /* evaluations before a run may be stopped */
+  real rmin;                  /* best R factor of all runs */
+  const char *log_file;
+#ifdef SR_MS_THREAD
+  pthread_mutex_t lock;
+  pthread_cond_t idle;        /* a worker has become free */
+#endif
+} sr_ms_ctx;
+
+static FILE *sr_ms_open_log_append(const char *log_file)
+{
+  FILE *log_stream = sr_log_begin(log_file);
+  if (log_stream == NULL) {
+    OPEN_ERROR(log_file);
+  }
+  return log_stream;
+}
+
+static const char *sr_ms_method(int search_type)
+{
+  switch (search_type)
+  {
+    case SR_SIMPLEX:       return "simplex";
+    case SR_POWELL:        return "powell";
+    case SR_SIM_ANNEALING: return "simulated annealing";
+    default:               return "unknown";
+  }
+}
+
+/* lose: the run has had its chance and is clearly worse than the best */
+static int sr_ms_losing(const sr_ms_ctx *ms, const sr_ms_run *run)
+{
+  return (run->n_eval >= ms->kill_after &&
+          run->rmin > ms->rmin + MS_KILL_MARGIN);
+}
+
+/* run->killed is written under ms->lock (sr_ms_eval); read it the same way */
+static int sr_ms_killed(sr_ms_run *run)
+{
+  int killed;
+
+  SR_MS_LOCK(run->ms);
+  killed = run->killed;
+  SR_MS_UNLOCK(run->ms);
+  return killed;
+}
+
+/***********************************************************************
+  objective function of a run: wait for a worker of the pool, then
+  LEED/R factor evaluation in the slot of the run
+***********************************************************************/
+
+static real sr_ms_eval(real *par, void *data)
+{
+  sr_ms_run *run = (sr_ms_run *)data;
+  sr_ms_ctx *ms = run->ms;
+  real rfac;
+  int improved;
+
+  SR_MS_LOCK(ms);
+  if (!run->killed && sr_ms_losing(ms, run)) run->killed = 1;
+  if (run->killed)
+  {
+    SR_MS_UNLOCK(ms);
+    return run->rmin;                /* no more calculations */
+  }
+#ifdef SR_MS_THREAD
+  while (ms->n_busy >= ms->n_jobs) pthread_cond_wait(&ms->idle, &ms->lock);
+#endif
+  ms->n_busy ++;
+  SR_MS_UNLOCK(ms);
+
+  rfac = sr_evalrf_slot(ms->ctx, par, &run->slot);
+
+  SR_MS_LOCK(ms);
+  ms->n_busy --;
+#ifdef SR_MS_THREAD
+  pthread_cond_signal(&ms->idle);
+#endif
+  run->n_eval ++;
+  improved = (rfac < run->rmin);
+  if (improved)
+  {
+    run->rmin = rfac;
+    sr_simplex_copy_point(run->pb, par, ms->ndim);
+  }
+  if (rfac < ms->rmin) ms->rmin = rfac;
+  if (sr_ms_losing(ms, run)) run->killed = 1;
+  SR_MS_UNLOCK(ms);
+
+  /* minimum of this run (the minimum of all runs is kept by sr_evalrf) */
+  if (improved && sr_evslot_promote(&run->slot, run->prefix, rfac) < 0)
+  {
+#ifdef WARNING
+    fprintf(STDWAR, "* warning (sr_ms): cannot write %s.pmin\n", run->prefix);
+#endif
+  }
+
+  return rfac;
+}
+
+/***********************************************************************
+  optimisers
+***********************************************************************/
+
+static int sr_ms_simplex(sr_ms_run *run, int anneal)
+{
+  sr_ms_ctx *ms = run->ms;
+  sr_simplex_buffers b;
+  int nfunc = 0, ret = 0;
+
+  if (sr_simplex_buffers_alloc(&b, ms->ndim) != 0 ||
+      sr_simplex_build_at(&b, run->start, ms->dpos, sr_ms_eval, run) != 0)
+  {
+    sr_simplex_buffers_free(&b);
+    return -1;
+  }
+
+  if (!anneal)
+  {
+    ret = sr_amoeba_data(b.p, b.y, ms->ndim, R_TOLERANCE, sr_ms_eval, run,
+                         run->prefix, &nfunc);
+  }
+  else
+  {
+    real rmin = 100.;
+    for (real temp = START_TEMP; temp > R_TOLERANCE && !sr_ms_killed(run);
+         temp *= (1. - EPSILON))
+    {
+      int budget = MAX_ITER_SA;
+      sr_amebsa_cfg cfg = {0};
+      cfg.ftol = temp;
+      cfg.temptr = temp;
+      cfg.funk_data = sr_ms_eval;
+      cfg.data = run;
+      cfg.idum = &run->idum;
+      (void)sr_amebsa(b.p, b.y, ms->ndim, b.x, &rmin, &cfg, &budget);
+    }
+  }
+
+  sr_simplex_buffers_free(&b);
+  return ret;
+}
+
+static int sr_ms_powell(sr_ms_run *run)
+{
+  int ndim = run->ms->ndim;
+  real *p = sr_alloc_vector((size_t)ndim);
+  real **xi = sr_alloc_matrix((size_t)ndim, (size_t)ndim);
+  real fret = 0.;
+  int iter = 0, ret = -1;
+
+  if (p != NULL && xi != NULL)
+  {
+    for (int i = 1; i <= ndim; i++)
+    {
+      p[i] = run->start[i];
+      for (int j = 1; j <= ndim; j++) xi[i][j] = (i == j) ? 1.0 : 0.0;
+    }
+    ret = sr_powell_data(p, xi, ndim, R_TOLERANCE, &iter, &fret,
+                         sr_ms_eval, run);
+  }
+
+  sr_free_matrix(xi);
+  sr_free_vector(p);
+  return ret;
+}
+
+static void *sr_ms_worker(void *arg)
+{
+  sr_ms_run *run = (sr_ms_run *)arg;
+  sr_ms_ctx *ms = run->ms;
+  FILE *log_stream;
+  int ret;
+
+  switch (ms->search_type)
+  {
+    case SR_POWELL:        ret = sr_ms_powell(run); break;
+    case SR_SIM_ANNEALING: ret = sr_ms_simplex(run, 1); break;
+    default:               ret = sr_ms_simplex(run, 0); break;
+  }
+
+  SR_MS_LOCK(ms);
+  run->failed = (ret != 0 && !run->killed);
+  log_stream = sr_ms_open_log_append(ms->log_file);
+  if (log_stream != NULL)
+  {
+    fprintf(log_stream, "=> run %2d: rmin = %.6f after %d evaluations (%s)\n",
+            run->id, (double)run->rmin, run->n_eval,
+            run->failed ? "failed" : run->killed ? "stopped" : "converged");
+    sr_log_end(log_stream);
+  }
+  SR_MS_UNLOCK(ms);
+
+  return NULL;
+}
+
+/***********************************************************************
+  starting points: from start_file (one point per line), then random
+  points around the input geometry (the first one being the input
+  geometry itself if there is no start_file). Random points with
+  rgeo > SR_RGEO_MAX (see sr_geo_batch) are redrawn, at most
+  MS_SCREEN_GEN times, before any LEED calculation is started.
+***********************************************************************/
+
+static int sr_ms_read_starts(const char *start_file, sr_ms_run *run,
+                             int n_start, int ndim)
+{
+  char line[STRSZ];
+  int n_read = 0;
+  FILE *fp = fopen(start_file, "r");
+
+  if (fp == NULL) return -1;
+  while (n_read < n_start && fgets(line, (int)sizeof(line), fp) != NULL)
+  {
+    if (sr_parse_reals(line, run[n_read].start + 1, ndim) == 0) n_read ++;
+  }
+  fclose(fp);
+  return n_read;
+}
+
+static int sr_ms_generate_starts(const struct sr_context *ctx, sr_ms_run *run,
+                                 int i_first, int n_start, int ndim,
+                                 real dpos, long idum, int *n_bad)
+{
+  sr_rng rng;
+  struct sr_geoscreen geo = {0};
+  real **cand = (real **)malloc((size_t)(n_start + 1) * sizeof(real *));
+  real *rgeo = sr_alloc_vector((size_t)n_start);
+  int n_pend = 0, n_redraw = 0;
+
+  if (cand == NULL || rgeo == NULL)
+  {
+    fprintf(STDERR, "*** error (sr_ms): allocation failure\n");
+    exit(1);
+  }
+
+  sr_rng_seed(&rng, (uint64_t)labs(idum) + 1);
+  for (int k = i_first; k < n_start; k++)
+  {
+    if (k == 0)
+      for (int j = 1; j <= ndim; j++) run[k].start[j] = 0.;
+    else
+      cand[++n_pend] = run[k].start;
+  }
+
+  /* draw all pending points, screen them at once, redraw the bad ones */
+  for (int gen = 0; n_pend > 0 && gen < MS_SCREEN_GEN; gen++)
+  {
+    int n_keep = 0;
+
+    if (gen > 0) n_redraw += n_pend;
+    for (int i = 1; i <= n_pend; i++)
+      for (int j = 1; j <= ndim; j++)
+        cand[i][j] =
+            (real)((2. * sr_rng_uniform01(&rng) - 1.) * MS_SPREAD * dpos);
+
+    if (sr_geo_batch(&geo, ctx, cand, n_pend, rgeo) == 0) n_pend = 0;
+    for (int i = 1; i <= n_pend; i++)
+      if (rgeo[i] > SR_RGEO_MAX) cand[++n_keep] = cand[i];
+    n_pend = n_keep;
+  }
+
+  *n_bad = n_pend;
+  sr_geo_free(&geo);
+  sr_free_vector(rgeo);
+  free(cand);
+  return n_redraw;
+}
+
+static int sr_ms_count_starts(const char *start_file, int ndim)
+{
+  char line[STRSZ];
+  int n = 0;
+  real *v = sr_alloc_vector((size_t)ndim);
+  FILE *fp = fopen(start_file, "r");
+
+  if (fp != NULL && v != NULL)
+  {
+    while (fgets(line, (int)sizeof(line), fp) != NULL)
+    {
+      if (sr_parse_reals(line, v + 1, ndim) == 0) n ++;
+    }
+  }
+  if (fp != NULL) fclose(fp);
+  sr_free_vector(v);
+  return n;
+}
+
+/***********************************************************************
+  summary
+***********************************************************************/
+
+/* order of the runs: failed runs last, then by R factor */
+static int sr_ms_before(const sr_ms_run *ra, const sr_ms_run *rb)
+{
+  if (ra->failed != rb->failed) return rb->failed;
+  return (ra->rmin < rb->rmin) || (!(ra->rmin > rb->rmin) && ra->id < rb->id);
+}
+
+static void sr_ms_rank(const sr_ms_run *run, int *rank, int n_start)
+{
+  for (int i = 0; i < n_start; i++)
+  {
+    int k = i;
+    while (k > 0 && sr_ms_before(run + i, run + rank[k - 1]))
+    {
+      rank[k] = rank[k - 1];
+      k --;
+    }
+    rank[k] = i;
+  }
+}
+
+static void sr_ms_write_ranking(FILE *out, const sr_ms_run *run,
+                                const int *rank, int n_start, int ndim)
+{
+  fprintf(out, "# rank  run      rmin  n_eval  status     files\n");
+  for (int i = 0; i < n_start; i++)
+  {
+    const sr_ms_run *r = run + rank[i];
+    fprintf(out, "%6d %4d %9.6f %7d  %-9s  %s.pmin %s.bmin ",
+            i + 1, r->id, (double)r->rmin, r->n_eval,
+            r->failed ? "failed" : r->killed ? "stopped" : "converged",
+            r->prefix, r->prefix);
+    for (int j = 1; j <= ndim; j++) fprintf(out, " %.6f", (double)r->pb[j]);
+    fprintf(out, "\n");
+  }
+}
+
+static void sr_ms_write_summary(const sr_ms_ctx *ms, const sr_ms_run *run,
+                                int n_start)
+{
+  char sum_file[STRSZ];
+  FILE *out;
+  int *rank = (int *)malloc((size_t)n_start * sizeof(int));
+
+  if (rank == NULL) return;
+  sr_ms_rank(run, rank, n_start);
+
+  (void)snprintf(sum_file, sizeof(sum_file), "%s.msum", ms->ctx->project);
+  out = fopen(sum_file, "w");
+  if (out == NULL)
+  {
+    OPEN_ERROR(sum_file);
+  }
+  else
+  {
+    fprintf(out, "# %s: %d starts (%s), %d evaluations at the same time\n",
+            ms->ctx->project, n_start, sr_ms_method(ms->search_type),
+            ms->n_jobs);
+    sr_ms_write_ranking(out, run, rank, n_start, ms->ndim);
+    fclose(out);
+  }
+
+  out = sr_ms_open_log_append(ms->log_file);
+  if (out != NULL)
+  {
+    const sr_ms_run *best = run + rank[0];
+
+    fprintf(out, "\n=> Ranked minima (see \"%s\"):\n", sum_file);
+    sr_ms_write_ranking(out, run, rank, n_start, ms->ndim);
+    fprintf(out, "=> Optimum parameter set and function value (run %d):\n",
+            best->id);
+    for (int j = 1; j <= ms->ndim; j++)
+      fprintf(out, "%.6f ", (double)best->pb[j]);
+    fprintf(out, "\nrmin = %.6f\n", (double)best->rmin);
+    sr_log_end(out);
+  }
+
+  free(rank);
+}
+
+/**********************************************************************/
+
+void sr_ms(struct sr_context *ctx, int search_type, int n_start,
+           const char *start_file, int ndim, real dpos, int n_jobs,
+           const char *log_file)
+{
+  sr_ms_ctx ms;
+  sr_ms_run *run;
+  FILE *log_stream;
+  int n_read = 0, n_redraw, n_bad;
+
+  if (n_start <= 0 && start_file != NULL)
+    n_start = sr_ms_count_starts(start_file, ndim);
+  if (n_start > SR_MS_MAX_START) n_start = SR_MS_MAX_START;
+  if (n_start <= 0)
+  {
+    fprintf(STDERR, "*** error (sr_ms): no starting points\n");
+    exit(1);
+  }
+
+  ms.ctx = ctx;
+  ms.search_type = search_type;
+  ms.ndim = ndim;
+  ms.dpos = dpos;
+  ms.n_jobs = (n_jobs < 1) ? 1 : n_jobs;
+  ms.n_busy = 0;
+  ms.kill_after = MS_KILL_EVAL * (ndim + 1);
+  ms.rmin = 100.;
+  ms.log_file = log_file;
+
+  run = (sr_ms_run *)calloc((size_t)n_start, sizeof(sr_ms_run));
+  if (run == NULL)
+  {
+    fprintf(STDERR, "*** error (sr_ms): allocation failure\n");
+    exit(1);
+  }
+  for (int k = 0; k < n_start; k++)
+  {
+    run[k].ms = &ms;
+    run[k].id = k + 1;
+    (void)snprintf(run[k].prefix, sizeof(run[k].prefix), "%s_ms%02d",
+                   ctx->project, k + 1);
+    run[k].start = sr_alloc_vector((size_t)ndim);
+    run[k].pb = sr_alloc_vector((size_t)ndim);
+    run[k].rmin = 100.;
+    run[k].idum = ctx->idum - 7919L * k;
+    if (run[k].start == NULL || run[k].pb == NULL)
+    {
+      fprintf(STDERR, "*** error (sr_ms): allocation failure\n");
+      exit(1);
+    }
+  }
+
+  /***********************************************************************
+    MULTI-START SEARCH
+  ***********************************************************************/
+
+  log_stream = sr_ms_open_log_append(log_file);
+  fprintf(log_stream, "=> MULTI-START SEARCH:\n\n");
+
+  if (start_file != NULL)
+  {
+    n_read = sr_ms_read_starts(start_file, run, n_start, ndim);
+    if (n_read < 0)
+    {
+      sr_log_end(log_stream);
+      OPEN_ERROR(start_file);
+      exit(1);
+    }
+    fprintf(log_stream, "=> %d starting points read from \"%s\"\n",
+            n_read, start_file);
+  }
+  n_redraw = sr_ms_generate_starts(ctx, run, n_read, n_start, ndim, dpos,
+                                   ctx->idum, &n_bad);
+  if (n_redraw > 0)
+    fprintf(log_stream, "=> Geometry screening: %d random starting points "
+            "redrawn (rgeo > %.1f), %d not acceptable\n", n_redraw,
+            SR_RGEO_MAX, n_bad);
+
+  for (int k = 0; k < n_start; k++)
+  {
+    fprintf(log_stream, "%3d:", k + 1);
+    for (int j = 1; j <= ndim; j++)
+      fprintf(log_stream, " %7.4f", (double)run[k].start[j]);
+    fprintf(log_stream, "\n");
+
+    if (sr_evslot_open(&run[k].slot, ctx->project, k + 1) != 0)
+    {
+      fprintf(log_stream, "*** cannot create scratch directory for "
+              "evaluation (CSEARCH_SCRATCH) ***\n");
+      sr_log_end(log_stream);
+      exit(1);
+    }
+  }
+
+  fprintf(log_stream, "=> Start %d runs (%s, %d evaluations at the same "
+          "time, abs. tolerance = %.3e)\n", n_start,
+          sr_ms_method(search_type), ms.n_jobs, R_TOLERANCE);
+  sr_log_end(log_stream);
+
+  /***********************************************************************
+    One thread per run; the pool limits the concurrent evaluations.
+  ***********************************************************************/
+
+#ifdef SR_MS_THREAD
+  pthread_mutex_init(&ms.lock, NULL);
+  pthread_cond_init(&ms.idle, NULL);
+  {
+    pthread_t *thread = (pthread_t *)calloc((size_t)n_start,
+                                            sizeof(pthread_t));
+    int *started = (int *)calloc((size_t)n_start, sizeof(int));
+
+    for (int k = 0; thread != NULL && started != NULL && k < n_start; k++)
+    {
+      started[k] = (pthread_create(thread + k, NULL, sr_ms_worker,
+                                   run + k) == 0);
+#ifdef WARNING
+      if (!started[k])
+        fprintf(STDWAR, "* warning (sr_ms): cannot start thread for run %d\n",
+                k + 1);
+#endif
+    }
+    /* runs without a thread are done by this one */
+    for (int k = 0; k < n_start; k++)
+    {
+      if (thread != NULL && started != NULL && started[k])
+        pthread_join(thread[k], NULL);
+      else
+        sr_ms_worker(run + k);
+    }
+    free(thread);
+    free(started);
+  }
+  pthread_cond_destroy(&ms.idle);
+  pthread_mutex_destroy(&ms.lock);
+#else
+  for (int k = 0; k < n_start; k++) sr_ms_worker(run + k);
+#endif
+
+  /***********************************************************************
+    Write ranked minima to log and summary file
+  ***********************************************************************/
+
+#ifdef CONTROL
+  fprintf(STDCTR, "(sr_ms): %d runs finished, rmin = %.6f\n", n_start,
+          (double)ms.rmin);
+#endif
+  sr_ms_write_summary(&ms, run, n_start);
+
+  for (int k = 0; k < n_start; k++)
+  {
+    sr_evslot_close(&run[k].slot);
+    sr_free_vector(run[k].start);
+    sr_free_vector(run[k].pb);
+  }
+  free(run);
+
+} /* end of function sr_ms */
+
+/***********************************************************************/
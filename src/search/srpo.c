@@ -2,12 +2,15 @@
 GH/19.09.95
  File contains:
 
-  sr_po(int ndim, char *bak_file, char *log_file)
+  sr_po(struct sr_context *ctx, int ndim, char *bak_file, char *log_file)
  Perform a search according to POWELL'S METHOD
 
  Driver for routine AMOEBA (From numerical recipes)
  Modified:
  GH/23.08.95
+ LD/19.10.26 - evaluate in the search context ctx (sr_powell_data).
+ LD/19.10.26 - the log file is written through sr_log_begin/sr_log_end
+               (sr_log.c).
 ***********************************************************************/
 
 #include <stdio.h>
@@ -22,7 +25,7 @@ GH/19.09.95
 
 static FILE *sr_po_open_log_append(const char *log_file)
 {
-  FILE *log_stream = fopen(log_file, "a");
+  FILE *log_stream = sr_log_begin(log_file);
   if (log_stream == NULL) {
     OPEN_ERROR(log_file);
   }
@@ -83,7 +86,8 @@ static void sr_po_initialise(FILE *log_stream, int ndim, const char *bak_file, s
   }
 }
 
-void sr_po(int ndim, const char *bak_file, const char *log_file)
+void sr_po(struct sr_context *ctx, int ndim, const char *bak_file,
+           const char *log_file)
 {
   int nfunc = 0;
   real rmin = 0.0;
@@ -115,9 +119,10 @@ void sr_po(int ndim, const char *bak_file, const char *log_file)
 ***********************************************************************/
 
   fprintf(log_stream, "=> Start search (abs. tolerance = %.3e)\n", R_TOLERANCE);
-  fclose(log_stream);
+  sr_log_end(log_stream);
 
-  if (sr_powell(b.p, b.xi, ndim, R_TOLERANCE, &nfunc, &rmin, sr_evalrf) != 0)
+  if (sr_powell_data(b.p, b.xi, ndim, R_TOLERANCE, &nfunc, &rmin,
+                     sr_evalrf_ctx, ctx) != 0)
   {
     fprintf(STDERR, "*** error (sr_po): Powell minimiser failed\n");
   }
@@ -128,7 +133,7 @@ void sr_po(int ndim, const char *bak_file, const char *log_file)
 
   log_stream = sr_po_open_log_append(log_file);
   sr_po_write_results(log_stream, ndim, nfunc, rmin, b.p);
-  fclose(log_stream);
+  sr_log_end(log_stream);
 
   sr_po_free_buffers(&b);
 }
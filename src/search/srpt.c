@@ -0,0 +1,256 @@
+/***********************************************************************
+LD/19.10.26
+ File contains:
+
+  sr_pt(struct sr_context *ctx, int ndim, real dpos, int n_jobs,
+        char *bak_file, char *log_file)
+ Perform a search according to the PARALLEL TEMPERING method:
+ replicas of the simulated annealing simplex at fixed temperatures.
+ Driver for routine sr_ptemper
+
+Changes
+LD/19.10.26 - Creation (copy from srsa.c)
+LD/19.10.26 - evaluate in the search context ctx.
+LD/19.10.26 - the log file is written through sr_log_begin/sr_log_end
+              (sr_log.c).
+LD/19.10.26 - at least N_REPLICA replicas, of which at most n_jobs are
+              annealed (i.e. evaluated) at the same time.
+
+***********************************************************************/
+
+/**
+ * @file srpt.c
+ * @brief SEARCH driver for parallel tempering (replica exchange of
+ * annealing simplices).
+ *
+ * Each replica evaluates in its own evaluation slot; results are shared
+ * between the replicas through an evaluation cache, so that a simplex
+ * handed to another temperature, or a point visited again, does not
+ * cost a second LEED calculation.
+ */
+
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "search.h"
+#include "sr_alloc.h"
+#include "sr_simplex.h"
+
+#define START_TEMP     3.5      /* hottest replica (as sr_sa) */
+#define END_TEMP       5.e-3    /* coldest replica */
+#define N_REPLICA      4        /* min. number of replicas */
+#define ITER_PT       50        /* evaluations per replica and sweep */
+#define MAX_SWEEP_PT 100
+#define PATIENCE_PT   10        /* sweeps without improvement */
+#define CACHE_RES      1.e-4    /* resolution of the evaluation cache */
+
+/**********************************************************************/
+
+typedef struct sr_pt_replica {
+  struct sr_context *ctx;
+  struct sr_evslot slot;
+  struct sr_evcache *cache;
+} sr_pt_replica;
+
+static FILE *sr_pt_open_log_append(const char *log_file)
+{
+  FILE *log_stream = sr_log_begin(log_file);
+  if (log_stream == NULL) {
+    OPEN_ERROR(log_file);
+  }
+  return log_stream;
+}
+
+/* objective function of a replica: cache, then LEED/R factor evaluation */
+static real sr_pt_eval(real *par, void *data)
+{
+  sr_pt_replica *r = (sr_pt_replica *)data;
+  real rfac;
+
+  if (sr_evcache_get(r->cache, par, &rfac)) return rfac;
+  rfac = sr_evalrf_slot(r->ctx, par, &r->slot);
+  sr_evcache_put(r->cache, par, rfac);
+  return rfac;
+}
+
+static void sr_pt_checkpoint(const real **p, const real *y, int ndim,
+                             void *arg)
+{
+  const struct sr_context *ctx = (const struct sr_context *)arg;
+  if (sr_simplex_write_vertex(ctx->project, p, y, ndim) != 0)
+  {
+#ifdef WARNING
+    fprintf(STDWAR, "* warning (sr_pt): cannot write vertex file\n");
+#endif
+  }
+}
+
+static void sr_pt_init_simplex_or_exit(struct sr_context *ctx,
+                                       sr_simplex_buffers *b,
+                                       real dpos,
+                                       const char *bak_file,
+                                       const char *log_file)
+{
+  FILE *log_stream = sr_pt_open_log_append(log_file);
+
+  if (strncmp(bak_file, "---", 3) == 0)
+  {
+    fprintf(log_stream, "=> Set up vertex:\n");
+    sr_log_end(log_stream);
+
+    if (sr_simplex_build_initial(b, dpos, sr_evalrf_ctx, ctx) != 0) {
+      fprintf(STDERR, "*** error (sr_pt): failed to initialise simplex\n");
+      exit(1);
+    }
+    return;
+  }
+
+  fprintf(log_stream, "=> Read vertex from \"%s\":\n", bak_file);
+  sr_log_end(log_stream);
+
+  if (sr_simplex_read_vertex(b, bak_file) != 0) {
+    fprintf(STDERR, "*** error (sr_pt): failed to read vertex file\n");
+    exit(1);
+  }
+}
+
+static void sr_pt_write_results(const char *log_file, int nfunc, long n_hit,
+                                int nswap, int ndim, const real *best,
+                                real rmin)
+{
+  FILE *log_stream = sr_pt_open_log_append(log_file);
+  fprintf(log_stream, "\n=> No. of function evaluations in sr_ptemper: %3d"
+          " (%ld from cache)\n", nfunc, n_hit);
+  fprintf(log_stream, "=> No. of exchanges between replicas: %d\n", nswap);
+  fprintf(log_stream, "=> Optimum parameter set and function value:\n");
+
+  for (int j_par = 1; j_par <= ndim; j_par++ ) {
+    fprintf(log_stream, "%.6f ", (double)best[j_par]);
+  }
+  fprintf(log_stream, "\nrmin = %.6f\n", (double)rmin);
+  sr_log_end(log_stream);
+}
+
+void sr_pt(struct sr_context *ctx, int ndim, real dpos, int n_jobs,
+           const char *bak_file, const char *log_file)
+{
+  /* -j limits the concurrent evaluations; more workers get more replicas */
+  int n_rep = MAX(n_jobs, N_REPLICA);
+  if (n_rep > SR_PT_MAX_REPLICA) n_rep = SR_PT_MAX_REPLICA;
+
+  sr_simplex_buffers b;
+  real **p[SR_PT_MAX_REPLICA];
+  real *y[SR_PT_MAX_REPLICA];
+  void *data[SR_PT_MAX_REPLICA];
+  sr_pt_replica *rep = (sr_pt_replica *)calloc((size_t)n_rep,
+                                                 sizeof(sr_pt_replica));
+  struct sr_evcache *cache = sr_evcache_new(ndim, CACHE_RES);
+  int failed = (rep == NULL || cache == NULL);
+
+  if (sr_simplex_buffers_alloc(&b, ndim) != 0) failed = 1;
+  for (int k = 0; k < n_rep; k++)
+  {
+    p[k] = sr_alloc_matrix((size_t)ndim + 1, (size_t)ndim);
+    y[k] = sr_alloc_vector((size_t)ndim + 1);
+    if (p[k] == NULL || y[k] == NULL) failed = 1;
+  }
+  if (failed)
+  {
+    fprintf(STDERR, "*** error (sr_pt): allocation failure\n");
+    exit(1);
+  }
+
+  /***********************************************************************
+    PARALLEL TEMPERING (SIMPLEX METHOD)
+  ***********************************************************************/
+
+  FILE *log_stream = sr_pt_open_log_append(log_file);
+  fprintf(log_stream, "=> PARALLEL TEMPERING:\n\n");
+  sr_log_end(log_stream);
+
+  sr_pt_init_simplex_or_exit(ctx, &b, dpos, bak_file, log_file);
+
+  /* all replicas start from the same simplex */
+  for (int k = 0; k < n_rep; k++)
+  {
+    for (int i = 1; i <= ndim + 1; i++)
+    {
+      sr_simplex_copy_point(p[k][i], b.p[i], ndim);
+      y[k][i] = b.y[i];
+    }
+
+    if (sr_evslot_open(&rep[k].slot, ctx->project, k + 1) != 0)
+    {
+      log_stream = sr_pt_open_log_append(log_file);
+      fprintf(log_stream, "*** cannot create scratch directory for "
+              "evaluation (CSEARCH_SCRATCH) ***\n");
+      sr_log_end(log_stream);
+      exit(1);
+    }
+    rep[k].ctx = ctx;
+    rep[k].cache = cache;
+    data[k] = rep + k;
+  }
+
+  /***********************************************************************
+    Enter sweep loop
+  ***********************************************************************/
+
+  sr_ptemper_cfg cfg = {0};
+  cfg.n_replica = n_rep;
+  cfg.n_jobs = MAX(n_jobs, 1);
+  cfg.t_min = END_TEMP;
+  cfg.t_max = START_TEMP;
+  cfg.ftol = R_TOLERANCE;
+  cfg.iter = ITER_PT;
+  cfg.max_sweep = MAX_SWEEP_PT;
+  cfg.patience = PATIENCE_PT;
+  cfg.idum = ctx->idum;
+  cfg.funk = sr_pt_eval;
+  cfg.data = data;
+  cfg.checkpoint = sr_pt_checkpoint;
+  cfg.checkpoint_arg = ctx;
+
+  log_stream = sr_pt_open_log_append(log_file);
+  fprintf(log_stream, "=> Start search (%d replicas, %d at a time, "
+          "T = %.3f ... %.3f, abs. tolerance = %.3e)\n", n_rep, cfg.n_jobs,
+          END_TEMP, START_TEMP, R_TOLERANCE);
+  sr_log_end(log_stream);
+
+  real rmin = 0.0;
+  int nfunc = 0, nswap = 0;
+  if (sr_ptemper(p, y, ndim, b.x, &rmin, &cfg, &nfunc, &nswap) != 0)
+  {
+    fprintf(STDERR, "*** error (sr_pt): parallel tempering failed\n");
+    exit(1);
+  }
+
+  /***********************************************************************
+    Write final results to log file
+  ***********************************************************************/
+
+  long n_hit, n_miss;
+  sr_evcache_stats(cache, &n_hit, &n_miss);
+#ifdef CONTROL
+  fprintf(STDCTR, "(sr_pt): %d function evaluations in sr_ptemper "
+          "(%ld from cache)\n", nfunc, n_hit);
+#endif
+  sr_pt_write_results(log_file, nfunc, n_hit, nswap, ndim, b.x, rmin);
+
+  for (int k = 0; k < n_rep; k++)
+  {
+    sr_evslot_close(&rep[k].slot);
+    sr_free_matrix(p[k]);
+    sr_free_vector(y[k]);
+  }
+  free(rep);
+  sr_evcache_free(cache);
+  sr_simplex_buffers_free(&b);
+
+} /* end of function sr_pt */
+
+/***********************************************************************/
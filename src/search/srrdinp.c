@@ -3,7 +3,7 @@
 
  file contains function:
 
-  int sr_rdinp(char * inp_file)
+  int sr_rdinp(struct sr_context *ctx, char * inp_file)
 
  Read input atom positions and convert them to parameter strings.
 
@@ -20,6 +20,10 @@ WB/29.09.98 - change BUFSZ and some CONTROLS ...
               set for allocation sr_atoms : n_atoms+2 
 GH/29.09.00 - calculate dr2 for dmt input in function leed_inp_debye_temp
 GH/31.03.03 - Added theta_0 and phi_0 for the angle search, use i_par_theta/phi
+LD/19.10.26 - results are stored in a search context (ctx) instead of the
+              globals sr_atoms, sr_search and sr_project; the input
+              buffers are local (several contexts may be read at the
+              same time).
 
 ***********************************************************************/
 
@@ -69,15 +73,6 @@ GH/31.03.03 - Added theta_0 and phi_0 for the angle search, use i_par_theta/phi
 
 /**********************************************************************/
 
-extern struct sratom_str *sr_atoms;
-extern struct search_str *sr_search;
-extern char *sr_project;
-
-/* input buffers */
-char buf[BUFSZ]; 
-char atom_name[STRSZ];
-char whatnext[STRSZ];
-
 static const char *sr_rdinp_basename(const char *path)
 {
   const char *base = path;
@@ -89,6 +84,8 @@ static const char *sr_rdinp_basename(const char *path)
 }
 
 int sr_rdinp(
+    struct sr_context *ctx,   /* search context (atoms, search parameters and
+                                 project name are set) */
     const char *inp_file      /* input file containing start geometry and 
                                  control parameters for SEARCH. */
 )
@@ -97,6 +94,8 @@ int sr_rdinp(
  Read input for search from input file (and *.bul)
  
 INPUT:
+  struct sr_context *ctx - (output) search context; ctx->project must
+                 point to a buffer of STRSZ characters.
   char *inp_file - (input) input file containing start geometry and control
                  parameters for SEARCH.
 
@@ -145,7 +144,7 @@ DESIGN:
 
 NOTE:
 
- sr_atoms and sr_search will be allocated in this function.
+ ctx->atoms and ctx->search will be allocated in this function.
 
 FUNCTION CALLS:
 
@@ -158,6 +157,11 @@ RETURN VALUES:
 
 {
 
+/* input buffers */
+char buf[BUFSZ];
+char atom_name[STRSZ];
+char whatnext[STRSZ];
+
 FILE *inp_stream;
 
 int iaux;                     /* counter, dummy  variables */
@@ -203,12 +207,12 @@ struct type_str *types;      /* this vector of structure type_str is
  }
 
  for (i_str = 0; i_str < (int)prefix_len; i_str++) {
-   sr_project[i_str] = base[i_str];
+   ctx->project[i_str] = base[i_str];
  }
- sr_project[i_str] = '\0';
+ ctx->project[i_str] = '\0';
 
  #ifdef CONTROL
-   fprintf(STDCTR,"(sr_rdinp): project name = \"%s\"\n", sr_project);
+   fprintf(STDCTR,"(sr_rdinp): project name = \"%s\"\n", ctx->project);
  #endif
 
 
@@ -217,8 +221,8 @@ struct type_str *types;      /* this vector of structure type_str is
   - allocate atoms (1 unit) and type (2 units)
 ********************************************************************/
 
- sr_atoms = (struct sratom_str *)malloc( sizeof(struct sratom_str) );
- if( sr_atoms == NULL)
+ ctx->atoms = (struct sratom_str *)malloc( sizeof(struct sratom_str) );
+ if( ctx->atoms == NULL)
  { ALLERR("sr_atoms"); }
  n_atoms = 0;
 
@@ -229,23 +233,23 @@ struct type_str *types;      /* this vector of structure type_str is
  types->r_min = F_END_OF_LIST;
  n_types = 0;
 
- sr_search = (struct search_str *)malloc( sizeof(struct search_str) );
- if( sr_search == NULL)
+ ctx->search = (struct search_str *)malloc( sizeof(struct search_str) );
+ if( ctx->search == NULL)
  { ALLERR("sr_search"); }
 
- for(iaux = 0; iaux < (int)(sizeof(sr_search->b_lat) / sizeof(sr_search->b_lat[0])); iaux ++)
-  sr_search->b_lat[iaux] = 0.;
+ for(iaux = 0; iaux < (int)(sizeof(ctx->search->b_lat) / sizeof(ctx->search->b_lat[0])); iaux ++)
+  ctx->search->b_lat[iaux] = 0.;
 
- sr_search->sr_angle = 0; /* added for the angle search */
- sr_search->z_only = 0;
- sr_search->rot_deg = 1;
- sr_search->rot_axis[1] = sr_search->rot_axis[2] = 0.;
+ ctx->search->sr_angle = 0; /* added for the angle search */
+ ctx->search->z_only = 0;
+ ctx->search->rot_deg = 1;
+ ctx->search->rot_axis[1] = ctx->search->rot_axis[2] = 0.;
 
- sr_search->mir_point[1] = sr_search->mir_point[2] = 0.;
- sr_search->mir_dir[1] = sr_search->mir_dir[2] = 0.;
+ ctx->search->mir_point[1] = ctx->search->mir_point[2] = 0.;
+ ctx->search->mir_dir[1] = ctx->search->mir_dir[2] = 0.;
 
- (void)snprintf(sr_search->rf_type, sizeof(sr_search->rf_type), "%s", RFAC_TYP);
- sr_search->rf_range = RFAC_SHIFT_RANGE;
+ (void)snprintf(ctx->search->rf_type, sizeof(ctx->search->rf_type), "%s", RFAC_TYP);
+ ctx->search->rf_range = RFAC_SHIFT_RANGE;
 
  temp = DEF_TEMP;
  for(iaux = 0; iaux < (int)(sizeof(m_super) / sizeof(m_super[0])); iaux ++)
@@ -262,7 +266,7 @@ struct type_str *types;      /* this vector of structure type_str is
   First try to read a1/a2, b1/b2, m1/m2 from <sr_project>.bul
 ********************************************************************/
 
- sprintf(buf,"%s.bul", sr_project);
+ sprintf(buf,"%s.bul", ctx->project);
  #ifdef CONTROL_X
    fprintf(STDERR,"(sr_rdinp): open file \"%s\" \n", buf);
  #endif
@@ -349,11 +353,11 @@ b1 b2:  (*.bul)
    {
      #ifdef REAL_IS_DOUBLE
      if( sscanf(buf+i_str+3," %lf %lf",
-         (sr_search->b_lat)+1, (sr_search->b_lat)+3 ) < 2)
+         (ctx->search->b_lat)+1, (ctx->search->b_lat)+3 ) < 2)
      #endif
      #ifdef REAL_IS_FLOAT
      if( sscanf(buf+i_str+3," %f %f",
-         (sr_search->b_lat)+1, (sr_search->b_lat)+3 ) < 2)
+         (ctx->search->b_lat)+1, (ctx->search->b_lat)+3 ) < 2)
      #endif
      {
      #ifdef ERROR
@@ -372,11 +376,11 @@ b1 b2:  (*.bul)
    {
      #ifdef REAL_IS_DOUBLE
        if( sscanf(buf+i_str+3," %lf %lf",
-           (sr_search->b_lat)+2, (sr_search->b_lat)+4 ) < 2)
+           (ctx->search->b_lat)+2, (ctx->search->b_lat)+4 ) < 2)
      #endif
      #ifdef REAL_IS_FLOAT
        if( sscanf(buf+i_str+3," %f %f",
-           (sr_search->b_lat)+2, (sr_search->b_lat)+4 ) < 2)
+           (ctx->search->b_lat)+2, (ctx->search->b_lat)+4 ) < 2)
      #endif
        {
      #ifdef ERROR
@@ -432,7 +436,7 @@ ip:  (*.bul)
      #ifdef REAL_IS_FLOAT
        iaux = sscanf(buf+i_str+3 ," %f",
      #endif
-            &(sr_search->phi_0) );
+            &(ctx->search->phi_0) );
 
    } /* case ip */
 
@@ -450,7 +454,7 @@ it:  (*.bul)
 #ifdef REAL_IS_FLOAT
      iaux = sscanf(buf+i_str+3 ," %f",
 #endif
-            &(sr_search->theta_0) );
+            &(ctx->search->theta_0) );
 
    } /* case it */
 
@@ -546,11 +550,11 @@ b1 b2:
    {
      #ifdef REAL_IS_DOUBLE
        if( sscanf(buf+i_str+3," %lf %lf",
-           (sr_search->b_lat)+1, (sr_search->b_lat)+3 ) < 2)
+           (ctx->search->b_lat)+1, (ctx->search->b_lat)+3 ) < 2)
      #endif
      #ifdef REAL_IS_FLOAT
        if( sscanf(buf+i_str+3," %f %f",
-           (sr_search->b_lat)+1, (sr_search->b_lat)+3 ) < 2)
+           (ctx->search->b_lat)+1, (ctx->search->b_lat)+3 ) < 2)
       #endif
        {
       #ifdef ERROR
@@ -569,11 +573,11 @@ b1 b2:
    {
      #ifdef REAL_IS_DOUBLE
        if( sscanf(buf+i_str+3," %lf %lf",
-           (sr_search->b_lat)+2, (sr_search->b_lat)+4 ) < 2)
+           (ctx->search->b_lat)+2, (ctx->search->b_lat)+4 ) < 2)
      #endif
      #ifdef REAL_IS_FLOAT
        if( sscanf(buf+i_str+3," %f %f",
-           (sr_search->b_lat)+2, (sr_search->b_lat)+4 ) < 2)
+           (ctx->search->b_lat)+2, (ctx->search->b_lat)+4 ) < 2)
      #endif
        {
      #ifdef ERROR
@@ -622,20 +626,20 @@ po:
    {
 
      struct sratom_str *new_atoms =
-       (struct sratom_str *)realloc(sr_atoms, (n_atoms + 2) * sizeof(struct sratom_str));
+       (struct sratom_str *)realloc(ctx->atoms, (n_atoms + 2) * sizeof(struct sratom_str));
      if (new_atoms == NULL)
      {
        ALLERR("sr_atoms");
      }
-     sr_atoms = new_atoms;
+     ctx->atoms = new_atoms;
 
    /* preset xyz_par with NULL ref and nref with I_END_OF_LIST */
-     (sr_atoms+n_atoms)->x_par = NULL;
-     (sr_atoms+n_atoms)->y_par = NULL;
-     (sr_atoms+n_atoms)->z_par = NULL;
+     (ctx->atoms+n_atoms)->x_par = NULL;
+     (ctx->atoms+n_atoms)->y_par = NULL;
+     (ctx->atoms+n_atoms)->z_par = NULL;
 
-     (sr_atoms+n_atoms)->ref  = I_END_OF_LIST;
-     (sr_atoms+n_atoms)->nref = I_END_OF_LIST;
+     (ctx->atoms+n_atoms)->ref  = I_END_OF_LIST;
+     (ctx->atoms+n_atoms)->nref = I_END_OF_LIST;
 
      #ifdef REAL_IS_DOUBLE
        iaux = sscanf(buf+i_str+3 ," %s %lf %lf %lf %s %lf %lf %lf",
@@ -643,10 +647,10 @@ po:
      #ifdef REAL_IS_FLOAT
        iaux = sscanf(buf+i_str+3 ," %s %f %f %f %s %f %f %f",
      #endif
-            (sr_atoms+n_atoms)->name,
-            &((sr_atoms+n_atoms)->x),
-            &((sr_atoms+n_atoms)->y),
-            &((sr_atoms+n_atoms)->z),
+            (ctx->atoms+n_atoms)->name,
+            &((ctx->atoms+n_atoms)->x),
+            &((ctx->atoms+n_atoms)->y),
+            &((ctx->atoms+n_atoms)->z),
             whatnext, 
             vaux+1, vaux+2, vaux+3);
   
@@ -667,21 +671,21 @@ po:
  **********************************/
 
      if (iaux <= 5) 
-       (sr_atoms+n_atoms)->dr = 0.;
+       (ctx->atoms+n_atoms)->dr = 0.;
      else
      {
 
    /* input of the isotropic root mean square displacement */
        if( ( !strncmp(whatnext, "dr1", 3) ) && (iaux >= 6) )
        {
-         (sr_atoms+n_atoms)->dr = vaux[1];
+         (ctx->atoms+n_atoms)->dr = vaux[1];
        }
 
 
    /* input of root mean square displacements for each direction */
        else if( ( !strncmp(whatnext, "dr3", 3) ) && (iaux >= 8) )
        {
-         (sr_atoms+n_atoms)->dr = 
+         (ctx->atoms+n_atoms)->dr = 
            R_sqrt( SQUARE(vaux[1]) + SQUARE(vaux[2]) + SQUARE(vaux[3]) );
        }
 
@@ -710,11 +714,11 @@ po:
          }
 
          vaux[0] = leed_inp_debye_temp(vaux[1], vaux[2], temp);
-         (sr_atoms+n_atoms)->dr = R_sqrt(vaux[0]) * BOHR;
+         (ctx->atoms+n_atoms)->dr = R_sqrt(vaux[0]) * BOHR;
          
          #ifdef CONTROL
            fprintf(STDCTR, "(sr_rdinp): temp = %.1f dr = %.3f\n",
-           temp, (sr_atoms+n_atoms)->dr);
+           temp, (ctx->atoms+n_atoms)->dr);
          #endif
        }
        else
@@ -726,7 +730,7 @@ po:
              fprintf(STDWAR," %.3f", vaux[i_str]);
            fprintf(STDWAR,"\n");
          #endif
-         (sr_atoms+n_atoms)->dr = 0.;
+         (ctx->atoms+n_atoms)->dr = 0.;
        }
      }
 
@@ -735,9 +739,9 @@ po:
   */
      for(i_types = 0; i_types < n_types; i_types ++)
      {
-       if(strcmp( (types+i_types)->name, (sr_atoms+n_atoms)->name ) == 0)
+       if(strcmp( (types+i_types)->name, (ctx->atoms+n_atoms)->name ) == 0)
        { 
-         (sr_atoms+n_atoms)->type = i_types;
+         (ctx->atoms+n_atoms)->type = i_types;
          break; 
        }
      }
@@ -755,10 +759,10 @@ po:
        }
        types = new_types;
 
-       strcpy( (types+i_types)->name, (sr_atoms+n_atoms)->name);
+       strcpy( (types+i_types)->name, (ctx->atoms+n_atoms)->name);
        (types+i_types)->r_min = F_END_OF_LIST;
 
-       (sr_atoms+n_atoms)->type = i_types;
+       (ctx->atoms+n_atoms)->type = i_types;
        n_types ++;
        (types + n_types)->name[0] = '\0';
        (types + n_types)->r_min = F_END_OF_LIST;
@@ -787,7 +791,7 @@ ip:
      #ifdef REAL_IS_FLOAT
        iaux = sscanf(buf+i_str+3 ," %f",
      #endif
-            &(sr_search->phi_0) );
+            &(ctx->search->phi_0) );
 
    } /* case ip */
 
@@ -806,7 +810,7 @@ it:
      #ifdef REAL_IS_FLOAT
        iaux = sscanf(buf+i_str+3 ," %f",
      #endif
-            &(sr_search->theta_0) );
+            &(ctx->search->theta_0) );
 
    } /* case it */
 /*
@@ -829,7 +833,7 @@ rfr:
      #ifdef REAL_IS_FLOAT
        iaux = sscanf(buf+i_str+4 ,"%f",
      #endif
-                   &(sr_search->rf_range) );
+                   &(ctx->search->rf_range) );
    }
 
 /***********************************
@@ -843,7 +847,7 @@ rft:
    the array boundaries (16)
 */
      iaux = sscanf(buf+i_str+4 ,"%s", whatnext );
-     (void)snprintf(sr_search->rf_type, sizeof(sr_search->rf_type), "%s", whatnext);
+     (void)snprintf(ctx->search->rf_type, sizeof(ctx->search->rf_type), "%s", whatnext);
    }
 
 /***********************************
@@ -916,8 +920,8 @@ sm:
        #ifdef REAL_IS_FLOAT
          iaux = sscanf(buf+i_str+3 ," %f %f %f %f",
        #endif
-                     (sr_search->mir_point)+1, (sr_search->mir_point)+2,
-                     (sr_search->mir_dir)+1,   (sr_search->mir_dir)+2   );
+                     (ctx->search->mir_point)+1, (ctx->search->mir_point)+2,
+                     (ctx->search->mir_dir)+1,   (ctx->search->mir_dir)+2   );
      }
    } /* sm */
 
@@ -942,9 +946,9 @@ sr:
        #ifdef REAL_IS_FLOAT
          iaux = sscanf(buf+i_str+3 ," %d %f %f",
        #endif
-                     &(sr_search->rot_deg),
-                     (sr_search->rot_axis)+1, 
-                     (sr_search->rot_axis)+2);
+                     &(ctx->search->rot_deg),
+                     (ctx->search->rot_axis)+1, 
+                     (ctx->search->rot_axis)+2);
 
      }
    } /* sr */
@@ -952,7 +956,7 @@ sr:
 /***********************************
 sz:
   z search only, xyz search
-  set sr_search->z_only to 1 if no argument,
+  set ctx->search->z_only to 1 if no argument,
   to the argument value otherwise
 ***********************************/
    else if( !strncasecmp(buf+i_str,"sz:",3) )
@@ -966,11 +970,11 @@ sz:
      }
      else
      {
-       iaux = sscanf(buf+i_str+3 ," %d", &(sr_search->z_only) );
+       iaux = sscanf(buf+i_str+3 ," %d", &(ctx->search->z_only) );
        if(iaux < 1) 
-         sr_search->z_only = 1;
+         ctx->search->z_only = 1;
        #ifdef CONTROL
-         if (sr_search->z_only) 
+         if (ctx->search->z_only) 
            fprintf(STDCTR, "(sr_rdinp):"
                    " Only variation of vertical parameters\n");
        #endif
@@ -984,10 +988,10 @@ sa:
 ***********************************/
    else if( !strncasecmp(buf+i_str,"sa:",3) )
    {
-       iaux = sscanf(buf+i_str+3 ," %d", &(sr_search->sr_angle) );
-       if(iaux < 1) sr_search->sr_angle = 1;
+       iaux = sscanf(buf+i_str+3 ," %d", &(ctx->search->sr_angle) );
+       if(iaux < 1) ctx->search->sr_angle = 1;
        #ifdef CONTROL
-         if (sr_search->sr_angle) 
+         if (ctx->search->sr_angle) 
            fprintf(STDCTR, "(sr_rdinp): Angle search is on\n");
        #endif
    } /* sa */
@@ -1002,13 +1006,13 @@ spn:
    else if( !strncasecmp(buf+i_str,"spn:",4) )
    {
      sscanf(buf+i_str+4 ," %d", &n_par );
-     sr_search->n_par = n_par;
-     sr_search->z_only = 0;
+     ctx->search->n_par = n_par;
+     ctx->search->z_only = 0;
      #ifdef CONTROL_X
        fprintf(STDCTR, "(sr_rdinp): %d parameters specified\n", 
-               sr_search->n_par);
+               ctx->search->n_par);
      #endif
-     fprintf(STDOUT,"spn(%d) ", sr_search->n_par);
+     fprintf(STDOUT,"spn(%d) ", ctx->search->n_par);
    } /* spn */
 
 /***********************************
@@ -1082,22 +1086,22 @@ spp:
 /* copy paux into respective parameter list */
        if(i_c == 'x')
        {
-         if((sr_atoms+i_atoms)->x_par != NULL) free((sr_atoms+i_atoms)->x_par);
-         (sr_atoms+i_atoms)->x_par = paux;
+         if((ctx->atoms+i_atoms)->x_par != NULL) free((ctx->atoms+i_atoms)->x_par);
+         (ctx->atoms+i_atoms)->x_par = paux;
          fprintf(STDOUT,"spp(%dx) ", i_atoms);
        }
 
        if(i_c == 'y')
        {
-         if((sr_atoms+i_atoms)->y_par != NULL) free((sr_atoms+i_atoms)->y_par);
-         (sr_atoms+i_atoms)->y_par = paux;
+         if((ctx->atoms+i_atoms)->y_par != NULL) free((ctx->atoms+i_atoms)->y_par);
+         (ctx->atoms+i_atoms)->y_par = paux;
          fprintf(STDOUT,"spp(%dy) ", i_atoms);
        }
 
        if(i_c == 'z')
        {
-         if((sr_atoms+i_atoms)->z_par != NULL) free((sr_atoms+i_atoms)->z_par);
-         (sr_atoms+i_atoms)->z_par = paux;
+         if((ctx->atoms+i_atoms)->z_par != NULL) free((ctx->atoms+i_atoms)->z_par);
+         (ctx->atoms+i_atoms)->z_par = paux;
          fprintf(STDOUT,"spp(%dz) ", i_atoms);
        }
      } /* else n_par != 0 */
@@ -1116,7 +1120,7 @@ zr:
      #ifdef REAL_IS_FLOAT
        iaux = sscanf(buf+i_str+3 ," %f %f",
      #endif
-            &(sr_search->z_min), &(sr_search->z_max) );
+            &(ctx->search->z_min), &(ctx->search->z_max) );
 
    } /* case zr */
 
@@ -1151,14 +1155,14 @@ zr:
 
  (types+n_types)->name[0] = '\0';
  (types+n_types)->r_min = F_END_OF_LIST;
- (sr_atoms+n_atoms)->type   = I_END_OF_LIST;
- (sr_atoms+n_atoms)->name[0] = '\0';
- (sr_atoms+n_atoms)->x_par = NULL;
- (sr_atoms+n_atoms)->y_par = NULL;
- (sr_atoms+n_atoms)->z_par = NULL;
- (sr_atoms+n_atoms)->dr_par = NULL;
- (sr_atoms+n_atoms)->ref = I_END_OF_LIST;
- (sr_atoms+n_atoms)->nref = I_END_OF_LIST;
+ (ctx->atoms+n_atoms)->type   = I_END_OF_LIST;
+ (ctx->atoms+n_atoms)->name[0] = '\0';
+ (ctx->atoms+n_atoms)->x_par = NULL;
+ (ctx->atoms+n_atoms)->y_par = NULL;
+ (ctx->atoms+n_atoms)->z_par = NULL;
+ (ctx->atoms+n_atoms)->dr_par = NULL;
+ (ctx->atoms+n_atoms)->ref = I_END_OF_LIST;
+ (ctx->atoms+n_atoms)->nref = I_END_OF_LIST;
 
 /************************************************************************
 *************************************************************************
@@ -1172,9 +1176,9 @@ zr:
    fprintf(STDCTR, "(sr_rdinp): start processing input data:\n");
    fprintf(STDCTR, "\tNo of atoms = %d\n", n_atoms);
    fprintf(STDCTR, "\tz_min = %.3f, z_max = %.3f\n", 
-           sr_search->z_min, sr_search->z_max);
+           ctx->search->z_min, ctx->search->z_max);
    fprintf(STDCTR, "\trf_type = \"%s\", rf_range = %.2f\n", 
-           sr_search->rf_type, sr_search->rf_range);
+           ctx->search->rf_type, ctx->search->rf_range);
  #endif
 
  if(n_atoms == 0)
@@ -1196,7 +1200,7 @@ zr:
 
  for(i_atoms = 0; i_atoms < n_atoms; i_atoms ++)
  {
-   i_types = (sr_atoms+i_atoms)->type;
+   i_types = (ctx->atoms+i_atoms)->type;
    if( IS_EQUAL_REAL((types+i_types)->r_min, F_END_OF_LIST) )
    {
      #ifdef WARNING
@@ -1206,7 +1210,7 @@ zr:
      (types+i_types)->r_min = 0.;
    }
    else
-     (sr_atoms+i_atoms)->r_min = (types+i_types)->r_min;
+     (ctx->atoms+i_atoms)->r_min = (types+i_types)->r_min;
    
  }
 
@@ -1219,7 +1223,7 @@ zr:
   Determine max. x/y search range from b_lat.
 *************************************************************************/
 
- if( R_hypot(sr_search->b_lat[1], sr_search->b_lat[3]) < GEO_TOLERANCE)
+ if( R_hypot(ctx->search->b_lat[1], ctx->search->b_lat[3]) < GEO_TOLERANCE)
  {
 
 /*
@@ -1240,36 +1244,36 @@ zr:
      #endif
    }
   
-   sr_search->b_lat[1] = m_super[1] * a1[1] + m_super[2] * a2[1];
-   sr_search->b_lat[3] = m_super[1] * a1[2] + m_super[2] * a2[2];
-   sr_search->b_lat[2] = m_super[3] * a1[1] + m_super[4] * a2[1];
-   sr_search->b_lat[4] = m_super[3] * a1[2] + m_super[4] * a2[2];
+   ctx->search->b_lat[1] = m_super[1] * a1[1] + m_super[2] * a2[1];
+   ctx->search->b_lat[3] = m_super[1] * a1[2] + m_super[2] * a2[2];
+   ctx->search->b_lat[2] = m_super[3] * a1[1] + m_super[4] * a2[1];
+   ctx->search->b_lat[4] = m_super[3] * a1[2] + m_super[4] * a2[2];
  }  /* no b defined */
 
  #ifdef CONTROL
    fprintf(STDCTR, "(sr_rdinp): b1 = (%6.3f,%6.3f)\n",
-                 sr_search->b_lat[1], sr_search->b_lat[3]);
+                 ctx->search->b_lat[1], ctx->search->b_lat[3]);
    fprintf(STDCTR, "(sr_rdinp): b2 = (%6.3f,%6.3f)\n",
-                 sr_search->b_lat[2], sr_search->b_lat[4]);
+                 ctx->search->b_lat[2], ctx->search->b_lat[4]);
  #endif
 
- sr_search->x_max =
-   (fabs(sr_search->b_lat[1]) > fabs(sr_search->b_lat[2]))
-     ? fabs(sr_search->b_lat[1])
-     : fabs(sr_search->b_lat[2]);
- sr_search->x_min = - sr_search->x_max;
+ ctx->search->x_max =
+   (fabs(ctx->search->b_lat[1]) > fabs(ctx->search->b_lat[2]))
+     ? fabs(ctx->search->b_lat[1])
+     : fabs(ctx->search->b_lat[2]);
+ ctx->search->x_min = - ctx->search->x_max;
 
- sr_search->y_max =
-   (fabs(sr_search->b_lat[3]) > fabs(sr_search->b_lat[4]))
-     ? fabs(sr_search->b_lat[3])
-     : fabs(sr_search->b_lat[4]);
- sr_search->y_min = - sr_search->y_max;
+ ctx->search->y_max =
+   (fabs(ctx->search->b_lat[3]) > fabs(ctx->search->b_lat[4]))
+     ? fabs(ctx->search->b_lat[3])
+     : fabs(ctx->search->b_lat[4]);
+ ctx->search->y_min = - ctx->search->y_max;
 
  #ifdef CONTROL
    fprintf(STDCTR, "(sr_rdinp): x_min/max = %6.3f/%6.3f\n",
-                 sr_search->x_min, sr_search->x_max);
+                 ctx->search->x_min, ctx->search->x_max);
    fprintf(STDCTR, "(sr_rdinp): y_min/max = %6.3f/%6.3f\n",
-                 sr_search->y_min, sr_search->y_max);
+                 ctx->search->y_min, ctx->search->y_max);
  #endif
 
 /************************************************************************
@@ -1285,9 +1289,9 @@ zr:
  {
    #ifdef CONTROL
      fprintf(STDCTR, "(sr_rdinp): rot_deg = %d, axis = (%6.3f,%6.3f)\n",
-           sr_search->rot_deg, sr_search->rot_axis[1], sr_search->rot_axis[2]);
+           ctx->search->rot_deg, ctx->search->rot_axis[1], ctx->search->rot_axis[2]);
    #endif
-   n_par = sr_ckrot(sr_atoms, sr_search);
+   n_par = sr_ckrot(ctx->atoms, ctx->search);
  }
  else
  {
@@ -1300,14 +1304,14 @@ zr:
        fprintf(STDCTR, "(sr_rdinp): i_atoms = %d", i_atoms);
      #endif
      fprintf(STDCTR, "x\n");
-     if( (sr_atoms+i_atoms)->x_par == NULL )
-       (sr_atoms+i_atoms)->x_par = (real *)calloc( (n_par +1), sizeof(real) );
+     if( (ctx->atoms+i_atoms)->x_par == NULL )
+       (ctx->atoms+i_atoms)->x_par = (real *)calloc( (n_par +1), sizeof(real) );
      fprintf(STDCTR, "y\n");
-     if( (sr_atoms+i_atoms)->y_par == NULL )
-       (sr_atoms+i_atoms)->y_par = (real *)calloc( (n_par +1), sizeof(real) );
+     if( (ctx->atoms+i_atoms)->y_par == NULL )
+       (ctx->atoms+i_atoms)->y_par = (real *)calloc( (n_par +1), sizeof(real) );
      fprintf(STDCTR, "z\n");
-     if( (sr_atoms+i_atoms)->z_par == NULL )
-       (sr_atoms+i_atoms)->z_par = (real *)calloc( (n_par +1), sizeof(real) );
+     if( (ctx->atoms+i_atoms)->z_par == NULL )
+       (ctx->atoms+i_atoms)->z_par = (real *)calloc( (n_par +1), sizeof(real) );
    }
  }
 
@@ -1316,29 +1320,29 @@ zr:
    for(i_atoms = 0; i_atoms < n_atoms; i_atoms ++)
    {
      fprintf(STDCTR,"\n%d \"%s\" (%6.3f, %6.3f, %6.3f) ref: %d nref: %d",
-             i_atoms, (sr_atoms + i_atoms)->name,
-             (sr_atoms + i_atoms)->x, (sr_atoms + i_atoms)->y, 
-             (sr_atoms + i_atoms)->z, 
-             (sr_atoms + i_atoms)->ref, (sr_atoms + i_atoms)->nref);
-     fprintf(STDCTR,"\n\tr_min: %6.3f", (sr_atoms + i_atoms)->r_min);
+             i_atoms, (ctx->atoms + i_atoms)->name,
+             (ctx->atoms + i_atoms)->x, (ctx->atoms + i_atoms)->y, 
+             (ctx->atoms + i_atoms)->z, 
+             (ctx->atoms + i_atoms)->ref, (ctx->atoms + i_atoms)->nref);
+     fprintf(STDCTR,"\n\tr_min: %6.3f", (ctx->atoms + i_atoms)->r_min);
 
-     if(!sr_search->z_only)
+     if(!ctx->search->z_only)
      {
        fprintf(STDCTR,"\n\tx_par: ");
        for(i_par = 1; i_par <= n_par; i_par ++)
        { 
-         fprintf(STDCTR,"%6.3f, ", (sr_atoms+i_atoms)->x_par[i_par]); 
+         fprintf(STDCTR,"%6.3f, ", (ctx->atoms+i_atoms)->x_par[i_par]); 
        }
        fprintf(STDCTR,"\n\ty_par: ");
        for(i_par = 1; i_par <= n_par; i_par ++)
        { 
-         fprintf(STDCTR,"%6.3f, ", (sr_atoms+i_atoms)->y_par[i_par]); 
+         fprintf(STDCTR,"%6.3f, ", (ctx->atoms+i_atoms)->y_par[i_par]); 
        }
      }
      fprintf(STDCTR,"\n\tz_par: ");
      for(i_par = 1; i_par <= n_par; i_par ++)
      {
-       fprintf(STDCTR,"%6.3f, ", (sr_atoms+i_atoms)->z_par[i_par]); 
+       fprintf(STDCTR,"%6.3f, ", (ctx->atoms+i_atoms)->z_par[i_par]); 
      }
      fprintf(STDCTR,"\n");
    } 
@@ -1347,19 +1351,19 @@ zr:
  #endif
 
 /* increment n_par by 2 for angle search */
- if(sr_search->sr_angle)
+ if(ctx->search->sr_angle)
  {
-   sr_search->n_par_geo   = sr_search->n_par;
-   sr_search->i_par_theta = sr_search->n_par_geo+1;
-   sr_search->i_par_phi   = sr_search->n_par_geo+2;
-   sr_search->n_par += 2;
+   ctx->search->n_par_geo   = ctx->search->n_par;
+   ctx->search->i_par_theta = ctx->search->n_par_geo+1;
+   ctx->search->i_par_phi   = ctx->search->n_par_geo+2;
+   ctx->search->n_par += 2;
    n_par += 2;
  }
  else
  {
-   sr_search->n_par_geo = sr_search->n_par;
-   sr_search->i_par_phi   = 0;
-   sr_search->i_par_theta = 0;
+   ctx->search->n_par_geo = ctx->search->n_par;
+   ctx->search->i_par_phi   = 0;
+   ctx->search->i_par_theta = 0;
  }
 
  return(n_par);
@@ -2,7 +2,7 @@
 GH/29.12.95
  File contains:
 
-  sr_sa(int ndim, char *bak_file, char *log_file)
+  sr_sa(struct sr_context *ctx, int ndim, char *bak_file, char *log_file)
  Perform a search according to the SIMULATED ANNEALING (SIMPLEX) METHOD
  Driver for routine sr_amebsa
 
@@ -10,6 +10,12 @@ Changes
 GH/20.09.95 - Creation (copy from srsx.c)
 GH/29.12.95 - insert dpos in parameter list: initial displacement
               can be specified through a command line option.
+LD/19.10.26 - evaluate in the search context ctx; the seed sa_idum is
+              a member of the context.
+LD/19.10.26 - surrogate pre-screening of trial points (ctx->surrogate,
+              see srsg.c).
+LD/19.10.26 - the log file is written through sr_log_begin/sr_log_end
+              (sr_log.c).
 
 ***********************************************************************/
 
@@ -38,18 +44,18 @@ GH/29.12.95 - insert dpos in parameter list: initial displacement
 
 /**********************************************************************/
 
-long sa_idum = -1;                /* seed for random number generator */
-
 static FILE *sr_sa_open_log_append(const char *log_file)
 {
-  FILE *log_stream = fopen(log_file, "a");
+  FILE *log_stream = sr_log_begin(log_file);
   if (log_stream == NULL) {
     OPEN_ERROR(log_file);
   }
   return log_stream;
 }
 
-static void sr_sa_init_simplex_or_exit(sr_simplex_buffers *b,
+static void sr_sa_init_simplex_or_exit(sr_eval_func funk, void *data,
+                                       struct sr_sgscreen *sg,
+                                       sr_simplex_buffers *b,
                                        real dpos,
                                        const char *bak_file,
                                        const char *log_file)
@@ -59,9 +65,9 @@ static void sr_sa_init_simplex_or_exit(sr_simplex_buffers *b,
   if (strncmp(bak_file, "---", 3) == 0)
   {
     fprintf(log_stream, "=> Set up vertex:\n");
-    fclose(log_stream);
+    sr_log_end(log_stream);
 
-    if (sr_simplex_build_initial(b, dpos, sr_evalrf) != 0) {
+    if (sr_simplex_build_initial(b, dpos, funk, data) != 0) {
       fprintf(STDERR, "*** error (sr_sa): failed to initialise simplex\n");
       exit(1);
     }
@@ -69,15 +75,21 @@ static void sr_sa_init_simplex_or_exit(sr_simplex_buffers *b,
   }
 
   fprintf(log_stream, "=> Read vertex from \"%s\":\n", bak_file);
-  fclose(log_stream);
+  sr_log_end(log_stream);
 
   if (sr_simplex_read_vertex(b, bak_file) != 0) {
     fprintf(STDERR, "*** error (sr_sa): failed to read vertex file\n");
     exit(1);
   }
+  if (sg != NULL)
+    for (int i_par = 1; i_par <= b->ndim + 1; i_par++)
+      sr_sg_add(sg, b->p[i_par], b->y[i_par]);
 }
 
-static int sr_sa_run_temperature_loop(sr_simplex_buffers *b, int ndim, real *out_rmin)
+static int sr_sa_run_temperature_loop(struct sr_context *ctx,
+                                      sr_eval_func funk, void *data,
+                                      sr_simplex_buffers *b, int ndim,
+                                      real *out_rmin)
 {
   real rmin = 100.;
   int nfunc = 0;
@@ -88,9 +100,11 @@ static int sr_sa_run_temperature_loop(sr_simplex_buffers *b, int ndim, real *out
     fprintf(STDCTR, "(sr_sa): temperature = %.4f\n", temp);
 #endif
     int budget = MAX_ITER_SA;
-    sr_amebsa_cfg cfg;
+    sr_amebsa_cfg cfg = {0};
     cfg.ftol = temp;
-    cfg.funk = sr_evalrf;
+    cfg.funk_data = funk;
+    cfg.data = data;
+    cfg.idum = &ctx->idum;
     cfg.temptr = temp;
     (void)sr_amebsa(b->p, b->y, ndim, b->x, &rmin, &cfg, &budget);
     nfunc += budget;
@@ -110,12 +124,17 @@ static void sr_sa_write_results(const char *log_file, int nfunc, int ndim, const
     fprintf(log_stream, "%.6f ", (double)best[j_par]);
   }
   fprintf(log_stream, "\nrmin = %.6f\n", (double)rmin);
-  fclose(log_stream);
+  sr_log_end(log_stream);
 }
 
-void sr_sa(int ndim, real dpos, const char *bak_file, const char *log_file)
+void sr_sa(struct sr_context *ctx, int ndim, real dpos, const char *bak_file,
+           const char *log_file)
 {
   sr_simplex_buffers b;
+  struct sr_sgscreen sg;
+  sr_eval_func funk = sr_evalrf_ctx;
+  void *data = ctx;
+
   if (sr_simplex_buffers_alloc(&b, ndim) != 0)
   {
     sr_simplex_buffers_free(&b);
@@ -123,15 +142,28 @@ void sr_sa(int ndim, real dpos, const char *bak_file, const char *log_file)
     exit(1);
   }
 
+  if (ctx->surrogate)
+  {
+    if (sr_sg_init(&sg, ctx, ndim, dpos, log_file) != 0)
+    {
+      sr_simplex_buffers_free(&b);
+      fprintf(STDERR, "*** error (sr_sa): allocation failure\n");
+      exit(1);
+    }
+    funk = sr_sg_eval;
+    data = &sg;
+  }
+
   /***********************************************************************
     SIMULATED ANNEALING (SIMPLEX METHOD)
   ***********************************************************************/
 
   FILE *log_stream = sr_sa_open_log_append(log_file);
   fprintf(log_stream, "=> SIMULATED ANNEALING:\n\n");
-  fclose(log_stream);
+  sr_log_end(log_stream);
 
-  sr_sa_init_simplex_or_exit(&b, dpos, bak_file, log_file);
+  sr_sa_init_simplex_or_exit(funk, data, ctx->surrogate ? &sg : NULL, &b,
+                             dpos, bak_file, log_file);
 
   /***********************************************************************
     Enter temperature loop
@@ -143,10 +175,10 @@ void sr_sa(int ndim, real dpos, const char *bak_file, const char *log_file)
 
   log_stream = sr_sa_open_log_append(log_file);
   fprintf(log_stream, "=> Start search (abs. tolerance = %.3e)\n", R_TOLERANCE);
-  fclose(log_stream);
+  sr_log_end(log_stream);
 
   real rmin = 0.0;
-  int nfunc = sr_sa_run_temperature_loop(&b, ndim, &rmin);
+  int nfunc = sr_sa_run_temperature_loop(ctx, funk, data, &b, ndim, &rmin);
 
   /***********************************************************************
     Write final results to log file
@@ -157,6 +189,11 @@ void sr_sa(int ndim, real dpos, const char *bak_file, const char *log_file)
 #endif
   sr_sa_write_results(log_file, nfunc, ndim, b.x, rmin);
 
+  if (ctx->surrogate)
+  {
+    sr_sg_report(&sg, log_file);
+    sr_sg_free(&sg);
+  }
   sr_simplex_buffers_free(&b);
 
 } /* end of function sr_sa */
@@ -0,0 +1,166 @@
+/***********************************************************************
+LD/19.10.26
+ File contains:
+
+  sr_sg_init(struct sr_sgscreen *sg, struct sr_context *ctx, int ndim,
+             real dpos, const char *log_file)
+  sr_sg_eval(real *par, void *sg)
+  sr_sg_add(struct sr_sgscreen *sg, real *par, real y)
+  sr_sg_propose(struct sr_sgscreen *sg, real **p, real *y, int ndim,
+                real dpos, long seed, real *out)
+  sr_sg_report(const struct sr_sgscreen *sg, const char *log_file)
+  sr_sg_free(struct sr_sgscreen *sg)
+ Surrogate pre-screening of the trial points of a search.
+
+Changes
+LD/19.10.26 - Creation
+
+***********************************************************************/
+
+/**
+ * @file srsg.c
+ * @brief Pre-screening of trial points with a Gaussian process model of
+ * the R factor (see sr_surrogate.c).
+ *
+ * sr_sg_eval() is used instead of sr_evalrf_ctx() as objective function
+ * of the simplex and annealing searches. Each LEED evaluation is added
+ * to the model; once it has SG_MIN_POINT points per parameter a trial
+ * point is only evaluated if it may improve the best R factor,
+ *
+ *   mu - SG_KAPPA sigma <= y_best + SG_MARGIN,
+ *
+ * otherwise the prediction mu is returned to the minimiser (and logged
+ * as "** surrogate **" line). Points that have been evaluated before
+ * (e.g. the centre of a rebuilt simplex) are not evaluated again.
+ */
+
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+
+#include "search.h"
+
+#define SG_SCALE      2.0      /* length scale in units of dpos */
+#define SG_MIN_POINT  2        /* points per parameter before screening */
+#define SG_KAPPA      2.0      /* width of the confidence band (sigma) */
+#define SG_MARGIN     0.05     /* R factors above y_best still evaluated */
+#define SG_REPEAT     1.e-4    /* resolution of repeated points */
+#define SG_N_CAND     2000     /* random candidates of sr_sg_propose */
+#define SG_RADIUS     3.0      /* half width of proposal box (dpos) */
+
+/**********************************************************************/
+
+/**
+ * @brief Set up pre-screening for a search with @p ndim parameters.
+ *
+ * @return 0 on success, -1 on allocation failure.
+ */
+int sr_sg_init(struct sr_sgscreen *sg, struct sr_context *ctx, int ndim,
+               real dpos, const char *log_file)
+{
+  sg->ctx = ctx;
+  sg->log_file = log_file;
+  sg->n_min = SG_MIN_POINT * (ndim + 1);
+  sg->y_best = 100.;
+  sg->n_eval = sg->n_skip = sg->n_hit = 0;
+  sg->model = sr_surrogate_new(ndim, SG_SCALE * dpos);
+  return (sg->model != NULL) ? 0 : -1;
+}
+
+/**
+ * @brief Add a point evaluated elsewhere (e.g. the vertex of a restart).
+ */
+void sr_sg_add(struct sr_sgscreen *sg, real *par, real y)
+{
+  (void)sr_surrogate_add(sg->model, par, y);
+  if (y < sg->y_best) sg->y_best = y;
+}
+
+/**
+ * @brief Objective function (sr_eval_func) with pre-screening.
+ *
+ * @param par Parameters (`1..ndim`).
+ * @param data Pointer to struct sr_sgscreen.
+ * @return R factor (LEED) or predicted R factor (screened out).
+ */
+real sr_sg_eval(real *par, void *data)
+{
+  struct sr_sgscreen *sg = (struct sr_sgscreen *)data;
+  real y, mu, sigma;
+
+  if (sr_surrogate_lookup(sg->model, par, SG_REPEAT, &y))
+  {
+    sg->n_hit ++;
+    return y;
+  }
+
+  if (sr_surrogate_count(sg->model) >= sg->n_min &&
+      sr_surrogate_predict(sg->model, par, &mu, &sigma) == 0 &&
+      mu - SG_KAPPA * sigma > sg->y_best + SG_MARGIN)
+  {
+    FILE *log_stream = sr_log_begin(sg->log_file);
+    if (log_stream != NULL)
+    {
+      fprintf(log_stream, "#  - par:");
+      for (int i_par = 1; i_par <= sg->ctx->search->n_par; i_par++)
+        fprintf(log_stream, " %.3f", (double)par[i_par]);
+      fprintf(log_stream, " ** surrogate: %.4f +- %.4f, not evaluated **\n",
+              (double)mu, (double)sigma);
+      sr_log_end(log_stream);
+    }
+    sg->n_skip ++;
+    return mu;
+  }
+
+  y = sr_evalrf_ctx(par, sg->ctx);
+  sg->n_eval ++;
+  sr_sg_add(sg, par, y);
+  return y;
+}
+
+/**
+ * @brief Propose a point of high expected improvement near the best
+ * vertex of simplex @p p (`[1..ndim+1][1..ndim]`, values @p y).
+ *
+ * @return Expected improvement of @p out, -1 if the model is too small.
+ */
+real sr_sg_propose(struct sr_sgscreen *sg, real **p, real *y, int ndim,
+                   real dpos, long seed, real *out)
+{
+  int ilo = 1;
+
+  for (int i = 2; i <= ndim + 1; i++)
+    if (y[i] < y[ilo]) ilo = i;
+  if (sr_surrogate_count(sg->model) < sg->n_min) return -1.;
+
+  return sr_surrogate_propose(sg->model, p[ilo], SG_RADIUS * dpos,
+                              SG_N_CAND, sg->y_best, seed, out);
+}
+
+/**
+ * @brief Write the numbers of evaluated and screened points to the log.
+ */
+void sr_sg_report(const struct sr_sgscreen *sg, const char *log_file)
+{
+  FILE *log_stream = sr_log_begin(log_file);
+  if (log_stream == NULL) {
+    OPEN_ERROR(log_file);
+  }
+  fprintf(log_stream, "=> Surrogate: %d of %d trial points screened out, "
+          "%d repeated, %d LEED evaluations\n",
+          sg->n_skip, sg->n_eval + sg->n_skip + sg->n_hit,
+          sg->n_hit, sg->n_eval);
+  sr_log_end(log_stream);
+}
+
+/**
+ * @brief Free the model of @p sg.
+ */
+void sr_sg_free(struct sr_sgscreen *sg)
+{
+  sr_surrogate_free(sg->model);
+  sg->model = NULL;
+}
+
+/***********************************************************************/
@@ -2,7 +2,8 @@
 GH/29.12.95
  File contains:
 
-  sr_sx(int ndim, real dpos, char *bak_file, char *log_file)
+  sr_sx(struct sr_context *ctx, int ndim, real dpos, char *bak_file,
+        char *log_file)
  Perform a search according to the SIMPLEX METHOD
  Driver for routine AMOEBA (From numerical recipes)
 
@@ -10,6 +11,11 @@ GH/29.12.95
 GH/23.08.95
 GH/29.12.95 - insert dpos in parameter list: initial displacement
               can be specified through a command line option.
+LD/19.10.26 - evaluate in the search context ctx (sr_amoeba_data).
+LD/19.10.26 - surrogate pre-screening and restarts from points of high
+              expected improvement (ctx->surrogate, see srsg.c).
+LD/19.10.26 - the log file is written through sr_log_begin/sr_log_end
+              (sr_log.c).
 
 ***********************************************************************/
 
@@ -32,11 +38,14 @@ GH/29.12.95 - insert dpos in parameter list: initial displacement
 #include "sr_simplex.h"
 #include "sr_vertex_stats.h"
 
+#define MAX_PROPOSE_SX  5       /* surrogate proposals after convergence */
+#define EI_MIN_SX       2.e-3   /* smallest expected improvement evaluated */
+
 /**********************************************************************/
 
 static FILE *sr_sx_open_log_append(const char *log_file)
 {
-  FILE *log_stream = fopen(log_file, "a");
+  FILE *log_stream = sr_log_begin(log_file);
   if (log_stream == NULL) {
     OPEN_ERROR(log_file);
   }
@@ -74,10 +83,68 @@ static void sr_sx_log_final_simplex(FILE *log_stream, const sr_simplex_buffers *
   sr_free_vector(avg_p);
 }
 
-void sr_sx(int ndim, real dpos, const char *bak_file, const char *log_file)
+/*
+  After convergence: evaluate the point of highest expected improvement
+  near the best vertex (surrogate model) and restart the simplex from it
+  if it is better. Returns the number of function evaluations.
+*/
+static int sr_sx_surrogate_restart(struct sr_sgscreen *sg,
+                                   sr_simplex_buffers *b, real dpos,
+                                   const char *log_file)
+{
+  int nfunc = 0, n_amoeba;
+  real ei, y, y_old;
+  real *x = sr_alloc_vector((size_t)b->ndim);
+  FILE *log_stream;
+
+  if (x == NULL) return 0;
+
+  for (int i_prop = 1; i_prop <= MAX_PROPOSE_SX; i_prop++)
+  {
+    ei = sr_sg_propose(sg, b->p, b->y, b->ndim, dpos,
+                       sg->ctx->idum - 7919L * (sg->n_eval + i_prop), x);
+    if (ei < EI_MIN_SX) break;
+
+    /* always evaluated by LEED */
+    y_old = sg->y_best;
+    y = sr_evalrf_ctx(x, sg->ctx);
+    sg->n_eval ++;
+    sr_sg_add(sg, x, y);
+    nfunc ++;
+
+    log_stream = sr_sx_open_log_append(log_file);
+    fprintf(log_stream, "=> Surrogate proposal %d (expected improvement "
+            "%.4f): %.4f\n", i_prop, (double)ei, (double)y);
+    sr_log_end(log_stream);
+
+    if (y >= y_old - R_TOLERANCE) continue;
+
+    log_stream = sr_sx_open_log_append(log_file);
+    fprintf(log_stream, "=> Restart search from proposal %d\n", i_prop);
+    sr_log_end(log_stream);
+
+    n_amoeba = 0;
+    if (sr_simplex_build_at(b, x, dpos, sr_sg_eval, sg) != 0 ||
+        sr_amoeba_data(b->p, b->y, b->ndim, R_TOLERANCE, sr_sg_eval, sg,
+                       sg->ctx->project, &n_amoeba) != 0)
+    {
+      fprintf(STDERR, "*** error (sr_sx): simplex minimiser failed\n");
+    }
+    nfunc += b->ndim + 1 + n_amoeba;
+  }
+
+  sr_free_vector(x);
+  return nfunc;
+}
+
+void sr_sx(struct sr_context *ctx, int ndim, real dpos, const char *bak_file,
+           const char *log_file)
 {
   int nfunc = 0;
   sr_simplex_buffers b;
+  struct sr_sgscreen sg;
+  sr_eval_func funk = sr_evalrf_ctx;
+  void *data = ctx;
 
   if (sr_simplex_buffers_alloc(&b, ndim) != 0)
   {
@@ -86,6 +153,18 @@ void sr_sx(int ndim, real dpos, const char *bak_file, const char *log_file)
     exit(1);
   }
 
+  if (ctx->surrogate)
+  {
+    if (sr_sg_init(&sg, ctx, ndim, dpos, log_file) != 0)
+    {
+      sr_simplex_buffers_free(&b);
+      fprintf(STDERR, "*** error (sr_sx): allocation failure\n");
+      exit(1);
+    }
+    funk = sr_sg_eval;
+    data = &sg;
+  }
+
   FILE *log_stream = sr_sx_open_log_append(log_file);
   fprintf(log_stream, "=> SIMPLEX SEARCH:\n\n");
 
@@ -96,9 +175,9 @@ void sr_sx(int ndim, real dpos, const char *bak_file, const char *log_file)
   if (strncmp(bak_file, "---", 3) == 0)
   {
     fprintf(log_stream, "=> Set up vertex:\n");
-    fclose(log_stream);
+    sr_log_end(log_stream);
 
-    if (sr_simplex_build_initial(&b, dpos, sr_evalrf) != 0) {
+    if (sr_simplex_build_initial(&b, dpos, funk, data) != 0) {
       sr_simplex_buffers_free(&b);
       fprintf(STDERR, "*** error (sr_sx): failed to initialise simplex\n");
       exit(1);
@@ -107,13 +186,16 @@ void sr_sx(int ndim, real dpos, const char *bak_file, const char *log_file)
   else
   {
     fprintf(log_stream, "=> Read vertex from \"%s\":\n", bak_file);
-    fclose(log_stream);
+    sr_log_end(log_stream);
 
     if (sr_simplex_read_vertex(&b, bak_file) != 0) {
       sr_simplex_buffers_free(&b);
       fprintf(STDERR, "*** error (sr_sx): failed to read vertex file\n");
       exit(1);
     }
+    if (ctx->surrogate)
+      for (int i_par = 1; i_par <= ndim + 1; i_par++)
+        sr_sg_add(&sg, b.p[i_par], b.y[i_par]);
   }
 
   /***********************************************************************
@@ -126,13 +208,16 @@ void sr_sx(int ndim, real dpos, const char *bak_file, const char *log_file)
 
   log_stream = sr_sx_open_log_append(log_file);
   fprintf(log_stream, "=> Start search (abs. tolerance = %.3e)\n", R_TOLERANCE);
-  fclose(log_stream);
+  sr_log_end(log_stream);
 
-  if (sr_amoeba(b.p, b.y, ndim, R_TOLERANCE, sr_evalrf, &nfunc) != 0)
+  if (sr_amoeba_data(b.p, b.y, ndim, R_TOLERANCE, funk, data,
+                     ctx->project, &nfunc) != 0)
   {
     fprintf(STDERR, "*** error (sr_sx): simplex minimiser failed\n");
   }
 
+  if (ctx->surrogate) nfunc += sr_sx_surrogate_restart(&sg, &b, dpos, log_file);
+
   /***********************************************************************
     Write final results to log file
   ***********************************************************************/
@@ -143,8 +228,13 @@ void sr_sx(int ndim, real dpos, const char *bak_file, const char *log_file)
 
   log_stream = sr_sx_open_log_append(log_file);
   sr_sx_log_final_simplex(log_stream, &b, nfunc);
-  fclose(log_stream);
+  sr_log_end(log_stream);
 
+  if (ctx->surrogate)
+  {
+    sr_sg_report(&sg, log_file);
+    sr_sg_free(&sg);
+  }
   sr_simplex_buffers_free(&b);
 } /* end of function sr_sx */
 
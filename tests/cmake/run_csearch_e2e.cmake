@@ -19,10 +19,25 @@ endif()
 if(NOT DEFINED OUT_BASENAME)
   set(OUT_BASENAME "csearch_e2e")
 endif()
+# options of csearch (separated by spaces) and expected log file
+# contents (separated by '|')
+if(NOT DEFINED SEARCH_ARGS)
+  set(SEARCH_ARGS "-s sx -d 0.1")
+endif()
+if(NOT DEFINED LOG_NEEDLES)
+  set(LOG_NEEDLES "CSEARCH - version|=> SIMPLEX SEARCH|rf:")
+endif()
+separate_arguments(search_args UNIX_COMMAND "${SEARCH_ARGS}")
+string(REPLACE "|" ";" log_needles "${LOG_NEEDLES}")
+if(NOT DEFINED CHECK_VERTEX)
+  set(CHECK_VERTEX 1)
+endif()
 
 set(workdir "${CMAKE_CURRENT_BINARY_DIR}/e2e-${OUT_BASENAME}")
 file(REMOVE_RECURSE "${workdir}")
 file(MAKE_DIRECTORY "${workdir}")
+set(scratch "${workdir}/scratch")
+file(MAKE_DIRECTORY "${scratch}")
 
 set(inp_dst "${workdir}/${OUT_BASENAME}.inp")
 set(bul_dst "${workdir}/${OUT_BASENAME}.bul")
@@ -64,7 +79,8 @@ execute_process(
           "PATH=${path_value_escaped}"
           "CSEARCH_LEED=${leed_name}"
           "CSEARCH_RFAC=${rfac_name}"
-          "${PROGRAM}" -i "${inp_dst}" -s sx -d 0.1
+          "CSEARCH_SCRATCH=${scratch}"
+          "${PROGRAM}" -i "${inp_dst}" ${search_args}
   WORKING_DIRECTORY "${workdir}"
   RESULT_VARIABLE rc
   OUTPUT_VARIABLE stdout
@@ -76,16 +92,14 @@ endif()
 
 set(expected_files
   "${workdir}/${OUT_BASENAME}.log"
-  "${workdir}/${OUT_BASENAME}.par"
-  "${workdir}/${OUT_BASENAME}.bsr"
-  "${workdir}/${OUT_BASENAME}.res"
-  "${workdir}/${OUT_BASENAME}.dum"
   "${workdir}/${OUT_BASENAME}.pmin"
   "${workdir}/${OUT_BASENAME}.rmin"
   "${workdir}/${OUT_BASENAME}.bmin"
-  "${workdir}/${OUT_BASENAME}.ver"
-  "${workdir}/${OUT_BASENAME}.out"
+  "${workdir}/${OUT_BASENAME}.rfmin"
 )
+if(CHECK_VERTEX)
+  list(APPEND expected_files "${workdir}/${OUT_BASENAME}.ver")
+endif()
 
 foreach(path IN LISTS expected_files)
   if(NOT EXISTS "${path}")
@@ -93,14 +107,69 @@ foreach(path IN LISTS expected_files)
   endif()
 endforeach()
 
+# the files of each evaluation are written to a scratch directory,
+# which is removed at the end of the search
+foreach(ext IN ITEMS par bsr res dum out)
+  if(EXISTS "${workdir}/${OUT_BASENAME}.${ext}")
+    message(FATAL_ERROR "unexpected file in project directory: ${OUT_BASENAME}.${ext}")
+  endif()
+endforeach()
+file(GLOB scratch_left "${scratch}/*")
+if(scratch_left)
+  message(FATAL_ERROR "scratch directory not removed: ${scratch_left}")
+endif()
+
 file(READ "${workdir}/${OUT_BASENAME}.log" log_contents)
-foreach(needle IN ITEMS "CSEARCH - version" "=> SIMPLEX SEARCH" "rf:")
+foreach(needle IN LISTS log_needles)
   string(FIND "${log_contents}" "${needle}" pos)
   if(pos EQUAL -1)
-    message(FATAL_ERROR "expected to find ${needle} in ${OUT_BASENAME}.log")
+    message(FATAL_ERROR "expected to find ${needle} in ${OUT_BASENAME}.log:\n${log_contents}")
   endif()
 endforeach()
 
+# trace file (csearch --trace <OUT_BASENAME>.trace): expected contents
+# separated by '|'
+if(DEFINED TRACE_NEEDLES)
+  string(REPLACE "|" ";" trace_needles "${TRACE_NEEDLES}")
+  file(READ "${workdir}/${OUT_BASENAME}.trace" trace_contents)
+  foreach(needle IN LISTS trace_needles)
+    string(FIND "${trace_contents}" "${needle}" pos)
+    if(pos EQUAL -1)
+      message(FATAL_ERROR "expected to find ${needle} in ${OUT_BASENAME}.trace:\n${trace_contents}")
+    endif()
+  endforeach()
+endif()
+
+# statistics of the log and trace files (EVSTAT_PROGRAM): expected
+# output separated by '|'
+if(DEFINED EVSTAT_PROGRAM)
+  string(REPLACE "|" ";" evstat_needles "${EVSTAT_NEEDLES}")
+  set(evstat_files "${OUT_BASENAME}.log")
+  if(EXISTS "${workdir}/${OUT_BASENAME}.trace")
+    list(APPEND evstat_files "${OUT_BASENAME}.trace")
+  endif()
+  execute_process(
+    COMMAND "${EVSTAT_PROGRAM}" ${evstat_files}
+    WORKING_DIRECTORY "${workdir}"
+    RESULT_VARIABLE rc
+    OUTPUT_VARIABLE evstat_out
+    ERROR_VARIABLE evstat_err
+  )
+  if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "evstat failed (rc=${rc})\n${evstat_out}\n${evstat_err}")
+  endif()
+  foreach(needle IN LISTS evstat_needles)
+    string(FIND "${evstat_out}" "${needle}" pos)
+    if(pos EQUAL -1)
+      message(FATAL_ERROR "expected to find ${needle} in output of evstat:\n${evstat_out}")
+    endif()
+  endforeach()
+endif()
+
+if(NOT CHECK_VERTEX)
+  return()
+endif()
+
 file(READ "${workdir}/${OUT_BASENAME}.ver" ver_contents)
 string(REGEX MATCH "^[0-9]+[ ]+[0-9]+[ ]+${OUT_BASENAME}" ver_header_match "${ver_contents}")
 if(ver_header_match STREQUAL "")
@@ -39,7 +39,11 @@ static void replace_suffix(char *path, size_t cap, const char *suffix, const cha
     (void)snprintf(path + (len - slen), cap - (len - slen), "%s", replacement);
 }
 
-static int read_first_po_z(const char *par_path, double *out_z)
+#define MAX_ATOMS 64
+
+/* sum of (z - target_z)^2 over all atoms ("po:" lines); dz[i] = z - target_z */
+static int read_po_dz2(const char *par_path, double target_z, double *out_dz2,
+                       double *dz, int *n_dz)
 {
     FILE *fp = fopen(par_path, "rb");
     if (fp == NULL) {
@@ -47,6 +51,8 @@ static int read_first_po_z(const char *par_path, double *out_z)
     }
 
     char line[512];
+    int n_atoms = 0;
+    *out_dz2 = 0.0;
     while (fgets(line, (int)sizeof(line), fp) != NULL) {
         if (strncmp(line, "po:", 3) != 0) {
             continue;
@@ -55,14 +61,17 @@ static int read_first_po_z(const char *par_path, double *out_z)
         char name[128];
         double x = 0.0, y = 0.0, z = 0.0;
         if (sscanf(line, "po: %127s %lf %lf %lf", name, &x, &y, &z) == 4) {
-            fclose(fp);
-            *out_z = z;
-            return 0;
+            *out_dz2 += (z - target_z) * (z - target_z);
+            if (n_atoms < MAX_ATOMS) {
+                dz[n_atoms] = z - target_z;
+            }
+            n_atoms++;
         }
     }
 
     fclose(fp);
-    return -1;
+    *n_dz = (n_atoms < MAX_ATOMS) ? n_atoms : MAX_ATOMS;
+    return (n_atoms > 0) ? 0 : -1;
 }
 
 int main(int argc, char **argv)
@@ -77,27 +86,46 @@ int main(int argc, char **argv)
     (void)snprintf(par_path, sizeof(par_path), "%s", res_path);
     replace_suffix(par_path, sizeof(par_path), ".res", ".par");
 
-    double z = 0.0;
-    if (read_first_po_z(par_path, &z) != 0) {
+    const double target_z = 1.2;
+    double dz2 = 0.0;
+    double dz[MAX_ATOMS];
+    int n_dz = 0;
+    if (read_po_dz2(par_path, target_z, &dz2, dz, &n_dz) != 0) {
         fprintf(stderr, "fake_csearch_rfac: failed to read z from %s\n", par_path);
         return 3;
     }
 
     /*
-     * Create a small, smooth objective with a minimum near z=1.2.
+     * Create a small, smooth objective with a minimum at z=1.2 (all atoms).
      * csearch passes the R factor value to its optimisers (y), and expects
      * the R-factor program stdout to contain at least three numbers:
      *   rfac rr shift
      *
-     * sr_evalrf parses: rfac (1st) and shift (3rd), skipping rr (2nd).
-     * sr_er parses: rfac (1st) and rr (2nd).
+     * sr_evalrf parses rfac, rr and shift; sr_er uses rr.
      */
-    const double target_z = 1.2;
-    const double dz = z - target_z;
-    const double rfac = 0.10 + (dz * dz);
+    const double rfac = 0.10 + dz2;
     const double rr = 0.25;
     const double shift = 0.0;
 
+    /*
+     * -y <file>: residuals whose sum of squares is rfac
+     * (sqrt(0.10) and z - 1.2 of each atom), as written by crfac -y.
+     */
+    const char *yres_path = arg_value(argc, argv, "-y");
+    if (yres_path != NULL) {
+        FILE *fp = fopen(yres_path, "w");
+        if (fp == NULL) {
+            fprintf(stderr, "fake_csearch_rfac: cannot write %s\n", yres_path);
+            return 4;
+        }
+        fprintf(fp, "# n_res shift Rp\n%d %.4f %.8f\n", n_dz + 1, shift, rfac);
+        fprintf(fp, "%.10e\n", 0.31622776601683794);  /* sqrt(0.10) */
+        for (int i = 0; i < n_dz; i++) {
+            fprintf(fp, "%.10e\n", dz[i]);
+        }
+        fclose(fp);
+    }
+
     printf("%.6f %.6f %.6f\n", rfac, rr, shift);
     return 0;
 }
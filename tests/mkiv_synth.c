@@ -0,0 +1,158 @@
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+
+#include "mkiv.h"
+#include "mkiv_synth.h"
+
+void mkiv_synth_default(struct mkiv_synth *syn)
+{
+    syn->width = 512;
+    syn->height = 512;
+    syn->e_ref = 100.f;
+    syn->origin_x = 256.f;
+    syn->origin_y = 250.f;
+    syn->drift_x = 30.f;
+    syn->drift_y = -20.f;
+    syn->a1_x = 80.f;
+    syn->a1_y = 4.f;
+    syn->a2_x = -3.f;
+    syn->a2_y = 78.f;
+    syn->ratio = 0.1f;
+    syn->k_10 = 1.2f;
+    syn->sigma = 2.f;
+    syn->background = 200.f;
+    syn->noise = 20.f;
+    syn->cur_amp = 0.1f;
+    syn->order = 3;
+    syn->seed = 12345u;
+}
+
+/* smooth positive IV curve, different for each beam */
+float mkiv_synth_iv(int h, int k, float energy)
+{
+    return 4.e4f * (1.2f + sinf(0.11f * energy + 1.3f * h + 0.7f * k)) *
+           expf(-energy / 300.f) / (1.f + 0.2f * (h * h + k * k));
+}
+
+float mkiv_synth_current(const struct mkiv_synth *syn, float energy)
+{
+    return 1.f + syn->cur_amp * sinf(0.37f * energy);
+}
+
+void mkiv_synth_basis(const struct mkiv_synth *syn, float energy,
+                      float *o_x, float *o_y, float *a1_x, float *a1_y,
+                      float *a2_x, float *a2_y)
+{
+    float kappa = sqrtf(syn->e_ref / energy);
+    float du = 1.f / sqrtf(energy) - 1.f / sqrtf(syn->e_ref);
+
+    *o_x = syn->origin_x + syn->drift_x * du;
+    *o_y = syn->origin_y + syn->drift_y * du;
+    *a1_x = syn->a1_x * kappa;
+    *a1_y = syn->a1_y * kappa;
+    *a2_x = syn->a2_x * kappa;
+    *a2_y = syn->a2_y * kappa;
+}
+
+int mkiv_synth_spot_pos(const struct mkiv_synth *syn, int h, int k,
+                        float energy, float *x, float *y)
+{
+    float o_x, o_y, a1_x, a1_y, a2_x, a2_y;
+    float r_x, r_y, radius, sin_th, cos_th, cor_fac;
+
+    mkiv_synth_basis(syn, energy, &o_x, &o_y, &a1_x, &a1_y, &a2_x, &a2_y);
+
+    /* as in calcspotpos: screen radius and correction factor */
+    radius = hypotf(a1_x, a1_y) / (syn->k_10 * H2M / sqrtf(energy));
+    r_x = h * a1_x + k * a2_x;
+    r_y = h * a1_y + k * a2_y;
+    sin_th = hypotf(r_x, r_y) / radius;
+    if (sin_th > 1.f) return 0;
+    cos_th = sqrtf(1.f - sin_th * sin_th);
+    cor_fac = 1.f + syn->ratio * (1.f - cos_th);
+
+    *x = o_x + r_x / cor_fac;
+    *y = o_y + r_y / cor_fac;
+    return 1;
+}
+
+static unsigned int synth_rand(unsigned int *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+void mkiv_synth_frame(const struct mkiv_synth *syn, float energy,
+                      unsigned short *data)
+{
+    int n_pix = syn->width * syn->height;
+    int half = (int)(4.f * syn->sigma) + 1;
+    float *val = (float *)malloc((size_t)n_pix * sizeof(float));
+    float cur = mkiv_synth_current(syn, energy);
+    float norm = 1.f / (2.f * (float)PI * syn->sigma * syn->sigma);
+    unsigned int state = syn->seed ^ (unsigned int)(energy * 1000.f);
+    float x, y, amp, v;
+
+    if (val == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < n_pix; i++) {
+        val[i] = syn->background;
+    }
+
+    for (int h = -syn->order; h <= syn->order; h++) {
+        for (int k = -syn->order; k <= syn->order; k++) {
+            if (!mkiv_synth_spot_pos(syn, h, k, energy, &x, &y)) {
+                continue;
+            }
+            amp = mkiv_synth_iv(h, k, energy) * cur * norm;
+            for (int r = (int)y - half; r <= (int)y + half; r++) {
+                if (r < 0 || r >= syn->height) continue;
+                for (int c = (int)x - half; c <= (int)x + half; c++) {
+                    if (c < 0 || c >= syn->width) continue;
+                    val[r * syn->width + c] += amp *
+                        expf(-((c - x) * (c - x) + (r - y) * (r - y)) /
+                             (2.f * syn->sigma * syn->sigma));
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < n_pix; i++) {
+        v = val[i] + syn->noise *
+            ((float)(synth_rand(&state) & 0xFFFF) / 65535.f - 0.5f);
+        data[i] = (unsigned short)((v < 0.f) ? 0.f :
+                                   (v > 65535.f) ? 65535.f : v + 0.5f);
+    }
+    free(val);
+}
+
+int mkiv_synth_write_tif(const char *path, int width, int height,
+                         const unsigned short *data)
+{
+    TIFF *tif = TIFFOpen(path, "w");
+
+    if (tif == NULL) {
+        return -1;
+    }
+    TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, (uint32)width);
+    TIFFSetField(tif, TIFFTAG_IMAGELENGTH, (uint32)height);
+    TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 16);
+    TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+    TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
+    TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+    TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, (uint32)height);
+    for (int r = 0; r < height; r++) {
+        if (TIFFWriteScanline(tif, (void *)(data + (size_t)r * width),
+                              (uint32)r, 0) < 0) {
+            TIFFClose(tif);
+            return -1;
+        }
+    }
+    TIFFClose(tif);
+    return 0;
+}
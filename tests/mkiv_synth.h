@@ -0,0 +1,52 @@
+#ifndef CLEED_MKIV_SYNTH_H
+#define CLEED_MKIV_SYNTH_H
+
+/*
+ * Synthetic LEED image series for mkiv tests and benchmarks.
+ *
+ * Gaussian spots on a kinematic lattice: the lattice vectors scale with
+ * sqrt(e_ref/E) and the positions carry the same screen correction as
+ * calcspotpos(); the origin drifts linearly in u = 1/sqrt(E). The
+ * integrated intensity of spot (h,k) is mkiv_synth_iv() times the beam
+ * current mkiv_synth_current(); a constant background and uniform noise
+ * are added.
+ */
+
+struct mkiv_synth
+{
+    int width, height;          /* image size (pixels) */
+    float e_ref;                /* reference energy (eV) */
+    float origin_x, origin_y;   /* (0,0) spot at e_ref */
+    float drift_x, drift_y;     /* origin drift per unit of 1/sqrt(E) */
+    float a1_x, a1_y;           /* lattice vectors at e_ref (pixels) */
+    float a2_x, a2_y;
+    float ratio;                /* screen radius / camera distance */
+    float k_10;                 /* k_par of (1,0) (1/A) */
+    float sigma;                /* spot width (pixels) */
+    float background;           /* background level */
+    float noise;                /* amplitude of uniform noise */
+    float cur_amp;              /* relative variation of beam current */
+    int order;                  /* spots with |h|,|k| <= order */
+    unsigned int seed;
+};
+
+void mkiv_synth_default(struct mkiv_synth *syn);
+
+float mkiv_synth_iv(int h, int k, float energy);
+float mkiv_synth_current(const struct mkiv_synth *syn, float energy);
+
+/* returns 0 if spot (h,k) is outside the screen at this energy */
+int mkiv_synth_spot_pos(const struct mkiv_synth *syn, int h, int k,
+                        float energy, float *x, float *y);
+
+void mkiv_synth_basis(const struct mkiv_synth *syn, float energy,
+                      float *o_x, float *o_y, float *a1_x, float *a1_y,
+                      float *a2_x, float *a2_y);
+
+void mkiv_synth_frame(const struct mkiv_synth *syn, float energy,
+                      unsigned short *data);
+
+int mkiv_synth_write_tif(const char *path, int width, int height,
+                         const unsigned short *data);
+
+#endif
@@ -0,0 +1,134 @@
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+
+#include "ftsmooth.h"
+#include "test_support.h"
+
+/* X_k = sum_n x_n exp(+2 pi i n k / N) evaluated directly */
+static void naive_dft(const double *re, const double *im, int n,
+                      double *out_re, double *out_im)
+{
+    for (int k = 0; k < n; k++) {
+        out_re[k] = out_im[k] = 0.;
+        for (int j = 0; j < n; j++) {
+            const double phi = 2. * PI * (double)((long long)j * k % n) / n;
+            out_re[k] += re[j] * cos(phi) - im[j] * sin(phi);
+            out_im[k] += re[j] * sin(phi) + im[j] * cos(phi);
+        }
+    }
+}
+
+static int test_fft_matches_dft(int n)
+{
+    double *re = malloc(n * sizeof(double));
+    double *im = malloc(n * sizeof(double));
+    double *ref_re = malloc(n * sizeof(double));
+    double *ref_im = malloc(n * sizeof(double));
+    ftsmooth_fft_t *plan = ftsmooth_fft_init(n);
+
+    CLEED_TEST_ASSERT(plan != NULL);
+    for (int i = 0; i < n; i++) {
+        re[i] = sin(0.37 * i) + 0.01 * i;
+        im[i] = cos(1.3 * i * i / (double)n);
+    }
+    naive_dft(re, im, n, ref_re, ref_im);
+    ftsmooth_fft_exec(plan, re, im);
+
+    for (int i = 0; i < n; i++) {
+        CLEED_TEST_ASSERT_NEAR(re[i], ref_re[i], 1e-9 * n);
+        CLEED_TEST_ASSERT_NEAR(im[i], ref_im[i], 1e-9 * n);
+    }
+
+    ftsmooth_fft_free(plan);
+    free(re);
+    free(im);
+    free(ref_re);
+    free(ref_im);
+    return 0;
+}
+
+/* batch mode must give the same result as smoothing each column */
+static int test_batch_matches_single(void)
+{
+    enum { N_X = 151, N_COL = 3 };
+    double x[N_X], single[N_COL][N_X], batch[N_COL][N_X];
+    double *cols[N_COL];
+    FILE *null_out = tmpfile();
+
+    CLEED_TEST_ASSERT(null_out != NULL);
+    for (int i = 0; i < N_X; i++) {
+        x[i] = 40. + 0.5 * i;
+        for (int c = 0; c < N_COL; c++) {
+            single[c][i] = batch[c][i] =
+                exp(-0.01 * i * (c + 1)) * (1. + sin(0.2 * i)) + 0.05 * ((i * 7 + c) % 5);
+        }
+    }
+    for (int c = 0; c < N_COL; c++) {
+        CLEED_TEST_ASSERT(ftsmooth(null_out, x, single[c], N_X, 0.5, 10., 1) == 0);
+        cols[c] = batch[c];
+    }
+    CLEED_TEST_ASSERT(ftsmooth_batch(null_out, x, cols, N_X, N_COL, 0.5, 10., 1) == 0);
+
+    for (int c = 0; c < N_COL; c++) {
+        for (int i = 0; i < N_X; i++) {
+            CLEED_TEST_ASSERT_NEAR(batch[c][i], single[c][i], 1e-12);
+        }
+    }
+
+    /* smoothing must remove the high frequency part but keep the curve */
+    for (int i = 5; i < N_X - 5; i++) {
+        const double smooth = exp(-0.01 * i) * (1. + sin(0.2 * i)) + 0.1;
+        CLEED_TEST_ASSERT_NEAR(single[0][i], smooth, 0.1);
+    }
+
+    fclose(null_out);
+    return 0;
+}
+
+/* equidistant (FFT) and non-equidistant (direct) input must agree */
+static int test_fft_matches_direct(void)
+{
+    enum { N_X = 97 };
+    double x[N_X], x_pert[N_X], f_fft[N_X], f_dir[N_X];
+    FILE *null_out = tmpfile();
+
+    CLEED_TEST_ASSERT(null_out != NULL);
+    for (int i = 0; i < N_X; i++) {
+        x[i] = 20. + 2. * i;
+        /* shift inner points by 1e-3 of a step: forces direct transform */
+        x_pert[i] = x[i] + ((i > 0 && i < N_X - 1 && i % 2) ? 2.e-3 : 0.);
+        f_fft[i] = f_dir[i] = 1. + cos(0.15 * i) * exp(-0.02 * i);
+    }
+    CLEED_TEST_ASSERT(ftsmooth(null_out, x, f_fft, N_X, 0.6, 10., 1) == 0);
+    CLEED_TEST_ASSERT(ftsmooth(null_out, x_pert, f_dir, N_X, 0.6, 10., 1) == 0);
+
+    for (int i = 0; i < N_X; i++) {
+        CLEED_TEST_ASSERT_NEAR(f_fft[i], f_dir[i], 1e-3);
+    }
+
+    fclose(null_out);
+    return 0;
+}
+
+int main(void)
+{
+    const int lengths[] = {1, 2, 8, 64, 6, 30, 576, 1194};
+
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        if (test_fft_matches_dft(lengths[i]) != 0) {
+            fprintf(stderr, "FFT of length %d failed\n", lengths[i]);
+            return 1;
+        }
+    }
+    if (test_batch_matches_single() != 0) {
+        return 1;
+    }
+    if (test_fft_matches_direct() != 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+
+#include "mkiv.h"
+#include "test_support.h"
+
+#define N_FRAME 60
+
+int main(void)
+{
+    float cur[N_FRAME], smo[N_FRAME];
+    float lag_causal = 0.f, lag_centred = 0.f;
+    int i;
+
+    /* constant current is unchanged, also at both ends */
+    for (i = 0; i < N_FRAME; i++) cur[i] = 42.f;
+    b_smooth_series(cur, smo, N_FRAME, 5);
+    for (i = 0; i < N_FRAME; i++) CLEED_TEST_ASSERT_NEAR(smo[i], 42.f, 1e-4);
+
+    /* linear drift: the centred average is exact away from the ends,
+       the causal average (b_smooth) is delayed */
+    for (i = 0; i < N_FRAME; i++) cur[i] = 100.f + 0.5f * i;
+    b_smooth_series(cur, smo, N_FRAME, 5);
+    for (i = 5; i < N_FRAME - 5; i++) {
+        CLEED_TEST_ASSERT_NEAR(smo[i], cur[i], 1e-3);
+        lag_centred += fabsf(smo[i] - cur[i]);
+        lag_causal += fabsf(b_smooth(cur, i, 0, 1, 10) - cur[i]);
+    }
+    printf("mean deviation: centred %g, causal %g\n",
+           lag_centred / (N_FRAME - 10), lag_causal / (N_FRAME - 10));
+    CLEED_TEST_ASSERT(lag_causal > 10.f * lag_centred + 1.f);
+
+    /* noise is reduced */
+    for (i = 0; i < N_FRAME; i++) cur[i] = 100.f + ((i % 2) ? 3.f : -3.f);
+    b_smooth_series(cur, smo, N_FRAME, 5);
+    for (i = 5; i < N_FRAME - 5; i++) CLEED_TEST_ASSERT(fabsf(smo[i] - 100.f) < 0.6f);
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "mkiv.h"
+#include "mkiv_synth.h"
+#include "test_support.h"
+
+#define N_SPOT_MAX 25
+
+/* Positions of the spots of a synthetic frame found by each centroid
+   method, starting from the nearest pixel (as found by fimax4). */
+int main(void)
+{
+    struct mkiv_synth syn;
+    ImageMatrix mat;
+    Spot spot[N_SPOT_MAX];
+    unsigned short *data;
+    float tx[N_SPOT_MAX], ty[N_SPOT_MAX], energy = 90.f, range = 8.f;
+    double err[3], err_max[3];
+    int nspot = 0, method;
+
+    mkiv_synth_default(&syn);
+    data = (unsigned short *)malloc((size_t)syn.width * syn.height *
+                                    sizeof(unsigned short));
+    CLEED_TEST_ASSERT(data != NULL);
+    mkiv_synth_frame(&syn, energy, data);
+    mat.rows = syn.width;
+    mat.cols = syn.height;
+    mat.imagedata = (uint32 *)data;
+
+    for (int h = -2; h <= 2; h++) {
+        for (int k = -2; k <= 2; k++) {
+            if (!mkiv_synth_spot_pos(&syn, h, k, energy,
+                                     tx + nspot, ty + nspot)) continue;
+            nspot++;
+        }
+    }
+    CLEED_TEST_ASSERT(nspot > 10);
+
+    for (method = CENT_COG; method <= CENT_GAUSS; method++) {
+        for (int i = 0; i < nspot; i++) {
+            memset(spot + i, 0, sizeof(Spot));
+            spot[i].xx = floorf(tx[i] + 0.5f);
+            spot[i].yy = floorf(ty[i] + 0.5f);
+        }
+        CLEED_TEST_ASSERT(centroid(nspot, spot, range, &mat, method) == 0);
+
+        err[method] = err_max[method] = 0.;
+        for (int i = 0; i < nspot; i++) {
+            double d = hypot(spot[i].xx - tx[i], spot[i].yy - ty[i]);
+            err[method] += d / nspot;
+            if (d > err_max[method]) err_max[method] = d;
+        }
+        printf("method %d: mean error %.4f  max. error %.4f pixels\n",
+               method, err[method], err_max[method]);
+    }
+
+    CLEED_TEST_ASSERT(err[CENT_MOMENT] < err[CENT_COG]);
+    CLEED_TEST_ASSERT(err[CENT_GAUSS] < err[CENT_COG]);
+    CLEED_TEST_ASSERT(err_max[CENT_MOMENT] < 0.2);
+    CLEED_TEST_ASSERT(err_max[CENT_GAUSS] < 0.15);
+
+    free(data);
+    return 0;
+}
@@ -0,0 +1,137 @@
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "mkiv.h"
+#include "test_support.h"
+
+#define WIDTH   61          /* pixels per row (ImageMatrix.rows) */
+#define HEIGHT  47          /* number of rows (ImageMatrix.cols) */
+#define N_SPOT  40
+#define RANGE   9.f
+
+static unsigned long seed = 12345UL;
+
+static unsigned int lcg(void)
+{
+    seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+    return (unsigned int)(seed >> 8);
+}
+
+/* fimax4 as it was before the box sums: the direct 7x7 kernel sum for
+   every candidate of the search disc */
+static void fimax4_ref(int nspot, Spot spot[], int step, float range,
+                       ImageMatrix *image)
+{
+    static const long kernel[7*7] = { 0, 1, 1, 1, 1, 1, 0 ,
+                                      1, 1, 2, 2, 2, 1, 1 ,
+                                      1, 2, 4, 8, 4, 2, 1 ,
+                                      1, 2, 8,16, 8, 2, 1 ,
+                                      1, 2, 4, 8, 4, 2, 1 ,
+                                      1, 1, 2, 2, 2, 1, 1 ,
+                                      0, 1, 1, 1, 1, 1, 0 };
+    int cols = image->rows;
+    int rows = image->cols;
+    unsigned short *im = (unsigned short *)image->imagedata;
+    int ad[7*7], k = 0;
+
+    for (int v = -3; v <= 3; v++)
+        for (int h = -3; h <= 3; h++)
+            ad[k++] = v*cols + h;
+
+    for (int i = 0; i < nspot; i++) {
+        float h0 = spot[i].xx, v0 = spot[i].yy, r_spot;
+        int lowh, high, lowv, higv;
+        long max_sum = 0L;
+
+        if (spot[i].control & SPOT_GOOD_S2N)
+            continue;
+        r_spot = (spot[i].range > 0. && spot[i].range < range) ?
+                 spot[i].range : range;
+
+        lowh = MAX( (int)(h0-r_spot) , 3 );
+        high = MIN( (int)(h0+r_spot) , cols-3-1 );
+        lowv = MAX( (int)(v0-r_spot) , 3 );
+        higv = MIN( (int)(v0+r_spot) , rows-3-1 );
+
+        for (int v = lowv; v <= higv; v += step) {
+            for (int h = lowh; h <= high; h += step) {
+                long sum = 0L;
+
+                if (PYTH(v-v0,h-h0) > r_spot)
+                    continue;
+                for (k = 0; k < 7*7; k++)
+                    sum += kernel[k] * im[v*cols + h + ad[k]];
+                if (sum > max_sum) {
+                    spot[i].yy = (float)v;
+                    spot[i].xx = (float)h;
+                    max_sum = sum;
+                }
+            }
+        }
+    }
+}
+
+/* random spots, many of them close to (or beyond) the image border;
+   every fourth spot has its own (smaller, larger or no) search radius */
+static void random_spots(Spot spot[])
+{
+    memset(spot, 0, N_SPOT * sizeof(Spot));
+    for (int i = 0; i < N_SPOT; i++) {
+        spot[i].xx = (float)(lcg() % (WIDTH * 100 + 800)) / 100.f - 4.f;
+        spot[i].yy = (float)(lcg() % (HEIGHT * 100 + 800)) / 100.f - 4.f;
+        switch (i % 4) {
+        case 1: spot[i].range = 2.5f + (float)(lcg() % 50) / 10.f; break;
+        case 2: spot[i].range = RANGE + 3.f; break;
+        case 3: spot[i].range = 1.f; break;
+        default: break;
+        }
+    }
+    spot[7].control |= SPOT_GOOD_S2N;
+}
+
+int main(void)
+{
+    ImageMatrix mat;
+    unsigned short *data;
+    Spot spot[N_SPOT], ref[N_SPOT];
+
+    data = (unsigned short *)malloc(WIDTH * HEIGHT * sizeof(unsigned short));
+    CLEED_TEST_ASSERT(data != NULL);
+    mat.rows = WIDTH;
+    mat.cols = HEIGHT;
+    mat.imagedata = (uint32 *)data;
+
+    for (int bits = 8; bits <= 16; bits += 8) {
+        for (int frame = 0; frame < 4; frame++) {
+            for (int i = 0; i < WIDTH * HEIGHT; i++) {
+                data[i] = (unsigned short)(lcg() & ((1U << bits) - 1));
+            }
+            /* saturated areas: ties are resolved in the original order */
+            if (frame == 3) {
+                for (int i = 0; i < WIDTH * HEIGHT / 3; i++) {
+                    data[i] = (unsigned short)((1U << bits) - 1);
+                }
+            }
+
+            for (int step = 1; step <= 3; step++) {
+                random_spots(spot);
+                memcpy(ref, spot, sizeof(spot));
+
+                CLEED_TEST_ASSERT(fimax4(N_SPOT, spot, step, RANGE, &mat) == 0);
+                fimax4_ref(N_SPOT, ref, step, RANGE, &mat);
+
+                for (int i = 0; i < N_SPOT; i++) {
+                    CLEED_TEST_ASSERT(memcmp(&spot[i].xx, &ref[i].xx,
+                                             sizeof(float)) == 0);
+                    CLEED_TEST_ASSERT(memcmp(&spot[i].yy, &ref[i].yy,
+                                             sizeof(float)) == 0);
+                }
+            }
+        }
+    }
+
+    free(data);
+    return 0;
+}
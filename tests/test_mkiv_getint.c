@@ -0,0 +1,66 @@
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "mkiv.h"
+#include "test_support.h"
+
+#define N_SIZE 64
+#define N_FAR  5         /* rows |j| >= N_FAR have intensity 2 */
+
+/* Background area of get_int for an ellipse that is wider in y than
+   verh * h: the background ellipse reaches y = verh * v, i.e. beyond
+   the rows that the old (verh * h > v) ? h : v half-width covered. */
+int main(void)
+{
+    ImageMatrix mat;
+    Spot spot;
+    Vector scale;
+    unsigned short *data;
+    float h = 2.f, v = 4.f, verh = 1.5f;
+    int e_count = 0, b_count = 0, n_far = 0;
+    double expected;
+
+    data = (unsigned short *)malloc(N_SIZE * N_SIZE * sizeof(unsigned short));
+    CLEED_TEST_ASSERT(data != NULL);
+    for (int y = 0; y < N_SIZE; y++)
+        for (int x = 0; x < N_SIZE; x++)
+            data[y * N_SIZE + x] = (abs(y - N_SIZE / 2) >= N_FAR) ? 2 : 1;
+    mat.rows = N_SIZE;
+    mat.cols = N_SIZE;
+    mat.imagedata = (uint32 *)data;
+
+    /* pixels of the spot and background ellipses (angle 0) */
+    for (int j = -8; j <= 8; j++) {
+        for (int i = -8; i <= 8; i++) {
+            float ell = i * i / (h * h) + j * j / (v * v);
+            if (ell <= 1.f) e_count++;
+            else if (ell <= verh * verh) {
+                b_count++;
+                if (abs(j) >= N_FAR) n_far++;
+            }
+        }
+    }
+    CLEED_TEST_ASSERT(e_count == 25);
+    CLEED_TEST_ASSERT(b_count == 30);
+    CLEED_TEST_ASSERT(n_far == 8);
+
+    memset(&spot, 0, sizeof(Spot));
+    spot.xx = N_SIZE / 2;
+    spot.yy = N_SIZE / 2;
+    scale.xx = h;
+    scale.yy = v;
+    CLEED_TEST_ASSERT(get_int(1, &spot, &mat, NULL, &scale, 0.f, 1.f, BG_YES,
+                              0.f, QUICK, verh, 0.5f, 0.5f) == 0);
+    CLEED_TEST_ASSERT(!(spot.control & SPOT_OUT));
+
+    /* spot: all pixels 1; background: 1 plus 1 for the rows |j| >= N_FAR */
+    expected = e_count - (double)(b_count + n_far) * e_count / b_count;
+    CLEED_TEST_ASSERT_NEAR(spot.intensity, expected, 1e-4);
+
+    free(data);
+    return 0;
+}
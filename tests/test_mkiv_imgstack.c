@@ -0,0 +1,202 @@
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+#if !defined(_WIN32)
+// cppcheck-suppress missingIncludeSystem
+#include <sys/wait.h>
+// cppcheck-suppress missingIncludeSystem
+#include <unistd.h>
+#endif
+
+#include "mkiv.h"
+#include "test_support.h"
+
+#define WIDTH  37
+#define HEIGHT 23
+#define N_FRAME 3
+
+static const char *stack_path = "imgstack_test.stk";
+static const char *cur_path = "imgstack_test.cur";
+static const char *bad_path = "imgstack_test_bad.stk";
+
+static void frame_name(char *name, int numb)
+{
+    sprintf(name, "imgstack_test.%03d", numb);
+}
+
+static int write_frames(void)
+{
+    ImageMatrix mat;
+    unsigned short *data;
+    char name[64];
+    FILE *f;
+
+    data = (unsigned short *)malloc(WIDTH * HEIGHT * sizeof(unsigned short));
+    if (data == NULL) return -1;
+    mat.rows = WIDTH;
+    mat.cols = HEIGHT;
+    mat.imagedata = (uint32 *)data;
+
+    for (int k = 0; k < N_FRAME; k++) {
+        for (int i = 0; i < WIDTH * HEIGHT; i++) {
+            data[i] = (unsigned short)((i * (k + 3) + 7 * k) % 251);
+        }
+        frame_name(name, 10 + k);
+        out_tif(&mat, name);
+    }
+    free(data);
+
+    /* beam currents of frames 10 and 12 only */
+    if ((f = fopen(cur_path, "w")) == NULL) return -1;
+    fprintf(f, "10.000000\t1.500000\n12.000000\t2.500000\n");
+    fclose(f);
+    return 0;
+}
+
+#if !defined(_WIN32)
+static void put_u32(unsigned char *p, unsigned long v)
+{
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)((v >> (8 * i)) & 0xFF);
+    }
+}
+
+/* Copy of the stack with the 32 bit header value at offset off replaced;
+   imgstack_open must reject it with exit(1) rather than crash or map it. */
+static int open_fails(const unsigned char *stk, size_t size, int off,
+                      unsigned long value)
+{
+    unsigned char *bad;
+    FILE *f;
+    pid_t pid;
+    int status;
+
+    if ((bad = (unsigned char *)malloc(size)) == NULL) return 0;
+    memcpy(bad, stk, size);
+    put_u32(bad + off, value);
+    f = fopen(bad_path, "wb");
+    if (f == NULL || fwrite(bad, 1, size, f) != size) {
+        if (f != NULL) fclose(f);
+        free(bad);
+        return 0;
+    }
+    fclose(f);
+    free(bad);
+
+    fflush(NULL);
+    if ((pid = fork()) == -1) return 0;
+    if (pid == 0) {
+        if (freopen("/dev/null", "w", stderr) == NULL) _exit(2);
+        (void)imgstack_open((char *)bad_path, 1);
+        _exit(0);
+    }
+    if (waitpid(pid, &status, 0) != pid) return 0;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 1;
+}
+
+static int test_corrupt_headers(void)
+{
+    unsigned char *stk;
+    size_t size;
+    FILE *f;
+
+    f = fopen(stack_path, "rb");
+    CLEED_TEST_ASSERT(f != NULL);
+    fseek(f, 0L, SEEK_END);
+    size = (size_t)ftell(f);
+    fseek(f, 0L, SEEK_SET);
+    stk = (unsigned char *)malloc(size);
+    CLEED_TEST_ASSERT(stk != NULL);
+    CLEED_TEST_ASSERT(fread(stk, 1, size, f) == size);
+    fclose(f);
+
+    /* width, height, n_frame of 0 or above INT_MAX */
+    CLEED_TEST_ASSERT(open_fails(stk, size, 12, 0));
+    CLEED_TEST_ASSERT(open_fails(stk, size, 16, 0));
+    CLEED_TEST_ASSERT(open_fails(stk, size, 20, 0));
+    CLEED_TEST_ASSERT(open_fails(stk, size, 12, 0x80000000UL));
+    CLEED_TEST_ASSERT(open_fails(stk, size, 16, 0xFFFFFFFFUL));
+    CLEED_TEST_ASSERT(open_fails(stk, size, 20, 0x80000000UL));
+
+    /* sizes whose product wraps around in 32 bit (or 64 bit with n_frame) */
+    CLEED_TEST_ASSERT(open_fails(stk, size, 12, 0x10000UL));
+    CLEED_TEST_ASSERT(open_fails(stk, size, 16, 0x7FFFFFFFUL));
+    CLEED_TEST_ASSERT(open_fails(stk, size, 20, 0x7FFFFFFFUL));
+
+    /* frames beyond the end of the file or inside the frame table */
+    CLEED_TEST_ASSERT(open_fails(stk, size, 20, N_FRAME + 1));
+    CLEED_TEST_ASSERT(open_fails(stk, size, 28, 0xFFFFF000UL));
+    CLEED_TEST_ASSERT(open_fails(stk, size, 28, 64));
+
+    free(stk);
+    (void)remove(bad_path);
+    return 0;
+}
+#endif
+
+int main(void)
+{
+    struct imgstack *st;
+    tifvalues tif;
+    ImageMatrix ref, mat;
+    char name[64];
+    float energy, current;
+    unsigned short *pix, *ref_pix;
+
+    CLEED_TEST_ASSERT(write_frames() == 0);
+
+    frame_name(name, 10);
+    CLEED_TEST_ASSERT(imgstack_convert((char *)stack_path, name, 10, 12, 1.,
+                                       (char *)cur_path) == N_FRAME);
+
+    st = imgstack_open((char *)stack_path, 1);
+    CLEED_TEST_ASSERT(st != NULL);
+
+    memset(&tif, 0, sizeof(tif));
+    ref.imagedata = NULL;
+    mat.imagedata = NULL;
+    for (int k = 0; k < N_FRAME; k++) {
+        frame_name(name, 10 + k);
+        readtif(&tif, name);
+        conv_tif2mat(&tif, &ref);
+
+        CLEED_TEST_ASSERT(imgstack_frame(st, 10 + k, &mat, &energy, &current) == 0);
+        CLEED_TEST_ASSERT(mat.rows == ref.rows && mat.cols == ref.cols);
+        CLEED_TEST_ASSERT(memcmp(mat.imagedata, ref.imagedata,
+                                 WIDTH * HEIGHT * sizeof(unsigned short)) == 0);
+        CLEED_TEST_ASSERT_NEAR(energy, 10. + k, 1e-6);
+        CLEED_TEST_ASSERT_NEAR(current, (k == 1) ? 0. : 1.5 + 0.5 * k, 1e-6);
+    }
+
+    /* drawing into a frame changes neither the stack nor a frame that is
+       requested again */
+    pix = (unsigned short *)mat.imagedata;
+    for (int i = 0; i < WIDTH * HEIGHT; i++) {
+        pix[i] = 0xFFFF;
+    }
+    CLEED_TEST_ASSERT(imgstack_frame(st, 12, &mat, NULL, NULL) == 0);
+    pix = (unsigned short *)mat.imagedata;
+    ref_pix = (unsigned short *)ref.imagedata;
+    CLEED_TEST_ASSERT(memcmp(pix, ref_pix,
+                             WIDTH * HEIGHT * sizeof(unsigned short)) == 0);
+
+    CLEED_TEST_ASSERT(imgstack_frame(st, 13, &mat, NULL, NULL) == -1);
+
+    imgstack_close(st);
+#if !defined(_WIN32)
+    CLEED_TEST_ASSERT(test_corrupt_headers() == 0);
+#endif
+    free(tif.buf);
+    free(ref.imagedata);
+
+    for (int k = 0; k < N_FRAME; k++) {
+        frame_name(name, 10 + k);
+        (void)remove(name);
+    }
+    (void)remove(stack_path);
+    (void)remove(cur_path);
+    return 0;
+}
@@ -0,0 +1,112 @@
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "mkiv.h"
+#include "test_support.h"
+
+#define N_DESI  3
+#define N_FRAME 100
+
+static char *read_file(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    long n;
+    char *buf;
+
+    if (fp == NULL) return NULL;
+    fseek(fp, 0, SEEK_END);
+    n = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = (char *)malloc(n + 1);
+    if (buf != NULL && fread(buf, 1, n, fp) == (size_t)n) {
+        buf[n] = '\0';
+    } else {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    return buf;
+}
+
+int main(void)
+{
+    struct lindex desi[N_DESI] = { {0., 0., 0}, {1., 0., 0}, {0.5, -1., 0} };
+    struct ivwrite *iw;
+    FILE *iv_ref, *cur_ref, *smcur_ref;
+    float inty[N_DESI], energy;
+    char iv_path[] = "ivwrite.ivdat", cur_path[] = "ivwrite.raw",
+         smcur_path[] = "ivwrite.smo";
+    char *got, *want;
+    int i, k;
+
+    /* expected output written directly, as mkiv did before */
+    iv_ref = fopen("ivwrite_ref.ivdat", "w");
+    cur_ref = fopen("ivwrite_ref.raw", "w");
+    smcur_ref = fopen("ivwrite_ref.smo", "w");
+    CLEED_TEST_ASSERT(iv_ref != NULL && cur_ref != NULL && smcur_ref != NULL);
+    fprintf(iv_ref, " h     ");
+    for (k = 0; k < N_DESI; k++) fprintf(iv_ref, "%10.2f", desi[k].lind1);
+    fprintf(iv_ref, "\n k     ");
+    for (k = 0; k < N_DESI; k++) fprintf(iv_ref, "%10.2f", desi[k].lind2);
+    fprintf(iv_ref, "\n nenergy\n");
+
+    iw = ivwrite_open(iv_path, cur_path, smcur_path, N_DESI, desi);
+    CLEED_TEST_ASSERT(iw != NULL);
+
+    for (i = 0; i < N_FRAME; i++) {
+        energy = 50.f + 2.f * i;
+        for (k = 0; k < N_DESI; k++) {
+            inty[k] = (k == 2 && i % 7 == 0) ? INT_OUT : 0.37f * i + 11.f * k;
+        }
+        ivwrite_frame(iw, energy, 100.f + i, 99.5f + i, inty, i % 10 == 0);
+
+        /* the results are copied: the buffer may be reused at once */
+        for (k = 0; k < N_DESI; k++) inty[k] = -1.f;
+
+        fprintf(cur_ref, "%f\t%f\n", energy, 100.f + i);
+        fprintf(smcur_ref, "%f\t%f\n", energy, 99.5f + i);
+        fprintf(iv_ref, "%6.1f", energy);
+        for (k = 0; k < N_DESI; k++) {
+            fprintf(iv_ref, " %10.5f",
+                    (k == 2 && i % 7 == 0) ? INT_OUT : 0.37f * i + 11.f * k);
+        }
+        fprintf(iv_ref, "\n");
+    }
+    ivwrite_close(iw);
+    fclose(iv_ref);
+    fclose(cur_ref);
+    fclose(smcur_ref);
+
+    got = read_file("ivwrite.ivdat");
+    want = read_file("ivwrite_ref.ivdat");
+    CLEED_TEST_ASSERT(got != NULL && want != NULL);
+    CLEED_TEST_ASSERT(strcmp(got, want) == 0);
+    free(got);
+    free(want);
+
+    got = read_file("ivwrite.raw");
+    want = read_file("ivwrite_ref.raw");
+    CLEED_TEST_ASSERT(got != NULL && want != NULL);
+    CLEED_TEST_ASSERT(strcmp(got, want) == 0);
+    free(got);
+    free(want);
+
+    got = read_file("ivwrite.smo");
+    want = read_file("ivwrite_ref.smo");
+    CLEED_TEST_ASSERT(got != NULL && want != NULL);
+    CLEED_TEST_ASSERT(strcmp(got, want) == 0);
+    free(got);
+    free(want);
+
+    remove("ivwrite.ivdat");
+    remove("ivwrite.raw");
+    remove("ivwrite.smo");
+    remove("ivwrite_ref.ivdat");
+    remove("ivwrite_ref.raw");
+    remove("ivwrite_ref.smo");
+    return 0;
+}
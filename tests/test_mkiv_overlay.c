@@ -0,0 +1,135 @@
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "mkiv.h"
+#include "mkiv_synth.h"
+#include "test_support.h"
+
+#define N_SPOT_MAX 49
+#define N_FRAME    5
+
+static char *read_file(const char *path, long *n)
+{
+    FILE *fp = fopen(path, "rb");
+    char *buf;
+
+    if (fp == NULL) return NULL;
+    fseek(fp, 0, SEEK_END);
+    *n = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = (char *)malloc(*n + 1);
+    if (buf != NULL && fread(buf, 1, *n, fp) != (size_t)*n) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    return buf;
+}
+
+static int same_file(const char *path1, const char *path2)
+{
+    long n1, n2;
+    char *b1 = read_file(path1, &n1), *b2 = read_file(path2, &n2);
+    int same = (b1 != NULL && b2 != NULL && n1 == n2 &&
+                memcmp(b1, b2, n1) == 0);
+
+    free(b1);
+    free(b2);
+    return same;
+}
+
+/* The annotated images drawn by the overlay thread are identical to
+   images drawn directly, and the analysed frame is not changed. */
+int main(void)
+{
+    struct mkiv_synth syn;
+    struct overlay *ov;
+    ImageMatrix mat, copy;
+    Spot spot[N_SPOT_MAX];
+    Vector scale;
+    Coord center;
+    unsigned short *data, *orig;
+    char ima_path[] = "overlay_ima.tif", ref_path[] = "overlay_ref.tif";
+    char ima_direct[] = "overlay_ima_direct.tif",
+         ref_direct[] = "overlay_ref_direct.tif";
+    size_t n_size;
+    float x, y, energy = 0.f;
+    int nspot, i;
+    long n_png;
+    char *png;
+
+    mkiv_synth_default(&syn);
+    n_size = (size_t)syn.width * syn.height * sizeof(unsigned short);
+    data = (unsigned short *)malloc(n_size);
+    orig = (unsigned short *)malloc(n_size);
+    CLEED_TEST_ASSERT(data != NULL && orig != NULL);
+    mat.rows = syn.width;
+    mat.cols = syn.height;
+    mat.imagedata = (uint32 *)data;
+    center.xx = (int)syn.origin_x;
+    center.yy = (int)syn.origin_y;
+    scale.xx = scale.yy = 6.f;
+
+    ov = overlay_open(ima_path, ref_path, 2, NULL, &center, 240.f, 20.f);
+    CLEED_TEST_ASSERT(ov != NULL);
+
+    for (i = 0; i < N_FRAME; i++) {
+        energy = 80.f + 10.f * i;
+        mkiv_synth_frame(&syn, energy, data);
+        nspot = 0;
+        for (int h = -3; h <= 3; h++) {
+            for (int k = -3; k <= 3; k++) {
+                if (!mkiv_synth_spot_pos(&syn, h, k, energy, &x, &y)) continue;
+                memset(spot + nspot, 0, sizeof(Spot));
+                spot[nspot].lind1 = h;
+                spot[nspot].lind2 = k;
+                spot[nspot].xx = spot[nspot].x0 = x;
+                spot[nspot].yy = spot[nspot].y0 = y;
+                spot[nspot].control = (h == 0) ? SPOT_GOOD_S2N : 0;
+                nspot++;
+            }
+        }
+        memcpy(orig, data, n_size);
+        CLEED_TEST_ASSERT(overlay_frame(ov, &mat, nspot, spot, &scale,
+                                        0.f, 1.4f, 8.f) >= 0);
+        CLEED_TEST_ASSERT(memcmp(orig, data, n_size) == 0);
+    }
+    overlay_close(ov);
+
+    /* last frame drawn directly */
+    copy.rows = mat.rows;
+    copy.cols = mat.cols;
+    copy.imagedata = (uint32 *)orig;
+    drawbound(&copy, NULL, &center, 240.f, 20.f, -1, ima_direct);
+    drawell(nspot, spot, &copy, &scale, 0.f, 1.4f);
+    mark_reflex(nspot, spot, &copy, THICK, 8.f, WHITE, 0, ref_direct);
+
+    CLEED_TEST_ASSERT(same_file(ima_path, ima_direct));
+    CLEED_TEST_ASSERT(same_file(ref_path, ref_direct));
+
+    /* PNG (only if built with libpng) */
+    png = read_file("overlay_ima.png", &n_png);
+    if (png != NULL) {
+        CLEED_TEST_ASSERT(n_png > 24);
+        CLEED_TEST_ASSERT(memcmp(png + 1, "PNG", 3) == 0);
+        /* IHDR: width and height (big endian) */
+        CLEED_TEST_ASSERT(((unsigned char)png[18] << 8 |
+                           (unsigned char)png[19]) == syn.width / 2);
+        CLEED_TEST_ASSERT(((unsigned char)png[22] << 8 |
+                           (unsigned char)png[23]) == syn.height / 2);
+        free(png);
+        remove("overlay_ima.png");
+    }
+
+    remove(ima_path);
+    remove(ref_path);
+    remove(ima_direct);
+    remove(ref_direct);
+    free(data);
+    free(orig);
+    return 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * mkiv regression test and benchmark on a synthetic LEED image series.
+ *
+ * The frames of mkiv_synth are written as 16 bit TIFF files and run
+ * through the stages of the mkiv energy loop (readtif/conv_tif2mat,
+ * calca/calcspotpos, fimax4, calcoi, get_int, calcbase). The extracted
+ * IV curves and spot positions are compared with the ground truth and
+ * the time of each stage is reported.
+ *
+ * Usage: test_mkiv_pipeline [max_ms_per_frame [n_frame [size]]]
+ *   max_ms_per_frame: fail if the mean time per frame (all stages)
+ *                     exceeds this value (0: no limit) [default: 0]
+ */
+
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+// cppcheck-suppress missingIncludeSystem
+#include <time.h>
+
+#include "mkiv.h"
+#include "mkiv_synth.h"
+#include "test_support.h"
+
+#define E_START  60.f
+#define E_STEP   2.f
+#define N_BEAM_MAX 25
+#define SPOT_MAX 2000
+
+enum { ST_READ, ST_LATTICE, ST_FIMAX, ST_CALCOI, ST_GETINT, ST_CALCBASE,
+       N_STAGE };
+static const char *stage_name[N_STAGE] = {
+    "readtif", "calca/calcspotpos", "fimax4", "calcoi", "get_int", "calcbase"
+};
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1.e3 + ts.tv_nsec * 1.e-6;
+}
+
+static void frame_name(char *name, int numb)
+{
+    sprintf(name, "mkiv_pipeline.%03d", numb);
+}
+
+int main(int argc, char *argv[])
+{
+    struct mkiv_synth syn;
+    double max_ms = (argc > 1) ? atof(argv[1]) : 0.;
+    int n_frame = (argc > 2) ? atoi(argv[2]) : 41;
+    double t_stage[N_STAGE], t0, t_frame;
+    tifvalues tif;
+    ImageMatrix mat, mask;
+    Spot *spot, *aux;
+    Vector a[3], newa[3], scale, rel_scale;
+    unsigned short *data;
+    char name[64];
+    int nspot, naux, n_beam, n_found, numb;
+    int beam_h[N_BEAM_MAX], beam_k[N_BEAM_MAX];
+    double sum_et[N_BEAM_MAX], sum_tt[N_BEAM_MAX], sum_ee[N_BEAM_MAX];
+    int n_pt[N_BEAM_MAX];
+    double pos_err, max_pos_err = 0.;
+    float kappa, en_old, energy, range, radius, tx, ty;
+    float o_x, o_y, a1_x, a1_y, a2_x, a2_y;
+
+    /* mkiv.var settings */
+    const float range_min = 4.f, rel_range = 0.08f, scale_min = 8.f;
+    const float verh = 1.4f, acci = 0.9f, accb = 0.7f, angle = 0.f;
+    const float s2n_good = 0.5f, s2n_ref = 1.2f, bas_rat = 0.7f;
+    const int step = 1, distance = 60, trip_max = 599;
+
+    mkiv_synth_default(&syn);
+    syn.order = 6;
+    if (argc > 3) {
+        syn.width = syn.height = atoi(argv[3]);
+        syn.origin_x = syn.origin_y = syn.width / 2.f;
+    }
+    rel_scale.xx = rel_scale.yy = 0.12f;
+
+    /* image series */
+    data = (unsigned short *)malloc((size_t)syn.width * syn.height *
+                                    sizeof(unsigned short));
+    CLEED_TEST_ASSERT(data != NULL);
+    for (int i = 0; i < n_frame; i++) {
+        energy = E_START + i * E_STEP;
+        mkiv_synth_frame(&syn, energy, data);
+        frame_name(name, (int)energy);
+        CLEED_TEST_ASSERT(mkiv_synth_write_tif(name, syn.width, syn.height,
+                                               data) == 0);
+    }
+
+    /* mask: whole image visible */
+    for (int i = 0; i < syn.width * syn.height; i++) {
+        data[i] = 1;
+    }
+    mask.rows = syn.width;
+    mask.cols = syn.height;
+    mask.imagedata = (uint32 *)data;
+
+    /* beams compared with the ground truth */
+    n_beam = 0;
+    for (int h = -2; h <= 2; h++) {
+        for (int k = -2; k <= 2; k++) {
+            beam_h[n_beam] = h;
+            beam_k[n_beam] = k;
+            sum_et[n_beam] = sum_tt[n_beam] = sum_ee[n_beam] = 0.;
+            n_pt[n_beam] = 0;
+            n_beam++;
+        }
+    }
+
+    /* basis at the first energy (reference spots), origin off by 1 pixel */
+    mkiv_synth_basis(&syn, E_START, &o_x, &o_y, &a1_x, &a1_y, &a2_x, &a2_y);
+    a[0].xx = o_x + 1.f;
+    a[0].yy = o_y - 1.f;
+    a[1].xx = a1_x;
+    a[1].yy = a1_y;
+    a[2].xx = a2_x;
+    a[2].yy = a2_y;
+    for (int i = 0; i < 3; i++) {
+        a[i].len = hypotf(a[i].xx, a[i].yy);
+    }
+    en_old = E_START;
+
+    spot = (Spot *)calloc(SPOT_MAX, sizeof(Spot));
+    aux = (Spot *)calloc(SPOT_MAX, sizeof(Spot));
+    CLEED_TEST_ASSERT(spot != NULL && aux != NULL);
+    memset(&tif, 0, sizeof(tif));
+    mat.imagedata = NULL;
+    for (int s = 0; s < N_STAGE; s++) {
+        t_stage[s] = 0.;
+    }
+
+    for (int i = 0; i < n_frame; i++) {
+        energy = E_START + i * E_STEP;
+        numb = (int)energy;
+
+        t0 = now_ms();
+        frame_name(name, numb);
+        readtif(&tif, name);
+        free(mat.imagedata);
+        mat.imagedata = NULL;
+        conv_tif2mat(&tif, &mat);
+        t_stage[ST_READ] += now_ms() - t0;
+
+        t0 = now_ms();
+        calca(&kappa, &en_old, energy, a, &range, range_min, rel_range,
+              &scale, scale_min, rel_scale);
+        calcspotpos(a, 0, NULL, SPOT_MAX, &nspot, spot, 0, NULL, &mask,
+                    (float)syn.width, 0.f, &radius, energy, syn.ratio,
+                    syn.k_10);
+        for (int k = 0; k < nspot; k++) {
+            spot[k].control = 0;
+        }
+        t_stage[ST_LATTICE] += now_ms() - t0;
+
+        t0 = now_ms();
+        fimax4(nspot, spot, step, range, &mat);
+        t_stage[ST_FIMAX] += now_ms() - t0;
+
+        t0 = now_ms();
+        calcoi(nspot, spot, range, &mat);
+        t_stage[ST_CALCOI] += now_ms() - t0;
+
+        t0 = now_ms();
+        get_int(nspot, spot, &mat, &mask, &scale, angle,
+                mkiv_synth_current(&syn, energy), BG_YES, s2n_good, QUICK,
+                verh, acci, accb);
+        t_stage[ST_GETINT] += now_ms() - t0;
+
+        /* compare with ground truth */
+        for (int b = 0; b < n_beam; b++) {
+            for (int k = 0; k < nspot; k++) {
+                if (fabsf(spot[k].lind1 - beam_h[b]) > TOLERANCE ||
+                    fabsf(spot[k].lind2 - beam_k[b]) > TOLERANCE ||
+                    (spot[k].control & SPOT_OUT) ||
+                    !(spot[k].control & SPOT_GOOD_S2N)) {
+                    continue;
+                }
+                double t = mkiv_synth_iv(beam_h[b], beam_k[b], energy);
+                sum_et[b] += spot[k].intensity * t;
+                sum_tt[b] += t * t;
+                sum_ee[b] += (double)spot[k].intensity * spot[k].intensity;
+                n_pt[b]++;
+                if (mkiv_synth_spot_pos(&syn, beam_h[b], beam_k[b], energy,
+                                        &tx, &ty)) {
+                    pos_err = hypot(spot[k].xx - tx, spot[k].yy - ty);
+                    if (pos_err > max_pos_err) max_pos_err = pos_err;
+                }
+            }
+        }
+
+        /* basis recalibration with the good spots */
+        t0 = now_ms();
+        naux = 0;
+        for (int k = 0; k < nspot; k++) {
+            if (spot[k].s2n >= s2n_ref && !(spot[k].control & SPOT_OUT)) {
+                aux[naux++] = spot[k];
+            }
+        }
+        if (naux >= 3) {
+            newa[0] = a[0];
+            if (calcbase(naux, aux, newa, syn.ratio, distance, trip_max, 0.)) {
+                for (int k = 0; k < 3; k++) {
+                    a[k].xx = (1.f - bas_rat) * a[k].xx + bas_rat * newa[k].xx;
+                    a[k].yy = (1.f - bas_rat) * a[k].yy + bas_rat * newa[k].yy;
+                    a[k].len = hypotf(a[k].xx, a[k].yy);
+                }
+            }
+        }
+        t_stage[ST_CALCBASE] += now_ms() - t0;
+    }
+
+    /* timing */
+    t_frame = 0.;
+    printf("\nmkiv pipeline: %d frames of %dx%d pixels\n",
+           n_frame, syn.width, syn.height);
+    for (int s = 0; s < N_STAGE; s++) {
+        printf("  %-18s %9.2f ms  %8.3f ms/frame\n", stage_name[s],
+               t_stage[s], t_stage[s] / n_frame);
+        t_frame += t_stage[s] / n_frame;
+    }
+    printf("  %-18s %9.2f ms  %8.3f ms/frame\n", "total",
+           t_frame * n_frame, t_frame);
+
+    /* IV curves: intensity scale 1 (get_int is normalised to the beam
+       current) and relative deviation from the ground truth */
+    n_found = 0;
+    for (int b = 0; b < n_beam; b++) {
+        double s, dev;
+
+        if (sum_tt[b] <= 0.) continue;
+        s = sum_et[b] / sum_tt[b];
+        dev = sqrt(fmax(sum_ee[b] - 2. * s * sum_et[b] + s * s * sum_tt[b],
+                        0.) / (s * s * sum_tt[b]));
+        printf("  beam (%2d,%2d): %3d frames  scale %.4f  rel. deviation %.4f\n",
+               beam_h[b], beam_k[b], n_pt[b], s, dev);
+        CLEED_TEST_ASSERT(fabs(s - 1.) < 0.02);
+        CLEED_TEST_ASSERT(dev < 0.03);
+        if (n_pt[b] == n_frame) n_found++;
+    }
+    printf("  max. position error %.3f pixels\n", max_pos_err);
+    CLEED_TEST_ASSERT(n_found >= n_beam / 2);
+    CLEED_TEST_ASSERT(max_pos_err < 1.);
+
+    /* recalibrated basis at the last energy */
+    mkiv_synth_basis(&syn, energy, &o_x, &o_y, &a1_x, &a1_y, &a2_x, &a2_y);
+    printf("  basis deviation: orig %.3f  a1 %.3f  a2 %.3f pixels\n",
+           hypot(a[0].xx - o_x, a[0].yy - o_y),
+           hypot(a[1].xx - a1_x, a[1].yy - a1_y),
+           hypot(a[2].xx - a2_x, a[2].yy - a2_y));
+    CLEED_TEST_ASSERT(hypot(a[0].xx - o_x, a[0].yy - o_y) < 1.);
+    CLEED_TEST_ASSERT(hypot(a[1].xx - a1_x, a[1].yy - a1_y) < 1.);
+    CLEED_TEST_ASSERT(hypot(a[2].xx - a2_x, a[2].yy - a2_y) < 1.);
+
+    if (max_ms > 0.) {
+        CLEED_TEST_ASSERT(t_frame <= max_ms);
+    }
+
+    for (int i = 0; i < n_frame; i++) {
+        frame_name(name, (int)(E_START + i * E_STEP));
+        (void)remove(name);
+    }
+    free(tif.buf);
+    free(mat.imagedata);
+    free(spot);
+    free(aux);
+    free(data);
+    return 0;
+}
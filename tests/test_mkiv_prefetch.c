@@ -0,0 +1,158 @@
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+#if !defined(_WIN32)
+// cppcheck-suppress missingIncludeSystem
+#include <sys/wait.h>
+// cppcheck-suppress missingIncludeSystem
+#include <unistd.h>
+#define PREFETCH_THREAD
+#endif
+
+#include "mkiv.h"
+#include "mkiv_synth.h"
+#include "test_support.h"
+
+#define SIZE     96
+#define N_START  10
+#define N_STOP   19
+#define N_MISS   15         /* frame removed for the last loop */
+#define DEPTH    3
+
+static void frame_name(char *name, int numb)
+{
+    sprintf(name, "prefetch_test.%03d", numb);
+}
+
+static int write_frames(void)
+{
+    struct mkiv_synth syn;
+    unsigned short *data;
+    char name[64];
+
+    mkiv_synth_default(&syn);
+    syn.width = syn.height = SIZE;
+    syn.origin_x = syn.origin_y = SIZE / 2.f;
+    data = (unsigned short *)malloc(SIZE * SIZE * sizeof(unsigned short));
+    if (data == NULL) return -1;
+    for (int numb = N_START; numb <= N_STOP; numb++) {
+        mkiv_synth_frame(&syn, 10.f * numb, data);
+        frame_name(name, numb);
+        if (mkiv_synth_write_tif(name, SIZE, SIZE, data) != 0) {
+            free(data);
+            return -1;
+        }
+    }
+    free(data);
+    return 0;
+}
+
+/* frame numb through prefetch_frame is the frame of readtif+conv_tif2mat;
+   returns the value of prefetch_frame, -1 if the frames differ */
+static int same_frame(struct prefetch *pf, int numb)
+{
+    static tifvalues tif;
+    ImageMatrix ref, mat;
+    char name[64];
+    int ret;
+
+    ref.imagedata = NULL;
+    mat.imagedata = NULL;
+    frame_name(name, numb);
+    readtif(&tif, name);
+    conv_tif2mat(&tif, &ref);
+
+    ret = prefetch_frame(pf, numb, &mat);
+    if (mat.rows != ref.rows || mat.cols != ref.cols ||
+        memcmp(mat.imagedata, ref.imagedata,
+               (size_t)ref.rows * ref.cols * sizeof(unsigned short)) != 0)
+        ret = -1;
+    free(ref.imagedata);
+    free(mat.imagedata);
+    return ret;
+}
+
+#ifdef PREFETCH_THREAD
+/* Energy loop with frame N_MISS missing, in a child process (readtif exits
+   on a missing file): the frames before N_MISS must be passed although
+   the reading thread has already come across the missing file; the child
+   exits with 1 when the loop reaches N_MISS, with 3 if a frame differs. */
+static int missing_fails(void)
+{
+    struct prefetch *pf;
+    ImageMatrix mat;
+    char name[64];
+    pid_t pid;
+    int status;
+
+    fflush(NULL);
+    if ((pid = fork()) == -1) return 0;
+    if (pid == 0) {
+        if (freopen("/dev/null", "w", stderr) == NULL) _exit(2);
+        frame_name(name, N_START);
+        pf = prefetch_open(name, N_START, N_STOP, 1.f, 2 * DEPTH);
+        for (int numb = N_START; numb < N_MISS; numb++) {
+            if (same_frame(pf, numb) != 1) _exit(3);
+        }
+        mat.imagedata = NULL;
+        (void)prefetch_frame(pf, N_MISS, &mat);
+        _exit(0);
+    }
+    if (waitpid(pid, &status, 0) != pid) return 0;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 1;
+}
+#endif
+
+int main(void)
+{
+    struct prefetch *pf;
+    char name[64];
+    /* 1: prefetched, 0: read directly */
+#ifdef PREFETCH_THREAD
+    const int ahead = 1;
+#else
+    const int ahead = 0;
+#endif
+
+    CLEED_TEST_ASSERT(write_frames() == 0);
+
+    /* in order, repeated (a frame is analysed again if the recalibration
+       of the basis fails) and out of order */
+    frame_name(name, N_START);
+    pf = prefetch_open(name, N_START, N_STOP, 1.f, DEPTH);
+    CLEED_TEST_ASSERT(same_frame(pf, 10) == ahead);
+    CLEED_TEST_ASSERT(same_frame(pf, 11) == ahead);
+    CLEED_TEST_ASSERT(same_frame(pf, 11) == ahead);
+    CLEED_TEST_ASSERT(same_frame(pf, 12) == ahead);
+    CLEED_TEST_ASSERT(same_frame(pf, 12) == ahead);
+    CLEED_TEST_ASSERT(same_frame(pf, 13) == ahead);
+    CLEED_TEST_ASSERT(same_frame(pf, 11) == 0);
+    CLEED_TEST_ASSERT(same_frame(pf, 16) == ahead);
+    CLEED_TEST_ASSERT(same_frame(pf, 14) == 0);
+    CLEED_TEST_ASSERT(same_frame(pf, 19) == ahead);
+    CLEED_TEST_ASSERT(same_frame(pf, 17) == 0);
+    prefetch_close(pf);
+
+    /* without read-ahead */
+    pf = prefetch_open(name, N_START, N_STOP, 1.f, 0);
+    for (int numb = N_START; numb <= N_STOP; numb++) {
+        CLEED_TEST_ASSERT(same_frame(pf, numb) == 0);
+    }
+    prefetch_close(pf);
+
+    /* a missing file terminates the loop only when it reaches the frame */
+    frame_name(name, N_MISS);
+    (void)remove(name);
+#ifdef PREFETCH_THREAD
+    CLEED_TEST_ASSERT(missing_fails());
+#endif
+
+    for (int numb = N_START; numb <= N_STOP; numb++) {
+        frame_name(name, numb);
+        (void)remove(name);
+    }
+    return 0;
+}
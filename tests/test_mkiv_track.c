@@ -0,0 +1,86 @@
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "mkiv.h"
+#include "test_support.h"
+
+#define N_SPOT 4
+
+/* true position of spot k: lattice position plus a deviation that
+   changes linearly with u = 1/sqrt(E), origin drifting with u */
+static void true_pos(int k, float u, float *x, float *y)
+{
+    *x = 300.f + 40.f * u + (k + 1) * 900.f * u + 2.f + 30.f * u * k;
+    *y = 200.f - 25.f * u + k * 600.f * u - 1.f;
+}
+
+static void lattice_pos(int k, Vector a[], float u, float *x, float *y)
+{
+    *x = a[0].xx + (k + 1) * 900.f * u;
+    *y = a[0].yy + k * 600.f * u;
+}
+
+int main(void)
+{
+    struct track *tr = track_init(2.);
+    Spot spot[N_SPOT];
+    Vector a[3];
+    float energy, u, x, y;
+    int n_tracked = 0;
+
+    memset(a, 0, sizeof(a));
+    a[0].xx = 300.f;
+    a[0].yy = 200.f;
+
+    for (energy = 50.; energy <= 120.; energy += 2.) {
+        u = 1.f / sqrtf(energy);
+
+        track_origin(tr, a, energy);
+
+        /* calcspotpos */
+        memset(spot, 0, sizeof(spot));
+        for (int k = 0; k < N_SPOT; k++) {
+            spot[k].lind1 = (float)k;
+            spot[k].lind2 = 1.f;
+            lattice_pos(k, a, u, &spot[k].x0, &spot[k].y0);
+            spot[k].xx = spot[k].x0;
+            spot[k].yy = spot[k].y0;
+        }
+
+        n_tracked = track_predict(tr, N_SPOT, spot, 15.);
+
+        /* predictions of tracked spots are close to the true position */
+        for (int k = 0; k < N_SPOT; k++) {
+            true_pos(k, u, &x, &y);
+            if (spot[k].range > 0.) {
+                CLEED_TEST_ASSERT(hypotf(spot[k].xx - x, spot[k].yy - y) <
+                                  spot[k].range);
+            }
+            /* spot found exactly (fimax4/calcoi) with good s/n; spot 3
+               is never good enough */
+            spot[k].xx = x;
+            spot[k].yy = y;
+            spot[k].s2n = (k == 3) ? 0.1f : 2.f;
+        }
+        track_measure(tr, N_SPOT, spot, 0.5);
+
+        /* recalibrated origin */
+        a[0].xx = 300.f + 40.f * u;
+        a[0].yy = 200.f - 25.f * u;
+        track_accept(tr, a);
+    }
+
+    /* all spots except spot 3 are tracked with the minimum radius */
+    CLEED_TEST_ASSERT(n_tracked == N_SPOT - 1);
+    for (int k = 0; k < N_SPOT - 1; k++) {
+        CLEED_TEST_ASSERT_NEAR(spot[k].range, 2., 1e-6);
+    }
+    CLEED_TEST_ASSERT(spot[3].range <= 0.);
+
+    track_free(tr);
+    return 0;
+}
@@ -0,0 +1,242 @@
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "crfac.h"
+#include "cleed_ivbin.h"
+#include "test_support.h"
+
+#define N_BEAM 3
+#define N_ENG  5
+
+static const double beam_ind[N_BEAM][2] = {{0., 0.}, {1., 0.}, {0., 1.}};
+static const double energies[N_ENG] = {50., 52., 54., 56., 58.};
+static const double intens[N_BEAM][N_ENG] = {
+    {0., 0., 1.5e-3, 2.0e-3, 1.0e-3},
+    {0., 0., 4.0e-4, 3.0e-4, 5.0e-4},
+    {0., 0., 2.5e-4, 6.0e-4, 7.0e-4},
+};
+
+static void put_u32(FILE *f, unsigned long v)
+{
+    unsigned char b[4];
+    for (int i = 0; i < 4; i++) {
+        b[i] = (unsigned char)((v >> (8 * i)) & 0xFF);
+    }
+    fwrite(b, 1, 4, f);
+}
+
+static void put_f64(FILE *f, double v)
+{
+    unsigned long long bits;
+    unsigned char b[8];
+    memcpy(&bits, &v, 8);
+    for (int i = 0; i < 8; i++) {
+        b[i] = (unsigned char)((bits >> (8 * i)) & 0xFF);
+    }
+    fwrite(b, 1, 8, f);
+}
+
+static int write_binary(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return -1;
+    }
+    fwrite(IVBIN_MAGIC, 1, IVBIN_MAGIC_LEN, f);
+    put_u32(f, IVBIN_VERSION);
+    put_u32(f, IVBIN_DATA_OFFSET(N_BEAM));
+    put_u32(f, N_BEAM);
+    put_u32(f, N_ENG);
+    put_f64(f, energies[0]);
+    put_f64(f, energies[N_ENG - 1]);
+    put_f64(f, energies[1] - energies[0]);
+    put_f64(f, 0.);
+    put_f64(f, 0.);
+    for (int i = 0; i < N_BEAM; i++) {
+        put_f64(f, beam_ind[i][0]);
+        put_f64(f, beam_ind[i][1]);
+        put_u32(f, 0);
+        put_u32(f, 0);
+    }
+    for (int i = 0; i < N_ENG; i++) {
+        put_f64(f, energies[i]);
+    }
+    for (int b = 0; b < N_BEAM; b++) {
+        for (int i = 0; i < N_ENG; i++) {
+            put_f64(f, intens[b][i]);
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static int write_text(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        return -1;
+    }
+    fprintf(f, "# test\n#en %d\n#bn %d\n", N_ENG, N_BEAM);
+    for (int i = 0; i < N_BEAM; i++) {
+        fprintf(f, "#bi %d %f %f 0\n", i, beam_ind[i][0], beam_ind[i][1]);
+    }
+    for (int i = 0; i < N_ENG; i++) {
+        fprintf(f, "%.2f ", energies[i]);
+        for (int b = 0; b < N_BEAM; b++) {
+            fprintf(f, "%.6e ", intens[b][i]);
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    return 0;
+}
+
+static int compare_lists(const char *index_list, struct crivbin *ivbin, char *text)
+{
+    struct crivcur cur_bin, cur_txt;
+    char ind_bin[STRSZ], ind_txt[STRSZ];
+
+    memset(&cur_bin, 0, sizeof(cur_bin));
+    memset(&cur_txt, 0, sizeof(cur_txt));
+    strncpy(ind_bin, index_list, STRSZ - 1);
+    strncpy(ind_txt, index_list, STRSZ - 1);
+    ind_bin[STRSZ - 1] = ind_txt[STRSZ - 1] = '\0';
+
+    struct crelist *l_bin = cr_rdcleed_bin(&cur_bin, ivbin, ind_bin);
+    struct crelist *l_txt = cr_rdcleed(&cur_txt, text, ind_txt);
+
+    CLEED_TEST_ASSERT(l_bin != NULL && l_txt != NULL);
+    CLEED_TEST_ASSERT(cur_bin.the_leng == cur_txt.the_leng);
+    CLEED_TEST_ASSERT(cur_bin.the_leng == N_ENG - 2);
+    CLEED_TEST_ASSERT(cur_bin.the_sort == cur_txt.the_sort);
+    CLEED_TEST_ASSERT(cur_bin.the_equidist == cur_txt.the_equidist);
+    CLEED_TEST_ASSERT_NEAR(cur_bin.the_first_eng, cur_txt.the_first_eng, 1e-4);
+    CLEED_TEST_ASSERT_NEAR(cur_bin.the_last_eng, cur_txt.the_last_eng, 1e-4);
+    CLEED_TEST_ASSERT_NEAR(cur_bin.the_max_int, cur_txt.the_max_int, 1e-8);
+    CLEED_TEST_ASSERT_NEAR(cur_bin.spot_id.index1, cur_txt.spot_id.index1, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(cur_bin.spot_id.index2, cur_txt.spot_id.index2, 1e-6);
+
+    for (int i = 0; i <= cur_bin.the_leng; i++) {
+        CLEED_TEST_ASSERT_NEAR(l_bin[i].energy, l_txt[i].energy, 1e-4);
+        CLEED_TEST_ASSERT_NEAR(l_bin[i].intens, l_txt[i].intens, 1e-8);
+    }
+
+    free(l_bin);
+    free(l_txt);
+    return 0;
+}
+
+static void set_u32(char *buf, unsigned long v)
+{
+    for (int i = 0; i < 4; i++) {
+        buf[i] = (char)((v >> (8 * i)) & 0xFF);
+    }
+}
+
+/* header with the given counts and data offset, followed by n_fill
+   zero bytes; the buffer is owned (and freed) by cr_ivbin_from_buffer */
+static struct crivbin *open_header(unsigned long n_beam, unsigned long n_eng,
+                                   unsigned long data_offs, long n_fill)
+{
+    char *buf = (char *)calloc((size_t)(IVBIN_HEAD_SIZE + n_fill), 1);
+    if (buf == NULL) {
+        return NULL;
+    }
+    memcpy(buf, IVBIN_MAGIC, IVBIN_MAGIC_LEN);
+    set_u32(buf + IVBIN_OFFS_VERSION, IVBIN_VERSION);
+    set_u32(buf + IVBIN_OFFS_DATA, data_offs);
+    set_u32(buf + IVBIN_OFFS_N_BEAM, n_beam);
+    set_u32(buf + IVBIN_OFFS_N_ENG, n_eng);
+    return cr_ivbin_from_buffer(buf, IVBIN_HEAD_SIZE + n_fill);
+}
+
+/* counts that overflow the offset and size computations in 32 bits */
+static int test_corrupt_headers(void)
+{
+    struct crivbin *ivbin;
+
+    /* consistent: 1 beam, 2 energies */
+    ivbin = open_header(1, 2, IVBIN_DATA_OFFSET(1), IVBIN_BEAM_SIZE + 32);
+    CLEED_TEST_ASSERT(ivbin != NULL);
+    CLEED_TEST_ASSERT(ivbin->n_beam == 1 && ivbin->n_eng == 2);
+    cr_ivbin_close(ivbin);
+
+    /* one byte short */
+    CLEED_TEST_ASSERT(open_header(1, 2, IVBIN_DATA_OFFSET(1),
+                                  IVBIN_BEAM_SIZE + 31) == NULL);
+
+    /* 24 * n_beam wraps to 8 in 32 bits: offset 72 */
+    CLEED_TEST_ASSERT(open_header(0x0AAAAAABUL, 0, 72, 64) == NULL);
+    /* n_beam read as int -1: offset 64 - 24 */
+    CLEED_TEST_ASSERT(open_header(0xFFFFFFFFUL, 0, 40, 64) == NULL);
+
+    /* 8 * n_eng * (n_beam + 1) wraps in 32 bits */
+    CLEED_TEST_ASSERT(open_header(1, 0x20000000UL, IVBIN_DATA_OFFSET(1),
+                                  IVBIN_BEAM_SIZE + 32) == NULL);
+    CLEED_TEST_ASSERT(open_header(1, 0xFFFFFFFFUL, IVBIN_DATA_OFFSET(1),
+                                  IVBIN_BEAM_SIZE + 32) == NULL);
+    return 0;
+}
+
+int main(void)
+{
+    const char *bin_path = "ivbin_test.bres";
+    const char *txt_path = "ivbin_test.res";
+    const char *cnv_path = "ivbin_test_conv.res";
+
+    if (write_binary(bin_path) != 0 || write_text(txt_path) != 0) {
+        return 1;
+    }
+
+    CLEED_TEST_ASSERT(cr_ivbin_check(bin_path) == 1);
+    CLEED_TEST_ASSERT(cr_ivbin_check(txt_path) == 0);
+    CLEED_TEST_ASSERT(cr_ivbin_check("does_not_exist.bres") == 0);
+
+    struct crivbin *ivbin = cr_ivbin_open(bin_path);
+    CLEED_TEST_ASSERT(ivbin != NULL);
+    CLEED_TEST_ASSERT(ivbin->n_beam == N_BEAM);
+    CLEED_TEST_ASSERT(ivbin->n_eng == N_ENG);
+    CLEED_TEST_ASSERT_NEAR(ivbin->energy[N_ENG - 1], energies[N_ENG - 1], 1e-12);
+    CLEED_TEST_ASSERT_NEAR(ivbin->intens[2 * N_ENG + 3], intens[2][3], 1e-15);
+
+    char *text = file2buffer((char *)txt_path);
+    CLEED_TEST_ASSERT(text != NULL);
+
+    if (compare_lists("(1.,0.)", ivbin, text) != 0) {
+        return 1;
+    }
+    if (compare_lists("(0.,0.)*2.+(0.,1.)", ivbin, text) != 0) {
+        return 1;
+    }
+
+    /* The converted text file must read back to the same curves. */
+    FILE *out = fopen(cnv_path, "w");
+    CLEED_TEST_ASSERT(out != NULL);
+    CLEED_TEST_ASSERT(cr_ivbin_write_text(ivbin, out) == N_ENG);
+    fclose(out);
+
+    char *converted = file2buffer((char *)cnv_path);
+    CLEED_TEST_ASSERT(converted != NULL);
+    if (compare_lists("(0.,1.)", ivbin, converted) != 0) {
+        return 1;
+    }
+
+    free(converted);
+    free(text);
+    cr_ivbin_close(ivbin);
+
+    if (test_corrupt_headers() != 0) {
+        return 1;
+    }
+
+    (void)remove(bin_path);
+    (void)remove(txt_path);
+    (void)remove(cnv_path);
+    return 0;
+}
@@ -0,0 +1,132 @@
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+#ifdef _USE_OPENMP
+// cppcheck-suppress missingIncludeSystem
+#include <omp.h>
+#endif
+
+#include "crfac.h"
+#include "test_support.h"
+
+#define N_ENG   151
+#define N_BEAM  4
+#define N_EXP   3
+#define N_THREAD 4
+
+static const char *ctr_path = "rmin_test.ctr";
+static const char *the_path = "rmin_test.res";
+
+static double curve(double e, int beam, double shift)
+{
+    double x = e - shift - 5. * beam;
+    return 1.0 + 0.2 * beam + exp(-(x - 80.) * (x - 80.) / 40.) +
+           0.5 * exp(-(x - 130.) * (x - 130.) / (60. + 10. * beam)) +
+           0.05 * sin(0.3 * x);
+}
+
+static void exp_name(char *name, int beam)
+{
+    sprintf(name, "rmin_test_%d.iv", beam);
+}
+
+/* N_EXP experimental beams (1,0), (0,1), (1,1) compared with a theory of
+   N_BEAM beams; the experiment covers different energy ranges. */
+static int write_files(void)
+{
+    char name[64];
+    FILE *f;
+
+    for (int b = 1; b <= N_EXP; b++) {
+        exp_name(name, b);
+        if ((f = fopen(name, "w")) == NULL) return -1;
+        for (int i = 4 * b; i < N_ENG - 3 * b; i++) {
+            fprintf(f, "%.1f %.6e\n", 50. + i, curve(50. + i, b, 0.));
+        }
+        fclose(f);
+    }
+
+    if ((f = fopen(ctr_path, "w")) == NULL) return -1;
+    fprintf(f, "ef=rmin_test_1.iv:ti=(1.00,0.00):id=1:wt=1.\n");
+    fprintf(f, "ef=rmin_test_2.iv:ti=(0.00,1.00):id=2:wt=2.\n");
+    fprintf(f, "ef=rmin_test_3.iv:ti=(1.00,1.00):id=3:wt=1.\n\n");
+    fclose(f);
+
+    if ((f = fopen(the_path, "w")) == NULL) return -1;
+    fprintf(f, "# test\n#en %d\n#bn %d\n", N_ENG, N_BEAM);
+    fprintf(f, "#bi 0 0.000000 0.000000 0\n");
+    fprintf(f, "#bi 1 1.000000 0.000000 0\n");
+    fprintf(f, "#bi 2 0.000000 1.000000 0\n");
+    fprintf(f, "#bi 3 1.000000 1.000000 0\n");
+    for (int i = 0; i < N_ENG; i++) {
+        double e = 50. + i;
+        fprintf(f, "%.1f %.4e", e, 1.);
+        for (int b = 1; b < N_BEAM; b++) {
+            fprintf(f, " %.4e", curve(e, b, 1.5 - b));
+        }
+        fprintf(f, " \n");
+    }
+    fclose(f);
+    return 0;
+}
+
+static struct crargs test_args(int r_type)
+{
+    struct crargs args;
+
+    memset(&args, 0, sizeof(args));
+    args.r_type = r_type;
+    args.s_ini = -6.;
+    args.s_fin = 6.;
+    args.s_step = 0.5;
+    args.vi = 4.;
+    return args;
+}
+
+/* The pairs (shift, IV curve) of cr_rmin are evaluated in parallel, but
+   summed in a fixed order: the results must not depend on the number of
+   threads, not even in the last bit. */
+int main(void)
+{
+    static const int r_types[] = {RP_FACTOR, R1_FACTOR, R2_FACTOR, RB_FACTOR};
+    struct crivcur *iv_cur;
+    real r_min[2], s_min[2], e_range[2];
+    char e[2] = "e", t[2] = "t";
+    char name[64];
+
+    CLEED_TEST_ASSERT(write_files() == 0);
+
+    iv_cur = cr_input((char *)ctr_path, (char *)the_path);
+    CLEED_TEST_ASSERT(iv_cur != NULL);
+    for (int i = 0; iv_cur[i].group_id != I_END_OF_LIST; i++) {
+        cr_lorentz(iv_cur + i, 2., e);
+        cr_lorentz(iv_cur + i, 2., t);
+    }
+
+    for (int k = 0; k < (int)(sizeof(r_types) / sizeof(r_types[0])); k++) {
+        struct crargs args = test_args(r_types[k]);
+
+        for (int run = 0; run < 2; run++) {
+#ifdef _USE_OPENMP
+            omp_set_num_threads((run == 0) ? 1 : N_THREAD);
+#endif
+            CLEED_TEST_ASSERT(cr_rmin(iv_cur, &args, r_min + run, s_min + run,
+                                      e_range + run) >= 0.);
+        }
+        CLEED_TEST_ASSERT(e_range[0] > 0.);
+        CLEED_TEST_ASSERT(memcmp(r_min, r_min + 1, sizeof(real)) == 0);
+        CLEED_TEST_ASSERT(memcmp(s_min, s_min + 1, sizeof(real)) == 0);
+        CLEED_TEST_ASSERT(memcmp(e_range, e_range + 1, sizeof(real)) == 0);
+    }
+
+    for (int b = 1; b <= N_EXP; b++) {
+        exp_name(name, b);
+        (void)remove(name);
+    }
+    (void)remove(ctr_path);
+    (void)remove(the_path);
+    return 0;
+}
@@ -0,0 +1,343 @@
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+#if !defined(_WIN32)
+// cppcheck-suppress missingIncludeSystem
+#include <signal.h>
+// cppcheck-suppress missingIncludeSystem
+#include <sys/socket.h>
+// cppcheck-suppress missingIncludeSystem
+#include <sys/time.h>
+// cppcheck-suppress missingIncludeSystem
+#include <sys/un.h>
+// cppcheck-suppress missingIncludeSystem
+#include <sys/wait.h>
+// cppcheck-suppress missingIncludeSystem
+#include <unistd.h>
+#endif
+
+#include "crfac.h"
+#include "cleed_ivbin.h"
+#include "test_support.h"
+
+#define N_ENG  121
+#define N_BEAM 3
+
+static const char *exp_path = "serve_test.iv";
+static const char *ctr_path = "serve_test.ctr";
+static const char *the_a_path = "serve_test_a.res";
+static const char *the_b_path = "serve_test_b.res";
+static const char *the_c_path = "serve_test_c.res";
+static const char *bin_path = "serve_test_b.bres";
+static const char *sock_path = "serve_test.sock";
+
+static double curve(double e, double shift, double width)
+{
+    double x = e - shift;
+    return 1.0 + exp(-(x - 80.) * (x - 80.) / width) +
+           0.5 * exp(-(x - 130.) * (x - 130.) / width);
+}
+
+static void put_u32(FILE *f, unsigned long v)
+{
+    unsigned char b[4];
+    for (int i = 0; i < 4; i++) {
+        b[i] = (unsigned char)((v >> (8 * i)) & 0xFF);
+    }
+    fwrite(b, 1, 4, f);
+}
+
+static void put_f64(FILE *f, double v)
+{
+    unsigned long long bits;
+    unsigned char b[8];
+    memcpy(&bits, &v, 8);
+    for (int i = 0; i < 8; i++) {
+        b[i] = (unsigned char)((bits >> (8 * i)) & 0xFF);
+    }
+    fwrite(b, 1, 8, f);
+}
+
+static int write_files(void)
+{
+    FILE *f;
+
+    if ((f = fopen(exp_path, "w")) == NULL) return -1;
+    for (int i = 0; i < N_ENG; i++) {
+        fprintf(f, "%.1f %.6e\n", 50. + i, curve(50. + i, 0., 40.));
+    }
+    fclose(f);
+
+    /* control file: one curve, terminated by an empty line */
+    if ((f = fopen(ctr_path, "w")) == NULL) return -1;
+    fprintf(f, "ef=%s:ti=(1.00,0.00):id=1:wt=1.\n\n", exp_path);
+    fclose(f);
+
+    /* theory a: shifted copy of the experiment, theory b: different,
+       theory c: as a, but starting at 60 eV; beam (1,0) is compared,
+       the other beams are constant */
+    for (int k = 0; k < 3; k++) {
+        int i_0 = (k == 2) ? 10 : 0;
+        if ((f = fopen((k == 0) ? the_a_path :
+                       (k == 1) ? the_b_path : the_c_path, "w")) == NULL)
+            return -1;
+        fprintf(f, "# test\n#en %d\n#bn %d\n", N_ENG - i_0, N_BEAM);
+        fprintf(f, "#bi 0 0.000000 0.000000 0\n");
+        fprintf(f, "#bi 1 1.000000 0.000000 0\n");
+        fprintf(f, "#bi 2 0.000000 1.000000 0\n");
+        for (int i = i_0; i < N_ENG; i++) {
+            double e = 50. + i;
+            fprintf(f, "%.1f %.4e %.4e %.4e \n", e, 1.,
+                    (k == 1) ? curve(e, -3., 120.) : curve(e, 2., 40.), 1.);
+        }
+        fclose(f);
+    }
+
+    /* theory b in binary format */
+    if ((f = fopen(bin_path, "wb")) == NULL) return -1;
+    fwrite(IVBIN_MAGIC, 1, IVBIN_MAGIC_LEN, f);
+    put_u32(f, IVBIN_VERSION);
+    put_u32(f, IVBIN_DATA_OFFSET(N_BEAM));
+    put_u32(f, N_BEAM);
+    put_u32(f, N_ENG);
+    put_f64(f, 50.);
+    put_f64(f, 50. + N_ENG - 1);
+    put_f64(f, 1.);
+    put_f64(f, 0.);
+    put_f64(f, 0.);
+    for (int b = 0; b < N_BEAM; b++) {
+        put_f64(f, (b == 1) ? 1. : 0.);
+        put_f64(f, (b == 2) ? 1. : 0.);
+        put_u32(f, 0);
+        put_u32(f, 0);
+    }
+    for (int i = 0; i < N_ENG; i++) {
+        put_f64(f, 50. + i);
+    }
+    for (int b = 0; b < N_BEAM; b++) {
+        for (int i = 0; i < N_ENG; i++) {
+            put_f64(f, (b == 1) ? curve(50. + i, -3., 120.) : 1.);
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static struct crargs test_args(void)
+{
+    struct crargs args;
+
+    memset(&args, 0, sizeof(args));
+    args.r_type = RP_FACTOR;
+    args.s_ini = -5.;
+    args.s_fin = 5.;
+    args.s_step = 0.5;
+    args.vi = 4.;
+    return args;
+}
+
+/* R factor of a single crfac run (cr_input with theory) */
+static real single_run(char *the_file, real *s_min)
+{
+    struct crargs args = test_args();
+    struct crivcur *iv_cur = cr_input((char *)ctr_path, the_file);
+    real r_min, e_range;
+    char e[2] = "e", t[2] = "t";
+
+    for (int i = 0; iv_cur[i].group_id != I_END_OF_LIST; i++) {
+        cr_lorentz(iv_cur + i, args.vi / 2., e);
+        cr_lorentz(iv_cur + i, args.vi / 2., t);
+    }
+    cr_rmin(iv_cur, &args, &r_min, s_min, &e_range);
+    return r_min;
+}
+
+#if !defined(_WIN32)
+/* connection to the socket service; replies time out after 10 s */
+static int client_open(FILE **req, FILE **rep)
+{
+    struct sockaddr_un addr;
+    struct timeval tv = {10, 0};
+    int sock = -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, sock_path);
+
+    /* the service may not be listening yet */
+    for (int i = 0; i < 100; i++) {
+        if ((sock = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) return -1;
+        if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0) break;
+        close(sock);
+        sock = -1;
+        usleep(50000);
+    }
+    if (sock == -1 ||
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0)
+        return -1;
+
+    *rep = fdopen(sock, "r");
+    *req = fdopen(dup(sock), "w");
+    return (*rep != NULL && *req != NULL) ? 0 : -1;
+}
+
+/* R factor of a theory file through an open connection; -1 if failed */
+static double client_eval(FILE *req, FILE *rep, const char *the_file)
+{
+    char line[256];
+    double r_min;
+
+    if (fprintf(req, "%s\n", the_file) < 0 || fflush(req) != 0 ||
+        fgets(line, sizeof(line), rep) == NULL ||
+        sscanf(line, "%lf", &r_min) != 1)
+        return -1.;
+    return r_min;
+}
+
+/* Two clients connected at the same time: the second one is served
+   while the first session is still open, SHUTDOWN ends both. */
+static int two_clients(pid_t pid, real r_a, real r_b)
+{
+    FILE *req_1, *rep_1, *req_2, *rep_2;
+    char line[256];
+    int status;
+
+    CLEED_TEST_ASSERT(client_open(&req_1, &rep_1) == 0);
+    CLEED_TEST_ASSERT_NEAR(client_eval(req_1, rep_1, the_a_path), r_a, 1e-5);
+
+    CLEED_TEST_ASSERT(client_open(&req_2, &rep_2) == 0);
+    CLEED_TEST_ASSERT_NEAR(client_eval(req_2, rep_2, the_b_path), r_b, 1e-5);
+    CLEED_TEST_ASSERT_NEAR(client_eval(req_1, rep_1, the_b_path), r_b, 1e-5);
+    CLEED_TEST_ASSERT_NEAR(client_eval(req_2, rep_2, the_a_path), r_a, 1e-5);
+
+    fprintf(req_2, "SHUTDOWN\n");
+    fflush(req_2);
+    CLEED_TEST_ASSERT(waitpid(pid, &status, 0) == pid);
+    CLEED_TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    /* the first session has been closed by the service */
+    CLEED_TEST_ASSERT(fgets(line, sizeof(line), rep_1) == NULL);
+
+    fclose(req_1);
+    fclose(rep_1);
+    fclose(req_2);
+    fclose(rep_2);
+    return 0;
+}
+
+/* the service runs in a child process, which is killed if a test fails */
+static int test_two_clients(real r_a, real r_b)
+{
+    pid_t pid;
+
+    fflush(NULL);
+    if ((pid = fork()) == -1) return 1;
+    if (pid == 0) {
+        struct crargs args = test_args();
+        struct crivcur *iv_cur = cr_input((char *)ctr_path, NULL);
+
+        args.sockfile = (char *)sock_path;
+        _exit((iv_cur != NULL && cr_serve(iv_cur, &args) == 0) ? 0 : 1);
+    }
+
+    if (two_clients(pid, r_a, r_b) != 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        (void)remove(sock_path);
+        return 1;
+    }
+    return 0;
+}
+#endif
+
+int main(void)
+{
+    struct crargs args = test_args();
+    struct crivcur *iv_cur;
+    struct crivbin *ivbin;
+    real r_a, r_b, r_c, r_min, s_a, s_b, s_c, s_min, e_range;
+    char e[2] = "e";
+    char *buffer;
+    long len;
+    FILE *f;
+
+    if (write_files() != 0) {
+        return 1;
+    }
+
+    r_a = single_run((char *)the_a_path, &s_a);
+    r_b = single_run((char *)the_b_path, &s_b);
+    r_c = single_run((char *)the_c_path, &s_c);
+    CLEED_TEST_ASSERT(r_a < 0.1);
+    CLEED_TEST_ASSERT(r_b > r_a + 0.1);
+
+    /* experiment only, then several theories in turn */
+    iv_cur = cr_input((char *)ctr_path, NULL);
+    CLEED_TEST_ASSERT(iv_cur != NULL);
+    CLEED_TEST_ASSERT(iv_cur[0].the_list == NULL);
+    CLEED_TEST_ASSERT(iv_cur[0].the_index != NULL);
+    cr_lorentz(iv_cur, args.vi / 2., e);
+
+    CLEED_TEST_ASSERT(cr_input_the(iv_cur, (char *)the_b_path) == 0);
+    CLEED_TEST_ASSERT(cr_serve_eval(iv_cur, &args, &r_min, &s_min, &e_range) == 0);
+    CLEED_TEST_ASSERT_NEAR(r_min, r_b, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(s_min, s_b, 1e-6);
+
+    CLEED_TEST_ASSERT(cr_input_the(iv_cur, (char *)the_a_path) == 0);
+    CLEED_TEST_ASSERT(cr_serve_eval(iv_cur, &args, &r_min, &s_min, &e_range) == 0);
+    CLEED_TEST_ASSERT_NEAR(r_min, r_a, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(s_min, s_a, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(iv_cur[0].eng_0, 50., 1e-6);
+
+    /* a different energy range: eng_0 follows each theory */
+    CLEED_TEST_ASSERT(cr_input_the(iv_cur, (char *)the_c_path) == 0);
+    CLEED_TEST_ASSERT(cr_serve_eval(iv_cur, &args, &r_min, &s_min, &e_range) == 0);
+    CLEED_TEST_ASSERT_NEAR(r_min, r_c, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(s_min, s_c, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(iv_cur[0].eng_0, 60., 1e-6);
+
+    CLEED_TEST_ASSERT(cr_input_the(iv_cur, (char *)the_a_path) == 0);
+    CLEED_TEST_ASSERT(cr_serve_eval(iv_cur, &args, &r_min, &s_min, &e_range) == 0);
+    CLEED_TEST_ASSERT_NEAR(r_min, r_a, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(iv_cur[0].eng_0, 50., 1e-6);
+
+    /* binary theory received in memory */
+    f = fopen(bin_path, "rb");
+    CLEED_TEST_ASSERT(f != NULL);
+    fseek(f, 0L, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0L, SEEK_SET);
+    buffer = (char *)malloc((size_t)len);
+    CLEED_TEST_ASSERT(buffer != NULL);
+    CLEED_TEST_ASSERT((long)fread(buffer, 1, (size_t)len, f) == len);
+    fclose(f);
+
+    ivbin = cr_ivbin_from_buffer(buffer, len);
+    CLEED_TEST_ASSERT(ivbin != NULL);
+    CLEED_TEST_ASSERT(cr_input_thebuf(iv_cur, NULL, ivbin) == 0);
+    cr_ivbin_close(ivbin);
+    CLEED_TEST_ASSERT(cr_serve_eval(iv_cur, &args, &r_min, &s_min, &e_range) == 0);
+    CLEED_TEST_ASSERT_NEAR(r_min, r_b, 1e-4);
+    CLEED_TEST_ASSERT_NEAR(s_min, s_b, 1e-6);
+
+    /* inconsistent input is rejected without leaving the process */
+    CLEED_TEST_ASSERT(cr_input_thebuf(iv_cur, (char *)"# nothing\n", NULL) != 0);
+    CLEED_TEST_ASSERT(cr_input_thebuf(iv_cur, NULL, NULL) != 0);
+
+#if !defined(_WIN32)
+    CLEED_TEST_ASSERT(test_two_clients(r_a, r_b) == 0);
+#endif
+
+    (void)remove(exp_path);
+    (void)remove(ctr_path);
+    (void)remove(the_a_path);
+    (void)remove(the_b_path);
+    (void)remove(the_c_path);
+    (void)remove(bin_path);
+    return 0;
+}
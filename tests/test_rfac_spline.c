@@ -2,6 +2,8 @@
 #include <math.h>
 // cppcheck-suppress missingIncludeSystem
 #include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
 
 #include "crfac.h"
 #include "test_support.h"
@@ -100,6 +102,91 @@ static int test_degenerate_spacing(void)
     return 0;
 }
 
+/* Curves of different length with non-uniform spacing. */
+#define N_CURVES 3
+static const int curve_leng[N_CURVES] = {7, 2, 12};
+
+static void fill_curve(struct crelist *list, int leng, int seed)
+{
+    real e = (real)(20.0 + seed);
+    for (int i = 0; i < leng; i++) {
+        list[i].energy = e;
+        list[i].intens = (real)(1.0 + sin(0.3 * e + seed) * exp(-0.01 * e));
+        list[i].deriv2 = 0.0;
+        e += (real)(1.0 + 0.5 * ((i + seed) % 3));
+    }
+}
+
+static int test_batch_matches_single(void)
+{
+    struct crelist lists[N_CURVES][12];
+    struct crspline *spl = cr_spline_alloc(N_CURVES, curve_leng);
+    CLEED_TEST_ASSERT(spl != NULL);
+    CLEED_TEST_ASSERT(spl->n_tot == 7 + 2 + 12);
+
+    for (int c = 0; c < N_CURVES; c++) {
+        fill_curve(lists[c], curve_leng[c], c);
+        CLEED_TEST_ASSERT(cr_spline_set(spl, c, lists[c]) == curve_leng[c]);
+        cr_spline(lists[c], curve_leng[c]);
+    }
+    CLEED_TEST_ASSERT(cr_spline_prep(spl) == 0);
+
+    for (int c = 0; c < N_CURVES; c++) {
+        struct crsplcur cur;
+        const int leng = curve_leng[c];
+        const real e_lo = lists[c][0].energy - (real)1.0;
+        const real e_hi = lists[c][leng - 1].energy + (real)1.0;
+
+        for (int i = 0; i < leng; i++) {
+            CLEED_TEST_ASSERT_NEAR(spl->deriv2[spl->offs[c] + i], lists[c][i].deriv2, 1e-6);
+        }
+
+        /* increasing query points (cursor moves forward only) */
+        cr_splcur_init(&cur, spl, c);
+        for (real e = e_lo; e <= e_hi; e += (real)0.25) {
+            CLEED_TEST_ASSERT_NEAR(cr_splcur_eval(&cur, e), cr_splint(e, lists[c], leng), 1e-5);
+        }
+
+        /* decreasing query points fall back to bisection */
+        for (real e = e_hi; e >= e_lo; e -= (real)0.7) {
+            CLEED_TEST_ASSERT_NEAR(cr_splcur_eval(&cur, e), cr_splint(e, lists[c], leng), 1e-5);
+        }
+    }
+
+    cr_spline_free(spl);
+    return 0;
+}
+
+static int test_mklide_matches_splint(void)
+{
+    struct crelist exp_list[12], the_list[12];
+    real eng[64], e_int[64], t_int[64];
+    const int leng[2] = {12, 7};
+    const real shift = (real)1.5, de = (real)0.5;
+
+    fill_curve(exp_list, leng[0], 2);
+    fill_curve(the_list, leng[1], 0);
+    cr_spline(exp_list, leng[0]);
+    cr_spline(the_list, leng[1]);
+
+    struct crspline *spl = cr_spline_alloc(2, leng);
+    CLEED_TEST_ASSERT(spl != NULL);
+    cr_spline_set(spl, 0, exp_list);
+    cr_spline_set(spl, 1, the_list);
+    CLEED_TEST_ASSERT(cr_spline_prep(spl) == 0);
+
+    const int n_eng = cr_mklide(eng, e_int, t_int, de, shift, spl, 0, 1);
+    CLEED_TEST_ASSERT(n_eng > 1);
+    for (int i = 0; i < n_eng; i++) {
+        CLEED_TEST_ASSERT_NEAR(e_int[i], cr_splint(eng[i], exp_list, leng[0]), 1e-5);
+        CLEED_TEST_ASSERT_NEAR(t_int[i], cr_splint(eng[i] - shift, the_list, leng[1]), 1e-5);
+    }
+    CLEED_TEST_ASSERT(IS_EQUAL_REAL(eng[n_eng], F_END_OF_LIST));
+
+    cr_spline_free(spl);
+    return 0;
+}
+
 int main(void)
 {
     if (test_linear_exact() != 0) {
@@ -111,5 +198,11 @@ int main(void)
     if (test_degenerate_spacing() != 0) {
         return 1;
     }
+    if (test_batch_matches_single() != 0) {
+        return 1;
+    }
+    if (test_mklide_matches_splint() != 0) {
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,130 @@
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "crfac.h"
+#include "test_support.h"
+
+#define N_ENG  121
+
+static const char *exp_a_path = "yres_test_a.iv";
+static const char *exp_b_path = "yres_test_b.iv";
+static const char *ctr_path = "yres_test.ctr";
+static const char *the_path = "yres_test.res";
+static const char *yres_path = "yres_test.yres";
+
+static double curve(double e, double shift, double width, double pos)
+{
+    double x = e - shift;
+    return 1.0 + exp(-(x - pos) * (x - pos) / width) +
+           0.5 * exp(-(x - pos - 50.) * (x - pos - 50.) / width);
+}
+
+static int write_files(void)
+{
+    FILE *f;
+
+    if ((f = fopen(exp_a_path, "w")) == NULL) return -1;
+    for (int i = 0; i < N_ENG; i++) {
+        fprintf(f, "%.1f %.6e\n", 50. + i, curve(50. + i, 0., 40., 80.));
+    }
+    fclose(f);
+
+    /* second beam: shorter energy range */
+    if ((f = fopen(exp_b_path, "w")) == NULL) return -1;
+    for (int i = 20; i < N_ENG; i++) {
+        fprintf(f, "%.1f %.6e\n", 50. + i, curve(50. + i, 0., 60., 100.));
+    }
+    fclose(f);
+
+    /* two curves with different weights */
+    if ((f = fopen(ctr_path, "w")) == NULL) return -1;
+    fprintf(f, "ef=%s:ti=(1.00,0.00):id=1:wt=1.\n", exp_a_path);
+    fprintf(f, "ef=%s:ti=(0.00,1.00):id=2:wt=2.\n\n", exp_b_path);
+    fclose(f);
+
+    if ((f = fopen(the_path, "w")) == NULL) return -1;
+    fprintf(f, "# test\n#en %d\n#bn 3\n", N_ENG);
+    fprintf(f, "#bi 0 0.000000 0.000000 0\n");
+    fprintf(f, "#bi 1 1.000000 0.000000 0\n");
+    fprintf(f, "#bi 2 0.000000 1.000000 0\n");
+    for (int i = 0; i < N_ENG; i++) {
+        double e = 50. + i;
+        fprintf(f, "%.1f %.4e %.4e %.4e \n", e, 1.,
+                curve(e, 2., 50., 82.), curve(e, 2., 45., 97.));
+    }
+    fclose(f);
+    return 0;
+}
+
+int main(void)
+{
+    struct crargs args;
+    struct crivcur *iv_cur;
+    real r_min, s_min, e_range;
+    double shift, rp;
+    char e[2] = "e", t[2] = "t";
+    char line[256];
+    double sum = 0.;
+    int n_res, n_read = 0;
+    FILE *f;
+
+    CLEED_TEST_ASSERT(write_files() == 0);
+
+    memset(&args, 0, sizeof(args));
+    args.r_type = RP_FACTOR;
+    args.s_ini = -5.;
+    args.s_fin = 5.;
+    args.s_step = 0.5;
+    args.vi = 4.;
+
+    iv_cur = cr_input((char *)ctr_path, (char *)the_path);
+    CLEED_TEST_ASSERT(iv_cur != NULL);
+    for (int i = 0; iv_cur[i].group_id != I_END_OF_LIST; i++) {
+        cr_lorentz(iv_cur + i, args.vi / 2., e);
+        cr_lorentz(iv_cur + i, args.vi / 2., t);
+    }
+    cr_rmin(iv_cur, &args, &r_min, &s_min, &e_range);
+    CLEED_TEST_ASSERT(r_min > 0.01);
+
+    /* sum of squares of the residuals is Rp of cr_rmin */
+    n_res = cr_yres(iv_cur, &args, s_min, yres_path);
+    CLEED_TEST_ASSERT(n_res > 100);
+
+    f = fopen(yres_path, "r");
+    CLEED_TEST_ASSERT(f != NULL);
+    while (fgets(line, sizeof(line), f) != NULL && line[0] == '#') {
+    }
+    CLEED_TEST_ASSERT(sscanf(line, "%d %lf %lf", &n_read, &shift, &rp) == 3);
+    CLEED_TEST_ASSERT(n_read == n_res);
+    CLEED_TEST_ASSERT_NEAR(shift, s_min, 1e-4);
+    CLEED_TEST_ASSERT_NEAR(rp, r_min, 1e-6);
+    n_read = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        double r = atof(line);
+        sum += r * r;
+        n_read++;
+    }
+    fclose(f);
+    CLEED_TEST_ASSERT(n_read == n_res);
+    CLEED_TEST_ASSERT_NEAR(sum, r_min, 1e-6);
+
+    /* another shift: fewer overlapping points, higher Rp */
+    CLEED_TEST_ASSERT(cr_yres(iv_cur, &args, s_min + 3., yres_path) < n_res);
+
+    /* only defined for Pendry's R factor */
+    args.r_type = R1_FACTOR;
+    CLEED_TEST_ASSERT(cr_yres(iv_cur, &args, s_min, yres_path) == -1);
+
+    remove(exp_a_path);
+    remove(exp_b_path);
+    remove(ctr_path);
+    remove(the_path);
+    remove(yres_path);
+    return 0;
+}
@@ -9,8 +9,6 @@
 
 #include "test_support.h"
 
-extern long sa_idum;
-
 static real quadratic_2d(real *x)
 {
     const real dx = x[1] - 1.0;
@@ -58,11 +56,11 @@ static int run_amebsa_once(real temptr, long seed, amebsa_result *out)
 
     configure_simplex(p, y);
 
-    sa_idum = seed;
+    sr_default_context.idum = seed;
     real yb = 1e30;
     int budget = 500;
 
-    sr_amebsa_cfg cfg;
+    sr_amebsa_cfg cfg = {0};
     cfg.ftol = 1e-6;
     cfg.funk = quadratic_2d;
     cfg.temptr = temptr;
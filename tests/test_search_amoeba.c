@@ -31,17 +31,18 @@ static int find_min_index(const real *values, int n)
 
 static int setup_sr_project(void)
 {
-    sr_project = (char *)malloc((size_t)STRSZ + 1);
-    if (!sr_project) {
+    sr_default_context.project = (char *)malloc((size_t)STRSZ + 1);
+    if (!sr_default_context.project) {
         fprintf(stderr, "allocation failed: sr_project\n");
         return 1;
     }
-    snprintf(sr_project, (size_t)STRSZ + 1, "%s", "amoeba_test");
+    snprintf(sr_default_context.project, (size_t)STRSZ + 1, "%s",
+             "amoeba_test");
 
     if (cleed_test_write_text_file("amoeba_test.ver", "seed\n") != 0) {
         fprintf(stderr, "failed to create amoeba_test.ver\n");
-        free(sr_project);
-        sr_project = NULL;
+        free(sr_default_context.project);
+        sr_default_context.project = NULL;
         return 1;
     }
 
@@ -52,8 +53,8 @@ static void teardown_sr_project(void)
 {
     cleed_test_remove_file("amoeba_test.ver");
     cleed_test_remove_file("amoeba_test.vbk");
-    free(sr_project);
-    sr_project = NULL;
+    free(sr_default_context.project);
+    sr_default_context.project = NULL;
 }
 
 static void configure_simplex(real **p, real *y)
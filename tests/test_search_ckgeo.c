@@ -0,0 +1,224 @@
+#include "search.h"
+
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "test_support.h"
+
+#define N_PAR 3
+#define N_POP 20
+
+static unsigned long rng_state = 12345UL;
+
+static double uniform(double lo, double hi)
+{
+    rng_state = rng_state * 6364136223846793005UL + 1442695040888963407UL;
+    return lo + (hi - lo) * (double)((rng_state >> 11) & 0xFFFFFFUL) / 16777216.0;
+}
+
+/* the pair loop over all unit cells of the original sr_ckgeo */
+static double ref_ckgeo(const struct sr_context *ctx, const real *par)
+{
+    const struct search_str *s = ctx->search;
+    int n = 0;
+    while (ctx->atoms[n].type != I_END_OF_LIST) n++;
+
+    double *x = (double *)malloc((size_t)n * sizeof(double));
+    double *y = (double *)malloc((size_t)n * sizeof(double));
+    double *z = (double *)malloc((size_t)n * sizeof(double));
+    double rgeo = 0.;
+
+    for (int i = 0; i < n; i++)
+    {
+        x[i] = ctx->atoms[i].x;
+        y[i] = ctx->atoms[i].y;
+        z[i] = ctx->atoms[i].z;
+        for (int k = 1; k <= s->n_par_geo; k++)
+        {
+            if (!s->z_only)
+            {
+                x[i] += par[k] * ctx->atoms[i].x_par[k];
+                y[i] += par[k] * ctx->atoms[i].y_par[k];
+            }
+            z[i] += par[k] * ctx->atoms[i].z_par[k];
+        }
+    }
+    for (int i = 0; i < n; i++)
+    {
+        if (z[i] > s->z_max)
+            rgeo += pow(10. * (s->z_max - z[i]) / s->z_max, 2);
+        if (z[i] < s->z_min)
+            rgeo += pow(10. * (s->z_min - z[i]) / s->z_min, 2);
+        for (int j = i + 1; j < n; j++)
+        {
+            double d_min = ctx->atoms[i].r_min + ctx->atoms[j].r_min;
+            for (int i1 = -1; i1 <= 1; i1++)
+            for (int i2 = -1; i2 <= 1; i2++)
+            {
+                double dx = x[j] - x[i] + i1 * s->b_lat[1] + i2 * s->b_lat[2];
+                double dy = y[j] - y[i] + i1 * s->b_lat[3] + i2 * s->b_lat[4];
+                double d = sqrt(dx * dx + dy * dy + (z[j] - z[i]) * (z[j] - z[i]));
+                if (d < d_min) rgeo += pow(10. * (d_min - d) / d_min, 2);
+            }
+        }
+    }
+    free(x);
+    free(y);
+    free(z);
+    return rgeo / n;
+}
+
+/* n random atoms in the cell (a, b) with z in 1 ... 5 */
+static struct sratom_str *make_atoms(int n, const real *b_lat, double r_lo,
+                                     double r_hi)
+{
+    struct sratom_str *atoms =
+        (struct sratom_str *)calloc((size_t)n + 1, sizeof(struct sratom_str));
+    for (int i = 0; i < n; i++)
+    {
+        double u = uniform(0., 1.), v = uniform(0., 1.);
+        atoms[i].type = 1;
+        atoms[i].r_min = (real)uniform(r_lo, r_hi);
+        atoms[i].x = (real)(u * b_lat[1] + v * b_lat[2]);
+        atoms[i].y = (real)(u * b_lat[3] + v * b_lat[4]);
+        atoms[i].z = (real)uniform(1., 5.);
+        atoms[i].x_par = cleed_test_alloc_vector_1based(N_PAR);
+        atoms[i].y_par = cleed_test_alloc_vector_1based(N_PAR);
+        atoms[i].z_par = cleed_test_alloc_vector_1based(N_PAR);
+        for (int k = 1; k <= N_PAR; k++)
+        {
+            atoms[i].x_par[k] = (real)uniform(-1., 1.);
+            atoms[i].y_par[k] = (real)uniform(-1., 1.);
+            atoms[i].z_par[k] = (real)uniform(-1., 1.);
+        }
+    }
+    atoms[n].type = I_END_OF_LIST;
+    return atoms;
+}
+
+static void free_atoms(struct sratom_str *atoms)
+{
+    for (int i = 0; atoms[i].type != I_END_OF_LIST; i++)
+    {
+        cleed_test_free_vector_1based(atoms[i].x_par);
+        cleed_test_free_vector_1based(atoms[i].y_par);
+        cleed_test_free_vector_1based(atoms[i].z_par);
+    }
+    free(atoms);
+}
+
+/* sr_geo_eval, sr_geo_batch and sr_ckgeo against the pair loop */
+static int check_population(struct sr_context *ctx, double spread)
+{
+    struct sr_geoscreen geo;
+    real **pop = cleed_test_alloc_matrix_1based(N_POP, N_PAR);
+    real *rgeo = cleed_test_alloc_vector_1based(N_POP);
+    int n_bad = 0;
+
+    CLEED_TEST_ASSERT(pop != NULL && rgeo != NULL);
+    memset(&geo, 0, sizeof(geo));
+    for (int k = 1; k <= N_POP; k++)
+        for (int j = 1; j <= N_PAR; j++)
+            pop[k][j] = (real)uniform(-spread, spread);
+
+    int n_ret = sr_geo_batch(&geo, ctx, pop, N_POP, rgeo);
+    for (int k = 1; k <= N_POP; k++)
+    {
+        double ref = ref_ckgeo(ctx, pop[k]);
+        double tol = 1e-4 * (1. + ref);
+        CLEED_TEST_ASSERT_NEAR(rgeo[k], ref, tol);
+        CLEED_TEST_ASSERT_NEAR(sr_geo_eval(&geo, ctx, pop[k]), ref, tol);
+        CLEED_TEST_ASSERT_NEAR(sr_ckgeo(ctx, pop[k]), ref, tol);
+        if (rgeo[k] > SR_RGEO_MAX) n_bad++;
+    }
+    CLEED_TEST_ASSERT(n_ret == n_bad);
+
+    sr_geo_free(&geo);
+    cleed_test_free_matrix_1based(pop);
+    cleed_test_free_vector_1based(rgeo);
+    return 0;
+}
+
+static int test_ckgeo_cell_list(void)
+{
+    struct search_str search;
+    struct sr_context ctx;
+
+    memset(&search, 0, sizeof(search));
+    memset(&ctx, 0, sizeof(ctx));
+    search.n_par = search.n_par_geo = N_PAR;
+    search.z_min = 0.5;
+    search.z_max = 5.5;
+    ctx.search = &search;
+
+    /* large oblique cell, many atoms: few neighbours per atom */
+    search.b_lat[1] = 24.0; search.b_lat[2] = 12.0;
+    search.b_lat[3] = 0.0;  search.b_lat[4] = 20.8;
+    ctx.atoms = make_atoms(80, search.b_lat, 0.3, 0.6);
+    CLEED_TEST_ASSERT(check_population(&ctx, 0.2) == 0);
+    CLEED_TEST_ASSERT(check_population(&ctx, 2.0) == 0);
+    search.z_only = 1;
+    CLEED_TEST_ASSERT(check_population(&ctx, 1.0) == 0);
+    search.z_only = 0;
+    free_atoms(ctx.atoms);
+
+    /* small cell: the min. distance exceeds the lattice vectors */
+    search.b_lat[1] = 1.5; search.b_lat[2] = 0.0;
+    search.b_lat[3] = 0.0; search.b_lat[4] = 1.8;
+    ctx.atoms = make_atoms(6, search.b_lat, 0.8, 1.2);
+    CLEED_TEST_ASSERT(check_population(&ctx, 1.0) == 0);
+    free_atoms(ctx.atoms);
+
+    /* no radii: only the vertical limits */
+    ctx.atoms = make_atoms(10, search.b_lat, 0.0, 0.0);
+    CLEED_TEST_ASSERT(check_population(&ctx, 1.5) == 0);
+    free_atoms(ctx.atoms);
+
+    return 0;
+}
+
+static int test_ckgeo_overlap(void)
+{
+    struct search_str search;
+    struct sr_context ctx;
+    struct sr_geoscreen geo;
+    real par[N_PAR + 1] = {0., 0., 0., 0.};
+
+    memset(&search, 0, sizeof(search));
+    memset(&ctx, 0, sizeof(ctx));
+    memset(&geo, 0, sizeof(geo));
+    search.n_par = search.n_par_geo = N_PAR;
+    search.z_min = 0.5;
+    search.z_max = 5.5;
+    search.b_lat[1] = 10.0;
+    search.b_lat[4] = 10.0;
+    ctx.search = &search;
+    ctx.atoms = make_atoms(2, search.b_lat, 1.0, 1.0);
+
+    /* two atoms 1 A apart (sum of radii 2 A): (10 * 0.5)^2 / 2 */
+    ctx.atoms[0].x = ctx.atoms[0].y = 5.0f;
+    ctx.atoms[1].x = 6.0f;
+    ctx.atoms[1].y = 5.0f;
+    ctx.atoms[0].z = ctx.atoms[1].z = 2.0f;
+    CLEED_TEST_ASSERT_NEAR(sr_geo_eval(&geo, &ctx, par), 12.5, 1e-4);
+
+    /* ... and across the cell boundary */
+    ctx.atoms[0].x = 0.2f;
+    ctx.atoms[1].x = 9.2f;
+    CLEED_TEST_ASSERT_NEAR(sr_geo_eval(&geo, &ctx, par), 12.5, 1e-4);
+
+    sr_geo_free(&geo);
+    free_atoms(ctx.atoms);
+    return 0;
+}
+
+int main(void)
+{
+    if (test_ckgeo_cell_list() != 0) return 1;
+    if (test_ckgeo_overlap() != 0) return 1;
+    return 0;
+}
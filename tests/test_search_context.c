@@ -0,0 +1,154 @@
+#include "search.h"
+
+// cppcheck-suppress missingIncludeSystem
+#include <pthread.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+// cppcheck-suppress missingIncludeSystem
+#include <sys/stat.h>
+// cppcheck-suppress missingIncludeSystem
+#include <unistd.h>
+
+#include "test_support.h"
+
+#define N_CALL 50
+
+static const char *bul_text =
+    "a1: 1.0000 0.0000 0.0000\n"
+    "a2: 0.0000 1.0000 0.0000\n"
+    "a3: 0.0000 0.0000 1.0000\n"
+    "ip: 0.0\n"
+    "it: 0.0\n";
+
+/* one atom, one z parameter */
+static const char *inp_one =
+    "a1: 1.0000 0.0000 0.0000\n"
+    "a2: 0.0000 1.0000 0.0000\n"
+    "po: X_one 0.0000 0.0000 1.0000 dr3 0.050 0.050 0.050\n"
+    "rm: X_one 0.10\n"
+    "zr: 0.00 10.00\n"
+    "spn: 1\n"
+    "spp: - z 1.0\n";
+
+/* two atoms, one z parameter each */
+static const char *inp_two =
+    "a1: 1.0000 0.0000 0.0000\n"
+    "a2: 0.0000 1.0000 0.0000\n"
+    "po: X_two 0.0000 0.0000 1.2000 dr3 0.050 0.050 0.050\n"
+    "po: X_two 0.5000 0.5000 1.2000 dr3 0.050 0.050 0.050\n"
+    "rm: X_two 0.10\n"
+    "zr: 0.00 10.00\n"
+    "spn: 2\n"
+    "spp: 0 z 1.0 0.0\n"
+    "spp: 1 z 0.0 1.0\n";
+
+typedef struct job {
+    char inp_file[256];
+    struct sr_context ctx;
+    struct sr_evslot slot;
+    real rgeo;
+    int n_ok;
+} job;
+
+/* read the input, then write the LEED input for N_CALL parameter sets */
+static void *run_job(void *arg)
+{
+    job *j = (job *)arg;
+    real par[3];
+
+    if (sr_rdinp(&j->ctx, j->inp_file) < 1) return NULL;
+    if (sr_evslot_open(&j->slot, j->ctx.project, 1) != 0) return NULL;
+
+    for (int i_call = 1; i_call <= N_CALL; i_call++) {
+        for (int i = 1; i <= j->ctx.search->n_par; i++) {
+            par[i] = (real)0.01 * (real)(i_call * i);
+        }
+        j->rgeo = sr_ckgeo(&j->ctx, par);
+        if (sr_mkinp(&j->ctx, par, i_call, &j->slot) == 1) j->n_ok++;
+    }
+    return NULL;
+}
+
+static int count_lines(const char *path, const char *prefix, char *last)
+{
+    char line[256];
+    int n = 0;
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL) return -1;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (strncmp(line, prefix, strlen(prefix)) == 0) {
+            n++;
+            if (last != NULL) snprintf(last, 256, "%s", line);
+        }
+    }
+    fclose(fp);
+    return n;
+}
+
+int main(void)
+{
+    char work[] = "/tmp/test_context_XXXXXX";
+    char path[512], last[256];
+    job a, b;
+    pthread_t thread;
+
+    CLEED_TEST_ASSERT(mkdtemp(work) != NULL);
+    snprintf(path, sizeof(path), "%s/scratch", work);
+    CLEED_TEST_ASSERT(mkdir(path, 0755) == 0);
+    setenv("CSEARCH_SCRATCH", path, 1);
+    /* the project name is the base name of the input file */
+    CLEED_TEST_ASSERT(chdir(work) == 0);
+
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    CLEED_TEST_ASSERT(sr_context_init(&a.ctx, NULL) == 0);
+    CLEED_TEST_ASSERT(sr_context_init(&b.ctx, NULL) == 0);
+    CLEED_TEST_ASSERT(strcmp(a.ctx.project, "search") == 0);
+
+    snprintf(a.inp_file, sizeof(a.inp_file), "%s", "one.inp");
+    snprintf(b.inp_file, sizeof(b.inp_file), "%s", "two.inp");
+    CLEED_TEST_ASSERT(cleed_test_write_text_file(a.inp_file, inp_one) == 0);
+    CLEED_TEST_ASSERT(cleed_test_write_text_file(b.inp_file, inp_two) == 0);
+    CLEED_TEST_ASSERT(cleed_test_write_text_file("one.bul", bul_text) == 0);
+    CLEED_TEST_ASSERT(cleed_test_write_text_file("two.bul", bul_text) == 0);
+
+    /* two independent searches in one process */
+    CLEED_TEST_ASSERT(pthread_create(&thread, NULL, run_job, &a) == 0);
+    run_job(&b);
+    CLEED_TEST_ASSERT(pthread_join(thread, NULL) == 0);
+
+    CLEED_TEST_ASSERT(a.n_ok == N_CALL);
+    CLEED_TEST_ASSERT(b.n_ok == N_CALL);
+    CLEED_TEST_ASSERT(strcmp(a.ctx.project, "one") == 0);
+    CLEED_TEST_ASSERT(strcmp(b.ctx.project, "two") == 0);
+    CLEED_TEST_ASSERT(a.ctx.search->n_par == 1);
+    CLEED_TEST_ASSERT(b.ctx.search->n_par == 2);
+    CLEED_TEST_ASSERT_NEAR(a.rgeo, 0.0, 1e-12);
+    CLEED_TEST_ASSERT_NEAR(b.rgeo, 0.0, 1e-12);
+
+    /* each slot holds the last geometry of its own search */
+    CLEED_TEST_ASSERT(count_lines(a.slot.par_file, "po:", last) == 1);
+    CLEED_TEST_ASSERT(strstr(last, "X_one") != NULL);
+    CLEED_TEST_ASSERT(strstr(last, " 1.500000 ") != NULL);
+    CLEED_TEST_ASSERT(count_lines(b.slot.par_file, "po:", last) == 2);
+    CLEED_TEST_ASSERT(strstr(last, "X_two") != NULL);
+    CLEED_TEST_ASSERT(strstr(last, " 2.200000 ") != NULL);
+    CLEED_TEST_ASSERT(count_lines(a.slot.bsr_file, "ip:", NULL) == 1);
+
+    /* the default context is not touched */
+    CLEED_TEST_ASSERT(sr_default_context.atoms == NULL);
+    CLEED_TEST_ASSERT(sr_default_context.search == NULL);
+    CLEED_TEST_ASSERT(sr_default_context.project == NULL);
+
+    sr_evslot_close(&a.slot);
+    sr_evslot_close(&b.slot);
+    sr_context_free(&a.ctx);
+    sr_context_free(&b.ctx);
+    CLEED_TEST_ASSERT(a.ctx.atoms == NULL && a.ctx.project == NULL);
+    return 0;
+}
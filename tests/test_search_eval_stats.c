@@ -0,0 +1,191 @@
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+
+#include "sr_eval_stats.h"
+#include "test_support.h"
+
+static int test_eval_stats_parse(void)
+{
+    real *par = cleed_test_alloc_vector_1based(4);
+    sr_evstat_eval ev;
+
+    CLEED_TEST_ASSERT(par != NULL);
+    ev.par = par;
+
+    /* log file line */
+    CLEED_TEST_ASSERT(sr_evstat_parse(
+        "#  7 par: 0.250 -0.500 rf:0.3120 sh: 1.5 rg:0.0000 rt:0.3120 "
+        " dt: Mon Oct 19 12:00:05 2026\n", &ev, 4) == 1);
+    CLEED_TEST_ASSERT(ev.i_eval == 7);
+    CLEED_TEST_ASSERT(ev.n_par == 2);
+    CLEED_TEST_ASSERT(ev.rejected == 0);
+    CLEED_TEST_ASSERT_NEAR(par[1], 0.25, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(par[2], -0.5, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(ev.rfac, 0.312, 1e-9);
+    CLEED_TEST_ASSERT_NEAR(ev.shift, 1.5, 1e-9);
+    CLEED_TEST_ASSERT_NEAR(ev.rtot, 0.312, 1e-9);
+    CLEED_TEST_ASSERT(ev.t_leed < 0.);
+
+    /* time stamps: 1 day + 1 hour later */
+    double t0 = ev.time;
+    CLEED_TEST_ASSERT(sr_evstat_parse(
+        "#  8 par: 0.250 -0.500 **rfmax: 1.0000** rg:2.5000 rt:3.5000 "
+        " dt: Tue Oct 20 13:00:05 2026\n", &ev, 4) == 1);
+    CLEED_TEST_ASSERT(ev.rejected == 1);
+    CLEED_TEST_ASSERT(ev.i_calc == 0);
+    CLEED_TEST_ASSERT_NEAR(ev.rgeo, 2.5, 1e-9);
+    CLEED_TEST_ASSERT_NEAR(ev.time - t0, 90000., 1e-6);
+
+    /* trace file line */
+    CLEED_TEST_ASSERT(sr_evstat_parse(
+        "{\"eval\":3,\"calc\":2,\"slot\":1,\"time\":1000,\"par\":[0.1,-0.2,0.3],"
+        "\"rf\":0.200000,\"shift\":-2.00,\"rg\":0.010000,\"rt\":0.210000,"
+        "\"t_leed\":12.500,\"t_rfac\":0.250}\n", &ev, 4) == 1);
+    CLEED_TEST_ASSERT(ev.i_eval == 3);
+    CLEED_TEST_ASSERT(ev.i_calc == 2);
+    CLEED_TEST_ASSERT(ev.slot == 1);
+    CLEED_TEST_ASSERT(ev.n_par == 3);
+    CLEED_TEST_ASSERT_NEAR(par[3], 0.3, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(ev.time, 1000., 1e-9);
+    CLEED_TEST_ASSERT_NEAR(ev.rtot, 0.21, 1e-9);
+    CLEED_TEST_ASSERT_NEAR(ev.t_leed, 12.5, 1e-9);
+
+    /* other lines of the log file, too many parameters */
+    CLEED_TEST_ASSERT(sr_evstat_parse("=> SIMPLEX SEARCH:\n", &ev, 4) == 0);
+    CLEED_TEST_ASSERT(sr_evstat_parse(
+        "#  - par: 0.100 ** surrogate: 0.3 +- 0.1, not evaluated **\n",
+        &ev, 4) == 0);
+    CLEED_TEST_ASSERT(sr_evstat_parse(
+        "#  9 par: 1 2 3 4 5 rf:0.1 sh: 0.0 rg:0.0 rt:0.1\n", &ev, 4) == -1);
+    CLEED_TEST_ASSERT(sr_evstat_parse("#  9 par: 1 2 garbage\n", &ev, 4) == -1);
+
+    cleed_test_free_vector_1based(par);
+    return 0;
+}
+
+static int test_eval_stats_moments(void)
+{
+    real *par = cleed_test_alloc_vector_1based(2);
+    sr_evstat st;
+    sr_evstat_eval ev = {0};
+    sr_evstat_conv conv;
+
+    CLEED_TEST_ASSERT(par != NULL);
+    CLEED_TEST_ASSERT(sr_evstat_init(&st, 2, 0.9) == 0);
+    ev.par = par;
+    ev.n_par = 2;
+    ev.slot = 0;
+    ev.time = 100.;
+
+    /* R = 0.2 + 0.5 p1, p2 = -p1; the last point is above r_cut */
+    for (int i = 1; i <= 11; i++)
+    {
+        double p1 = (i <= 10) ? 0.1 * (10 - i) : 2.;
+        par[1] = (real)p1;
+        par[2] = (real)-p1;
+        ev.i_eval = i;
+        ev.rfac = ev.rtot = 0.2 + 0.5 * p1;
+        ev.time += 10.;
+        ev.t_leed = 6.;
+        ev.t_rfac = 1.;
+        CLEED_TEST_ASSERT(sr_evstat_add(&st, &ev) == 0);
+    }
+    ev.n_par = 3;
+    CLEED_TEST_ASSERT(sr_evstat_add(&st, &ev) == -1);
+
+    CLEED_TEST_ASSERT(st.n_eval == 11);
+    CLEED_TEST_ASSERT(st.n_calc == 11);
+    CLEED_TEST_ASSERT(st.n_skip == 1);
+    CLEED_TEST_ASSERT(st.n_mom == 10);
+    CLEED_TEST_ASSERT_NEAR(sr_evstat_mean(&st, 1), 0.45, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(sr_evstat_dev(&st, 1), sqrt(0.0825 / 0.9), 1e-6);
+    CLEED_TEST_ASSERT_NEAR(sr_evstat_slope(&st, 1), 0.5, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(sr_evstat_slope(&st, 2), -0.5, 1e-6);
+    CLEED_TEST_ASSERT_NEAR(sr_evstat_corr(&st, 1, 0), 1., 1e-6);
+    CLEED_TEST_ASSERT_NEAR(sr_evstat_corr(&st, 1, 2), -1., 1e-6);
+
+    /* R factors 0.2 .. 0.65 and 1.2 */
+    CLEED_TEST_ASSERT_NEAR(st.r_min, 0.2, 1e-9);
+    CLEED_TEST_ASSERT_NEAR(st.r_max, 1.2, 1e-9);
+    CLEED_TEST_ASSERT_NEAR(sr_evstat_quantile(&st, 0.5), 0.45, 2e-3);
+    CLEED_TEST_ASSERT_NEAR(sr_evstat_quantile(&st, 1.0), 1.2, 1e-9);
+
+    /* convergence: best 0.2 at evaluation 10, within 0.05 at 9 */
+    sr_evstat_end(&st, &conv);
+    CLEED_TEST_ASSERT(conv.n_eval == 11);
+    CLEED_TEST_ASSERT(conv.n_step == 10);
+    CLEED_TEST_ASSERT(conv.i_best == 10);
+    CLEED_TEST_ASSERT_NEAR(conv.r_first, 0.65, 1e-9);
+    CLEED_TEST_ASSERT_NEAR(conv.r_best, 0.2, 1e-9);
+    CLEED_TEST_ASSERT(conv.i_conv[0] == 9);
+    CLEED_TEST_ASSERT(conv.i_conv[1] == 10);
+    CLEED_TEST_ASSERT_NEAR(conv.elapsed, 100., 1e-9);
+
+    /* wall time: 10 s per evaluation, 7 s of it in LEED and R factor */
+    CLEED_TEST_ASSERT(st.n_wall == 10);
+    CLEED_TEST_ASSERT_NEAR(st.t_wall / st.n_wall, 10., 1e-9);
+    CLEED_TEST_ASSERT_NEAR((st.t_wall_leed + st.t_wall_rfac) / st.n_wall,
+                           7., 1e-9);
+
+    /* a new search starts a new best-so-far list */
+    sr_evstat_begin(&st);
+    ev.n_par = 2;
+    ev.i_eval = 1;
+    ev.rfac = ev.rtot = 0.5;
+    CLEED_TEST_ASSERT(sr_evstat_add(&st, &ev) == 0);
+    sr_evstat_end(&st, &conv);
+    CLEED_TEST_ASSERT(conv.n_eval == 1);
+    CLEED_TEST_ASSERT_NEAR(conv.r_best, 0.5, 1e-9);
+    CLEED_TEST_ASSERT(st.n_eval == 12);
+
+    sr_evstat_free(&st);
+    cleed_test_free_vector_1based(par);
+    return 0;
+}
+
+static int test_eval_stats_bounded_steps(void)
+{
+    real *par = cleed_test_alloc_vector_1based(1);
+    sr_evstat st;
+    sr_evstat_eval ev = {0};
+    sr_evstat_conv conv;
+    const int n = 10 * SR_EVSTAT_MAX_STEP;
+
+    CLEED_TEST_ASSERT(par != NULL);
+    CLEED_TEST_ASSERT(sr_evstat_init(&st, 1, HUGE_VAL) == 0);
+    ev.par = par;
+    ev.n_par = 1;
+    ev.time = ev.t_leed = ev.t_rfac = -1.;
+
+    /* every evaluation improves: R = 1 - i/n */
+    for (int i = 1; i <= n; i++)
+    {
+        par[1] = (real)i;
+        ev.i_eval = i;
+        ev.rfac = ev.rtot = 1. - (double)i / n;
+        CLEED_TEST_ASSERT(sr_evstat_add(&st, &ev) == 0);
+    }
+    CLEED_TEST_ASSERT(st.n_step <= SR_EVSTAT_MAX_STEP);
+
+    sr_evstat_end(&st, &conv);
+    CLEED_TEST_ASSERT(conv.n_step == n);
+    CLEED_TEST_ASSERT(conv.i_best == n);
+    CLEED_TEST_ASSERT_NEAR(conv.r_best, 0., 1e-12);
+    /* exact: n - 0.01 n; thinning delays by less than 16 evaluations */
+    CLEED_TEST_ASSERT(conv.i_conv[1] >= n - n / 100);
+    CLEED_TEST_ASSERT(conv.i_conv[1] < n - n / 100 + 16);
+    CLEED_TEST_ASSERT(conv.elapsed < 0.);
+    CLEED_TEST_ASSERT(st.n_time == 0);
+
+    sr_evstat_free(&st);
+    cleed_test_free_vector_1based(par);
+    return 0;
+}
+
+int main(void)
+{
+    if (test_eval_stats_parse() != 0) return 1;
+    if (test_eval_stats_moments() != 0) return 1;
+    if (test_eval_stats_bounded_steps() != 0) return 1;
+    return 0;
+}
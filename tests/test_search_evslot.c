@@ -0,0 +1,113 @@
+#include "search.h"
+
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+// cppcheck-suppress missingIncludeSystem
+#include <sys/stat.h>
+// cppcheck-suppress missingIncludeSystem
+#include <unistd.h>
+
+#include "test_support.h"
+
+static int file_equals(const char *path, const char *contents)
+{
+    char buffer[256];
+    size_t n;
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL) {
+        return 0;
+    }
+    n = fread(buffer, 1, sizeof(buffer) - 1, fp);
+    fclose(fp);
+    buffer[n] = '\0';
+    return strcmp(buffer, contents) == 0;
+}
+
+static int is_dir(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static int write_slot(const struct sr_evslot *slot, const char *tag)
+{
+    char text[64];
+
+    snprintf(text, sizeof(text), "res %s\n", tag);
+    if (cleed_test_write_text_file(slot->res_file, text) != 0) return -1;
+    snprintf(text, sizeof(text), "par %s\n", tag);
+    if (cleed_test_write_text_file(slot->par_file, text) != 0) return -1;
+    snprintf(text, sizeof(text), "bsr %s\n", tag);
+    return cleed_test_write_text_file(slot->bsr_file, text);
+}
+
+int main(void)
+{
+    char work[] = "/tmp/test_evslot_XXXXXX";
+    char scratch[64], project[64], path[SR_PATHSZ + 16], dir_a[SR_PATHSZ];
+    struct sr_evslot a, b;
+
+    CLEED_TEST_ASSERT(mkdtemp(work) != NULL);
+    snprintf(scratch, sizeof(scratch), "%s/scratch", work);
+    snprintf(project, sizeof(project), "%s/proj", work);
+    CLEED_TEST_ASSERT(mkdir(scratch, 0755) == 0);
+    setenv("CSEARCH_SCRATCH", scratch, 1);
+
+    /* two slots of the same project have separate files */
+    CLEED_TEST_ASSERT(sr_evslot_open(&a, project, 0) == 0);
+    CLEED_TEST_ASSERT(sr_evslot_open(&b, project, 1) == 0);
+    CLEED_TEST_ASSERT(is_dir(a.dir) && is_dir(b.dir));
+    CLEED_TEST_ASSERT(strncmp(a.dir, scratch, strlen(scratch)) == 0);
+    CLEED_TEST_ASSERT(strcmp(a.res_file, b.res_file) != 0);
+    CLEED_TEST_ASSERT(strcmp(a.bul_file, b.bul_file) == 0);
+    snprintf(path, sizeof(path), "%s.bul", project);
+    CLEED_TEST_ASSERT(strcmp(a.bul_file, path) == 0);
+    snprintf(path, sizeof(path), "%s/proj.par", a.dir);
+    CLEED_TEST_ASSERT(strcmp(a.par_file, path) == 0);
+
+    CLEED_TEST_ASSERT(write_slot(&a, "a") == 0);
+    CLEED_TEST_ASSERT(write_slot(&b, "b") == 0);
+
+    /* first result is promoted, a worse one is not, a better one is */
+    CLEED_TEST_ASSERT(sr_evslot_promote(&a, project, 0.40) == 1);
+    CLEED_TEST_ASSERT(sr_evslot_promote(&b, project, 0.45) == 0);
+    snprintf(path, sizeof(path), "%s.rmin", project);
+    CLEED_TEST_ASSERT(file_equals(path, "res a\n"));
+    CLEED_TEST_ASSERT(sr_evslot_promote(&b, project, 0.30) == 1);
+    CLEED_TEST_ASSERT(file_equals(path, "res b\n"));
+    snprintf(path, sizeof(path), "%s.pmin", project);
+    CLEED_TEST_ASSERT(file_equals(path, "par b\n"));
+    snprintf(path, sizeof(path), "%s.bmin", project);
+    CLEED_TEST_ASSERT(file_equals(path, "bsr b\n"));
+
+    /* a record of a terminated process does not block promotion */
+    snprintf(path, sizeof(path), "%s.rfmin", project);
+    CLEED_TEST_ASSERT(cleed_test_write_text_file(path, "0.100000 999999999\n") == 0);
+    CLEED_TEST_ASSERT(sr_evslot_promote(&a, project, 0.35) == 1);
+    snprintf(path, sizeof(path), "%s.rmin", project);
+    CLEED_TEST_ASSERT(file_equals(path, "res a\n"));
+
+    /* closing removes the scratch directory */
+    strcpy(dir_a, a.dir);
+    sr_evslot_close(&a);
+    sr_evslot_close(&b);
+    sr_evslot_close(&a);
+    CLEED_TEST_ASSERT(!is_dir(dir_a));
+    CLEED_TEST_ASSERT(rmdir(scratch) == 0);
+
+    CLEED_TEST_ASSERT(sr_evslot_open(&a, "", 0) != 0);
+
+    const char *ext[] = {"rmin", "pmin", "bmin", "rfmin"};
+    for (size_t i = 0; i < sizeof(ext) / sizeof(ext[0]); i++) {
+        snprintf(path, sizeof(path), "%s.%s", project, ext[i]);
+        (void)cleed_test_remove_file(path);
+    }
+    CLEED_TEST_ASSERT(rmdir(work) == 0);
+
+    return 0;
+}
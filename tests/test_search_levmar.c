@@ -0,0 +1,173 @@
+#include "search.h"
+
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+
+#include "test_support.h"
+
+#define N_JOB 4
+#define N_PT  41
+
+typedef struct counter {
+    int n_eval;
+    int n_fixed;
+} counter;
+
+/* Rosenbrock function as sum of squares: minimum 0 at (1,1) */
+static int rosenbrock(real *x, real *res, int n_max, real *aux, int fix_aux,
+                      void *data)
+{
+    counter *c = (counter *)data;
+    (void)aux;
+    (void)fix_aux;
+    if (n_max < 2) return -1;
+    res[1] = (real)10.0 * (x[2] - x[1] * x[1]);
+    res[2] = (real)1.0 - x[1];
+    c->n_eval++;
+    return 2;
+}
+
+/*
+  Fit of a Gaussian peak (height x[1], width x[2]) to data with an
+  unknown offset on the energy axis; the offset (aux) is fitted by the
+  function itself on a grid of 0.5 if fix_aux is 0, like the energy shift
+  of the R factor. The number of residuals depends on the offset.
+*/
+static real peak(real e, real height, real width)
+{
+    return height * (real)exp(-(e * e) / (width * width));
+}
+
+static int shifted_peak(real *x, real *res, int n_max, real *aux,
+                        int fix_aux, void *data)
+{
+    counter *c = (counter *)data;
+    real best = (real)HUGE_VAL, shift = *aux;
+    int n = 0;
+
+    if (!fix_aux) {
+        for (real s = (real)-2.0; s <= (real)2.0; s += (real)0.5) {
+            real sum = 0.0;
+            for (int i = 0; i < N_PT; i++) {
+                real e = (real)-4.0 + (real)0.2 * i;
+                real d = peak(e - s, x[1], x[2]) - peak(e - (real)1.0, 2.0, 1.5);
+                sum += d * d;
+            }
+            if (sum < best) {
+                best = sum;
+                shift = s;
+            }
+        }
+        *aux = shift;
+    } else {
+        c->n_fixed++;
+    }
+
+    /* overlap: drop one point per unit of the offset */
+    for (int i = (int)fabs((double)shift); i < N_PT; i++) {
+        real e = (real)-4.0 + (real)0.2 * i;
+        if (++n > n_max) return -1;
+        res[n] = peak(e - shift, x[1], x[2]) - peak(e - (real)1.0, 2.0, 1.5);
+    }
+    c->n_eval++;
+    return n;
+}
+
+static int run_rosenbrock(int n_jobs, int central, real *x, real *chi2,
+                           int *n_iter, int *n_eval)
+{
+    counter cnt[N_JOB] = {{0, 0}};
+    void *data[N_JOB];
+    sr_levmar_cfg cfg = {0};
+
+    for (int k = 0; k < N_JOB; k++) data[k] = cnt + k;
+    cfg.n_max = 8;
+    cfg.n_jobs = n_jobs;
+    cfg.h = 1.e-3;
+    cfg.central = central;
+    cfg.ftol = 1.e-6;
+    cfg.max_iter = 200;
+    cfg.func = rosenbrock;
+    cfg.data = data;
+
+    x[1] = -1.2;
+    x[2] = 1.0;
+    CLEED_TEST_ASSERT(sr_levmar(x, 2, chi2, &cfg, n_iter, n_eval) == 0);
+
+    int total = 0;
+    for (int k = 0; k < N_JOB; k++) total += cnt[k].n_eval;
+    CLEED_TEST_ASSERT(total == *n_eval);
+    return 0;
+}
+
+int main(void)
+{
+    real *x = cleed_test_alloc_vector_1based(2);
+    real *x_par = cleed_test_alloc_vector_1based(2);
+    real chi2, chi2_par;
+    int n_iter, n_eval, n_iter_par, n_eval_par;
+
+    CLEED_TEST_ASSERT(x != NULL && x_par != NULL);
+
+    /* classic start point (-1.2, 1) */
+    CLEED_TEST_ASSERT(run_rosenbrock(1, 0, x, &chi2, &n_iter, &n_eval) == 0);
+    CLEED_TEST_ASSERT_NEAR(x[1], 1.0, 1e-3);
+    CLEED_TEST_ASSERT_NEAR(x[2], 1.0, 2e-3);
+    CLEED_TEST_ASSERT(chi2 < 1e-6);
+    CLEED_TEST_ASSERT(n_iter < 100);
+
+    /* the columns of the Jacobian in parallel: same path */
+    CLEED_TEST_ASSERT(run_rosenbrock(2, 0, x_par, &chi2_par, &n_iter_par,
+                                     &n_eval_par) == 0);
+    CLEED_TEST_ASSERT_NEAR(x_par[1], x[1], 1e-12);
+    CLEED_TEST_ASSERT_NEAR(x_par[2], x[2], 1e-12);
+    CLEED_TEST_ASSERT(n_iter_par == n_iter && n_eval_par == n_eval);
+
+    /* central differences */
+    CLEED_TEST_ASSERT(run_rosenbrock(N_JOB, 1, x_par, &chi2_par, &n_iter_par,
+                                     &n_eval_par) == 0);
+    CLEED_TEST_ASSERT_NEAR(x_par[1], 1.0, 1e-3);
+    CLEED_TEST_ASSERT_NEAR(x_par[2], 1.0, 2e-3);
+
+    /* auxiliary variable fitted by the function, fixed for the Jacobian */
+    {
+        counter cnt[N_JOB] = {{0, 0}};
+        void *data[N_JOB];
+        sr_levmar_cfg cfg = {0};
+        int n_fixed = 0;
+
+        for (int k = 0; k < N_JOB; k++) data[k] = cnt + k;
+        cfg.n_max = N_PT;
+        cfg.n_jobs = N_JOB;
+        cfg.h = 1.e-3;
+        cfg.ftol = 1.e-6;
+        cfg.max_iter = 100;
+        cfg.func = shifted_peak;
+        cfg.data = data;
+
+        x[1] = 1.0;
+        x[2] = 1.0;
+        CLEED_TEST_ASSERT(sr_levmar(x, 2, &chi2, &cfg, &n_iter, &n_eval) == 0);
+        CLEED_TEST_ASSERT_NEAR(x[1], 2.0, 1e-3);
+        CLEED_TEST_ASSERT_NEAR(x[2], 1.5, 1e-3);
+        CLEED_TEST_ASSERT(chi2 < 1e-6);
+        for (int k = 0; k < N_JOB; k++) n_fixed += cnt[k].n_fixed;
+        CLEED_TEST_ASSERT(n_fixed == 2 * n_iter);
+    }
+
+    /* invalid input */
+    {
+        sr_levmar_cfg cfg = {0};
+        cfg.n_max = 2;
+        cfg.h = 1.e-3;
+        CLEED_TEST_ASSERT(sr_levmar(x, 2, &chi2, &cfg, NULL, NULL) != 0);
+    }
+
+    cleed_test_free_vector_1based(x);
+    cleed_test_free_vector_1based(x_par);
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "search.h"
+
+// cppcheck-suppress missingIncludeSystem
+#include <pthread.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+// cppcheck-suppress missingIncludeSystem
+#include <string.h>
+
+#include "test_support.h"
+
+#define N_THREAD 4
+#define N_BLOCK  500
+#define N_LINE   3
+
+static const char *log_file = "test_search_log.log";
+static const char *rec_file = "test_search_log.rec";
+
+static void *writer(void *arg)
+{
+    int id = *(int *)arg;
+    real par[3] = {0., 0.25, -0.5};
+    struct sr_logrec rec = {0};
+
+    rec.slot = id;
+    rec.n_par = 2;
+    rec.par = par;
+    for (int b = 0; b < N_BLOCK; b++) {
+        FILE *log_stream = sr_log_begin(log_file);
+        if (log_stream == NULL) return arg;
+        for (int l = 0; l < N_LINE; l++)
+            fprintf(log_stream, "t%d b%d l%d\n", id, b, l);
+        sr_log_end(log_stream);
+
+        rec.i_eval = id * N_BLOCK + b + 1;
+        rec.rfac = (real)0.125;
+        sr_log_record(&rec);
+    }
+    return NULL;
+}
+
+/* blocks are contiguous and in order for each thread */
+static int check_log(int n_thread, int n_block)
+{
+    int last[N_THREAD], n_lines = 0, t, b, l, t0 = -1, b0 = -1;
+    char line[64];
+    FILE *fp = fopen(log_file, "r");
+
+    CLEED_TEST_ASSERT(fp != NULL);
+    for (int k = 0; k < N_THREAD; k++) last[k] = -1;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        CLEED_TEST_ASSERT(sscanf(line, "t%d b%d l%d", &t, &b, &l) == 3);
+        CLEED_TEST_ASSERT(t >= 0 && t < n_thread);
+        if (l == 0) {
+            CLEED_TEST_ASSERT(b == last[t] + 1);
+            last[t] = b;
+            t0 = t;
+            b0 = b;
+        } else {
+            CLEED_TEST_ASSERT(t == t0 && b == b0);
+        }
+        n_lines++;
+    }
+    fclose(fp);
+    CLEED_TEST_ASSERT(n_lines == n_thread * n_block * N_LINE);
+    return 0;
+}
+
+static int count_records(void)
+{
+    char line[256];
+    int n = 0;
+    FILE *fp = fopen(rec_file, "r");
+
+    if (fp == NULL) return -1;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (strncmp(line, "{\"eval\":", 8) != 0 ||
+            strstr(line, "\"par\":[0.25,-0.5],\"rf\":0.125000,") == NULL ||
+            strcmp(line + strlen(line) - 2, "}\n") != 0)
+            return -1;
+        n++;
+    }
+    fclose(fp);
+    return n;
+}
+
+int main(void)
+{
+    pthread_t thread[N_THREAD];
+    int id[N_THREAD];
+    char buf[STRSZ];
+
+    /* without writer thread: written directly */
+    (void)cleed_test_remove_file(log_file);
+    id[0] = 0;
+    CLEED_TEST_ASSERT(writer(id) == NULL);
+    CLEED_TEST_ASSERT(check_log(1, N_BLOCK) == 0);
+
+    /* writer thread: concurrent blocks are not interleaved */
+    (void)cleed_test_remove_file(log_file);
+    CLEED_TEST_ASSERT(sr_log_open(rec_file) == 0);
+    for (int k = 0; k < N_THREAD; k++) {
+        id[k] = k;
+        CLEED_TEST_ASSERT(pthread_create(thread + k, NULL, writer, id + k) == 0);
+    }
+    for (int k = 0; k < N_THREAD; k++) {
+        void *ret;
+        CLEED_TEST_ASSERT(pthread_join(thread[k], &ret) == 0 && ret == NULL);
+    }
+    sr_log_flush();
+    CLEED_TEST_ASSERT(check_log(N_THREAD, N_BLOCK) == 0);
+    CLEED_TEST_ASSERT(count_records() == N_THREAD * N_BLOCK);
+    sr_log_close();
+    sr_log_close();
+
+    /* after closing: appended directly */
+    {
+        FILE *log_stream = sr_log_begin(log_file);
+        CLEED_TEST_ASSERT(log_stream != NULL);
+        fprintf(log_stream, "t0 b%d l0\nt0 b%d l1\nt0 b%d l2\n",
+                N_BLOCK, N_BLOCK, N_BLOCK);
+        sr_log_end(log_stream);
+    }
+    {
+        FILE *fp = fopen(log_file, "r");
+        CLEED_TEST_ASSERT(fp != NULL);
+        while (fgets(buf, sizeof(buf), fp) != NULL) continue;
+        fclose(fp);
+        CLEED_TEST_ASSERT(strcmp(buf, "t0 b500 l2\n") == 0);
+    }
+
+    /* asctime() format */
+    sr_log_time(buf, sizeof(buf));
+    CLEED_TEST_ASSERT(strlen(buf) == 25 && buf[24] == '\n');
+
+    (void)cleed_test_remove_file(log_file);
+    (void)cleed_test_remove_file(rec_file);
+    return 0;
+}
@@ -21,6 +21,22 @@ static int test_parse_two_reals(void)
     return 0;
 }
 
+static int test_parse_reals(void)
+{
+    real v[3] = {0.0, 0.0, 0.0};
+
+    CLEED_TEST_ASSERT(sr_parse_reals(" 0.1 -0.2\t3e-1 # start 1\n", v, 3) == 0);
+    CLEED_TEST_ASSERT_NEAR(v[0], 0.1, 1e-12);
+    CLEED_TEST_ASSERT_NEAR(v[1], -0.2, 1e-12);
+    CLEED_TEST_ASSERT_NEAR(v[2], 0.3, 1e-12);
+
+    CLEED_TEST_ASSERT(sr_parse_reals("0.1 0.2\n", v, 3) != 0);
+    CLEED_TEST_ASSERT(sr_parse_reals("# 0.1 0.2 0.3\n", v, 3) != 0);
+    CLEED_TEST_ASSERT(sr_parse_reals("0.1 0.2 0.3\n", v, 0) != 0);
+
+    return 0;
+}
+
 static int test_read_two_reals_from_file(void)
 {
     const char *path = "parse_test.dum";
@@ -46,6 +62,9 @@ int main(void)
     if (test_parse_two_reals() != 0) {
         return 1;
     }
+    if (test_parse_reals() != 0) {
+        return 1;
+    }
     if (test_read_two_reals_from_file() != 0) {
         return 1;
     }
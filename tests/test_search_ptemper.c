@@ -0,0 +1,186 @@
+#include "search.h"
+
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+
+#include "test_support.h"
+
+#define N_REP 4
+
+typedef struct counter {
+    int n_eval;
+} counter;
+
+/* parabola with ripples: global minimum at (-1,-1), local minima near
+   all integer points */
+static real rugged(real *x, void *data)
+{
+    counter *c = (counter *)data;
+    real r = 0.0;
+    for (int j = 1; j <= 2; j++) {
+        const real u = x[j] + 1.0;
+        r += (real)0.1 * u * u + (real)0.3 * (real)(1.0 - cos(2.0 * M_PI * x[j]));
+    }
+    c->n_eval++;
+    return r;
+}
+
+typedef struct pt_result {
+    real yb;
+    real pb1;
+    real pb2;
+    int nfunc;
+    int nswap;
+} pt_result;
+
+/* n_rep replicas (1: a single cold simplex), same total budget */
+static int run_ptemper_once(int n_rep, int n_jobs, pt_result *out)
+{
+    const int ndim = 2;
+    real **p[N_REP];
+    real *y[N_REP];
+    void *data[N_REP];
+    counter cnt[N_REP];
+    real *pb = cleed_test_alloc_vector_1based(ndim);
+    int n_eval = 0;
+
+    CLEED_TEST_ASSERT(pb != NULL);
+    for (int k = 0; k < n_rep; k++) {
+        p[k] = cleed_test_alloc_matrix_1based(ndim + 1, ndim);
+        y[k] = cleed_test_alloc_vector_1based(ndim + 1);
+        CLEED_TEST_ASSERT(p[k] != NULL && y[k] != NULL);
+        cnt[k].n_eval = 0;
+        data[k] = cnt + k;
+
+        /* all replicas start in the local minimum at (2,2) */
+        p[k][1][1] = 2.0;  p[k][1][2] = 2.0;
+        p[k][2][1] = 2.3;  p[k][2][2] = 2.0;
+        p[k][3][1] = 2.0;  p[k][3][2] = 2.3;
+        for (int i = 1; i <= ndim + 1; i++) {
+            y[k][i] = rugged(p[k][i], cnt + k);
+        }
+        cnt[k].n_eval = 0;
+    }
+
+    sr_ptemper_cfg cfg = {0};
+    cfg.n_replica = n_rep;
+    cfg.n_jobs = n_jobs;
+    cfg.t_min = 1e-3;
+    cfg.t_max = (n_rep > 1) ? 2.0 : 1e-3;
+    cfg.ftol = 1e-6;
+    cfg.iter = 160 / n_rep;
+    cfg.max_sweep = 100;
+    cfg.idum = -4711;
+    cfg.funk = rugged;
+    cfg.data = data;
+
+    real yb = 0.0;
+    int nfunc = 0, nswap = 0;
+    CLEED_TEST_ASSERT(sr_ptemper(p, y, ndim, pb, &yb, &cfg, &nfunc, &nswap) == 0);
+
+    /* every evaluation is counted by the replica that made it */
+    for (int k = 0; k < n_rep; k++) n_eval += cnt[k].n_eval;
+    CLEED_TEST_ASSERT(nfunc == n_eval);
+    CLEED_TEST_ASSERT(nfunc == 100 * 160);
+
+    /* p[0] is the simplex of the coldest replica */
+    for (int i = 1; i <= ndim + 1; i++) {
+        CLEED_TEST_ASSERT(y[0][i] >= yb);
+    }
+
+    out->yb = yb;
+    out->pb1 = pb[1];
+    out->pb2 = pb[2];
+    out->nfunc = nfunc;
+    out->nswap = nswap;
+
+    for (int k = 0; k < n_rep; k++) {
+        cleed_test_free_matrix_1based(p[k]);
+        cleed_test_free_vector_1based(y[k]);
+    }
+    cleed_test_free_vector_1based(pb);
+    return 0;
+}
+
+static int test_ptemper(void)
+{
+    pt_result r0, r1, r4;
+
+    /* a single cold simplex stays in the local minimum, the replicas
+       find the basin of the global minimum with the same budget */
+    if (run_ptemper_once(1, 1, &r0) != 0) return 1;
+    if (run_ptemper_once(N_REP, 1, &r1) != 0) return 1;
+    CLEED_TEST_ASSERT(r0.yb > 1.0);
+    CLEED_TEST_ASSERT(r1.yb < 0.2);
+    CLEED_TEST_ASSERT(r1.pb1 < 0.0 && r1.pb2 < 0.0);
+    CLEED_TEST_ASSERT(r1.nswap > 0);
+
+    /* the result does not depend on the number of threads */
+    if (run_ptemper_once(N_REP, N_REP, &r4) != 0) return 1;
+    CLEED_TEST_ASSERT_NEAR(r1.yb, r4.yb, 1e-12);
+    CLEED_TEST_ASSERT_NEAR(r1.pb1, r4.pb1, 1e-12);
+    CLEED_TEST_ASSERT_NEAR(r1.pb2, r4.pb2, 1e-12);
+    CLEED_TEST_ASSERT(r1.nfunc == r4.nfunc);
+    CLEED_TEST_ASSERT(r1.nswap == r4.nswap);
+
+    return 0;
+}
+
+static int test_evcache(void)
+{
+    struct sr_evcache *c = sr_evcache_new(2, (real)1e-4);
+    real par[3], val = 0.0;
+    long n_hit, n_miss;
+
+    CLEED_TEST_ASSERT(c != NULL);
+    CLEED_TEST_ASSERT(sr_evcache_new(0, (real)1e-4) == NULL);
+
+    par[1] = 0.1;
+    par[2] = -0.2;
+    CLEED_TEST_ASSERT(sr_evcache_get(c, par, &val) == 0);
+    sr_evcache_put(c, par, (real)0.35);
+
+    /* same grid point */
+    par[1] = 0.10002;
+    CLEED_TEST_ASSERT(sr_evcache_get(c, par, &val) == 1);
+    CLEED_TEST_ASSERT_NEAR(val, 0.35, 1e-6);
+
+    /* neighbouring grid point */
+    par[1] = 0.1001;
+    CLEED_TEST_ASSERT(sr_evcache_get(c, par, &val) == 0);
+
+    /* many entries (the table grows) */
+    for (int i = 0; i < 1000; i++) {
+        par[1] = (real)i * (real)1e-3;
+        par[2] = (real)1.0;
+        sr_evcache_put(c, par, (real)i);
+    }
+    for (int i = 0; i < 1000; i++) {
+        par[1] = (real)i * (real)1e-3;
+        par[2] = (real)1.0;
+        CLEED_TEST_ASSERT(sr_evcache_get(c, par, &val) == 1);
+        CLEED_TEST_ASSERT_NEAR(val, (real)i, 1e-6);
+    }
+
+    sr_evcache_stats(c, &n_hit, &n_miss);
+    CLEED_TEST_ASSERT(n_hit == 1001);
+    CLEED_TEST_ASSERT(n_miss == 2);
+
+    /* a NULL cache never finds anything */
+    CLEED_TEST_ASSERT(sr_evcache_get(NULL, par, &val) == 0);
+    sr_evcache_put(NULL, par, val);
+
+    sr_evcache_free(c);
+    return 0;
+}
+
+int main(void)
+{
+    if (test_evcache() != 0) return 1;
+    if (test_ptemper() != 0) return 1;
+    return 0;
+}
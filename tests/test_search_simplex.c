@@ -2,12 +2,11 @@
 
 #include "sr_simplex.h"
 
-static int g_ndim = 0;
-
-static real test_obj(real *x)
+static real test_obj(real *x, void *data)
 {
+  const int ndim = *(const int *)data;
   real sum = 0.0;
-  for (int j = 1; j <= g_ndim; j++) {
+  for (int j = 1; j <= ndim; j++) {
     sum += x[j] * x[j];
   }
   return sum;
@@ -17,14 +16,13 @@ static int test_build_initial_simplex(void)
 {
   const int ndim = 3;
   const real dpos = (real)0.25;
-  g_ndim = ndim;
 
   sr_simplex_buffers b;
   CLEED_TEST_ASSERT(sr_simplex_buffers_alloc(&b, ndim) == 0);
   CLEED_TEST_ASSERT(b.ndim == ndim);
   CLEED_TEST_ASSERT(b.mpar == ndim + 1);
 
-  CLEED_TEST_ASSERT(sr_simplex_build_initial(&b, dpos, test_obj) == 0);
+  CLEED_TEST_ASSERT(sr_simplex_build_initial(&b, dpos, test_obj, (void *)&ndim) == 0);
 
   for (int j = 1; j <= ndim; j++) {
     CLEED_TEST_ASSERT_NEAR(b.p[1][j], 0.0, 1e-12);
@@ -47,11 +45,10 @@ static int test_build_initial_simplex(void)
 static int test_extremes_and_centroid(void)
 {
   const int ndim = 2;
-  g_ndim = ndim;
 
   sr_simplex_buffers b;
   CLEED_TEST_ASSERT(sr_simplex_buffers_alloc(&b, ndim) == 0);
-  CLEED_TEST_ASSERT(sr_simplex_build_initial(&b, (real)1.0, test_obj) == 0);
+  CLEED_TEST_ASSERT(sr_simplex_build_initial(&b, (real)1.0, test_obj, (void *)&ndim) == 0);
 
   /* Override y for deterministic extremes selection. */
   b.y[1] = (real)2.0;
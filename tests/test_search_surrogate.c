@@ -0,0 +1,106 @@
+#include "search.h"
+
+// cppcheck-suppress missingIncludeSystem
+#include <math.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdio.h>
+// cppcheck-suppress missingIncludeSystem
+#include <stdlib.h>
+
+#include "test_support.h"
+
+/* R factor like test function: minimum 0.1 at (0.1, -0.05) */
+static real quad(const real *x)
+{
+    return (real)0.1 + (x[1] - (real)0.1) * (x[1] - (real)0.1) +
+           (x[2] + (real)0.05) * (x[2] + (real)0.05);
+}
+
+int main(void)
+{
+    struct sr_surrogate *s = sr_surrogate_new(2, 0.2);
+    real *x = cleed_test_alloc_vector_1based(2);
+    real *out = cleed_test_alloc_vector_1based(2);
+    real mu, sigma, y, y_best = 100., ei, ei_far;
+
+    CLEED_TEST_ASSERT(s != NULL && x != NULL && out != NULL);
+    CLEED_TEST_ASSERT(sr_surrogate_new(0, 0.2) == NULL);
+    CLEED_TEST_ASSERT(sr_surrogate_new(2, 0.) == NULL);
+
+    /* no prediction from fewer than two points */
+    x[1] = 0.;
+    x[2] = 0.;
+    CLEED_TEST_ASSERT(sr_surrogate_predict(s, x, &mu, &sigma) != 0);
+
+    /* 5 x 5 grid in [-0.2, 0.2]^2 */
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 5; j++) {
+            x[1] = (real)-0.2 + (real)0.1 * i;
+            x[2] = (real)-0.2 + (real)0.1 * j;
+            y = quad(x);
+            if (y < y_best) y_best = y;
+            CLEED_TEST_ASSERT(sr_surrogate_add(s, x, y) == 0);
+        }
+    }
+    CLEED_TEST_ASSERT(sr_surrogate_count(s) == 25);
+
+    /* repeated points */
+    x[1] = 0.1;
+    x[2] = -0.1;
+    CLEED_TEST_ASSERT(sr_surrogate_lookup(s, x, 1.e-4, &y) == 1);
+    CLEED_TEST_ASSERT_NEAR(y, quad(x), 1e-6);
+    x[2] = -0.09;
+    CLEED_TEST_ASSERT(sr_surrogate_lookup(s, x, 1.e-4, &y) == 0);
+
+    /* interpolation between the grid points */
+    x[1] = 0.05;
+    x[2] = 0.05;
+    CLEED_TEST_ASSERT(sr_surrogate_predict(s, x, &mu, &sigma) == 0);
+    CLEED_TEST_ASSERT_NEAR(mu, quad(x), 5e-3);
+    CLEED_TEST_ASSERT(sigma < 0.02);
+
+    /* far from the data: mean of the values, large uncertainty */
+    x[1] = 2.0;
+    x[2] = 2.0;
+    CLEED_TEST_ASSERT(sr_surrogate_predict(s, x, &mu, &sigma) == 0);
+    CLEED_TEST_ASSERT(mu < (real)0.2 && sigma > (real)0.02);
+
+    /* expected improvement: near the minimum > at the worst corner */
+    x[1] = 0.1;
+    x[2] = -0.05;
+    ei = sr_surrogate_ei(s, x, y_best);
+    x[1] = -0.2;
+    x[2] = 0.2;
+    ei_far = sr_surrogate_ei(s, x, y_best);
+    CLEED_TEST_ASSERT(ei > (real)0. && ei > ei_far);
+
+    /* proposal near the minimum, deterministic for a given seed */
+    x[1] = 0.;
+    x[2] = 0.;
+    ei = sr_surrogate_propose(s, x, 0.2, 2000, y_best, 11L, out);
+    CLEED_TEST_ASSERT(ei > (real)0.);
+    CLEED_TEST_ASSERT_NEAR(out[1], 0.1, 0.05);
+    CLEED_TEST_ASSERT_NEAR(out[2], -0.05, 0.05);
+    x[1] = out[1];
+    x[2] = out[2];
+    CLEED_TEST_ASSERT(sr_surrogate_propose(s, x, 0., 10, y_best, 11L, out) >= 0.);
+    CLEED_TEST_ASSERT_NEAR(out[1], x[1], 1e-6);
+
+    /* full model: the worst points are replaced */
+    for (int i = 0; i < 300; i++) {
+        x[1] = (real)-0.5 + (real)0.01 * (i % 100);
+        x[2] = (real)-0.3 + (real)0.2 * (i / 100);
+        (void)sr_surrogate_add(s, x, quad(x));
+    }
+    CLEED_TEST_ASSERT(sr_surrogate_count(s) == 256);
+    x[1] = 0.1;
+    x[2] = -0.05;
+    CLEED_TEST_ASSERT(sr_surrogate_predict(s, x, &mu, &sigma) == 0);
+    CLEED_TEST_ASSERT_NEAR(mu, 0.1, 5e-3);
+
+    sr_surrogate_free(s);
+    sr_surrogate_free(NULL);
+    cleed_test_free_vector_1based(x);
+    cleed_test_free_vector_1based(out);
+    return 0;
+}